@@ -1,8 +1,15 @@
 #include <iostream>
 #include <GameTimer/GameTimer.h>
 #include "ShadowApp.h"
+#include "ShadowBenchmark.h"
+
+int main(int argc, char *argv[]) {
+	// --benchmark runs the CPU side of the frame headless, see Benchmark/Benchmark.h for the flags
+	if (com::isBenchmarkRequested(argc, argv)) {
+		ShadowBenchmark benchmark;
+		return com::runBenchmarkMain(argc, argv, benchmark);
+	}
 
-int main() {
 	std::shared_ptr<com::GameTimer> pGameTimer = std::make_shared<com::GameTimer>();
 	ShadowApp app;
 	try {
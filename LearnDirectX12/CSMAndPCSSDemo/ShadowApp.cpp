@@ -1,3 +1,5 @@
+#include <cmath>
+#include <algorithm>
 #include "ShadowApp.h"
 #include "ShadowRgph.h"
 #include "ShadowMaterial.h"
@@ -14,15 +16,33 @@
 #include "RenderGraph/Drawable/Drawable.h"
 #include "RenderGraph/Technique/Technique.h"
 #include "D3D/Shadow/CSMShadowPass.h"
+#include "D3D/Sky/SkyBoxPass.h"
+#include "D3D/TextureManager/TextureManager.h"
 #include "D3D/Tool/FirstPersonCamera.h"
+#include "Profiler/Profiler.h"
 
 using namespace Math;
 
+// a caster is drawn when any cascade sees it, the pass culls every cascade again on its own
+struct CascadeBounding : public d3d::IBounding {
+	explicit CascadeBounding(std::span<const d3d::CSMShadowPass::FrustumItem> cascades) : cascades(cascades) {}
+	DX::ContainmentType contains(const BoundingBox &box) const override {
+		for (const d3d::CSMShadowPass::FrustumItem &cascade : cascades) {
+			if (cascade.boundingBox.contains(box) != DX::ContainmentType::DISJOINT)
+				return DX::ContainmentType::INTERSECTS;
+		}
+		return DX::ContainmentType::DISJOINT;
+	}
+public:
+	std::span<const d3d::CSMShadowPass::FrustumItem> cascades;
+};
+
 
 ShadowApp::ShadowApp() {
 	_title = "ShadowApp";
 	_width = 1280;
 	_height = 760;
+	_enableFramePipeline = true;
 }
 
 ShadowApp::~ShadowApp() {
@@ -50,6 +70,7 @@ void ShadowApp::onInitialize(dx12lib::DirectContextProxy pDirectCtx) {
 	lightVisitor->lights[0].initAsDirectionLight(float3(-3, 6, -3), float3(3.f));
 	lightVisitor->lights[1].initAsDirectionLight(float3(-3, +6, -3), float3(0.1f));
 	lightVisitor->lights[2].initAsDirectionLight(float3(-3, -6, -3), float3(0.1f));
+	_lightDir = Vector3(lightVisitor->lights[0].direction);
 
 	_pEnvMap = pDirectCtx->createDDSTextureCubeFromFile(L"resources/grasscube1024.dds");
 	_pRenderGraph = createShadowRenderGraph(this, pDirectCtx);
@@ -57,25 +78,58 @@ void ShadowApp::onInitialize(dx12lib::DirectContextProxy pDirectCtx) {
 		_pRenderGraph->getRenderQueuePass(ShadowRgph::ShadowPass)
 	);
 	assert(_pCSMShadowPass != nullptr);
+	assert(_pSkyBoxPass != nullptr);
+	assert(_pClearPass != nullptr);
 	_pCSMShadowPass->setZMulti(10.f);
 	_pCSMShadowPass->setLightSize(50.f);
 	_pCSMShadowPass->setLightPlane(300.f);
+	// the last cascade reaches furthest, its texels cover the least of the screen
+	_pCSMShadowPass->setCascadeResolution(_pCSMShadowPass->getNumCascaded() - 1, 512);
+	_depthHistogram = d3d::DepthHistogram(cameraDesc.nearClip, cameraDesc.farClip, 64);
 
 	ShadowMaterial::init(this);
 
 	std::shared_ptr<d3d::ALTree> pALTree = std::make_shared<d3d::ALTree>("./resources/powerplant/powerplant.gltf");
 	_pMeshModel = std::make_shared<d3d::MeshModel>(*pDirectCtx, pALTree);
+
+	{
+		// load every diffuse map in loader jobs before the materials ask for them. Maps baked by an
+		// earlier run come from the texture cache, so only the first start pays for the compression
+		PROFILE_ZONE("ShadowApp::prefetchTextures");
+		auto *pTextureManager = d3d::TextureManager::instance();
+		for (size_t i = 0; i < pALTree->getNumMaterial(); ++i) {
+			const d3d::ALTexture &diffuseMap = pALTree->getMaterial(i)->getDiffuseMap();
+			if (diffuseMap.path.empty())
+				continue;
+
+			d3d::TextureLoadRequest request;
+			request.path = diffuseMap.path;
+			request.pData = diffuseMap.pTextureData;
+			request.dataSize = diffuseMap.textureDataSize;
+			request.formatHint = diffuseMap.textureExtName;
+			request.settings.role = d3d::TextureRole::Albedo;
+			request.streaming = true;
+			pTextureManager->requestTexture(std::move(request));
+		}
+		pTextureManager->flushTextureLoading(pDirectCtx);
+	}
+
 	_pMeshModel->createMaterial(*_pRenderGraph,
 		*pDirectCtx,
 		ShadowMaterial::getShadowMaterialCreator(pDirectCtx)
 	);
 	_pMeshModel->setModelTransform(static_cast<float4x4>(Matrix4::makeScale(2.f)));
+
+	// the plant does not move, its mesh boxes are the shadow casters for the whole run
+	_pMeshModel->updateTransforms();
+	_pMeshModel->collectWorldBounds(_casterBounds);
+	_pCSMShadowPass->setCasterBounds(_casterBounds);
 }
 
 void ShadowApp::onDestroy() {
 }
 
-void ShadowApp::onBeginTick(std::shared_ptr<com::GameTimer> pGameTimer) {
+std::shared_ptr<const com::FramePacket> ShadowApp::onUpdate(std::shared_ptr<com::GameTimer> pGameTimer) {
 	// poll mouse event
 	while (auto event = _pInputSystem->pMouse->getEvent()) {
 		if (event.isLPress()) {
@@ -94,29 +148,81 @@ void ShadowApp::onBeginTick(std::shared_ptr<com::GameTimer> pGameTimer) {
 		_pCamera->pollEvent(event);
 
 	_pCamera->update(pGameTimer);
+	auto pPacket = std::make_shared<ShadowFramePacket>(*_pCamera);
+	pPacket->frameIndex = _frameIndex;
+	pPacket->totalTime = pGameTimer->getTotalTime();
+	pPacket->deltaTime = pGameTimer->getDeltaTime();
+
+	// the CPU side of the frame runs here, overlapping the render stage of the previous one
+	const d3d::FirstPersonCamera &camera = pPacket->camera;
+	_pMeshModel->updateTransforms(pPacket->transformUploads);
+	updateShadowSplits(camera);
+	_pCSMShadowPass->fitCascades(&camera, -_lightDir, pPacket->cascades);
+	_pMeshModel->cullRenderItems(CascadeBounding(pPacket->cascades), pPacket->shadowItems);
+	_pMeshModel->cullRenderItems(d3d::MakeBoundingWrap(camera.getViewSpaceFrustum()), pPacket->opaqueItems);
+	return pPacket;
+}
+
+void ShadowApp::onRender(const com::FramePacket &packet) {
+	const auto &shadowPacket = static_cast<const ShadowFramePacket &>(packet);
+	const d3d::FirstPersonCamera &camera = shadowPacket.camera;
 	auto pPassCbVisitor = _pPassCb->visit();
-	_pCamera->updatePassCB(*pPassCbVisitor);
+	camera.updatePassCB(*pPassCbVisitor);
 
-	auto pLightCbVisitor = _pLightCb->visit<d3d::CBLightType>();
-	Vector3 lightDir(pLightCbVisitor->lights[0].direction);
-	_lightBoundingBox = _pCSMShadowPass->update(_pCamera.get(), pGameTimer, -lightDir);
-}
+	_pCSMShadowPass->update(shadowPacket.cascades, packet.totalTime, packet.deltaTime, -_lightDir);
+	_pSkyBoxPass->setCamera(camera);
+	_pClearPass->clearDepth = camera.getClearDepth();
 
-void ShadowApp::onTick(std::shared_ptr<com::GameTimer> pGameTimer) {
 	auto pCmdQueue = _pDevice->getCommandQueue();
 	auto pDirectCtx = pCmdQueue->createDirectContextProxy();
-	_pMeshModel->submit(d3d::MakeBoundingWrap(_lightBoundingBox), ShadowRgph::kShadow);
-	_pMeshModel->submit(d3d::MakeBoundingWrap(_pCamera->getViewSpaceFrustum()), ShadowRgph::kOpaque);
+	_pMeshModel->uploadTransforms(shadowPacket.transformUploads);
+	updateTextureStreaming(pDirectCtx, shadowPacket);
+	for (d3d::RenderItem *pRenderItem : shadowPacket.shadowItems)
+		pRenderItem->submit(ShadowRgph::kShadow);
+	for (d3d::RenderItem *pRenderItem : shadowPacket.opaqueItems)
+		pRenderItem->submit(ShadowRgph::kOpaque);
 	_pRenderGraph->execute(pDirectCtx);
 	pCmdQueue->executeCommandList(pDirectCtx);
-}
-
-void ShadowApp::onEndTick(std::shared_ptr<com::GameTimer> pGameTimer) {
-	std::shared_ptr<dx12lib::CommandQueue> pCmdQueue = _pDevice->getCommandQueue();
 	pCmdQueue->signal(_pSwapChain);
 	_pRenderGraph->reset();
 }
 
+void ShadowApp::updateShadowSplits(const d3d::CameraBase &camera) {
+	// the view depths of the visible casters stand in for a depth buffer reduction
+	const d3d::CameraCore &core = camera.getCore();
+	Vector3 eye(core.getEye());
+	Vector3 forward(core.getForward());
+	_depthHistogram.clear();
+	for (const d3d::TransformAABB &bounds : _casterBounds) {
+		Vector3 center(bounds.center[0], bounds.center[1], bounds.center[2]);
+		Vector3 extents(bounds.extents[0], bounds.extents[1], bounds.extents[2]);
+		if (camera.getViewSpaceFrustum().contains(BoundingBox(center - extents, center + extents)) == DX::ContainmentType::DISJOINT)
+			continue;
+		_depthHistogram.add(dot(center - eye, forward));
+	}
+	_pCSMShadowPass->tuneSplits(_depthHistogram, &camera);
+}
+
+void ShadowApp::updateTextureStreaming(dx12lib::DirectContextProxy pDirectCtx, const ShadowFramePacket &packet) {
+	// the diffuse maps start with their mip tail, visible items ask for the mips they cover on screen
+	const d3d::CameraBase &camera = packet.camera;
+	d3d::TextureStreamingView view;
+	const Math::float3 &eye = camera.getCore().getEye();
+	view.eyePosition[0] = eye.x;
+	view.eyePosition[1] = eye.y;
+	view.eyePosition[2] = eye.z;
+	view.tanHalfFovY = std::tan(camera.getCore().getFovY() * 0.5f);
+	view.viewportHeight = static_cast<float>(_height);
+	for (const d3d::RenderItem *pRenderItem : packet.opaqueItems)
+		pRenderItem->requestTextureResidency(view);
+
+	// reloads of released mips arrive through the loader, the recreated textures need new materials
+	auto *pTextureManager = d3d::TextureManager::instance();
+	pTextureManager->uploadLoadedTextures(pDirectCtx);
+	std::vector<std::string> updatedTextures = pTextureManager->updateStreaming(pDirectCtx);
+	_pMeshModel->rebuildMaterial(*pDirectCtx, ShadowMaterial::getShadowMaterialCreator(pDirectCtx), updatedTextures);
+}
+
 void ShadowApp::onResize(dx12lib::DirectContextProxy pDirectCtx, int width, int height) {
 	float aspect = static_cast<float>(width) / static_cast<float>(height);
 	_pCamera->setAspect(aspect);
@@ -11,11 +11,28 @@
 #include "RenderGraph/Pass/ClearPass.hpp"
 #include "RenderGraph/Pass/PresentPass.hpp"
 #include "RenderGraph/RenderGraph/RenderGraph.h"
+#include "D3D/Tool/FirstPersonCamera.h"
+#include "D3D/Shadow/CascadeFitting.h"
+#include "D3D/Shadow/CSMShadowPass.h"
 
 namespace d3d {
-class CSMShadowPass;
+class CameraBase;
+class SkyBoxPass;
 }
 
+struct ClearRTAndDSPass;
+
+// what the update stage worked out for one frame, the render stage only records and submits it
+struct ShadowFramePacket : com::FramePacket {
+	d3d::FirstPersonCamera camera;
+	std::vector<d3d::MeshTransformUpload> transformUploads;
+	std::vector<d3d::CSMShadowPass::FrustumItem> cascades;
+	std::vector<d3d::RenderItem *> shadowItems;			// inside any cascade
+	std::vector<d3d::RenderItem *> opaqueItems;			// inside the camera frustum
+public:
+	explicit ShadowFramePacket(const d3d::FirstPersonCamera &camera) : camera(camera) {}
+};
+
 class ShadowApp : public com::BaseApp {
 public:
 	ShadowApp();
@@ -27,13 +44,16 @@ public:
 	auto &getCamera() const { return _pCamera; }
 	auto &getPassCb() const { return _pPassCb; }
 	auto &getLightCb() const { return _pLightCb; }
+	void setSkyBoxPass(d3d::SkyBoxPass *pSkyBoxPass) { _pSkyBoxPass = pSkyBoxPass; }
+	void setClearPass(ClearRTAndDSPass *pClearPass) { _pClearPass = pClearPass; }
 private:
 	void onInitialize(dx12lib::DirectContextProxy pDirectCtx) override;
 	void onDestroy() override;
-	void onBeginTick(std::shared_ptr<com::GameTimer> pGameTimer) override;
-	void onTick(std::shared_ptr<com::GameTimer> pGameTimer) override;
-	void onEndTick(std::shared_ptr<com::GameTimer> pGameTimer) override;
+	std::shared_ptr<const com::FramePacket> onUpdate(std::shared_ptr<com::GameTimer> pGameTimer) override;
+	void onRender(const com::FramePacket &packet) override;
 	void onResize(dx12lib::DirectContextProxy pDirectCtx, int width, int height) override;
+	void updateShadowSplits(const d3d::CameraBase &camera);
+	void updateTextureStreaming(dx12lib::DirectContextProxy pDirectCtx, const ShadowFramePacket &packet);
 private:
 	bool _bMouseLeftPress = false;
 	std::shared_ptr<d3d::FirstPersonCamera> _pCamera;
@@ -42,7 +62,11 @@ private:
 	std::shared_ptr<dx12lib::ITextureResourceCube> _pEnvMap;
 	dx12lib::FRConstantBufferPtr<d3d::CBPassType> _pPassCb;
 	d3d::CSMShadowPass *_pCSMShadowPass;
-	Math::BoundingBox _lightBoundingBox;
+	d3d::SkyBoxPass *_pSkyBoxPass = nullptr;
+	ClearRTAndDSPass *_pClearPass = nullptr;
 	std::shared_ptr<d3d::MeshModel> _pMeshModel;
+	Math::Vector3 _lightDir;
+	std::vector<d3d::TransformAABB> _casterBounds;
+	d3d::DepthHistogram _depthHistogram;
 	std::shared_ptr<rgph::RenderGraph> _pRenderGraph;
 };
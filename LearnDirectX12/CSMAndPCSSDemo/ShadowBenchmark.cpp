@@ -0,0 +1,158 @@
+#include "ShadowBenchmark.h"
+#include <algorithm>
+#include "D3D/AssimpLoader/ALTree.h"
+#include "D3D/AssimpLoader/ALNode.h"
+#include "D3D/AssimpLoader/ALMesh.h"
+#include "D3D/Model/MeshModel/MeshNode.h"
+
+using namespace Math;
+
+const char *ShadowBenchmark::getName() const {
+	return "CSMAndPCSSDemo";
+}
+
+void ShadowBenchmark::onBenchmarkBegin(com::BenchmarkConfig &config) {
+	_transforms.clear();
+	_meshes.clear();
+	_geometries.clear();
+	// same model and scale as ShadowApp::onInitialize
+	d3d::ALTree alTree("./resources/powerplant/powerplant.gltf");
+	size_t root = _transforms.addNode(d3d::TransformHierarchy::kInvalidNode, float4x4(Matrix4::makeScale(2.f)));
+	addNode(alTree.getRootNode(), root);
+	_transforms.update();
+	// the model does not move, the world boxes are computed once
+	_casterBounds.clear();
+	_worldAABBs.clear();
+	for (size_t mesh : _meshes) {
+		const d3d::TransformAABB &bounds = _transforms.getWorldBounds(mesh);
+		_casterBounds.push_back(bounds);
+		Vector3 center(bounds.center[0], bounds.center[1], bounds.center[2]);
+		Vector3 extents(bounds.extents[0], bounds.extents[1], bounds.extents[2]);
+		_worldAABBs.emplace_back(center - extents, center + extents);
+	}
+
+	d3d::CameraDesc cameraDesc {
+		float3(110.045f, 8.51247f, -0.0528324f),
+		float3(0.f, 1.f, 0.f),
+		float3(109.05f, 8.41141f, -0.0424141f),
+		DirectX::XMConvertToDegrees(config.fovY),
+		config.zNear,
+		config.zFar,
+		config.aspect,
+	};
+	_pCamera = std::make_unique<d3d::PathCamera>(cameraDesc);
+
+	_pCSMShadowPass = std::make_unique<d3d::CSMShadowPass>("CSMShadowPass");
+	_pCSMShadowPass->setZMulti(10.f);
+	_pCSMShadowPass->setLightSize(50.f);
+	_pCSMShadowPass->setLightPlane(300.f);
+	_pCSMShadowPass->setCascadeResolution(_pCSMShadowPass->getNumCascaded() - 1, 512);
+	_pCSMShadowPass->setCasterBounds(_casterBounds);
+	_depthHistogram = d3d::DepthHistogram(config.zNear, config.zFar, 64);
+	// ShadowApp's first light points along (-3, 6, -3), the pass takes the direction the light travels
+	_lightDir = -normalize(Vector3(-3.f, 6.f, -3.f));
+	_cascadeVisible.resize(_pCSMShadowPass->getNumCascaded());
+	_shadowQueues.resize(_pCSMShadowPass->getNumCascaded());
+
+	if (config.cameraPath.empty()) {
+		// a walk around the plant, starting where ShadowApp's camera starts
+		com::CameraPath path(true);
+		const float keys[][6] = {
+			{ 110.f, 8.5f, 0.f,    109.f, 8.4f, 0.f },
+			{ 0.f,   20.f, 120.f,  -1.f,  19.f, 119.f },
+			{ -150.f, 40.f, 0.f,   -149.f, 39.5f, 1.f },
+			{ 0.f,   12.f, -150.f, 1.f,   12.f, -149.f },
+			{ 110.f, 8.5f, 0.f,    109.f, 8.4f, 0.f },
+		};
+		for (size_t i = 0; i < std::size(keys); ++i) {
+			com::CameraPose pose;
+			std::copy_n(keys[i], 3, pose.position);
+			std::copy_n(keys[i] + 3, 3, pose.target);
+			path.addKey(4.f * static_cast<float>(i), pose);
+		}
+		config.cameraPath = path;
+	}
+}
+
+void ShadowBenchmark::addNode(const d3d::ALNode *pALNode, size_t parent) {
+	size_t node = _transforms.addNode(parent, pALNode->getNodeTransform());
+	for (size_t i = 0; i < pALNode->getNumMesh(); ++i) {
+		std::shared_ptr<d3d::ALMesh> pALMesh = pALNode->getMesh(i);
+		d3d::TransformAABB bounds = d3d::MeshNode::calcMeshBounds(*pALMesh);
+		size_t mesh = _transforms.addNode(node);
+		_transforms.setLocalBounds(mesh, bounds);
+		_meshes.push_back(mesh);
+		_geometries.push_back(static_cast<std::uint32_t>(pALMesh->getMeshIdx()));
+	}
+	for (size_t i = 0; i < pALNode->getNumChildren(); ++i)
+		addNode(pALNode->getChildren(i), node);
+}
+
+std::uint64_t ShadowBenchmark::onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) {
+	_pCamera->setPose(frame.camera.position, frame.camera.target);
+	{
+		com::BenchmarkStageScope scope(stages, "cull");
+		const BoundingFrustum &frustum = _pCamera->getViewSpaceFrustum();
+		_visible.clear();
+		for (size_t i = 0; i < _worldAABBs.size(); ++i) {
+			if (frustum.contains(_worldAABBs[i]) != DX::ContainmentType::DISJOINT)
+				_visible.push_back(static_cast<std::uint32_t>(i));
+		}
+	}
+	{
+		com::BenchmarkStageScope scope(stages, "cascades");
+		// the view depths of the visible meshes stand in for ShadowApp's depth histogram
+		const d3d::CameraCore &core = _pCamera->getCore();
+		Vector3 eye(core.getEye());
+		Vector3 forward(core.getForward());
+		_depthHistogram.clear();
+		for (std::uint32_t index : _visible) {
+			const float *center = _casterBounds[index].center;
+			_depthHistogram.add(dot(Vector3(center[0], center[1], center[2]) - eye, forward));
+		}
+		_pCSMShadowPass->tuneSplits(_depthHistogram, _pCamera.get());
+		_pCSMShadowPass->updateCascades(_pCamera.get(), _lightDir);
+	}
+	size_t numCascaded = _pCSMShadowPass->getNumCascaded();
+	{
+		com::BenchmarkStageScope scope(stages, "shadowCull");
+		for (size_t c = 0; c < numCascaded; ++c) {
+			_cascadeVisible[c].clear();
+			for (size_t i = 0; i < _worldAABBs.size(); ++i) {
+				if (_pCSMShadowPass->isVisibleInCascade(c, _worldAABBs[i]))
+					_cascadeVisible[c].push_back(static_cast<std::uint32_t>(i));
+			}
+		}
+	}
+	{
+		com::BenchmarkStageScope scope(stages, "queue");
+		const d3d::CameraCore &core = _pCamera->getCore();
+		Vector3 eye(core.getEye());
+		Vector3 forward(core.getForward());
+		_drawQueue.clear();
+		for (std::uint32_t index : _visible) {
+			const float *center = _transforms.getWorldBounds(_meshes[index]).center;
+			float viewDepth = dot(Vector3(center[0], center[1], center[2]) - eye, forward);
+			_drawQueue.push(d3d::DrawSortKey::make(0, 0, _geometries[index], _geometries[index], viewDepth), index);
+		}
+		_drawQueue.sort();
+		// the shadow pass groups by geometry only
+		for (size_t c = 0; c < numCascaded; ++c) {
+			_shadowQueues[c].clear();
+			for (std::uint32_t index : _cascadeVisible[c])
+				_shadowQueues[c].push(d3d::DrawSortKey::make(0, 0, 0, _geometries[index], 0.f), index);
+			_shadowQueues[c].sort();
+		}
+	}
+
+	com::BenchmarkHash hash;
+	hash.add(_visible.size());
+	for (const d3d::DrawItem &item : _drawQueue.getItems())
+		hash.add(item.index);
+	for (size_t c = 0; c < numCascaded; ++c) {
+		hash.add(_cascadeVisible[c].size());
+		for (const d3d::DrawItem &item : _shadowQueues[c].getItems())
+			hash.add(item.index);
+	}
+	return hash.get();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Benchmark/Benchmark.h"
+#include "D3D/DrawQueue/DrawQueue.h"
+#include "D3D/Model/Transform/TransformHierarchy.h"
+#include "D3D/Shadow/CSMShadowPass.h"
+#include "D3D/Tool/PathCamera.h"
+
+namespace d3d {
+class ALNode;
+}
+
+// CPU side of ShadowApp without a device: the powerplant meshes are culled against the camera and
+// every cascade of a real CSMShadowPass, then queued the way the pass sorts them
+class ShadowBenchmark : public com::IBenchmarkScene {
+public:
+	const char *getName() const override;
+	void onBenchmarkBegin(com::BenchmarkConfig &config) override;
+	std::uint64_t onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) override;
+private:
+	void addNode(const d3d::ALNode *pALNode, size_t parent);
+private:
+	d3d::TransformHierarchy _transforms;
+	std::vector<size_t> _meshes;
+	std::vector<d3d::TransformAABB> _casterBounds;
+	std::vector<Math::BoundingBox> _worldAABBs;
+	std::vector<std::uint32_t> _geometries;
+	std::unique_ptr<d3d::PathCamera> _pCamera;
+	std::unique_ptr<d3d::CSMShadowPass> _pCSMShadowPass;
+	d3d::DepthHistogram _depthHistogram;
+	Math::Vector3 _lightDir;
+	std::vector<std::uint32_t> _visible;
+	std::vector<std::vector<std::uint32_t>> _cascadeVisible;
+	d3d::DrawQueue _drawQueue;
+	std::vector<d3d::DrawQueue> _shadowQueues;
+};
@@ -7,6 +7,7 @@
 #include "ShadowRgph.h"
 #include "D3D/Shadow/CSMShadowPass.h"
 #include "D3D/TextureManager/TextureManager.h"
+#include "D3D/TextureManager/TextureBaker.h"
 #include "Dx12lib/Device/SwapChain.h"
 #include "Dx12lib/Pipeline/PipelineStateObject.h"
 #include "Dx12lib/Pipeline/RootSignature.h"
@@ -79,6 +80,10 @@ void ShadowMaterial::init(ShadowApp *pApp) {
 			pSwapChain->getDepthStencilFormat()
 		);
 		pOpaquePso->setRootSignature(pRootSignature);
+		// the camera's depth mode is fixed once the demo is initialized
+		CD3DX12_DEPTH_STENCIL_DESC depthStencilDesc(D3D12_DEFAULT);
+		depthStencilDesc.DepthFunc = pApp->getCamera()->getDepthComparisonFunc();
+		pOpaquePso->setDepthStencilState(depthStencilDesc);
 		pOpaquePso->setInputLayout({
 			d3d::PositionSemantic,
 			d3d::NormalSemantic,
@@ -178,11 +183,22 @@ void ShadowMaterial::init(ShadowApp *pApp) {
 }
 
 d3d::MeshModel::MaterialCreator ShadowMaterial::getShadowMaterialCreator(dx12lib::DirectContextProxy pDirectCtx) {
-	return [&](const d3d::ALMaterial *pAlMaterial) -> std::shared_ptr<rgph::Material> {
+	// by value, the creator is also called from ShadowApp::updateTextureStreaming long after this returns
+	return [pDirectCtx](const d3d::ALMaterial *pAlMaterial) mutable -> std::shared_ptr<rgph::Material> {
 		const auto &diffuseMap = pAlMaterial->getDiffuseMap();
 		auto pTex = d3d::TextureManager::instance()->get(diffuseMap.path);
 		if (pTex == nullptr) {
-			if (diffuseMap.pTextureData != nullptr) {
+			d3d::TextureBakeRequest request;
+			request.fileName = diffuseMap.path;
+			request.pData = diffuseMap.pTextureData.get();
+			request.dataSize = diffuseMap.textureDataSize;
+			request.settings.role = d3d::TextureRole::Albedo;
+			d3d::TextureBaker baker;
+			std::vector<std::uint8_t> ddsFile = baker.bakeToDDS(request);
+			if (!ddsFile.empty()) {
+				pTex = pDirectCtx->createTextureFromMemory("dds", ddsFile.data(), ddsFile.size(), true);
+			}
+			else if (diffuseMap.pTextureData != nullptr) {
 				pTex = pDirectCtx->createTextureFromMemory(diffuseMap.textureExtName,
 					diffuseMap.pTextureData.get(),
 					diffuseMap.textureDataSize
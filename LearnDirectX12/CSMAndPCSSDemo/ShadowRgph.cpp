@@ -4,10 +4,19 @@
 #include "D3D/Sky/SkyBoxPass.h"
 #include "D3D/Tool/FirstPersonCamera.h"
 #include "Dx12lib/Device/SwapChain.h"
-#include "RenderGraph/Pass/ClearPass.hpp"
 #include "RenderGraph/Pass/PresentPass.hpp"
 #include "Dx12lib/Resource/IResource.h"
 
+ClearRTAndDSPass::ClearRTAndDSPass(const std::string &passName) : GraphicsPass(passName, true, true) {
+}
+
+void ClearRTAndDSPass::execute(dx12lib::DirectContextProxy pDirectCtx) {
+	auto rtClearValue = pRenderTarget->getClearValue();
+	auto dsClearValue = pDepthStencil->getClearValue();
+	pDirectCtx->clearColor(pRenderTarget->getRTV(), Math::float4(rtClearValue.Color));
+	pDirectCtx->clearDepthStencil(pDepthStencil->getDSV(), clearDepth, dsClearValue.DepthStencil.Stencil);
+}
+
 ShadowPass::ShadowPass(const std::string &passName) : RenderQueuePass(passName, false, true) {
 }
 
@@ -18,7 +27,7 @@ OpaquePass::OpaquePass(const std::string &passName)
 }
 
 std::shared_ptr<rgph::RenderGraph> createShadowRenderGraph(ShadowApp *pApp, dx12lib::DirectContextProxy pDirectCtx) {
-	auto pClearPass = std::make_shared<rgph::ClearPass>(ShadowRgph::ClearRTAndDSPass);
+	auto pClearPass = std::make_shared<ClearRTAndDSPass>(ShadowRgph::ClearRTAndDSPass);
 	auto pClearCSMShadowMap = std::make_shared<d3d::ClearCSMShadowMapPass>(ShadowRgph::ClearCSMShadowMapPass);
 	auto pOpaquePass = std::make_shared<OpaquePass>(ShadowRgph::OpaquePass);
 	auto pSkyBoxPass = std::make_shared<d3d::SkyBoxPass>(ShadowRgph::SkyBoxPass);
@@ -38,6 +47,7 @@ std::shared_ptr<rgph::RenderGraph> createShadowRenderGraph(ShadowApp *pApp, dx12
 
 		getRenderTarget >> pClearPass->pRenderTarget;
 		getDepthStencil >> pClearPass->pDepthStencil;
+		pApp->setClearPass(pClearPass.get());
 		pRenderGraph->addPass(pClearPass);
 	}
 	{ // clear Shadow Map
@@ -61,7 +71,7 @@ std::shared_ptr<rgph::RenderGraph> createShadowRenderGraph(ShadowApp *pApp, dx12
 		pSkyBoxPass->renderTargetFormat = pApp->getSwapChain()->getRenderTargetFormat();
 		pSkyBoxPass->depthStencilFormat = pApp->getSwapChain()->getDepthStencilFormat();
 		pSkyBoxPass->pEnvMap = pApp->getEnvMap();
-		pSkyBoxPass->pCamera = pApp->getCamera().get();
+		pApp->setSkyBoxPass(pSkyBoxPass.get());
 		pOpaquePass->pRenderTarget >> pSkyBoxPass->pRenderTarget;
 		pOpaquePass->pDepthStencil >> pSkyBoxPass->pDepthStencil;
 		pRenderGraph->addPass(pSkyBoxPass);
@@ -1,5 +1,6 @@
 #pragma once
 #include "RenderGraph/Pass/RenderQueuePass.h"
+#include "RenderGraph/Pass/GraphicsPass.h"
 #include "RenderGraph/Technique/TechniqueType.hpp"
 
 class ShadowApp;
@@ -19,6 +20,13 @@ inline std::string PresentPass				= "PresentPass";
 }
 
 
+// clears the depth buffer to the camera's clear depth, 0 under reverse Z
+struct ClearRTAndDSPass : rgph::GraphicsPass {
+	explicit ClearRTAndDSPass(const std::string &passName);
+	void execute(dx12lib::DirectContextProxy pDirectCtx) override;
+	float clearDepth = 1.f;
+};
+
 struct ShadowPass : rgph::RenderQueuePass {
 	explicit ShadowPass(const std::string &passName);
 };
@@ -87,7 +87,8 @@ float4 getShadowColor(VertexOut pin) {
 
 	for (int i = 0; i < 4; ++i) {
 		float3 pos = lightSpacePos[i].xyz;
-		if (pos.x >= dx && pos.x <= (1.f-dx) && pos.y >= dx && pos.y <= (1.f-dx))
+		float end = gShadow.subFrustum[i].texcoordScale - dx;
+		if (pos.x >= dx && pos.x <= end && pos.y >= dx && pos.y <= end)
 			return colorList[i];
 	}
 	return float4(0.3, 0.3, 0.3, 1.0);
@@ -242,11 +243,11 @@ float getShadow(VertexOut pin) {
 
 	float dx = 1.0 / (float)width;
 	float validBegin = dx * kMaxSampleKernel;
-	float validEnd = 1.f - validBegin;
 	float3 pos = 0;
 	int index = 0;
 	while (index < 4) {
 		pos = lightSpacePos[index].xyz;
+		float validEnd = gShadow.subFrustum[index].texcoordScale - validBegin;
 		if (pos.x > validBegin && pos.x < validEnd && pos.y > validBegin && pos.y < validEnd)
 			break;
 		++index;
@@ -4,10 +4,18 @@
 #include <dx12lib/Context/ContextStd.h>
 
 #include "D3D/d3dutil.h"
+#include "Profiler/Profiler.h"
+#include "FrameArena/FrameArena.h"
+#include "JobSystem/JobSystem.h"
 
 namespace com {
 
 void BaseApp::initialize() {
+	Profiler::emplace();
+	Profiler::instance()->setThreadName("Main");
+	PROFILE_ZONE("BaseApp::initialize");
+	// the main thread becomes thread 0 of the shared pool
+	JobSystem::emplace();
 	_pInputSystem = std::make_shared<InputSystem>(_title, _width, _height);
 	_pInputSystem->initialize();
 	_pInputSystem->pWindow->setResizeCallback([&](int width, int height) {
@@ -19,7 +27,7 @@ void BaseApp::initialize() {
 
 	dx12lib::DeviceInitDesc desc = {
 		DXGI_FORMAT_R8G8B8A8_UNORM,
-		DXGI_FORMAT_D24_UNORM_S8_UINT,
+		_depthStencilFormat,
 		_fps,
 	};
 	_pDevice->initialize(desc);
@@ -36,50 +44,81 @@ void BaseApp::initialize() {
 	pCmdQueue->executeCommandList(pDirectContext);
 	pCmdQueue->signal(_pSwapChain);
 	pCmdQueue->flushCommandQueue();
+
+	if (_enableFramePipeline) {
+		_pFramePipeline = std::make_unique<FramePipeline>([this](const FramePacket &packet) {
+			renderFrame(packet);
+		}, _maxFramesInFlight);
+	}
 }
 
 void BaseApp::destroy() {
+	_pFramePipeline.reset();
 	auto pCmdQueue = _pDevice->getCommandQueue();
 	pCmdQueue->flushCommandQueue();
 	onDestroy();
 	_pD3dInitializer.reset();
 	_pInputSystem->destroy();
 	_pDevice->destroy();
+	JobSystem::destroy();
+	Profiler::destroy();
 }
 
 void BaseApp::beginTick(std::shared_ptr<GameTimer> pGameTimer) {
+	PROFILE_ZONE("BaseApp::beginTick");
 	_pInputSystem->beginTick(pGameTimer);
 	if (_canPause && _pInputSystem->pWindow->isPause()) {
 		std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(1000.f / 60.f)));
 		return;
 	}
 
+	// the render thread starts its own frames
+	if (_pFramePipeline != nullptr)
+		return;
+
 	auto pCmdQueue = _pDevice->getCommandQueue();
 	pCmdQueue->startNewFrame();		// start new frames
 	onBeginTick(pGameTimer);
 }
 
 void BaseApp::tick(std::shared_ptr<GameTimer> pGameTimer) {
+	PROFILE_ZONE("BaseApp::tick");
 	_pInputSystem->tick(pGameTimer);
 	if (_canPause && _pInputSystem->pWindow->isPause())
 		return;
 
+	if (_pFramePipeline != nullptr) {
+		if (auto pPacket = updateFrame(pGameTimer))
+			_pFramePipeline->push(std::move(pPacket));
+		return;
+	}
 	onTick(pGameTimer);
 }
 
 void BaseApp::endTick(std::shared_ptr<GameTimer> pGameTimer) {
-	_pInputSystem->endTick(pGameTimer);
-	if (_canPause && _pInputSystem->pWindow->isPause())
-		return;
-
-	onEndTick(pGameTimer);
-	_pDevice->releaseStaleDescriptor();
+	{
+		PROFILE_ZONE("BaseApp::endTick");
+		_pInputSystem->endTick(pGameTimer);
+		if (_canPause && _pInputSystem->pWindow->isPause())
+			return;
+
+		if (_pFramePipeline == nullptr) {
+			onEndTick(pGameTimer);
+			_pDevice->releaseStaleDescriptor();
+		}
+	}
+	Profiler::instance()->endFrame();
+	FrameArena::endFrame();
 }
 
 void BaseApp::resize(int width, int height) {
 	if (width == 0 || height == 0)
 		return;
 
+	// the render thread may not record while the swap chain is rebuilt
+	if (_pFramePipeline != nullptr)
+		_pFramePipeline->flush();
+
 	_width = width;
 	_height = height;
 	auto pCmdQueue = _pDevice->getCommandQueue();
@@ -105,4 +144,22 @@ auto BaseApp::getGameTimer() const -> std::shared_ptr<com::GameTimer> {
 	return _pGameTimer;
 }
 
+std::shared_ptr<const FramePacket> BaseApp::updateFrame(std::shared_ptr<com::GameTimer> pGameTimer) {
+	std::shared_ptr<const FramePacket> pPacket = onUpdate(pGameTimer);
+	++_frameIndex;
+	return pPacket;
+}
+
+FramePipelineStats BaseApp::getFramePipelineStats() const {
+	return _pFramePipeline != nullptr ? _pFramePipeline->getStats() : FramePipelineStats{};
+}
+
+void BaseApp::renderFrame(const FramePacket &packet) {
+	PROFILE_ZONE("BaseApp::renderFrame");
+	auto pCmdQueue = _pDevice->getCommandQueue();
+	pCmdQueue->startNewFrame();
+	onRender(packet);
+	_pDevice->releaseStaleDescriptor();
+}
+
 }
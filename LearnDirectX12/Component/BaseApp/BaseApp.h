@@ -6,6 +6,7 @@
 #include "dx12lib/Context/ContextProxy.hpp"
 #include "ITick.h"
 #include "InputSystem/InputSystem.h"
+#include "BaseApp/FramePipeline.h"
 
 
 namespace d3d {
@@ -34,6 +35,9 @@ public:
 	bool isRunning() const;
 	void setGameTimer(std::shared_ptr<com::GameTimer> pGameTimer);
 	auto getGameTimer() const -> std::shared_ptr<com::GameTimer>;
+	// update stage only, usable without a render stage
+	std::shared_ptr<const FramePacket> updateFrame(std::shared_ptr<com::GameTimer> pGameTimer);
+	FramePipelineStats getFramePipelineStats() const;
 protected:
 	virtual void onInitialize(dx12lib::DirectContextProxy pDirectCtx) {}
 	virtual void onDestroy() {}
@@ -41,11 +45,21 @@ protected:
 	virtual void onTick(std::shared_ptr<com::GameTimer> pGameTimer) {}
 	virtual void onEndTick(std::shared_ptr<com::GameTimer> pGameTimer) {}
 	virtual void onResize(dx12lib::DirectContextProxy pDirectCtx, int width, int height) {}
+	// with _enableFramePipeline these replace onBeginTick/onTick/onEndTick: onUpdate runs on the
+	// main thread and must not touch GPU resources, onRender gets the packet on the render thread
+	virtual std::shared_ptr<const FramePacket> onUpdate(std::shared_ptr<com::GameTimer> pGameTimer) { return nullptr; }
+	virtual void onRender(const FramePacket &packet) {}
+private:
+	void renderFrame(const FramePacket &packet);
 protected:
 	int  _width    = 800;
 	int  _height   = 600;
 	bool _canPause = true;
+	bool _enableFramePipeline = false;
+	size_t _maxFramesInFlight = 1;
 	size_t _fps    = 120;
+	// a reverse Z camera wants a float depth buffer, e.g. DXGI_FORMAT_D32_FLOAT_S8X24_UINT
+	DXGI_FORMAT _depthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 	std::string _title = "BaseApp";
 	std::shared_ptr<dx12lib::Adapter>    _pAdapter;
 	std::shared_ptr<dx12lib::Device>     _pDevice;
@@ -53,6 +67,8 @@ protected:
 	std::shared_ptr<InputSystem>         _pInputSystem;
 	std::shared_ptr<com::GameTimer>		 _pGameTimer;
 	std::unique_ptr<d3d::D3DInitializer> _pD3dInitializer;
+	std::unique_ptr<FramePipeline>		 _pFramePipeline;
+	size_t _frameIndex = 0;
 };
 
 }
@@ -0,0 +1,126 @@
+#include "FramePipeline.h"
+#include <cassert>
+#include <format>
+#include <algorithm>
+#include "FrameArena/FrameArena.h"
+
+namespace com {
+
+double FramePipelineStats::getAvgUpdateMs() const {
+	return numFrames > 0 ? updateMs / numFrames : 0.0;
+}
+
+double FramePipelineStats::getAvgRenderMs() const {
+	return numFrames > 0 ? renderMs / numFrames : 0.0;
+}
+
+double FramePipelineStats::getAvgFrameMs() const {
+	return numFrames > 0 ? frameMs / numFrames : 0.0;
+}
+
+double FramePipelineStats::getAvgSerialFrameMs() const {
+	return getAvgUpdateMs() + getAvgRenderMs();
+}
+
+std::string FramePipelineStats::toString() const {
+	return std::format("frame pipeline: {} frames, update {:.3f} ms, render {:.3f} ms, wait {:.3f} ms, frame {:.3f} ms (serial {:.3f} ms)\n",
+		numFrames, getAvgUpdateMs(), getAvgRenderMs(), numFrames > 0 ? waitMs / numFrames : 0.0, getAvgFrameMs(), getAvgSerialFrameMs());
+}
+
+FramePipeline::FramePipeline(RenderFunc render, size_t maxFramesInFlight)
+: _render(std::move(render)), _maxFramesInFlight(std::max<size_t>(maxFramesInFlight, 1))
+{
+	if (_render != nullptr)
+		_renderThread = std::thread([this]() { renderMain(); });
+}
+
+FramePipeline::~FramePipeline() {
+	flush();
+	{
+		std::lock_guard lock(_mutex);
+		_quit = true;
+	}
+	_packetPushed.notify_one();
+	if (_renderThread.joinable())
+		_renderThread.join();
+}
+
+void FramePipeline::push(std::shared_ptr<const FramePacket> pPacket) {
+	assert(pPacket != nullptr);
+	Clock::time_point begin = Clock::now();
+	{
+		std::unique_lock lock(_mutex);
+		if (_render != nullptr) {
+			_packetDone.wait(lock, [this]() { return _packets.size() < _maxFramesInFlight; });
+			_packets.push_back(std::move(pPacket));
+		}
+
+		// the update of a frame is the time since the previous push returned
+		Clock::time_point end = Clock::now();
+		double waitMs = std::chrono::duration<double, std::milli>(end - begin).count();
+		if (_hasLastPush) {
+			double frameMs = std::chrono::duration<double, std::milli>(end - _lastPushTime).count();
+			++_stats.numFrames;
+			_stats.frameMs += frameMs;
+			_stats.waitMs += waitMs;
+			_stats.updateMs += frameMs - waitMs;
+		}
+		_lastPushTime = end;
+		_hasLastPush = true;
+	}
+	_packetPushed.notify_one();
+}
+
+void FramePipeline::flush() {
+	std::unique_lock lock(_mutex);
+	_packetDone.wait(lock, [this]() { return _packets.empty() && !_rendering; });
+	// the next frame after a flush does not include the stall
+	_hasLastPush = false;
+}
+
+size_t FramePipeline::getMaxFramesInFlight() const {
+	return _maxFramesInFlight;
+}
+
+FramePipelineStats FramePipeline::getStats() const {
+	std::lock_guard lock(_mutex);
+	return _stats;
+}
+
+void FramePipeline::resetStats() {
+	std::lock_guard lock(_mutex);
+	_stats = {};
+	_hasLastPush = false;
+}
+
+void FramePipeline::renderMain() {
+	// the render stage lags the main thread, its frame memory is rewound after every packet instead
+	// of at the main thread's endFrame
+	FrameArena *pArena = FrameArena::get();
+	pArena->setManualReset(true);
+	std::unique_lock lock(_mutex);
+	for (;;) {
+		_packetPushed.wait(lock, [this]() { return _quit || !_packets.empty(); });
+		if (_packets.empty())
+			break;
+
+		std::shared_ptr<const FramePacket> pPacket = std::move(_packets.front());
+		_packets.pop_front();
+		_rendering = true;
+		lock.unlock();
+		_packetDone.notify_all();
+
+		Clock::time_point begin = Clock::now();
+		_render(*pPacket);
+		double renderMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+		pPacket.reset();
+		pArena->reset();
+
+		lock.lock();
+		_stats.renderMs += renderMs;
+		_rendering = false;
+		_packetDone.notify_all();
+	}
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+namespace com {
+
+// everything the render stage needs from one update, never written after it is pushed
+struct FramePacket {
+	size_t frameIndex = 0;
+	float  totalTime = 0.f;
+	float  deltaTime = 0.f;
+public:
+	virtual ~FramePacket() = default;
+};
+
+struct FramePipelineStats {
+	size_t numFrames = 0;
+	double updateMs = 0.0;			// caller time between two pushes, not counting the wait for a free slot
+	double waitMs = 0.0;			// caller blocked on a full queue
+	double renderMs = 0.0;			// render stage busy time
+	double frameMs = 0.0;			// wall time between two pushes
+public:
+	double getAvgUpdateMs() const;
+	double getAvgRenderMs() const;
+	double getAvgFrameMs() const;
+	// what the frame would cost with update and render in sequence
+	double getAvgSerialFrameMs() const;
+	std::string toString() const;
+};
+
+// Two stage frame pipeline: the caller updates frame N+1 while a render thread of its own records
+// and submits frame N. The render thread is not a JobSystem worker, so the caller can never end up
+// running the render stage itself; the render function may still use the JobSystem. The queue
+// holds at most maxFramesInFlight packets, push sleeps while it is full.
+// Without a render function the packets are dropped, which runs the update stage headless
+class FramePipeline {
+public:
+	using RenderFunc = std::function<void(const FramePacket &packet)>;
+
+	explicit FramePipeline(RenderFunc render, size_t maxFramesInFlight = 1);
+	~FramePipeline();
+	FramePipeline(const FramePipeline &) = delete;
+	FramePipeline &operator=(const FramePipeline &) = delete;
+
+	void push(std::shared_ptr<const FramePacket> pPacket);
+	// waits until every pushed packet is rendered, the render thread is idle when it returns
+	void flush();
+	size_t getMaxFramesInFlight() const;
+	FramePipelineStats getStats() const;
+	void resetStats();
+private:
+	void renderMain();
+private:
+	using Clock = std::chrono::steady_clock;
+
+	RenderFunc _render;
+	size_t _maxFramesInFlight;
+	mutable std::mutex _mutex;
+	std::condition_variable _packetPushed;			// wakes the render thread
+	std::condition_variable _packetDone;			// wakes push and flush
+	std::deque<std::shared_ptr<const FramePacket>> _packets;
+	bool _rendering = false;						// the render thread holds a packet
+	bool _quit = false;
+	std::thread _renderThread;
+
+	FramePipelineStats _stats;
+	Clock::time_point _lastPushTime;
+	bool _hasLastPush = false;
+};
+
+}
@@ -0,0 +1,345 @@
+#include "Benchmark.h"
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+
+namespace com {
+
+void BenchmarkHash::add(std::uint64_t value) {
+	for (size_t i = 0; i < sizeof(value); ++i) {
+		_hash ^= (value >> (i * 8)) & 0xff;
+		_hash *= 0x100000001b3;
+	}
+}
+
+std::uint64_t BenchmarkHash::get() const {
+	return _hash;
+}
+
+void BenchmarkStageRecorder::begin(const char *name) {
+	assert(_openStage == SIZE_MAX && "benchmark stages do not nest");
+	_openStage = findStage(name);
+	_openTime = Clock::now();
+}
+
+void BenchmarkStageRecorder::end() {
+	assert(_openStage != SIZE_MAX);
+	std::chrono::duration<float, std::milli> elapsed = Clock::now() - _openTime;
+	_stageTimes[_openStage] += elapsed.count();
+	_openStage = SIZE_MAX;
+}
+
+const std::vector<std::string> &BenchmarkStageRecorder::getStageNames() const {
+	return _stageNames;
+}
+
+const std::vector<float> &BenchmarkStageRecorder::getStageTimes() const {
+	return _stageTimes;
+}
+
+void BenchmarkStageRecorder::resetFrame() {
+	std::fill(_stageTimes.begin(), _stageTimes.end(), 0.f);
+	_openStage = SIZE_MAX;
+}
+
+size_t BenchmarkStageRecorder::findStage(const char *name) {
+	for (size_t i = 0; i < _stageNames.size(); ++i) {
+		if (_stageNames[i] == name)
+			return i;
+	}
+	_stageNames.emplace_back(name);
+	_stageTimes.push_back(0.f);
+	return _stageNames.size() - 1;
+}
+
+BenchmarkStageScope::BenchmarkStageScope(BenchmarkStageRecorder &recorder, const char *name) : _recorder(recorder) {
+	_recorder.begin(name);
+}
+
+BenchmarkStageScope::~BenchmarkStageScope() {
+	_recorder.end();
+}
+
+std::uint64_t BenchmarkResult::getChecksum() const {
+	BenchmarkHash hash;
+	for (std::uint64_t frameHash : frameHashes)
+		hash.add(frameHash);
+	return hash.get();
+}
+
+FrameTimeStats BenchmarkResult::getStageStats(const std::string &stageName) const {
+	if (stageName == "total")
+		return calcFrameTimeStats(frameMs);
+	for (size_t i = 0; i < stageNames.size(); ++i) {
+		if (stageNames[i] == stageName)
+			return calcFrameTimeStats(stageMs[i]);
+	}
+	return {};
+}
+
+std::string BenchmarkResult::toString() const {
+	std::string text = std::format("{}: {} frames, checksum {:016x}\n", sceneName, frameMs.size(), getChecksum());
+	text += std::format("  {:<12} {}\n", "total", getStageStats("total").toString());
+	for (const std::string &stageName : stageNames)
+		text += std::format("  {:<12} {}\n", stageName, getStageStats(stageName).toString());
+	return text;
+}
+
+std::string BenchmarkResult::toCSV() const {
+	std::string csv = "frame,hash,total";
+	for (const std::string &stageName : stageNames)
+		csv += "," + stageName;
+	csv += '\n';
+	for (size_t frame = 0; frame < frameMs.size(); ++frame) {
+		csv += std::format("{},{:016x},{:.4f}", frame, frameHashes[frame], frameMs[frame]);
+		for (size_t stage = 0; stage < stageNames.size(); ++stage)
+			csv += std::format(",{:.4f}", stageMs[stage][frame]);
+		csv += '\n';
+	}
+	return csv;
+}
+
+std::string BenchmarkResult::toJson() const {
+	auto statsToJson = [](const std::string &name, const FrameTimeStats &stats) {
+		return std::format(R"({{"name":"{}","avgMs":{:.4f},"p50Ms":{:.4f},"p95Ms":{:.4f},"p99Ms":{:.4f},"worstMs":{:.4f}}})",
+			name, stats.averageMs, stats.p50Ms, stats.p95Ms, stats.p99Ms, stats.worstMs);
+	};
+	std::string json = std::format(R"({{"scene":"{}","frames":{},"fixedDeltaMs":{:.4f},"checksum":"{:016x}","stages":[)",
+		sceneName, frameMs.size(), fixedDeltaMs, getChecksum());
+	json += statsToJson("total", getStageStats("total"));
+	for (const std::string &stageName : stageNames)
+		json += "," + statsToJson(stageName, getStageStats(stageName));
+	json += "]}\n";
+	return json;
+}
+
+static bool writeFileAtomic(const std::string &path, const std::string &content) {
+	namespace fs = std::filesystem;
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream output(tempPath, std::ios::binary);
+		if (!output)
+			return false;
+		output.write(content.data(), static_cast<std::streamsize>(content.size()));
+		if (!output)
+			return false;
+	}
+	std::error_code error;
+	fs::rename(tempPath, path, error);
+	return !error;
+}
+
+bool BenchmarkResult::writeCSV(const std::string &path) const {
+	return writeFileAtomic(path, toCSV());
+}
+
+bool BenchmarkResult::writeJson(const std::string &path) const {
+	return writeFileAtomic(path, toJson());
+}
+
+static std::vector<std::string> splitCSVLine(const std::string &line) {
+	std::vector<std::string> fields;
+	std::stringstream stream(line);
+	std::string field;
+	while (std::getline(stream, field, ','))
+		fields.push_back(field);
+	return fields;
+}
+
+bool BenchmarkResult::readCSV(const std::string &path, BenchmarkResult &result) {
+	std::ifstream input(path);
+	if (!input)
+		return false;
+
+	std::string line;
+	if (!std::getline(input, line))
+		return false;
+	std::vector<std::string> header = splitCSVLine(line);
+	if (header.size() < 3 || header[0] != "frame" || header[1] != "hash" || header[2] != "total")
+		return false;
+
+	BenchmarkResult parsed;
+	parsed.sceneName = std::filesystem::path(path).stem().string();
+	parsed.stageNames.assign(header.begin() + 3, header.end());
+	parsed.stageMs.resize(parsed.stageNames.size());
+	while (std::getline(input, line)) {
+		if (line.empty())
+			continue;
+		std::vector<std::string> fields = splitCSVLine(line);
+		if (fields.size() != header.size())
+			return false;
+		parsed.frameHashes.push_back(std::strtoull(fields[1].c_str(), nullptr, 16));
+		parsed.frameMs.push_back(std::strtof(fields[2].c_str(), nullptr));
+		for (size_t stage = 0; stage < parsed.stageNames.size(); ++stage)
+			parsed.stageMs[stage].push_back(std::strtof(fields[stage + 3].c_str(), nullptr));
+	}
+	result = std::move(parsed);
+	return true;
+}
+
+float BenchmarkRegression::getRatio() const {
+	return baselineMs > 0.f ? currentMs / baselineMs : 0.f;
+}
+
+std::string BenchmarkRegression::toString() const {
+	return std::format("{} {}: {:.4f}ms -> {:.4f}ms (+{:.1f}%)",
+		stageName, metric, baselineMs, currentMs, (getRatio() - 1.f) * 100.f);
+}
+
+std::vector<BenchmarkRegression> compareBenchmarks(const BenchmarkResult &baseline,
+	const BenchmarkResult &current,
+	float tolerance,
+	float minMs)
+{
+	std::vector<BenchmarkRegression> regressions;
+	auto compare = [&](const std::string &stageName) {
+		FrameTimeStats before = baseline.getStageStats(stageName);
+		FrameTimeStats after = current.getStageStats(stageName);
+		if (before.numFrames == 0 || after.numFrames == 0)
+			return;
+
+		auto check = [&](const char *metric, float beforeMs, float afterMs) {
+			if (std::max(beforeMs, afterMs) < minMs)
+				return;
+			if (afterMs > beforeMs * (1.f + tolerance))
+				regressions.push_back({ stageName, metric, beforeMs, afterMs });
+		};
+		check("p50", before.p50Ms, after.p50Ms);
+		check("p95", before.p95Ms, after.p95Ms);
+	};
+
+	compare("total");
+	for (const std::string &stageName : current.stageNames)
+		compare(stageName);
+	return regressions;
+}
+
+BenchmarkResult BenchmarkRunner::run(IBenchmarkScene &scene, BenchmarkConfig config) const {
+	using Clock = std::chrono::steady_clock;
+	scene.onBenchmarkBegin(config);
+
+	// the scene only ever sees simulated time, every run steps through the same frames
+	auto pClock = std::make_shared<ManualGameClock>();
+	GameTimer gameTimer(pClock);
+	BenchmarkStageRecorder stages;
+
+	BenchmarkResult result;
+	result.sceneName = scene.getName();
+	result.fixedDeltaMs = config.fixedDeltaMs;
+	result.frameMs.reserve(config.numFrames);
+	result.frameHashes.reserve(config.numFrames);
+
+	size_t numTotalFrames = config.numWarmupFrames + config.numFrames;
+	for (size_t frameIndex = 0; frameIndex < numTotalFrames; ++frameIndex) {
+		if (frameIndex > 0)
+			pClock->advanceMs(config.fixedDeltaMs);
+		gameTimer.startNewFrame();
+		stages.resetFrame();
+
+		auto frameStart = Clock::now();
+		BenchmarkFrame frame;
+		frame.frameIndex = frameIndex;
+		frame.warmup = frameIndex < config.numWarmupFrames;
+		frame.pGameTimer = &gameTimer;
+		{
+			BenchmarkStageScope scope(stages, "camera");
+			frame.camera = config.cameraPath.sample(gameTimer.getTotalTime());
+			frame.frustum = BenchmarkFrustum(frame.camera, config.fovY, config.aspect, config.zNear, config.zFar);
+		}
+		std::uint64_t frameHash = scene.onBenchmarkFrame(frame, stages);
+		std::chrono::duration<float, std::milli> frameTime = Clock::now() - frameStart;
+		if (frame.warmup)
+			continue;
+
+		result.frameMs.push_back(frameTime.count());
+		result.frameHashes.push_back(frameHash);
+		const std::vector<float> &stageTimes = stages.getStageTimes();
+		result.stageMs.resize(stageTimes.size());
+		for (size_t stage = 0; stage < stageTimes.size(); ++stage) {
+			// a stage first seen late gets zeros for the frames before it
+			result.stageMs[stage].resize(result.frameMs.size() - 1, 0.f);
+			result.stageMs[stage].push_back(stageTimes[stage]);
+		}
+	}
+	scene.onBenchmarkEnd();
+
+	result.stageNames = stages.getStageNames();
+	result.stageMs.resize(result.stageNames.size());
+	for (std::vector<float> &stageTimes : result.stageMs)
+		stageTimes.resize(result.frameMs.size(), 0.f);
+	return result;
+}
+
+bool isBenchmarkRequested(int argc, char *argv[]) {
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--benchmark") == 0)
+			return true;
+	}
+	return false;
+}
+
+int runBenchmarkMain(int argc, char *argv[], IBenchmarkScene &scene) {
+	BenchmarkConfig config;
+	std::string outPath = std::string(scene.getName()) + "Benchmark";
+	std::string baselinePath;
+	float tolerance = 0.1f;
+	for (int i = 1; i < argc; ++i) {
+		std::string_view arg = argv[i];
+		const char *pValue = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if (arg == "--benchmark" || pValue == nullptr)
+			continue;
+
+		if (arg == "--frames")
+			config.numFrames = std::strtoull(pValue, nullptr, 10);
+		else if (arg == "--warmup")
+			config.numWarmupFrames = std::strtoull(pValue, nullptr, 10);
+		else if (arg == "--dt")
+			config.fixedDeltaMs = std::strtof(pValue, nullptr);
+		else if (arg == "--out")
+			outPath = pValue;
+		else if (arg == "--baseline")
+			baselinePath = pValue;
+		else if (arg == "--tolerance")
+			tolerance = std::strtof(pValue, nullptr);
+		else
+			continue;
+		++i;
+	}
+
+	BenchmarkRunner runner;
+	BenchmarkResult result = runner.run(scene, config);
+	std::cout << result.toString();
+	if (!result.writeCSV(outPath + ".csv") || !result.writeJson(outPath + ".json")) {
+		std::cerr << "failed to write " << outPath << ".csv/.json" << std::endl;
+		return 1;
+	}
+
+	if (baselinePath.empty())
+		return 0;
+
+	BenchmarkResult baseline;
+	if (!BenchmarkResult::readCSV(baselinePath, baseline)) {
+		std::cerr << "failed to read baseline " << baselinePath << std::endl;
+		return 1;
+	}
+
+	bool passed = true;
+	if (baseline.frameHashes.size() == result.frameHashes.size() && baseline.getChecksum() != result.getChecksum()) {
+		// the timings are not comparable when the frames did different work
+		std::cerr << "checksum differs from the baseline, the scene output changed" << std::endl;
+		passed = false;
+	}
+	for (const BenchmarkRegression &regression : compareBenchmarks(baseline, result, tolerance)) {
+		std::cerr << "regression: " << regression.toString() << std::endl;
+		passed = false;
+	}
+	return passed ? 0 : 1;
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "GameTimer/GameTimer.h"
+#include "Benchmark/BenchmarkCamera.h"
+
+namespace com {
+
+struct BenchmarkConfig {
+	size_t numWarmupFrames = 60;
+	size_t numFrames = 600;
+	float  fixedDeltaMs = 1000.f / 60.f;		// simulated time per frame, independent of how long the frame took
+	float  fovY = 0.785398f;
+	float  aspect = 16.f / 9.f;
+	float  zNear = 0.1f;
+	float  zFar = 1000.f;
+	CameraPath cameraPath;						// empty lets the scene pick its own
+};
+
+// FNV-1a, for the per frame hash scenes return
+class BenchmarkHash {
+public:
+	void add(std::uint64_t value);
+	std::uint64_t get() const;
+private:
+	std::uint64_t _hash = 0xcbf29ce484222325;
+};
+
+struct BenchmarkFrame {
+	size_t frameIndex = 0;
+	bool   warmup = false;
+	const GameTimer *pGameTimer = nullptr;
+	CameraPose camera;
+	BenchmarkFrustum frustum;
+};
+
+// per stage wall time of the running frame, stages are columns in the order they first appear
+class BenchmarkStageRecorder {
+public:
+	void begin(const char *name);
+	void end();
+	const std::vector<std::string> &getStageNames() const;
+	// milliseconds of every stage this frame, stages that did not run are 0
+	const std::vector<float> &getStageTimes() const;
+	void resetFrame();
+private:
+	size_t findStage(const char *name);
+private:
+	using Clock = std::chrono::steady_clock;
+	std::vector<std::string> _stageNames;
+	std::vector<float> _stageTimes;
+	size_t _openStage = SIZE_MAX;
+	Clock::time_point _openTime;
+};
+
+class BenchmarkStageScope {
+public:
+	BenchmarkStageScope(BenchmarkStageRecorder &recorder, const char *name);
+	BenchmarkStageScope(const BenchmarkStageScope &) = delete;
+	BenchmarkStageScope &operator=(const BenchmarkStageScope &) = delete;
+	~BenchmarkStageScope();
+private:
+	BenchmarkStageRecorder &_recorder;
+};
+
+// The CPU side of a demo frame without a device: animation, culling, transform propagation and
+// queue building. Scenes must be deterministic, the same config has to produce the same frames
+class IBenchmarkScene {
+public:
+	virtual const char *getName() const = 0;
+	// build the scene, an empty config.cameraPath should be filled in here
+	virtual void onBenchmarkBegin(BenchmarkConfig &config) = 0;
+	// returns a hash of what the frame produced (visible counts, draw keys ...), it must not
+	// depend on timing. Equal hashes between two runs mean both measured the same work
+	virtual std::uint64_t onBenchmarkFrame(const BenchmarkFrame &frame, BenchmarkStageRecorder &stages) = 0;
+	virtual void onBenchmarkEnd() {}
+	virtual ~IBenchmarkScene() = default;
+};
+
+struct BenchmarkResult {
+	std::string sceneName;
+	float fixedDeltaMs = 0.f;
+	std::vector<std::string> stageNames;				// "total" is implied and not listed
+	std::vector<float> frameMs;							// per measured frame
+	std::vector<std::vector<float>> stageMs;			// [stage][frame]
+	std::vector<std::uint64_t> frameHashes;
+public:
+	std::uint64_t getChecksum() const;
+	// "total" or a stage name, empty stats when unknown
+	FrameTimeStats getStageStats(const std::string &stageName) const;
+	std::string toString() const;
+	std::string toCSV() const;
+	std::string toJson() const;
+	bool writeCSV(const std::string &path) const;
+	bool writeJson(const std::string &path) const;
+	// reads what writeCSV wrote, returns false when the file is missing or malformed
+	static bool readCSV(const std::string &path, BenchmarkResult &result);
+};
+
+struct BenchmarkRegression {
+	std::string stageName;
+	std::string metric;				// "p50" or "p95"
+	float baselineMs = 0.f;
+	float currentMs = 0.f;
+public:
+	float getRatio() const;
+	std::string toString() const;
+};
+
+// stages whose p50 or p95 grew by more than tolerance (0.1 == 10%) over the baseline. Stages
+// faster than minMs in both runs are skipped, timer noise dominates them
+std::vector<BenchmarkRegression> compareBenchmarks(const BenchmarkResult &baseline,
+	const BenchmarkResult &current,
+	float tolerance = 0.1f,
+	float minMs = 0.05f
+);
+
+class BenchmarkRunner {
+public:
+	BenchmarkResult run(IBenchmarkScene &scene, BenchmarkConfig config) const;
+};
+
+// true when argv asks for the headless benchmark
+bool isBenchmarkRequested(int argc, char *argv[]);
+// Runs the scene and writes <out>.csv and <out>.json. Flags:
+//   --benchmark --frames N --warmup N --dt ms --out path --baseline path.csv --tolerance 0.1
+// returns the process exit code, 1 when the baseline comparison failed
+int runBenchmarkMain(int argc, char *argv[], IBenchmarkScene &scene);
+
+}
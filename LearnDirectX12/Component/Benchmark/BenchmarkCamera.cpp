@@ -0,0 +1,222 @@
+#include "BenchmarkCamera.h"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+namespace com {
+
+static float dot3(const float *lhs, const float *rhs) {
+	return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+}
+
+static void cross3(const float *lhs, const float *rhs, float *dst) {
+	float x = lhs[1] * rhs[2] - lhs[2] * rhs[1];
+	float y = lhs[2] * rhs[0] - lhs[0] * rhs[2];
+	float z = lhs[0] * rhs[1] - lhs[1] * rhs[0];
+	dst[0] = x; dst[1] = y; dst[2] = z;
+}
+
+static void normalize3(float *v) {
+	float length = std::sqrt(dot3(v, v));
+	if (length > 0.f) {
+		v[0] /= length; v[1] /= length; v[2] /= length;
+	}
+}
+
+static float catmullRom(float p0, float p1, float p2, float p3, float t) {
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.f * p1) + (-p0 + p2) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (-p0 + 3.f * p1 - 3.f * p2 + p3) * t3);
+}
+
+CameraPath::CameraPath(bool loop) : _loop(loop) {
+}
+
+void CameraPath::addKey(float time, const CameraPose &pose) {
+	assert(_keys.empty() || time > _keys.back().time);
+	_keys.push_back({ time, pose });
+}
+
+CameraPose CameraPath::sample(float time) const {
+	if (_keys.empty())
+		return {};
+	if (_keys.size() == 1)
+		return _keys.front().pose;
+
+	float start = _keys.front().time;
+	float duration = getDuration();
+	float local = time - start;
+	if (_loop)
+		local = std::fmod(std::fmod(local, duration) + duration, duration);
+	else
+		local = std::clamp(local, 0.f, duration);
+
+	float keyTime = start + local;
+	auto iter = std::upper_bound(_keys.begin(), _keys.end(), keyTime, [](float t, const CameraPathKey &key) {
+		return t < key.time;
+	});
+	size_t count = _keys.size();
+	size_t i1 = std::clamp<size_t>(static_cast<size_t>(iter - _keys.begin()), 1, count - 1) - 1;
+	size_t i2 = i1 + 1;
+	bool hasPrev = i1 > 0 || _loop;
+	bool hasNext = i2 + 1 < count || _loop;
+	const CameraPose &p0 = _keys[i1 > 0 ? i1 - 1 : count - 2].pose;
+	const CameraPose &p1 = _keys[i1].pose;
+	const CameraPose &p2 = _keys[i2].pose;
+	const CameraPose &p3 = _keys[i2 + 1 < count ? i2 + 1 : 1].pose;
+
+	float span = _keys[i2].time - _keys[i1].time;
+	float t = std::clamp((keyTime - _keys[i1].time) / span, 0.f, 1.f);
+	// the open ends of a clamped path mirror the neighbour key, so the first and last segment stay straight
+	auto interpolate = [&](const float *v0, const float *v1, const float *v2, const float *v3, float *dst) {
+		for (size_t c = 0; c < 3; ++c) {
+			float prev = hasPrev ? v0[c] : 2.f * v1[c] - v2[c];
+			float next = hasNext ? v3[c] : 2.f * v2[c] - v1[c];
+			dst[c] = catmullRom(prev, v1[c], v2[c], next, t);
+		}
+	};
+	CameraPose pose;
+	interpolate(p0.position, p1.position, p2.position, p3.position, pose.position);
+	interpolate(p0.target, p1.target, p2.target, p3.target, pose.target);
+	return pose;
+}
+
+float CameraPath::getDuration() const {
+	if (_keys.size() < 2)
+		return 0.f;
+	return _keys.back().time - _keys.front().time;
+}
+
+size_t CameraPath::getNumKeys() const {
+	return _keys.size();
+}
+
+bool CameraPath::empty() const {
+	return _keys.empty();
+}
+
+CameraPath CameraPath::makeOrbit(const float center[3], float radius, float height, float duration, size_t numKeys) {
+	assert(numKeys >= 2);
+	constexpr float kTwoPi = 6.28318530718f;
+	CameraPath path(true);
+	// the last key closes the loop on the first one
+	for (size_t i = 0; i <= numKeys; ++i) {
+		float angle = kTwoPi * static_cast<float>(i % numKeys) / static_cast<float>(numKeys);
+		CameraPose pose;
+		pose.position[0] = center[0] + radius * std::cos(angle);
+		pose.position[1] = center[1] + height;
+		pose.position[2] = center[2] + radius * std::sin(angle);
+		pose.target[0] = center[0];
+		pose.target[1] = center[1];
+		pose.target[2] = center[2];
+		path.addKey(duration * static_cast<float>(i) / static_cast<float>(numKeys), pose);
+	}
+	return path;
+}
+
+BenchmarkFrustum::BenchmarkFrustum(const CameraPose &pose, float fovY, float aspect, float zNear, float zFar) {
+	constexpr float kWorldUp[3] = { 0.f, 1.f, 0.f };
+	for (size_t c = 0; c < 3; ++c) {
+		_eye[c] = pose.position[c];
+		_forward[c] = pose.target[c] - pose.position[c];
+	}
+	normalize3(_forward);
+	cross3(kWorldUp, _forward, _right);
+	normalize3(_right);
+	cross3(_forward, _right, _up);
+
+	_tanHalfFovY = std::tan(fovY * 0.5f);
+	_tanHalfFovX = _tanHalfFovY * aspect;
+
+	auto setPlane = [&](Plane plane, const float normal[3], float offset) {
+		float n[3] = { normal[0], normal[1], normal[2] };
+		normalize3(n);
+		_planes[plane][0] = n[0];
+		_planes[plane][1] = n[1];
+		_planes[plane][2] = n[2];
+		_planes[plane][3] = -dot3(n, _eye) + offset * dot3(n, _forward);
+	};
+
+	float negForward[3] = { -_forward[0], -_forward[1], -_forward[2] };
+	float left[3], right[3], bottom[3], top[3];
+	for (size_t c = 0; c < 3; ++c) {
+		left[c] = _right[c] + _forward[c] * _tanHalfFovX;
+		right[c] = -_right[c] + _forward[c] * _tanHalfFovX;
+		bottom[c] = _up[c] + _forward[c] * _tanHalfFovY;
+		top[c] = -_up[c] + _forward[c] * _tanHalfFovY;
+	}
+	setPlane(Near, _forward, -zNear);
+	setPlane(Far, negForward, -zFar);
+	setPlane(Left, left, 0.f);
+	setPlane(Right, right, 0.f);
+	setPlane(Bottom, bottom, 0.f);
+	setPlane(Top, top, 0.f);
+}
+
+bool BenchmarkFrustum::intersectsBox(const float center[3], const float extents[3]) const {
+	for (const float *plane : _planes) {
+		float radius = extents[0] * std::abs(plane[0]) + extents[1] * std::abs(plane[1]) + extents[2] * std::abs(plane[2]);
+		if (dot3(plane, center) + plane[3] < -radius)
+			return false;
+	}
+	return true;
+}
+
+bool BenchmarkFrustum::intersectsSphere(const float center[3], float radius) const {
+	for (const float *plane : _planes) {
+		if (dot3(plane, center) + plane[3] < -radius)
+			return false;
+	}
+	return true;
+}
+
+void BenchmarkFrustum::getCorners(float zNear, float zFar, float corners[8][3]) const {
+	const float depths[2] = { zNear, zFar };
+	constexpr float kSigns[4][2] = { { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+	for (size_t slice = 0; slice < 2; ++slice) {
+		float z = depths[slice];
+		for (size_t i = 0; i < 4; ++i) {
+			float x = kSigns[i][0] * z * _tanHalfFovX;
+			float y = kSigns[i][1] * z * _tanHalfFovY;
+			for (size_t c = 0; c < 3; ++c)
+				corners[slice * 4 + i][c] = _eye[c] + _right[c] * x + _up[c] * y + _forward[c] * z;
+		}
+	}
+}
+
+void BenchmarkFrustum::toViewSpace(const float position[3], float viewPos[3]) const {
+	float offset[3] = { position[0] - _eye[0], position[1] - _eye[1], position[2] - _eye[2] };
+	viewPos[0] = dot3(offset, _right);
+	viewPos[1] = dot3(offset, _up);
+	viewPos[2] = dot3(offset, _forward);
+}
+
+const float *BenchmarkFrustum::getPlane(Plane plane) const {
+	return _planes[plane];
+}
+
+const float *BenchmarkFrustum::getEye() const {
+	return _eye;
+}
+
+const float *BenchmarkFrustum::getForward() const {
+	return _forward;
+}
+
+const float *BenchmarkFrustum::getRight() const {
+	return _right;
+}
+
+const float *BenchmarkFrustum::getUp() const {
+	return _up;
+}
+
+float BenchmarkFrustum::getTanHalfFovX() const {
+	return _tanHalfFovX;
+}
+
+float BenchmarkFrustum::getTanHalfFovY() const {
+	return _tanHalfFovY;
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace com {
+
+struct CameraPose {
+	float position[3] = { 0.f, 0.f, 0.f };
+	float target[3] = { 0.f, 0.f, 1.f };
+};
+
+struct CameraPathKey {
+	float time;
+	CameraPose pose;
+};
+
+// scripted camera, Catmull-Rom through the keys. Keys are added in time order, sampling past the
+// last key wraps around when the path loops and clamps otherwise. The last key of a looping path
+// has to repeat the first one
+class CameraPath {
+public:
+	explicit CameraPath(bool loop = true);
+	void addKey(float time, const CameraPose &pose);
+	CameraPose sample(float time) const;
+	float getDuration() const;
+	size_t getNumKeys() const;
+	bool empty() const;
+	// numKeys keys on a circle around center, looking at center
+	static CameraPath makeOrbit(const float center[3], float radius, float height, float duration, size_t numKeys = 8);
+private:
+	bool _loop;
+	std::vector<CameraPathKey> _keys;
+};
+
+// left handed like the demo cameras, +y is up. Plane normals point inwards: dot(n, p) + d >= 0 inside
+class BenchmarkFrustum {
+public:
+	enum Plane { Near, Far, Left, Right, Bottom, Top, kNumPlanes };
+public:
+	BenchmarkFrustum() = default;
+	BenchmarkFrustum(const CameraPose &pose, float fovY, float aspect, float zNear, float zFar);
+	bool intersectsBox(const float center[3], const float extents[3]) const;
+	bool intersectsSphere(const float center[3], float radius) const;
+	// world space corners of the slice [zNear, zFar], near corners first
+	void getCorners(float zNear, float zFar, float corners[8][3]) const;
+	// position relative to the eye expressed in the right/up/forward basis
+	void toViewSpace(const float position[3], float viewPos[3]) const;
+	const float *getPlane(Plane plane) const;
+	const float *getEye() const;
+	const float *getForward() const;
+	const float *getRight() const;
+	const float *getUp() const;
+	float getTanHalfFovX() const;
+	float getTanHalfFovY() const;
+private:
+	float _planes[kNumPlanes][4] = {};
+	float _eye[3] = {};
+	float _forward[3] = { 0.f, 0.f, 1.f };
+	float _right[3] = { 1.f, 0.f, 0.f };
+	float _up[3] = { 0.f, 1.f, 0.f };
+	float _tanHalfFovX = 1.f;
+	float _tanHalfFovY = 1.f;
+};
+
+}
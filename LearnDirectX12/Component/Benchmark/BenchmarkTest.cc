@@ -0,0 +1,153 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <array>
+#include <filesystem>
+#include "Benchmark.h"
+
+using namespace com;
+
+static bool nearlyEqual(float lhs, float rhs, float epsilon = 1e-3f) {
+	return std::abs(lhs - rhs) <= epsilon;
+}
+
+// a grid of spheres, the hash is the visible set of every frame
+class SphereGridScene : public IBenchmarkScene {
+public:
+	explicit SphereGridScene(size_t workScale = 1) : _workScale(workScale) {}
+	const char *getName() const override {
+		return "SphereGrid";
+	}
+	void onBenchmarkBegin(BenchmarkConfig &config) override {
+		if (config.cameraPath.empty()) {
+			float center[3] = { 0.f, 0.f, 0.f };
+			config.cameraPath = CameraPath::makeOrbit(center, 60.f, 10.f, 4.f);
+		}
+		_centers.clear();
+		for (int x = -10; x <= 10; ++x) {
+			for (int z = -10; z <= 10; ++z)
+				_centers.push_back({ x * 4.f, 0.f, z * 4.f });
+		}
+	}
+	std::uint64_t onBenchmarkFrame(const BenchmarkFrame &frame, BenchmarkStageRecorder &stages) override {
+		std::uint64_t hash = 0;
+		{
+			BenchmarkStageScope scope(stages, "cull");
+			for (size_t repeat = 0; repeat < _workScale; ++repeat) {
+				hash = 0;
+				for (size_t i = 0; i < _centers.size(); ++i) {
+					if (frame.frustum.intersectsSphere(_centers[i].data(), 1.f))
+						hash = hash * 31 + i + 1;
+				}
+			}
+		}
+		if (frame.frameIndex % 2 == 0) {
+			BenchmarkStageScope scope(stages, "even");
+			hash ^= frame.frameIndex;
+		}
+		return hash;
+	}
+private:
+	size_t _workScale;
+	std::vector<std::array<float, 3>> _centers;
+};
+
+void cameraPathTest() {
+	CameraPath path(false);
+	CameraPose a, b, c;
+	a.position[0] = 0.f;
+	b.position[0] = 10.f;
+	c.position[0] = 20.f;
+	path.addKey(0.f, a);
+	path.addKey(1.f, b);
+	path.addKey(2.f, c);
+	assert(nearlyEqual(path.sample(0.f).position[0], 0.f));
+	assert(nearlyEqual(path.sample(1.f).position[0], 10.f));
+	assert(nearlyEqual(path.sample(0.5f).position[0], 5.f));
+	assert(nearlyEqual(path.sample(5.f).position[0], 20.f));
+
+	float center[3] = { 0.f, 0.f, 0.f };
+	CameraPath orbit = CameraPath::makeOrbit(center, 10.f, 2.f, 8.f);
+	assert(nearlyEqual(orbit.getDuration(), 8.f));
+	CameraPose start = orbit.sample(0.f);
+	CameraPose wrapped = orbit.sample(8.f);
+	assert(nearlyEqual(start.position[0], 10.f) && nearlyEqual(wrapped.position[0], 10.f));
+	assert(nearlyEqual(orbit.sample(2.f).position[2], 10.f));
+}
+
+void frustumTest() {
+	CameraPose pose;
+	pose.position[2] = -10.f;
+	pose.target[2] = 0.f;
+	BenchmarkFrustum frustum(pose, 1.5707963f, 1.f, 1.f, 100.f);
+	float inside[3] = { 0.f, 0.f, 0.f };
+	float behind[3] = { 0.f, 0.f, -20.f };
+	float beyond[3] = { 0.f, 0.f, 95.f };
+	float side[3] = { 20.f, 0.f, 0.f };
+	float extents[3] = { 1.f, 1.f, 1.f };
+	assert(frustum.intersectsSphere(inside, 1.f));
+	assert(!frustum.intersectsSphere(behind, 1.f));
+	assert(!frustum.intersectsSphere(beyond, 1.f));
+	assert(!frustum.intersectsBox(side, extents));
+	// 90 degrees: x == z at the edge
+	float edge[3] = { 10.5f, 0.f, 0.f };
+	assert(frustum.intersectsBox(edge, extents));
+
+	float corners[8][3];
+	frustum.getCorners(1.f, 100.f, corners);
+	assert(nearlyEqual(corners[0][0], -1.f) && nearlyEqual(corners[0][2], -9.f));
+	assert(nearlyEqual(corners[6][0], 100.f) && nearlyEqual(corners[6][1], 100.f) && nearlyEqual(corners[6][2], 90.f));
+	float viewPos[3];
+	frustum.toViewSpace(inside, viewPos);
+	assert(nearlyEqual(viewPos[2], 10.f));
+}
+
+void runnerTest() {
+	BenchmarkConfig config;
+	config.numWarmupFrames = 5;
+	config.numFrames = 120;
+	BenchmarkRunner runner;
+	SphereGridScene scene;
+	BenchmarkResult first = runner.run(scene, config);
+	BenchmarkResult second = runner.run(scene, config);
+	assert(first.frameMs.size() == 120);
+	assert(first.stageNames.size() == 3);
+	assert(first.stageNames[0] == "camera" && first.stageNames[1] == "cull" && first.stageNames[2] == "even");
+	// warmup is 5 frames, the first measured frame is odd
+	assert(first.stageMs[2][0] == 0.f && first.stageMs[2][1] > 0.f);
+	// deterministic: same frames, same work
+	assert(first.frameHashes == second.frameHashes);
+	assert(first.getChecksum() == second.getChecksum());
+	assert(first.getStageStats("cull").numFrames == 120);
+	assert(first.getStageStats("unknown").numFrames == 0);
+
+	std::string path = "SphereGridBenchmarkTest.csv";
+	assert(first.writeCSV(path));
+	BenchmarkResult loaded;
+	assert(BenchmarkResult::readCSV(path, loaded));
+	std::filesystem::remove(path);
+	assert(loaded.stageNames == first.stageNames);
+	assert(loaded.getChecksum() == first.getChecksum());
+	assert(loaded.frameMs.size() == first.frameMs.size());
+	assert(!BenchmarkResult::readCSV(path, loaded));
+
+	// ten times the culling work has to show up as a regression
+	SphereGridScene slowScene(10);
+	BenchmarkResult slow = runner.run(slowScene, config);
+	assert(slow.getChecksum() == first.getChecksum());
+	auto regressions = compareBenchmarks(first, slow, 0.5f, 0.f);
+	bool cullRegressed = false;
+	for (const BenchmarkRegression &regression : regressions)
+		cullRegressed |= regression.stageName == "cull";
+	assert(cullRegressed);
+	for (const BenchmarkRegression &regression : compareBenchmarks(slow, first, 0.5f, 0.f))
+		assert(regression.stageName != "cull");
+	std::cout << first.toString() << first.toJson();
+}
+
+int main() {
+	cameraPathTest();
+	frustumTest();
+	runnerTest();
+	return 0;
+}
@@ -1,4 +1,7 @@
 #include <D3D/Animation/SkinnedData.h>
+#include <Profiler/Profiler.h>
+#include <FrameArena/FrameArena.h>
+#include <algorithm>
 
 namespace d3d {
 using namespace Math;
@@ -65,14 +68,17 @@ float AnimationClip::getClipEndTime() const {
 }
 
 std::vector<float4x4> AnimationClip::interpolate(float timePoint) const {
-	std::vector<float4x4> result;
-	result.reserve(boneAnimations.size());
-	for (auto &bone : boneAnimations)
-		result.push_back(bone.interpolate(timePoint));
-
+	std::vector<float4x4> result(boneAnimations.size());
+	interpolate(timePoint, result);
 	return result;
 }
 
+void AnimationClip::interpolate(float timePoint, std::span<float4x4> result) const {
+	size_t count = std::min(result.size(), boneAnimations.size());
+	for (size_t i = 0; i < count; ++i)
+		result[i] = boneAnimations[i].interpolate(timePoint);
+}
+
 size_t SkinnedData::getBoneCount() const {
 	return _boneHierarchy.size();
 }
@@ -94,16 +100,30 @@ float SkinnedData::getClipEndTime(const std::string &clipName) const {
 }
 
 std::vector<float4x4> SkinnedData::getFinalTransforms(const std::string &clipName, float timePoint) const {
+	std::vector<float4x4> result(_boneOffsets.size());
+	getFinalTransforms(clipName, timePoint, result);
+	return result;
+}
+
+void SkinnedData::getFinalTransforms(const std::string &clipName, float timePoint, std::span<float4x4> result) const {
+	PROFILE_ZONE("SkinnedData::getFinalTransforms");
 	auto iter = _animations.find(clipName);
 	if ( iter == _animations.end()) {
 		assert(false);
-		return {};
+		return;
 	}
 
-	std::vector<float4x4> boneTransform = iter->second.interpolate(timePoint);
-	std::vector<Matrix4> toRootSpaceTransforms(_boneOffsets.size());
+	// a bone's parent comes before it, only the bones up to the last written one are needed
+	size_t numBones = std::min(result.size(), _boneOffsets.size());
+	if (numBones == 0)
+		return;
+
+	com::FrameArena *pArena = com::FrameArena::get();
+	std::pmr::vector<float4x4> boneTransform(numBones, pArena);
+	iter->second.interpolate(timePoint, boneTransform);
+	std::pmr::vector<Matrix4> toRootSpaceTransforms(numBones, pArena);
 	toRootSpaceTransforms[0] = static_cast<Matrix4>(boneTransform[0]);
-	for (size_t i = 1; i < boneTransform.size(); ++i) {
+	for (size_t i = 1; i < numBones; ++i) {
 		size_t parentIndex = _boneHierarchy[i];
 		Matrix4 toParent { boneTransform[i] };
 		const Matrix4 &parentToRoot = toRootSpaceTransforms[parentIndex];
@@ -111,14 +131,11 @@ std::vector<float4x4> SkinnedData::getFinalTransforms(const std::string &clipNam
 		toRootSpaceTransforms[i] = toRoot;
 	}
 
-	std::vector<float4x4> result;
-	result.reserve(_boneOffsets.size());
-	for (size_t i = 0; i < toRootSpaceTransforms.size(); ++i) {
+	for (size_t i = 0; i < numBones; ++i) {
 		Matrix4 offset { _boneOffsets[i] };
 		const Matrix4 &toRootSpace = toRootSpaceTransforms[i];
-		result.push_back(static_cast<float4x4>(toRootSpace * offset));
+		result[i] = static_cast<float4x4>(toRootSpace * offset);
 	}
-	return result;
 }
 
 void SkinnedData::setBoneHierarchy(const std::vector<size_t> &boneHierarchy) {
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <span>
 #include <unordered_map>
 #include <Math/MathStd.hpp>
 
@@ -34,6 +35,8 @@ struct AnimationClip {
 	float getClipStartTime() const;
 	float getClipEndTime() const;
 	std::vector<Math::float4x4> interpolate(float timePoint) const;
+	// writes the first result.size() bones
+	void interpolate(float timePoint, std::span<Math::float4x4> result) const;
 	std::vector<BoneAnimation> boneAnimations;
 };
 
@@ -44,6 +47,9 @@ public:
 	float getClipStartTime(const std::string &clipName) const;
 	float getClipEndTime(const std::string &clipName) const;
 	std::vector<Math::float4x4> getFinalTransforms(const std::string &clipName, float timePoint) const;
+	// writes the first result.size() bones straight into the caller's memory (a mapped constant
+	// buffer), the temporaries come from the frame arena
+	void getFinalTransforms(const std::string &clipName, float timePoint, std::span<Math::float4x4> result) const;
 	void setBoneHierarchy(const std::vector<size_t> &boneHierarchy);
 	void setBoneOffsets(const std::vector<Math::float4x4> &boneOffsets);
 	void setAnimations(const std::unordered_map<std::string, AnimationClip> &animations);
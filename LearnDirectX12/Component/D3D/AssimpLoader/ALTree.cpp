@@ -1,5 +1,6 @@
 #include "ALTree.h"
 #include "ALNode.h"
+#include "Profiler/Profiler.h"
 #include <filesystem>
 
 namespace d3d {
@@ -60,9 +61,14 @@ void ALMaterial::processTexture(ALTexture &texture,
 }
 
 ALTree::ALTree(const std::string &path, int flag) {
+	PROFILE_ZONE("ALTree::import");
 	Assimp::Importer importer;
 	importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_LINE | aiPrimitiveType_POINT);
-	const aiScene *pAiScene = importer.ReadFile(path, flag);
+	const aiScene *pAiScene = nullptr;
+	{
+		PROFILE_ZONE("ALTree::readFile");
+		pAiScene = importer.ReadFile(path, flag);
+	}
 	if (pAiScene == nullptr || pAiScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || pAiScene->mRootNode == nullptr) {
 		assert(false);
 		return;
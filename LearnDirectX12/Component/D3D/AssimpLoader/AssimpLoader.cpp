@@ -27,46 +27,6 @@ bool AssimpLoader::isLoad() const {
 	return _isLoad;
 }
 
-void AssimpLoader::prepareTexture(dx12lib::CommonContextProxy pCommonCtx) const {
-
-	auto prepareMaterialTexture = [&](const aiMaterial *pAiMaterial, aiTextureType type, bool sRGB) {
-		aiString path;
-		pAiMaterial->GetTexture(type, 0, &path);
-		if (path.data[0] == '*') {						//  * ͷ,ʾǶͼ, ƴһͼ
-			int textureIndex = 0;
-			sscanf_s(path.data, "*%d", &textureIndex);
-			assert(static_cast<size_t>(textureIndex) < _pScene->mNumTextures);
-			const aiTexture *pAiTexture = _pScene->mTextures[textureIndex];
-			std::string textureName = _fileName + pAiTexture->mFilename.C_Str();;
-			if (TextureManager::instance()->exist(textureName))
-				return;
-
-			assert(pAiTexture->mHeight != 0 && "Embedded maps can only be compressed textures");
-			auto pTexture = pCommonCtx->createTextureFromMemory(pAiTexture->achFormatHint,
-				pAiTexture->pcData,
-				pAiTexture->mWidth,
-				sRGB
-			);
-			TextureManager::instance()->set(textureName, pTexture);
-
-		} else {
-			std::string textureName = path.C_Str();
-			auto pTexture = pCommonCtx->createTextureFromFile(std::to_wstring(textureName), sRGB);
-			TextureManager::instance()->set(textureName, pTexture);
-		}
-	};
-
-	for (size_t i = 0; i < _pScene->mNumMeshes; ++i) {
-		const aiMesh *pAiMesh = _pScene->mMeshes[i];
-		const aiMaterial *pAiMaterial = _pScene->mMaterials[pAiMesh->mMaterialIndex];
-		prepareMaterialTexture(pAiMaterial, aiTextureType_DIFFUSE, true);
-		prepareMaterialTexture(pAiMaterial, aiTextureType_METALNESS, false);
-		prepareMaterialTexture(pAiMaterial, aiTextureType_DIFFUSE_ROUGHNESS, true);
-		prepareMaterialTexture(pAiMaterial, aiTextureType_NORMALS, false);
-		prepareMaterialTexture(pAiMaterial, aiTextureType_AMBIENT_OCCLUSION, false);
-	}
-}
-
 std::vector<AssimpLoader::ALMesh> AssimpLoader::parseMesh() const {
 	assert(isLoad());
 	std::vector<ALMesh> meshs;
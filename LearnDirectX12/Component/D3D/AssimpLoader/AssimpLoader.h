@@ -46,7 +46,6 @@ public:
 	explicit AssimpLoader(const std::string &fileName);
 	bool load(const int flag = kDefaultLoadFlag);
 	bool isLoad() const;
-	void prepareTexture(dx12lib::CommonContextProxy pCommonCtx) const;
 	std::vector<ALMesh> parseMesh() const;
 	std::vector<ALSkinnedMesh> parseSkinnedMesh() const;
 	const std::string &getFileName() const;
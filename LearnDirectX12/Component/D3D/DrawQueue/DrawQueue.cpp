@@ -0,0 +1,204 @@
+#include "DrawQueue.h"
+#include <cassert>
+#include <cstring>
+#include <bit>
+#include <format>
+
+namespace d3d {
+
+namespace DrawSortKey {
+
+constexpr static std::uint64_t kMask16 = 0xffff;
+constexpr static std::uint64_t kMask12 = 0xfff;
+constexpr static std::uint64_t kMask4 = 0xf;
+
+std::uint64_t make(std::uint32_t pass,
+	std::uint32_t pipeline,
+	std::uint32_t material,
+	std::uint32_t geometry,
+	float viewDepth,
+	DrawOrder order)
+{
+	assert(pass <= kMask4 && pipeline <= kMask12 && material <= kMask16 && geometry <= kMask16);
+	std::uint64_t depth = quantizeDepth(viewDepth);
+	std::uint64_t key = (pass & kMask4) << 60;
+	if (order == DrawOrder::Opaque) {
+		key |= (pipeline & kMask12) << 48;
+		key |= (material & kMask16) << 32;
+		key |= (geometry & kMask16) << 16;
+		key |= depth;
+	} else {
+		key |= (~depth & kMask16) << 44;
+		key |= (pipeline & kMask12) << 32;
+		key |= (material & kMask16) << 16;
+		key |= (geometry & kMask16);
+	}
+	return key;
+}
+
+std::uint16_t quantizeDepth(float viewDepth) {
+	if (!(viewDepth > 0.f))
+		return 0;
+	// positive floats order like their bit patterns
+	return static_cast<std::uint16_t>(std::bit_cast<std::uint32_t>(viewDepth) >> 16);
+}
+
+std::uint32_t getPass(std::uint64_t key) {
+	return static_cast<std::uint32_t>(key >> 60);
+}
+
+std::uint32_t getPipeline(std::uint64_t key, DrawOrder order) {
+	return static_cast<std::uint32_t>((key >> (order == DrawOrder::Opaque ? 48 : 32)) & kMask12);
+}
+
+std::uint32_t getMaterial(std::uint64_t key, DrawOrder order) {
+	return static_cast<std::uint32_t>((key >> (order == DrawOrder::Opaque ? 32 : 16)) & kMask16);
+}
+
+std::uint32_t getGeometry(std::uint64_t key, DrawOrder order) {
+	return static_cast<std::uint32_t>((key >> (order == DrawOrder::Opaque ? 16 : 0)) & kMask16);
+}
+
+}
+
+DrawStateRegistry::DrawStateRegistry(std::uint32_t maxId) : _maxId(maxId) {
+}
+
+std::uint32_t DrawStateRegistry::getId(const void *pState) {
+	auto iter = _ids.find(pState);
+	if (iter != _ids.end())
+		return iter->second;
+
+	// a collision only costs a redundant bind, never a wrong one
+	std::uint32_t id = _nextId;
+	_nextId = (_nextId == _maxId) ? 0 : _nextId + 1;
+	_ids.emplace(pState, id);
+	return id;
+}
+
+size_t DrawStateRegistry::size() const {
+	return _ids.size();
+}
+
+void DrawStateRegistry::clear() {
+	_ids.clear();
+	_nextId = 0;
+}
+
+void radixSortDrawItems(std::vector<DrawItem> &items, std::vector<DrawItem> &scratch) {
+	constexpr size_t kNumDigits = sizeof(std::uint64_t);
+	size_t count = items.size();
+	if (count < 2)
+		return;
+
+	// every histogram in one read
+	std::uint32_t histograms[kNumDigits][256];
+	std::memset(histograms, 0, sizeof(histograms));
+	for (const DrawItem &item : items) {
+		for (size_t digit = 0; digit < kNumDigits; ++digit)
+			++histograms[digit][(item.key >> (digit * 8)) & 0xff];
+	}
+
+	scratch.resize(count);
+	DrawItem *pSrc = items.data();
+	DrawItem *pDst = scratch.data();
+	for (size_t digit = 0; digit < kNumDigits; ++digit) {
+		std::uint32_t *pHistogram = histograms[digit];
+		// the pass and most of the pipeline bits are usually the same for every item
+		if (pHistogram[(pSrc[0].key >> (digit * 8)) & 0xff] == count)
+			continue;
+
+		std::uint32_t offset = 0;
+		for (size_t bucket = 0; bucket < 256; ++bucket) {
+			std::uint32_t bucketCount = pHistogram[bucket];
+			pHistogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			const DrawItem &item = pSrc[i];
+			pDst[pHistogram[(item.key >> (digit * 8)) & 0xff]++] = item;
+		}
+		std::swap(pSrc, pDst);
+	}
+
+	if (pSrc != items.data())
+		items.swap(scratch);
+}
+
+std::string DrawStateChanges::toString() const {
+	return std::format("draws: {}, pipeline changes: {}, material changes: {}, geometry changes: {}",
+		numDraws, pipelineChanges, materialChanges, geometryChanges);
+}
+
+void DrawStateTracker::reset() {
+	_pipeline = kNone;
+	_material = kNone;
+	_geometry = kNone;
+}
+
+bool DrawStateTracker::setPipeline(std::uint32_t pipeline) {
+	if (pipeline == _pipeline)
+		return false;
+	_pipeline = pipeline;
+	_material = kNone;
+	++_changes.pipelineChanges;
+	return true;
+}
+
+bool DrawStateTracker::setMaterial(std::uint32_t material) {
+	if (material == _material)
+		return false;
+	_material = material;
+	++_changes.materialChanges;
+	return true;
+}
+
+bool DrawStateTracker::setGeometry(std::uint32_t geometry) {
+	if (geometry == _geometry)
+		return false;
+	_geometry = geometry;
+	++_changes.geometryChanges;
+	return true;
+}
+
+void DrawStateTracker::draw() {
+	++_changes.numDraws;
+}
+
+const DrawStateChanges &DrawStateTracker::getChanges() const {
+	return _changes;
+}
+
+void DrawStateTracker::resetChanges() {
+	_changes = {};
+}
+
+void DrawQueue::clear() {
+	_items.clear();
+}
+
+void DrawQueue::reserve(size_t count) {
+	_items.reserve(count);
+}
+
+void DrawQueue::push(std::uint64_t key, std::uint32_t index) {
+	_items.push_back({ key, index });
+}
+
+void DrawQueue::sort() {
+	radixSortDrawItems(_items, _scratch);
+}
+
+size_t DrawQueue::size() const {
+	return _items.size();
+}
+
+bool DrawQueue::empty() const {
+	return _items.empty();
+}
+
+const std::vector<DrawItem> &DrawQueue::getItems() const {
+	return _items;
+}
+
+}
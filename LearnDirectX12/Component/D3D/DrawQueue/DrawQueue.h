@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace d3d {
+
+enum class DrawOrder : std::uint8_t {
+	Opaque,				// state first, front to back inside equal state
+	Transparent,		// back to front first, state only breaks ties
+};
+
+// 64 bit sort key
+//   opaque:      pass:4 | pipeline:12 | material:16 | geometry:16 | depth:16
+//   transparent: pass:4 | ~depth:16 | pipeline:12 | material:16 | geometry:16
+namespace DrawSortKey {
+constexpr std::uint32_t kPassBits	  = 4;
+constexpr std::uint32_t kPipelineBits = 12;
+constexpr std::uint32_t kMaterialBits = 16;
+constexpr std::uint32_t kGeometryBits = 16;
+constexpr std::uint32_t kDepthBits	  = 16;
+
+std::uint64_t make(std::uint32_t pass,
+	std::uint32_t pipeline,
+	std::uint32_t material,
+	std::uint32_t geometry,
+	float viewDepth,
+	DrawOrder order = DrawOrder::Opaque
+);
+// monotonic in the view depth, the upper bits of the float keep more precision close to the camera
+std::uint16_t quantizeDepth(float viewDepth);
+std::uint32_t getPass(std::uint64_t key);
+std::uint32_t getPipeline(std::uint64_t key, DrawOrder order = DrawOrder::Opaque);
+std::uint32_t getMaterial(std::uint64_t key, DrawOrder order = DrawOrder::Opaque);
+std::uint32_t getGeometry(std::uint64_t key, DrawOrder order = DrawOrder::Opaque);
+}
+
+// hands out the small ids the sort key needs for pipelines, materials and geometries
+class DrawStateRegistry {
+public:
+	explicit DrawStateRegistry(std::uint32_t maxId);
+	// the same pointer always gets the same id, ids wrap once maxId is reached
+	std::uint32_t getId(const void *pState);
+	size_t size() const;
+	void clear();
+private:
+	std::uint32_t _maxId;
+	std::uint32_t _nextId = 0;
+	std::unordered_map<const void *, std::uint32_t> _ids;
+};
+
+struct DrawItem {
+	std::uint64_t key;
+	std::uint32_t index;			// into the caller's job list
+};
+
+// LSD radix sort on 8 bit digits, digits every key shares are skipped. Stable
+void radixSortDrawItems(std::vector<DrawItem> &items, std::vector<DrawItem> &scratch);
+
+// how often a draw sequence switches state, measures the order only, nothing is bound or skipped
+struct DrawStateChanges {
+	size_t numDraws = 0;
+	size_t pipelineChanges = 0;
+	size_t materialChanges = 0;
+	size_t geometryChanges = 0;
+public:
+	std::string toString() const;
+};
+
+// remembers the state of the last draw, a set* call returns true when it differs
+class DrawStateTracker {
+public:
+	void reset();
+	bool setPipeline(std::uint32_t pipeline);		// a new pipeline also counts the next material as a change
+	bool setMaterial(std::uint32_t material);
+	bool setGeometry(std::uint32_t geometry);
+	void draw();
+	const DrawStateChanges &getChanges() const;
+	void resetChanges();
+private:
+	constexpr static std::uint32_t kNone = 0xffffffff;
+	std::uint32_t _pipeline = kNone;
+	std::uint32_t _material = kNone;
+	std::uint32_t _geometry = kNone;
+	DrawStateChanges _changes;
+};
+
+// per frame list of keyed draws
+class DrawQueue {
+public:
+	void clear();
+	void reserve(size_t count);
+	void push(std::uint64_t key, std::uint32_t index);
+	void sort();
+	size_t size() const;
+	bool empty() const;
+	const std::vector<DrawItem> &getItems() const;
+private:
+	std::vector<DrawItem> _items;
+	std::vector<DrawItem> _scratch;
+};
+
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <format>
+#include <chrono>
+#include "TestCheck.h"
+#include "D3D/DrawQueue/DrawQueue.h"
+
+using namespace d3d;
+
+void drawQueueTest() {
+	// keys order by pass, then state, then depth for opaque; by depth first for transparent
+	std::uint64_t near = DrawSortKey::make(1, 3, 7, 9, 1.f);
+	std::uint64_t far = DrawSortKey::make(1, 3, 7, 9, 100.f);
+	std::uint64_t otherPipeline = DrawSortKey::make(1, 4, 0, 0, 0.5f);
+	std::uint64_t laterPass = DrawSortKey::make(2, 0, 0, 0, 0.f);
+	TEST_CHECK(near < far && far < otherPipeline && otherPipeline < laterPass);
+	TEST_CHECK(DrawSortKey::getPass(far) == 1 && DrawSortKey::getPipeline(far) == 3);
+	TEST_CHECK(DrawSortKey::getMaterial(far) == 7 && DrawSortKey::getGeometry(far) == 9);
+	std::uint64_t transparentNear = DrawSortKey::make(1, 0, 0, 0, 1.f, DrawOrder::Transparent);
+	std::uint64_t transparentFar = DrawSortKey::make(1, 5, 5, 5, 100.f, DrawOrder::Transparent);
+	TEST_CHECK(transparentFar < transparentNear && DrawSortKey::getGeometry(transparentFar, DrawOrder::Transparent) == 5);
+	TEST_CHECK(DrawSortKey::quantizeDepth(-1.f) == 0 && DrawSortKey::quantizeDepth(2.f) > DrawSortKey::quantizeDepth(1.9f));
+
+	DrawStateRegistry registry(3);
+	int states[5];
+	std::uint32_t id0 = registry.getId(&states[0]);
+	std::uint32_t id1 = registry.getId(&states[1]);
+	std::uint32_t id0Again = registry.getId(&states[0]);
+	TEST_CHECK(id0 == 0 && id1 == 1 && id0Again == 0);
+	registry.getId(&states[2]);
+	registry.getId(&states[3]);
+	std::uint32_t id4 = registry.getId(&states[4]);
+	TEST_CHECK(id4 == 0 && registry.size() == 5);
+
+	// 50k jobs in tree order: state changes on nearly every draw before sorting
+	constexpr size_t kNumJobs = 50000;
+	std::mt19937 random(37);
+	std::vector<DrawItem> items(kNumJobs);
+	for (size_t i = 0; i < kNumJobs; ++i) {
+		std::uint32_t pipeline = random() % 16;
+		std::uint32_t material = pipeline * 64 + random() % 64;
+		std::uint32_t geometry = random() % 4000;
+		float depth = std::uniform_real_distribution<float>(0.1f, 1000.f)(random);
+		items[i] = { DrawSortKey::make(random() % 2, pipeline, material, geometry, depth), static_cast<std::uint32_t>(i) };
+	}
+
+	auto countChanges = [](const std::vector<DrawItem> &sequence) {
+		DrawStateTracker tracker;
+		for (const DrawItem &item : sequence) {
+			tracker.setPipeline(DrawSortKey::getPipeline(item.key));
+			tracker.setMaterial(DrawSortKey::getMaterial(item.key));
+			tracker.setGeometry(DrawSortKey::getGeometry(item.key));
+			tracker.draw();
+		}
+		return tracker.getChanges();
+	};
+	DrawStateChanges unsorted = countChanges(items);
+
+	std::vector<DrawItem> expected = items;
+	auto begin = std::chrono::steady_clock::now();
+	std::stable_sort(expected.begin(), expected.end(), [](const DrawItem &lhs, const DrawItem &rhs) {
+		return lhs.key < rhs.key;
+	});
+	double stdSortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+	DrawQueue queue;
+	queue.reserve(kNumJobs);
+	double radixSortMs = 0.0;
+	for (int frame = 0; frame < 4; ++frame) {
+		queue.clear();
+		for (const DrawItem &item : items)
+			queue.push(item.key, item.index);
+		begin = std::chrono::steady_clock::now();
+		queue.sort();
+		radixSortMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+	radixSortMs /= 4.0;
+
+	const std::vector<DrawItem> &sorted = queue.getItems();
+	TEST_CHECK(sorted.size() == kNumJobs);
+	for (size_t i = 0; i < kNumJobs; ++i)
+		TEST_CHECK(sorted[i].key == expected[i].key && sorted[i].index == expected[i].index);
+
+	DrawStateChanges sortedChanges = countChanges(sorted);
+	TEST_CHECK(sortedChanges.numDraws == kNumJobs && sortedChanges.pipelineChanges <= 32);
+	TEST_CHECK((sortedChanges.pipelineChanges + sortedChanges.materialChanges) * 10 < unsorted.pipelineChanges + unsorted.materialChanges);
+	std::cout << std::format("[DrawQueue] {} jobs, radix sort: {:.2f} ms, std::stable_sort: {:.2f} ms\n", kNumJobs, radixSortMs, stdSortMs)
+		<< "  unsorted " << unsorted.toString() << "\n"
+		<< "  sorted   " << sortedChanges.toString() << std::endl;
+}
+
+int main() {
+	drawQueueTest();
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include "InstanceBatcher.h"
+#include <format>
+
+namespace d3d {
+
+size_t InstanceBatchStats::getDrawsSaved() const {
+	return drawsBefore - drawsAfter;
+}
+
+std::string InstanceBatchStats::toString() const {
+	return std::format("instancing: draws {} -> {} (saved {}), instanced draws: {}, max instances per draw: {}",
+		drawsBefore, drawsAfter, getDrawsSaved(), numInstancedDraws, maxInstancesPerDraw);
+}
+
+InstanceBatcher::InstanceBatcher(DrawOrder order, std::uint32_t maxInstancesPerDraw)
+: _order(order), _maxInstancesPerDraw(maxInstancesPerDraw)
+{
+}
+
+void InstanceBatcher::build(const std::vector<DrawItem> &sortedItems) {
+	clear();
+	_instanceIndices.reserve(sortedItems.size());
+	_stats.drawsBefore = sortedItems.size();
+
+	InstanceBatch *pBatch = nullptr;
+	for (const DrawItem &item : sortedItems) {
+		std::uint32_t pipeline = DrawSortKey::getPipeline(item.key, _order);
+		std::uint32_t material = DrawSortKey::getMaterial(item.key, _order);
+		std::uint32_t geometry = DrawSortKey::getGeometry(item.key, _order);
+		bool merge = pBatch != nullptr &&
+			pBatch->pipeline == pipeline &&
+			pBatch->material == material &&
+			pBatch->geometry == geometry &&
+			(_maxInstancesPerDraw == 0 || pBatch->instanceCount < _maxInstancesPerDraw);
+
+		if (!merge) {
+			InstanceBatch batch;
+			batch.pipeline = pipeline;
+			batch.material = material;
+			batch.geometry = geometry;
+			batch.firstInstance = static_cast<std::uint32_t>(_instanceIndices.size());
+			_batches.push_back(batch);
+			pBatch = &_batches.back();
+		}
+		_instanceIndices.push_back(item.index);
+		++pBatch->instanceCount;
+	}
+
+	_stats.drawsAfter = _batches.size();
+	for (const InstanceBatch &batch : _batches) {
+		if (batch.instanceCount > 1)
+			++_stats.numInstancedDraws;
+		_stats.maxInstancesPerDraw = std::max<size_t>(_stats.maxInstancesPerDraw, batch.instanceCount);
+	}
+}
+
+void InstanceBatcher::clear() {
+	_batches.clear();
+	_instanceIndices.clear();
+	_stats = {};
+}
+
+const std::vector<InstanceBatch> &InstanceBatcher::getBatches() const {
+	return _batches;
+}
+
+const std::vector<std::uint32_t> &InstanceBatcher::getInstanceIndices() const {
+	return _instanceIndices;
+}
+
+size_t InstanceBatcher::getInstanceCount() const {
+	return _instanceIndices.size();
+}
+
+const InstanceBatchStats &InstanceBatcher::getStats() const {
+	return _stats;
+}
+
+size_t getInstanceBufferCapacity(size_t requiredCount, size_t currentCapacity) {
+	constexpr size_t kMinCapacity = 64;
+	if (requiredCount <= currentCapacity)
+		return currentCapacity;
+	size_t capacity = std::max(currentCapacity, kMinCapacity);
+	while (capacity < requiredCount)
+		capacity *= 2;
+	return capacity;
+}
+
+}
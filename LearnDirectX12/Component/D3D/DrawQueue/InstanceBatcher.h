@@ -0,0 +1,64 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "D3D/DrawQueue/DrawQueue.h"
+
+namespace d3d {
+
+// one instanced draw, its instances are [firstInstance, firstInstance + instanceCount) of the instance buffer
+struct InstanceBatch {
+	std::uint32_t pipeline = 0;
+	std::uint32_t material = 0;
+	std::uint32_t geometry = 0;
+	std::uint32_t firstInstance = 0;
+	std::uint32_t instanceCount = 0;
+};
+
+struct InstanceBatchStats {
+	size_t drawsBefore = 0;
+	size_t drawsAfter = 0;
+	size_t numInstancedDraws = 0;			// draws with more than one instance
+	size_t maxInstancesPerDraw = 0;
+public:
+	size_t getDrawsSaved() const;
+	std::string toString() const;
+};
+
+// merges runs of sorted draw items that share pipeline, material and geometry into instanced draws.
+// Only neighbours merge, so transparent items keep their back to front order
+class InstanceBatcher {
+public:
+	// maxInstancesPerDraw == 0 puts no limit on a batch
+	explicit InstanceBatcher(DrawOrder order = DrawOrder::Opaque, std::uint32_t maxInstancesPerDraw = 0);
+	void build(const std::vector<DrawItem> &sortedItems);
+	void clear();
+	const std::vector<InstanceBatch> &getBatches() const;
+	// caller job index of every instance slot, in instance buffer order
+	const std::vector<std::uint32_t> &getInstanceIndices() const;
+	size_t getInstanceCount() const;
+	const InstanceBatchStats &getStats() const;
+
+	// fill(T &instance, std::uint32_t jobIndex) writes one slot, dst must hold getInstanceCount() elements
+	template<typename T, typename Func>
+	void packInstances(T *pDst, size_t dstCount, Func &&fill) const {
+		assert(dstCount >= _instanceIndices.size());
+		size_t count = std::min(dstCount, _instanceIndices.size());
+		for (size_t slot = 0; slot < count; ++slot)
+			fill(pDst[slot], _instanceIndices[slot]);
+	}
+private:
+	DrawOrder _order;
+	std::uint32_t _maxInstancesPerDraw;
+	std::vector<InstanceBatch> _batches;
+	std::vector<std::uint32_t> _instanceIndices;
+	InstanceBatchStats _stats;
+};
+
+// capacity for a per frame instance buffer, grows in powers of two so reallocation stays rare
+size_t getInstanceBufferCapacity(size_t requiredCount, size_t currentCapacity);
+
+}
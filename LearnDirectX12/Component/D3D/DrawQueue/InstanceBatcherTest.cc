@@ -0,0 +1,77 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "TestCheck.h"
+#include "D3D/DrawQueue/InstanceBatcher.h"
+
+using namespace d3d;
+
+void instanceBatcherTest() {
+	// a scene that repeats 20 meshes with 4 materials, like the power plant
+	constexpr size_t kNumJobs = 5000;
+	std::mt19937 random(38);
+	DrawQueue queue;
+	for (size_t i = 0; i < kNumJobs; ++i) {
+		std::uint32_t geometry = random() % 20;
+		std::uint32_t material = geometry % 4;
+		float depth = std::uniform_real_distribution<float>(0.1f, 500.f)(random);
+		queue.push(DrawSortKey::make(0, 1, material, geometry, depth), static_cast<std::uint32_t>(i));
+	}
+	queue.sort();
+
+	InstanceBatcher batcher;
+	batcher.build(queue.getItems());
+	const InstanceBatchStats &stats = batcher.getStats();
+	TEST_CHECK(stats.drawsBefore == kNumJobs && stats.drawsAfter == 20 && stats.numInstancedDraws == 20);
+	TEST_CHECK(stats.maxInstancesPerDraw > 150 && batcher.getInstanceCount() == kNumJobs);
+
+	// batches tile the instance buffer, every slot maps back to a job of the batch's state
+	std::vector<std::uint32_t> geometries(kNumJobs);
+	for (const DrawItem &item : queue.getItems())
+		geometries[item.index] = DrawSortKey::getGeometry(item.key);
+	std::vector<std::uint32_t> instances(batcher.getInstanceCount());
+	batcher.packInstances(instances.data(), instances.size(), [&](std::uint32_t &instance, std::uint32_t jobIndex) {
+		instance = jobIndex;
+	});
+	std::uint32_t nextInstance = 0;
+	for (const InstanceBatch &batch : batcher.getBatches()) {
+		TEST_CHECK(batch.firstInstance == nextInstance);
+		for (std::uint32_t slot = batch.firstInstance; slot < batch.firstInstance + batch.instanceCount; ++slot)
+			TEST_CHECK(geometries[instances[slot]] == batch.geometry);
+		nextInstance += batch.instanceCount;
+	}
+	TEST_CHECK(nextInstance == kNumJobs);
+	std::vector<std::uint32_t> sortedInstances = instances;
+	std::sort(sortedInstances.begin(), sortedInstances.end());
+	for (size_t i = 0; i < kNumJobs; ++i)
+		TEST_CHECK(sortedInstances[i] == i);
+
+	// a cap splits long runs
+	InstanceBatcher capped(DrawOrder::Opaque, 100);
+	capped.build(queue.getItems());
+	for (const InstanceBatch &batch : capped.getBatches())
+		TEST_CHECK(batch.instanceCount <= 100);
+	TEST_CHECK(capped.getStats().drawsAfter >= kNumJobs / 100);
+
+	// transparent items only merge with equal state neighbours, the depth order survives
+	DrawQueue transparentQueue;
+	float depths[] = { 10.f, 9.f, 8.f, 7.f, 6.f };
+	std::uint32_t transparentGeometry[] = { 1, 1, 2, 1, 1 };
+	for (std::uint32_t i = 0; i < 5; ++i)
+		transparentQueue.push(DrawSortKey::make(0, 0, 0, transparentGeometry[i], depths[i], DrawOrder::Transparent), i);
+	transparentQueue.sort();
+	InstanceBatcher transparent(DrawOrder::Transparent);
+	transparent.build(transparentQueue.getItems());
+	TEST_CHECK(transparent.getStats().drawsAfter == 3);
+	TEST_CHECK(transparent.getInstanceIndices() == std::vector<std::uint32_t>({ 0, 1, 2, 3, 4 }));
+
+	TEST_CHECK(getInstanceBufferCapacity(10, 0) == 64 && getInstanceBufferCapacity(150, 64) == 256);
+	TEST_CHECK(getInstanceBufferCapacity(100, 256) == 256);
+	std::cout << "[InstanceBatcher] " << stats.toString() << std::endl;
+}
+
+int main() {
+	instanceBatcherTest();
+	return 0;
+}
@@ -75,6 +75,8 @@ struct CSMSubFrustum {
 	float4x4 worldToLightMatrix;	// ռ
 	float3   center;				// view Դ
 	float	 lightPlane;			// Դƽ, PCSS ʹ
+	float	 texcoordScale;		// cascade resolution / shadow map size, the cascade uses the top left corner
+	float3	 subFrustumPad;
 };
 
 const static uint kMaxShadowCascaded = 4;
@@ -25,6 +25,9 @@ struct VertexOut {
 VertexOut VS(VertexIn vin) {
 	VertexOut vout;
 	vout.SVPosition = mul(gViewProj, float4(vin.position, 1.0)).xyww;
+#ifdef REVERSE_Z
+	vout.SVPosition.z = 0.0;		// reversed depth puts the far plane at 0
+#endif
 	vout.texcoord   = vin.position;
 	return vout;
 }
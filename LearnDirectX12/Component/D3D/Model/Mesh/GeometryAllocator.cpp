@@ -0,0 +1,202 @@
+#include "GeometryAllocator.h"
+#include <cassert>
+#include <algorithm>
+
+namespace d3d {
+
+GeometryAllocator::GeometryAllocator(size_t capacity) {
+	grow(capacity);
+}
+
+GeometryAllocator::Allocation GeometryAllocator::allocate(size_t count) {
+	if (count == 0)
+		return {};
+
+	// best fit: the smallest free block that can hold count elements
+	auto sizeIter = _freeBySize.lower_bound(count);
+	if (sizeIter == _freeBySize.end())
+		return {};
+
+	size_t blockOffset = sizeIter->second;
+	size_t blockCount = sizeIter->first;
+	eraseFreeBlock(_freeByOffset.find(blockOffset));
+	if (blockCount > count)
+		insertFreeBlock(blockOffset + count, blockCount - count);
+
+	_usedCount += count;
+	++_totalAllocations;
+	++_currFrameAllocations;
+	_currFrameAllocatedCount += count;
+
+	Allocation allocation;
+	allocation.handle = newHandle(blockOffset, count);
+	allocation.offset = blockOffset;
+	allocation.count = count;
+	return allocation;
+}
+
+void GeometryAllocator::free(Handle handle) {
+	if (!isValid(handle)) {
+		assert(false && "free invalid geometry allocation");
+		return;
+	}
+
+	AllocationRecord &record = _records[handle];
+	size_t offset = record.offset;
+	size_t count = record.count;
+	record.alive = false;
+	_freeHandles.push_back(handle);
+	_usedCount -= count;
+	++_totalFrees;
+	++_currFrameFrees;
+
+	// merge with the next free block
+	auto nextIter = _freeByOffset.find(offset + count);
+	if (nextIter != _freeByOffset.end()) {
+		count += nextIter->second;
+		eraseFreeBlock(nextIter);
+	}
+
+	// merge with the previous free block
+	auto prevIter = _freeByOffset.lower_bound(offset);
+	if (prevIter != _freeByOffset.begin()) {
+		--prevIter;
+		if (prevIter->first + prevIter->second == offset) {
+			offset = prevIter->first;
+			count += prevIter->second;
+			eraseFreeBlock(prevIter);
+		}
+	}
+	insertFreeBlock(offset, count);
+}
+
+void GeometryAllocator::grow(size_t newCapacity) {
+	if (newCapacity <= _capacity)
+		return;
+
+	size_t offset = _capacity;
+	size_t count = newCapacity - _capacity;
+	_capacity = newCapacity;
+
+	// extend the tail free block if there is one
+	if (!_freeByOffset.empty()) {
+		auto tailIter = std::prev(_freeByOffset.end());
+		if (tailIter->first + tailIter->second == offset) {
+			offset = tailIter->first;
+			count += tailIter->second;
+			eraseFreeBlock(tailIter);
+		}
+	}
+	insertFreeBlock(offset, count);
+}
+
+std::vector<GeometryAllocator::Move> GeometryAllocator::compact() {
+	std::vector<Handle> aliveHandles;
+	aliveHandles.reserve(_records.size());
+	for (Handle handle = 0; handle < _records.size(); ++handle) {
+		if (_records[handle].alive)
+			aliveHandles.push_back(handle);
+	}
+
+	std::sort(aliveHandles.begin(), aliveHandles.end(), [&](Handle lhs, Handle rhs) {
+		return _records[lhs].offset < _records[rhs].offset;
+	});
+
+	// slide every allocation down, moves are ordered so dst never overlaps a pending src
+	std::vector<Move> moves;
+	size_t cursor = 0;
+	for (Handle handle : aliveHandles) {
+		AllocationRecord &record = _records[handle];
+		if (record.offset != cursor) {
+			moves.push_back(Move{ record.offset, cursor, record.count });
+			record.offset = cursor;
+		}
+		cursor += record.count;
+	}
+
+	_freeByOffset.clear();
+	_freeBySize.clear();
+	if (cursor < _capacity)
+		insertFreeBlock(cursor, _capacity - cursor);
+	return moves;
+}
+
+void GeometryAllocator::beginFrame() {
+	_prevFrameAllocations = _currFrameAllocations;
+	_prevFrameFrees = _currFrameFrees;
+	_prevFrameAllocatedCount = _currFrameAllocatedCount;
+	_currFrameAllocations = 0;
+	_currFrameFrees = 0;
+	_currFrameAllocatedCount = 0;
+}
+
+bool GeometryAllocator::isValid(Handle handle) const {
+	return handle < _records.size() && _records[handle].alive;
+}
+
+size_t GeometryAllocator::getOffset(Handle handle) const {
+	assert(isValid(handle));
+	return _records[handle].offset;
+}
+
+size_t GeometryAllocator::getCount(Handle handle) const {
+	assert(isValid(handle));
+	return _records[handle].count;
+}
+
+size_t GeometryAllocator::getCapacity() const {
+	return _capacity;
+}
+
+GeometryAllocator::Stats GeometryAllocator::getStats() const {
+	Stats stats;
+	stats.capacity = _capacity;
+	stats.usedCount = _usedCount;
+	stats.freeCount = _capacity - _usedCount;
+	stats.largestFreeBlock = _freeBySize.empty() ? 0 : _freeBySize.rbegin()->first;
+	stats.numFreeBlocks = _freeByOffset.size();
+	stats.numAllocations = _records.size() - _freeHandles.size();
+	stats.totalAllocations = _totalAllocations;
+	stats.totalFrees = _totalFrees;
+	stats.frameAllocations = _prevFrameAllocations;
+	stats.frameFrees = _prevFrameFrees;
+	stats.frameAllocatedCount = _prevFrameAllocatedCount;
+	if (stats.freeCount > 0) {
+		float largest = static_cast<float>(stats.largestFreeBlock);
+		stats.fragmentation = 1.f - largest / static_cast<float>(stats.freeCount);
+	}
+	return stats;
+}
+
+void GeometryAllocator::insertFreeBlock(size_t offset, size_t count) {
+	assert(count > 0);
+	_freeByOffset.emplace(offset, count);
+	_freeBySize.emplace(count, offset);
+}
+
+void GeometryAllocator::eraseFreeBlock(std::map<size_t, size_t>::iterator iter) {
+	assert(iter != _freeByOffset.end());
+	auto [begin, end] = _freeBySize.equal_range(iter->second);
+	for (auto sizeIter = begin; sizeIter != end; ++sizeIter) {
+		if (sizeIter->second == iter->first) {
+			_freeBySize.erase(sizeIter);
+			break;
+		}
+	}
+	_freeByOffset.erase(iter);
+}
+
+GeometryAllocator::Handle GeometryAllocator::newHandle(size_t offset, size_t count) {
+	Handle handle;
+	if (!_freeHandles.empty()) {
+		handle = _freeHandles.back();
+		_freeHandles.pop_back();
+	} else {
+		handle = static_cast<Handle>(_records.size());
+		_records.emplace_back();
+	}
+	_records[handle] = AllocationRecord{ offset, count, true };
+	return handle;
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+namespace d3d {
+
+// Range allocator in element units. It only manages offsets and never owns data,
+// GeometryArena uses it to suballocate meshes inside a few large vertex/index buffers
+class GeometryAllocator {
+public:
+	using Handle = std::uint32_t;
+	constexpr static Handle kInvalidHandle = std::numeric_limits<Handle>::max();
+
+	struct Allocation {
+		Handle handle = kInvalidHandle;
+		size_t offset = 0;
+		size_t count  = 0;
+	public:
+		explicit operator bool() const { return handle != kInvalidHandle; }
+	};
+
+	// data move produced by compact(), all values are element counts
+	struct Move {
+		size_t srcOffset;
+		size_t dstOffset;
+		size_t count;
+	};
+
+	struct Stats {
+		size_t capacity           = 0;
+		size_t usedCount          = 0;
+		size_t freeCount          = 0;
+		size_t largestFreeBlock   = 0;
+		size_t numFreeBlocks      = 0;
+		size_t numAllocations     = 0;
+		size_t totalAllocations   = 0;
+		size_t totalFrees         = 0;
+		size_t frameAllocations   = 0;		// allocations in the last finished frame
+		size_t frameFrees         = 0;		// frees in the last finished frame
+		size_t frameAllocatedCount = 0;		// elements allocated in the last finished frame
+		float  fragmentation      = 0.f;	// 1 - largestFreeBlock / freeCount
+	};
+public:
+	explicit GeometryAllocator(size_t capacity = 0);
+	Allocation allocate(size_t count);
+	void free(Handle handle);
+	void grow(size_t newCapacity);
+	std::vector<Move> compact();
+	void beginFrame();
+	bool isValid(Handle handle) const;
+	size_t getOffset(Handle handle) const;
+	size_t getCount(Handle handle) const;
+	size_t getCapacity() const;
+	Stats getStats() const;
+private:
+	void insertFreeBlock(size_t offset, size_t count);
+	void eraseFreeBlock(std::map<size_t, size_t>::iterator iter);
+	Handle newHandle(size_t offset, size_t count);
+private:
+	struct AllocationRecord {
+		size_t offset = 0;
+		size_t count  = 0;
+		bool   alive  = false;
+	};
+	size_t _capacity  = 0;
+	size_t _usedCount = 0;
+	std::map<size_t, size_t>	  _freeByOffset;	// offset -> count
+	std::multimap<size_t, size_t> _freeBySize;		// count  -> offset
+	std::vector<AllocationRecord> _records;
+	std::vector<Handle>			  _freeHandles;
+	size_t _totalAllocations = 0;
+	size_t _totalFrees = 0;
+	size_t _currFrameAllocations = 0;
+	size_t _currFrameFrees = 0;
+	size_t _currFrameAllocatedCount = 0;
+	size_t _prevFrameAllocations = 0;
+	size_t _prevFrameFrees = 0;
+	size_t _prevFrameAllocatedCount = 0;
+};
+
+}
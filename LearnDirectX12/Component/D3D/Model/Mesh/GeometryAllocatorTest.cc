@@ -0,0 +1,49 @@
+#include <iostream>
+#include "TestCheck.h"
+#include "D3D/Model/Mesh/GeometryAllocator.h"
+
+using namespace d3d;
+
+void geometryAllocatorTest() {
+	GeometryAllocator allocator(100);
+	auto a = allocator.allocate(10);
+	auto b = allocator.allocate(20);
+	auto c = allocator.allocate(30);
+	TEST_CHECK(a.offset == 0 && b.offset == 10 && c.offset == 30);
+
+	// free the middle block, best fit should reuse it
+	allocator.free(b.handle);
+	auto d = allocator.allocate(15);
+	TEST_CHECK(d.offset == 10);
+	auto stats = allocator.getStats();
+	TEST_CHECK(stats.usedCount == 55);
+	TEST_CHECK(stats.numFreeBlocks == 2);
+	TEST_CHECK(stats.fragmentation > 0.f);
+
+	// free everything, neighbours must coalesce into one block
+	allocator.free(a.handle);
+	allocator.free(c.handle);
+	allocator.free(d.handle);
+	stats = allocator.getStats();
+	TEST_CHECK(stats.numFreeBlocks == 1);
+	TEST_CHECK(stats.largestFreeBlock == 100);
+	TEST_CHECK(stats.fragmentation == 0.f);
+
+	// out of space returns an invalid allocation, grow extends the tail block
+	auto e = allocator.allocate(80);
+	auto full = allocator.allocate(40);
+	TEST_CHECK(e && !full);
+	allocator.grow(200);
+	auto f = allocator.allocate(40);
+	TEST_CHECK(f.offset == 80);
+
+	allocator.beginFrame();
+	stats = allocator.getStats();
+	std::cout << "allocator frame allocations: " << stats.frameAllocations
+			  << ", fragmentation: " << stats.fragmentation << std::endl;
+}
+
+int main() {
+	geometryAllocatorTest();
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include "GeometryArena.h"
+#include <cstring>
+#include <algorithm>
+#include <format>
+
+namespace d3d {
+
+void CpuGeometryBackingStore::resize(size_t sizeInByte) {
+	_data.resize(sizeInByte);
+}
+
+void CpuGeometryBackingStore::write(size_t offsetInByte, const void *pData, size_t sizeInByte) {
+	assert(offsetInByte + sizeInByte <= _data.size());
+	std::memcpy(_data.data() + offsetInByte, pData, sizeInByte);
+	_writeBytes += sizeInByte;
+}
+
+void CpuGeometryBackingStore::move(size_t dstOffsetInByte, size_t srcOffsetInByte, size_t sizeInByte) {
+	assert(dstOffsetInByte + sizeInByte <= _data.size());
+	assert(srcOffsetInByte + sizeInByte <= _data.size());
+	std::memmove(_data.data() + dstOffsetInByte, _data.data() + srcOffsetInByte, sizeInByte);
+	_moveBytes += sizeInByte;
+}
+
+size_t CpuGeometryBackingStore::getSize() const {
+	return _data.size();
+}
+
+const std::vector<std::uint8_t> &CpuGeometryBackingStore::getData() const {
+	return _data;
+}
+
+size_t CpuGeometryBackingStore::getWriteBytes() const {
+	return _writeBytes;
+}
+
+size_t CpuGeometryBackingStore::getMoveBytes() const {
+	return _moveBytes;
+}
+
+GeometryArena::GeometryArena(StoreCreator storeCreator) : _storeCreator(std::move(storeCreator)) {
+	assert(_storeCreator != nullptr);
+}
+
+size_t GeometryArena::createStream(const GeometryStreamDesc &desc) {
+	assert(desc.stride > 0);
+	assert(findStream(desc.name) == kInvalidStream);
+	Stream stream;
+	stream.desc = desc;
+	stream.allocator.grow(desc.initCapacity);
+	stream.pStore = _storeCreator(desc);
+	stream.pStore->resize(desc.initCapacity * desc.stride);
+	_streams.push_back(std::move(stream));
+	return _streams.size() - 1;
+}
+
+size_t GeometryArena::findStream(const std::string &name) const {
+	for (size_t i = 0; i < _streams.size(); ++i) {
+		if (_streams[i].desc.name == name)
+			return i;
+	}
+	return kInvalidStream;
+}
+
+size_t GeometryArena::getNumStream() const {
+	return _streams.size();
+}
+
+GeometryRange GeometryArena::allocate(size_t streamIdx, const void *pData, size_t count) {
+	assert(streamIdx < _streams.size());
+	Stream &stream = _streams[streamIdx];
+	auto allocation = stream.allocator.allocate(count);
+	if (!allocation && count > 0 && stream.desc.growable) {
+		// double the capacity until the request fits in the tail block
+		size_t capacity = std::max<size_t>(stream.allocator.getCapacity(), 1);
+		while (capacity - stream.allocator.getStats().usedCount < count)
+			capacity *= 2;
+		capacity = std::max(capacity, stream.allocator.getCapacity() + count);
+		stream.allocator.grow(capacity);
+		stream.pStore->resize(capacity * stream.desc.stride);
+		++stream.numGrows;
+		allocation = stream.allocator.allocate(count);
+	}
+
+	if (!allocation)
+		return {};
+
+	if (pData != nullptr) {
+		size_t stride = stream.desc.stride;
+		stream.pStore->write(allocation.offset * stride, pData, count * stride);
+	}
+
+	GeometryRange range;
+	range.stream = streamIdx;
+	range.handle = allocation.handle;
+	range.offset = allocation.offset;
+	range.count = allocation.count;
+	return range;
+}
+
+void GeometryArena::write(size_t streamIdx, size_t offset, const void *pData, size_t count) {
+	assert(streamIdx < _streams.size());
+	Stream &stream = _streams[streamIdx];
+	assert(offset + count <= stream.allocator.getCapacity());
+	size_t stride = stream.desc.stride;
+	stream.pStore->write(offset * stride, pData, count * stride);
+}
+
+void GeometryArena::free(GeometryRange &range) {
+	if (!range)
+		return;
+
+	assert(range.stream < _streams.size());
+	_streams[range.stream].allocator.free(range.handle);
+	range = GeometryRange{};
+}
+
+size_t GeometryArena::getOffset(const GeometryRange &range) const {
+	assert(range.stream < _streams.size());
+	return _streams[range.stream].allocator.getOffset(range.handle);
+}
+
+size_t GeometryArena::compact(size_t streamIdx) {
+	assert(streamIdx < _streams.size());
+	Stream &stream = _streams[streamIdx];
+	size_t stride = stream.desc.stride;
+	size_t movedInByte = 0;
+	for (const auto &move : stream.allocator.compact()) {
+		size_t sizeInByte = move.count * stride;
+		stream.pStore->move(move.dstOffset * stride, move.srcOffset * stride, sizeInByte);
+		movedInByte += sizeInByte;
+	}
+	stream.compactMovedInByte += movedInByte;
+	return movedInByte;
+}
+
+void GeometryArena::beginFrame() {
+	for (auto &stream : _streams)
+		stream.allocator.beginFrame();
+}
+
+IGeometryBackingStore *GeometryArena::getStore(size_t streamIdx) const {
+	assert(streamIdx < _streams.size());
+	return _streams[streamIdx].pStore.get();
+}
+
+const GeometryStreamDesc &GeometryArena::getStreamDesc(size_t streamIdx) const {
+	assert(streamIdx < _streams.size());
+	return _streams[streamIdx].desc;
+}
+
+GeometryArenaStats GeometryArena::getStats(size_t streamIdx) const {
+	assert(streamIdx < _streams.size());
+	const Stream &stream = _streams[streamIdx];
+	GeometryArenaStats stats;
+	stats.name = stream.desc.name;
+	stats.stride = stream.desc.stride;
+	stats.allocator = stream.allocator.getStats();
+	stats.capacityInByte = stats.allocator.capacity * stream.desc.stride;
+	stats.usedInByte = stats.allocator.usedCount * stream.desc.stride;
+	stats.numGrows = stream.numGrows;
+	stats.compactMovedInByte = stream.compactMovedInByte;
+	return stats;
+}
+
+std::string GeometryArena::dumpStats() const {
+	std::string result;
+	for (size_t i = 0; i < _streams.size(); ++i) {
+		GeometryArenaStats stats = getStats(i);
+		result += std::format("[{}] stride: {}, used: {}/{} bytes, allocations: {}, free blocks: {}, "
+			"fragmentation: {:.3f}, frame alloc/free: {}/{}, grows: {}, compact moved: {} bytes\n",
+			stats.name,
+			stats.stride,
+			stats.usedInByte,
+			stats.capacityInByte,
+			stats.allocator.numAllocations,
+			stats.allocator.numFreeBlocks,
+			stats.allocator.fragmentation,
+			stats.allocator.frameAllocations,
+			stats.allocator.frameFrees,
+			stats.numGrows,
+			stats.compactMovedInByte
+		);
+	}
+	return result;
+}
+
+}
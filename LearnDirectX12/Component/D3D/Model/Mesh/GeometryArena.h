@@ -0,0 +1,107 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cassert>
+#include "GeometryAllocator.h"
+
+namespace d3d {
+
+// Storage behind one arena stream. The arena only talks in bytes,
+// the dx12 implementation lives in GeometryBackingStore.h, tests use CpuGeometryBackingStore
+struct IGeometryBackingStore {
+	virtual void resize(size_t sizeInByte) = 0;
+	virtual void write(size_t offsetInByte, const void *pData, size_t sizeInByte) = 0;
+	virtual void move(size_t dstOffsetInByte, size_t srcOffsetInByte, size_t sizeInByte) = 0;
+	virtual size_t getSize() const = 0;
+	virtual ~IGeometryBackingStore() = default;
+};
+
+class CpuGeometryBackingStore : public IGeometryBackingStore {
+public:
+	void resize(size_t sizeInByte) override;
+	void write(size_t offsetInByte, const void *pData, size_t sizeInByte) override;
+	void move(size_t dstOffsetInByte, size_t srcOffsetInByte, size_t sizeInByte) override;
+	size_t getSize() const override;
+	const std::vector<std::uint8_t> &getData() const;
+	size_t getWriteBytes() const;
+	size_t getMoveBytes() const;
+protected:
+	std::vector<std::uint8_t> _data;
+	size_t _writeBytes = 0;
+	size_t _moveBytes = 0;
+};
+
+struct GeometryStreamDesc {
+	std::string name;
+	size_t		stride;
+	size_t		initCapacity  = 1024 * 64;		// elements
+	bool		isIndexStream = false;
+	bool		growable	  = true;			// a fixed stream fails the allocation instead of growing
+};
+
+// A suballocated range inside a stream. offset/count are in elements, so offset can be used
+// directly as SubMesh::baseVertexLocation or SubMesh::startIndexLocation
+struct GeometryRange {
+	size_t					  stream = -1;
+	GeometryAllocator::Handle handle = GeometryAllocator::kInvalidHandle;
+	size_t					  offset = 0;
+	size_t					  count  = 0;
+public:
+	explicit operator bool() const { return handle != GeometryAllocator::kInvalidHandle; }
+};
+
+struct GeometryArenaStats {
+	std::string name;
+	size_t stride;
+	size_t capacityInByte;
+	size_t usedInByte;
+	size_t numGrows;
+	size_t compactMovedInByte;
+	GeometryAllocator::Stats allocator;
+};
+
+class GeometryArena {
+public:
+	using StoreCreator = std::function<std::unique_ptr<IGeometryBackingStore>(const GeometryStreamDesc &)>;
+	explicit GeometryArena(StoreCreator storeCreator);
+	GeometryArena(const GeometryArena &) = delete;
+	GeometryArena &operator=(const GeometryArena &) = delete;
+
+	size_t createStream(const GeometryStreamDesc &desc);
+	size_t findStream(const std::string &name) const;
+	size_t getNumStream() const;
+	GeometryRange allocate(size_t stream, const void *pData, size_t count);
+	// writes into elements whose offset was allocated in another stream, parallel streams
+	// with the same layout allocate from one of them and share its offsets
+	void write(size_t stream, size_t offset, const void *pData, size_t count);
+	void free(GeometryRange &range);
+	size_t getOffset(const GeometryRange &range) const;
+	size_t compact(size_t stream);
+	void beginFrame();
+	IGeometryBackingStore *getStore(size_t stream) const;
+	const GeometryStreamDesc &getStreamDesc(size_t stream) const;
+	GeometryArenaStats getStats(size_t stream) const;
+	std::string dumpStats() const;
+
+	template<typename T>
+	GeometryRange allocate(size_t stream, const std::vector<T> &data) {
+		assert(sizeof(T) == getStreamDesc(stream).stride);
+		return allocate(stream, data.data(), data.size());
+	}
+public:
+	constexpr static size_t kInvalidStream = -1;
+private:
+	struct Stream {
+		GeometryStreamDesc desc;
+		GeometryAllocator allocator;
+		std::unique_ptr<IGeometryBackingStore> pStore;
+		size_t numGrows = 0;
+		size_t compactMovedInByte = 0;
+	};
+	StoreCreator _storeCreator;
+	std::vector<Stream> _streams;
+};
+
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <memory>
+#include "TestCheck.h"
+#include "D3D/Model/Mesh/GeometryArena.h"
+
+using namespace d3d;
+
+void geometryArenaTest() {
+	GeometryArena arena([](const GeometryStreamDesc &) {
+		return std::make_unique<CpuGeometryBackingStore>();
+	});
+	size_t stream = arena.createStream(GeometryStreamDesc{ "Position", sizeof(int), 16 });
+
+	std::vector<int> mesh0(10);
+	std::vector<int> mesh1(10);
+	std::vector<int> mesh2(10);
+	std::iota(mesh0.begin(), mesh0.end(), 0);
+	std::iota(mesh1.begin(), mesh1.end(), 100);
+	std::iota(mesh2.begin(), mesh2.end(), 200);
+	GeometryRange r0 = arena.allocate(stream, mesh0);
+	GeometryRange r1 = arena.allocate(stream, mesh1);		// does not fit, the stream grows
+	GeometryRange r2 = arena.allocate(stream, mesh2);
+	TEST_CHECK(arena.getStats(stream).numGrows >= 1);
+
+	// free the first mesh and compact, the remaining data must slide down intact
+	arena.free(r0);
+	size_t moved = arena.compact(stream);
+	TEST_CHECK(moved == 20 * sizeof(int));
+	TEST_CHECK(arena.getOffset(r1) == 0);
+	TEST_CHECK(arena.getOffset(r2) == 10);
+
+	auto *pStore = static_cast<CpuGeometryBackingStore *>(arena.getStore(stream));
+	const int *pData = reinterpret_cast<const int *>(pStore->getData().data());
+	for (size_t i = 0; i < 10; ++i) {
+		TEST_CHECK(pData[arena.getOffset(r1) + i] == mesh1[i]);
+		TEST_CHECK(pData[arena.getOffset(r2) + i] == mesh2[i]);
+	}
+
+	// random churn to look at fragmentation
+	std::mt19937 gen(0);
+	std::uniform_int_distribution<size_t> dist(1, 64);
+	std::vector<GeometryRange> ranges;
+	for (size_t i = 0; i < 1000; ++i) {
+		if (!ranges.empty() && (gen() % 3) == 0) {
+			size_t idx = gen() % ranges.size();
+			arena.free(ranges[idx]);
+			ranges.erase(ranges.begin() + idx);
+		} else {
+			ranges.push_back(arena.allocate(stream, nullptr, dist(gen)));
+		}
+	}
+	arena.beginFrame();
+	std::cout << "before compact: " << arena.dumpStats();
+	arena.compact(stream);
+	std::cout << "after compact:  " << arena.dumpStats();
+	TEST_CHECK(arena.getStats(stream).allocator.fragmentation == 0.f);
+
+	// a fixed stream never grows, two streams fed the same allocations keep the same offsets
+	GeometryStreamDesc pageDesc{ "Page", sizeof(int), 16 };
+	pageDesc.growable = false;
+	size_t page0 = arena.createStream(pageDesc);
+	pageDesc.name = "PageShadow";
+	size_t page1 = arena.createStream(pageDesc);
+	GeometryRange p0 = arena.allocate(page0, mesh0);
+	GeometryRange s0 = arena.allocate(page1, nullptr, mesh0.size());
+	TEST_CHECK(p0 && s0 && p0.offset == s0.offset);
+	TEST_CHECK(!arena.allocate(page0, mesh1));
+	TEST_CHECK(arena.getStats(page0).numGrows == 0);
+	TEST_CHECK(arena.getStats(page0).capacityInByte == 16 * sizeof(int));
+	arena.free(p0);
+	GeometryRange p1 = arena.allocate(page0, mesh1);
+	TEST_CHECK(p1 && p1.offset == 0);
+
+	// a parallel stream takes its data at the offset allocated in the first one
+	arena.write(page1, p1.offset, mesh2.data(), mesh2.size());
+	const int *pShadow = reinterpret_cast<const int *>(static_cast<CpuGeometryBackingStore *>(arena.getStore(page1))->getData().data());
+	for (size_t i = 0; i < mesh2.size(); ++i)
+		TEST_CHECK(pShadow[p1.offset + i] == mesh2[i]);
+}
+
+int main() {
+	geometryArenaTest();
+	return 0;
+}
@@ -0,0 +1,71 @@
+#include "GeometryBackingStore.h"
+#include <dx12lib/Buffer/VertexBuffer.h>
+#include <dx12lib/Buffer/IndexBuffer.h>
+#include <algorithm>
+
+namespace d3d {
+
+DX12GeometryBackingStore::DX12GeometryBackingStore(const GeometryStreamDesc &desc) : _desc(desc) {
+	assert(!desc.isIndexStream || desc.stride == sizeof(std::uint16_t) || desc.stride == sizeof(std::uint32_t));
+}
+
+void DX12GeometryBackingStore::resize(size_t sizeInByte) {
+	CpuGeometryBackingStore::resize(sizeInByte);
+	_writtenEnd = std::min(_writtenEnd, sizeInByte);
+}
+
+void DX12GeometryBackingStore::write(size_t offsetInByte, const void *pData, size_t sizeInByte) {
+	CpuGeometryBackingStore::write(offsetInByte, pData, sizeInByte);
+	_writtenEnd = std::max(_writtenEnd, offsetInByte + sizeInByte);
+	_dirty = true;
+}
+
+void DX12GeometryBackingStore::move(size_t dstOffsetInByte, size_t srcOffsetInByte, size_t sizeInByte) {
+	CpuGeometryBackingStore::move(dstOffsetInByte, srcOffsetInByte, sizeInByte);
+	_writtenEnd = std::max(_writtenEnd, dstOffsetInByte + sizeInByte);
+	_dirty = true;
+}
+
+bool DX12GeometryBackingStore::flush(dx12lib::IDirectContext &directCtx) {
+	if (!_dirty || _writtenEnd == 0)
+		return false;
+
+	// the unwritten tail of the page is never uploaded
+	size_t count = (_writtenEnd + _desc.stride - 1) / _desc.stride;
+	if (_desc.isIndexStream) {
+		DXGI_FORMAT format = (_desc.stride == sizeof(std::uint16_t)) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		_pIndexBuffer = directCtx.createIndexBuffer(_data.data(), count, format);
+	} else {
+		_pVertexBuffer = directCtx.createVertexBuffer(_data.data(), count, _desc.stride);
+	}
+	_uploadedBytes += count * _desc.stride;
+	_dirty = false;
+	return true;
+}
+
+void DX12GeometryBackingStore::release() {
+	_pVertexBuffer = nullptr;
+	_pIndexBuffer = nullptr;
+	_writtenEnd = 0;
+	_dirty = false;
+}
+
+bool DX12GeometryBackingStore::isDirty() const {
+	return _dirty;
+}
+
+size_t DX12GeometryBackingStore::getUploadedBytes() const {
+	return _uploadedBytes;
+}
+
+std::shared_ptr<dx12lib::VertexBuffer> DX12GeometryBackingStore::getVertexBuffer() const {
+	assert(!_desc.isIndexStream);
+	return _pVertexBuffer;
+}
+
+std::shared_ptr<dx12lib::IndexBuffer> DX12GeometryBackingStore::getIndexBuffer() const {
+	assert(_desc.isIndexStream);
+	return _pIndexBuffer;
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <dx12lib/dx12libStd.h>
+#include <dx12lib/Context/ContextStd.h>
+#include "GeometryArena.h"
+
+namespace d3d {
+
+// Keeps a CPU shadow copy of the stream and creates the GPU buffer on flush. dx12lib buffers are
+// immutable after creation, so the buffer only covers what was written up to the flush. MeshManager
+// seals a page once it was flushed and never writes into it again, every byte is uploaded once
+class DX12GeometryBackingStore : public CpuGeometryBackingStore {
+public:
+	explicit DX12GeometryBackingStore(const GeometryStreamDesc &desc);
+	void resize(size_t sizeInByte) override;
+	void write(size_t offsetInByte, const void *pData, size_t sizeInByte) override;
+	void move(size_t dstOffsetInByte, size_t srcOffsetInByte, size_t sizeInByte) override;
+	bool flush(dx12lib::IDirectContext &directCtx);
+	// drops the GPU buffer, the next writes start a new one
+	void release();
+	bool isDirty() const;
+	size_t getUploadedBytes() const;
+	std::shared_ptr<dx12lib::VertexBuffer> getVertexBuffer() const;
+	std::shared_ptr<dx12lib::IndexBuffer> getIndexBuffer() const;
+private:
+	GeometryStreamDesc _desc;
+	bool _dirty = false;
+	size_t _writtenEnd = 0;			// bytes, end of the highest write
+	size_t _uploadedBytes = 0;
+	std::shared_ptr<dx12lib::VertexBuffer> _pVertexBuffer;
+	std::shared_ptr<dx12lib::IndexBuffer> _pIndexBuffer;
+};
+
+}
@@ -0,0 +1,133 @@
+#include "IndexNarrowing.h"
+#include <cassert>
+#include <algorithm>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE4_1__)
+	#define D3D_INDEX_NARROWING_SSE4 1
+	#include <smmintrin.h>
+#else
+	#define D3D_INDEX_NARROWING_SSE4 0
+#endif
+
+namespace d3d {
+
+IndexRange calcIndexRange(const std::uint32_t *pIndices, size_t count) {
+	if (count == 0)
+		return {};
+
+	std::uint32_t minValue = std::numeric_limits<std::uint32_t>::max();
+	std::uint32_t maxValue = 0;
+	size_t i = 0;
+#if D3D_INDEX_NARROWING_SSE4
+	if (count >= 8) {
+		__m128i vMin0 = _mm_set1_epi32(-1);
+		__m128i vMin1 = vMin0;
+		__m128i vMax0 = _mm_setzero_si128();
+		__m128i vMax1 = vMax0;
+		for (; i + 8 <= count; i += 8) {
+			__m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIndices + i + 0));
+			__m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIndices + i + 4));
+			vMin0 = _mm_min_epu32(vMin0, v0);
+			vMin1 = _mm_min_epu32(vMin1, v1);
+			vMax0 = _mm_max_epu32(vMax0, v0);
+			vMax1 = _mm_max_epu32(vMax1, v1);
+		}
+		__m128i vMin = _mm_min_epu32(vMin0, vMin1);
+		__m128i vMax = _mm_max_epu32(vMax0, vMax1);
+		vMin = _mm_min_epu32(vMin, _mm_shuffle_epi32(vMin, _MM_SHUFFLE(1, 0, 3, 2)));
+		vMin = _mm_min_epu32(vMin, _mm_shuffle_epi32(vMin, _MM_SHUFFLE(2, 3, 0, 1)));
+		vMax = _mm_max_epu32(vMax, _mm_shuffle_epi32(vMax, _MM_SHUFFLE(1, 0, 3, 2)));
+		vMax = _mm_max_epu32(vMax, _mm_shuffle_epi32(vMax, _MM_SHUFFLE(2, 3, 0, 1)));
+		minValue = static_cast<std::uint32_t>(_mm_cvtsi128_si32(vMin));
+		maxValue = static_cast<std::uint32_t>(_mm_cvtsi128_si32(vMax));
+	}
+#endif
+	for (; i < count; ++i) {
+		minValue = std::min(minValue, pIndices[i]);
+		maxValue = std::max(maxValue, pIndices[i]);
+	}
+	return IndexRange{ minValue, maxValue };
+}
+
+bool narrowIndexToUint16(const std::uint32_t *pSrc, size_t count, std::uint32_t base, std::uint16_t *pDst) {
+	if (count == 0)
+		return true;
+
+	IndexRange range = calcIndexRange(pSrc, count);
+	if (range.min < base || range.max - base > std::numeric_limits<std::uint16_t>::max())
+		return false;
+
+	size_t i = 0;
+#if D3D_INDEX_NARROWING_SSE4
+	// packus saturates as signed 32-bit, the range check above keeps every value in [0, 65535]
+	__m128i vBase = _mm_set1_epi32(static_cast<int>(base));
+	for (; i + 8 <= count; i += 8) {
+		__m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + i + 0));
+		__m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + i + 4));
+		v0 = _mm_sub_epi32(v0, vBase);
+		v1 = _mm_sub_epi32(v1, vBase);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + i), _mm_packus_epi32(v0, v1));
+	}
+#endif
+	for (; i < count; ++i)
+		pDst[i] = static_cast<std::uint16_t>(pSrc[i] - base);
+	return true;
+}
+
+std::vector<IndexPartition> partitionIndexToUint16(const std::uint32_t *pIndices, size_t count, size_t primitiveSize) {
+	std::vector<IndexPartition> partitions;
+	if (count == 0)
+		return partitions;
+
+	// fast path, the whole mesh is addressable after rebasing
+	IndexRange range = calcIndexRange(pIndices, count);
+	if (range.fitsUint16()) {
+		partitions.push_back(IndexPartition{ 0, count, range.min });
+		return partitions;
+	}
+
+	assert(primitiveSize > 0 && count % primitiveSize == 0);
+	IndexPartition curr;
+	IndexRange currRange = { std::numeric_limits<std::uint32_t>::max(), 0 };
+	for (size_t i = 0; i < count; i += primitiveSize) {
+		IndexRange primRange = calcIndexRange(pIndices + i, primitiveSize);
+		IndexRange merged = {
+			std::min(currRange.min, primRange.min),
+			std::max(currRange.max, primRange.max),
+		};
+		if (curr.indexCount > 0 && !merged.fitsUint16()) {
+			curr.baseVertexLocation = currRange.min;
+			partitions.push_back(curr);
+			curr.startIndexLocation = i;
+			curr.indexCount = 0;
+			merged = primRange;
+		}
+		assert(merged.fitsUint16() && "a single primitive spans more than 65536 vertices");
+		currRange = merged;
+		curr.indexCount += primitiveSize;
+	}
+	curr.baseVertexLocation = currRange.min;
+	partitions.push_back(curr);
+	return partitions;
+}
+
+std::vector<std::uint16_t> buildUint16Indices(const std::uint32_t *pIndices,
+	size_t count,
+	std::vector<IndexPartition> &partitions,
+	size_t primitiveSize)
+{
+	partitions = partitionIndexToUint16(pIndices, count, primitiveSize);
+	std::vector<std::uint16_t> result(count);
+	for (const IndexPartition &partition : partitions) {
+		[[maybe_unused]] bool narrowed = narrowIndexToUint16(pIndices + partition.startIndexLocation,
+			partition.indexCount,
+			partition.baseVertexLocation,
+			result.data() + partition.startIndexLocation
+		);
+		assert(narrowed);
+	}
+	return result;
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace d3d {
+
+struct IndexRange {
+	std::uint32_t min = 0;
+	std::uint32_t max = 0;
+public:
+	size_t span() const { return static_cast<size_t>(max) - min + 1; }
+	bool fitsUint16() const { return span() <= kUint16IndexSpan; }
+	constexpr static size_t kUint16IndexSpan = 0x10000;
+};
+
+// One 16-bit addressable piece of a mesh. Indices inside the piece are rebased
+// so that index + baseVertexLocation is the original 32-bit index
+struct IndexPartition {
+	size_t		  startIndexLocation = 0;
+	size_t		  indexCount		 = 0;
+	std::uint32_t baseVertexLocation = 0;
+};
+
+// min/max of all indices in one pass, SSE4.1 when available
+IndexRange calcIndexRange(const std::uint32_t *pIndices, size_t count);
+
+// pDst[i] = pSrc[i] - base. The range is checked first, nothing is written and false is
+// returned when a value falls outside [base, base + 65535]
+bool narrowIndexToUint16(const std::uint32_t *pSrc, size_t count, std::uint32_t base, std::uint16_t *pDst);
+
+// Split a primitive list into pieces whose index span is at most 65536.
+// Primitives are never split, the input order is kept
+std::vector<IndexPartition> partitionIndexToUint16(const std::uint32_t *pIndices, size_t count, size_t primitiveSize = 3);
+
+// partition + rebase + narrow, the result is laid out in partition order
+std::vector<std::uint16_t> buildUint16Indices(const std::uint32_t *pIndices,
+	size_t count,
+	std::vector<IndexPartition> &partitions,
+	size_t primitiveSize = 3
+);
+
+}
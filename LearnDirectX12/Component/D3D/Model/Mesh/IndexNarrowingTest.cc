@@ -0,0 +1,53 @@
+#include <iostream>
+#include <vector>
+#include "TestCheck.h"
+#include "D3D/Model/Mesh/IndexNarrowing.h"
+
+using namespace d3d;
+
+void indexNarrowingTest() {
+	std::vector<std::uint32_t> indices = { 70000, 70001, 70002, 70002, 70003, 70000, 70010, 70004, 70001 };
+	IndexRange range = calcIndexRange(indices.data(), indices.size());
+	TEST_CHECK(range.min == 70000 && range.max == 70010 && range.fitsUint16());
+
+	std::vector<IndexPartition> partitions;
+	std::vector<std::uint16_t> narrowed = buildUint16Indices(indices.data(), indices.size(), partitions);
+	TEST_CHECK(partitions.size() == 1 && partitions[0].baseVertexLocation == 70000);
+	for (size_t i = 0; i < indices.size(); ++i)
+		TEST_CHECK(narrowed[i] + partitions[0].baseVertexLocation == indices[i]);
+
+	// a grid-like mesh with 200k vertices must be split into several 16-bit submeshes
+	std::vector<std::uint32_t> bigIndices;
+	for (std::uint32_t v = 0; v + 2 < 200000; ++v) {
+		bigIndices.push_back(v);
+		bigIndices.push_back(v + 1);
+		bigIndices.push_back(v + 2);
+	}
+	narrowed = buildUint16Indices(bigIndices.data(), bigIndices.size(), partitions);
+	TEST_CHECK(partitions.size() > 1);
+	size_t totalCount = 0;
+	for (const IndexPartition &partition : partitions) {
+		IndexRange partRange = calcIndexRange(bigIndices.data() + partition.startIndexLocation, partition.indexCount);
+		TEST_CHECK(partRange.fitsUint16() && partRange.min == partition.baseVertexLocation);
+		for (size_t i = 0; i < partition.indexCount; ++i) {
+			size_t idx = partition.startIndexLocation + i;
+			TEST_CHECK(narrowed[idx] + partition.baseVertexLocation == bigIndices[idx]);
+		}
+		totalCount += partition.indexCount;
+	}
+	TEST_CHECK(totalCount == bigIndices.size());
+
+	// out of range values are rejected before anything is narrowed, including the SIMD body
+	std::vector<std::uint16_t> untouched(bigIndices.size(), 0xabcd);
+	TEST_CHECK(!narrowIndexToUint16(bigIndices.data(), bigIndices.size(), 0, untouched.data()));
+	TEST_CHECK(!narrowIndexToUint16(indices.data(), indices.size(), 70001, untouched.data()));
+	TEST_CHECK(untouched[0] == 0xabcd && untouched[8] == 0xabcd);
+	TEST_CHECK(narrowIndexToUint16(indices.data(), indices.size(), 70000, untouched.data()));
+	TEST_CHECK(untouched[6] == 10);
+	std::cout << "index partitions: " << partitions.size() << std::endl;
+}
+
+int main() {
+	indexNarrowingTest();
+	return 0;
+}
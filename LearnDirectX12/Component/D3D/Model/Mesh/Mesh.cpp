@@ -41,7 +41,7 @@ Mesh::Mesh(std::shared_ptr<dx12lib::VertexBuffer> pVertexBuffer,
 : _pVertexBuffer(pVertexBuffer), _pIndexBuffer(pIndexBuffer), _subMeshs(subMeshs), _bounds(bounds)
 {
 	if (subMeshs.empty())
-		_subMeshs.push_back(getSubMesh());
+		_subMeshs.push_back(makeAllSubMesh());
 }
 
 void Mesh::appendSubMesh(const SubMesh &subMesh) {
@@ -81,18 +81,20 @@ void Mesh::drawIndexedInstanced(dx12lib::GraphicsContextProxy pGraphicsCtx,
 		subMesh.drawIndexedInstanced(pGraphicsCtx, instanceCount, startInstanceLocation);
 }
 
-SubMesh Mesh::getSubMesh(const std::string &name) const {
-	SubMesh res;
+std::vector<SubMesh> Mesh::getSubMesh(const std::string &name) const {
+	std::vector<SubMesh> res;
 	for (const auto &submesh : *this) {
-		if (submesh.name == name) {
-			res = submesh;
-			break;
-		}
+		if (submesh.name == name)
+			res.push_back(submesh);
 	}
 	return res;
 }
 
-SubMesh Mesh::getSubMesh() const {
+const std::vector<SubMesh> &Mesh::getSubMesh() const {
+	return _subMeshs;
+}
+
+SubMesh Mesh::makeAllSubMesh() const {
 	assert(_pVertexBuffer != nullptr || _pIndexBuffer != nullptr);
 	SubMesh subMesh;
 	subMesh.name = "MeshAllSubMesh";
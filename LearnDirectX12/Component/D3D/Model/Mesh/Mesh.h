@@ -4,9 +4,11 @@
 #include <d3d12.h>
 #include <cassert>
 #include <type_traits>
+#include <limits>
 #include <string>
 #include <unordered_map>
 #include "Geometry/GeometryGenerator.h"
+#include "D3D/Model/Mesh/IndexNarrowing.h"
 #include <dx12lib/Context/ContextProxy.hpp>
 #include <DirectXCollision.h>
 
@@ -66,10 +68,13 @@ public:
 		size_t startInstanceLocation = 0
 	) const;
 
-	SubMesh getSubMesh(const std::string &name) const;
-	SubMesh getSubMesh() const;
+	// a 16-bit mesh may be split into several partitions under one name, all of them are returned
+	std::vector<SubMesh> getSubMesh(const std::string &name) const;
+	const std::vector<SubMesh> &getSubMesh() const;
 
 	const DX::BoundingBox &getBounds() const;
+private:
+	SubMesh makeAllSubMesh() const;
 };
 
 enum class MeshIndexType {
@@ -124,9 +129,15 @@ struct MakeMeshHelper {
 			break;
 		}
 		case d3d::MeshIndexType::UINT16: {
-			std::vector<std::uint16_t> indices;
-			indices.reserve(mesh.indices.size());
-			indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+			std::vector<std::uint16_t> indices(mesh.indices.size());
+			if (!narrowIndexToUint16(mesh.indices.data(), mesh.indices.size(), 0, indices.data())) {
+				// build() splits these into partitions, a direct caller gets 32-bit indices instead
+				return pGrahpicsCtx->createIndexBuffer(
+					mesh.indices.data(),
+					mesh.indices.size(),
+					DXGI_FORMAT_R32_UINT
+				);
+			}
 			return pGrahpicsCtx->createIndexBuffer(
 				indices.data(),
 				indices.size(),
@@ -160,15 +171,34 @@ struct MakeMeshHelper {
 
 		assert(count != -1);
 		auto pVertexBuffer = buildVertexBuffer(pGrahpicsCtx, mesh);
-		auto pIndexBuffer = buildIndexBuffer(pGrahpicsCtx, mesh);
 
 		const auto *pVertex = mesh.vertices.data();
 		DX::BoundingBox bounds;
 		DX::BoundingBox::CreateFromPoints(bounds, mesh.vertices.size(), &pVertex->position, sizeof(com::Vertex));
 
 		std::vector<SubMesh> submeshs;
-		if (!name.empty())
-			submeshs.emplace_back(name, count, static_cast<std::uint32_t>(0), static_cast<std::uint32_t>(0));
+		std::shared_ptr<dx12lib::IndexBuffer> pIndexBuffer;
+		IndexRange indexRange = calcIndexRange(mesh.indices.data(), mesh.indices.size());
+		if (IndexType == MeshIndexType::UINT16 && indexRange.max > std::numeric_limits<std::uint16_t>::max()) {
+			// rebase and split into 16-bit addressable partitions instead of truncating the indices,
+			// every partition keeps the submesh name so getSubMesh(name) finds all of them
+			std::vector<IndexPartition> partitions;
+			auto indices = buildUint16Indices(mesh.indices.data(), mesh.indices.size(), partitions);
+			pIndexBuffer = pGrahpicsCtx->createIndexBuffer(indices.data(), indices.size(), DXGI_FORMAT_R16_UINT);
+			std::string subMeshName = name.empty() ? "MeshAllSubMesh" : name;
+			for (const IndexPartition &partition : partitions) {
+				submeshs.emplace_back(
+					subMeshName,
+					partition.indexCount, 
+					partition.startIndexLocation, 
+					static_cast<std::size_t>(partition.baseVertexLocation)
+				);
+			}
+		} else {
+			pIndexBuffer = buildIndexBuffer(pGrahpicsCtx, mesh);
+			if (!name.empty())
+				submeshs.emplace_back(name, count, static_cast<std::uint32_t>(0), static_cast<std::uint32_t>(0));
+		}
 
 		return std::make_shared<Mesh>(
 			pVertexBuffer,
@@ -195,11 +225,27 @@ struct MakeUnionMeshHelper {
 		SubMesh subMesh = {
 			name,
 			count,
-			static_cast<UINT>(_indices.size()),
+			static_cast<UINT>(_useWideIndices ? _wideIndices.size() : _indices.size()),
 			static_cast<UINT>(_vertices.size()),
 		};
 		_vertices.insert(_vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
-		_indices.insert(_indices.end(), mesh.indices.begin(), mesh.indices.end());
+		if constexpr (std::is_same_v<index_t, std::uint16_t>) {
+			if (!_useWideIndices) {
+				size_t offset = _indices.size();
+				_indices.resize(offset + mesh.indices.size());
+				if (!narrowIndexToUint16(mesh.indices.data(), mesh.indices.size(), 0, _indices.data() + offset)) {
+					// this submesh needs more than 16-bit indices, the whole union falls back to R32_UINT
+					_indices.resize(offset);
+					_wideIndices.assign(_indices.begin(), _indices.end());
+					_indices.clear();
+					_useWideIndices = true;
+				}
+			}
+			if (_useWideIndices)
+				_wideIndices.insert(_wideIndices.end(), mesh.indices.begin(), mesh.indices.end());
+		} else {
+			_indices.insert(_indices.end(), mesh.indices.begin(), mesh.indices.end());
+		}
 
 		const auto *pVertex = mesh.vertices.data();
 		DX::BoundingBox submeshBounds;
@@ -216,19 +262,30 @@ struct MakeUnionMeshHelper {
 			_vertices.size(),
 			sizeof(T)
 		);
-		auto pIndexBuffer = pGrahpicsCtx->createIndexBuffer(
-			_indices.data(),
-			_indices.size(),
-			reinterpret_cast<DXGI_FORMAT>(IndexType)
-		);
+		std::shared_ptr<dx12lib::IndexBuffer> pIndexBuffer;
+		if (_useWideIndices) {
+			pIndexBuffer = pGrahpicsCtx->createIndexBuffer(
+				_wideIndices.data(),
+				_wideIndices.size(),
+				DXGI_FORMAT_R32_UINT
+			);
+		} else {
+			pIndexBuffer = pGrahpicsCtx->createIndexBuffer(
+				_indices.data(),
+				_indices.size(),
+				static_cast<DXGI_FORMAT>(IndexType)
+			);
+		}
 
 		std::vector<SubMesh> submesh;
 		submesh.reserve(_subMeshs.size());
-		submesh.insert(_subMeshs.begin(), _subMeshs.end());
+		for (const auto &[name, subMesh] : _subMeshs)
+			submesh.push_back(subMesh);
 
 		return std::make_shared<Mesh>(
 			pVertexBuffer,
 			pIndexBuffer,
+			_bounds,
 			submesh
 		);
 	}
@@ -236,6 +293,8 @@ private:
 	using index_t = MeshIndexTypeToIntegerType_t<IndexType>;
 	std::vector<T> _vertices;
 	std::vector<index_t> _indices;
+	std::vector<std::uint32_t> _wideIndices;		// replaces _indices once a submesh overflows 16 bits
+	bool _useWideIndices = false;
 	std::unordered_map<std::string, SubMesh> _subMeshs;
 	DX::BoundingBox _bounds;
 };
@@ -1,27 +1,236 @@
 #include "MeshManager.h"
+#include <format>
+#include <algorithm>
+#include "D3D/Model/Mesh/GeometryBackingStore.h"
+#include "D3D/Model/Mesh/IndexNarrowing.h"
 
 namespace d3d {
 
-std::shared_ptr<dx12lib::VertexBuffer> MeshManager::getVertexBuffer(const std::string &key) const {
-	auto iter = _vertexBufferCache.find(key);
-	if (iter != _vertexBufferCache.end())
-		return iter->second.lock();
-	return nullptr;
+static size_t getFormatStride(DXGI_FORMAT format) {
+	switch (format) {
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return sizeof(float) * 4;
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+		return sizeof(float) * 3;
+	case DXGI_FORMAT_R32G32_FLOAT:
+		return sizeof(float) * 2;
+	default:
+		assert(false && "unsupported geometry stream format");
+		return 0;
+	}
 }
 
-std::shared_ptr<dx12lib::IndexBuffer> MeshManager::getIndexBuffer(const std::string &key) const {
-	auto iter = _indexBufferCache.find(key);
-	if (iter != _indexBufferCache.end())
+static size_t getSemanticIndex(const VertexDataSemantic &semantic) {
+	for (size_t i = 0; i < kNumVertexSemantic; ++i) {
+		if (SemanticList[i] == semantic)
+			return i;
+	}
+	assert(false && "semantic has no geometry stream");
+	return kNumVertexSemantic;
+}
+
+template<typename Func>
+void MeshManager::forEachStream(const GeometryPage &page, Func &&func) const {
+	for (size_t stream : page.vertexStreams) {
+		if (stream != GeometryArena::kInvalidStream)
+			func(static_cast<DX12GeometryBackingStore *>(_pGeometryArena->getStore(stream)));
+	}
+	for (size_t stream : { page.index16Stream, page.index32Stream }) {
+		if (stream != GeometryArena::kInvalidStream)
+			func(static_cast<DX12GeometryBackingStore *>(_pGeometryArena->getStore(stream)));
+	}
+}
+
+std::shared_ptr<const MeshAllocation> MeshManager::getMeshAllocation(const std::string &key) const {
+	auto iter = _meshCache.find(key);
+	if (iter != _meshCache.end())
 		return iter->second.lock();
 	return nullptr;
 }
 
-void MeshManager::cacheVertexBuffer(const std::string &key, std::weak_ptr<dx12lib::VertexBuffer> pVertexBuffer) {
-	_vertexBufferCache[key] = std::move(pVertexBuffer);
+std::shared_ptr<const MeshAllocation> MeshManager::allocateMesh(const std::string &key,
+	size_t vertexCount,
+	const VertexSemanticData &semanticData,
+	const std::vector<std::uint32_t> &indices)
+{
+	assert(getMeshAllocation(key) == nullptr);
+	auto *pAllocation = new MeshAllocation(allocateMesh(vertexCount, semanticData, indices));
+	std::shared_ptr<const MeshAllocation> pResult(pAllocation, [](MeshAllocation *pAllocation) {
+		if (MeshManager *pMeshManager = MeshManager::instance())
+			pMeshManager->freeMesh(*pAllocation);
+		delete pAllocation;
+	});
+	_meshCache[key] = pResult;
+	return pResult;
+}
+
+std::shared_ptr<dx12lib::VertexBuffer> MeshManager::getArenaVertexBuffer(const MeshAllocation &allocation,
+	const VertexDataSemantic &semantic) const
+{
+	assert(allocation.page < _pages.size());
+	size_t semanticIdx = getSemanticIndex(semantic);
+	if (semanticIdx >= kNumVertexSemantic || !allocation.semantics.test(semanticIdx))
+		return nullptr;
+
+	size_t stream = _pages[allocation.page].vertexStreams[semanticIdx];
+	auto *pStore = static_cast<DX12GeometryBackingStore *>(_pGeometryArena->getStore(stream));
+	assert(!pStore->isDirty() && "call flushGeometryArena first");
+	return pStore->getVertexBuffer();
+}
+
+std::shared_ptr<dx12lib::IndexBuffer> MeshManager::getArenaIndexBuffer(const MeshAllocation &allocation) const {
+	assert(allocation.page < _pages.size());
+	if (!allocation.indexRange)
+		return nullptr;
+
+	auto *pStore = static_cast<DX12GeometryBackingStore *>(_pGeometryArena->getStore(allocation.indexRange.stream));
+	assert(!pStore->isDirty() && "call flushGeometryArena first");
+	return pStore->getIndexBuffer();
+}
+
+void MeshManager::flushGeometryArena(dx12lib::IDirectContext &directCtx) {
+	if (_pGeometryArena == nullptr)
+		return;
+
+	// each page is uploaded once, later meshes go to a page that is still open
+	bool flushed = false;
+	for (GeometryPage &page : _pages) {
+		if (page.sealed || page.numMeshes == 0)
+			continue;
+		forEachStream(page, [&](DX12GeometryBackingStore *pStore) {
+			flushed |= pStore->flush(directCtx);
+		});
+		page.sealed = true;
+	}
+	if (flushed)
+		_pGeometryArena->beginFrame();
+}
+
+GeometryArena &MeshManager::getGeometryArena() {
+	// nothing is reserved until the first mesh is uploaded
+	if (_pGeometryArena == nullptr) {
+		_pGeometryArena = std::make_unique<GeometryArena>([](const GeometryStreamDesc &desc) {
+			return std::make_unique<DX12GeometryBackingStore>(desc);
+		});
+	}
+	return *_pGeometryArena;
+}
+
+MeshAllocation MeshManager::allocateMesh(size_t vertexCount,
+	const VertexSemanticData &semanticData,
+	const std::vector<std::uint32_t> &indices)
+{
+	assert(vertexCount > 0);
+	size_t positionIdx = getSemanticIndex(PositionSemantic);
+	assert(semanticData[positionIdx] != nullptr);
+
+	GeometryArena &arena = getGeometryArena();
+	MeshAllocation allocation;
+	for (size_t pageIdx = 0; ; ++pageIdx) {
+		if (pageIdx == _pages.size())
+			createPage(std::max(kVertexPageCapacity, vertexCount));
+		if (_pages[pageIdx].sealed)
+			continue;
+
+		size_t positionStream = getVertexStream(pageIdx, positionIdx);
+		allocation.vertexRange = arena.allocate(positionStream, semanticData[positionIdx], vertexCount);
+		if (allocation.vertexRange) {
+			allocation.page = pageIdx;
+			break;
+		}
+	}
+
+	// the other semantics are written at the offsets of the position stream, absent ones are skipped
+	allocation.semantics.set(positionIdx);
+	for (size_t i = 0; i < kNumVertexSemantic; ++i) {
+		if (i == positionIdx || semanticData[i] == nullptr)
+			continue;
+		arena.write(getVertexStream(allocation.page, i), allocation.vertexRange.offset, semanticData[i], vertexCount);
+		allocation.semantics.set(i);
+	}
+	allocation.baseVertexLocation = allocation.vertexRange.offset;
+	allocation.vertexCount = vertexCount;
+	++_pages[allocation.page].numMeshes;
+
+	if (indices.size() < 3)
+		return allocation;
+
+	// the indices stay relative to the mesh, the draw adds baseVertexLocation
+	IndexRange indexRange = calcIndexRange(indices.data(), indices.size());
+	assert(indexRange.max < vertexCount);
+	std::vector<std::uint16_t> narrowIndices;
+	if (indexRange.fitsUint16()) {
+		narrowIndices.resize(indices.size());
+		if (!narrowIndexToUint16(indices.data(), indices.size(), indexRange.min, narrowIndices.data()))
+			narrowIndices.clear();
+	}
+
+	if (!narrowIndices.empty()) {
+		allocation.indexRange = arena.allocate(getIndexStream(allocation.page, sizeof(std::uint16_t)), narrowIndices);
+		allocation.baseVertexLocation += indexRange.min;
+	} else {
+		allocation.indexRange = arena.allocate(getIndexStream(allocation.page, sizeof(std::uint32_t)), indices);
+	}
+	assert(allocation.indexRange);
+	allocation.startIndexLocation = allocation.indexRange.offset;
+	allocation.indexCount = indices.size();
+	return allocation;
+}
+
+void MeshManager::freeMesh(MeshAllocation &allocation) {
+	if (!allocation)
+		return;
+
+	_pGeometryArena->free(allocation.vertexRange);
+	_pGeometryArena->free(allocation.indexRange);
+	GeometryPage &page = _pages[allocation.page];
+	assert(page.numMeshes > 0);
+	if (--page.numMeshes == 0)
+		releasePage(page);
+	allocation = MeshAllocation{};
+}
+
+void MeshManager::createPage(size_t capacity) {
+	GeometryPage page;
+	page.vertexStreams.fill(GeometryArena::kInvalidStream);
+	page.capacity = capacity;
+	_pages.push_back(page);
+}
+
+size_t MeshManager::getVertexStream(size_t pageIdx, size_t semanticIdx) {
+	GeometryPage &page = _pages[pageIdx];
+	size_t &stream = page.vertexStreams[semanticIdx];
+	if (stream == GeometryArena::kInvalidStream) {
+		GeometryStreamDesc desc;
+		desc.name = std::format("{}{}#{}", SemanticList[semanticIdx].name, SemanticList[semanticIdx].index, pageIdx);
+		desc.stride = getFormatStride(SemanticList[semanticIdx].format);
+		desc.initCapacity = page.capacity;
+		desc.growable = false;
+		stream = getGeometryArena().createStream(desc);
+	}
+	return stream;
+}
+
+size_t MeshManager::getIndexStream(size_t pageIdx, size_t stride) {
+	GeometryPage &page = _pages[pageIdx];
+	size_t &stream = (stride == sizeof(std::uint16_t)) ? page.index16Stream : page.index32Stream;
+	if (stream == GeometryArena::kInvalidStream) {
+		GeometryStreamDesc desc;
+		desc.name = std::format("Index{}#{}", stride * 8, pageIdx);
+		desc.stride = stride;
+		desc.initCapacity = kIndexPageCapacity;
+		desc.isIndexStream = true;
+		stream = getGeometryArena().createStream(desc);
+	}
+	return stream;
 }
 
-void MeshManager::cacheIndexBuffer(const std::string &key, std::weak_ptr<dx12lib::IndexBuffer> pIndexBuffer) {
-	_indexBufferCache[key] = std::move(pIndexBuffer);
+void MeshManager::releasePage(GeometryPage &page) {
+	// the last mesh is gone, the page is written and uploaded from the start again
+	forEachStream(page, [](DX12GeometryBackingStore *pStore) {
+		pStore->release();
+	});
+	page.sealed = false;
 }
 
 }
@@ -1,21 +1,73 @@
 #pragma once
+#include <array>
+#include <bitset>
 #include <string>
 #include <unordered_map>
 #include <Singleton/Singleton.hpp>
 #include <Dx12lib/Buffer/VertexBuffer.h>
 #include <Dx12lib/Buffer/IndexBuffer.h>
+#include "D3D/Model/Mesh/GeometryArena.h"
+#include "D3D/Model/RenderItem/VertexDataSemantic.h"
 
 namespace d3d {
 
+constexpr size_t kNumVertexSemantic = std::size(SemanticList);
+using VertexSemanticData = std::array<const void *, kNumVertexSemantic>;
+
+// One mesh inside a geometry page. The vertex streams of a page share the offsets of its position
+// stream, a semantic the mesh has no data for is never written. The indices are relative to
+// baseVertexLocation and sit in the 16 bit index stream of the page whenever they fit
+struct MeshAllocation {
+	size_t		  page				 = -1;
+	size_t		  baseVertexLocation = 0;
+	size_t		  vertexCount		 = 0;
+	size_t		  startIndexLocation = 0;
+	size_t		  indexCount		 = 0;
+	GeometryRange vertexRange;
+	GeometryRange indexRange;
+	std::bitset<kNumVertexSemantic> semantics;
+public:
+	explicit operator bool() const { return page != static_cast<size_t>(-1); }
+};
+
 class MeshManager : public com::Singleton<MeshManager> {
 public:
-	std::shared_ptr<dx12lib::VertexBuffer> getVertexBuffer(const std::string &key) const;
-	std::shared_ptr<dx12lib::IndexBuffer> getIndexBuffer(const std::string &key) const;
-	void cacheVertexBuffer(const std::string &key, std::weak_ptr<dx12lib::VertexBuffer> pVertexBuffer);
-	void cacheIndexBuffer(const std::string &key, std::weak_ptr<dx12lib::IndexBuffer> pIndexBuffer);
+	// the geometry is shared by key and goes back to the arena with the last user
+	std::shared_ptr<const MeshAllocation> getMeshAllocation(const std::string &key) const;
+	std::shared_ptr<const MeshAllocation> allocateMesh(const std::string &key, 
+		size_t vertexCount, 
+		const VertexSemanticData &semanticData,
+		const std::vector<std::uint32_t> &indices
+	);
+	std::shared_ptr<dx12lib::VertexBuffer> getArenaVertexBuffer(const MeshAllocation &allocation, const VertexDataSemantic &semantic) const;
+	std::shared_ptr<dx12lib::IndexBuffer> getArenaIndexBuffer(const MeshAllocation &allocation) const;
+	// uploads the pages written since the last flush and seals them
+	void flushGeometryArena(dx12lib::IDirectContext &directCtx);
+	GeometryArena &getGeometryArena();
+private:
+	struct GeometryPage {
+		std::array<size_t, kNumVertexSemantic> vertexStreams;		// created by the first mesh with the semantic
+		size_t index16Stream = GeometryArena::kInvalidStream;
+		size_t index32Stream = GeometryArena::kInvalidStream;
+		size_t capacity		 = 0;
+		size_t numMeshes	 = 0;
+		bool   sealed		 = false;		// uploaded, nothing is written into it until it is empty again
+	};
+
+	MeshAllocation allocateMesh(size_t vertexCount, const VertexSemanticData &semanticData, const std::vector<std::uint32_t> &indices);
+	void freeMesh(MeshAllocation &allocation);
+	void createPage(size_t capacity);
+	size_t getVertexStream(size_t pageIdx, size_t semanticIdx);
+	size_t getIndexStream(size_t pageIdx, size_t stride);
+	void releasePage(GeometryPage &page);
+	template<typename Func>
+	void forEachStream(const GeometryPage &page, Func &&func) const;
 private:
-	std::unordered_map<std::string, std::weak_ptr<dx12lib::VertexBuffer>> _vertexBufferCache;
-	std::unordered_map<std::string, std::weak_ptr<dx12lib::IndexBuffer>> _indexBufferCache;
+	std::unordered_map<std::string, std::weak_ptr<const MeshAllocation>> _meshCache;
+	std::unique_ptr<GeometryArena> _pGeometryArena;
+	std::vector<GeometryPage> _pages;
+	constexpr static size_t kVertexPageCapacity = 1024 * 64;
+	constexpr static size_t kIndexPageCapacity = kVertexPageCapacity * 3;
 };
 
 }
@@ -7,28 +7,89 @@ using namespace Math;
 
 MeshModel::MeshModel(dx12lib::IDirectContext &directCtx, std::shared_ptr<ALTree> pALTree)
 : _modelTransform(float4x4::identity())
-, _pRootNode(std::make_unique<MeshNode>(directCtx, pALTree->getRootNode()))
+, _pRootNode(std::make_unique<MeshNode>(directCtx, pALTree->getRootNode(), _transforms))
 {
 	_pALTree = std::move(pALTree);
+	_pRootNode->collectNodes(_transformNodes);
+	// the bounds nodes of the render items have no MeshNode
+	_transformNodes.resize(_transforms.size(), nullptr);
+	for (MeshNode *pNode : _transformNodes) {
+		if (pNode == nullptr || pNode->getNodeTransformCBuffer() == nullptr)
+			continue;
+		pNode->setTransformSlot(_transformStaging.addSlot<rgph::TransformStore>());
+		_stagedNodes.push_back(pNode);
+		for (size_t i = 0; i < pNode->getNumRenderItem(); ++i) {
+			_itemTransforms.push_back(pNode->getItemTransform(i));
+			_renderItems.push_back(pNode->getRenderItem(i));
+		}
+	}
 }
 
 MeshModel::~MeshModel() = default;
 
-void MeshModel::submit(const IBounding &bounding, const rgph::TechniqueFlag &techniqueFlag) const {
-	if (_modelTransformDirty) {
-		_pRootNode->setParentTransform(Matrix4(_modelTransform));
-		_modelTransformDirty = false;
+void MeshModel::updateTransforms() {
+	_uploads.clear();
+	updateTransforms(_uploads);
+	uploadTransforms(_uploads);
+}
+
+void MeshModel::updateTransforms(std::vector<MeshTransformUpload> &uploads) {
+	// only the subtrees below a changed transform are recomputed
+	_transforms.update();
+	for (size_t node : _transforms.getChangedNodes()) {
+		MeshNode *pNode = _transformNodes[node];
+		if (pNode == nullptr || pNode->getTransformSlot() == UploadStaging::kInvalidSlot)
+			continue;
+		uploads.push_back({
+			.node = node,
+			.store = {
+				.matWorld = _transforms.getWorldTransform(node),
+				.matNormal = _transforms.getNormalTransform(node),
+			},
+		});
 	}
+}
+
+void MeshModel::uploadTransforms(std::span<const MeshTransformUpload> uploads) {
+	for (const MeshTransformUpload &upload : uploads)
+		_transformNodes[upload.node]->applyWorldTransform(upload.store, _transformStaging);
+
+	// a node that moved back to where it was writes nothing, the constant buffer takes the whole store
+	_transformStaging.flush([&](size_t slot, size_t, size_t, const std::byte *) {
+		_stagedNodes[slot]->uploadTransform(_transformStaging.get<rgph::TransformStore>(slot));
+	});
+}
+
+void MeshModel::cullRenderItems(const IBounding &bounding, std::vector<RenderItem *> &items) const {
+	for (size_t i = 0; i < _itemTransforms.size(); ++i) {
+		const TransformAABB &bounds = _transforms.getWorldBounds(_itemTransforms[i]);
+		Vector3 center(bounds.center[0], bounds.center[1], bounds.center[2]);
+		Vector3 extents(bounds.extents[0], bounds.extents[1], bounds.extents[2]);
+		if (bounding.contains(BoundingBox(center - extents, center + extents)) != DX::ContainmentType::DISJOINT)
+			items.push_back(_renderItems[i]);
+	}
+}
+
+void MeshModel::submit(const IBounding &bounding, const rgph::TechniqueFlag &techniqueFlag) const {
 	_pRootNode->submit(bounding, techniqueFlag);
 }
 
+void MeshModel::collectWorldBounds(std::vector<TransformAABB> &bounds) const {
+	for (size_t node : _itemTransforms)
+		bounds.push_back(_transforms.getWorldBounds(node));
+}
+
+const UploadStagingStats &MeshModel::getTransformUploadStats() const {
+	return _transformStaging.getLastFrameStats();
+}
+
 INode * MeshModel::getRootNode() const {
 	return _pRootNode.get();
 }
 
 void MeshModel::setModelTransform(const float4x4 &matWorld) {
 	_modelTransform = matWorld;
-	_modelTransformDirty = true;
+	_pRootNode->setParentTransform(Matrix4(_modelTransform));
 }
 
 void MeshModel::createMaterial(rgph::RenderGraph &graph, 
@@ -38,5 +99,17 @@ void MeshModel::createMaterial(rgph::RenderGraph &graph,
 	_pRootNode->createMaterial(graph, directCtx, creator);
 }
 
+void MeshModel::requestTextureResidency(const IBounding &bounding, const TextureStreamingView &view) const {
+	_pRootNode->requestTextureResidency(bounding, view);
+}
+
+void MeshModel::rebuildMaterial(dx12lib::IDirectContext &directCtx, 
+	const MaterialCreator &creator, 
+	const std::vector<std::string> &textureNames)
+{
+	if (!textureNames.empty())
+		_pRootNode->rebuildMaterial(directCtx, creator, textureNames);
+}
+
 
 }
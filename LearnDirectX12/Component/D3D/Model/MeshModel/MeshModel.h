@@ -1,7 +1,12 @@
 #pragma once
+#include <span>
+#include <vector>
 #include "D3D/AssimpLoader/ALTree.h"
 #include "D3D/Model/IModel.hpp"
 #include "D3D/Model/RenderItem/RenderItem.h"
+#include "D3D/Model/Transform/TransformHierarchy.h"
+#include "D3D/UploadStaging/UploadStaging.h"
+#include "RenderGraph/Job/TransformCBufferPtr.h"
 
 namespace rgph {
 
@@ -13,10 +18,27 @@ class RenderGraph;
 namespace d3d {
 
 class MeshNode;
+
+// new world and normal matrix of a moved node, handed from the update to the render stage
+struct MeshTransformUpload {
+	size_t node;
+	rgph::TransformStore store;
+};
+
 class MeshModel : public IModel {
 public:
 	MeshModel(dx12lib::IDirectContext &directCtx, std::shared_ptr<ALTree> pALTree);
 	~MeshModel() override;
+	// once per frame before the submits, recomputes the moved subtrees and uploads their transforms
+	void updateTransforms();
+	// The same split over the frame pipeline stages. The update stage owns the hierarchy: it
+	// recomputes the moved subtrees and appends their matrices to uploads. The render stage owns the
+	// render items and the constant buffers: uploadTransforms moves the item bounds and uploads the
+	// changed rows
+	void updateTransforms(std::vector<MeshTransformUpload> &uploads);
+	void uploadTransforms(std::span<const MeshTransformUpload> uploads);
+	// render items whose world box in the hierarchy intersects bounding, safe in the update stage
+	void cullRenderItems(const IBounding &bounding, std::vector<RenderItem *> &items) const;
 	void submit(const IBounding &bounding, const rgph::TechniqueFlag &techniqueFlag) const override ;
 	INode *getRootNode() const override;
 	void setModelTransform(const Math::float4x4 &matWorld) override;
@@ -26,10 +48,27 @@ public:
 		dx12lib::IDirectContext &directCtx, 
 		const MaterialCreator &creator
 	);
+	// visible render items request the mips of their streamed textures
+	void requestTextureResidency(const IBounding &bounding, const TextureStreamingView &view) const;
+	// items using one of the textures get a new material, TextureManager::updateStreaming names them
+	void rebuildMaterial(dx12lib::IDirectContext &directCtx, 
+		const MaterialCreator &creator, 
+		const std::vector<std::string> &textureNames
+	);
+	// world boxes of the render items as of the last updateTransforms, e.g. the shadow casters
+	void collectWorldBounds(std::vector<TransformAABB> &bounds) const;
+	// node transform bytes of the last updateTransforms
+	const UploadStagingStats &getTransformUploadStats() const;
 private:
-	mutable bool _modelTransformDirty = true;
 	Math::float4x4 _modelTransform;
+	TransformHierarchy _transforms;
 	std::unique_ptr<MeshNode> _pRootNode;
+	std::vector<MeshNode *> _transformNodes;		// indexed by transform handle
+	std::vector<MeshNode *> _stagedNodes;			// indexed by staging slot, nodes with meshes only
+	std::vector<size_t> _itemTransforms;			// bounds node of every render item
+	std::vector<RenderItem *> _renderItems;
+	std::vector<MeshTransformUpload> _uploads;		// scratch of the single stage updateTransforms
+	UploadStaging _transformStaging { dx12lib::kFrameResourceCount, UploadStaging::kRowSize };
 	std::shared_ptr<ALTree> _pALTree;
 };
 
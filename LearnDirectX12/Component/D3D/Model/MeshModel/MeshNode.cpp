@@ -1,15 +1,44 @@
 #include "MeshNode.h"
+#include <algorithm>
+#include <limits>
 #include "D3D/AssimpLoader/ALNode.h"
 #include "D3D/Model/RenderItem/RenderItem.h"
 #include "D3D/AssimpLoader/ALMesh.h"
 #include "RenderGraph/Job/TransformCBufferPtr.h"
+#include "Profiler/Profiler.h"
 
 using namespace Math;
 namespace d3d {
 
-MeshNode::MeshNode(dx12lib::IDirectContext &directCtx, const ALNode *pALNode) {
-	_applyTransform = pALNode->getNodeTransform();
+TransformAABB MeshNode::calcMeshBounds(const ALMesh &mesh) {
+	TransformAABB bounds;
+	if (mesh.getPositions().empty())
+		return bounds;
+
+	float vMin[3] = { +std::numeric_limits<float>::max(), +std::numeric_limits<float>::max(), +std::numeric_limits<float>::max() };
+	float vMax[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+	for (const float4 &position : mesh.getPositions()) {
+		const float p[3] = { position.x, position.y, position.z };
+		for (size_t c = 0; c < 3; ++c) {
+			vMin[c] = std::min(vMin[c], p[c]);
+			vMax[c] = std::max(vMax[c], p[c]);
+		}
+	}
+	for (size_t c = 0; c < 3; ++c) {
+		bounds.center[c] = (vMin[c] + vMax[c]) * 0.5f;
+		bounds.extents[c] = (vMax[c] - vMin[c]) * 0.5f;
+	}
+	return bounds;
+}
+
+MeshNode::MeshNode(dx12lib::IDirectContext &directCtx, 
+	const ALNode *pALNode, 
+	TransformHierarchy &transforms, 
+	size_t parentTransform)
+: _pTransforms(&transforms)
+{
 	_nodeLocalTransform = pALNode->getNodeTransform();
+	_transformHandle = transforms.addNode(parentTransform, _nodeLocalTransform);
 
 	if (pALNode->getNumMesh() > 0)
 		_nodeTransformCBuffer.setTransformCBuffer(directCtx.createFRConstantBuffer<rgph::TransformStore>());
@@ -17,22 +46,18 @@ MeshNode::MeshNode(dx12lib::IDirectContext &directCtx, const ALNode *pALNode) {
 	for (size_t i = 0; i < pALNode->getNumMesh(); ++i) {
 		_alMeshes.push_back(pALNode->getMesh(i));
 		_renderItems.emplace_back(std::make_unique<RenderItem>(directCtx, this, i));
+		// a bounds only child per render item, the update stage culls with its world box
+		size_t itemTransform = transforms.addNode(_transformHandle);
+		transforms.setLocalBounds(itemTransform, calcMeshBounds(*_alMeshes.back()));
+		_itemTransforms.push_back(itemTransform);
 	}
 
 	for (size_t i = 0; i < pALNode->getNumChildren(); ++i)
-		_children.push_back(std::make_unique<MeshNode>(directCtx, pALNode->getChildren(i)));
+		_children.push_back(std::make_unique<MeshNode>(directCtx, pALNode->getChildren(i), transforms, _transformHandle));
 }
 
 void MeshNode::submit(const IBounding &bounding, const rgph::TechniqueFlag &techniqueFlag) const {
-	if (_transformDirty && _nodeTransformCBuffer != nullptr) {
-		rgph::TransformStore store {
-			.matWorld = _applyTransform,
-			.matNormal = float4x4(transpose(inverse(Matrix4(_applyTransform))))
-		};
-		_nodeTransformCBuffer.setTransformStore(store);
-		_transformDirty = false;
-	}
-
+	PROFILE_ZONE("MeshNode::submit");
 	for (auto &pRenderItem : _renderItems) {
 		const auto &worldAABB = pRenderItem->getWorldAABB();
 		if (bounding.contains(worldAABB) == DX::ContainmentType::DISJOINT)
@@ -57,15 +82,10 @@ RenderItem * MeshNode::getRenderItem(size_t idx) const {
 }
 
 void MeshNode::setParentTransform(const Matrix4 &matWorld) {
+	assert(_pTransforms->getParent(_transformHandle) == TransformHierarchy::kInvalidNode);
 	Matrix4 localTransform(_nodeLocalTransform);
-	Matrix4 applyTransform = localTransform * matWorld;
-	_applyTransform = float4x4(applyTransform);
-	_transformDirty = true;
-	for (auto &pChildren : _children)
-		pChildren->setParentTransform(applyTransform);
-
-	for (auto &pRenderItem : _renderItems)
-		pRenderItem->applyTransform(applyTransform);
+	float4x4 applyTransform = float4x4(localTransform * matWorld);
+	_pTransforms->setLocalTransform(_transformHandle, applyTransform);
 }
 
 const rgph::TransformCBufferPtr &MeshNode::getNodeTransformCBuffer() const {
@@ -86,10 +106,77 @@ void MeshNode::createMaterial(rgph::RenderGraph &graph,
 		const auto *pALMaterial = _alMeshes[idx]->getMaterial();
 		pRenderItem->setMaterial(creator(pALMaterial));
 		pRenderItem->rebuildTechniqueFromMaterial(directCtx);
+		if (pALMaterial != nullptr) {
+			pRenderItem->addStreamingTexture(pALMaterial->getDiffuseMap().path);
+			pRenderItem->addStreamingTexture(pALMaterial->getNormalMap().path);
+			pRenderItem->addStreamingTexture(pALMaterial->getMetallicMap().path);
+			pRenderItem->addStreamingTexture(pALMaterial->getSmoothnessMap().path);
+			pRenderItem->addStreamingTexture(pALMaterial->getAmbientOcclusionMap().path);
+		}
 		++idx;
 	}
 	for (auto &pChild : _children)
 		pChild->createMaterial(graph, directCtx, creator);
 }
 
+void MeshNode::requestTextureResidency(const IBounding &bounding, const TextureStreamingView &view) const {
+	for (auto &pRenderItem : _renderItems) {
+		if (bounding.contains(pRenderItem->getWorldAABB()) == DX::ContainmentType::DISJOINT)
+			continue;
+		pRenderItem->requestTextureResidency(view);
+	}
+	for (auto &pChild : _children)
+		pChild->requestTextureResidency(bounding, view);
+}
+
+void MeshNode::rebuildMaterial(dx12lib::IDirectContext &directCtx, 
+	const MeshModel::MaterialCreator &creator, 
+	const std::vector<std::string> &textureNames)
+{
+	for (size_t idx = 0; idx < _renderItems.size(); ++idx) {
+		auto &pRenderItem = _renderItems[idx];
+		if (!pRenderItem->usesStreamingTexture(textureNames))
+			continue;
+		pRenderItem->setMaterial(creator(_alMeshes[idx]->getMaterial()));
+		pRenderItem->rebuildTechniqueFromMaterial(directCtx);
+	}
+	for (auto &pChild : _children)
+		pChild->rebuildMaterial(directCtx, creator, textureNames);
+}
+
+void MeshNode::collectNodes(std::vector<MeshNode *> &nodes) {
+	if (nodes.size() <= _transformHandle)
+		nodes.resize(_transformHandle + 1, nullptr);
+	nodes[_transformHandle] = this;
+	for (auto &pChild : _children)
+		pChild->collectNodes(nodes);
+}
+
+void MeshNode::setTransformSlot(size_t slot) {
+	assert(_nodeTransformCBuffer != nullptr);
+	_transformSlot = slot;
+}
+
+size_t MeshNode::getTransformSlot() const {
+	return _transformSlot;
+}
+
+size_t MeshNode::getItemTransform(size_t idx) const {
+	assert(idx < _itemTransforms.size());
+	return _itemTransforms[idx];
+}
+
+void MeshNode::applyWorldTransform(const rgph::TransformStore &store, UploadStaging &staging) {
+	assert(_transformSlot != UploadStaging::kInvalidSlot);
+	staging.write(_transformSlot, store);
+	Matrix4 matWorld(store.matWorld);
+	for (auto &pRenderItem : _renderItems)
+		pRenderItem->applyTransform(matWorld);
+}
+
+void MeshNode::uploadTransform(const rgph::TransformStore &store) const {
+	assert(_nodeTransformCBuffer != nullptr);
+	_nodeTransformCBuffer.setTransformStore(store);
+}
+
 }
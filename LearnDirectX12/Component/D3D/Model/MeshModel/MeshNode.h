@@ -1,16 +1,24 @@
 #pragma once
 #include "D3D/Model/MeshModel/MeshModel.h"
 #include "RenderGraph/Job/TransformCBufferPtr.h"
+#include "D3D/Model/Transform/TransformHierarchy.h"
+#include "D3D/UploadStaging/UploadStaging.h"
 
 namespace d3d {
 
 class ALNode;
+struct ALMesh;
 class MeshNode : public INode {
 public:
-	MeshNode(dx12lib::IDirectContext &directCtx, const ALNode *pALNode);
+	MeshNode(dx12lib::IDirectContext &directCtx, 
+		const ALNode *pALNode, 
+		TransformHierarchy &transforms, 
+		size_t parentTransform = TransformHierarchy::kInvalidNode
+	);
 	void submit(const IBounding &bounding, const rgph::TechniqueFlag &techniqueFlag) const override;
 	size_t getNumRenderItem() const override;
 	RenderItem *getRenderItem(size_t idx) const override;
+	// only the root has a parent transform, inner nodes follow the hierarchy
 	void setParentTransform(const Math::Matrix4 &matWorld) override;
 	const rgph::TransformCBufferPtr &getNodeTransformCBuffer() const override;
 	std::shared_ptr<rgph::IMesh> getMesh(size_t idx) const override;
@@ -18,10 +26,29 @@ public:
 		dx12lib::IDirectContext &directCtx, 
 		const MeshModel::MaterialCreator &creator
 	);
+	void requestTextureResidency(const IBounding &bounding, const TextureStreamingView &view) const;
+	void rebuildMaterial(dx12lib::IDirectContext &directCtx, 
+		const MeshModel::MaterialCreator &creator, 
+		const std::vector<std::string> &textureNames
+	);
+	// mesh space box as center and extents, the way the hierarchy transforms them
+	static TransformAABB calcMeshBounds(const ALMesh &mesh);
+	// nodes[transform handle] = node for the whole subtree
+	void collectNodes(std::vector<MeshNode *> &nodes);
+	// only nodes with meshes have a transform buffer and a staging slot
+	void setTransformSlot(size_t slot);
+	size_t getTransformSlot() const;
+	// hierarchy node holding the world box of render item idx
+	size_t getItemTransform(size_t idx) const;
+	// render stage side of a moved node: stages the store and moves the render item bounds along
+	void applyWorldTransform(const rgph::TransformStore &store, UploadStaging &staging);
+	void uploadTransform(const rgph::TransformStore &store) const;
 private:
-	mutable bool _transformDirty = true;
-	Math::float4x4 _applyTransform;
 	Math::float4x4 _nodeLocalTransform;
+	TransformHierarchy *_pTransforms;
+	size_t _transformHandle;
+	size_t _transformSlot = UploadStaging::kInvalidSlot;
+	std::vector<size_t> _itemTransforms;			// bounds only children, one per render item
 	std::vector<std::shared_ptr<ALMesh>> _alMeshes;
 	std::vector<std::unique_ptr<RenderItem>> _renderItems;
 	std::vector<std::unique_ptr<MeshNode>> _children;
@@ -1,12 +1,34 @@
-#include <format>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include "RenderItem.h"
 #include "D3D/Model/IModel.hpp"
 #include "RenderGraph/Material/Material.h"
+#include "D3D/TextureManager/TextureManager.h"
 
 namespace d3d {
 
 using namespace Math;
 
+template<typename T>
+static std::pair<const void *, size_t> makeSemanticData(const std::vector<T> &data) {
+	return { data.data(), data.size() };
+}
+
+static std::pair<const void *, size_t> getSemanticData(const rgph::IMesh &mesh, const VertexDataSemantic &semantic) {
+	if (semantic == PositionSemantic)
+		return makeSemanticData(mesh.getPositions());
+	if (semantic == NormalSemantic)
+		return makeSemanticData(mesh.getNormals());
+	if (semantic == TangentSemantic)
+		return makeSemanticData(mesh.getTangents());
+	if (semantic == Texcoord0Semantic)
+		return makeSemanticData(mesh.getTexcoord0());
+	if (semantic == Texcoord1Semantic)
+		return makeSemanticData(mesh.getTexcoord1());
+	return { nullptr, 0 };
+}
+
 RenderItem::RenderItem(dx12lib::IDirectContext &directCtx, INode *pNode, size_t meshIdx) {
 	auto pALMesh = pNode->getMesh(meshIdx);
 	_pGeometry = std::make_shared<rgph::Geometry>();
@@ -14,43 +36,48 @@ RenderItem::RenderItem(dx12lib::IDirectContext &directCtx, INode *pNode, size_t
 	_pGeometry->genDrawArgs();
 	_pTransformCBuf = pNode->getNodeTransformCBuffer();
 
-	const auto &indices = pALMesh->getIndices();
-	if (indices.size() < 3)
+	const auto &positions = pALMesh->getPositions();
+	if (positions.empty())
 		return;
 
-	std::shared_ptr<dx12lib::IndexBuffer> pIndexBuffer;
-	if (pALMesh->getPositions().size() > std::numeric_limits<uint16_t>::max()) {
-		std::string key = pALMesh->getMeshName() + "_IndexBuffer_uint32";
-		pIndexBuffer = MeshManager::instance()->getIndexBuffer(key);
-		if (pIndexBuffer == nullptr) {
-			pIndexBuffer = directCtx.createIndexBuffer(
-				indices.data(), 
-				indices.size(), 
-				DXGI_FORMAT_R32_UINT
-			);
-			MeshManager::instance()->cacheIndexBuffer(key, pIndexBuffer);
+	// bounding sphere for the texture streaming screen size estimate
+	float vMin[3] = { positions[0].x, positions[0].y, positions[0].z };
+	float vMax[3] = { positions[0].x, positions[0].y, positions[0].z };
+	for (const auto &position : positions) {
+		const float p[3] = { position.x, position.y, position.z };
+		for (size_t i = 0; i < 3; ++i) {
+			vMin[i] = std::min(vMin[i], p[i]);
+			vMax[i] = std::max(vMax[i], p[i]);
 		}
-	} else {
-		std::string key = pALMesh->getMeshName() + "_IndexBuffer_uint16";
-		pIndexBuffer = MeshManager::instance()->getIndexBuffer(key);
-		if (pIndexBuffer == nullptr) {
-			std::vector<uint16_t> newIndices;
-			newIndices.resize(indices.size());
-			for (size_t i = 0; i < indices.size()-2; i += 3) {
-				newIndices[i+0] = static_cast<uint16_t>(indices[i+0]);
-				newIndices[i+1] = static_cast<uint16_t>(indices[i+1]);
-				newIndices[i+2] = static_cast<uint16_t>(indices[i+2]);
-			}
-
-			pIndexBuffer = directCtx.createIndexBuffer(
-				newIndices.data(), 
-				newIndices.size(), 
-				DXGI_FORMAT_R16_UINT
-			);
-			MeshManager::instance()->cacheIndexBuffer(key, pIndexBuffer);
+	}
+	float lengthSq = 0.f;
+	for (size_t i = 0; i < 3; ++i) {
+		float extent = (vMax[i] - vMin[i]) * 0.5f;
+		_localSphereCenter[i] = (vMax[i] + vMin[i]) * 0.5f;
+		lengthSq += extent * extent;
+	}
+	_localSphereRadius = std::sqrt(lengthSq);
+	std::memcpy(_worldSphereCenter, _localSphereCenter, sizeof(_worldSphereCenter));
+	_worldSphereRadius = _localSphereRadius;
+
+	// vertices and indices live in the shared arena pages, one allocation per mesh
+	auto *pMeshManager = MeshManager::instance();
+	const std::string &meshName = pALMesh->getMeshName();
+	_pMeshAllocation = pMeshManager->getMeshAllocation(meshName);
+	if (_pMeshAllocation == nullptr) {
+		VertexSemanticData semanticData;
+		for (size_t i = 0; i < kNumVertexSemantic; ++i) {
+			auto [pData, count] = getSemanticData(*pALMesh, SemanticList[i]);
+			semanticData[i] = (count == positions.size()) ? pData : nullptr;
 		}
+		_pMeshAllocation = pMeshManager->allocateMesh(meshName, positions.size(), semanticData, pALMesh->getIndices());
 	}
-	_pGeometry->setIndexBuffer(pIndexBuffer);
+
+	// the draw starts at the mesh's place in the pages, the indices are not rebased
+	auto drawArgs = _pGeometry->getDrawArgs();
+	drawArgs.baseVertexLocation = _pMeshAllocation->baseVertexLocation;
+	drawArgs.startIndexLocation = _pMeshAllocation->startIndexLocation;
+	_pGeometry->setDrawArgs(drawArgs);
 }
 
 std::shared_ptr<rgph::Material> RenderItem::getMaterial() const {
@@ -74,42 +101,23 @@ void RenderItem::rebuildTechniqueFromMaterial(dx12lib::IDirectContext &directCtx
 	}
 }
 
-template<typename T>
-static std::shared_ptr<dx12lib::VertexBuffer> buildVertexDataInputImpl(
-	dx12lib::IDirectContext &directCtx,
-	const VertexDataSemantic &semantic,
-	const std::string &meshName,
-	const std::vector<T> &data)
-{
-	assert(!data.empty());
-	std::string key = meshName + std::format("_{}", semantic.name);
-	auto pVertexBuffer = MeshManager::instance()->getVertexBuffer(key);
-	if (pVertexBuffer == nullptr) {
-		pVertexBuffer = directCtx.createVertexBuffer(data.data(), data.size(), sizeof(T));
-		MeshManager::instance()->cacheVertexBuffer(key, pVertexBuffer);
-	}
-	return pVertexBuffer;
-}
-
 bool RenderItem::buildVertexDataInput(dx12lib::IDirectContext &directCtx, const VertexDataSemantic &semantic) {
-	if (_pGeometry->getVertexBuffer(semantic.slot) != nullptr)
+	if (_pGeometry->getVertexBuffer(semantic.slot) != nullptr || _pMeshAllocation == nullptr)
 		return false;
 
-	auto pMesh = _pGeometry->getMesh();
-	const std::string &meshName = pMesh->getMeshName();
-	std::shared_ptr<dx12lib::VertexBuffer> pVertexBuffer = nullptr;
-	if (semantic == PositionSemantic)
-		pVertexBuffer = buildVertexDataInputImpl(directCtx, semantic, meshName, pMesh->getPositions());
-	else if (semantic == NormalSemantic)
-		pVertexBuffer = buildVertexDataInputImpl(directCtx, semantic, meshName, pMesh->getNormals());
-	else if (semantic == TangentSemantic)
-		pVertexBuffer = buildVertexDataInputImpl(directCtx, semantic, meshName, pMesh->getTangents());
-	else if (semantic == Texcoord0Semantic)
-		pVertexBuffer = buildVertexDataInputImpl(directCtx, semantic, meshName, pMesh->getTexcoord0());
-	else if (semantic == Texcoord1Semantic)
-		pVertexBuffer = buildVertexDataInputImpl(directCtx, semantic, meshName, pMesh->getTexcoord1());
-
-	assert(pVertexBuffer != nullptr);
+	// the first bind after loading uploads every page written so far in one go
+	auto *pMeshManager = MeshManager::instance();
+	pMeshManager->flushGeometryArena(directCtx);
+	if (_pMeshAllocation->indexRange && !_indexBufferBound) {
+		_pGeometry->setIndexBuffer(pMeshManager->getArenaIndexBuffer(*_pMeshAllocation));
+		_indexBufferBound = true;
+	}
+
+	std::shared_ptr<dx12lib::VertexBuffer> pVertexBuffer = pMeshManager->getArenaVertexBuffer(*_pMeshAllocation, semantic);
+	if (pVertexBuffer == nullptr) {
+		assert(false && "mesh has no data for this semantic");
+		return false;
+	}
 	_pGeometry->setVertexBuffer(semantic.slot, pVertexBuffer);
 	return true;
 }
@@ -120,6 +128,40 @@ const BoundingBox & RenderItem::getWorldAABB() const {
 
 void RenderItem::applyTransform(const Matrix4 &matWorld) {
 	_pGeometry->applyTransform(matWorld);
+
+	DX::XMMATRIX matrix = matWorld;
+	DX::XMVECTOR center = DX::XMVectorSet(_localSphereCenter[0], _localSphereCenter[1], _localSphereCenter[2], 1.f);
+	center = DX::XMVector3TransformCoord(center, matrix);
+	_worldSphereCenter[0] = DX::XMVectorGetX(center);
+	_worldSphereCenter[1] = DX::XMVectorGetY(center);
+	_worldSphereCenter[2] = DX::XMVectorGetZ(center);
+	float maxScale = 0.f;
+	for (size_t i = 0; i < 3; ++i)
+		maxScale = std::max(maxScale, DX::XMVectorGetX(DX::XMVector3Length(matrix.r[i])));
+	_worldSphereRadius = _localSphereRadius * maxScale;
+}
+
+void RenderItem::addStreamingTexture(const std::string &textureName) {
+	if (textureName.empty())
+		return;
+	if (std::find(_streamingTextures.begin(), _streamingTextures.end(), textureName) == _streamingTextures.end())
+		_streamingTextures.push_back(textureName);
+}
+
+void RenderItem::requestTextureResidency(const TextureStreamingView &view) const {
+	if (_streamingTextures.empty())
+		return;
+
+	// assumes the uv set covers the texture about once across the item
+	float screenSize = TextureResidency::estimateScreenSize(_worldSphereCenter, _worldSphereRadius, view);
+	auto *pTextureManager = TextureManager::instance();
+	for (const std::string &textureName : _streamingTextures)
+		pTextureManager->requestTextureScreenSize(textureName, screenSize);
+}
+
+bool RenderItem::usesStreamingTexture(const std::vector<std::string> &textureNames) const {
+	return std::find_first_of(_streamingTextures.begin(), _streamingTextures.end(),
+		textureNames.begin(), textureNames.end()) != _streamingTextures.end();
 }
 
 }
@@ -3,6 +3,7 @@
 #include "D3D/AssimpLoader/ALNode.h"
 #include "D3D/Model/RenderItem/VertexDataSemantic.h"
 #include "D3D/Model/Mesh/MeshManager.h"
+#include "D3D/TextureManager/TextureResidency.h"
 
 namespace rgph {
 class Material;
@@ -22,8 +23,20 @@ public:
 	using rgph::Drawable::submit;
 	const Math::BoundingBox &getWorldAABB() const;
 	void applyTransform(const Math::Matrix4 &matWorld);
+
+	// textures used by the material, their mips are requested from the projected size of this item
+	void addStreamingTexture(const std::string &textureName);
+	void requestTextureResidency(const TextureStreamingView &view) const;
+	bool usesStreamingTexture(const std::vector<std::string> &textureNames) const;
 private:
 	std::shared_ptr<rgph::Material> _pMaterial;
+	std::shared_ptr<const MeshAllocation> _pMeshAllocation;
+	bool _indexBufferBound = false;
+	std::vector<std::string> _streamingTextures;
+	float _localSphereCenter[3] = { 0.f, 0.f, 0.f };
+	float _localSphereRadius = 0.f;
+	float _worldSphereCenter[3] = { 0.f, 0.f, 0.f };
+	float _worldSphereRadius = 0.f;
 };
 
 }
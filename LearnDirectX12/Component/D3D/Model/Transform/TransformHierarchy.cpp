@@ -0,0 +1,285 @@
+#include "TransformHierarchy.h"
+#include "JobSystem/JobSystem.h"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+namespace d3d {
+
+using namespace Math;
+
+// the rows of the upper 3x3 are the transformed basis vectors
+static Vector3 getAxis(const float4x4 &matrix, size_t row) {
+	return Vector3(matrix.m[row][0], matrix.m[row][1], matrix.m[row][2]);
+}
+
+TransformClass classifyTransform(const Matrix4 &matrix) {
+	constexpr float kEpsilon = 1e-4f;
+	float4x4 m(matrix);
+	Vector3 axes[3] = { getAxis(m, 0), getAxis(m, 1), getAxis(m, 2) };
+	float lengthSq = lengthSquare(axes[0]);
+	if (lengthSq <= 0.f)
+		return TransformClass::General;
+
+	float tolerance = kEpsilon * lengthSq;
+	for (size_t i = 0; i < 3; ++i) {
+		if (std::abs(lengthSquare(axes[i]) - lengthSq) > tolerance)
+			return TransformClass::General;
+		if (std::abs(dot(axes[i], axes[(i + 1) % 3])) > tolerance)
+			return TransformClass::General;
+	}
+	return std::abs(lengthSq - 1.f) <= kEpsilon ? TransformClass::Rigid : TransformClass::UniformScale;
+}
+
+Matrix4 calcNormalMatrix(const Matrix4 &matrix, TransformClass transformClass) {
+	float4x4 upper(matrix);
+	upper.m[3][0] = upper.m[3][1] = upper.m[3][2] = 0.f;
+	Matrix4 result(upper);
+	if (transformClass == TransformClass::Rigid)
+		return result;
+	// the inverse transpose of s * R is R / s
+	if (transformClass == TransformClass::UniformScale)
+		return Matrix4::makeScale(1.f / lengthSquare(getAxis(upper, 0))) * result;
+	return transpose(inverse(result));
+}
+
+TransformAABB transformAABB(const TransformAABB &box, const Matrix4 &matrix) {
+	float4x4 m(matrix);
+	TransformAABB result;
+	for (size_t col = 0; col < 3; ++col) {
+		float center = m.m[3][col];
+		float extent = 0.f;
+		for (size_t row = 0; row < 3; ++row) {
+			center += box.center[row] * m.m[row][col];
+			extent += box.extents[row] * std::abs(m.m[row][col]);
+		}
+		result.center[col] = center;
+		result.extents[col] = extent;
+	}
+	return result;
+}
+
+size_t TransformHierarchy::addNode(size_t parent, const float4x4 &local) {
+	size_t parentSlot = kInvalidNode;
+	std::uint32_t depth = 0;
+	if (parent != kInvalidNode) {
+		assert(parent < _slots.size());
+		if (parent >= _slots.size())
+			return kInvalidNode;
+		parentSlot = _slots[parent];
+		depth = _depths[parentSlot] + 1;
+	}
+
+	size_t node = _slots.size();
+	size_t slot = _nodes.size();
+	if (!_depths.empty() && depth < _depths.back())
+		_sorted = false;
+
+	TransformClass localClass = classifyTransform(Matrix4(local));
+	_parentSlots.push_back(static_cast<std::uint32_t>(parentSlot));
+	_depths.push_back(depth);
+	_flags.push_back(kDirty);
+	_localClasses.push_back(localClass);
+	_worldClasses.push_back(localClass);
+	_locals.push_back(local);
+	_worlds.push_back(local);
+	_normals.emplace_back(calcNormalMatrix(Matrix4(local), localClass));
+	_localBounds.emplace_back();
+	_worldBounds.emplace_back();
+	_nodes.push_back(node);
+	_slots.push_back(slot);
+	if (_levelEnds.size() <= depth)
+		_levelEnds.resize(depth + 1, 0);
+	_dirtyMinDepth = std::min<size_t>(_dirtyMinDepth, depth);
+	return node;
+}
+
+void TransformHierarchy::setLocalTransform(size_t node, const float4x4 &local) {
+	assert(node < _slots.size());
+	size_t slot = _slots[node];
+	_locals[slot] = local;
+	_localClasses[slot] = classifyTransform(Matrix4(local));
+	_flags[slot] |= kDirty;
+	_dirtyMinDepth = std::min<size_t>(_dirtyMinDepth, _depths[slot]);
+}
+
+void TransformHierarchy::setLocalBounds(size_t node, const TransformAABB &bounds) {
+	assert(node < _slots.size());
+	size_t slot = _slots[node];
+	_localBounds[slot] = bounds;
+	_flags[slot] |= kDirty | kHasBounds;
+	_dirtyMinDepth = std::min<size_t>(_dirtyMinDepth, _depths[slot]);
+}
+
+void TransformHierarchy::clear() {
+	bool parallel = _parallel;
+	*this = TransformHierarchy{};
+	_parallel = parallel;
+}
+
+void TransformHierarchy::setParallel(bool parallel) {
+	_parallel = parallel;
+}
+
+const TransformUpdateStats &TransformHierarchy::update() {
+	_stats = {};
+	_changedNodes.clear();
+	if (_dirtyMinDepth == SIZE_MAX)
+		return _stats;
+
+	if (!_sorted)
+		sortByDepth();
+
+	// slots are in depth order, so the level ends are the running counts
+	std::fill(_levelEnds.begin(), _levelEnds.end(), 0);
+	for (std::uint32_t depth : _depths)
+		++_levelEnds[depth];
+	for (size_t level = 1; level < _levelEnds.size(); ++level)
+		_levelEnds[level] += _levelEnds[level - 1];
+
+	size_t firstLevel = _dirtyMinDepth;
+	size_t firstSlot = firstLevel == 0 ? 0 : _levelEnds[firstLevel - 1];
+	_stats.numLevels = _levelEnds.size() - firstLevel;
+	_stats.numVisited = _nodes.size() - firstSlot;
+
+	if (!_parallel) {
+		updateRange(firstSlot, _nodes.size());
+	} else {
+		// a level reads the worlds and flags of its parents, parallelFor only returns once the
+		// whole level is written
+		for (size_t level = firstLevel; level < _levelEnds.size(); ++level) {
+			size_t levelBegin = level == 0 ? 0 : _levelEnds[level - 1];
+			com::parallelFor(levelBegin, _levelEnds[level], kMinNodesPerJob, [this](size_t begin, size_t end) {
+				updateRange(begin, end);
+			});
+		}
+	}
+
+	for (size_t slot = firstSlot; slot < _nodes.size(); ++slot) {
+		if (_flags[slot] & kChanged) {
+			_changedNodes.push_back(_nodes[slot]);
+			_flags[slot] &= ~(kDirty | kChanged);
+		}
+	}
+	_stats.numUpdated = _changedNodes.size();
+	_dirtyMinDepth = SIZE_MAX;
+	return _stats;
+}
+
+const std::vector<size_t> &TransformHierarchy::getChangedNodes() const {
+	return _changedNodes;
+}
+
+size_t TransformHierarchy::size() const {
+	return _nodes.size();
+}
+
+size_t TransformHierarchy::getParent(size_t node) const {
+	assert(node < _slots.size());
+	std::uint32_t parentSlot = _parentSlots[_slots[node]];
+	return parentSlot == static_cast<std::uint32_t>(kInvalidNode) ? kInvalidNode : _nodes[parentSlot];
+}
+
+size_t TransformHierarchy::getDepth(size_t node) const {
+	assert(node < _slots.size());
+	return _depths[_slots[node]];
+}
+
+const float4x4 &TransformHierarchy::getLocalTransform(size_t node) const {
+	assert(node < _slots.size());
+	return _locals[_slots[node]];
+}
+
+const float4x4 &TransformHierarchy::getWorldTransform(size_t node) const {
+	assert(node < _slots.size());
+	return _worlds[_slots[node]];
+}
+
+const float4x4 &TransformHierarchy::getNormalTransform(size_t node) const {
+	assert(node < _slots.size());
+	return _normals[_slots[node]];
+}
+
+TransformClass TransformHierarchy::getWorldClass(size_t node) const {
+	assert(node < _slots.size());
+	return _worldClasses[_slots[node]];
+}
+
+bool TransformHierarchy::hasBounds(size_t node) const {
+	assert(node < _slots.size());
+	return (_flags[_slots[node]] & kHasBounds) != 0;
+}
+
+const TransformAABB &TransformHierarchy::getWorldBounds(size_t node) const {
+	assert(node < _slots.size());
+	return _worldBounds[_slots[node]];
+}
+
+void TransformHierarchy::sortByDepth() {
+	size_t count = _nodes.size();
+	std::vector<size_t> order(count);
+	for (size_t slot = 0; slot < count; ++slot)
+		order[slot] = slot;
+	std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+		return _depths[lhs] < _depths[rhs];
+	});
+
+	std::vector<size_t> newSlots(count);
+	for (size_t slot = 0; slot < count; ++slot)
+		newSlots[order[slot]] = slot;
+
+	auto permute = [&](auto &array) {
+		std::remove_reference_t<decltype(array)> sorted(count);
+		for (size_t slot = 0; slot < count; ++slot)
+			sorted[slot] = array[order[slot]];
+		array.swap(sorted);
+	};
+	permute(_parentSlots);
+	permute(_depths);
+	permute(_flags);
+	permute(_localClasses);
+	permute(_worldClasses);
+	permute(_locals);
+	permute(_worlds);
+	permute(_normals);
+	permute(_localBounds);
+	permute(_worldBounds);
+	permute(_nodes);
+
+	for (std::uint32_t &parentSlot : _parentSlots) {
+		if (parentSlot != static_cast<std::uint32_t>(kInvalidNode))
+			parentSlot = static_cast<std::uint32_t>(newSlots[parentSlot]);
+	}
+	for (size_t slot = 0; slot < count; ++slot)
+		_slots[_nodes[slot]] = slot;
+	_sorted = true;
+}
+
+void TransformHierarchy::updateRange(size_t slotBegin, size_t slotEnd) {
+	constexpr std::uint32_t kNoParent = static_cast<std::uint32_t>(kInvalidNode);
+	for (size_t slot = slotBegin; slot < slotEnd; ++slot) {
+		std::uint32_t parentSlot = _parentSlots[slot];
+		bool parentChanged = parentSlot != kNoParent && (_flags[parentSlot] & kChanged);
+		if (!(_flags[slot] & kDirty) && !parentChanged)
+			continue;
+
+		TransformClass worldClass = _localClasses[slot];
+		Matrix4 world(_locals[slot]);
+		if (parentSlot != kNoParent) {
+			// the local transform applies first
+			world = Matrix4(_worlds[parentSlot]) * world;
+			worldClass = std::max(worldClass, _worldClasses[parentSlot]);
+			// two uniform scales may cancel out
+			if (worldClass == TransformClass::UniformScale)
+				worldClass = classifyTransform(world);
+		}
+		_worlds[slot] = float4x4(world);
+		_worldClasses[slot] = worldClass;
+		_normals[slot] = float4x4(calcNormalMatrix(world, worldClass));
+		if (_flags[slot] & kHasBounds)
+			_worldBounds[slot] = transformAABB(_localBounds[slot], world);
+		_flags[slot] |= kChanged;
+	}
+}
+
+}
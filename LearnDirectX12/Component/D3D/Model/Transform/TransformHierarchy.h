@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Math/MathStd.hpp"
+
+namespace d3d {
+
+struct TransformAABB {
+	float center[3] = { 0.f, 0.f, 0.f };
+	float extents[3] = { 0.f, 0.f, 0.f };
+};
+
+// how far the upper 3x3 is from a rotation, decides the cost of the normal matrix
+enum class TransformClass : std::uint8_t {
+	Rigid,				// orthonormal rows, the normal matrix is the 3x3 itself
+	UniformScale,		// orthogonal rows of equal length s, the normal matrix is 3x3 / s^2
+	General,			// needs the inverse transpose
+};
+
+TransformClass classifyTransform(const Math::Matrix4 &matrix);
+// upper 3x3 inverse transpose in a 4x4 with the translation cleared
+Math::Matrix4 calcNormalMatrix(const Math::Matrix4 &matrix, TransformClass transformClass);
+TransformAABB transformAABB(const TransformAABB &box, const Math::Matrix4 &matrix);
+
+struct TransformUpdateStats {
+	size_t numLevels = 0;			// depth levels walked
+	size_t numVisited = 0;			// nodes checked on those levels
+	size_t numUpdated = 0;			// world matrices recomputed
+};
+
+// Flat scene transform storage. Nodes live in arrays sorted by depth so every parent is computed
+// before its children; matrices, bounds and flags are separate arrays. setLocalTransform only
+// marks the node dirty, update() propagates once per frame, levels above the shallowest dirty
+// node are skipped and the nodes of one level can run on the JobSystem workers
+class TransformHierarchy {
+public:
+	constexpr static size_t kInvalidNode = -1;
+
+	size_t addNode(size_t parent = kInvalidNode, const Math::float4x4 &local = Math::float4x4::identity());
+	void setLocalTransform(size_t node, const Math::float4x4 &local);
+	void setLocalBounds(size_t node, const TransformAABB &bounds);
+	void clear();
+
+	// splits every level over the shared JobSystem and joins it before the next one reads the
+	// parents, false runs every level on the calling thread
+	void setParallel(bool parallel);
+	const TransformUpdateStats &update();
+	// nodes whose world matrix changed in the last update, in depth order
+	const std::vector<size_t> &getChangedNodes() const;
+
+	size_t size() const;
+	size_t getParent(size_t node) const;
+	size_t getDepth(size_t node) const;
+	const Math::float4x4 &getLocalTransform(size_t node) const;
+	const Math::float4x4 &getWorldTransform(size_t node) const;
+	const Math::float4x4 &getNormalTransform(size_t node) const;
+	TransformClass getWorldClass(size_t node) const;
+	bool hasBounds(size_t node) const;
+	const TransformAABB &getWorldBounds(size_t node) const;
+private:
+	void sortByDepth();
+	void updateRange(size_t slotBegin, size_t slotEnd);
+private:
+	constexpr static size_t kMinNodesPerJob = 256;
+
+	enum : std::uint8_t {
+		kDirty = 0x1,			// local transform or bounds changed
+		kChanged = 0x2,			// world recomputed in the running update
+		kHasBounds = 0x4,
+	};
+
+	// indexed by slot
+	std::vector<std::uint32_t>	  _parentSlots;
+	std::vector<std::uint32_t>	  _depths;
+	std::vector<std::uint8_t>	  _flags;
+	std::vector<TransformClass>   _localClasses;
+	std::vector<TransformClass>   _worldClasses;
+	std::vector<Math::float4x4>	  _locals;
+	std::vector<Math::float4x4>	  _worlds;
+	std::vector<Math::float4x4>	  _normals;
+	std::vector<TransformAABB>	  _localBounds;
+	std::vector<TransformAABB>	  _worldBounds;
+	std::vector<size_t>			  _nodes;			// slot -> node
+
+	std::vector<size_t>			  _slots;			// node -> slot
+	std::vector<size_t>			  _levelEnds;		// slot one past the end of every depth
+	size_t _dirtyMinDepth = SIZE_MAX;
+	bool _sorted = true;
+	bool _parallel = false;
+	std::vector<size_t> _changedNodes;
+	TransformUpdateStats _stats;
+};
+
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <format>
+#include <chrono>
+#include "TestCheck.h"
+#include "D3D/Model/Transform/TransformHierarchy.h"
+#include "JobSystem/JobSystem.h"
+
+using namespace d3d;
+using namespace Math;
+
+void transformHierarchyTest() {
+	auto nearlyEqual = [](const float4x4 &lhs, const float4x4 &rhs) {
+		for (size_t row = 0; row < 4; ++row) {
+			for (size_t col = 0; col < 4; ++col) {
+				if (std::abs(lhs.m[row][col] - rhs.m[row][col]) > 1e-3f)
+					return false;
+			}
+		}
+		return true;
+	};
+
+	TEST_CHECK(classifyTransform(Matrix4::makeYRotationByRadian(0.7f)) == TransformClass::Rigid);
+	TEST_CHECK(classifyTransform(Matrix4::makeYRotationByRadian(0.3f) * Matrix4::makeScale(2.f)) == TransformClass::UniformScale);
+	Matrix4 skewed = Matrix4::makeYRotationByRadian(0.4f) * Matrix4::makeScale(1.f, 3.f, 0.5f);
+	TEST_CHECK(classifyTransform(skewed) == TransformClass::General);
+	// M * N^T == I for the upper 3x3, whichever path computed N
+	for (const Matrix4 &matrix : { skewed, Matrix4(Matrix4::makeYRotationByRadian(1.f) * Matrix4::makeScale(4.f)) }) {
+		float4x4 m(matrix);
+		float4x4 normal(calcNormalMatrix(matrix, classifyTransform(matrix)));
+		for (size_t row = 0; row < 3; ++row) {
+			for (size_t col = 0; col < 3; ++col) {
+				float sum = 0.f;
+				for (size_t k = 0; k < 3; ++k)
+					sum += m.m[row][k] * normal.m[col][k];
+				TEST_CHECK(std::abs(sum - (row == col ? 1.f : 0.f)) < 1e-4f);
+			}
+		}
+	}
+
+	// root -> 8 branches -> 2000 leaves each, leaves carry bounds
+	auto buildScene = [](TransformHierarchy &hierarchy, std::vector<size_t> &leaves) {
+		size_t root = hierarchy.addNode();
+		std::vector<size_t> branches;
+		for (int i = 0; i < 8; ++i)
+			branches.push_back(hierarchy.addNode(root, float4x4(Matrix4::makeTranslation(10.f * i, 0.f, 0.f) * Matrix4::makeYRotationByRadian(0.1f * i))));
+		for (int i = 0; i < 16000; ++i) {
+			size_t leaf = hierarchy.addNode(branches[i % 8], float4x4(Matrix4::makeTranslation(0.f, 0.01f * i, 1.f)));
+			hierarchy.setLocalBounds(leaf, TransformAABB{ { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f } });
+			leaves.push_back(leaf);
+		}
+		// a late child of the root breaks the depth order until the next update
+		size_t lateNode = hierarchy.addNode(root, float4x4(Matrix4::makeScale(1.f, 2.f, 1.f)));
+		leaves.push_back(hierarchy.addNode(lateNode, float4x4(Matrix4::makeTranslation(1.f, 1.f, 1.f))));
+		return root;
+	};
+
+	TransformHierarchy serial;
+	std::vector<size_t> leaves;
+	size_t root = buildScene(serial, leaves);
+	const TransformUpdateStats &initStats = serial.update();
+	TEST_CHECK(initStats.numUpdated == serial.size() && initStats.numLevels == 3);
+	auto checkWorld = [&](const TransformHierarchy &hierarchy, size_t node) {
+		Matrix4 expected(hierarchy.getLocalTransform(node));
+		for (size_t parent = hierarchy.getParent(node); parent != TransformHierarchy::kInvalidNode; parent = hierarchy.getParent(parent))
+			expected = Matrix4(hierarchy.getLocalTransform(parent)) * expected;
+		return nearlyEqual(float4x4(expected), hierarchy.getWorldTransform(node));
+	};
+	for (size_t i = 0; i < leaves.size(); i += 997)
+		TEST_CHECK(checkWorld(serial, leaves[i]));
+	TEST_CHECK(serial.getDepth(leaves.back()) == 2 && serial.getWorldClass(leaves.back()) == TransformClass::General);
+
+	// nothing dirty: nothing visited
+	TEST_CHECK(serial.update().numVisited == 0 && serial.getChangedNodes().empty());
+
+	// moving a leaf only touches the leaf level and recomputes one node
+	serial.setLocalTransform(leaves[5], float4x4(Matrix4::makeTranslation(3.f, 0.f, 0.f)));
+	const TransformUpdateStats &leafStats = serial.update();
+	TEST_CHECK(leafStats.numUpdated == 1 && leafStats.numLevels == 1 && serial.getChangedNodes()[0] == leaves[5]);
+	TEST_CHECK(checkWorld(serial, leaves[5]));
+	const TransformAABB &bounds = serial.getWorldBounds(leaves[5]);
+	const float4x4 &world = serial.getWorldTransform(leaves[5]);
+	TEST_CHECK(std::abs(bounds.center[0] - world.m[3][0]) < 1e-4f && std::abs(bounds.extents[1] - 1.f) < 1e-4f);
+
+	// moving the root recomputes everything, the serial and the parallel result agree
+	TransformHierarchy parallel;
+	parallel.setParallel(true);
+	std::vector<size_t> parallelLeaves;
+	buildScene(parallel, parallelLeaves);
+	parallel.update();
+	parallel.setLocalTransform(leaves[5], float4x4(Matrix4::makeTranslation(3.f, 0.f, 0.f)));
+
+	double serialMs = 0.0;
+	double parallelMs = 0.0;
+	for (int frame = 0; frame < 4; ++frame) {
+		float4x4 rootTransform(Matrix4::makeYRotationByRadian(0.25f * frame) * Matrix4::makeScale(2.f));
+		serial.setLocalTransform(root, rootTransform);
+		parallel.setLocalTransform(root, rootTransform);
+		auto begin = std::chrono::steady_clock::now();
+		TEST_CHECK(serial.update().numUpdated == serial.size());
+		auto middle = std::chrono::steady_clock::now();
+		TEST_CHECK(parallel.update().numUpdated == parallel.size());
+		auto end = std::chrono::steady_clock::now();
+		serialMs += std::chrono::duration<double, std::milli>(middle - begin).count();
+		parallelMs += std::chrono::duration<double, std::milli>(end - middle).count();
+	}
+	for (size_t i = 0; i < leaves.size(); ++i) {
+		TEST_CHECK(nearlyEqual(serial.getWorldTransform(leaves[i]), parallel.getWorldTransform(parallelLeaves[i])));
+		TEST_CHECK(nearlyEqual(serial.getNormalTransform(leaves[i]), parallel.getNormalTransform(parallelLeaves[i])));
+	}
+	TEST_CHECK(checkWorld(parallel, parallelLeaves[777]) && parallel.getWorldClass(parallelLeaves[777]) == TransformClass::UniformScale);
+	std::cout << std::format("[TransformHierarchy] {} nodes, root move: serial {:.2f} ms, {} threads {:.2f} ms\n",
+		serial.size(), serialMs / 4.0, com::JobSystem::instance()->getThreadCount(), parallelMs / 4.0);
+
+	// a wide, slow first level: every parent is a general transform and only the parents are dirty,
+	// so a child sees its parent moved only through the changed flag of the level above
+	TransformHierarchy wide;
+	wide.setParallel(true);
+	size_t wideRoot = wide.addNode();
+	std::vector<size_t> parents;
+	std::vector<size_t> grandChildren;
+	for (int i = 0; i < 20000; ++i) {
+		parents.push_back(wide.addNode(wideRoot, float4x4(skewed)));
+		size_t child = wide.addNode(parents.back(), float4x4(Matrix4::makeTranslation(1.f, 0.f, 0.f)));
+		grandChildren.push_back(wide.addNode(child, float4x4(Matrix4::makeTranslation(0.f, 0.f, 0.001f * i))));
+	}
+	wide.update();
+	for (int frame = 1; frame <= 3; ++frame) {
+		for (size_t parent : parents)
+			wide.setLocalTransform(parent, float4x4(Matrix4::makeTranslation(0.f, static_cast<float>(frame), 0.f) * skewed));
+		const TransformUpdateStats &wideStats = wide.update();
+		TEST_CHECK(wideStats.numLevels == 3 && wideStats.numUpdated == wide.size() - 1);
+		size_t numWrong = 0;
+		for (size_t node : grandChildren)
+			numWrong += checkWorld(wide, node) ? 0 : 1;
+		TEST_CHECK(numWrong == 0);
+	}
+}
+
+int main() {
+	com::JobSystem::emplace(4);
+	transformHierarchyTest();
+	com::JobSystem::destroy();
+	return 0;
+}
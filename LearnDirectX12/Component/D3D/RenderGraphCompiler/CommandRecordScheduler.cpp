@@ -0,0 +1,177 @@
+#include "CommandRecordScheduler.h"
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <format>
+#include <JobSystem/JobSystem.h>
+
+namespace d3d {
+
+size_t RecordSchedule::getBatchBegin(size_t batch) const {
+	assert(batch < batchEnds.size());
+	return batch == 0 ? 0 : batchEnds[batch - 1];
+}
+
+std::string RecordStats::toString() const {
+	std::string result = std::format("record: {} threads, wall {:.2f} ms, {} submits\n", threads.size(), wallMs, numSubmits);
+	for (size_t i = 0; i < threads.size(); ++i) {
+		result += std::format("    thread {}: {} chunks, {} jobs, busy {:.2f} ms\n",
+			i, threads[i].numChunks, threads[i].numJobs, threads[i].busyMs);
+	}
+	return result;
+}
+
+size_t CommandRecordScheduler::addTask(RecordTaskDesc desc) {
+	assert(desc.record != nullptr);
+	_tasks.push_back(std::move(desc));
+	return _tasks.size() - 1;
+}
+
+void CommandRecordScheduler::clearTasks() {
+	_tasks.clear();
+}
+
+size_t CommandRecordScheduler::getThreadCount() const {
+	com::JobSystem *pJobSystem = com::JobSystem::instance();
+	return pJobSystem != nullptr ? pJobSystem->getThreadCount() : 1;
+}
+
+const RecordTaskDesc &CommandRecordScheduler::getTask(size_t task) const {
+	assert(task < _tasks.size());
+	return _tasks[task];
+}
+
+RecordSchedule CommandRecordScheduler::plan() const {
+	RecordSchedule schedule;
+	size_t numTasks = _tasks.size();
+	std::vector<std::vector<size_t>> successors(numTasks);
+	std::vector<size_t> inDegree(numTasks, 0);
+	for (size_t task = 0; task < numTasks; ++task) {
+		for (size_t dependency : _tasks[task].dependencies) {
+			assert(dependency < numTasks);
+			if (dependency >= numTasks || dependency == task)
+				continue;
+			successors[dependency].push_back(task);
+			++inDegree[task];
+		}
+	}
+
+	// the level of a task is its longest dependency chain, tasks of one level are independent
+	std::vector<size_t> levels(numTasks, 0);
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<>> ready;
+	for (size_t task = 0; task < numTasks; ++task) {
+		if (inDegree[task] == 0)
+			ready.push(task);
+	}
+	size_t numVisited = 0;
+	size_t numLevels = 0;
+	while (!ready.empty()) {
+		size_t task = ready.top();
+		ready.pop();
+		++numVisited;
+		numLevels = std::max(numLevels, levels[task] + 1);
+		for (size_t successor : successors[task]) {
+			levels[successor] = std::max(levels[successor], levels[task] + 1);
+			if (--inDegree[successor] == 0)
+				ready.push(successor);
+		}
+	}
+	if (numVisited != numTasks) {
+		schedule.error = "record tasks have a dependency cycle between:";
+		for (size_t task = 0; task < numTasks; ++task) {
+			if (inDegree[task] > 0)
+				schedule.error += std::format(" {}", _tasks[task].name);
+		}
+		return schedule;
+	}
+
+	// large tasks are split into at most one chunk per thread
+	size_t numThreads = getThreadCount();
+	for (size_t level = 0; level < numLevels; ++level) {
+		for (size_t task = 0; task < numTasks; ++task) {
+			const RecordTaskDesc &desc = _tasks[task];
+			if (levels[task] != level || desc.jobCount == 0)
+				continue;
+
+			size_t minJobsPerChunk = std::max<size_t>(desc.minJobsPerChunk, 1);
+			size_t numChunks = std::clamp<size_t>(desc.jobCount / minJobsPerChunk, 1, numThreads);
+			for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+				RecordChunk recordChunk;
+				recordChunk.task = task;
+				recordChunk.jobBegin = desc.jobCount * chunk / numChunks;
+				recordChunk.jobEnd = desc.jobCount * (chunk + 1) / numChunks;
+				schedule.chunks.push_back(recordChunk);
+			}
+		}
+		if (schedule.batchEnds.empty() || schedule.batchEnds.back() != schedule.chunks.size())
+			schedule.batchEnds.push_back(schedule.chunks.size());
+	}
+	return schedule;
+}
+
+RecordStats CommandRecordScheduler::execute(const RecordSchedule &schedule, const SubmitFunc &submit) {
+	assert(schedule);
+	size_t numJobs = std::min(getThreadCount(), schedule.chunks.size());
+	RecordStats stats;
+	stats.threads.resize(numJobs);
+	if (!schedule || schedule.chunks.empty())
+		return stats;
+
+	auto begin = std::chrono::steady_clock::now();
+	_pSchedule = &schedule;
+	_pSubmit = &submit;
+	_nextChunk = 0;
+	_nextSubmitBatch = 0;
+	_batchRemaining = std::vector<std::atomic<size_t>>(schedule.batchEnds.size());
+	_chunkBatches.resize(schedule.chunks.size());
+	for (size_t batch = 0; batch < schedule.batchEnds.size(); ++batch) {
+		size_t batchBegin = schedule.getBatchBegin(batch);
+		_batchRemaining[batch] = schedule.batchEnds[batch] - batchBegin;
+		std::fill(_chunkBatches.begin() + batchBegin, _chunkBatches.begin() + schedule.batchEnds[batch], batch);
+	}
+	_threadStats.assign(numJobs, RecordThreadStats{});
+
+	// one job per thread, each takes the next chunk until none is left
+	com::parallelFor(0, numJobs, 1, [this](size_t jobBegin, size_t jobEnd) {
+		for (size_t job = jobBegin; job < jobEnd; ++job)
+			recordChunks(job);
+	});
+	assert(_nextSubmitBatch == schedule.batchEnds.size());
+
+	stats.threads = _threadStats;
+	stats.numSubmits = _nextSubmitBatch;
+	stats.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	_pSchedule = nullptr;
+	_pSubmit = nullptr;
+	return stats;
+}
+
+void CommandRecordScheduler::recordChunks(size_t job) {
+	// chunks are taken in submission order, so the first batches finish first
+	const RecordSchedule &schedule = *_pSchedule;
+	RecordThreadStats &threadStats = _threadStats[job];
+	for (size_t index = _nextChunk++; index < schedule.chunks.size(); index = _nextChunk++) {
+		const RecordChunk &chunk = schedule.chunks[index];
+		auto begin = std::chrono::steady_clock::now();
+		_tasks[chunk.task].record(index, chunk.jobBegin, chunk.jobEnd);
+		threadStats.busyMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		threadStats.numJobs += chunk.jobEnd - chunk.jobBegin;
+		++threadStats.numChunks;
+
+		if (--_batchRemaining[_chunkBatches[index]] == 0)
+			submitReadyBatches();
+	}
+}
+
+void CommandRecordScheduler::submitReadyBatches() {
+	// called from whichever thread finished a batch, the lock keeps the submits ordered
+	std::lock_guard lock(_submitMutex);
+	const RecordSchedule &schedule = *_pSchedule;
+	while (_nextSubmitBatch < schedule.batchEnds.size() && _batchRemaining[_nextSubmitBatch] == 0) {
+		(*_pSubmit)(_nextSubmitBatch, schedule.getBatchBegin(_nextSubmitBatch), schedule.batchEnds[_nextSubmitBatch]);
+		++_nextSubmitBatch;
+	}
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+namespace d3d {
+
+// records jobs [jobBegin, jobEnd) of a task into the context with the given index
+using RecordFunc = std::function<void(size_t contextIndex, size_t jobBegin, size_t jobEnd)>;
+
+struct RecordTaskDesc {
+	const char		   *name = "";					// static string, tasks are added every frame
+	size_t				jobCount = 1;
+	size_t				minJobsPerChunk = 128;		// below twice this a task stays in one context
+	std::vector<size_t> dependencies;				// tasks whose commands must be submitted first
+	RecordFunc			record;
+};
+
+struct RecordChunk {
+	size_t task = 0;
+	size_t jobBegin = 0;
+	size_t jobEnd = 0;
+};
+
+// every chunk records into its own context, chunk index == context index. Batches are the
+// join points: a batch is submitted once all of its chunks and every earlier batch are recorded
+struct RecordSchedule {
+	std::vector<RecordChunk> chunks;				// submission order
+	std::vector<size_t> batchEnds;					// chunk index one past the end of every batch
+	std::string error;
+public:
+	explicit operator bool() const { return error.empty(); }
+	size_t getBatchBegin(size_t batch) const;
+};
+
+struct RecordThreadStats {
+	size_t numChunks = 0;
+	size_t numJobs = 0;
+	double busyMs = 0.0;
+};
+
+struct RecordStats {
+	std::vector<RecordThreadStats> threads;			// one per recording job
+	double wallMs = 0.0;
+	size_t numSubmits = 0;
+public:
+	std::string toString() const;
+};
+
+// CPU side of parallel command recording. Independent tasks, and large tasks split into chunks,
+// record on the shared JobSystem into separate contexts; the submit callback still sees them in
+// dependency order. Without a JobSystem every chunk records on the calling thread
+class CommandRecordScheduler {
+public:
+	// contexts of one batch in submission order, called by the thread that completes the batch,
+	// never twice at the same time
+	using SubmitFunc = std::function<void(size_t batch, size_t chunkBegin, size_t chunkEnd)>;
+
+	CommandRecordScheduler() = default;
+	CommandRecordScheduler(const CommandRecordScheduler &) = delete;
+	CommandRecordScheduler &operator=(const CommandRecordScheduler &) = delete;
+
+	size_t addTask(RecordTaskDesc desc);
+	void clearTasks();
+	size_t getThreadCount() const;
+	const RecordTaskDesc &getTask(size_t task) const;
+
+	RecordSchedule plan() const;
+	RecordStats execute(const RecordSchedule &schedule, const SubmitFunc &submit);
+private:
+	void recordChunks(size_t job);
+	void submitReadyBatches();
+private:
+	std::vector<RecordTaskDesc> _tasks;
+
+	// state of the running execute
+	const RecordSchedule *_pSchedule = nullptr;
+	const SubmitFunc *_pSubmit = nullptr;
+	std::atomic<size_t> _nextChunk = 0;
+	std::vector<std::atomic<size_t>> _batchRemaining;
+	std::vector<size_t> _chunkBatches;
+	std::mutex _submitMutex;
+	size_t _nextSubmitBatch = 0;
+	std::vector<RecordThreadStats> _threadStats;
+};
+
+}
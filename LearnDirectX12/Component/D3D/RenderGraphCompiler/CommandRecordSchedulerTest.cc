@@ -0,0 +1,68 @@
+#include <vector>
+#include <string>
+#include "TestCheck.h"
+#include "D3D/RenderGraphCompiler/CommandRecordScheduler.h"
+#include "JobSystem/JobSystem.h"
+
+using namespace d3d;
+
+void commandRecordSchedulerTest() {
+	CommandRecordScheduler scheduler;
+	TEST_CHECK(scheduler.getThreadCount() == 4);
+
+	// every context gets the (task, job) pairs recorded into it, like a command list
+	std::vector<std::vector<std::pair<size_t, size_t>>> contexts;
+	auto makeRecord = [&](size_t task) {
+		return [&contexts, task](size_t contextIndex, size_t jobBegin, size_t jobEnd) {
+			for (size_t job = jobBegin; job < jobEnd; ++job)
+				contexts[contextIndex].emplace_back(task, job);
+		};
+	};
+	size_t shadow = scheduler.addTask({ "Shadow", 1000, 100, {}, makeRecord(0) });
+	size_t opaque = scheduler.addTask({ "Opaque", 50, 100, {}, makeRecord(1) });
+	size_t skyBox = scheduler.addTask({ "SkyBox", 1, 128, { opaque }, makeRecord(2) });
+	size_t post = scheduler.addTask({ "Post", 1, 128, { shadow, skyBox }, makeRecord(3) });
+	TEST_CHECK(post == 3);
+
+	RecordSchedule schedule = scheduler.plan();
+	TEST_CHECK(schedule && schedule.chunks.size() == 7);
+	TEST_CHECK((schedule.batchEnds == std::vector<size_t>{ 5, 6, 7 }));
+	TEST_CHECK(schedule.chunks[0].task == shadow && schedule.chunks[3].jobEnd == 1000 && schedule.chunks[4].task == opaque);
+
+	for (int frame = 0; frame < 3; ++frame) {
+		contexts.assign(schedule.chunks.size(), {});
+		std::vector<std::pair<size_t, size_t>> submitted;
+		size_t expectedBatch = 0;
+		RecordStats stats = scheduler.execute(schedule, [&](size_t batch, size_t chunkBegin, size_t chunkEnd) {
+			TEST_CHECK(batch == expectedBatch);
+			++expectedBatch;
+			TEST_CHECK(chunkBegin == schedule.getBatchBegin(batch) && chunkEnd == schedule.batchEnds[batch]);
+			for (size_t chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+				submitted.insert(submitted.end(), contexts[chunk].begin(), contexts[chunk].end());
+		});
+
+		// submission order is the task order with the jobs of split tasks back in sequence
+		TEST_CHECK(submitted.size() == 1052 && stats.numSubmits == 3);
+		for (size_t i = 0; i < 1000; ++i)
+			TEST_CHECK(submitted[i] == std::make_pair(shadow, i));
+		TEST_CHECK(submitted[1000] == std::make_pair(opaque, size_t(0)) && submitted[1050].first == skyBox && submitted[1051].first == post);
+		size_t numJobs = 0;
+		for (const RecordThreadStats &threadStats : stats.threads)
+			numJobs += threadStats.numJobs;
+		TEST_CHECK(numJobs == 1052 && stats.threads.size() == 4);
+		TEST_CHECK(stats.toString().find("thread 3:") != std::string::npos);
+	}
+
+	scheduler.clearTasks();
+	size_t a = scheduler.addTask({ "A", 1, 128, { 1 }, makeRecord(0) });
+	scheduler.addTask({ "B", 1, 128, { a }, makeRecord(1) });
+	RecordSchedule cyclic = scheduler.plan();
+	TEST_CHECK(!cyclic && cyclic.error.find("A B") != std::string::npos);
+}
+
+int main() {
+	com::JobSystem::emplace(4);
+	commandRecordSchedulerTest();
+	com::JobSystem::destroy();
+	return 0;
+}
@@ -0,0 +1,427 @@
+#include "RenderGraphCompiler.h"
+#include <cassert>
+#include <algorithm>
+#include <queue>
+#include <functional>
+#include <format>
+
+namespace d3d {
+
+namespace GS = GraphResourceStates;
+
+constexpr static GraphResourceState kReadOnlyStates = GS::kDepthRead |
+	GS::kNonPixelShaderResource |
+	GS::kPixelShaderResource |
+	GS::kCopySource;
+
+static bool isReadOnlyState(GraphResourceState state) {
+	return state != GS::kCommon && (state & ~kReadOnlyStates) == 0;
+}
+
+GraphResourceState getGraphResourceState(GraphResourceUsage usage) {
+	switch (usage) {
+	case GraphResourceUsage::RenderTarget:		  return GS::kRenderTarget;
+	case GraphResourceUsage::DepthWrite:		  return GS::kDepthWrite;
+	case GraphResourceUsage::DepthRead:			  return GS::kDepthRead;
+	case GraphResourceUsage::PixelShaderRead:	  return GS::kPixelShaderResource;
+	case GraphResourceUsage::NonPixelShaderRead:  return GS::kNonPixelShaderResource;
+	case GraphResourceUsage::UnorderedAccess:	  return GS::kUnorderedAccess;
+	case GraphResourceUsage::CopySource:		  return GS::kCopySource;
+	case GraphResourceUsage::CopyDest:			  return GS::kCopyDest;
+	case GraphResourceUsage::Present:			  return GS::kPresent;
+	}
+	assert(false);
+	return GS::kCommon;
+}
+
+bool isGraphWriteUsage(GraphResourceUsage usage) {
+	switch (usage) {
+	case GraphResourceUsage::RenderTarget:
+	case GraphResourceUsage::DepthWrite:
+	case GraphResourceUsage::UnorderedAccess:
+	case GraphResourceUsage::CopyDest:
+		return true;
+	default:
+		return false;
+	}
+}
+
+std::string graphResourceStateToString(GraphResourceState state) {
+	static const std::pair<GraphResourceState, const char *> kStateNames[] = {
+		{ GS::kRenderTarget,			"RENDER_TARGET"				  },
+		{ GS::kUnorderedAccess,			"UNORDERED_ACCESS"			  },
+		{ GS::kDepthWrite,				"DEPTH_WRITE"				  },
+		{ GS::kDepthRead,				"DEPTH_READ"				  },
+		{ GS::kNonPixelShaderResource,	"NON_PIXEL_SHADER_RESOURCE"	  },
+		{ GS::kPixelShaderResource,		"PIXEL_SHADER_RESOURCE"		  },
+		{ GS::kCopyDest,				"COPY_DEST"					  },
+		{ GS::kCopySource,				"COPY_SOURCE"				  },
+	};
+	if (state == GS::kCommon)
+		return "COMMON";
+
+	std::string result;
+	for (auto &&[bit, pName] : kStateNames) {
+		if ((state & bit) == 0)
+			continue;
+		if (!result.empty())
+			result += '|';
+		result += pName;
+		state &= ~bit;
+	}
+	if (state != 0)
+		result += std::format("{}{:x}", result.empty() ? "" : "|", state);
+	return result;
+}
+
+bool CompiledRenderGraph::isCulled(GraphPassId pass) const {
+	return std::find(culledPasses.begin(), culledPasses.end(), pass) != culledPasses.end();
+}
+
+GraphResourceState CompiledRenderGraph::getPassState(GraphPassId pass, size_t accessIndex) const {
+	assert(pass < passStates.size() && accessIndex < passStates[pass].size());
+	if (pass >= passStates.size() || accessIndex >= passStates[pass].size())
+		return GS::kCommon;
+	return passStates[pass][accessIndex];
+}
+
+GraphResourceId RenderGraphCompiler::addResource(GraphResourceDesc desc) {
+	_resources.push_back(std::move(desc));
+	return static_cast<GraphResourceId>(_resources.size() - 1);
+}
+
+GraphPassId RenderGraphCompiler::addPass(GraphPassDesc desc) {
+	for (const GraphResourceAccess &access : desc.accesses)
+		assert(access.resource < _resources.size());
+	_passes.push_back(std::move(desc));
+	return static_cast<GraphPassId>(_passes.size() - 1);
+}
+
+void RenderGraphCompiler::addDependency(GraphPassId before, GraphPassId after) {
+	assert(before < _passes.size() && after < _passes.size());
+	_explicitDependencies.emplace_back(before, after);
+}
+
+const GraphResourceDesc &RenderGraphCompiler::getResource(GraphResourceId id) const {
+	assert(id < _resources.size());
+	return _resources[id];
+}
+
+const GraphPassDesc &RenderGraphCompiler::getPass(GraphPassId id) const {
+	assert(id < _passes.size());
+	return _passes[id];
+}
+
+size_t RenderGraphCompiler::getResourceCount() const {
+	return _resources.size();
+}
+
+size_t RenderGraphCompiler::getPassCount() const {
+	return _passes.size();
+}
+
+std::vector<RenderGraphCompiler::Edge> RenderGraphCompiler::buildEdges() const {
+	std::vector<Edge> edges;
+	std::vector<GraphPassId> lastWriters(_resources.size(), kInvalidGraphId);
+	std::vector<std::vector<GraphPassId>> readers(_resources.size());
+	auto addEdge = [&](GraphPassId from, GraphPassId to, bool isData) {
+		if (from != kInvalidGraphId && from != to)
+			edges.push_back({ from, to, isData });
+	};
+
+	// declaration order defines the versions of every resource
+	for (GraphPassId pass = 0; pass < _passes.size(); ++pass) {
+		for (const GraphResourceAccess &access : _passes[pass].accesses) {
+			GraphResourceId resource = access.resource;
+			addEdge(lastWriters[resource], pass, true);
+			if (!isGraphWriteUsage(access.usage)) {
+				readers[resource].push_back(pass);
+				continue;
+			}
+
+			// every write loads the previous content, a clear followed by a draw keeps the clear
+			for (GraphPassId reader : readers[resource])
+				addEdge(reader, pass, false);
+			readers[resource].clear();
+			lastWriters[resource] = pass;
+		}
+	}
+
+	for (auto &&[before, after] : _explicitDependencies)
+		addEdge(before, after, false);
+	return edges;
+}
+
+CompiledRenderGraph RenderGraphCompiler::compile() const {
+	CompiledRenderGraph result;
+	std::vector<Edge> edges = buildEdges();
+	size_t numPasses = _passes.size();
+
+	// culling: walk the data edges back from the passes whose results leave the graph
+	std::vector<bool> alive(numPasses, false);
+	std::vector<std::vector<GraphPassId>> producers(numPasses);
+	for (const Edge &edge : edges) {
+		if (edge.isData)
+			producers[edge.to].push_back(edge.from);
+	}
+	std::vector<GraphPassId> stack;
+	for (GraphPassId pass = 0; pass < numPasses; ++pass) {
+		bool isRoot = _passes[pass].hasSideEffect;
+		for (const GraphResourceAccess &access : _passes[pass].accesses)
+			isRoot |= _resources[access.resource].imported && isGraphWriteUsage(access.usage);
+		if (isRoot) {
+			alive[pass] = true;
+			stack.push_back(pass);
+		}
+	}
+	while (!stack.empty()) {
+		GraphPassId pass = stack.back();
+		stack.pop_back();
+		for (GraphPassId producer : producers[pass]) {
+			if (!alive[producer]) {
+				alive[producer] = true;
+				stack.push_back(producer);
+			}
+		}
+	}
+	for (GraphPassId pass = 0; pass < numPasses; ++pass) {
+		if (!alive[pass])
+			result.culledPasses.push_back(pass);
+	}
+
+	// Kahn, ties go to the earlier declared pass so an acyclic description keeps its order
+	std::vector<std::vector<GraphPassId>> successors(numPasses);
+	std::vector<std::vector<GraphPassId>> dependencies(numPasses);
+	std::vector<size_t> inDegree(numPasses, 0);
+	for (const Edge &edge : edges) {
+		if (!alive[edge.from] || !alive[edge.to])
+			continue;
+		auto &deps = dependencies[edge.to];
+		if (std::find(deps.begin(), deps.end(), edge.from) != deps.end())
+			continue;
+		deps.push_back(edge.from);
+		successors[edge.from].push_back(edge.to);
+		++inDegree[edge.to];
+	}
+
+	std::priority_queue<GraphPassId, std::vector<GraphPassId>, std::greater<>> ready;
+	size_t numAlive = 0;
+	for (GraphPassId pass = 0; pass < numPasses; ++pass) {
+		numAlive += alive[pass] ? 1 : 0;
+		if (alive[pass] && inDegree[pass] == 0)
+			ready.push(pass);
+	}
+	while (!ready.empty()) {
+		GraphPassId pass = ready.top();
+		ready.pop();
+		GraphCompiledPass compiledPass;
+		compiledPass.pass = pass;
+		compiledPass.dependencies = dependencies[pass];
+		std::sort(compiledPass.dependencies.begin(), compiledPass.dependencies.end());
+		result.schedule.push_back(std::move(compiledPass));
+		for (GraphPassId successor : successors[pass]) {
+			if (--inDegree[successor] == 0)
+				ready.push(successor);
+		}
+	}
+	if (result.schedule.size() != numAlive) {
+		result.error = "render graph has a dependency cycle between:";
+		for (GraphPassId pass = 0; pass < numPasses; ++pass) {
+			if (alive[pass] && inDegree[pass] > 0)
+				result.error += " " + _passes[pass].name;
+		}
+		result.schedule.clear();
+		return result;
+	}
+
+	// lifetimes
+	result.lifetimes.resize(_resources.size());
+	for (size_t index = 0; index < result.schedule.size(); ++index) {
+		for (const GraphResourceAccess &access : _passes[result.schedule[index].pass].accesses) {
+			GraphResourceLifetime &lifetime = result.lifetimes[access.resource];
+			lifetime.used = true;
+			lifetime.firstUse = std::min(lifetime.firstUse, index);
+			lifetime.lastUse = std::max(lifetime.lastUse, index);
+		}
+	}
+
+	// transitions, reads that follow each other share one barrier to the combined read state
+	auto getPassUsage = [&](GraphPassId pass, GraphResourceId resource, bool &isWrite) {
+		GraphResourceState state = GS::kCommon;
+		isWrite = false;
+		for (const GraphResourceAccess &access : _passes[pass].accesses) {
+			if (access.resource == resource) {
+				state |= getGraphResourceState(access.usage);
+				isWrite |= isGraphWriteUsage(access.usage);
+			}
+		}
+		return state;
+	};
+
+	result.passStates.resize(numPasses);
+	for (GraphPassId pass = 0; pass < numPasses; ++pass)
+		result.passStates[pass].resize(_passes[pass].accesses.size(), GS::kCommon);
+
+	std::vector<GraphResourceState> currentStates(_resources.size(), GS::kCommon);
+	std::vector<bool> initialized(_resources.size(), false);
+	for (GraphResourceId resource = 0; resource < _resources.size(); ++resource) {
+		if (_resources[resource].imported) {
+			currentStates[resource] = _resources[resource].initState;
+			initialized[resource] = true;
+		}
+	}
+
+	for (size_t index = 0; index < result.schedule.size(); ++index) {
+		GraphCompiledPass &compiledPass = result.schedule[index];
+		const GraphPassDesc &passDesc = _passes[compiledPass.pass];
+		std::vector<GraphResourceId> handled;
+		for (const GraphResourceAccess &access : passDesc.accesses) {
+			GraphResourceId resource = access.resource;
+			if (std::find(handled.begin(), handled.end(), resource) != handled.end())
+				continue;
+			handled.push_back(resource);
+
+			bool isWrite = false;
+			GraphResourceState desired = getPassUsage(compiledPass.pass, resource, isWrite);
+			if (!isWrite && isReadOnlyState(desired)) {
+				for (size_t next = index + 1; next < result.schedule.size(); ++next) {
+					bool nextIsWrite = false;
+					GraphResourceState nextState = getPassUsage(result.schedule[next].pass, resource, nextIsWrite);
+					if (nextIsWrite || (nextState != GS::kCommon && !isReadOnlyState(nextState)))
+						break;
+					desired |= nextState;
+				}
+			}
+
+			GraphResourceState &current = currentStates[resource];
+			bool covered = isReadOnlyState(current) && isReadOnlyState(desired) && (current & desired) == desired;
+			if (!initialized[resource]) {
+				current = desired;
+				initialized[resource] = true;
+			} else if (current != desired && !covered) {
+				compiledPass.barriers.push_back({ resource, current, desired });
+				current = desired;
+			}
+		}
+
+		for (size_t i = 0; i < passDesc.accesses.size(); ++i)
+			result.passStates[compiledPass.pass][i] = currentStates[passDesc.accesses[i].resource];
+	}
+
+	// aliasing: first fit of the transient resources, largest first, into one heap
+	std::vector<GraphResourceId> transients;
+	for (GraphResourceId resource = 0; resource < _resources.size(); ++resource) {
+		if (!_resources[resource].imported && result.lifetimes[resource].used && _resources[resource].sizeInBytes > 0) {
+			transients.push_back(resource);
+			result.transientMemory += _resources[resource].sizeInBytes;
+		}
+	}
+	std::stable_sort(transients.begin(), transients.end(), [&](GraphResourceId lhs, GraphResourceId rhs) {
+		return _resources[lhs].sizeInBytes > _resources[rhs].sizeInBytes;
+	});
+
+	auto alignUp = [](size_t value, size_t alignment) {
+		return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+	};
+	std::vector<GraphResourceId> placed;
+	for (GraphResourceId resource : transients) {
+		const GraphResourceDesc &desc = _resources[resource];
+		GraphResourceLifetime &lifetime = result.lifetimes[resource];
+		std::vector<GraphResourceId> liveTogether;
+		std::vector<size_t> candidates = { 0 };
+		for (GraphResourceId other : placed) {
+			const GraphResourceLifetime &otherLifetime = result.lifetimes[other];
+			if (otherLifetime.lastUse < lifetime.firstUse || otherLifetime.firstUse > lifetime.lastUse)
+				continue;
+			liveTogether.push_back(other);
+			candidates.push_back(alignUp(otherLifetime.heapOffset + _resources[other].sizeInBytes, desc.alignment));
+		}
+		std::sort(candidates.begin(), candidates.end());
+		for (size_t offset : candidates) {
+			bool overlap = false;
+			for (GraphResourceId other : liveTogether) {
+				size_t otherBegin = result.lifetimes[other].heapOffset;
+				size_t otherEnd = otherBegin + _resources[other].sizeInBytes;
+				overlap |= offset < otherEnd && otherBegin < offset + desc.sizeInBytes;
+			}
+			if (!overlap) {
+				lifetime.heapOffset = offset;
+				break;
+			}
+		}
+		result.heapSize = std::max(result.heapSize, lifetime.heapOffset + desc.sizeInBytes);
+		placed.push_back(resource);
+	}
+
+	// a resource taking over memory of one that died earlier needs an aliasing barrier at its first use
+	for (GraphResourceId resource : transients) {
+		const GraphResourceLifetime &lifetime = result.lifetimes[resource];
+		for (GraphResourceId other : transients) {
+			const GraphResourceLifetime &otherLifetime = result.lifetimes[other];
+			if (other == resource || otherLifetime.lastUse >= lifetime.firstUse)
+				continue;
+			size_t otherEnd = otherLifetime.heapOffset + _resources[other].sizeInBytes;
+			if (lifetime.heapOffset < otherEnd && otherLifetime.heapOffset < lifetime.heapOffset + _resources[resource].sizeInBytes)
+				result.schedule[lifetime.firstUse].aliasingBarriers.emplace_back(other, resource);
+		}
+	}
+	return result;
+}
+
+std::string RenderGraphCompiler::dump(const CompiledRenderGraph &compiled) const {
+	auto toMB = [](size_t size) {
+		return static_cast<double>(size) / (1024.0 * 1024.0);
+	};
+
+	std::string result;
+	if (!compiled) {
+		result += compiled.error;
+		result += '\n';
+		return result;
+	}
+
+	result += std::format("render graph: {} passes, {} scheduled, {} culled\n",
+		_passes.size(), compiled.schedule.size(), compiled.culledPasses.size());
+	for (size_t index = 0; index < compiled.schedule.size(); ++index) {
+		const GraphCompiledPass &compiledPass = compiled.schedule[index];
+		result += std::format("[{}] {}", index, _passes[compiledPass.pass].name);
+		if (!compiledPass.dependencies.empty()) {
+			result += " after";
+			for (GraphPassId dependency : compiledPass.dependencies)
+				result += " " + _passes[dependency].name;
+		}
+		result += '\n';
+		for (auto &&[before, after] : compiledPass.aliasingBarriers)
+			result += std::format("    alias {} -> {}\n", _resources[before].name, _resources[after].name);
+		for (const GraphBarrier &barrier : compiledPass.barriers) {
+			result += std::format("    {}: {} -> {}\n", _resources[barrier.resource].name,
+				graphResourceStateToString(barrier.before), graphResourceStateToString(barrier.after));
+		}
+	}
+
+	if (!compiled.culledPasses.empty()) {
+		result += "culled:";
+		for (GraphPassId pass : compiled.culledPasses)
+			result += " " + _passes[pass].name;
+		result += '\n';
+	}
+
+	result += "resources:\n";
+	for (GraphResourceId resource = 0; resource < _resources.size(); ++resource) {
+		const GraphResourceDesc &desc = _resources[resource];
+		const GraphResourceLifetime &lifetime = compiled.lifetimes[resource];
+		if (!lifetime.used) {
+			result += std::format("    {}: unused\n", desc.name);
+		} else if (desc.imported) {
+			result += std::format("    {}: imported, passes {}..{}\n", desc.name, lifetime.firstUse, lifetime.lastUse);
+		} else {
+			result += std::format("    {}: transient, passes {}..{}, offset {:.2f} MB, size {:.2f} MB\n", desc.name,
+				lifetime.firstUse, lifetime.lastUse, toMB(lifetime.heapOffset), toMB(desc.sizeInBytes));
+		}
+	}
+	result += std::format("memory: transient {:.2f} MB, aliased heap {:.2f} MB, saved {:.2f} MB\n",
+		toMB(compiled.transientMemory), toMB(compiled.heapSize), toMB(compiled.transientMemory - compiled.heapSize));
+	return result;
+}
+
+}
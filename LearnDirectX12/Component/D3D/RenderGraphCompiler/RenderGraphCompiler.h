@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace d3d {
+
+// same bits as D3D12_RESOURCE_STATES, so a state casts straight to the d3d12 enum
+using GraphResourceState = std::uint32_t;
+
+namespace GraphResourceStates {
+constexpr GraphResourceState kCommon				  = 0;
+constexpr GraphResourceState kRenderTarget			  = 0x4;
+constexpr GraphResourceState kUnorderedAccess		  = 0x8;
+constexpr GraphResourceState kDepthWrite			  = 0x10;
+constexpr GraphResourceState kDepthRead				  = 0x20;
+constexpr GraphResourceState kNonPixelShaderResource  = 0x40;
+constexpr GraphResourceState kPixelShaderResource	  = 0x80;
+constexpr GraphResourceState kCopyDest				  = 0x400;
+constexpr GraphResourceState kCopySource			  = 0x800;
+constexpr GraphResourceState kPresent				  = 0;
+}
+
+enum class GraphResourceUsage : std::uint8_t {
+	RenderTarget,
+	DepthWrite,
+	DepthRead,
+	PixelShaderRead,
+	NonPixelShaderRead,
+	UnorderedAccess,
+	CopySource,
+	CopyDest,
+	Present,
+};
+
+GraphResourceState getGraphResourceState(GraphResourceUsage usage);
+bool isGraphWriteUsage(GraphResourceUsage usage);
+std::string graphResourceStateToString(GraphResourceState state);
+
+using GraphResourceId = std::uint32_t;
+using GraphPassId = std::uint32_t;
+constexpr std::uint32_t kInvalidGraphId = 0xffffffff;
+
+struct GraphResourceDesc {
+	std::string name;
+	bool		imported = false;					// owned outside the graph (swap chain, history buffers), never aliased
+	GraphResourceState initState = GraphResourceStates::kCommon;	// imported only, transient resources start in their first state
+	size_t		sizeInBytes = 0;
+	size_t		alignment = 64 * 1024;
+};
+
+struct GraphResourceAccess {
+	GraphResourceId	   resource = kInvalidGraphId;
+	GraphResourceUsage usage = GraphResourceUsage::PixelShaderRead;
+};
+
+struct GraphPassDesc {
+	std::string name;
+	std::vector<GraphResourceAccess> accesses;
+	bool hasSideEffect = false;						// present, readback... never culled
+};
+
+struct GraphBarrier {
+	GraphResourceId	   resource = kInvalidGraphId;
+	GraphResourceState before = GraphResourceStates::kCommon;
+	GraphResourceState after = GraphResourceStates::kCommon;
+};
+
+struct GraphCompiledPass {
+	GraphPassId pass = kInvalidGraphId;
+	std::vector<GraphPassId> dependencies;			// passes that must run before this one
+	std::vector<std::pair<GraphResourceId, GraphResourceId>> aliasingBarriers;		// (before, after) sharing memory
+	std::vector<GraphBarrier> barriers;				// transitions issued before the pass executes
+};
+
+struct GraphResourceLifetime {
+	size_t firstUse = static_cast<size_t>(-1);		// index into the schedule
+	size_t lastUse = 0;
+	size_t heapOffset = 0;							// transient resources only
+	bool   used = false;
+};
+
+struct CompiledRenderGraph {
+	std::vector<GraphCompiledPass> schedule;
+	std::vector<GraphPassId> culledPasses;
+	std::vector<GraphResourceLifetime> lifetimes;	// indexed by GraphResourceId
+	std::vector<std::vector<GraphResourceState>> passStates;	// [pass][access], state while the pass runs
+	size_t transientMemory = 0;						// sum of every used transient resource
+	size_t heapSize = 0;							// after aliasing
+	std::string error;								// set when the dependencies form a cycle
+public:
+	explicit operator bool() const { return error.empty(); }
+	bool isCulled(GraphPassId pass) const;
+	// the state preExecuteState should be set to for an access of a pass
+	GraphResourceState getPassState(GraphPassId pass, size_t accessIndex) const;
+};
+
+// Compiles a render graph description without touching the GPU: builds the pass DAG from the
+// resource accesses in declaration order, culls passes that do not contribute to an imported
+// resource or a side effect, schedules the rest, derives the state transitions and packs the
+// transient resources into one heap by their lifetimes
+class RenderGraphCompiler {
+public:
+	GraphResourceId addResource(GraphResourceDesc desc);
+	GraphPassId addPass(GraphPassDesc desc);
+	// ordering without a resource between the passes
+	void addDependency(GraphPassId before, GraphPassId after);
+	const GraphResourceDesc &getResource(GraphResourceId id) const;
+	const GraphPassDesc &getPass(GraphPassId id) const;
+	size_t getResourceCount() const;
+	size_t getPassCount() const;
+
+	CompiledRenderGraph compile() const;
+	std::string dump(const CompiledRenderGraph &compiled) const;
+private:
+	struct Edge {
+		GraphPassId from;
+		GraphPassId to;
+		bool		isData;							// the later pass consumes what the earlier one wrote
+	};
+	std::vector<Edge> buildEdges() const;
+private:
+	std::vector<GraphResourceDesc> _resources;
+	std::vector<GraphPassDesc> _passes;
+	std::vector<std::pair<GraphPassId, GraphPassId>> _explicitDependencies;
+};
+
+}
@@ -0,0 +1,88 @@
+#include <vector>
+#include <string>
+#include "TestCheck.h"
+#include "D3D/RenderGraphCompiler/RenderGraphCompiler.h"
+
+using namespace d3d;
+
+void renderGraphCompilerTest() {
+	using Usage = GraphResourceUsage;
+	namespace GS = GraphResourceStates;
+	constexpr size_t kMB = 1024 * 1024;
+
+	// the TBDR frame plus a debug view nobody reads and a bloom that can reuse dead gbuffer memory
+	RenderGraphCompiler compiler;
+	GraphResourceId depth = compiler.addResource({ "Depth", true, GS::kDepthWrite });
+	GraphResourceId backBuffer = compiler.addResource({ "BackBuffer", true, GS::kPresent });
+	GraphResourceId gbuffer0 = compiler.addResource({ "GBuffer0", false, GS::kCommon, 8 * kMB });
+	GraphResourceId gbuffer1 = compiler.addResource({ "GBuffer1", false, GS::kCommon, 8 * kMB });
+	GraphResourceId gbuffer2 = compiler.addResource({ "GBuffer2", false, GS::kCommon, 8 * kMB });
+	GraphResourceId lighting = compiler.addResource({ "Lighting", false, GS::kCommon, 16 * kMB });
+	GraphResourceId debugView = compiler.addResource({ "DebugView", false, GS::kCommon, 4 * kMB });
+	GraphResourceId bloom = compiler.addResource({ "Bloom", false, GS::kCommon, 8 * kMB });
+
+	GraphPassId clearDs = compiler.addPass({ "ClearDs", { { depth, Usage::DepthWrite } } });
+	GraphPassId clearGBuffer = compiler.addPass({ "ClearGBuffer", {
+		{ gbuffer0, Usage::RenderTarget }, { gbuffer1, Usage::RenderTarget }, { gbuffer2, Usage::RenderTarget } } });
+	GraphPassId gbufferPass = compiler.addPass({ "GBuffer", {
+		{ gbuffer0, Usage::RenderTarget }, { gbuffer1, Usage::RenderTarget }, { gbuffer2, Usage::RenderTarget },
+		{ depth, Usage::DepthWrite } } });
+	GraphPassId debugPass = compiler.addPass({ "DebugView", { { gbuffer1, Usage::PixelShaderRead }, { debugView, Usage::RenderTarget } } });
+	GraphPassId lightingPass = compiler.addPass({ "Lighting", {
+		{ gbuffer0, Usage::NonPixelShaderRead }, { gbuffer1, Usage::NonPixelShaderRead }, { gbuffer2, Usage::NonPixelShaderRead },
+		{ depth, Usage::DepthRead }, { lighting, Usage::UnorderedAccess } } });
+	GraphPassId copyPass = compiler.addPass({ "CopyToBackBuffer", { { lighting, Usage::CopySource }, { backBuffer, Usage::CopyDest } } });
+	GraphPassId skyBoxPass = compiler.addPass({ "SkyBox", { { backBuffer, Usage::RenderTarget }, { depth, Usage::DepthRead } } });
+	GraphPassId bloomPass = compiler.addPass({ "Bloom", { { backBuffer, Usage::NonPixelShaderRead }, { bloom, Usage::UnorderedAccess } } });
+	GraphPassId compositePass = compiler.addPass({ "Composite", { { bloom, Usage::PixelShaderRead }, { backBuffer, Usage::RenderTarget } } });
+	GraphPassId presentPass = compiler.addPass({ "Present", { { backBuffer, Usage::Present } }, true });
+
+	CompiledRenderGraph compiled = compiler.compile();
+	TEST_CHECK(compiled);
+	TEST_CHECK(compiled.culledPasses == std::vector<GraphPassId>{ debugPass } && compiled.isCulled(debugPass));
+	std::vector<GraphPassId> order;
+	for (const GraphCompiledPass &compiledPass : compiled.schedule)
+		order.push_back(compiledPass.pass);
+	TEST_CHECK((order == std::vector<GraphPassId>{ clearDs, clearGBuffer, gbufferPass, lightingPass, copyPass, skyBoxPass, bloomPass, compositePass, presentPass }));
+	TEST_CHECK((compiled.schedule[2].dependencies == std::vector<GraphPassId>{ clearDs, clearGBuffer }));
+
+	// the clears create their targets in the right state, the gbuffer pass needs nothing
+	TEST_CHECK(compiled.schedule[0].barriers.empty() && compiled.schedule[1].barriers.empty() && compiled.schedule[2].barriers.empty());
+	const auto &lightingBarriers = compiled.schedule[3].barriers;
+	TEST_CHECK(lightingBarriers.size() == 4);
+	TEST_CHECK(lightingBarriers[0].resource == gbuffer0 && lightingBarriers[0].before == GS::kRenderTarget && lightingBarriers[0].after == GS::kNonPixelShaderResource);
+	TEST_CHECK(lightingBarriers[3].resource == depth && lightingBarriers[3].after == GS::kDepthRead);
+	// depth stays readable through the skybox without another barrier
+	TEST_CHECK(compiled.schedule[5].barriers.size() == 1 && compiled.schedule[5].barriers[0].resource == backBuffer);
+	TEST_CHECK(compiled.schedule[8].barriers.size() == 1 && compiled.schedule[8].barriers[0].after == GS::kPresent);
+	TEST_CHECK(compiled.getPassState(lightingPass, 3) == GS::kDepthRead);
+	TEST_CHECK(compiled.getPassState(copyPass, 1) == GS::kCopyDest);
+
+	// bloom lives after the lighting buffer died and takes its memory
+	TEST_CHECK(!compiled.lifetimes[debugView].used);
+	TEST_CHECK(compiled.lifetimes[gbuffer0].firstUse == 1 && compiled.lifetimes[gbuffer0].lastUse == 3);
+	TEST_CHECK(compiled.lifetimes[bloom].heapOffset == compiled.lifetimes[lighting].heapOffset);
+	TEST_CHECK(compiled.transientMemory == 48 * kMB && compiled.heapSize == 40 * kMB);
+	TEST_CHECK((compiled.schedule[6].aliasingBarriers == std::vector<std::pair<GraphResourceId, GraphResourceId>>{ { lighting, bloom } }));
+	for (GraphResourceId a : { gbuffer0, gbuffer1, gbuffer2, lighting }) {
+		for (GraphResourceId b : { gbuffer0, gbuffer1, gbuffer2, lighting }) {
+			if (a != b)
+				TEST_CHECK(compiled.lifetimes[a].heapOffset != compiled.lifetimes[b].heapOffset);
+		}
+	}
+
+	std::string text = compiler.dump(compiled);
+	TEST_CHECK(text.find("culled: DebugView") != std::string::npos);
+	TEST_CHECK(text.find("GBuffer0: RENDER_TARGET -> NON_PIXEL_SHADER_RESOURCE") != std::string::npos);
+	TEST_CHECK(text.find("saved 8.00 MB") != std::string::npos);
+
+	// an explicit dependency against the data flow is a cycle
+	compiler.addDependency(presentPass, clearDs);
+	CompiledRenderGraph cyclic = compiler.compile();
+	TEST_CHECK(!cyclic && cyclic.schedule.empty() && cyclic.error.find("ClearDs") != std::string::npos);
+}
+
+int main() {
+	renderGraphCompilerTest();
+	return 0;
+}
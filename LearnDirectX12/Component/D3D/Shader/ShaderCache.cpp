@@ -0,0 +1,352 @@
+#include "ShaderCache.h"
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <thread>
+#include <format>
+#include <JobSystem/JobSystem.h>
+
+namespace d3d {
+
+// bump when the key or the file layout changes, old cache entries are then ignored
+constexpr static std::uint32_t kShaderCacheVersion = 1;
+constexpr static std::uint32_t kShaderCacheMagic = 0x31434253;		// "SBC1"
+
+class FNV1aHasher {
+public:
+	void combine(const void *pData, size_t size) {
+		const auto *pBegin = static_cast<const std::uint8_t *>(pData);
+		for (size_t i = 0; i < size; ++i) {
+			_hash ^= pBegin[i];
+			_hash *= 0x100000001b3ull;
+		}
+	}
+	// the terminator keeps ("ab", "c") and ("a", "bc") apart
+	void combine(const std::string &str) {
+		combine(str.data(), str.size() + 1);
+	}
+	std::uint64_t get() const {
+		return _hash;
+	}
+private:
+	std::uint64_t _hash = 0xcbf29ce484222325ull;
+};
+
+static bool readTextFile(const std::string &fileName, std::string &content) {
+	std::ifstream input(fileName, std::ios::binary);
+	if (!input.is_open())
+		return false;
+	std::stringstream buffer;
+	buffer << input.rdbuf();
+	content = buffer.str();
+	return true;
+}
+
+ShaderCache::ShaderCache(CompileFunc compiler, std::string cacheDirectory)
+: _compiler(std::move(compiler)), _cacheDirectory(std::move(cacheDirectory))
+{
+	assert(_compiler != nullptr);
+}
+
+void ShaderCache::setIncludeLoader(IncludeLoader loader) {
+	_includeLoader = std::move(loader);
+}
+
+void ShaderCache::addIncludeDirectory(std::string directory) {
+	_includeDirectories.push_back(std::move(directory));
+}
+
+ShaderByteCode ShaderCache::compile(const ShaderCompileDesc &desc, std::string *pErrors) {
+	std::uint64_t hash = calcShaderHash(desc);
+	std::promise<ShaderByteCode> promise;
+	std::shared_future<ShaderByteCode> future;
+	bool isOwner = false;
+	{
+		std::lock_guard lock(_mutex);
+		auto iter = _memoryCache.find(hash);
+		if (iter != _memoryCache.end()) {
+			future = iter->second;
+		} else {
+			future = promise.get_future().share();
+			_memoryCache.emplace(hash, future);
+			isOwner = true;
+		}
+	}
+
+	// someone else compiles or already compiled this one
+	if (!isOwner) {
+		++_memoryHits;
+		ShaderByteCode pByteCode = future.get();
+		if (pByteCode == nullptr && pErrors != nullptr)
+			*pErrors = std::format("{}: compilation failed in another request\n", desc.fileName);
+		return pByteCode;
+	}
+
+	ShaderByteCode pByteCode = readDiskCache(hash);
+	if (pByteCode != nullptr) {
+		++_diskHits;
+	} else {
+		std::vector<std::uint8_t> byteCode;
+		std::string errors;
+		if (_compiler(desc, byteCode, errors)) {
+			pByteCode = std::make_shared<const std::vector<std::uint8_t>>(std::move(byteCode));
+			writeDiskCache(hash, *pByteCode);
+			++_numCompiled;
+		} else {
+			++_numFailed;
+			if (pErrors != nullptr)
+				*pErrors = std::move(errors);
+		}
+	}
+
+	// a failed compile is retried next time, the source is probably being edited
+	if (pByteCode == nullptr) {
+		std::lock_guard lock(_mutex);
+		_memoryCache.erase(hash);
+	}
+	promise.set_value(pByteCode);
+	return pByteCode;
+}
+
+std::vector<ShaderByteCode> ShaderCache::compileBatch(const std::vector<ShaderCompileDesc> &descs) {
+	std::vector<ShaderByteCode> result(descs.size());
+	com::parallelFor(0, descs.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			result[i] = compile(descs[i]);
+	});
+	return result;
+}
+
+void ShaderCache::clearMemoryCache() {
+	std::lock_guard lock(_mutex);
+	_memoryCache.clear();
+}
+
+ShaderCacheStats ShaderCache::getStats() const {
+	ShaderCacheStats stats;
+	stats.memoryHits = _memoryHits;
+	stats.diskHits = _diskHits;
+	stats.numCompiled = _numCompiled;
+	stats.numFailed = _numFailed;
+	return stats;
+}
+
+const std::string &ShaderCache::getCacheDirectory() const {
+	return _cacheDirectory;
+}
+
+std::uint64_t ShaderCache::calcShaderHash(const ShaderCompileDesc &desc) const {
+	FNV1aHasher hasher;
+	hasher.combine(&kShaderCacheVersion, sizeof(kShaderCacheVersion));
+	hasher.combine(desc.source);
+
+	std::uint64_t includeHash = 0;
+	std::vector<std::string> visited;
+	hashIncludes(desc.source, desc.fileName, visited, includeHash);
+	hasher.combine(&includeHash, sizeof(includeHash));
+
+	// sorted like calcMacroKey, the order the macros were declared in does not matter
+	std::vector<const ShaderMacro *> macros;
+	for (const ShaderMacro &macro : desc.macros)
+		macros.push_back(&macro);
+	std::sort(macros.begin(), macros.end(), [](const ShaderMacro *lhs, const ShaderMacro *rhs) {
+		return lhs->name < rhs->name;
+	});
+	for (const ShaderMacro *pMacro : macros) {
+		hasher.combine(pMacro->name);
+		hasher.combine(pMacro->definition);
+	}
+
+	hasher.combine(desc.entryPoint);
+	hasher.combine(desc.target);
+	hasher.combine(&desc.flags, sizeof(desc.flags));
+	return hasher.get();
+}
+
+std::vector<std::string> ShaderCache::findIncludes(const std::string &source) {
+	std::vector<std::string> result;
+	size_t lineBegin = 0;
+	while (lineBegin < source.size()) {
+		size_t lineEnd = source.find('\n', lineBegin);
+		if (lineEnd == std::string::npos)
+			lineEnd = source.size();
+
+		size_t pos = source.find_first_not_of(" \t", lineBegin);
+		if (pos < lineEnd && source[pos] == '#') {
+			pos = source.find_first_not_of(" \t", pos + 1);
+			if (pos < lineEnd && source.compare(pos, 7, "include") == 0) {
+				pos = source.find_first_of("\"<", pos + 7);
+				if (pos < lineEnd) {
+					char close = source[pos] == '"' ? '"' : '>';
+					size_t end = source.find(close, pos + 1);
+					if (end < lineEnd)
+						result.push_back(source.substr(pos + 1, end - pos - 1));
+				}
+			}
+		}
+		lineBegin = lineEnd + 1;
+	}
+	return result;
+}
+
+std::vector<ShaderListEntry> ShaderCache::parseShaderList(const std::string &luaText) {
+	// drop comments first, a brace inside one would break the nesting
+	std::string text;
+	std::istringstream input(luaText);
+	for (std::string line; std::getline(input, line);) {
+		if (size_t comment = line.find("--"); comment != std::string::npos)
+			line.resize(comment);
+		text += line;
+		text += '\n';
+	}
+
+	std::vector<ShaderListEntry> result;
+	static const std::regex pairRegex(R"re((\w+)\s*=\s*"([^"]*)")re");
+	size_t groupBegin = std::string::npos;
+	for (size_t i = 0; i < text.size(); ++i) {
+		if (text[i] == '{') {
+			groupBegin = i;
+		} else if (text[i] == '}' && groupBegin != std::string::npos) {
+			// innermost table, one shader
+			std::string group = text.substr(groupBegin + 1, i - groupBegin - 1);
+			groupBegin = std::string::npos;
+			ShaderListEntry entry;
+			for (std::sregex_iterator iter(group.begin(), group.end(), pairRegex), end; iter != end; ++iter) {
+				std::string key = (*iter)[1].str();
+				std::string value = (*iter)[2].str();
+				if (key == "file")
+					entry.file = value;
+				else if (std::string target = getStageTarget(key); !target.empty())
+					entry.stages.emplace_back(value, target);
+			}
+			if (!entry.file.empty())
+				result.push_back(std::move(entry));
+		}
+	}
+	return result;
+}
+
+std::string ShaderCache::getStageTarget(const std::string &stage) {
+	static const char *kStages[] = { "vs", "hs", "ds", "gs", "ps", "cs" };
+	for (const char *pStage : kStages) {
+		if (stage == pStage)
+			return stage + "_5_0";
+	}
+	return {};
+}
+
+bool ShaderCache::loadInclude(const std::string &includeName,
+	const std::string &includerName,
+	std::string &resolvedName,
+	std::string &content) const
+{
+	if (_includeLoader != nullptr)
+		return _includeLoader(includeName, includerName, resolvedName, content);
+
+	namespace fs = std::filesystem;
+	std::vector<fs::path> candidates;
+	candidates.push_back(fs::path(includerName).parent_path() / includeName);
+	for (const std::string &directory : _includeDirectories)
+		candidates.push_back(fs::path(directory) / includeName);
+
+	for (const fs::path &candidate : candidates) {
+		if (readTextFile(candidate.string(), content)) {
+			resolvedName = candidate.lexically_normal().string();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ShaderCache::hashIncludes(const std::string &source,
+	const std::string &fileName,
+	std::vector<std::string> &visited,
+	std::uint64_t &hash) const
+{
+	for (const std::string &includeName : findIncludes(source)) {
+		FNV1aHasher hasher;
+		hasher.combine(&hash, sizeof(hash));
+		hasher.combine(includeName);
+
+		std::string resolvedName;
+		std::string content;
+		// an include we can not see only contributes its name, the compiler reports it if it is really missing
+		if (loadInclude(includeName, fileName, resolvedName, content)) {
+			if (std::find(visited.begin(), visited.end(), resolvedName) != visited.end()) {
+				hash = hasher.get();
+				continue;
+			}
+			visited.push_back(resolvedName);
+			hasher.combine(content);
+			hash = hasher.get();
+			hashIncludes(content, resolvedName, visited, hash);
+		} else {
+			hash = hasher.get();
+		}
+	}
+}
+
+ShaderByteCode ShaderCache::readDiskCache(std::uint64_t hash) const {
+	if (_cacheDirectory.empty())
+		return nullptr;
+
+	std::ifstream input(getDiskCachePath(hash), std::ios::binary | std::ios::ate);
+	if (!input.is_open())
+		return nullptr;
+
+	size_t fileSize = static_cast<size_t>(input.tellg());
+	std::uint32_t magic = 0;
+	std::uint64_t fileHash = 0;
+	std::uint64_t size = 0;
+	constexpr size_t kHeaderSize = sizeof(magic) + sizeof(fileHash) + sizeof(size);
+	if (fileSize < kHeaderSize)
+		return nullptr;
+
+	input.seekg(0);
+	input.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+	input.read(reinterpret_cast<char *>(&fileHash), sizeof(fileHash));
+	input.read(reinterpret_cast<char *>(&size), sizeof(size));
+	// a truncated or foreign file is ignored and overwritten by the next compile
+	if (magic != kShaderCacheMagic || fileHash != hash || size != fileSize - kHeaderSize)
+		return nullptr;
+
+	std::vector<std::uint8_t> byteCode(static_cast<size_t>(size));
+	input.read(reinterpret_cast<char *>(byteCode.data()), byteCode.size());
+	if (!input)
+		return nullptr;
+	return std::make_shared<const std::vector<std::uint8_t>>(std::move(byteCode));
+}
+
+void ShaderCache::writeDiskCache(std::uint64_t hash, const std::vector<std::uint8_t> &byteCode) const {
+	if (_cacheDirectory.empty())
+		return;
+
+	std::error_code ec;
+	std::filesystem::create_directories(_cacheDirectory, ec);
+	std::string cachePath = getDiskCachePath(hash);
+	// write to a temporary file first, another thread or process may compile the same shader
+	std::string tempPath = std::format("{}.{}.tmp", cachePath, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	{
+		std::ofstream output(tempPath, std::ios::binary);
+		if (!output.is_open())
+			return;
+		std::uint64_t size = byteCode.size();
+		output.write(reinterpret_cast<const char *>(&kShaderCacheMagic), sizeof(kShaderCacheMagic));
+		output.write(reinterpret_cast<const char *>(&hash), sizeof(hash));
+		output.write(reinterpret_cast<const char *>(&size), sizeof(size));
+		output.write(reinterpret_cast<const char *>(byteCode.data()), byteCode.size());
+	}
+	std::filesystem::rename(tempPath, cachePath, ec);
+	if (ec)
+		std::filesystem::remove(tempPath, ec);
+}
+
+std::string ShaderCache::getDiskCachePath(std::uint64_t hash) const {
+	return std::format("{}{:016x}.cso", _cacheDirectory, hash);
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <Singleton/Singleton.hpp>
+
+namespace d3d {
+
+struct ShaderMacro {
+	std::string name;
+	std::string definition;
+};
+
+struct ShaderCompileDesc {
+	std::string fileName;						// source name, relative includes are resolved from its directory
+	std::string source;
+	std::vector<ShaderMacro> macros;			// order does not matter
+	std::string entryPoint;
+	std::string target;
+	std::uint32_t flags = 0;
+};
+
+using ShaderByteCode = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+struct ShaderCacheStats {
+	size_t memoryHits = 0;
+	size_t diskHits = 0;
+	size_t numCompiled = 0;
+	size_t numFailed = 0;
+};
+
+// one entry of shaderList in config/ShaderDefine.lua
+struct ShaderListEntry {
+	std::string file;
+	std::vector<std::pair<std::string, std::string>> stages;		// entry point, target
+};
+
+// Compile-once cache for shader byte code. The key hashes the source, every resolved include,
+// the macros, the entry point, the target and the flags. Results live in memory and on disk,
+// the compiler itself is injected so the cache runs without d3dcompiler
+class ShaderCache : public com::Singleton<ShaderCache> {
+public:
+	// fills byteCode, or errors and returns false
+	using CompileFunc = std::function<bool(const ShaderCompileDesc &desc, std::vector<std::uint8_t> &byteCode, std::string &errors)>;
+	// reads an included file, resolvedName identifies it for cycle detection
+	using IncludeLoader = std::function<bool(const std::string &includeName, const std::string &includerName, std::string &resolvedName, std::string &content)>;
+
+	explicit ShaderCache(CompileFunc compiler, std::string cacheDirectory = defaultCacheDirectory);
+	void setIncludeLoader(IncludeLoader loader);
+	// used by the default include loader after the directory of the including file
+	void addIncludeDirectory(std::string directory);
+
+	// nullptr when the compiler fails, failures are not cached
+	ShaderByteCode compile(const ShaderCompileDesc &desc, std::string *pErrors = nullptr);
+	// compiles on the shared JobSystem, the same shader requested twice is only compiled once
+	std::vector<ShaderByteCode> compileBatch(const std::vector<ShaderCompileDesc> &descs);
+	void clearMemoryCache();
+	ShaderCacheStats getStats() const;
+	const std::string &getCacheDirectory() const;
+	std::uint64_t calcShaderHash(const ShaderCompileDesc &desc) const;
+
+	static std::vector<std::string> findIncludes(const std::string &source);
+	// the flat form used by config/ShaderDefine.lua: { file = "...", vs = "VS", ps = "PS" }
+	static std::vector<ShaderListEntry> parseShaderList(const std::string &luaText);
+	static std::string getStageTarget(const std::string &stage);
+public:
+	static inline std::string defaultCacheDirectory = "resources/ShaderCache/";
+private:
+	bool loadInclude(const std::string &includeName, const std::string &includerName, std::string &resolvedName, std::string &content) const;
+	void hashIncludes(const std::string &source, const std::string &fileName, std::vector<std::string> &visited, std::uint64_t &hash) const;
+	ShaderByteCode readDiskCache(std::uint64_t hash) const;
+	void writeDiskCache(std::uint64_t hash, const std::vector<std::uint8_t> &byteCode) const;
+	std::string getDiskCachePath(std::uint64_t hash) const;
+private:
+	CompileFunc _compiler;
+	IncludeLoader _includeLoader;
+	std::string _cacheDirectory;
+	std::vector<std::string> _includeDirectories;
+	mutable std::mutex _mutex;
+	std::unordered_map<std::uint64_t, std::shared_future<ShaderByteCode>> _memoryCache;
+	std::atomic<size_t> _memoryHits = 0;
+	std::atomic<size_t> _diskHits = 0;
+	std::atomic<size_t> _numCompiled = 0;
+	std::atomic<size_t> _numFailed = 0;
+};
+
+}
@@ -0,0 +1,124 @@
+#include <vector>
+#include <string>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include "TestCheck.h"
+#include "D3D/Shader/ShaderCache.h"
+#include "JobSystem/JobSystem.h"
+
+using namespace d3d;
+
+void shaderCacheTest() {
+	std::string cacheDirectory = (std::filesystem::temp_directory_path() / "D3DTestShaderCache/").string();
+	std::filesystem::remove_all(cacheDirectory);
+	std::filesystem::create_directories(cacheDirectory);
+	auto writeText = [](const std::string &fileName, const std::string &text) {
+		std::ofstream output(fileName, std::ios::binary);
+		output << text;
+	};
+	writeText(cacheDirectory + "Common.hlsli", "#include \"Math.hlsli\"\nfloat4 common;\n");
+	writeText(cacheDirectory + "Math.hlsli", "#include \"Common.hlsli\"\nfloat pi;\n");
+
+	// the byte code is the key material itself, so a wrong key shows up as wrong byte code
+	std::atomic<int> compileCount = 0;
+	auto mockCompiler = [&](const ShaderCompileDesc &desc, std::vector<std::uint8_t> &byteCode, std::string &errors) {
+		++compileCount;
+		if (desc.source.find("error") != std::string::npos) {
+			errors = desc.fileName + ": syntax error";
+			return false;
+		}
+		std::string text = desc.source + desc.entryPoint + desc.target;
+		for (const ShaderMacro &macro : desc.macros)
+			text += macro.name + "=" + macro.definition;
+		byteCode.assign(text.begin(), text.end());
+		return true;
+	};
+
+	ShaderCache cache(mockCompiler, cacheDirectory + "bin/");
+	ShaderCompileDesc desc;
+	desc.fileName = cacheDirectory + "Shader.hlsl";
+	desc.source = "#include \"Common.hlsli\"\nfloat4 VS() : SV_Position { return common; }\n";
+	desc.macros = { { "USE_SHADOW", "1" }, { "NUM_LIGHTS", "4" } };
+	desc.entryPoint = "VS";
+	desc.target = "vs_5_0";
+
+	TEST_CHECK((ShaderCache::findIncludes(" # include <A.hlsli>\n//#include \"B\"\n#include \"C.hlsli\"") == std::vector<std::string>{ "A.hlsli", "C.hlsli" }));
+
+	ShaderByteCode pFirst = cache.compile(desc);
+	TEST_CHECK(pFirst != nullptr && compileCount == 1);
+	TEST_CHECK(cache.compile(desc) == pFirst && compileCount == 1 && cache.getStats().memoryHits == 1);
+
+	// the disk layer survives a cleared memory cache and a new instance
+	cache.clearMemoryCache();
+	ShaderByteCode pDisk = cache.compile(desc);
+	TEST_CHECK(*pDisk == *pFirst && compileCount == 1 && cache.getStats().diskHits == 1);
+	ShaderCache otherCache(mockCompiler, cacheDirectory + "bin/");
+	TEST_CHECK(*otherCache.compile(desc) == *pFirst && compileCount == 1);
+
+	// macro order does not matter, the value does
+	ShaderCompileDesc swapped = desc;
+	std::swap(swapped.macros[0], swapped.macros[1]);
+	TEST_CHECK(cache.calcShaderHash(swapped) == cache.calcShaderHash(desc));
+	ShaderCompileDesc changed = desc;
+	changed.macros[1].definition = "8";
+	TEST_CHECK(cache.calcShaderHash(changed) != cache.calcShaderHash(desc));
+	cache.compile(changed);
+	TEST_CHECK(compileCount == 2);
+
+	// editing a nested include recompiles, the include cycle is cut
+	std::uint64_t hash = cache.calcShaderHash(desc);
+	writeText(cacheDirectory + "Math.hlsli", "#include \"Common.hlsli\"\nfloat pi = 3.14;\n");
+	TEST_CHECK(cache.calcShaderHash(desc) != hash);
+	cache.compile(desc);
+	TEST_CHECK(compileCount == 3);
+
+	// failures report the errors and are not cached
+	ShaderCompileDesc broken = desc;
+	broken.source = "error";
+	std::string errors;
+	TEST_CHECK(cache.compile(broken, &errors) == nullptr && errors.find("syntax error") != std::string::npos);
+	TEST_CHECK(cache.compile(broken) == nullptr && compileCount == 5 && cache.getStats().numFailed == 2);
+
+	// a damaged file on disk is ignored
+	ShaderCompileDesc pixel = desc;
+	pixel.entryPoint = "PS";
+	pixel.target = "ps_5_0";
+	cache.compile(pixel);
+	TEST_CHECK(compileCount == 6);
+	for (const auto &entry : std::filesystem::directory_iterator(cacheDirectory + "bin/"))
+		std::filesystem::resize_file(entry.path(), 10);
+	cache.clearMemoryCache();
+	TEST_CHECK(*cache.compile(pixel) != std::vector<std::uint8_t>{} && compileCount == 7);
+
+	// a batch with duplicates compiles every shader once
+	std::vector<ShaderCompileDesc> batch;
+	for (int i = 0; i < 32; ++i) {
+		ShaderCompileDesc batchDesc = desc;
+		batchDesc.source = "// variant " + std::to_string(i % 8);
+		batch.push_back(std::move(batchDesc));
+	}
+	std::vector<ShaderByteCode> results = cache.compileBatch(batch);
+	TEST_CHECK(compileCount == 7 + 8);
+	for (size_t i = 0; i < results.size(); ++i)
+		TEST_CHECK(results[i] != nullptr && results[i] == results[i % 8]);
+
+	std::vector<ShaderListEntry> shaderList = ShaderCache::parseShaderList(
+		"-- shaders compiled at startup\n"
+		"shaderList = {\n"
+		"    { file = \"HlslShader/StaticModel.hlsl\", vs = \"VS\", ps = \"PS\" },\n"
+		"    { file = \"HlslShader/StaticModelShadow\", vs = \"VS\", ps = \"PS\" },\n"
+		"}\n"
+	);
+	TEST_CHECK(shaderList.size() == 2 && shaderList[1].file == "HlslShader/StaticModelShadow");
+	TEST_CHECK(shaderList[0].stages.size() == 2 && shaderList[0].stages[1].first == "PS" && shaderList[0].stages[1].second == "ps_5_0");
+	std::filesystem::remove_all(cacheDirectory);
+}
+
+int main() {
+	com::JobSystem::emplace(4);
+	shaderCacheTest();
+	com::JobSystem::destroy();
+	return 0;
+}
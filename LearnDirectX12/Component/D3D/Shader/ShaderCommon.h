@@ -73,6 +73,8 @@ struct CSMSubFrustum {
 	Math::float4x4 worldToLightMatrix;
 	Math::float3   center;
 	float		   lightPlane;
+	float		   texcoordScale;		// cascade resolution / shadow map size
+	Math::float3   subFrustumPad;
 };
 
 constexpr inline std::size_t kMaxShadowCascaded = 4;
@@ -0,0 +1,245 @@
+#include "ShaderPermutation.h"
+#include <cassert>
+#include <algorithm>
+#include <bit>
+#include <mutex>
+
+namespace d3d {
+
+ShaderPermutationKey::ShaderPermutationKey(std::uint16_t nameId) : _nameId(nameId) {
+	updateHash();
+}
+
+void ShaderPermutationKey::setMacro(std::uint16_t macroId, std::uint16_t valueId) {
+	assert(macroId < kMaxShaderMacros);
+	if (macroId >= kMaxShaderMacros)
+		return;
+	_macroMask |= std::uint64_t(1) << macroId;
+	_values[macroId] = valueId;
+	updateHash();
+}
+
+void ShaderPermutationKey::clearMacro(std::uint16_t macroId) {
+	assert(macroId < kMaxShaderMacros);
+	if (macroId >= kMaxShaderMacros)
+		return;
+	_macroMask &= ~(std::uint64_t(1) << macroId);
+	_values[macroId] = 0;
+	updateHash();
+}
+
+bool ShaderPermutationKey::hasMacro(std::uint16_t macroId) const {
+	return macroId < kMaxShaderMacros && (_macroMask & (std::uint64_t(1) << macroId)) != 0;
+}
+
+std::uint16_t ShaderPermutationKey::getValue(std::uint16_t macroId) const {
+	return hasMacro(macroId) ? _values[macroId] : kInvalidShaderId;
+}
+
+std::uint16_t ShaderPermutationKey::getNameId() const {
+	return _nameId;
+}
+
+std::uint64_t ShaderPermutationKey::getMacroMask() const {
+	return _macroMask;
+}
+
+size_t ShaderPermutationKey::getMacroCount() const {
+	return static_cast<size_t>(std::popcount(_macroMask));
+}
+
+std::uint64_t ShaderPermutationKey::getHash() const {
+	return _hash;
+}
+
+ShaderPermutationKey::operator bool() const {
+	return _nameId != kInvalidShaderId;
+}
+
+bool operator==(const ShaderPermutationKey &lhs, const ShaderPermutationKey &rhs) {
+	// values outside the mask are kept at zero, so the arrays compare directly
+	return lhs._hash == rhs._hash &&
+		lhs._nameId == rhs._nameId &&
+		lhs._macroMask == rhs._macroMask &&
+		lhs._values == rhs._values;
+}
+
+bool operator!=(const ShaderPermutationKey &lhs, const ShaderPermutationKey &rhs) {
+	return !(lhs == rhs);
+}
+
+void ShaderPermutationKey::updateHash() {
+	auto mix = [](std::uint64_t hash, std::uint64_t value) {
+		hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+		return hash;
+	};
+	std::uint64_t hash = mix(_nameId, _macroMask);
+	for (std::uint64_t mask = _macroMask; mask != 0; mask &= mask - 1)
+		hash = mix(hash, _values[std::countr_zero(mask)]);
+	_hash = hash;
+}
+
+std::uint16_t ShaderMacroTable::StringPool::find(std::string_view str) const {
+	auto iter = _ids.find(str);
+	return iter != _ids.end() ? iter->second : kInvalidShaderId;
+}
+
+std::uint16_t ShaderMacroTable::StringPool::insert(std::string_view str, size_t maxCount) {
+	if (std::uint16_t id = find(str); id != kInvalidShaderId)
+		return id;
+	if (_strings.size() >= maxCount) {
+		assert(false && "too many interned shader strings");
+		return kInvalidShaderId;
+	}
+	auto id = static_cast<std::uint16_t>(_strings.size());
+	auto iter = _ids.emplace(std::string(str), id).first;
+	// node based map, the key does not move on rehash
+	_strings.push_back(&iter->first);
+	return id;
+}
+
+std::string_view ShaderMacroTable::StringPool::get(std::uint16_t id) const {
+	return id < _strings.size() ? std::string_view(*_strings[id]) : std::string_view();
+}
+
+ShaderMacroTable::ShaderMacroTable() {
+	_values.insert("", kInvalidShaderId);
+}
+
+std::uint16_t ShaderMacroTable::internName(std::string_view name) {
+	return intern(_names, name, kInvalidShaderId);
+}
+
+std::uint16_t ShaderMacroTable::internMacro(std::string_view macro) {
+	return intern(_macros, macro, kMaxShaderMacros);
+}
+
+std::uint16_t ShaderMacroTable::internValue(std::string_view value) {
+	return intern(_values, value, kInvalidShaderId);
+}
+
+std::string_view ShaderMacroTable::getName(std::uint16_t id) const {
+	return lookup(_names, id);
+}
+
+std::string_view ShaderMacroTable::getMacro(std::uint16_t id) const {
+	return lookup(_macros, id);
+}
+
+std::string_view ShaderMacroTable::getValue(std::uint16_t id) const {
+	return lookup(_values, id);
+}
+
+ShaderPermutationKey ShaderMacroTable::makeKey(std::string_view name, const std::vector<MacroPair> &macros) {
+	ShaderPermutationKey key(internName(name));
+	for (const MacroPair &macro : macros) {
+		std::uint16_t macroId = internMacro(macro.key);
+		if (macroId == kInvalidShaderId)
+			return {};
+		key.setMacro(macroId, internValue(macro.value));
+	}
+	return key;
+}
+
+std::string ShaderMacroTable::toString(const ShaderPermutationKey &key) const {
+	if (!key)
+		return {};
+	auto macros = getMacros(key);
+	return buildMacroKeyString(getName(key.getNameId()), macros);
+}
+
+ShaderPermutationKey ShaderMacroTable::parse(std::string_view key) {
+	std::string_view name;
+	std::vector<std::pair<std::string_view, std::string_view>> macros;
+	if (!parseMacroKeyString(key, name, macros))
+		return {};
+
+	ShaderPermutationKey result(internName(name));
+	for (auto &&[macro, value] : macros) {
+		std::uint16_t macroId = internMacro(macro);
+		if (macroId == kInvalidShaderId)
+			return {};
+		result.setMacro(macroId, internValue(value));
+	}
+	return result;
+}
+
+std::vector<std::pair<std::string_view, std::string_view>> ShaderMacroTable::getMacros(const ShaderPermutationKey &key) const {
+	std::vector<std::pair<std::string_view, std::string_view>> result;
+	result.reserve(key.getMacroCount());
+	std::shared_lock lock(_mutex);
+	for (std::uint64_t mask = key.getMacroMask(); mask != 0; mask &= mask - 1) {
+		auto macroId = static_cast<std::uint16_t>(std::countr_zero(mask));
+		result.emplace_back(_macros.get(macroId), _values.get(key.getValue(macroId)));
+	}
+	return result;
+}
+
+std::uint16_t ShaderMacroTable::intern(StringPool &pool, std::string_view str, size_t maxCount) {
+	{
+		std::shared_lock lock(_mutex);
+		if (std::uint16_t id = pool.find(str); id != kInvalidShaderId)
+			return id;
+	}
+	std::unique_lock lock(_mutex);
+	return pool.insert(str, maxCount);
+}
+
+std::string_view ShaderMacroTable::lookup(const StringPool &pool, std::uint16_t id) const {
+	std::shared_lock lock(_mutex);
+	return pool.get(id);
+}
+
+std::string buildMacroKeyString(std::string_view name, std::vector<std::pair<std::string_view, std::string_view>> &macros) {
+	std::sort(macros.begin(), macros.end(), [](const auto &lhs, const auto &rhs) {
+		return lhs.first < rhs.first;
+	});
+
+	assert(std::adjacent_find(macros.begin(), macros.end(), [](const auto &lhs, const auto &rhs) {
+		return lhs.first == rhs.first;
+	}) == macros.end());
+
+	size_t length = name.size();
+	for (auto &&[macro, value] : macros)
+		length += macro.size() + value.size() + 4;
+
+	std::string result;
+	result.reserve(length);
+	result += name;
+	for (auto &&[macro, value] : macros) {
+		result += "_[";
+		result += macro;
+		if (!value.empty()) {
+			result += ',';
+			result += value;
+		}
+		result += ']';
+	}
+	return result;
+}
+
+bool parseMacroKeyString(std::string_view key, std::string_view &name, std::vector<std::pair<std::string_view, std::string_view>> &macros) {
+	size_t position = key.find("_[");
+	name = key.substr(0, position);
+	while (position != std::string_view::npos) {
+		size_t end = key.find(']', position);
+		if (end == std::string_view::npos)
+			return false;
+
+		std::string_view macro = key.substr(position + 2, end - position - 2);
+		size_t comma = macro.find(',');
+		if (comma != std::string_view::npos)
+			macros.emplace_back(macro.substr(0, comma), macro.substr(comma + 1));
+		else
+			macros.emplace_back(macro, std::string_view());
+
+		position = end + 1;
+		if (position == key.size())
+			break;
+		if (key.compare(position, 2, "_[") != 0)
+			return false;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <shared_mutex>
+#include <unordered_map>
+#include <Singleton/Singleton.hpp>
+
+namespace d3d {
+
+struct MacroPair {
+	std::string key;
+	std::string value;
+};
+
+constexpr size_t kMaxShaderMacros = 64;
+constexpr std::uint16_t kInvalidShaderId = 0xffff;
+
+// A shader name plus the macros it is compiled with, every string replaced by its id in a
+// ShaderMacroTable. Equality compares the precomputed hash and a fixed size payload, so looking
+// up a permutation never touches a string
+class ShaderPermutationKey {
+public:
+	ShaderPermutationKey() = default;
+	explicit ShaderPermutationKey(std::uint16_t nameId);
+	void setMacro(std::uint16_t macroId, std::uint16_t valueId);
+	void clearMacro(std::uint16_t macroId);
+	bool hasMacro(std::uint16_t macroId) const;
+	std::uint16_t getValue(std::uint16_t macroId) const;
+	std::uint16_t getNameId() const;
+	std::uint64_t getMacroMask() const;
+	size_t getMacroCount() const;
+	std::uint64_t getHash() const;
+	explicit operator bool() const;
+	friend bool operator==(const ShaderPermutationKey &lhs, const ShaderPermutationKey &rhs);
+	friend bool operator!=(const ShaderPermutationKey &lhs, const ShaderPermutationKey &rhs);
+private:
+	void updateHash();
+private:
+	std::uint16_t _nameId = kInvalidShaderId;
+	std::uint64_t _macroMask = 0;
+	std::array<std::uint16_t, kMaxShaderMacros> _values = {};		// value id of every macro in the mask, 0 otherwise
+	std::uint64_t _hash = 0;
+};
+
+struct ShaderPermutationKeyHasher {
+	size_t operator()(const ShaderPermutationKey &key) const noexcept {
+		return static_cast<size_t>(key.getHash());
+	}
+};
+
+// Interns shader names, macro names and macro values to small ids. Lookups of known strings take
+// a shared lock and do not allocate, ids stay valid for the lifetime of the table
+class ShaderMacroTable : public com::Singleton<ShaderMacroTable> {
+public:
+	ShaderMacroTable();
+	std::uint16_t internName(std::string_view name);
+	std::uint16_t internMacro(std::string_view macro);			// at most kMaxShaderMacros distinct macros
+	std::uint16_t internValue(std::string_view value);			// the empty value is always id 0
+	std::string_view getName(std::uint16_t id) const;
+	std::string_view getMacro(std::uint16_t id) const;
+	std::string_view getValue(std::uint16_t id) const;
+
+	// Macro is D3D_SHADER_MACRO or anything with Name/Definition, a null Name ends the array
+	template<typename Macro>
+	ShaderPermutationKey makeKey(std::string_view name, const Macro *pMacros, size_t size);
+	ShaderPermutationKey makeKey(std::string_view name, const std::vector<MacroPair> &macros);
+
+	// the string form of calcMacroKey: name_[MACRO,VALUE]_[MACRO] with macros sorted by name
+	std::string toString(const ShaderPermutationKey &key) const;
+	ShaderPermutationKey parse(std::string_view key);
+	std::vector<std::pair<std::string_view, std::string_view>> getMacros(const ShaderPermutationKey &key) const;
+private:
+	class StringPool {
+	public:
+		std::uint16_t find(std::string_view str) const;
+		std::uint16_t insert(std::string_view str, size_t maxCount);
+		std::string_view get(std::uint16_t id) const;
+	private:
+		struct TransparentHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view str) const noexcept {
+				return std::hash<std::string_view>{}(str);
+			}
+		};
+		std::unordered_map<std::string, std::uint16_t, TransparentHash, std::equal_to<>> _ids;
+		std::vector<const std::string *> _strings;
+	};
+	std::uint16_t intern(StringPool &pool, std::string_view str, size_t maxCount);
+	std::string_view lookup(const StringPool &pool, std::uint16_t id) const;
+private:
+	mutable std::shared_mutex _mutex;
+	StringPool _names;
+	StringPool _macros;
+	StringPool _values;
+};
+
+template<typename Macro>
+ShaderPermutationKey ShaderMacroTable::makeKey(std::string_view name, const Macro *pMacros, size_t size) {
+	ShaderPermutationKey key(internName(name));
+	for (size_t i = 0; i < size && pMacros != nullptr && pMacros[i].Name != nullptr; ++i) {
+		std::uint16_t macroId = internMacro(pMacros[i].Name);
+		if (macroId == kInvalidShaderId)
+			return {};
+		std::string_view definition = pMacros[i].Definition != nullptr ? pMacros[i].Definition : "";
+		key.setMacro(macroId, internValue(definition));
+	}
+	return key;
+}
+
+// builds name_[MACRO,VALUE]_[MACRO], macros are sorted in place
+std::string buildMacroKeyString(std::string_view name, std::vector<std::pair<std::string_view, std::string_view>> &macros);
+// the inverse of buildMacroKeyString, false when the key is malformed
+bool parseMacroKeyString(std::string_view key, std::string_view &name, std::vector<std::pair<std::string_view, std::string_view>> &macros);
+
+}
@@ -0,0 +1,69 @@
+#include <vector>
+#include <string>
+#include <atomic>
+#include <unordered_map>
+#include <thread>
+#include "TestCheck.h"
+#include "D3D/Shader/ShaderPermutation.h"
+
+using namespace d3d;
+
+void shaderPermutationTest() {
+	// stands in for D3D_SHADER_MACRO
+	struct Macro {
+		const char *Name;
+		const char *Definition;
+	};
+	ShaderMacroTable table;
+	Macro macros[] = { { "USE_SHADOW", "1" }, { "NUM_LIGHTS", "4" }, { "ALPHA_TEST", nullptr }, { nullptr, nullptr } };
+	Macro reordered[] = { { "ALPHA_TEST", "" }, { "USE_SHADOW", "1" }, { "NUM_LIGHTS", "4" } };
+	ShaderPermutationKey key = table.makeKey("StaticModel", macros, std::size(macros));
+	ShaderPermutationKey same = table.makeKey("StaticModel", reordered, std::size(reordered));
+	TEST_CHECK(key && key.getMacroCount() == 3);
+	TEST_CHECK(key == same && key.getHash() == same.getHash());
+	TEST_CHECK(table.internValue("") == 0 && key.getValue(table.internMacro("ALPHA_TEST")) == 0);
+
+	Macro otherValue[] = { { "USE_SHADOW", "1" }, { "NUM_LIGHTS", "8" }, { "ALPHA_TEST", nullptr } };
+	TEST_CHECK(table.makeKey("StaticModel", otherValue, std::size(otherValue)) != key);
+	TEST_CHECK(table.makeKey("StaticModelShadow", macros, std::size(macros)) != key);
+	ShaderPermutationKey fewer = key;
+	fewer.clearMacro(table.internMacro("ALPHA_TEST"));
+	TEST_CHECK(fewer != key && fewer.getMacroCount() == 2);
+	fewer.setMacro(table.internMacro("ALPHA_TEST"), 0);
+	TEST_CHECK(fewer == key);
+
+	// round trip through the calcMacroKey string form
+	std::string text = table.toString(key);
+	TEST_CHECK(text == "StaticModel_[ALPHA_TEST]_[NUM_LIGHTS,4]_[USE_SHADOW,1]");
+	TEST_CHECK(table.parse(text) == key);
+	TEST_CHECK(table.makeKey("StaticModel", std::vector<MacroPair>{ { "NUM_LIGHTS", "4" }, { "USE_SHADOW", "1" }, { "ALPHA_TEST", "" } }) == key);
+	TEST_CHECK(table.parse("Sky") == table.makeKey("Sky", std::vector<MacroPair>{}));
+	TEST_CHECK(!table.parse("Sky_[A,1") && !table.parse("Sky_[A]x"));
+
+	std::string_view name;
+	std::vector<std::pair<std::string_view, std::string_view>> parsed;
+	TEST_CHECK(parseMacroKeyString("Blur_[RADIUS,5]_[HORZ]", name, parsed));
+	TEST_CHECK(name == "Blur" && parsed.size() == 2 && parsed[0].second == "5" && parsed[1].first == "HORZ" && parsed[1].second.empty());
+
+	// usable as a hash map key across threads
+	std::unordered_map<ShaderPermutationKey, int, ShaderPermutationKeyHasher> permutations;
+	permutations[key] = 1;
+	std::vector<std::thread> threads;
+	std::atomic<int> found = 0;
+	for (int i = 0; i < 4; ++i) {
+		threads.emplace_back([&]() {
+			for (int j = 0; j < 1000; ++j) {
+				if (permutations.count(table.makeKey("StaticModel", reordered, std::size(reordered))) == 1)
+					++found;
+			}
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+	TEST_CHECK(found == 4000);
+}
+
+int main() {
+	shaderPermutationTest();
+	return 0;
+}
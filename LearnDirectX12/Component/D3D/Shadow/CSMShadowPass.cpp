@@ -1,11 +1,10 @@
 #include "CSMShadowPass.h"
-
-#include <iostream>
-
 #include "D3D/Tool/Camera.h"
+#include "D3D/Shadow/CascadeFitting.h"
 #include "Dx12lib/Texture/DepthStencilTexture.h"
-#include "GameTimer/GameTimer.h"
 #include "RenderGraph/Pass/SubPass.h"
+#include "Profiler/Profiler.h"
+#include "FrameArena/FrameArena.h"
 
 namespace d3d {
 
@@ -35,44 +34,111 @@ CSMShadowPass::CSMShadowPass(const std::string &name)
 }
 
 void CSMShadowPass::execute(dx12lib::DirectContextProxy pDirectCtx) {
+	PROFILE_ZONE("CSMShadowPass::execute");
 	assert(_finalized);
-		
-	pDirectCtx->setViewport(*customViewport);
-	pDirectCtx->setScissorRect(*customScissorRect);
 
+	auto iter = _subPasses.begin();
+	while (iter != _subPasses.end()) {
+		if (!(*iter)->valid())
+			iter = _subPasses.erase(iter);
+		else
+			++iter;
+	}
+
+	// every cascade culls every sub pass on the workers, a chunk only writes its own job list. The
+	// lists are members so they keep their capacity, the rest of the per frame lists use the frame arena
+	using SubPassPtr = std::remove_cvref_t<decltype(*_subPasses.begin())>;
+	com::FrameArena *pArena = com::FrameArena::get();
+	std::pmr::vector<std::pair<size_t, const SubPassPtr *>> tasks(pArena);
+	_pCullScheduler->clearTasks();
 	for (size_t i = 0; i < _numCascaded; ++i) {
-		const auto &dsv = _pShadowMapArray->getPlaneDSV(i);
-		pDirectCtx->setRenderTarget(dsv);
-		auto &boundingBox = _subFrustumItems[i].boundingBox;
-		auto iter = _subPasses.begin();
-		while (iter != _subPasses.end()) {
-			if (!(*iter)->valid()) {
-				iter = _subPasses.erase(iter);
+		for (const SubPassPtr &pSubPass : _subPasses) {
+			if (pSubPass->getJobCount() == 0)
 				continue;
-			}
 
-			auto &pSubPass = *iter;
-			if (pSubPass->getJobCount() == 0) {
-				++iter;
-				continue;
-			}
-
-			std::vector<rgph::Job> jobs;
-			jobs.reserve(pSubPass->getJobCount());
-			for (auto &job : pSubPass->getJobs()) {
-				if (boundingBox.contains(job.pGeometry->getWorldAABB()) != DX::ContainmentType::DISJOINT)
-					jobs.push_back(job);
-			}
-
-			pSubPass->bind(*pDirectCtx);
-			auto passCBufferShaderRegister = pSubPass->getPassCBufferShaderRegister();
-			auto pPassCb = _subFrustumPassCBuffers[i];
-			if (passCBufferShaderRegister.slot && !passCBufferShaderRegister.slot.isSampler())
-				pDirectCtx->setConstantBuffer(passCBufferShaderRegister, pPassCb);
-
-			pSubPass->execute(*pDirectCtx, jobs);
-			++iter;
+			const SubPassPtr *ppSubPass = &pSubPass;
+			RecordTaskDesc desc;
+			desc.name = "CascadeCull";
+			desc.jobCount = pSubPass->getJobCount();
+			desc.minJobsPerChunk = 256;
+			desc.record = [this, cascade = i, ppSubPass](size_t contextIndex, size_t jobBegin, size_t jobEnd) {
+				PROFILE_ZONE("CSMShadowPass::cull");
+				const auto &jobs = (*ppSubPass)->getJobs();
+				auto jobIter = std::next(jobs.begin(), jobBegin);
+				for (size_t j = jobBegin; j < jobEnd; ++j, ++jobIter) {
+					if (isVisibleInCascade(cascade, jobIter->pGeometry->getWorldAABB()))
+						_visibleJobs[contextIndex].push_back(*jobIter);
+				}
+			};
+			_pCullScheduler->addTask(std::move(desc));
+			tasks.emplace_back(i, ppSubPass);
+		}
+	}
+
+	RecordSchedule schedule = _pCullScheduler->plan();
+	_geometryIds.clear();
+	_stateTracker.resetChanges();
+	for (auto &visibleJobs : _visibleJobs)
+		visibleJobs.clear();
+	_visibleJobs.resize(schedule.chunks.size());
+	{
+		PROFILE_ZONE("CSMShadowPass::cullWait");
+		_cullStats = _pCullScheduler->execute(schedule, [](size_t, size_t, size_t) {});
+	}
+
+	// one context, so recording stays in cascade and sub pass order; the chunks of a task are adjacent
+	size_t currentCascade = static_cast<size_t>(-1);
+	std::pmr::vector<const rgph::Job *> jobs(pArena);
+	for (size_t chunk = 0; chunk < schedule.chunks.size();) {
+		size_t task = schedule.chunks[chunk].task;
+		jobs.clear();
+		for (; chunk < schedule.chunks.size() && schedule.chunks[chunk].task == task; ++chunk) {
+			for (const rgph::Job &job : _visibleJobs[chunk])
+				jobs.push_back(&job);
+		}
+
+		auto &&[cascade, ppSubPass] = tasks[task];
+		if (cascade != currentCascade) {
+			// a cascade with a lower resolution renders into the top left corner of its slice
+			auto resolution = _subFrustumItems[cascade].resolution;
+			D3D12_VIEWPORT viewport = {
+				0.f, 0.f,
+				static_cast<float>(resolution), static_cast<float>(resolution),
+				0.f, 1.f
+			};
+			D3D12_RECT rect = {
+				0, 0, static_cast<LONG>(resolution), static_cast<LONG>(resolution)
+			};
+			pDirectCtx->setRenderTarget(_pShadowMapArray->getPlaneDSV(cascade));
+			pDirectCtx->setViewport(viewport);
+			pDirectCtx->setScissorRect(rect);
+			currentCascade = cascade;
+		}
+
+		// depth only, so the order inside a cascade is free: group by geometry, the stable sort keeps the rest
+		_drawQueue.clear();
+		for (size_t j = 0; j < jobs.size(); ++j) {
+			std::uint32_t geometry = _geometryIds.getId(&*jobs[j]->pGeometry);
+			_drawQueue.push(DrawSortKey::make(0, 0, 0, geometry, 0.f), static_cast<std::uint32_t>(j));
+		}
+		_drawQueue.sort();
+
+		_sortedJobs.clear();
+		_stateTracker.reset();
+		for (const DrawItem &item : _drawQueue.getItems()) {
+			_stateTracker.setGeometry(DrawSortKey::getGeometry(item.key));
+			_stateTracker.draw();
+			_sortedJobs.push_back(*jobs[item.index]);
 		}
+
+		const SubPassPtr &pSubPass = *ppSubPass;
+		pSubPass->bind(*pDirectCtx);
+		auto passCBufferShaderRegister = pSubPass->getPassCBufferShaderRegister();
+		auto pPassCb = _subFrustumPassCBuffers[cascade];
+		if (passCBufferShaderRegister.slot && !passCBufferShaderRegister.slot.isSampler())
+			pDirectCtx->setConstantBuffer(passCBufferShaderRegister, pPassCb);
+
+		pSubPass->execute(*pDirectCtx, _sortedJobs);
 	}
 }
 
@@ -96,6 +162,37 @@ void CSMShadowPass::setLightPlane(float lightPlane) {
 	_lightPlane = lightPlane;
 }
 
+void CSMShadowPass::setShadowDistance(float shadowDistance) {
+	assert(shadowDistance >= 0.f);
+	_shadowDistance = shadowDistance;
+}
+
+void CSMShadowPass::setCascadeResolution(size_t cascade, size_t resolution) {
+	assert(cascade < kMaxNumCascaded);
+	assert(resolution <= _shadowMapSize && resolution != 1);
+	_cascadeResolutions[cascade] = resolution;
+}
+
+void CSMShadowPass::setCasterBounds(std::span<const TransformAABB> casters) {
+	_casterBounds.assign(casters.begin(), casters.end());
+}
+
+SplitTuning CSMShadowPass::tuneSplits(const DepthHistogram &histogram, const CameraBase *pCameraBase) {
+	const CameraCore &core = pCameraBase->getCore();
+	float tanHalfFovY = std::tan(core.getFovY() * 0.5f);
+	_splitTuner.update(histogram, _numCascaded, tanHalfFovY * core.getAspect(), tanHalfFovY);
+	const SplitTuning &tuning = _splitTuner.getTuning();
+	if (tuning.zFar > 0.f) {
+		_lambda = tuning.lambda;
+		_shadowDistance = tuning.zFar;
+	}
+	return tuning;
+}
+
+void CSMShadowPass::setSplitTuningThreshold(float threshold) {
+	_splitTuner.setThreshold(threshold);
+}
+
 auto CSMShadowPass::getShadowMapArray() const -> const std::shared_ptr<dx12lib::IDepthStencil2DArray> & {
 	return _pShadowMapArray;
 }
@@ -137,16 +234,30 @@ void CSMShadowPass::finalize(dx12lib::DirectContextProxy pDirectCtx) {
 		auto pPassCb = pDirectCtx->createFRConstantBuffer<d3d::CBPassType>();
 		pPassCb->setResourceName(std::format("SubFrustumPassCBuffer{}", i));
 		_subFrustumPassCBuffers.push_back(pPassCb);
+		_passStaging.addSlot<d3d::CBPassType>();
 	}
 
+	_pCullScheduler = std::make_unique<CommandRecordScheduler>();
 	_finalized = true;
 }
 
+const RecordStats &CSMShadowPass::getCullStats() const {
+	return _cullStats;
+}
+
+const DrawStateChanges &CSMShadowPass::getStateChanges() const {
+	return _stateTracker.getChanges();
+}
+
+const UploadStagingStats &CSMShadowPass::getPassUploadStats() const {
+	return _passStaging.getLastFrameStats();
+}
+
 static BoundingBox calcLightFrustum(const CameraBase *pCameraBase, Vector3 lightDir) {
 	BoundingFrustum frustum = pCameraBase->getViewSpaceFrustum();
 	Vector3 center(Vector3::identity());
 	Vector3 vMin(std::numeric_limits<float>::max());
-	Vector3 vMax(std::numeric_limits<float>::min());
+	Vector3 vMax(std::numeric_limits<float>::lowest());
 	for (auto &c : frustum.getCorners()) {
 		Vector3 p(c);
 		center += p;
@@ -164,133 +275,136 @@ static BoundingBox calcLightFrustum(const CameraBase *pCameraBase, Vector3 light
 	return boundingBox.transform(lightView);
 }
 
-BoundingBox CSMShadowPass::update(const CameraBase *pCameraBase, std::shared_ptr<com::GameTimer> pGameTimer, Vector3 lightDir) {
+void CSMShadowPass::updateCascades(const CameraBase *pCameraBase, Vector3 lightDir) {
+	fitCascades(pCameraBase, lightDir, _subFrustumItems);
+}
+
+void CSMShadowPass::fitCascades(const CameraBase *pCameraBase, Vector3 lightDir, std::vector<FrustumItem> &items) const {
+	PROFILE_ZONE("CSMShadowPass::fitCascades");
+	assert(_numCascaded < kMaxNumCascaded);
+	// the camera's far clip still bounds the shadows when its projection has no far plane
 	float zNear = pCameraBase->_nearClip;
 	float zFar = pCameraBase->_farClip;
-	float ratio = zFar / zNear;
-	_subFrustumItems.resize(_numCascaded);
-	for (size_t i = 1; i < _numCascaded; ++i) {
-		float si = static_cast<float>(i) / static_cast<float>(_numCascaded);
-		float cLog = (zNear * pow(ratio, si));
-		float cUni = (zNear + (zFar - zNear) * si);
-		float tNear = _lambda * cLog + (1.f - _lambda) * cUni;
-		float tFar = tNear * 1.005f;
-		_subFrustumItems[i].zNear = tNear;
-		_subFrustumItems[i-1].zFar = tFar;
+	if (_shadowDistance > 0.f)
+		zFar = std::clamp(_shadowDistance, zNear * 1.01f, zFar);
+
+	CascadeSplit splits[kMaxNumCascaded];
+	calcCascadeSplits(zNear, zFar, _lambda, _numCascaded, splits);
+
+	const CameraCore &core = pCameraBase->getCore();
+	CascadeCamera camera;
+	camera.eye = core.getEye();
+	camera.forward = core.getForward();
+	camera.tanHalfFovY = std::tan(core.getFovY() * 0.5f);
+	camera.tanHalfFovX = camera.tanHalfFovY * core.getAspect();
+
+	CascadeFitDesc desc;
+	desc.lightDir = lightDir.xyz;
+	desc.atlasSize = static_cast<std::uint32_t>(_shadowMapSize);
+	desc.kernelTexels = static_cast<std::uint32_t>(_pcfKernelSize);
+	desc.casters = _casterBounds;
+
+	items.resize(_numCascaded);
+	for (size_t i = 0; i < _numCascaded; ++i) {
+		FrustumItem &item = items[i];
+		item.zNear = splits[i].zNear;
+		item.zFar = splits[i].zFar;
+		item.resolution = (_cascadeResolutions[i] != 0) ? _cascadeResolutions[i] : _shadowMapSize;
+		desc.resolution = static_cast<std::uint32_t>(item.resolution);
+		if (_casterBounds.empty()) {
+			float3 center;
+			float radius;
+			calcCascadeSphere(camera, splits[i].zNear, splits[i].zFar, center, radius);
+			desc.casterExtension = _zMulti * radius;
+		}
+		item.fit = fitCascade(camera, splits[i], desc);
+
+		const CascadeFit &fit = item.fit;
+		Vector3 bMin(fit.bounds.center[0] - fit.bounds.extents[0],
+			fit.bounds.center[1] - fit.bounds.extents[1],
+			fit.bounds.center[2] - fit.bounds.extents[2]
+		);
+		Vector3 bMax(fit.bounds.center[0] + fit.bounds.extents[0],
+			fit.bounds.center[1] + fit.bounds.extents[1],
+			fit.bounds.center[2] + fit.bounds.extents[2]
+		);
+		item.boundingBox = BoundingBox(bMin, bMax);
 	}
-	_subFrustumItems[0].zNear = zNear;
-	_subFrustumItems[_numCascaded-1].zFar = zFar;
+}
+
+bool CSMShadowPass::isVisibleInCascade(size_t cascade, const BoundingBox &worldAABB) const {
+	assert(cascade < _subFrustumItems.size());
+	return _subFrustumItems[cascade].boundingBox.contains(worldAABB) != DX::ContainmentType::DISJOINT;
+}
+
+size_t CSMShadowPass::getNumCascaded() const {
+	return _numCascaded;
+}
+
+auto CSMShadowPass::getFrustumItem(size_t cascade) const -> const FrustumItem & {
+	assert(cascade < _subFrustumItems.size());
+	return _subFrustumItems[cascade];
+}
 
-	float fov = DX::XMConvertToRadians(pCameraBase->getFov());
-	float aspect = pCameraBase->getAspect();
-	Matrix4 cameraInvView = inverse(static_cast<Matrix4>(pCameraBase->getView()));
-	float2 renderTargetSize(_shadowMapSize);
-	float2 invRenderTargetSize(1.f / static_cast<float>(_shadowMapSize), 1.f / static_cast<float>(_shadowMapSize));
+BoundingBox CSMShadowPass::update(const CameraBase *pCameraBase, float totalTime, float deltaTime, Vector3 lightDir) {
+	PROFILE_ZONE("CSMShadowPass::update");
+	assert(_finalized);
+	updateCascades(pCameraBase, lightDir);
+	updatePassCBuffers(totalTime, deltaTime, lightDir);
+	return calcLightFrustum(pCameraBase, lightDir);
+}
+
+void CSMShadowPass::update(std::span<const FrustumItem> items, float totalTime, float deltaTime, Vector3 lightDir) {
+	PROFILE_ZONE("CSMShadowPass::update");
+	assert(_finalized && items.size() == _numCascaded);
+	_subFrustumItems.assign(items.begin(), items.end());
+	updatePassCBuffers(totalTime, deltaTime, lightDir);
+}
 
+void CSMShadowPass::updatePassCBuffers(float totalTime, float deltaTime, Vector3 lightDir) {
 	auto pLightSpaceMatrixVisitor = _pLightSpaceMatrix->visit();
 	std::memset(pLightSpaceMatrixVisitor.ptr(), 0, sizeof(*pLightSpaceMatrixVisitor));
 	pLightSpaceMatrixVisitor->lightSize = _lightSize;
 	pLightSpaceMatrixVisitor->lightDir = lightDir.xyz;
 
-	float invShadowMapSize = 1.f / static_cast<float>(_shadowMapSize);
-	float invZMulti = 1.f / _zMulti;
-	float zMulti = _zMulti;
-
-	Matrix4 worldToLightSpace = DX::XMMatrixLookToLH(
-		Vector3::zero(), 
-		lightDir, 
-		Vector3(0.f, 1.f, 0.f)
-	);
-	Matrix4 lightToWorldSpace = inverse(worldToLightSpace);
-
-
 	for (size_t i = 0; i < _numCascaded; ++i) {
-		FrustumItem &item = _subFrustumItems[i];
-		Matrix4 cameraSubProj = DX::XMMatrixPerspectiveFovLH(fov, aspect, item.zNear, item.zFar);
-		BoundingFrustum cameraSubViewSpaceFrustum(cameraSubProj);
-		cameraSubViewSpaceFrustum = cameraSubViewSpaceFrustum.transform(cameraInvView);
-		Vector3 center = Vector3::zero();
-		auto corners = cameraSubViewSpaceFrustum.getCorners();
-		for (auto &c : corners)
-			center += Vector3(c);
-		center /= 8.f;
-
-		///     Near    Far
-		///    0----1  4----5
-		///    |    |  |    |
-		///    |    |  |    |
-		///    3----2  7----6
-		float dis1 = length(Vector3(corners[7]) - Vector3(corners[5]));
-		float dis2 = length(Vector3(corners[7]) - Vector3(corners[0]));
-		float maxDis = std::max(dis1, dis2);
-		float disPerPix = maxDis / static_cast<float>(_shadowMapSize);
-
-		center = worldToLightSpace * Vector4(center, 1.f);
-		center = floor(center / disPerPix) * disPerPix;
-		center = lightToWorldSpace * Vector4(center, 1);
-
-		Matrix4 lightView = DX::XMMatrixLookAtLH(
-			center,
-			center + lightDir,
-			Vector3(0.f, 1.f, 0.f)
-		);
-
-		float orthoNear = std::numeric_limits<float>::max();
-		float orthoFar = std::numeric_limits<float>::min();
-		BoundingFrustum lightSpaceFrustum = cameraSubViewSpaceFrustum.transform(lightView);
-		for (auto &c : lightSpaceFrustum.getCorners()) {
-			orthoNear = std::min(orthoNear, c.z);
-			orthoFar = std::max(orthoFar, c.z);
-		}
-
-		orthoNear *= (orthoNear > 0.f) ? invZMulti : zMulti;
-		orthoFar  = std::max(zFar, orthoFar);
-		float extentDis = maxDis + static_cast<float>(_pcfKernelSize) * invShadowMapSize * 2.f;
-		Matrix4 lightProj = DX::XMMatrixOrthographicLH(
-			extentDis, extentDis,
-			orthoNear, orthoFar
-		);
-
-		Matrix4 invView = inverse(lightView);
-		Vector3 bMin(-extentDis * 0.5f, -extentDis * 0.5f, orthoNear);
-		Vector3 bMax(+extentDis * 0.5f, extentDis * 0.5f, orthoFar);
-		BoundingBox boundingBox(bMin, bMax);
-		item.boundingBox = boundingBox.transform(invView);
-
-		Matrix4 lightViewProj = lightProj * lightView;
-		Matrix4 scale = Matrix4::makeScale(0.5f, -0.5f, 1.f);
-		Matrix4 translation = Matrix4::makeTranslation(0.5f, 0.5f, 0.f);
-		Matrix4 ndcToTexcoord = translation * scale;
-		Matrix4 worldToShadowTexcoord = ndcToTexcoord * lightViewProj;
-
-		auto pShadowPassCb = _subFrustumPassCBuffers[i];
-		auto cbVisitor = pShadowPassCb->visit();
-		std::memset(cbVisitor.ptr(), 0, sizeof(*cbVisitor));
-		cbVisitor->view = float4x4(lightView);
-		cbVisitor->invView = float4x4(invView);
-		cbVisitor->proj = float4x4(lightProj);
-		cbVisitor->invProj = float4x4(inverse(lightProj));
-		cbVisitor->viewProj = float4x4(lightViewProj);
-		cbVisitor->invViewProj = float4x4(inverse(lightViewProj));
-		cbVisitor->eyePos = center.xyz;
-		cbVisitor->renderTargetSize = renderTargetSize;
-		cbVisitor->invRenderTargetSize = invRenderTargetSize;
-		cbVisitor->nearZ = orthoNear;
-		cbVisitor->farZ = orthoFar;
-		cbVisitor->totalTime = pGameTimer->getTotalTime();
-		cbVisitor->deltaTime = pGameTimer->getDeltaTime();
-
-		pLightSpaceMatrixVisitor->subFrustum[i].worldToLightMatrix = float4x4(worldToShadowTexcoord);
-		pLightSpaceMatrixVisitor->subFrustum[i].width = extentDis;
-		pLightSpaceMatrixVisitor->subFrustum[i].height = extentDis;
-		pLightSpaceMatrixVisitor->subFrustum[i].zNear = orthoNear;
-		pLightSpaceMatrixVisitor->subFrustum[i].zFar = orthoFar;
-		pLightSpaceMatrixVisitor->subFrustum[i].center = center.xyz;
-		Vector3 lightPlanePos = center + (orthoNear) * lightDir;
-		pLightSpaceMatrixVisitor->subFrustum[i].lightPlane = _lightPlane;
+		const FrustumItem &item = _subFrustumItems[i];
+		const CascadeFit &fit = item.fit;
+		auto resolution = static_cast<float>(item.resolution);
+		// built on the stack, the staging compares it with last frame's and copies the rows that moved
+		d3d::CBPassType passCb;
+		std::memset(&passCb, 0, sizeof(passCb));
+		passCb.view = fit.view;
+		passCb.invView = fit.invView;
+		passCb.proj = fit.proj;
+		passCb.invProj = fit.invProj;
+		passCb.viewProj = fit.viewProj;
+		passCb.invViewProj = fit.invViewProj;
+		passCb.eyePos = fit.origin;
+		passCb.renderTargetSize = float2(resolution);
+		passCb.invRenderTargetSize = float2(1.f / resolution);
+		passCb.nearZ = fit.zNear;
+		passCb.farZ = fit.zFar;
+		passCb.totalTime = totalTime;
+		passCb.deltaTime = deltaTime;
+		_passStaging.write(i, passCb);
+
+		CSMSubFrustum &subFrustum = pLightSpaceMatrixVisitor->subFrustum[i];
+		subFrustum.worldToLightMatrix = fit.shadowTexcoord;
+		subFrustum.width = 2.f * fit.halfWidth;
+		subFrustum.height = 2.f * fit.halfWidth;
+		subFrustum.zNear = fit.zNear;
+		subFrustum.zFar = fit.zFar;
+		subFrustum.center = fit.origin;
+		subFrustum.lightPlane = _lightPlane;
+		subFrustum.texcoordScale = fit.texcoordScale;
 	}
 
-	return calcLightFrustum(pCameraBase, lightDir);
+	// one flush per frame, each frame resource copy gets the rows it has not seen yet
+	_passStaging.flush([&](size_t slot, size_t offset, size_t size, const std::byte *pData) {
+		auto cbVisitor = _subFrustumPassCBuffers[slot]->visit();
+		std::memcpy(reinterpret_cast<std::byte *>(cbVisitor.ptr()) + offset, pData, size);
+	});
 }
 
 }
@@ -2,10 +2,10 @@
 #include <RenderGraph/Pass/RenderQueuePass.h>
 #include <Dx12lib/Context/ContextProxy.hpp>
 #include "D3D/Shader/ShaderCommon.h"
-
-namespace com {
-class GameTimer;
-}
+#include "D3D/RenderGraphCompiler/CommandRecordScheduler.h"
+#include "D3D/DrawQueue/DrawQueue.h"
+#include "D3D/UploadStaging/UploadStaging.h"
+#include "D3D/Shadow/CascadeFitting.h"
 
 namespace d3d {
 
@@ -25,37 +25,83 @@ public:
 	struct FrustumItem {
 		float zNear;
 		float zFar;
-		Math::BoundingBox boundingBox;
+		size_t resolution;
+		CascadeFit fit;
+		Math::BoundingBox boundingBox;					// world space, what the cascade culls against
 	};
 public:
 	CSMShadowPass(const std::string &name);
 	void execute(dx12lib::DirectContextProxy pDirectCtx) override;
 	void setNumCascaded(size_t n);
 	void setSplitLambda(float lambda);
+	// without caster bounds the ortho near plane moves this many cascade radii towards the light
 	void setZMulti(float zMulti);
 	void setLightSize(float lightSize);
 	void setLightPlane(float lightPlane);
+	// how far the cascades reach, 0 uses the camera's far clip
+	void setShadowDistance(float shadowDistance);
+	// texels the cascade renders along x and y, at most the shadow map size. 0 uses the whole slice
+	void setCascadeResolution(size_t cascade, size_t resolution);
+	// world bounds of the shadow casters, the depth range of every cascade reaches the closest one
+	// overlapping it. Empty falls back to setZMulti
+	void setCasterBounds(std::span<const TransformAABB> casters);
+	// lambda and shadow distance from last frame's view depth histogram through a SplitTuner, they
+	// only change when the gain is above the tuning threshold. Returns the applied tuning
+	SplitTuning tuneSplits(const DepthHistogram &histogram, const CameraBase *pCameraBase);
+	void setSplitTuningThreshold(float threshold);
 	auto getShadowMapArray() const -> const std::shared_ptr<dx12lib::IDepthStencil2DArray> &;
 	auto getShadowTypeCBuffer() const -> FRConstantBufferPtr<CBShadowType>;
 	auto getShadowMapFormat() const -> DXGI_FORMAT;
 	void finalize(dx12lib::DirectContextProxy pDirectCtx);
-	Math::BoundingBox update(const CameraBase *pCameraBase, std::shared_ptr<com::GameTimer> pGameTimer, Math::Vector3 lightDir);
+	// splits and light space fits of the cascades, only touches the CPU side so it runs before finalize
+	void updateCascades(const CameraBase *pCameraBase, Math::Vector3 lightDir);
+	// the same fits into items, the pass is not touched. With a frame pipeline the update stage fits
+	// the next frame while the render stage still executes this one
+	void fitCascades(const CameraBase *pCameraBase, Math::Vector3 lightDir, std::vector<FrustumItem> &items) const;
+	bool isVisibleInCascade(size_t cascade, const Math::BoundingBox &worldAABB) const;
+	size_t getNumCascaded() const;
+	const FrustumItem &getFrustumItem(size_t cascade) const;
+	// updateCascades, then the constant buffers. totalTime and deltaTime go into the cascade pass ones
+	Math::BoundingBox update(const CameraBase *pCameraBase, float totalTime, float deltaTime, Math::Vector3 lightDir);
+	// render stage side of fitCascades: takes its items, then the constant buffers
+	void update(std::span<const FrustumItem> items, float totalTime, float deltaTime, Math::Vector3 lightDir);
+	// per thread timing of the last cascade culling
+	const RecordStats &getCullStats() const;
+	// geometry changes of last frame's shadow draws after grouping by geometry, the sub pass
+	// still binds every job
+	const DrawStateChanges &getStateChanges() const;
+	// bytes the cascade pass constant buffers took last update
+	const UploadStagingStats &getPassUploadStats() const;
 
 	rgph::PassResourcePtr<dx12lib::IDepthStencil2DArray> pShadowMapArray;
+private:
+	void updatePassCBuffers(float totalTime, float deltaTime, Math::Vector3 lightDir);
 private:
 	bool _finalized = false;
 	float _lambda = 0.7f;
 	float _zMulti = 1.f;
 	float _lightSize = 3.f;
 	float _lightPlane = 500.f;
-	size_t _pcfKernelSize = 3;
+	float _shadowDistance = 0.f;
+	size_t _pcfKernelSize = 5;								// kMaxSampleKernel of the shader
+	size_t _cascadeResolutions[kMaxNumCascaded] = {};
 	size_t _numCascaded = 4;
 	size_t _shadowMapSize = 1024;
 	DXGI_FORMAT _shadowMapFormat = DXGI_FORMAT_D16_UNORM;
 	std::vector<FrustumItem> _subFrustumItems;
+	std::vector<TransformAABB> _casterBounds;
+	SplitTuner _splitTuner;
 	FRConstantBufferPtr<CBShadowType> _pLightSpaceMatrix;
 	std::shared_ptr<dx12lib::IDepthStencil2DArray> _pShadowMapArray;
 	std::vector<FRConstantBufferPtr<d3d::CBPassType>> _subFrustumPassCBuffers;
+	UploadStaging _passStaging { dx12lib::kFrameResourceCount };		// slot i is cascade i
+	std::unique_ptr<CommandRecordScheduler> _pCullScheduler;
+	RecordStats _cullStats;
+	std::vector<std::vector<rgph::Job>> _visibleJobs;		// per cull chunk
+	std::vector<rgph::Job> _sortedJobs;
+	DrawQueue _drawQueue;
+	DrawStateRegistry _geometryIds { (1u << DrawSortKey::kGeometryBits) - 1 };
+	DrawStateTracker _stateTracker;
 };
 
 }
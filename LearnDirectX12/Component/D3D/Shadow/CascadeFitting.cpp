@@ -0,0 +1,316 @@
+#include "CascadeFitting.h"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+namespace d3d {
+
+using namespace Math;
+
+void calcCascadeSplits(float zNear, float zFar, float lambda, size_t numCascades, CascadeSplit *pSplits,
+	float overlap)
+{
+	assert(numCascades > 0 && pSplits != nullptr);
+	assert(zNear > 0.f && zFar > zNear && std::isfinite(zFar));
+	assert(overlap >= 1.f);
+
+	float ratio = zFar / zNear;
+	pSplits[0].zNear = zNear;
+	for (size_t i = 1; i < numCascades; ++i) {
+		float si = static_cast<float>(i) / static_cast<float>(numCascades);
+		float cLog = zNear * std::pow(ratio, si);
+		float cUni = zNear + (zFar - zNear) * si;
+		float split = lambda * cLog + (1.f - lambda) * cUni;
+		pSplits[i].zNear = split;
+		pSplits[i - 1].zFar = std::min(split * overlap, zFar);
+	}
+	pSplits[numCascades - 1].zFar = zFar;
+}
+
+// distance of the sphere center along forward and the radius. The corners of a slice plane at z
+// are z * sqrt(1 + t2) from the eye; the center is where the near and far corners are equally
+// far, unless that lies past the far plane and the far corners alone decide
+static void calcSlice(float tanHalfFovX, float tanHalfFovY, float zNear, float zFar, float &distance, float &radius) {
+	float t2 = tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY;
+	distance = std::min(zFar, 0.5f * (zNear + zFar) * (1.f + t2));
+	float toFar = zFar - distance;
+	radius = std::sqrt(toFar * toFar + zFar * zFar * t2);
+}
+
+void calcCascadeSphere(const CascadeCamera &camera, float zNear, float zFar, float3 &center, float &radius) {
+	assert(zNear >= 0.f && zFar > zNear);
+	float distance;
+	calcSlice(camera.tanHalfFovX, camera.tanHalfFovY, zNear, zFar, distance, radius);
+	center = (Vector3(camera.eye) + Vector3(camera.forward) * distance).xyz;
+}
+
+CascadeFit fitCascade(const CascadeCamera &camera, const CascadeSplit &split, const CascadeFitDesc &desc) {
+	assert(desc.resolution > 2 * desc.kernelTexels && desc.resolution <= desc.atlasSize);
+	CascadeFit fit;
+	calcCascadeSphere(camera, split.zNear, split.zFar, fit.center, fit.radius);
+
+	// same basis as XMMatrixLookToLH, the up hint only changes for a vertical light
+	Vector3 lightForward = normalize(Vector3(desc.lightDir));
+	Vector3 upHint(0.f, 1.f, 0.f);
+	if (std::abs(lightForward.xyz.y) > 0.999f)
+		upHint = Vector3(0.f, 0.f, 1.f);
+	Vector3 lightRight = normalize(cross(upHint, lightForward));
+	Vector3 lightUp = cross(lightForward, lightRight);
+	float3 forward = lightForward.xyz;
+	float3 right = lightRight.xyz;
+	float3 up = lightUp.xyz;
+
+	// the kernel border is made of whole texels, so the sphere diameter spans resolution - 2 * kernel
+	auto resolution = static_cast<float>(desc.resolution);
+	fit.texelSize = 2.f * fit.radius / static_cast<float>(desc.resolution - 2 * desc.kernelTexels);
+	fit.halfWidth = 0.5f * fit.texelSize * resolution;
+	Vector3 center(fit.center);
+	float x = dot(center, lightRight);
+	float y = dot(center, lightUp);
+	float z = dot(center, lightForward);
+	if (desc.snapToTexel) {
+		x = std::floor(x / fit.texelSize) * fit.texelSize;
+		y = std::floor(y / fit.texelSize) * fit.texelSize;
+	}
+
+	// receivers live inside the sphere, casters between it and the light shadow them
+	float zNear = z - fit.radius;
+	float zFar = z + fit.radius;
+	if (desc.casters.empty())
+		zNear -= desc.casterExtension;
+	for (const TransformAABB &caster : desc.casters) {
+		Vector3 casterCenter(caster.center[0], caster.center[1], caster.center[2]);
+		float cx = dot(casterCenter, lightRight) - x;
+		float cy = dot(casterCenter, lightUp) - y;
+		float cz = dot(casterCenter, lightForward);
+		float ex = std::abs(right.x) * caster.extents[0] + std::abs(right.y) * caster.extents[1] + std::abs(right.z) * caster.extents[2];
+		float ey = std::abs(up.x) * caster.extents[0] + std::abs(up.y) * caster.extents[1] + std::abs(up.z) * caster.extents[2];
+		float ez = std::abs(forward.x) * caster.extents[0] + std::abs(forward.y) * caster.extents[1] + std::abs(forward.z) * caster.extents[2];
+		if (std::abs(cx) > fit.halfWidth + ex || std::abs(cy) > fit.halfWidth + ey || cz - ez > zFar)
+			continue;
+		zNear = std::min(zNear, cz - ez);
+	}
+	if (desc.snapToTexel) {
+		zNear = std::floor(zNear / fit.texelSize) * fit.texelSize;
+		zFar = std::ceil(zFar / fit.texelSize) * fit.texelSize;
+	}
+	fit.zNear = zNear;
+	fit.zFar = zFar;
+	fit.origin = (lightRight * x + lightUp * y).xyz;
+
+	Matrix4 view = DX::XMMATRIX(
+		right.x, up.x, forward.x, 0.f,
+		right.y, up.y, forward.y, 0.f,
+		right.z, up.z, forward.z, 0.f,
+		-x,		 -y,   0.f,		  1.f
+	);
+	Matrix4 invView = DX::XMMATRIX(
+		right.x,	  right.y,		right.z,	  0.f,
+		up.x,		  up.y,			up.z,		  0.f,
+		forward.x,	  forward.y,	forward.z,	  0.f,
+		fit.origin.x, fit.origin.y, fit.origin.z, 1.f
+	);
+	// XMMatrixOrthographicLH with width = height = 2 * halfWidth
+	float depthRange = zFar - zNear;
+	Matrix4 proj = DX::XMMATRIX(
+		1.f / fit.halfWidth, 0.f,				  0.f,				   0.f,
+		0.f,				 1.f / fit.halfWidth, 0.f,				   0.f,
+		0.f,				 0.f,				  1.f / depthRange,	   0.f,
+		0.f,				 0.f,				  -zNear / depthRange, 1.f
+	);
+	Matrix4 invProj = DX::XMMATRIX(
+		fit.halfWidth, 0.f,			  0.f,		  0.f,
+		0.f,		   fit.halfWidth, 0.f,		  0.f,
+		0.f,		   0.f,			  depthRange, 0.f,
+		0.f,		   0.f,			  zNear,	  1.f
+	);
+	// the view applies first
+	Matrix4 viewProj = proj * view;
+
+	// ndc -> uv of the cascade's corner of the atlas
+	fit.texcoordScale = resolution / static_cast<float>(desc.atlasSize);
+	float s = fit.texcoordScale;
+	Matrix4 ndcToTexcoord = Matrix4::makeTranslation(0.5f * s, 0.5f * s, 0.f) * Matrix4::makeScale(0.5f * s, -0.5f * s, 1.f);
+	fit.view = float4x4(view);
+	fit.invView = float4x4(invView);
+	fit.proj = float4x4(proj);
+	fit.invProj = float4x4(invProj);
+	fit.viewProj = float4x4(viewProj);
+	fit.invViewProj = float4x4(invView * invProj);
+	fit.shadowTexcoord = float4x4(ndcToTexcoord * viewProj);
+
+	TransformAABB lightBox;
+	lightBox.center[2] = 0.5f * (zNear + zFar);
+	lightBox.extents[0] = fit.halfWidth;
+	lightBox.extents[1] = fit.halfWidth;
+	lightBox.extents[2] = 0.5f * depthRange;
+	fit.bounds = transformAABB(lightBox, invView);
+	return fit;
+}
+
+DepthHistogram::DepthHistogram(float zNear, float zFar, size_t numBins)
+: zNear(zNear), zFar(zFar), bins(numBins, 0)
+{
+	assert(zNear > 0.f && zFar > zNear && numBins > 0);
+}
+
+void DepthHistogram::add(float z, std::uint32_t count) {
+	bins[getBin(z)] += count;
+}
+
+void DepthHistogram::clear() {
+	std::fill(bins.begin(), bins.end(), 0);
+}
+
+size_t DepthHistogram::getBin(float z) const {
+	assert(!bins.empty());
+	float t = std::log(std::max(z, zNear) / zNear) / std::log(zFar / zNear);
+	auto bin = static_cast<size_t>(std::max(t, 0.f) * static_cast<float>(bins.size()));
+	return std::min(bin, bins.size() - 1);
+}
+
+float DepthHistogram::getBinEdge(size_t bin) const {
+	float t = static_cast<float>(bin) / static_cast<float>(bins.size());
+	return zNear * std::pow(zFar / zNear, t);
+}
+
+std::uint64_t DepthHistogram::getTotal() const {
+	std::uint64_t total = 0;
+	for (std::uint32_t count : bins)
+		total += count;
+	return total;
+}
+
+float calcSplitError(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX, float tanHalfFovY,
+	float lambda, float zNear, float zFar)
+{
+	SplitErrorScratch scratch;
+	return calcSplitError(histogram, numCascades, tanHalfFovX, tanHalfFovY, lambda, zNear, zFar, scratch);
+}
+
+float calcSplitError(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX, float tanHalfFovY,
+	float lambda, float zNear, float zFar, SplitErrorScratch &scratch)
+{
+	assert(numCascades > 0);
+	std::vector<CascadeSplit> &splits = scratch.splits;
+	std::vector<float> &radii = scratch.radii;
+	splits.resize(numCascades);
+	radii.resize(numCascades);
+	calcCascadeSplits(zNear, zFar, lambda, numCascades, splits.data(), 1.f);
+	for (size_t i = 0; i < numCascades; ++i) {
+		float distance;
+		calcSlice(tanHalfFovX, tanHalfFovY, splits[i].zNear, splits[i].zFar, distance, radii[i]);
+	}
+
+	// texel size is proportional to the radius, the pixel footprint to the distance
+	double error = 0.0;
+	std::uint64_t numSamples = 0;
+	size_t cascade = 0;
+	for (size_t bin = 0; bin < histogram.bins.size(); ++bin) {
+		std::uint32_t count = histogram.bins[bin];
+		float z = std::sqrt(histogram.getBinEdge(bin) * histogram.getBinEdge(bin + 1));
+		if (count == 0 || z > zFar)
+			continue;
+		while (cascade + 1 < numCascades && z > splits[cascade].zFar)
+			++cascade;
+		error += static_cast<double>(count) * radii[cascade] / std::max(z, zNear);
+		numSamples += count;
+	}
+	return numSamples > 0 ? static_cast<float>(error / static_cast<double>(numSamples)) : 0.f;
+}
+
+SplitTuning tuneSplitLambda(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX,
+	float tanHalfFovY, float coverage)
+{
+	SplitErrorScratch scratch;
+	return tuneSplitLambda(histogram, numCascades, tanHalfFovX, tanHalfFovY, scratch, coverage);
+}
+
+SplitTuning tuneSplitLambda(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX,
+	float tanHalfFovY, SplitErrorScratch &scratch, float coverage)
+{
+	SplitTuning result;
+	std::uint64_t total = histogram.getTotal();
+	if (total == 0)
+		return result;
+
+	size_t firstBin = 0;
+	while (histogram.bins[firstBin] == 0)
+		++firstBin;
+	size_t lastBin = firstBin;
+	std::uint64_t sum = 0;
+	auto threshold = static_cast<std::uint64_t>(std::ceil(static_cast<double>(total) * coverage));
+	for (size_t bin = firstBin; bin < histogram.bins.size(); ++bin) {
+		sum += histogram.bins[bin];
+		lastBin = bin;
+		if (sum >= threshold)
+			break;
+	}
+	result.zFar = histogram.getBinEdge(lastBin + 1);
+
+	// coarse steps over [0, 1], then a finer pass around the best one
+	bool evaluated = false;
+	auto evaluate = [&](float lambda) {
+		float error = calcSplitError(histogram, numCascades, tanHalfFovX, tanHalfFovY, lambda, histogram.zNear, result.zFar, scratch);
+		if (!evaluated || error < result.error) {
+			evaluated = true;
+			result.error = error;
+			result.lambda = lambda;
+		}
+	};
+	for (int i = 0; i <= 20; ++i)
+		evaluate(static_cast<float>(i) * 0.05f);
+	float coarse = result.lambda;
+	for (int i = -4; i <= 4; ++i)
+		evaluate(std::clamp(coarse + static_cast<float>(i) * 0.01f, 0.f, 1.f));
+	return result;
+}
+
+SplitTuner::SplitTuner(float threshold) : _threshold(threshold) {
+	assert(threshold >= 0.f);
+}
+
+bool SplitTuner::update(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX, float tanHalfFovY) {
+	SplitTuning best = tuneSplitLambda(histogram, numCascades, tanHalfFovX, tanHalfFovY, _scratch);
+	if (best.zFar <= 0.f)
+		return false;
+	if (_tuning.zFar <= 0.f) {
+		_tuning = best;
+		return true;
+	}
+
+	bool changed = false;
+	float zFar = _tuning.zFar;
+	if (std::abs(best.zFar - zFar) > _threshold * zFar) {
+		zFar = best.zFar;
+		changed = true;
+	}
+	// the error only counts the samples up to zFar, so both lambdas are measured over the applied range
+	float bestError = best.error;
+	if (zFar != best.zFar)
+		bestError = calcSplitError(histogram, numCascades, tanHalfFovX, tanHalfFovY, best.lambda, histogram.zNear, zFar, _scratch);
+	float error = calcSplitError(histogram, numCascades, tanHalfFovX, tanHalfFovY, _tuning.lambda, histogram.zNear, zFar, _scratch);
+	if (bestError < error * (1.f - _threshold)) {
+		_tuning.lambda = best.lambda;
+		error = bestError;
+		changed = true;
+	}
+	_tuning.zFar = zFar;
+	_tuning.error = error;
+	return changed;
+}
+
+const SplitTuning &SplitTuner::getTuning() const {
+	return _tuning;
+}
+
+void SplitTuner::setThreshold(float threshold) {
+	assert(threshold >= 0.f);
+	_threshold = threshold;
+}
+
+void SplitTuner::reset() {
+	_tuning = SplitTuning();
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "D3D/Model/Transform/TransformHierarchy.h"
+
+namespace d3d {
+
+struct CascadeSplit {
+	float zNear;
+	float zFar;
+};
+
+// PSSM splits of [zNear, zFar] in view distance, lambda blends the logarithmic (1) and the uniform
+// (0) distribution. Every cascade but the last reaches overlap times past the next one's start so
+// the blend band between them is covered by both. zFar is the shadow distance, not necessarily the
+// camera's far clip: with an infinite projection there is none
+void calcCascadeSplits(float zNear, float zFar, float lambda, size_t numCascades, CascadeSplit *pSplits,
+	float overlap = 1.005f);
+
+// what the fitting needs from the camera, the frustum is symmetric around forward
+struct CascadeCamera {
+	Math::float3 eye;
+	Math::float3 forward;		// normalized
+	float tanHalfFovX;
+	float tanHalfFovY;
+};
+
+// smallest sphere around the frustum slice [zNear, zFar]. It only depends on the distances and the
+// fov, so rotating the camera does not change the radius and the texel size of the cascade stays put
+void calcCascadeSphere(const CascadeCamera &camera, float zNear, float zFar, Math::float3 &center, float &radius);
+
+struct CascadeFitDesc {
+	Math::float3 lightDir;					// direction the light travels, normalized
+	std::uint32_t resolution = 1024;		// texels the cascade covers along x and y
+	std::uint32_t atlasSize = 1024;			// texels of the shadow map slice, the cascade uses its top left corner
+	std::uint32_t kernelTexels = 0;			// filter reach, the fit keeps this many texels around the sphere
+	bool snapToTexel = true;
+	// world space bounds of the shadow casters. The ortho near plane moves to the closest caster
+	// overlapping the cascade, without casters it is the sphere's near side moved by casterExtension
+	std::span<const TransformAABB> casters;
+	float casterExtension = 0.f;
+};
+
+struct CascadeFit {
+	Math::float4x4 view;
+	Math::float4x4 invView;
+	Math::float4x4 proj;
+	Math::float4x4 invProj;
+	Math::float4x4 viewProj;
+	Math::float4x4 invViewProj;
+	Math::float4x4 shadowTexcoord;		// world -> atlas uv and depth
+	TransformAABB bounds;				// world space box of the ortho volume, what the casters are culled with
+	Math::float3 center;				// bounding sphere, world space
+	float radius;
+	Math::float3 origin;				// world position of the light view origin, z = 0 of the ortho range
+	float halfWidth;					// ortho half extent including the kernel border
+	float texelSize;					// world units per texel
+	float zNear;						// ortho range along lightDir
+	float zFar;
+	float texcoordScale;				// resolution / atlasSize
+};
+
+// Light view rotation from lightDir with a fixed up, the sphere center is snapped to whole texels
+// in that space so the texel grid stays fixed in the world while the camera moves. The depth
+// range covers the receivers inside the sphere and the casters that can shadow them, snapped to
+// texels as well
+CascadeFit fitCascade(const CascadeCamera &camera, const CascadeSplit &split, const CascadeFitDesc &desc);
+
+// view distance histogram of the visible pixels, bins spaced logarithmically over [zNear, zFar].
+// Usually a GPU reduction of the depth buffer read back a frame or two late
+struct DepthHistogram {
+	float zNear = 0.1f;
+	float zFar = 1000.f;
+	std::vector<std::uint32_t> bins;
+public:
+	DepthHistogram() = default;
+	DepthHistogram(float zNear, float zFar, size_t numBins);
+	void add(float z, std::uint32_t count = 1);
+	void clear();
+	size_t getBin(float z) const;
+	// distance at the lower edge of bin, bin == bins.size() gives zFar
+	float getBinEdge(size_t bin) const;
+	std::uint64_t getTotal() const;
+};
+
+struct SplitTuning {
+	float lambda = 0.5f;
+	float zFar = 0.f;			// where the coverage fraction of the samples is reached
+	float error = 0.f;			// sample weighted texel size over view distance, lower is sharper
+};
+
+// picks the split lambda that minimizes the histogram weighted shadow texel size relative to the
+// pixel footprint, which grows with the view distance. The splits start at histogram.zNear, the
+// camera's near clip like in CSMShadowPass, and end where the coverage fraction of the samples is
+// reached: the returned zFar is meant as the shadow distance. An empty histogram returns the defaults
+SplitTuning tuneSplitLambda(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX,
+	float tanHalfFovY, float coverage = 0.999f);
+// the same error for a given lambda and range, what tuneSplitLambda minimizes
+float calcSplitError(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX, float tanHalfFovY,
+	float lambda, float zNear, float zFar);
+
+// the splits and radii calcSplitError works on, kept by a caller that evaluates every frame
+struct SplitErrorScratch {
+	std::vector<CascadeSplit> splits;
+	std::vector<float> radii;
+};
+SplitTuning tuneSplitLambda(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX,
+	float tanHalfFovY, SplitErrorScratch &scratch, float coverage = 0.999f);
+float calcSplitError(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX, float tanHalfFovY,
+	float lambda, float zNear, float zFar, SplitErrorScratch &scratch);
+
+// tuneSplitLambda with hysteresis for a per frame caller. The applied shadow distance only moves when
+// the tuned one differs by more than threshold of it, the applied lambda only when the tuned one lowers
+// the error by more than threshold of it. Small changes of the histogram leave the splits where they
+// are instead of shimmering
+class SplitTuner {
+public:
+	explicit SplitTuner(float threshold = 0.05f);
+	// returns true when the applied tuning changed. An empty histogram keeps the last one
+	bool update(const DepthHistogram &histogram, size_t numCascades, float tanHalfFovX, float tanHalfFovY);
+	// zFar is 0 until a histogram had samples, error is the applied tuning's on the last histogram
+	const SplitTuning &getTuning() const;
+	void setThreshold(float threshold);
+	void reset();
+private:
+	float _threshold;
+	SplitTuning _tuning;
+	SplitErrorScratch _scratch;
+};
+
+}
@@ -0,0 +1,249 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <format>
+#include "TestCheck.h"
+#include "D3D/Tool/CameraCore.h"
+#include "D3D/Shadow/CascadeFitting.h"
+
+using namespace d3d;
+using namespace Math;
+
+void cascadeFittingTest() {
+	auto transformPoint = [](const float4x4 &matrix, const float3 &point, float result[3]) {
+		for (size_t j = 0; j < 3; ++j)
+			result[j] = point.x * matrix.m[0][j] + point.y * matrix.m[1][j] + point.z * matrix.m[2][j] + matrix.m[3][j];
+	};
+	// the product of a matrix and its inverse
+	auto isIdentity = [](const float4x4 &lhs, const float4x4 &rhs) {
+		float4x4 matrix(Matrix4(lhs) * Matrix4(rhs));
+		for (size_t row = 0; row < 4; ++row) {
+			for (size_t col = 0; col < 4; ++col) {
+				if (std::abs(matrix.m[row][col] - (row == col ? 1.f : 0.f)) > 1e-3f)
+					return false;
+			}
+		}
+		return true;
+	};
+	auto distance = [](const Vector3 &lhs, const Vector3 &rhs) -> float {
+		return length(lhs - rhs);
+	};
+	// distance between two texel fractions on the circle, 0.99 and 0.01 are close
+	auto fractDistance = [](float lhs, float rhs) {
+		float d = std::abs((lhs - std::floor(lhs)) - (rhs - std::floor(rhs)));
+		return std::min(d, 1.f - d);
+	};
+
+	CameraCore core;
+	core.setPerspective(1.0471976f, 16.f / 9.f, 0.1f, 500.f);
+	auto makeCamera = [&](const float3 &eye, float yaw) {
+		const float3 target(eye.x + std::sin(yaw), eye.y - 0.3f, eye.z + std::cos(yaw));
+		core.setLookAt(eye, target, float3(0.f, 1.f, 0.f));
+		core.update();
+		CascadeCamera camera;
+		camera.eye = core.getEye();
+		camera.forward = core.getForward();
+		camera.tanHalfFovY = std::tan(core.getFovY() * 0.5f);
+		camera.tanHalfFovX = camera.tanHalfFovY * core.getAspect();
+		return camera;
+	};
+
+	// the sphere holds every corner of the slice and keeps its radius when the camera turns
+	const float3 origin(0.f, 2.f, 0.f);
+	float firstRadius = 0.f;
+	for (float yaw = 0.f; yaw < 6.f; yaw += 0.7f) {
+		CascadeCamera camera = makeCamera(origin, yaw);
+		const float slices[][2] = { { 0.1f, 8.f }, { 8.f, 30.f }, { 30.f, 120.f }, { 120.f, 500.f } };
+		for (auto &&[zNear, zFar] : slices) {
+			float3 center;
+			float radius;
+			calcCascadeSphere(camera, zNear, zFar, center, radius);
+			for (float z : { zNear, zFar }) {
+				for (float sx : { -1.f, 1.f }) {
+					for (float sy : { -1.f, 1.f }) {
+						Vector3 corner = Vector3(camera.eye) + (Vector3(core.getForward()) + Vector3(core.getRight()) * (sx * camera.tanHalfFovX)
+							+ Vector3(core.getUp()) * (sy * camera.tanHalfFovY)) * z;
+						TEST_CHECK(distance(corner, Vector3(center)) <= radius * 1.0001f);
+					}
+				}
+			}
+			// tighter than the corner diagonal the cascades used to be sized with
+			float diagonal = 2.f * zFar * std::sqrt(1.f + camera.tanHalfFovX * camera.tanHalfFovX + camera.tanHalfFovY * camera.tanHalfFovY);
+			TEST_CHECK(2.f * radius < diagonal);
+		}
+		float3 center;
+		float radius;
+		calcCascadeSphere(camera, 0.1f, 8.f, center, radius);
+		if (firstRadius == 0.f)
+			firstRadius = radius;
+		TEST_CHECK(std::abs(radius - firstRadius) < 1e-4f * firstRadius);
+	}
+
+	CascadeFitDesc desc;
+	desc.lightDir = normalize(Vector3(0.3f, -0.9f, 0.4f)).xyz;
+	desc.kernelTexels = 5;
+	const CascadeSplit split = { 0.1f, 8.f };
+
+	// a fixed world point has to land on the same spot inside its texel every frame while the
+	// camera walks and turns, otherwise the shadow edges crawl
+	const float3 probe(1.3f, 0.2f, 3.7f);
+	auto measureShimmer = [&](bool snap, float &texelDrift) {
+		desc.snapToTexel = snap;
+		float maxDrift = 0.f;
+		float firstU = 0.f, firstV = 0.f, firstTexel = 0.f;
+		texelDrift = 0.f;
+		for (int frame = 0; frame < 120; ++frame) {
+			const float3 eye(0.0137f * frame, 2.f + 0.003f * frame, -0.0071f * frame);
+			CascadeFit fit = fitCascade(makeCamera(eye, 0.01f * frame), split, desc);
+			float uv[3];
+			transformPoint(fit.shadowTexcoord, probe, uv);
+			float u = uv[0] * static_cast<float>(desc.atlasSize);
+			float v = uv[1] * static_cast<float>(desc.atlasSize);
+			if (frame == 0) {
+				firstU = u;
+				firstV = v;
+				firstTexel = fit.texelSize;
+			}
+			maxDrift = std::max({ maxDrift, fractDistance(u, firstU), fractDistance(v, firstV) });
+			texelDrift = std::max(texelDrift, std::abs(fit.texelSize - firstTexel));
+		}
+		return maxDrift;
+	};
+	float snappedTexelDrift, freeTexelDrift;
+	float snappedDrift = measureShimmer(true, snappedTexelDrift);
+	float freeDrift = measureShimmer(false, freeTexelDrift);
+	std::cout << std::format("[CascadeFitting] texel phase drift over 120 frames: snapped {}, unsnapped {}",
+		snappedDrift, freeDrift) << std::endl;
+	TEST_CHECK(snappedDrift < 2e-3f && freeDrift > 0.1f);
+	TEST_CHECK(snappedTexelDrift < 1e-5f && freeTexelDrift < 1e-5f);
+
+	// analytic inverses, bounds around the sphere, the sphere inside the kernel border of the map
+	desc.snapToTexel = true;
+	CascadeCamera camera = makeCamera(origin, 0.4f);
+	CascadeFit fit = fitCascade(camera, split, desc);
+	TEST_CHECK(isIdentity(fit.view, fit.invView));
+	TEST_CHECK(isIdentity(fit.proj, fit.invProj));
+	TEST_CHECK(isIdentity(fit.viewProj, fit.invViewProj));
+	const float fitCenter[3] = { fit.center.x, fit.center.y, fit.center.z };
+	for (size_t i = 0; i < 3; ++i)
+		TEST_CHECK(std::abs(fitCenter[i] - fit.bounds.center[i]) <= fit.bounds.extents[i] - fit.radius + 1e-3f);
+	float kernel = static_cast<float>(desc.kernelTexels) / static_cast<float>(desc.resolution);
+	for (float sx : { -1.f, 1.f }) {
+		for (float sy : { -1.f, 1.f }) {
+			Vector3 corner = Vector3(camera.eye) + (Vector3(camera.forward) + Vector3(core.getRight()) * (sx * camera.tanHalfFovX)
+				+ Vector3(core.getUp()) * (sy * camera.tanHalfFovY)) * split.zFar;
+			float uv[3];
+			transformPoint(fit.shadowTexcoord, corner.xyz, uv);
+			TEST_CHECK(uv[0] > kernel && uv[0] < 1.f - kernel && uv[1] > kernel && uv[1] < 1.f - kernel);
+			TEST_CHECK(uv[2] > 0.f && uv[2] < 1.f);
+		}
+	}
+
+	// without casters the depth range is the sphere and a texel of rounding on each side
+	float receiverRange = fit.zFar - fit.zNear;
+	TEST_CHECK(receiverRange >= 2.f * fit.radius && receiverRange <= 2.f * fit.radius + 2.f * fit.texelSize + 1e-4f);
+	// a caster 100 units towards the light pulls the near plane out, one beside the map or one
+	// behind the receivers does not
+	Vector3 right(fit.invView.m[0][0], fit.invView.m[0][1], fit.invView.m[0][2]);
+	Vector3 toLight = -Vector3(desc.lightDir);
+	const Vector3 casterCenters[3] = {
+		Vector3(fit.center) + toLight * 100.f,
+		Vector3(fit.center) + toLight * 300.f + right * 1000.f,
+		Vector3(fit.center) - toLight * 500.f,
+	};
+	std::vector<TransformAABB> casters(3);
+	for (size_t c = 0; c < 3; ++c) {
+		float3 center = casterCenters[c].xyz;
+		casters[c].center[0] = center.x;
+		casters[c].center[1] = center.y;
+		casters[c].center[2] = center.z;
+		casters[c].extents[0] = casters[c].extents[1] = casters[c].extents[2] = 1.f;
+	}
+	desc.casters = std::span(casters).subspan(1);
+	CascadeFit ignored = fitCascade(camera, split, desc);
+	TEST_CHECK(ignored.zNear == fit.zNear && ignored.zFar == fit.zFar);
+	desc.casters = casters;
+	CascadeFit withCaster = fitCascade(camera, split, desc);
+	// the box reaches a little less than 2 towards the light along this direction
+	float casterNear = (fit.zFar + fit.zNear) * 0.5f - 100.f;
+	TEST_CHECK(withCaster.zNear < casterNear - 1.f && withCaster.zNear > casterNear - 2.f - 2.f * fit.texelSize);
+	TEST_CHECK(withCaster.zFar == fit.zFar);
+	desc.casters = {};
+	desc.casterExtension = 50.f;
+	TEST_CHECK(fitCascade(camera, split, desc).zNear < fit.zNear - 49.f);
+	desc.casterExtension = 0.f;
+
+	// a lower resolution cascade takes the top left of the map, the texels get bigger
+	desc.resolution = 512;
+	CascadeFit half = fitCascade(camera, split, desc);
+	TEST_CHECK(half.texcoordScale == 0.5f);
+	TEST_CHECK(std::abs(half.texelSize - 2.f * fit.radius / 502.f) < 1e-5f);
+	float uv[3];
+	transformPoint(half.shadowTexcoord, half.center, uv);
+	TEST_CHECK(std::abs(uv[0] - 0.25f) < 0.01f && std::abs(uv[1] - 0.25f) < 0.01f);
+	desc.resolution = 1024;
+
+	// split tuning from a view depth histogram
+	DepthHistogram histogram(0.1f, 500.f, 256);
+	TEST_CHECK(histogram.getBinEdge(0) == 0.1f && std::abs(histogram.getBinEdge(256) - 500.f) < 1e-2f);
+	for (size_t bin : { 0, 17, 100, 255 })
+		TEST_CHECK(histogram.getBin(histogram.getBinEdge(bin) * 1.001f) == bin);
+	TEST_CHECK(histogram.getBin(0.01f) == 0 && histogram.getBin(1e5f) == 255);
+	SplitTuning empty = tuneSplitLambda(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY);
+	TEST_CHECK(empty.lambda == 0.5f && empty.zFar == 0.f);
+
+	// an indoor like scene: most pixels close, a few through a window out to 150
+	for (int i = 0; i < 10000; ++i)
+		histogram.add(0.5f + 15.f * static_cast<float>(i) / 10000.f);
+	histogram.add(150.f, 5);
+	SplitTuning close = tuneSplitLambda(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY);
+	TEST_CHECK(close.zFar < 25.f);
+	for (float lambda : { 0.f, 0.25f, 0.5f, 0.75f, 1.f }) {
+		float error = calcSplitError(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY, lambda, histogram.zNear, close.zFar);
+		TEST_CHECK(close.error <= error + 1e-6f);
+	}
+	// a terrain: pixels spread evenly in distance up to 400
+	histogram.clear();
+	TEST_CHECK(histogram.getTotal() == 0);
+	for (int i = 0; i < 10000; ++i)
+		histogram.add(1.f + 399.f * static_cast<float>(i) / 10000.f);
+	SplitTuning open = tuneSplitLambda(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY);
+	TEST_CHECK(open.zFar > 390.f);
+	for (float lambda : { 0.f, 0.25f, 0.5f, 0.75f, 1.f }) {
+		float error = calcSplitError(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY, lambda, histogram.zNear, open.zFar);
+		TEST_CHECK(open.error <= error + 1e-6f);
+	}
+	// the tuned shadow distance against the camera's far clip with the default lambda
+	float closeDefault = calcSplitError(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY, 0.7f, histogram.zNear, 500.f);
+	TEST_CHECK(open.error < closeDefault);
+
+	// the tuner keeps the applied splits while the histogram only wobbles
+	SplitTuner tuner;
+	TEST_CHECK(tuner.update(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY));
+	TEST_CHECK(tuner.getTuning().lambda == open.lambda && tuner.getTuning().zFar == open.zFar);
+	for (int i = 0; i < 100; ++i)
+		histogram.add(20.f + 2.f * static_cast<float>(i));
+	TEST_CHECK(!tuner.update(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY));
+	TEST_CHECK(tuner.getTuning().lambda == open.lambda && tuner.getTuning().zFar == open.zFar);
+	SplitTuning kept = tuner.getTuning();
+	DepthHistogram emptyHistogram(0.1f, 1000.f, 256);
+	TEST_CHECK(!tuner.update(emptyHistogram, 4, camera.tanHalfFovX, camera.tanHalfFovY));
+	TEST_CHECK(tuner.getTuning().lambda == kept.lambda && tuner.getTuning().zFar == kept.zFar);
+	// walking indoors is a real change
+	histogram.clear();
+	for (int i = 0; i < 10000; ++i)
+		histogram.add(0.5f + 15.f * static_cast<float>(i) / 10000.f);
+	histogram.add(150.f, 5);
+	TEST_CHECK(tuner.update(histogram, 4, camera.tanHalfFovX, camera.tanHalfFovY));
+	TEST_CHECK(tuner.getTuning().zFar == close.zFar);
+	TEST_CHECK(tuner.getTuning().error <= close.error * 1.05f + 1e-6f);
+
+	std::cout << std::format("[CascadeFitting] tuned lambda close {} (shadow distance {}), open {} (shadow distance {})",
+		close.lambda, close.zFar, open.lambda, open.zFar) << std::endl;
+}
+
+int main() {
+	cascadeFittingTest();
+	return 0;
+}
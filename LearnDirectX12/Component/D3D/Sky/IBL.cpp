@@ -11,6 +11,8 @@
 #include <dx12lib/Buffer/BufferStd.h>
 
 #include "D3D/d3dutil.h"
+#include "D3D/Sky/SHProjection.h"
+#include "D3D/Sky/IBLBaker.h"
 #include "D3D/Model/RenderItem/VertexDataSemantic.h"
 #include "D3D/Shader/ShaderCommon.h"
 #include "Dx12lib/Texture/Texture.h"
@@ -23,6 +25,10 @@ namespace d3d {
 IBL::IBL(dx12lib::DirectContextProxy pComputeCtx, const std::string &fileName) {
 	std::memset(&_irradianceMapSH3, 0, sizeof(_irradianceMapSH3));
 
+	// results of IBLBakeTool (default settings), nothing has to be computed at startup
+	if (IBLBakeFiles bakedFiles = IBLBaker().findCached(fileName); bakedFiles && loadBakedFiles(pComputeCtx, bakedFiles))
+		return;
+
 	std::wstring wcharFileName = std::to_wstring(fileName);
 	std::wstring_view suffix = L".hdr";
 	if (auto iter = wcharFileName.find(suffix); iter != std::wstring::npos)
@@ -35,9 +41,11 @@ IBL::IBL(dx12lib::DirectContextProxy pComputeCtx, const std::string &fileName) {
 	buildPanoToCubeMapPSO(pComputeCtx->getDevice());
 	buildEnvMap(pComputeCtx, pPannoEnvMap);
 
-	// build irradiance map spherical harmonics
-	buildConvolutionIrradiancePSO(pComputeCtx->getDevice());
-	buildConvolutionIrradianceMap(pComputeCtx, pPannoEnvMap);
+	// build irradiance map spherical harmonics, on the CPU when the source hdr is available
+	if (!buildIrradianceMapSH3(fileName)) {
+		buildConvolutionIrradiancePSO(pComputeCtx->getDevice());
+		buildConvolutionIrradianceMap(pComputeCtx, pPannoEnvMap);
+	}
 
 	buildPerFilterEnvPSO(pComputeCtx->getDevice());
 	buildPerFilterEnvMap(pComputeCtx);
@@ -197,6 +205,51 @@ void IBL::buildConvolutionIrradianceMap(dx12lib::ComputeContextProxy pComputeCtx
 	pComputeCtx->trackResource(std::move(pReadBack));
 }
 
+bool IBL::buildIrradianceMapSH3(const std::string &fileName) {
+	int width = 0;
+	int height = 0;
+	int channel = 0;
+	float *pPixels = stbi_loadf(fileName.c_str(), &width, &height, &channel, 3);
+	if (pPixels == nullptr)
+		return false;
+
+	SHCoefficients radianceSH = projectEquirectToSH(pPixels, width, height, 3, 3);
+	stbi_image_free(pPixels);
+	setIrradianceSH(radianceSH);
+	return true;
+}
+
+bool IBL::loadBakedFiles(dx12lib::DirectContextProxy pComputeCtx, const IBLBakeFiles &files) {
+	SHCoefficients radianceSH = IBLBaker::readSHFile(files.irradianceSHPath);
+	if (radianceSH.order < 3)
+		return false;
+
+	_pEnvMap = pComputeCtx->createTextureFromFile(std::to_wstring(files.envMapPath), false);
+	_pPerFilterEnvMap = pComputeCtx->createTextureFromFile(std::to_wstring(files.prefilterEnvMapPath), false);
+	_pBRDFLutMap = pComputeCtx->createTextureFromFile(std::to_wstring(files.brdfLutPath), false);
+	setIrradianceSH(radianceSH);
+	return true;
+}
+
+void IBL::setIrradianceSH(SHCoefficients radianceSH) {
+	// SampleSH expects irradiance / PI, the same as ConvolutionIrradianceMapCS writes
+	constexpr float kInvPI = 1.f / 3.141592654f;
+	std::vector<float> bandScales = calcSHCosineLobeBandScale(radianceSH.order);
+	for (float &scale : bandScales)
+		scale *= kInvPI;
+	applySHBandScale(radianceSH, bandScales);
+
+	// higher bands are dropped, the first 9 coefficients are the same for every order
+	for (size_t i = 0; i < 9; ++i) {
+		_irradianceMapSH3._m[i] = float4(
+			radianceSH.channels[0][i],
+			radianceSH.channels[1][i],
+			radianceSH.channels[2][i],
+			0.f
+		);
+	}
+}
+
 void IBL::buildPerFilterEnvPSO(std::weak_ptr<dx12lib::Device> pDevice) {
 	auto pSharedDevice = pDevice.lock();
 	auto pRootSignature = pSharedDevice->createRootSignature(2, 1);
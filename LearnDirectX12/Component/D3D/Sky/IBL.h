@@ -2,9 +2,12 @@
 #include <dx12lib/dx12libStd.h>
 #include <dx12lib/Context/ContextProxy.hpp>
 #include "SphericalHarmonics.hpp"
+#include "SHProjection.h"
 
 namespace d3d {
 
+struct IBLBakeFiles;
+
 class IBL {
 public:
 	IBL(dx12lib::DirectContextProxy pDirectCtx, const std::string &fileName);
@@ -17,6 +20,9 @@ private:
 	void buildConvolutionIrradiancePSO(std::weak_ptr<dx12lib::Device> pDevice);
 	void buildEnvMap(dx12lib::ComputeContextProxy pComputeCtx, std::shared_ptr<dx12lib::Texture> pPannoEnvMap);
 	void buildConvolutionIrradianceMap(dx12lib::ComputeContextProxy pComputeCtx, std::shared_ptr<dx12lib::Texture> pPannoEnvMap);
+	bool buildIrradianceMapSH3(const std::string &fileName);
+	bool loadBakedFiles(dx12lib::DirectContextProxy pComputeCtx, const IBLBakeFiles &files);
+	void setIrradianceSH(SHCoefficients radianceSH);
 	void buildPerFilterEnvPSO(std::weak_ptr<dx12lib::Device> pDevice);
 	void buildPerFilterEnvMap(dx12lib::ComputeContextProxy pComputeCtx);
 	static std::shared_ptr<dx12lib::VertexBuffer> createCubeVertexBuffer(dx12lib::DirectContextProxy pComputeCtx);
@@ -0,0 +1,607 @@
+#include "IBLBaker.h"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <format>
+#include <JobSystem/JobSystem.h>
+#include <stb/stb_image.h>			// STB_IMAGE_IMPLEMENTATION lives in IBL.cpp
+
+namespace d3d {
+
+// bump when the baked output changes, old cache entries are then ignored
+constexpr static std::uint32_t kIBLBakerVersion = 1;
+constexpr static std::uint32_t kSHFileMagic = 0x31434853;		// "SHC1"
+constexpr static float kPI = 3.141592654f;
+
+static float radicalInverseVdC(std::uint32_t bits) {
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return static_cast<float>(bits) * 2.3283064365386963e-10f;
+}
+
+// half vector around +z, alpha = roughness^2
+static void importanceSampleGGX(std::uint32_t i, std::uint32_t count, float alpha, float H[3]) {
+	float phi = 2.f * kPI * static_cast<float>(i) / static_cast<float>(count);
+	float xi = radicalInverseVdC(i);
+	float cosTheta = std::sqrt((1.f - xi) / (1.f + (alpha * alpha - 1.f) * xi));
+	float sinTheta = std::sqrt(std::max(1.f - cosTheta * cosTheta, 0.f));
+	H[0] = sinTheta * std::cos(phi);
+	H[1] = sinTheta * std::sin(phi);
+	H[2] = cosTheta;
+}
+
+IBLCubeMap::IBLCubeMap(std::uint32_t size, std::uint32_t mipLevels) : size(size), mipLevels(mipLevels) {
+	assert(size > 0 && mipLevels > 0);
+	faces.resize(static_cast<size_t>(mipLevels) * 6);
+	for (std::uint32_t mip = 0; mip < mipLevels; ++mip) {
+		std::uint32_t mipSize = getMipSize(mip);
+		for (int face = 0; face < 6; ++face)
+			faces[mip * 6 + face].assign(static_cast<size_t>(mipSize) * mipSize * 4, 0.f);
+	}
+}
+
+std::uint32_t IBLCubeMap::getMipSize(std::uint32_t mip) const {
+	return std::max(size >> mip, 1u);
+}
+
+float *IBLCubeMap::getFace(std::uint32_t mip, int face) {
+	return faces[mip * 6 + face].data();
+}
+
+const float *IBLCubeMap::getFace(std::uint32_t mip, int face) const {
+	return faces[mip * 6 + face].data();
+}
+
+void IBLCubeMap::sample(const float direction[3], float lod, float rgb[3]) const {
+	int face;
+	float u, v;
+	calcCubeMapFaceUV(direction, face, u, v);
+
+	auto sampleLevel = [&](std::uint32_t mip, float result[3]) {
+		std::uint32_t mipSize = getMipSize(mip);
+		const float *pFace = getFace(mip, face);
+		float x = std::clamp(u * mipSize - 0.5f, 0.f, static_cast<float>(mipSize - 1));
+		float y = std::clamp(v * mipSize - 0.5f, 0.f, static_cast<float>(mipSize - 1));
+		std::uint32_t x0 = static_cast<std::uint32_t>(x);
+		std::uint32_t y0 = static_cast<std::uint32_t>(y);
+		std::uint32_t x1 = std::min(x0 + 1, mipSize - 1);
+		std::uint32_t y1 = std::min(y0 + 1, mipSize - 1);
+		float fx = x - x0;
+		float fy = y - y0;
+		const float *p00 = pFace + (y0 * mipSize + x0) * 4;
+		const float *p10 = pFace + (y0 * mipSize + x1) * 4;
+		const float *p01 = pFace + (y1 * mipSize + x0) * 4;
+		const float *p11 = pFace + (y1 * mipSize + x1) * 4;
+		for (int c = 0; c < 3; ++c) {
+			float top = p00[c] + (p10[c] - p00[c]) * fx;
+			float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+			result[c] = top + (bottom - top) * fy;
+		}
+	};
+
+	lod = std::clamp(lod, 0.f, static_cast<float>(mipLevels - 1));
+	std::uint32_t mip0 = static_cast<std::uint32_t>(lod);
+	std::uint32_t mip1 = std::min(mip0 + 1, mipLevels - 1);
+	float t = lod - mip0;
+	sampleLevel(mip0, rgb);
+	if (mip1 != mip0 && t > 0.f) {
+		float next[3];
+		sampleLevel(mip1, next);
+		for (int c = 0; c < 3; ++c)
+			rgb[c] += (next[c] - rgb[c]) * t;
+	}
+}
+
+IBLBaker::IBLBaker(std::string cacheDirectory)
+: _cacheDirectory(std::move(cacheDirectory))
+{
+}
+
+IBLBakeFiles IBLBaker::bake(const std::string &hdrFileName, const IBLBakeSettings &settings, bool force) {
+	std::vector<std::uint8_t> fileData = readBinaryFile(hdrFileName);
+	if (fileData.empty()) {
+		++_numFailed;
+		return {};
+	}
+
+	IBLBakeFiles files = makeFileNames(calcSourceHash(fileData.data(), fileData.size(), settings), settings);
+	auto exists = [](const std::string &fileName) {
+		std::error_code ec;
+		return std::filesystem::exists(fileName, ec);
+	};
+	bool cached = exists(files.envMapPath) && exists(files.prefilterEnvMapPath) && exists(files.irradianceSHPath);
+	if (cached && exists(files.brdfLutPath) && !force) {
+		++_numCacheHits;
+		return files;
+	}
+
+	int width = 0;
+	int height = 0;
+	int channel = 0;
+	float *pPixels = stbi_loadf_from_memory(fileData.data(), static_cast<int>(fileData.size()), &width, &height, &channel, 3);
+	if (pPixels == nullptr) {
+		++_numFailed;
+		return {};
+	}
+	fileData = {};
+
+	bool success = true;
+	if (!cached || force) {
+		SHCoefficients radianceSH = projectEquirectToSH(pPixels, width, height, 3, settings.shOrder);
+		IBLCubeMap envMap = panoramaToCubeMap(pPixels, width, height, 3, settings.envMapSize);
+		generateMipChain(envMap);
+		IBLCubeMap prefilterEnvMap = prefilterGGX(envMap,
+			settings.prefilterSize,
+			settings.prefilterMipLevels,
+			settings.prefilterSampleCount
+		);
+
+		success &= writeFile(files.irradianceSHPath, writeSHFile(radianceSH));
+		success &= writeFile(files.envMapPath, TextureBaker::writeDDS(toBakedTexture(envMap)));
+		success &= writeFile(files.prefilterEnvMapPath, TextureBaker::writeDDS(toBakedTexture(prefilterEnvMap)));
+	}
+	stbi_image_free(pPixels);
+
+	// the lut does not depend on the environment, every source shares it
+	if (!exists(files.brdfLutPath) || force) {
+		std::vector<float> brdfLut = integrateBRDF(settings.brdfLutSize, settings.brdfSampleCount);
+		success &= writeFile(files.brdfLutPath, TextureBaker::writeDDS(toBakedTexture(brdfLut, settings.brdfLutSize)));
+	}
+
+	if (!success) {
+		++_numFailed;
+		return {};
+	}
+	++_numBaked;
+	return files;
+}
+
+IBLBakeFiles IBLBaker::findCached(const std::string &hdrFileName, const IBLBakeSettings &settings) const {
+	std::vector<std::uint8_t> fileData = readBinaryFile(hdrFileName);
+	if (fileData.empty())
+		return {};
+
+	IBLBakeFiles files = makeFileNames(calcSourceHash(fileData.data(), fileData.size(), settings), settings);
+	for (const std::string *pFileName : { &files.envMapPath, &files.prefilterEnvMapPath, &files.brdfLutPath, &files.irradianceSHPath }) {
+		std::error_code ec;
+		if (!std::filesystem::exists(*pFileName, ec))
+			return {};
+	}
+	return files;
+}
+
+IBLBakerStats IBLBaker::getStats() const {
+	IBLBakerStats stats;
+	stats.numBaked = _numBaked;
+	stats.numCacheHits = _numCacheHits;
+	stats.numFailed = _numFailed;
+	return stats;
+}
+
+const std::string &IBLBaker::getCacheDirectory() const {
+	return _cacheDirectory;
+}
+
+IBLCubeMap IBLBaker::panoramaToCubeMap(const float *pPixels,
+	std::uint32_t width,
+	std::uint32_t height,
+	std::uint32_t numChannel,
+	std::uint32_t size,
+	bool parallel)
+{
+	assert(pPixels != nullptr && width > 0 && height > 0 && numChannel >= 3 && size > 0);
+	std::uint32_t mipLevels = TextureBaker::calcMipCount(size, size);
+	IBLCubeMap cubeMap(size, mipLevels);
+
+	// bilinear, u wraps around and v is clamped at the poles
+	auto samplePanorama = [&](const float direction[3], float rgb[3]) {
+		float u = std::atan2(direction[2], direction[0]) / (2.f * kPI) + 0.5f;
+		float v = 0.5f - std::asin(std::clamp(direction[1], -1.f, 1.f)) / kPI;
+		float x = u * width - 0.5f;
+		float y = std::clamp(v * height - 0.5f, 0.f, static_cast<float>(height - 1));
+		float floorX = std::floor(x);
+		float fx = x - floorX;
+		std::uint32_t x0 = static_cast<std::uint32_t>((static_cast<std::int64_t>(floorX) % width + width) % width);
+		std::uint32_t x1 = (x0 + 1) % width;
+		std::uint32_t y0 = static_cast<std::uint32_t>(y);
+		std::uint32_t y1 = std::min(y0 + 1, height - 1);
+		float fy = y - y0;
+		auto texel = [&](std::uint32_t tx, std::uint32_t ty) {
+			return pPixels + (static_cast<size_t>(ty) * width + tx) * numChannel;
+		};
+		for (int c = 0; c < 3; ++c) {
+			float top = texel(x0, y0)[c] + (texel(x1, y0)[c] - texel(x0, y0)[c]) * fx;
+			float bottom = texel(x0, y1)[c] + (texel(x1, y1)[c] - texel(x0, y1)[c]) * fx;
+			rgb[c] = top + (bottom - top) * fy;
+		}
+	};
+
+	// 2x2 samples per texel, the panorama is usually denser than the faces
+	size_t numRows = static_cast<size_t>(size) * 6;
+	// a grain of the whole range keeps it on this thread
+	com::parallelFor(0, numRows, parallel ? 1 : numRows, [&](size_t begin, size_t end) {
+		for (size_t row = begin; row < end; ++row) {
+			int face = static_cast<int>(row / size);
+			std::uint32_t y = static_cast<std::uint32_t>(row % size);
+			float *pRow = cubeMap.getFace(0, face) + static_cast<size_t>(y) * size * 4;
+			for (std::uint32_t x = 0; x < size; ++x) {
+				float sum[3] = { 0.f, 0.f, 0.f };
+				for (int sy = 0; sy < 2; ++sy) {
+					for (int sx = 0; sx < 2; ++sx) {
+						float direction[3];
+						float rgb[3];
+						calcCubeMapDirection(face, (x + 0.25f + 0.5f * sx) / size, (y + 0.25f + 0.5f * sy) / size, direction);
+						samplePanorama(direction, rgb);
+						for (int c = 0; c < 3; ++c)
+							sum[c] += rgb[c] * 0.25f;
+					}
+				}
+				std::copy_n(sum, 3, pRow + x * 4);
+				pRow[x * 4 + 3] = 1.f;
+			}
+		}
+	});
+	return cubeMap;
+}
+
+void IBLBaker::generateMipChain(IBLCubeMap &cubeMap) {
+	for (std::uint32_t mip = 1; mip < cubeMap.mipLevels; ++mip) {
+		std::uint32_t srcSize = cubeMap.getMipSize(mip - 1);
+		std::uint32_t dstSize = cubeMap.getMipSize(mip);
+		for (int face = 0; face < 6; ++face) {
+			const float *pSrc = cubeMap.getFace(mip - 1, face);
+			float *pDst = cubeMap.getFace(mip, face);
+			for (std::uint32_t y = 0; y < dstSize; ++y) {
+				for (std::uint32_t x = 0; x < dstSize; ++x) {
+					std::uint32_t sx0 = std::min(x * 2, srcSize - 1);
+					std::uint32_t sx1 = std::min(x * 2 + 1, srcSize - 1);
+					std::uint32_t sy0 = std::min(y * 2, srcSize - 1);
+					std::uint32_t sy1 = std::min(y * 2 + 1, srcSize - 1);
+					for (int c = 0; c < 4; ++c) {
+						pDst[(y * dstSize + x) * 4 + c] = 0.25f * (
+							pSrc[(sy0 * srcSize + sx0) * 4 + c] +
+							pSrc[(sy0 * srcSize + sx1) * 4 + c] +
+							pSrc[(sy1 * srcSize + sx0) * 4 + c] +
+							pSrc[(sy1 * srcSize + sx1) * 4 + c]
+						);
+					}
+				}
+			}
+		}
+	}
+}
+
+IBLCubeMap IBLBaker::prefilterGGX(const IBLCubeMap &envMap,
+	std::uint32_t size,
+	std::uint32_t mipLevels,
+	std::uint32_t sampleCount,
+	bool parallel)
+{
+	assert(static_cast<bool>(envMap) && size > 0 && mipLevels > 0 && sampleCount > 0);
+	mipLevels = std::min(mipLevels, TextureBaker::calcMipCount(size, size));
+	IBLCubeMap result(size, mipLevels);
+	float envTexelSolidAngle = 4.f * kPI / (6.f * envMap.size * envMap.size);
+
+	struct GGXSample {
+		float direction[3];						// tangent space, N = +z
+		float NdotL;
+		float lod;
+	};
+
+	for (std::uint32_t mip = 0; mip < mipLevels; ++mip) {
+		std::uint32_t mipSize = result.getMipSize(mip);
+		float roughness = mipLevels > 1 ? static_cast<float>(mip) / static_cast<float>(mipLevels - 1) : 0.f;
+		float alpha = roughness * roughness;
+
+		// the sample set is the same for every texel of a level, only the tangent frame changes
+		std::vector<GGXSample> samples;
+		if (roughness == 0.f) {
+			float lod = std::log2(static_cast<float>(envMap.size) / static_cast<float>(mipSize));
+			samples.push_back(GGXSample{ { 0.f, 0.f, 1.f }, 1.f, std::max(lod, 0.f) });
+		} else {
+			for (std::uint32_t i = 0; i < sampleCount; ++i) {
+				float H[3];
+				importanceSampleGGX(i, sampleCount, alpha, H);
+				// V = N, so L = reflect(-N, H)
+				float NdotH = H[2];
+				GGXSample sample;
+				sample.direction[0] = 2.f * NdotH * H[0];
+				sample.direction[1] = 2.f * NdotH * H[1];
+				sample.direction[2] = 2.f * NdotH * H[2] - 1.f;
+				sample.NdotL = sample.direction[2];
+				if (sample.NdotL <= 0.f)
+					continue;
+
+				// pdf(L) = D * NdotH / (4 * VdotH) = D / 4 with V = N
+				float a2 = alpha * alpha;
+				float denominator = NdotH * NdotH * (a2 - 1.f) + 1.f;
+				float D = a2 / (kPI * denominator * denominator);
+				float sampleSolidAngle = 1.f / (static_cast<float>(sampleCount) * D * 0.25f + 0.0001f);
+				sample.lod = std::max(0.5f * std::log2(sampleSolidAngle / envTexelSolidAngle) + 1.f, 0.f);
+				samples.push_back(sample);
+			}
+		}
+
+		size_t numRows = static_cast<size_t>(mipSize) * 6;
+		com::parallelFor(0, numRows, parallel ? 1 : numRows, [&](size_t begin, size_t end) {
+			for (size_t row = begin; row < end; ++row) {
+				int face = static_cast<int>(row / mipSize);
+				std::uint32_t y = static_cast<std::uint32_t>(row % mipSize);
+				float *pRow = result.getFace(mip, face) + static_cast<size_t>(y) * mipSize * 4;
+				for (std::uint32_t x = 0; x < mipSize; ++x) {
+					float N[3];
+					calcCubeMapDirection(face, (x + 0.5f) / mipSize, (y + 0.5f) / mipSize, N);
+					float up[3] = { 0.f, 0.f, 1.f };
+					if (std::abs(N[2]) >= 0.999f)
+						up[0] = 1.f, up[2] = 0.f;
+
+					float T[3] = {
+						up[1] * N[2] - up[2] * N[1],
+						up[2] * N[0] - up[0] * N[2],
+						up[0] * N[1] - up[1] * N[0],
+					};
+					float invLength = 1.f / std::sqrt(T[0]*T[0] + T[1]*T[1] + T[2]*T[2]);
+					T[0] *= invLength; T[1] *= invLength; T[2] *= invLength;
+					float B[3] = {
+						N[1] * T[2] - N[2] * T[1],
+						N[2] * T[0] - N[0] * T[2],
+						N[0] * T[1] - N[1] * T[0],
+					};
+
+					float colorSum[3] = { 0.f, 0.f, 0.f };
+					float weightSum = 0.f;
+					for (const GGXSample &sample : samples) {
+						float L[3];
+						for (int c = 0; c < 3; ++c)
+							L[c] = T[c] * sample.direction[0] + B[c] * sample.direction[1] + N[c] * sample.direction[2];
+
+						float rgb[3];
+						envMap.sample(L, sample.lod, rgb);
+						for (int c = 0; c < 3; ++c)
+							colorSum[c] += rgb[c] * sample.NdotL;
+						weightSum += sample.NdotL;
+					}
+
+					float invWeight = weightSum > 0.f ? 1.f / weightSum : 0.f;
+					for (int c = 0; c < 3; ++c)
+						pRow[x * 4 + c] = colorSum[c] * invWeight;
+					pRow[x * 4 + 3] = 1.f;
+				}
+			}
+		});
+	}
+	return result;
+}
+
+std::vector<float> IBLBaker::integrateBRDF(std::uint32_t size, std::uint32_t sampleCount, bool parallel) {
+	assert(size > 0 && sampleCount > 0);
+	std::vector<float> lut(static_cast<size_t>(size) * size * 2);
+	com::parallelFor(0, size, parallel ? 1 : size, [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; ++y) {
+			float roughness = (y + 0.5f) / size;
+			float alpha = roughness * roughness;
+			float k = alpha * 0.5f;							// Schlick-GGX for image based lighting
+			for (std::uint32_t x = 0; x < size; ++x) {
+				float NdotV = (x + 0.5f) / size;
+				float V[3] = { std::sqrt(1.f - NdotV * NdotV), 0.f, NdotV };
+				float scale = 0.f;
+				float bias = 0.f;
+				for (std::uint32_t i = 0; i < sampleCount; ++i) {
+					float H[3];
+					importanceSampleGGX(i, sampleCount, alpha, H);
+					float VdotH = V[0] * H[0] + V[1] * H[1] + V[2] * H[2];
+					float NdotL = 2.f * VdotH * H[2] - V[2];
+					if (NdotL <= 0.f)
+						continue;
+
+					float NdotH = std::max(H[2], 0.f);
+					VdotH = std::max(VdotH, 0.f);
+					float G = (NdotV / (NdotV * (1.f - k) + k)) * (NdotL / (NdotL * (1.f - k) + k));
+					float visibility = G * VdotH / (NdotH * NdotV);
+					float fresnel = std::pow(1.f - VdotH, 5.f);
+					scale += (1.f - fresnel) * visibility;
+					bias += fresnel * visibility;
+				}
+				float *pTexel = lut.data() + (y * size + x) * 2;
+				pTexel[0] = scale / sampleCount;
+				pTexel[1] = bias / sampleCount;
+			}
+		}
+	});
+	return lut;
+}
+
+BakedTexture IBLBaker::toBakedTexture(const IBLCubeMap &cubeMap) {
+	BakedTexture texture;
+	texture.width = cubeMap.size;
+	texture.height = cubeMap.size;
+	texture.format = TextureBlockFormat::RGBA16F;
+	texture.arraySize = 6;
+	texture.cubeMap = true;
+	// dds stores every mip of a face before the next face
+	for (int face = 0; face < 6; ++face) {
+		for (std::uint32_t mip = 0; mip < cubeMap.mipLevels; ++mip) {
+			std::uint32_t mipSize = cubeMap.getMipSize(mip);
+			const float *pFace = cubeMap.getFace(mip, face);
+			BakedMipLevel level;
+			level.width = mipSize;
+			level.height = mipSize;
+			level.data.resize(static_cast<size_t>(mipSize) * mipSize * 4 * sizeof(std::uint16_t));
+			auto *pDst = reinterpret_cast<std::uint16_t *>(level.data.data());
+			for (size_t i = 0; i < static_cast<size_t>(mipSize) * mipSize * 4; ++i)
+				pDst[i] = floatToHalf(pFace[i]);
+			texture.mips.push_back(std::move(level));
+		}
+	}
+	return texture;
+}
+
+BakedTexture IBLBaker::toBakedTexture(const std::vector<float> &brdfLut, std::uint32_t size) {
+	assert(brdfLut.size() == static_cast<size_t>(size) * size * 2);
+	BakedTexture texture;
+	texture.width = size;
+	texture.height = size;
+	texture.format = TextureBlockFormat::RG16F;
+	BakedMipLevel level;
+	level.width = size;
+	level.height = size;
+	level.data.resize(brdfLut.size() * sizeof(std::uint16_t));
+	auto *pDst = reinterpret_cast<std::uint16_t *>(level.data.data());
+	for (size_t i = 0; i < brdfLut.size(); ++i)
+		pDst[i] = floatToHalf(brdfLut[i]);
+	texture.mips.push_back(std::move(level));
+	return texture;
+}
+
+std::vector<std::uint8_t> IBLBaker::writeSHFile(const SHCoefficients &sh) {
+	std::vector<std::uint8_t> result;
+	auto append = [&](const void *pData, size_t size) {
+		const auto *pBegin = static_cast<const std::uint8_t *>(pData);
+		result.insert(result.end(), pBegin, pBegin + size);
+	};
+	std::int32_t order = sh.order;
+	append(&kSHFileMagic, sizeof(kSHFileMagic));
+	append(&order, sizeof(order));
+	for (const auto &channel : sh.channels)
+		append(channel.data(), channel.size() * sizeof(float));
+	return result;
+}
+
+SHCoefficients IBLBaker::readSHFile(const std::string &fileName) {
+	std::vector<std::uint8_t> data = readBinaryFile(fileName);
+	std::uint32_t magic = 0;
+	std::int32_t order = 0;
+	if (data.size() < sizeof(magic) + sizeof(order))
+		return {};
+
+	std::memcpy(&magic, data.data(), sizeof(magic));
+	std::memcpy(&order, data.data() + sizeof(magic), sizeof(order));
+	size_t expectSize = sizeof(magic) + sizeof(order) + calcSHCoeffCount(order) * 3 * sizeof(float);
+	if (magic != kSHFileMagic || order <= 0 || order > kMaxSHOrder || data.size() != expectSize)
+		return {};
+
+	SHCoefficients sh(order);
+	const std::uint8_t *pData = data.data() + sizeof(magic) + sizeof(order);
+	for (auto &channel : sh.channels) {
+		std::memcpy(channel.data(), pData, channel.size() * sizeof(float));
+		pData += channel.size() * sizeof(float);
+	}
+	return sh;
+}
+
+std::uint64_t IBLBaker::calcSourceHash(const void *pData, size_t size, const IBLBakeSettings &settings) {
+	// FNV-1a over the source bytes and everything that changes the output
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	auto combine = [&](const void *pBytes, size_t count) {
+		const auto *pBegin = static_cast<const std::uint8_t *>(pBytes);
+		for (size_t i = 0; i < count; ++i) {
+			hash ^= pBegin[i];
+			hash *= 0x100000001b3ull;
+		}
+	};
+	combine(pData, size);
+	std::uint32_t settingBits[] = {
+		kIBLBakerVersion,
+		settings.envMapSize,
+		settings.prefilterSize,
+		settings.prefilterMipLevels,
+		settings.prefilterSampleCount,
+		static_cast<std::uint32_t>(settings.shOrder),
+	};
+	combine(settingBits, sizeof(settingBits));
+	return hash;
+}
+
+std::uint16_t IBLBaker::floatToHalf(float value) {
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+	std::uint32_t biasedExponent = (bits >> 23) & 0xff;
+	std::uint32_t mantissa = bits & 0x7fffff;
+	if (biasedExponent == 0xff)											// inf / nan
+		return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+
+	int exponent = static_cast<int>(biasedExponent) - 127 + 15;
+	if (exponent >= 31)													// clamp to the largest half, a bright sun is not infinite
+		return sign | 0x7bff;
+	if (exponent <= 0) {												// denormal or zero
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		std::uint32_t shift = static_cast<std::uint32_t>(14 - exponent);
+		std::uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			++half;
+		return sign | static_cast<std::uint16_t>(half);
+	}
+
+	std::uint32_t half = (static_cast<std::uint32_t>(exponent) << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)												// round, a carry moves into the exponent
+		++half;
+	return sign | static_cast<std::uint16_t>(std::min(half, 0x7bffu));
+}
+
+float IBLBaker::halfToFloat(std::uint16_t value) {
+	std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000) << 16;
+	std::uint32_t exponent = (value >> 10) & 0x1f;
+	std::uint32_t mantissa = value & 0x3ff;
+	std::uint32_t bits;
+	if (exponent == 0) {
+		if (mantissa == 0) {
+			bits = sign;
+		} else {
+			// normalize the denormal
+			int shift = 0;
+			while ((mantissa & 0x400) == 0) {
+				mantissa <<= 1;
+				++shift;
+			}
+			mantissa &= 0x3ff;
+			bits = sign | (static_cast<std::uint32_t>(127 - 15 + 1 - shift) << 23) | (mantissa << 13);
+		}
+	} else if (exponent == 31) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+IBLBakeFiles IBLBaker::makeFileNames(std::uint64_t hash, const IBLBakeSettings &settings) const {
+	IBLBakeFiles files;
+	files.envMapPath = std::format("{}{:016x}_env.dds", _cacheDirectory, hash);
+	files.prefilterEnvMapPath = std::format("{}{:016x}_prefilter.dds", _cacheDirectory, hash);
+	files.irradianceSHPath = std::format("{}{:016x}_sh.bin", _cacheDirectory, hash);
+	files.brdfLutPath = std::format("{}brdf_lut_{}_{}_v{}.dds", _cacheDirectory, settings.brdfLutSize, settings.brdfSampleCount, kIBLBakerVersion);
+	return files;
+}
+
+bool IBLBaker::writeFile(const std::string &fileName, const std::vector<std::uint8_t> &data) const {
+	std::error_code ec;
+	std::filesystem::create_directories(_cacheDirectory, ec);
+	// write to a temporary file first, another process may bake the same source
+	std::string tempPath = std::format("{}.{}.tmp", fileName, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	{
+		std::ofstream output(tempPath, std::ios::binary);
+		if (!output.is_open())
+			return false;
+		output.write(reinterpret_cast<const char *>(data.data()), data.size());
+	}
+	std::filesystem::rename(tempPath, fileName, ec);
+	if (ec) {
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+	return true;
+}
+
+}
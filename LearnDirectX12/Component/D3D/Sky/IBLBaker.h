@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "SHProjection.h"
+#include "D3D/TextureManager/TextureBaker.h"
+
+namespace d3d {
+
+struct IBLBakeSettings {
+	std::uint32_t envMapSize = 512;
+	std::uint32_t prefilterSize = 256;
+	std::uint32_t prefilterMipLevels = 5;			// MAX_REFLECTION_LOD in LightingUtil.hlsl + 1
+	std::uint32_t prefilterSampleCount = 512;
+	std::uint32_t brdfLutSize = 512;
+	std::uint32_t brdfSampleCount = 1024;
+	int			  shOrder = 3;
+};
+
+// float RGBA cube map with a mip chain, faces in D3D order (+X -X +Y -Y +Z -Z)
+struct IBLCubeMap {
+	std::uint32_t size = 0;
+	std::uint32_t mipLevels = 0;
+	std::vector<std::vector<float>> faces;			// faces[mip * 6 + face]
+public:
+	IBLCubeMap() = default;
+	IBLCubeMap(std::uint32_t size, std::uint32_t mipLevels);
+	explicit operator bool() const { return size > 0; }
+	std::uint32_t getMipSize(std::uint32_t mip) const;
+	float *getFace(std::uint32_t mip, int face);
+	const float *getFace(std::uint32_t mip, int face) const;
+	// bilinear inside the face, linear between mips
+	void sample(const float direction[3], float lod, float rgb[3]) const;
+};
+
+struct IBLBakeFiles {
+	std::string envMapPath;
+	std::string prefilterEnvMapPath;
+	std::string brdfLutPath;
+	std::string irradianceSHPath;					// radiance SH, see IBLBaker::readSHFile
+public:
+	explicit operator bool() const { return !envMapPath.empty(); }
+};
+
+struct IBLBakerStats {
+	size_t numBaked = 0;
+	size_t numCacheHits = 0;
+	size_t numFailed = 0;
+};
+
+// Offline version of the IBL compute passes. Turns an equirect .hdr into the environment cube map,
+// a GGX prefiltered mip chain, radiance SH and the split-sum BRDF LUT, then stores them as dds
+// files keyed by the source hash so IBL can load them instead of computing them at startup
+class IBLBaker {
+public:
+	explicit IBLBaker(std::string cacheDirectory = defaultCacheDirectory);
+
+	// bakes when the cache does not hold this source yet, empty files when the hdr can not be loaded
+	IBLBakeFiles bake(const std::string &hdrFileName, const IBLBakeSettings &settings = {}, bool force = false);
+	IBLBakeFiles findCached(const std::string &hdrFileName, const IBLBakeSettings &settings = {}) const;
+	IBLBakerStats getStats() const;
+	const std::string &getCacheDirectory() const;
+
+	static IBLCubeMap panoramaToCubeMap(const float *pPixels,
+		std::uint32_t width,
+		std::uint32_t height,
+		std::uint32_t numChannel,
+		std::uint32_t size,
+		bool parallel = true
+	);
+	// box filtered, every level from the one above
+	static void generateMipChain(IBLCubeMap &cubeMap);
+	// importance sampled GGX, the source lod of every sample follows its pdf (filtered importance sampling)
+	static IBLCubeMap prefilterGGX(const IBLCubeMap &envMap,
+		std::uint32_t size,
+		std::uint32_t mipLevels,
+		std::uint32_t sampleCount,
+		bool parallel = true
+	);
+	// RG (scale, bias) for F0, u = NdotV, v = roughness
+	static std::vector<float> integrateBRDF(std::uint32_t size, std::uint32_t sampleCount, bool parallel = true);
+
+	static BakedTexture toBakedTexture(const IBLCubeMap &cubeMap);
+	static BakedTexture toBakedTexture(const std::vector<float> &brdfLut, std::uint32_t size);
+	static std::vector<std::uint8_t> writeSHFile(const SHCoefficients &sh);
+	static SHCoefficients readSHFile(const std::string &fileName);
+	static std::uint64_t calcSourceHash(const void *pData, size_t size, const IBLBakeSettings &settings);
+	static std::uint16_t floatToHalf(float value);
+	static float halfToFloat(std::uint16_t value);
+public:
+	static inline std::string defaultCacheDirectory = "resources/IBLCache/";
+private:
+	IBLBakeFiles makeFileNames(std::uint64_t hash, const IBLBakeSettings &settings) const;
+	bool writeFile(const std::string &fileName, const std::vector<std::uint8_t> &data) const;
+private:
+	std::string _cacheDirectory;
+	std::atomic<size_t> _numBaked = 0;
+	std::atomic<size_t> _numCacheHits = 0;
+	std::atomic<size_t> _numFailed = 0;
+};
+
+}
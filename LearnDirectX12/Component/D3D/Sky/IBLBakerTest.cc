@@ -0,0 +1,135 @@
+#include <cmath>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include "TestCheck.h"
+#include "D3D/Sky/IBLBaker.h"
+#include "JobSystem/JobSystem.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+using namespace d3d;
+
+void iblBakerTest() {
+	auto nearlyEqual = [](float a, float b, float epsilon) { return std::abs(a - b) <= epsilon; };
+	for (float value : { 0.f, 1.f, -2.5f, 0.3333f, 1e-5f, 65504.f })
+		TEST_CHECK(nearlyEqual(IBLBaker::halfToFloat(IBLBaker::floatToHalf(value)), value, std::abs(value) * 1e-3f + 1e-7f));
+	TEST_CHECK(IBLBaker::halfToFloat(IBLBaker::floatToHalf(1e6f)) == 65504.f);
+
+	// face/uv round trip
+	for (int face = 0; face < 6; ++face) {
+		float direction[3];
+		calcCubeMapDirection(face, 0.3f, 0.8f, direction);
+		int resultFace;
+		float u, v;
+		calcCubeMapFaceUV(direction, resultFace, u, v);
+		TEST_CHECK(resultFace == face && nearlyEqual(u, 0.3f, 1e-5f) && nearlyEqual(v, 0.8f, 1e-5f));
+	}
+
+	// a smooth panorama lands on the right texels
+	constexpr std::uint32_t kWidth = 256;
+	constexpr std::uint32_t kHeight = 128;
+	std::vector<float> panorama(kWidth * kHeight * 3);
+	for (std::uint32_t y = 0; y < kHeight; ++y) {
+		for (std::uint32_t x = 0; x < kWidth; ++x) {
+			float direction[3];
+			calcEquirectDirection((x + 0.5f) / kWidth, (y + 0.5f) / kHeight, direction);
+			float *pTexel = panorama.data() + (y * kWidth + x) * 3;
+			pTexel[0] = direction[0] + 2.f;
+			pTexel[1] = direction[1] + 2.f;
+			pTexel[2] = 1.f;
+		}
+	}
+	IBLCubeMap envMap = IBLBaker::panoramaToCubeMap(panorama.data(), kWidth, kHeight, 3, 32);
+	TEST_CHECK(envMap.mipLevels == 6);
+	for (int face = 0; face < 6; ++face) {
+		for (std::uint32_t y = 0; y < 32; y += 5) {
+			for (std::uint32_t x = 0; x < 32; x += 5) {
+				float direction[3];
+				calcCubeMapDirection(face, (x + 0.5f) / 32.f, (y + 0.5f) / 32.f, direction);
+				const float *pTexel = envMap.getFace(0, face) + (y * 32 + x) * 4;
+				TEST_CHECK(nearlyEqual(pTexel[0], direction[0] + 2.f, 0.03f));
+				TEST_CHECK(nearlyEqual(pTexel[1], direction[1] + 2.f, 0.03f));
+			}
+		}
+	}
+
+	// prefiltering keeps a constant environment constant and the smooth one close at roughness 0
+	IBLBaker::generateMipChain(envMap);
+	IBLCubeMap prefilter = IBLBaker::prefilterGGX(envMap, 16, 5, 128);
+	TEST_CHECK(prefilter.mipLevels == 5);
+	for (std::uint32_t mip = 0; mip < prefilter.mipLevels; ++mip) {
+		std::uint32_t mipSize = prefilter.getMipSize(mip);
+		for (int face = 0; face < 6; ++face) {
+			for (std::uint32_t i = 0; i < mipSize * mipSize; ++i)
+				TEST_CHECK(nearlyEqual(prefilter.getFace(mip, face)[i * 4 + 2], 1.f, 1e-3f));
+		}
+	}
+	float direction[3] = { 0.6f, 0.f, 0.8f };
+	float rgb[3];
+	prefilter.sample(direction, 0.f, rgb);
+	TEST_CHECK(nearlyEqual(rgb[0], 2.6f, 0.05f));
+	// rough lobes blur toward the average
+	prefilter.sample(direction, 4.f, rgb);
+	TEST_CHECK(rgb[0] < 2.6f && rgb[0] > 2.f);
+
+	// split sum lut: no energy above one, almost all of it at low roughness
+	constexpr std::uint32_t kLutSize = 16;
+	std::vector<float> lut = IBLBaker::integrateBRDF(kLutSize, 256);
+	for (float value : lut)
+		TEST_CHECK(value >= 0.f && value <= 1.05f);
+	for (std::uint32_t x = kLutSize / 2; x < kLutSize; ++x)
+		TEST_CHECK(nearlyEqual(lut[x * 2] + lut[x * 2 + 1], 1.f, 0.05f));
+	const float *pRough = lut.data() + ((kLutSize - 1) * kLutSize + 2) * 2;
+	TEST_CHECK(pRough[0] + pRough[1] < 0.9f);
+
+	// end to end with the cache
+	std::string cacheDirectory = (std::filesystem::temp_directory_path() / "D3DTestIBLCache/").string();
+	std::filesystem::remove_all(cacheDirectory);
+	std::filesystem::create_directories(cacheDirectory);
+	std::string hdrFileName = cacheDirectory + "sky.hdr";
+	std::vector<float> constantSky(64 * 32 * 3, 0.5f);
+	int written = stbi_write_hdr(hdrFileName.c_str(), 64, 32, 3, constantSky.data());
+	TEST_CHECK(written != 0);
+
+	IBLBakeSettings settings;
+	settings.envMapSize = 16;
+	settings.prefilterSize = 8;
+	settings.prefilterMipLevels = 3;
+	settings.prefilterSampleCount = 32;
+	settings.brdfLutSize = 16;
+	settings.brdfSampleCount = 64;
+	IBLBaker baker(cacheDirectory);
+	TEST_CHECK(!baker.findCached(hdrFileName, settings));
+	IBLBakeFiles files = baker.bake(hdrFileName, settings);
+	TEST_CHECK(files && baker.getStats().numBaked == 1);
+	IBLBakeFiles cachedFiles = baker.bake(hdrFileName, settings);
+	TEST_CHECK(cachedFiles.envMapPath == files.envMapPath && baker.getStats().numCacheHits == 1);
+	TEST_CHECK(baker.findCached(hdrFileName, settings).prefilterEnvMapPath == files.prefilterEnvMapPath);
+	TEST_CHECK(!baker.bake(cacheDirectory + "missing.hdr", settings));
+
+	SHCoefficients sh = IBLBaker::readSHFile(files.irradianceSHPath);
+	TEST_CHECK(sh.order == 3 && nearlyEqual(sh.channels[1][0], 0.5f * 2.f * std::sqrt(3.141592654f), 1e-2f));
+
+	// cube dds: DX10 header with the cube flag, 6 faces of 16^2 .. 1^2 half RGBA texels
+	size_t ddsSize = std::filesystem::file_size(files.envMapPath);
+	size_t texelCount = 0;
+	for (std::uint32_t size = 16; size > 0; size >>= 1)
+		texelCount += size * size;
+	TEST_CHECK(ddsSize == 4 + 124 + 20 + texelCount * 6 * 8);
+	std::ifstream ddsFile(files.envMapPath, std::ios::binary);
+	std::uint32_t header[4 + 124 / 4 + 5];
+	ddsFile.read(reinterpret_cast<char *>(header), sizeof(header));
+	TEST_CHECK(header[0] == 0x20534444 && header[1 + 27] == 0xFE00);		// magic, caps2
+	TEST_CHECK(header[32] == 10 && header[34] == 0x4 && header[35] == 1);	// format, misc flag, cube count
+	std::filesystem::remove_all(cacheDirectory);
+}
+
+int main() {
+	com::JobSystem::emplace(4);
+	iblBakerTest();
+	com::JobSystem::destroy();
+	return 0;
+}
@@ -0,0 +1,555 @@
+#include "SHProjection.h"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <JobSystem/JobSystem.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+	#define D3D_SH_PROJECTION_SSE 1
+	#include <emmintrin.h>
+#else
+	#define D3D_SH_PROJECTION_SSE 0
+#endif
+
+namespace d3d {
+
+constexpr static double kPI = 3.14159265358979323846;
+
+// four lanes of float, the recurrence is written once for float and for this
+struct SHFloat4 {
+#if D3D_SH_PROJECTION_SSE
+	__m128 v;
+	SHFloat4() = default;
+	SHFloat4(__m128 value) : v(value) {}
+	SHFloat4(float value) : v(_mm_set1_ps(value)) {}
+	static SHFloat4 load(const float *p) { return _mm_loadu_ps(p); }
+	void store(float *p) const { _mm_storeu_ps(p, v); }
+	friend SHFloat4 operator+(SHFloat4 a, SHFloat4 b) { return _mm_add_ps(a.v, b.v); }
+	friend SHFloat4 operator-(SHFloat4 a, SHFloat4 b) { return _mm_sub_ps(a.v, b.v); }
+	friend SHFloat4 operator*(SHFloat4 a, SHFloat4 b) { return _mm_mul_ps(a.v, b.v); }
+	float sum() const {
+		__m128 shuffle = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(v, shuffle);
+		shuffle = _mm_movehl_ps(shuffle, sums);
+		return _mm_cvtss_f32(_mm_add_ss(sums, shuffle));
+	}
+#else
+	float v[4];
+	SHFloat4() = default;
+	SHFloat4(float value) : v{ value, value, value, value } {}
+	static SHFloat4 load(const float *p) { SHFloat4 r; std::copy_n(p, 4, r.v); return r; }
+	void store(float *p) const { std::copy_n(v, 4, p); }
+	friend SHFloat4 operator+(SHFloat4 a, SHFloat4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+	friend SHFloat4 operator-(SHFloat4 a, SHFloat4 b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+	friend SHFloat4 operator*(SHFloat4 a, SHFloat4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+	float sum() const { return (v[0] + v[1]) + (v[2] + v[3]); }
+#endif
+};
+
+static size_t calcSHNormalizationIndex(int l, int m) {
+	return static_cast<size_t>(l * (l + 1) / 2 + m);
+}
+
+SHCoefficients::SHCoefficients(int order) : order(order) {
+	assert(order > 0 && order <= kMaxSHOrder);
+	for (auto &channel : channels)
+		channel.assign(calcSHCoeffCount(order), 0.f);
+}
+
+size_t SHCoefficients::getNumCoeff() const {
+	return calcSHCoeffCount(order);
+}
+
+void SHCoefficients::eval(const float direction[3], float rgb[3]) const {
+	std::vector<float> basis(getNumCoeff());
+	SHBasisEvaluator(order).eval(direction[0], direction[1], direction[2], basis.data());
+	for (size_t c = 0; c < 3; ++c) {
+		double sum = 0.0;
+		for (size_t k = 0; k < basis.size(); ++k)
+			sum += channels[c][k] * basis[k];
+		rgb[c] = static_cast<float>(sum);
+	}
+}
+
+SHCoefficients &SHCoefficients::operator+=(const SHCoefficients &other) {
+	assert(order == other.order);
+	for (size_t c = 0; c < 3; ++c) {
+		for (size_t k = 0; k < channels[c].size(); ++k)
+			channels[c][k] += other.channels[c][k];
+	}
+	return *this;
+}
+
+SHCoefficients &SHCoefficients::operator*=(float scale) {
+	for (auto &channel : channels) {
+		for (float &value : channel)
+			value *= scale;
+	}
+	return *this;
+}
+
+SHBasisEvaluator::SHBasisEvaluator(int order) : _order(order) {
+	assert(order > 0 && order <= kMaxSHOrder);
+	size_t count = calcSHNormalizationIndex(order, 0);
+	_normalization.resize(count);
+	_recurrenceA.resize(count);
+	_recurrenceB.resize(count);
+	for (int l = 0; l < order; ++l) {
+		for (int m = 0; m <= l; ++m) {
+			// in log space, (l+m)! and (2m-1)!! overflow long before the product does
+			double logDoubleFactorial = std::lgamma(2.0 * m + 1.0) - m * std::log(2.0) - std::lgamma(m + 1.0);
+			double logK = 0.5 * (std::log((2.0 * l + 1.0) / (4.0 * kPI)) + std::lgamma(l - m + 1.0) - std::lgamma(l + m + 1.0));
+			double normalization = std::exp(logK + logDoubleFactorial);
+			if (m != 0)
+				normalization *= std::sqrt(2.0);
+
+			size_t index = calcSHNormalizationIndex(l, m);
+			_normalization[index] = static_cast<float>(normalization);
+			_recurrenceA[index] = l > m ? static_cast<float>(2 * l - 1) / static_cast<float>(l - m) : 0.f;
+			_recurrenceB[index] = l > m ? static_cast<float>(l + m - 1) / static_cast<float>(l - m) : 0.f;
+		}
+	}
+}
+
+int SHBasisEvaluator::getOrder() const {
+	return _order;
+}
+
+void SHBasisEvaluator::eval(float x, float y, float z, float *pOut) const {
+	evalImpl<float>(x, y, z, pOut);
+}
+
+void SHBasisEvaluator::eval4(const float *pX, const float *pY, const float *pZ, float *pOut) const {
+	SHFloat4 basis[kMaxSHOrder * kMaxSHOrder];
+	evalImpl<SHFloat4>(SHFloat4::load(pX), SHFloat4::load(pY), SHFloat4::load(pZ), basis);
+	for (size_t k = 0; k < calcSHCoeffCount(_order); ++k)
+		basis[k].store(pOut + k * 4);
+}
+
+// Q(l, m) is the associated Legendre polynomial divided by (2m-1)!!, cos/sin(m*phi) * sin^m(theta)
+// come from the powers of (x + iy), so there are no trigonometric calls at all
+template<typename V>
+void SHBasisEvaluator::evalImpl(V x, V y, V z, V *pOut) const {
+	V cosTerm[kMaxSHOrder];
+	V sinTerm[kMaxSHOrder];
+	cosTerm[0] = V(1.f);
+	sinTerm[0] = V(0.f);
+	for (int m = 1; m < _order; ++m) {
+		cosTerm[m] = x * cosTerm[m-1] - y * sinTerm[m-1];
+		sinTerm[m] = x * sinTerm[m-1] + y * cosTerm[m-1];
+	}
+
+	for (int m = 0; m < _order; ++m) {
+		V q1 = V(0.f);
+		V q2 = V(0.f);
+		for (int l = m; l < _order; ++l) {
+			size_t index = calcSHNormalizationIndex(l, m);
+			V q;
+			if (l == m)
+				q = V(1.f);
+			else if (l == m + 1)
+				q = z * V(static_cast<float>(2 * m + 1));
+			else
+				q = z * q1 * V(_recurrenceA[index]) - q2 * V(_recurrenceB[index]);
+
+			q2 = q1;
+			q1 = q;
+			V kq = q * V(_normalization[index]);
+			if (m == 0) {
+				pOut[calcSHIndex(l, 0)] = kq;
+			} else {
+				pOut[calcSHIndex(l, +m)] = kq * cosTerm[m];
+				pOut[calcSHIndex(l, -m)] = kq * sinTerm[m];
+			}
+		}
+	}
+}
+
+void calcEquirectDirection(float u, float v, float direction[3]) {
+	double phi = (u - 0.5) * 2.0 * kPI;
+	double latitude = (0.5 - v) * kPI;
+	double cosLatitude = std::cos(latitude);
+	direction[0] = static_cast<float>(cosLatitude * std::cos(phi));
+	direction[1] = static_cast<float>(std::sin(latitude));
+	direction[2] = static_cast<float>(cosLatitude * std::sin(phi));
+}
+
+void calcCubeMapDirection(int face, float u, float v, float direction[3]) {
+	float s = 2.f * u - 1.f;
+	float t = 2.f * v - 1.f;
+	float x, y, z;
+	switch (face) {
+	case 0: x = +1.f; y = -t;   z = -s;   break;	// +X
+	case 1: x = -1.f; y = -t;   z = +s;   break;	// -X
+	case 2: x = +s;   y = +1.f; z = +t;   break;	// +Y
+	case 3: x = +s;   y = -1.f; z = -t;   break;	// -Y
+	case 4: x = +s;   y = -t;   z = +1.f; break;	// +Z
+	case 5: x = -s;   y = -t;   z = -1.f; break;	// -Z
+	default:
+		assert(false);
+		x = 0.f; y = 0.f; z = 1.f;
+		break;
+	}
+	float invLength = 1.f / std::sqrt(x*x + y*y + z*z);
+	direction[0] = x * invLength;
+	direction[1] = y * invLength;
+	direction[2] = z * invLength;
+}
+
+void calcCubeMapFaceUV(const float direction[3], int &face, float &u, float &v) {
+	float x = direction[0];
+	float y = direction[1];
+	float z = direction[2];
+	float absX = std::abs(x);
+	float absY = std::abs(y);
+	float absZ = std::abs(z);
+	float s, t, major;
+	if (absX >= absY && absX >= absZ) {
+		face = x >= 0.f ? 0 : 1;
+		major = absX;
+		s = x >= 0.f ? -z : z;
+		t = -y;
+	} else if (absY >= absZ) {
+		face = y >= 0.f ? 2 : 3;
+		major = absY;
+		s = x;
+		t = y >= 0.f ? z : -z;
+	} else {
+		face = z >= 0.f ? 4 : 5;
+		major = absZ;
+		s = z >= 0.f ? x : -x;
+		t = -y;
+	}
+	u = 0.5f * (s / major + 1.f);
+	v = 0.5f * (t / major + 1.f);
+}
+
+// Accumulates texels four at a time, the running sums stay in SIMD registers and
+// are folded into double precision once per row
+class SHRowAccumulator {
+public:
+	explicit SHRowAccumulator(const SHBasisEvaluator &evaluator)
+	: _evaluator(evaluator)
+	, _numCoeff(calcSHCoeffCount(evaluator.getOrder()))
+	, _basis(_numCoeff * 4)
+	, _rowSums(_numCoeff * 3, SHFloat4(0.f))
+	, _sums(_numCoeff * 3, 0.0)
+	{
+	}
+
+	// weights are already multiplied into rgb, unused lanes carry zero
+	void add4(const float *pX, const float *pY, const float *pZ, const float *pR, const float *pG, const float *pB) {
+		_evaluator.eval4(pX, pY, pZ, _basis.data());
+		SHFloat4 r = SHFloat4::load(pR);
+		SHFloat4 g = SHFloat4::load(pG);
+		SHFloat4 b = SHFloat4::load(pB);
+		for (size_t k = 0; k < _numCoeff; ++k) {
+			SHFloat4 basis = SHFloat4::load(_basis.data() + k * 4);
+			_rowSums[k * 3 + 0] = _rowSums[k * 3 + 0] + basis * r;
+			_rowSums[k * 3 + 1] = _rowSums[k * 3 + 1] + basis * g;
+			_rowSums[k * 3 + 2] = _rowSums[k * 3 + 2] + basis * b;
+		}
+	}
+
+	void flushRow() {
+		for (size_t i = 0; i < _rowSums.size(); ++i) {
+			_sums[i] += _rowSums[i].sum();
+			_rowSums[i] = SHFloat4(0.f);
+		}
+	}
+
+	const std::vector<double> &getSums() const {
+		return _sums;
+	}
+private:
+	const SHBasisEvaluator &_evaluator;
+	size_t _numCoeff;
+	std::vector<float> _basis;
+	std::vector<SHFloat4> _rowSums;
+	std::vector<double> _sums;
+};
+
+// rows are split into fixed chunks and summed in chunk order, the result depends neither on
+// scheduling nor on the number of threads
+template<typename RowFunc>
+static SHCoefficients projectRows(size_t numRows, int order, bool parallel, const RowFunc &rowFunc) {
+	constexpr size_t kMaxChunks = 64;
+	SHBasisEvaluator evaluator(order);
+	size_t numChunks = std::min(numRows, kMaxChunks);
+	std::vector<std::vector<double>> chunkSums(numChunks);
+	com::parallelFor(0, numChunks, parallel ? 1 : numChunks, [&](size_t beginChunk, size_t endChunk) {
+		for (size_t chunk = beginChunk; chunk < endChunk; ++chunk) {
+			SHRowAccumulator accumulator(evaluator);
+			size_t beginRow = numRows * chunk / numChunks;
+			size_t endRow = numRows * (chunk + 1) / numChunks;
+			for (size_t row = beginRow; row < endRow; ++row) {
+				rowFunc(row, accumulator);
+				accumulator.flushRow();
+			}
+			chunkSums[chunk] = accumulator.getSums();
+		}
+	});
+
+	SHCoefficients sh(order);
+	size_t numCoeff = sh.getNumCoeff();
+	for (size_t k = 0; k < numCoeff; ++k) {
+		for (size_t c = 0; c < 3; ++c) {
+			double sum = 0.0;
+			for (const auto &sums : chunkSums)
+				sum += sums[k * 3 + c];
+			sh.channels[c][k] = static_cast<float>(sum);
+		}
+	}
+	return sh;
+}
+
+struct SHTexelBatch {
+	float x[4], y[4], z[4];
+	float r[4], g[4], b[4];
+	size_t count = 0;
+public:
+	void push(const float direction[3], const float *pPixel, float weight) {
+		x[count] = direction[0];
+		y[count] = direction[1];
+		z[count] = direction[2];
+		r[count] = pPixel[0] * weight;
+		g[count] = pPixel[1] * weight;
+		b[count] = pPixel[2] * weight;
+		++count;
+	}
+	void flush(SHRowAccumulator &accumulator) {
+		if (count == 0)
+			return;
+		for (size_t i = count; i < 4; ++i) {
+			x[i] = 0.f; y[i] = 0.f; z[i] = 1.f;
+			r[i] = 0.f; g[i] = 0.f; b[i] = 0.f;
+		}
+		accumulator.add4(x, y, z, r, g, b);
+		count = 0;
+	}
+};
+
+SHCoefficients projectEquirectToSH(const float *pPixels, int width, int height, int numChannel, int order, bool parallel) {
+	if (pPixels == nullptr || width <= 0 || height <= 0 || numChannel < 3) {
+		assert(false);
+		return {};
+	}
+
+	std::vector<float> cosPhi(width);
+	std::vector<float> sinPhi(width);
+	for (int i = 0; i < width; ++i) {
+		double phi = ((i + 0.5) / width - 0.5) * 2.0 * kPI;
+		cosPhi[i] = static_cast<float>(std::cos(phi));
+		sinPhi[i] = static_cast<float>(std::sin(phi));
+	}
+
+	return projectRows(height, order, parallel, [&](size_t row, SHRowAccumulator &accumulator) {
+		// exact solid angle of a texel row: 2PI / width * (sin(top latitude) - sin(bottom latitude))
+		double topLatitude = (0.5 - static_cast<double>(row) / height) * kPI;
+		double bottomLatitude = (0.5 - static_cast<double>(row + 1) / height) * kPI;
+		double latitude = (0.5 - (row + 0.5) / height) * kPI;
+		float solidAngle = static_cast<float>(2.0 * kPI / width * (std::sin(topLatitude) - std::sin(bottomLatitude)));
+		float cosLatitude = static_cast<float>(std::cos(latitude));
+		float sinLatitude = static_cast<float>(std::sin(latitude));
+
+		const float *pRow = pPixels + row * width * numChannel;
+		SHTexelBatch batch;
+		for (int i = 0; i < width; ++i) {
+			float direction[3] = { cosLatitude * cosPhi[i], sinLatitude, cosLatitude * sinPhi[i] };
+			batch.push(direction, pRow + i * numChannel, solidAngle);
+			if (batch.count == 4)
+				batch.flush(accumulator);
+		}
+		batch.flush(accumulator);
+	});
+}
+
+// https://www.rorydriscoll.com/2012/01/15/cubemap-texel-solid-angle/
+static float calcAreaElement(double x, double y) {
+	return static_cast<float>(std::atan2(x * y, std::sqrt(x*x + y*y + 1.0)));
+}
+
+SHCoefficients projectCubeMapToSH(const float *const pFaces[6], int size, int numChannel, int order, bool parallel) {
+	if (pFaces == nullptr || size <= 0 || numChannel < 3) {
+		assert(false);
+		return {};
+	}
+
+	return projectRows(size * 6, order, parallel, [&](size_t row, SHRowAccumulator &accumulator) {
+		int face = static_cast<int>(row) / size;
+		int y = static_cast<int>(row) % size;
+		const float *pRow = pFaces[face] + static_cast<size_t>(y) * size * numChannel;
+		double invSize = 1.0 / size;
+		double t0 = 2.0 * y * invSize - 1.0;
+		double t1 = t0 + 2.0 * invSize;
+		float v = static_cast<float>((y + 0.5) * invSize);
+
+		SHTexelBatch batch;
+		for (int x = 0; x < size; ++x) {
+			double s0 = 2.0 * x * invSize - 1.0;
+			double s1 = s0 + 2.0 * invSize;
+			float solidAngle = calcAreaElement(s0, t0) - calcAreaElement(s0, t1) - calcAreaElement(s1, t0) + calcAreaElement(s1, t1);
+			float direction[3];
+			calcCubeMapDirection(face, static_cast<float>((x + 0.5) * invSize), v, direction);
+			batch.push(direction, pRow + x * numChannel, solidAngle);
+			if (batch.count == 4)
+				batch.flush(accumulator);
+		}
+		batch.flush(accumulator);
+	});
+}
+
+// band rotation matrices, Ivanic & Ruedenberg, "Rotation Matrices for Real Spherical Harmonics" (1996, errata 1998)
+class SHBandRotation {
+public:
+	SHBandRotation(int l) : _l(l), _data((2*l+1) * (2*l+1), 0.0) {}
+	double operator()(int m, int n) const { return _data[(m + _l) * (2*_l+1) + (n + _l)]; }
+	double &operator()(int m, int n) { return _data[(m + _l) * (2*_l+1) + (n + _l)]; }
+private:
+	int _l;
+	std::vector<double> _data;
+};
+
+static double calcP(int i, int a, int b, int l, const SHBandRotation &r1, const SHBandRotation &prev) {
+	if (b == l)
+		return r1(i, 1) * prev(a, l-1) - r1(i, -1) * prev(a, -l+1);
+	if (b == -l)
+		return r1(i, 1) * prev(a, -l+1) + r1(i, -1) * prev(a, l-1);
+	return r1(i, 0) * prev(a, b);
+}
+
+static double calcU(int m, int n, int l, const SHBandRotation &r1, const SHBandRotation &prev) {
+	return calcP(0, m, n, l, r1, prev);
+}
+
+static double calcV(int m, int n, int l, const SHBandRotation &r1, const SHBandRotation &prev) {
+	if (m == 0)
+		return calcP(1, 1, n, l, r1, prev) + calcP(-1, -1, n, l, r1, prev);
+	if (m > 0) {
+		double d = m == 1 ? 1.0 : 0.0;
+		return calcP(1, m-1, n, l, r1, prev) * std::sqrt(1.0 + d) - calcP(-1, -m+1, n, l, r1, prev) * (1.0 - d);
+	}
+	double d = m == -1 ? 1.0 : 0.0;
+	return calcP(1, m+1, n, l, r1, prev) * (1.0 - d) + calcP(-1, -m-1, n, l, r1, prev) * std::sqrt(1.0 + d);
+}
+
+static double calcW(int m, int n, int l, const SHBandRotation &r1, const SHBandRotation &prev) {
+	if (m > 0)
+		return calcP(1, m+1, n, l, r1, prev) + calcP(-1, -m-1, n, l, r1, prev);
+	return calcP(1, m-1, n, l, r1, prev) - calcP(-1, -m+1, n, l, r1, prev);
+}
+
+SHCoefficients rotateSH(const SHCoefficients &sh, const float rotation[3][3]) {
+	SHCoefficients result(sh.order);
+	for (size_t c = 0; c < 3; ++c)
+		result.channels[c][0] = sh.channels[c][0];
+	if (sh.order < 2)
+		return result;
+
+	// band 1 is ordered (y, z, x)
+	constexpr int kAxis[3] = { 1, 2, 0 };
+	SHBandRotation r1(1);
+	for (int m = -1; m <= 1; ++m) {
+		for (int n = -1; n <= 1; ++n)
+			r1(m, n) = rotation[kAxis[m+1]][kAxis[n+1]];
+	}
+
+	auto applyBand = [&](int l, const SHBandRotation &band) {
+		for (size_t c = 0; c < 3; ++c) {
+			for (int m = -l; m <= l; ++m) {
+				double sum = 0.0;
+				for (int n = -l; n <= l; ++n)
+					sum += band(m, n) * sh.channels[c][calcSHIndex(l, n)];
+				result.channels[c][calcSHIndex(l, m)] = static_cast<float>(sum);
+			}
+		}
+	};
+	applyBand(1, r1);
+
+	SHBandRotation prev = r1;
+	for (int l = 2; l < sh.order; ++l) {
+		SHBandRotation band(l);
+		for (int m = -l; m <= l; ++m) {
+			for (int n = -l; n <= l; ++n) {
+				double d = m == 0 ? 1.0 : 0.0;
+				int absM = std::abs(m);
+				double denominator = std::abs(n) == l ? 2.0 * l * (2.0 * l - 1.0) : static_cast<double>((l + n) * (l - n));
+				double u = std::sqrt((l + m) * (l - m) / denominator);
+				double v = 0.5 * std::sqrt((1.0 + d) * (l + absM - 1.0) * (l + absM) / denominator) * (1.0 - 2.0 * d);
+				double w = -0.5 * std::sqrt((l - absM - 1.0) * (l - absM) / denominator) * (1.0 - d);
+
+				double value = 0.0;
+				if (u != 0.0)
+					value += u * calcU(m, n, l, r1, prev);
+				if (v != 0.0)
+					value += v * calcV(m, n, l, r1, prev);
+				if (w != 0.0)
+					value += w * calcW(m, n, l, r1, prev);
+				band(m, n) = value;
+			}
+		}
+		applyBand(l, band);
+		prev = std::move(band);
+	}
+	return result;
+}
+
+void applySHBandScale(SHCoefficients &sh, const std::vector<float> &bandScales) {
+	assert(bandScales.size() >= static_cast<size_t>(sh.order));
+	for (int l = 0; l < sh.order; ++l) {
+		for (int m = -l; m <= l; ++m) {
+			for (auto &channel : sh.channels)
+				channel[calcSHIndex(l, m)] *= bandScales[l];
+		}
+	}
+}
+
+void convolveSHZonal(SHCoefficients &sh, const std::vector<float> &zonalCoeffs) {
+	assert(zonalCoeffs.size() >= static_cast<size_t>(sh.order));
+	std::vector<float> bandScales(sh.order);
+	for (int l = 0; l < sh.order; ++l)
+		bandScales[l] = static_cast<float>(std::sqrt(4.0 * kPI / (2.0 * l + 1.0)) * zonalCoeffs[l]);
+	applySHBandScale(sh, bandScales);
+}
+
+// Ramamoorthi & Hanrahan, "An Efficient Representation for Irradiance Environment Maps"
+std::vector<float> calcSHCosineLobeBandScale(int order) {
+	std::vector<float> bandScales(order, 0.f);
+	for (int l = 0; l < order; ++l) {
+		double value = 0.0;
+		if (l == 0) {
+			value = kPI;
+		} else if (l == 1) {
+			value = 2.0 * kPI / 3.0;
+		} else if (l % 2 == 0) {
+			double sign = (l / 2) % 2 == 0 ? -1.0 : 1.0;
+			double logRatio = std::lgamma(l + 1.0) - l * std::log(2.0) - 2.0 * std::lgamma(l / 2 + 1.0);
+			value = 2.0 * kPI * sign / ((l + 2.0) * (l - 1.0)) * std::exp(logRatio);
+		}
+		bandScales[l] = static_cast<float>(value);
+	}
+	return bandScales;
+}
+
+std::vector<float> calcSHHanningWindow(int order, float width) {
+	std::vector<float> window(order, 0.f);
+	for (int l = 0; l < order; ++l) {
+		if (l <= width)
+			window[l] = static_cast<float>(0.5 * (1.0 + std::cos(kPI * l / width)));
+	}
+	return window;
+}
+
+std::vector<float> calcSHLanczosWindow(int order, float width) {
+	std::vector<float> window(order, 0.f);
+	window[0] = 1.f;
+	for (int l = 1; l < order; ++l) {
+		if (l < width) {
+			double x = kPI * l / width;
+			window[l] = static_cast<float>(std::sin(x) / x);
+		}
+	}
+	return window;
+}
+
+}
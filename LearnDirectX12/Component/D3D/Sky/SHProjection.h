@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace d3d {
+
+// Real spherical harmonics of any order (number of bands). Coefficient k = l*(l+1)+m,
+// same ordering and sign convention as SHBasisFunction in SphericalHarmonics.hpp
+constexpr int kMaxSHOrder = 32;
+
+constexpr size_t calcSHCoeffCount(int order) noexcept {
+	return static_cast<size_t>(order) * static_cast<size_t>(order);
+}
+
+constexpr size_t calcSHIndex(int l, int m) noexcept {
+	return static_cast<size_t>(l * (l + 1) + m);
+}
+
+// RGB coefficients stored per channel (SoA)
+struct SHCoefficients {
+	int order = 0;
+	std::vector<float> channels[3];
+public:
+	SHCoefficients() = default;
+	explicit SHCoefficients(int order);
+	size_t getNumCoeff() const;
+	void eval(const float direction[3], float rgb[3]) const;
+	SHCoefficients &operator+=(const SHCoefficients &other);
+	SHCoefficients &operator*=(float scale);
+};
+
+// Evaluates every basis function up to the order with the associated Legendre recurrence,
+// normalization constants are computed once per evaluator
+class SHBasisEvaluator {
+public:
+	explicit SHBasisEvaluator(int order);
+	int getOrder() const;
+	// direction must be normalized, pOut receives calcSHCoeffCount(order) values
+	void eval(float x, float y, float z, float *pOut) const;
+	// four directions at once, pOut[k * 4 + lane]
+	void eval4(const float *pX, const float *pY, const float *pZ, float *pOut) const;
+private:
+	template<typename V>
+	void evalImpl(V x, V y, V z, V *pOut) const;
+private:
+	int _order;
+	std::vector<float> _normalization;				// K(l, m) * (2m-1)!!, sqrt(2) folded in for m != 0
+	std::vector<float> _recurrenceA;				// (2l-1) / (l-m)
+	std::vector<float> _recurrenceB;				// (l+m-1) / (l-m)
+};
+
+// Equirect layout of PanoToCubeMapCS: u = atan2(z, x) / 2PI + 0.5, v = 0.5 - asin(y) / PI
+void calcEquirectDirection(float u, float v, float direction[3]);
+// D3D cube face order +X -X +Y -Y +Z -Z, u/v in [0, 1] with v pointing down
+void calcCubeMapDirection(int face, float u, float v, float direction[3]);
+// inverse of calcCubeMapDirection, direction does not need to be normalized
+void calcCubeMapFaceUV(const float direction[3], int &face, float &u, float &v);
+
+// Projection with exact per texel solid angle, rows are spread across threads.
+// pPixels is float RGB(A) with numChannel >= 3
+SHCoefficients projectEquirectToSH(const float *pPixels, int width, int height, int numChannel, int order, bool parallel = true);
+SHCoefficients projectCubeMapToSH(const float *const pFaces[6], int size, int numChannel, int order, bool parallel = true);
+
+// Rotate so the function follows the rotation: f'(R * d) = f(d). rotation is row major, applied to column vectors
+SHCoefficients rotateSH(const SHCoefficients &sh, const float rotation[3][3]);
+
+// per band scale, sh_lm *= bandScales[l]
+void applySHBandScale(SHCoefficients &sh, const std::vector<float> &bandScales);
+// convolution with a circularly symmetric kernel given by its zonal coefficients
+void convolveSHZonal(SHCoefficients &sh, const std::vector<float> &zonalCoeffs);
+// clamped cosine lobe (A_l), radiance * A_l = irradiance
+std::vector<float> calcSHCosineLobeBandScale(int order);
+// ringing suppression windows, width is usually the order
+std::vector<float> calcSHHanningWindow(int order, float width);
+std::vector<float> calcSHLanczosWindow(int order, float width);
+
+}
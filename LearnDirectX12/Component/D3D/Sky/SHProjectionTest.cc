@@ -0,0 +1,142 @@
+#include <cmath>
+#include <vector>
+#include "TestCheck.h"
+#include "D3D/Sky/SHProjection.h"
+#include "JobSystem/JobSystem.h"
+
+using namespace d3d;
+
+void shProjectionTest() {
+	constexpr float kPI = 3.14159265f;
+	auto nearlyEqual = [](float a, float b, float epsilon) { return std::abs(a - b) <= epsilon; };
+
+	// recurrence against the closed forms of SphericalHarmonics.hpp
+	SHBasisEvaluator evaluator(5);
+	float x = 0.48f, y = -0.6f, z = 0.64f;
+	float basis[25];
+	evaluator.eval(x, y, z, basis);
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(0, 0)], 0.5f * std::sqrt(1.f / kPI), 1e-5f));
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(1, 1)], std::sqrt(3.f / (4.f * kPI)) * x, 1e-5f));
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(2, -1)], 0.5f * std::sqrt(15.f / kPI) * y * z, 1e-5f));
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(3, -3)], 0.25f * std::sqrt(35.f / (2.f * kPI)) * y * (3.f * x * x - y * y), 1e-5f));
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(3, +1)], 0.25f * std::sqrt(21.f / (2.f * kPI)) * x * (5.f * z * z - 1.f), 1e-5f));
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(4, -1)], 0.75f * std::sqrt(5.f / (2.f * kPI)) * y * (7.f * z * z * z - 3.f * z), 1e-5f));
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(4, +3)], 0.75f * std::sqrt(35.f / (2.f * kPI)) * x * (x * x - 3.f * y * y) * z, 1e-5f));
+	TEST_CHECK(nearlyEqual(basis[calcSHIndex(4, +4)], 3.f / 16.f * std::sqrt(35.f / kPI) * (x * x * (x * x - 3.f * y * y) - y * y * (3.f * x * x - y * y)), 1e-5f));
+
+	// the four lane path matches the scalar one
+	float xs[4] = { x, 0.f, 1.f, -0.6f };
+	float ys[4] = { y, 1.f, 0.f, 0.f };
+	float zs[4] = { z, 0.f, 0.f, 0.8f };
+	float basis4[25 * 4];
+	evaluator.eval4(xs, ys, zs, basis4);
+	for (size_t lane = 0; lane < 4; ++lane) {
+		evaluator.eval(xs[lane], ys[lane], zs[lane], basis);
+		for (size_t k = 0; k < 25; ++k)
+			TEST_CHECK(nearlyEqual(basis4[k * 4 + lane], basis[k], 1e-6f));
+	}
+
+	// projecting a basis function gives back a unit coefficient on both layouts
+	constexpr int kOrder = 6;
+	SHBasisEvaluator highEvaluator(kOrder);
+	const size_t kTargets[] = { calcSHIndex(0, 0), calcSHIndex(1, -1), calcSHIndex(3, 2), calcSHIndex(5, -4) };
+	constexpr int kWidth = 256;
+	constexpr int kHeight = 128;
+	constexpr int kCubeSize = 48;
+	for (size_t target : kTargets) {
+		std::vector<float> basisValues(calcSHCoeffCount(kOrder));
+		std::vector<float> equirect(kWidth * kHeight * 3, 0.f);
+		for (int j = 0; j < kHeight; ++j) {
+			for (int i = 0; i < kWidth; ++i) {
+				float direction[3];
+				calcEquirectDirection((i + 0.5f) / kWidth, (j + 0.5f) / kHeight, direction);
+				highEvaluator.eval(direction[0], direction[1], direction[2], basisValues.data());
+				equirect[(j * kWidth + i) * 3 + 1] = basisValues[target];
+			}
+		}
+
+		std::vector<float> faces[6];
+		const float *pFaces[6];
+		for (int face = 0; face < 6; ++face) {
+			faces[face].assign(kCubeSize * kCubeSize * 4, 0.f);
+			for (int j = 0; j < kCubeSize; ++j) {
+				for (int i = 0; i < kCubeSize; ++i) {
+					float direction[3];
+					calcCubeMapDirection(face, (i + 0.5f) / kCubeSize, (j + 0.5f) / kCubeSize, direction);
+					highEvaluator.eval(direction[0], direction[1], direction[2], basisValues.data());
+					faces[face][(j * kCubeSize + i) * 4 + 1] = basisValues[target];
+				}
+			}
+			pFaces[face] = faces[face].data();
+		}
+
+		SHCoefficients fromEquirect = projectEquirectToSH(equirect.data(), kWidth, kHeight, 3, kOrder);
+		SHCoefficients fromCubeMap = projectCubeMapToSH(pFaces, kCubeSize, 4, kOrder, false);
+		for (size_t k = 0; k < calcSHCoeffCount(kOrder); ++k) {
+			float expected = k == target ? 1.f : 0.f;
+			TEST_CHECK(nearlyEqual(fromEquirect.channels[1][k], expected, 2e-3f));
+			TEST_CHECK(nearlyEqual(fromCubeMap.channels[1][k], expected, 2e-3f));
+			TEST_CHECK(fromEquirect.channels[0][k] == 0.f && fromCubeMap.channels[2][k] == 0.f);
+		}
+	}
+
+	// constant radiance: only the DC term, irradiance is PI * radiance in every direction
+	std::vector<float> constant(kWidth * kHeight * 3, 2.f);
+	SHCoefficients constantSH = projectEquirectToSH(constant.data(), kWidth, kHeight, 3, 3);
+	TEST_CHECK(nearlyEqual(constantSH.channels[0][0], 2.f * 2.f * std::sqrt(kPI), 1e-3f));
+	for (size_t k = 1; k < constantSH.getNumCoeff(); ++k)
+		TEST_CHECK(nearlyEqual(constantSH.channels[0][k], 0.f, 4e-3f));
+	applySHBandScale(constantSH, calcSHCosineLobeBandScale(3));
+	float normal[3] = { 0.f, 0.f, 1.f };
+	float irradiance[3];
+	constantSH.eval(normal, irradiance);
+	TEST_CHECK(nearlyEqual(irradiance[0], 2.f * kPI, 1e-3f));
+
+	std::vector<float> cosineLobe = calcSHCosineLobeBandScale(5);
+	TEST_CHECK(nearlyEqual(cosineLobe[1], 2.f * kPI / 3.f, 1e-6f));
+	TEST_CHECK(nearlyEqual(cosineLobe[2], kPI / 4.f, 1e-6f));
+	TEST_CHECK(cosineLobe[3] == 0.f);
+	TEST_CHECK(nearlyEqual(cosineLobe[4], -kPI / 24.f, 1e-6f));
+	std::vector<float> hanning = calcSHHanningWindow(5, 5.f);
+	std::vector<float> lanczos = calcSHLanczosWindow(5, 5.f);
+	TEST_CHECK(hanning[0] == 1.f && lanczos[0] == 1.f && hanning[4] < hanning[1] && lanczos[4] < lanczos[1]);
+
+	// rotating the coefficients of a direction moves the lobe: Y(d) rotated equals Y(R * d)
+	float angle = 0.7f;
+	float axis[3] = { 0.36f, 0.48f, 0.8f };
+	float c = std::cos(angle), s = std::sin(angle), t = 1.f - c;
+	float rotation[3][3] = {
+		{ t*axis[0]*axis[0] + c,         t*axis[0]*axis[1] - s*axis[2], t*axis[0]*axis[2] + s*axis[1] },
+		{ t*axis[0]*axis[1] + s*axis[2], t*axis[1]*axis[1] + c,         t*axis[1]*axis[2] - s*axis[0] },
+		{ t*axis[0]*axis[2] - s*axis[1], t*axis[1]*axis[2] + s*axis[0], t*axis[2]*axis[2] + c         },
+	};
+	float direction[3] = { x, y, z };
+	float rotated[3];
+	for (int i = 0; i < 3; ++i)
+		rotated[i] = rotation[i][0] * direction[0] + rotation[i][1] * direction[1] + rotation[i][2] * direction[2];
+
+	SHCoefficients lobe(kOrder);
+	highEvaluator.eval(direction[0], direction[1], direction[2], lobe.channels[0].data());
+	SHCoefficients rotatedLobe = rotateSH(lobe, rotation);
+	std::vector<float> expected(calcSHCoeffCount(kOrder));
+	highEvaluator.eval(rotated[0], rotated[1], rotated[2], expected.data());
+	for (size_t k = 0; k < expected.size(); ++k)
+		TEST_CHECK(nearlyEqual(rotatedLobe.channels[0][k], expected[k], 1e-4f));
+
+	// rotation keeps the energy of every band
+	for (int l = 0; l < kOrder; ++l) {
+		float before = 0.f, after = 0.f;
+		for (int m = -l; m <= l; ++m) {
+			before += lobe.channels[0][calcSHIndex(l, m)] * lobe.channels[0][calcSHIndex(l, m)];
+			after += rotatedLobe.channels[0][calcSHIndex(l, m)] * rotatedLobe.channels[0][calcSHIndex(l, m)];
+		}
+		TEST_CHECK(nearlyEqual(before, after, 1e-4f));
+	}
+}
+
+int main() {
+	com::JobSystem::emplace(4);
+	shProjectionTest();
+	com::JobSystem::destroy();
+	return 0;
+}
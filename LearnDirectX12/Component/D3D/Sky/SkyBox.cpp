@@ -52,25 +52,28 @@ SkyBox::SkyBox(const SkyBoxDesc &desc) : _pCubeMap(desc.pCubeMap) {
 	depthStencilDesc.DepthEnable = true;
 	depthStencilDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
 	depthStencilDesc.StencilEnable = false;
-	depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	depthStencilDesc.DepthFunc = desc.reverseZ ? D3D12_COMPARISON_FUNC_GREATER_EQUAL : D3D12_COMPARISON_FUNC_LESS_EQUAL;
 	_pSkyBoxPSO->setDepthStencilState(depthStencilDesc);
 
 	CD3DX12_RASTERIZER_DESC rasterizerDesc(D3D12_DEFAULT);
 	rasterizerDesc.CullMode = D3D12_CULL_MODE_NONE;
 	_pSkyBoxPSO->setRasterizerState(rasterizerDesc);
 
-	D3D_SHADER_MACRO macros[3] = {
-		desc.enableGammaCorrection	? "ENABLE_GAMMA_CORRECTION"	 : nullptr, nullptr,
-		desc.enableToneMapping		? "ENABLE_TONE_MAPPING"		 : nullptr, nullptr,
-		nullptr, nullptr,
-	};
+	std::vector<D3D_SHADER_MACRO> macros;
+	if (desc.enableGammaCorrection)
+		macros.emplace_back("ENABLE_GAMMA_CORRECTION", nullptr);
+	if (desc.enableToneMapping)
+		macros.emplace_back("ENABLE_TONE_MAPPING", nullptr);
+	if (desc.reverseZ)
+		macros.emplace_back("REVERSE_Z", nullptr);
+	macros.emplace_back(nullptr, nullptr);
 
 	auto skyBoxContent = getD3DResource("HlslShader/SkyBox.hlsl");
 	_pSkyBoxPSO->setVertexShader(compileShaderParseInclude(
 		"HlslShader/SkyBox.hlsl",
 		skyBoxContent.begin(),
 		skyBoxContent.size(),
-		macros,
+		macros.data(),
 		"VS",
 		"vs_5_0"
 	));
@@ -79,7 +82,7 @@ SkyBox::SkyBox(const SkyBoxDesc &desc) : _pCubeMap(desc.pCubeMap) {
 		"HlslShader/SkyBox.hlsl",
 		skyBoxContent.begin(),
 		skyBoxContent.size(),
-		macros,
+		macros.data(),
 		"PS",
 		"ps_5_0"
 	));
@@ -14,6 +14,7 @@ struct SkyBoxDesc {
 	DXGI_FORMAT depthStencilFormat;
 	bool enableGammaCorrection = false;
 	bool enableToneMapping = false;
+	bool reverseZ = false;				// CameraBase::isReverseZ of the camera it is rendered with
 };
 
 class SkyBox {
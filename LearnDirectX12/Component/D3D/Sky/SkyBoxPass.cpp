@@ -17,13 +17,14 @@ SkyBoxPass::SkyBoxPass(const std::string &passName) : GraphicsPass(passName, tru
 
 void SkyBoxPass::execute(dx12lib::DirectContextProxy pDirectCtx) {
 	assert(pEnvMap != nullptr);
-	assert(pCamera != nullptr);
+	assert(_hasCamera);
 	assert(renderTargetFormat != DXGI_FORMAT_UNKNOWN);
 	assert(depthStencilFormat != DXGI_FORMAT_UNKNOWN);
 
 	GraphicsPass::execute(pDirectCtx);
 
-	if (_pGraphicsPso == nullptr) 
+	// the depth mode is baked into the PSO, a camera that switched it needs a new one
+	if (_pGraphicsPso == nullptr || _psoReverseZ != _reverseZ || _psoDepthFunc != _depthFunc)
 		buildGraphicsPso(pDirectCtx);
 	if (_pCubeVertexBuffer == nullptr)
 		_pCubeVertexBuffer = SkyBox::buildCubeVertexBuffer(pDirectCtx);
@@ -33,15 +34,9 @@ void SkyBoxPass::execute(dx12lib::DirectContextProxy pDirectCtx) {
 	pDirectCtx->setShaderResourceView(dx12lib::RegisterSlot::SRV0, pEnvMap->getSRV());
 	pDirectCtx->setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	auto matView = pCamera->getView();
-	matView._41 = 0.f; matView._42 = 0.f; matView._43 = 0.f;
-	Matrix4 view(matView);
-	Matrix4 proj(pCamera->getProj());
-	float4x4 viewProj = static_cast<float4x4>(proj * view);
-
 	pDirectCtx->setGraphics32BitConstants(dx12lib::RegisterSlot::CBV0, 
 		sizeof(float4x4) / sizeof(float),
-		&viewProj
+		&_viewProj
 	);
 
 	pDirectCtx->drawInstanced(
@@ -51,6 +46,17 @@ void SkyBoxPass::execute(dx12lib::DirectContextProxy pDirectCtx) {
 	);
 }
 
+void SkyBoxPass::setCamera(const CameraBase &camera) {
+	auto matView = camera.getView();
+	matView._41 = 0.f; matView._42 = 0.f; matView._43 = 0.f;
+	Matrix4 view(matView);
+	Matrix4 proj(camera.getProj());
+	_viewProj = static_cast<float4x4>(proj * view);
+	_reverseZ = camera.isReverseZ();
+	_depthFunc = camera.getDepthComparisonFunc();
+	_hasCamera = true;
+}
+
 void SkyBoxPass::buildGraphicsPso(dx12lib::DirectContextProxy pDirectCtx) {
 	auto pSharedDevice = pDirectCtx->getDevice().lock();
 	auto pRootSignature = pSharedDevice->createRootSignature(2, 1);
@@ -69,6 +75,8 @@ void SkyBoxPass::buildGraphicsPso(dx12lib::DirectContextProxy pDirectCtx) {
 		macros.emplace_back("ENABLE_TONE_MAPPING", nullptr);
 	if (enableGammaCorrection)
 		macros.emplace_back("ENABLE_GAMMA_CORRECTION", nullptr);
+	if (_reverseZ)
+		macros.emplace_back("REVERSE_Z", nullptr);
 	macros.emplace_back(nullptr, nullptr);
 	_pGraphicsPso = pSharedDevice->createGraphicsPSO("SkyBoxPassPSO");
 	_pGraphicsPso->setRootSignature(pRootSignature);
@@ -79,7 +87,7 @@ void SkyBoxPass::buildGraphicsPso(dx12lib::DirectContextProxy pDirectCtx) {
 	_pGraphicsPso->setRasterizerState(rasterizerDesc);
 
 	CD3DX12_DEPTH_STENCIL_DESC depthStencilDesc(D3D12_DEFAULT);
-	depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	depthStencilDesc.DepthFunc = _depthFunc;
 	_pGraphicsPso->setDepthStencilState(depthStencilDesc);
 
 	_pGraphicsPso->setInputLayout({
@@ -112,6 +120,8 @@ void SkyBoxPass::buildGraphicsPso(dx12lib::DirectContextProxy pDirectCtx) {
 		"ps_5_0"
 	));
 	_pGraphicsPso->finalize();
+	_psoReverseZ = _reverseZ;
+	_psoDepthFunc = _depthFunc;
 }
 
 }
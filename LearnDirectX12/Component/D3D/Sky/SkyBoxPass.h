@@ -8,19 +8,26 @@ class SkyBoxPass : public rgph::GraphicsPass {
 public:
 	SkyBoxPass(const std::string &passName);
 	void execute(dx12lib::DirectContextProxy pDirectCtx) override;
+	// copies the matrices and depth mode of the camera being rendered, call it before every execute
+	void setCamera(const CameraBase &camera);
 public:
 	bool enableToneMapping = false;
 	bool enableGammaCorrection = false;
 	DXGI_FORMAT renderTargetFormat = DXGI_FORMAT_UNKNOWN;
 	DXGI_FORMAT depthStencilFormat = DXGI_FORMAT_UNKNOWN;
 	std::shared_ptr<dx12lib::ITextureResourceCube> pEnvMap;
-	CameraBase *pCamera = nullptr;
 private:
 	void buildGraphicsPso(dx12lib::DirectContextProxy pDirectCtx);
 private:
 	std::shared_ptr<dx12lib::GraphicsPSO> _pGraphicsPso;
 	std::shared_ptr<dx12lib::VertexBuffer> _pCubeVertexBuffer;
 	std::shared_ptr<dx12lib::RootSignature> _pRootSignature;
+	bool _hasCamera = false;
+	bool _reverseZ = false;
+	D3D12_COMPARISON_FUNC _depthFunc = D3D12_COMPARISON_FUNC_LESS;
+	bool _psoReverseZ = false;								// what _pGraphicsPso was built with
+	D3D12_COMPARISON_FUNC _psoDepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	Math::float4x4 _viewProj;
 };
 
 }
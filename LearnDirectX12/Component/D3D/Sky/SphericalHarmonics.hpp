@@ -34,22 +34,22 @@ DECLARE_SH_BASIS_FUNCTION( (2), (+0), (0.25f * sqrt(5.f / PI)), (3.f * z * z - 1
 DECLARE_SH_BASIS_FUNCTION( (2), (+1), (0.5f * sqrt(15.f / PI)), (x * z) );
 DECLARE_SH_BASIS_FUNCTION( (2), (+2), (0.25f * sqrt(15.f / PI)), (x * x - y * y) );
 
-DECLARE_SH_BASIS_FUNCTION( (3), (-3), (0.25f * sqrt(35.f / 2.f * PI)), (y * (3.f * x * x - y * y)) );
+DECLARE_SH_BASIS_FUNCTION( (3), (-3), (0.25f * sqrt(35.f / (2.f * PI))), (y * (3.f * x * x - y * y)) );
 DECLARE_SH_BASIS_FUNCTION( (3), (-2), (0.5f * sqrt(105.f / PI)), (x * y * z) );
-DECLARE_SH_BASIS_FUNCTION( (3), (-1), (0.25f * sqrt(21.f / 2.f * PI)), (y * (5.f * z * z - 1.f)) );
+DECLARE_SH_BASIS_FUNCTION( (3), (-1), (0.25f * sqrt(21.f / (2.f * PI))), (y * (5.f * z * z - 1.f)) );
 DECLARE_SH_BASIS_FUNCTION( (3), (+0), (0.25f * sqrt(7.f / PI)), (5.f * z * z * z - 3.f * z) );
-DECLARE_SH_BASIS_FUNCTION( (3), (+1), (0.25f * sqrt(21.f / 2.f * PI)), (x * (5.f * z * z - 1.f)) );
+DECLARE_SH_BASIS_FUNCTION( (3), (+1), (0.25f * sqrt(21.f / (2.f * PI))), (x * (5.f * z * z - 1.f)) );
 DECLARE_SH_BASIS_FUNCTION( (3), (+2), (0.25f * sqrt(105.f / PI)), ((x * x - y * y) * z) );
-DECLARE_SH_BASIS_FUNCTION( (3), (+3), (0.25f * sqrt(35.f / 2.f * PI)), (x * (x * x - 3.f * y * y)) );
+DECLARE_SH_BASIS_FUNCTION( (3), (+3), (0.25f * sqrt(35.f / (2.f * PI))), (x * (x * x - 3.f * y * y)) );
 
 DECLARE_SH_BASIS_FUNCTION( (4), (-4), (0.75f * sqrt(35.f / PI)), (x * y * (x * x - y * y)) );
-DECLARE_SH_BASIS_FUNCTION( (4), (-3), (0.75f * sqrt(35.f / 2.f * PI)), (y * (3.f * x * x - y * y) * z) );
+DECLARE_SH_BASIS_FUNCTION( (4), (-3), (0.75f * sqrt(35.f / (2.f * PI))), (y * (3.f * x * x - y * y) * z) );
 DECLARE_SH_BASIS_FUNCTION( (4), (-2), (0.75f * sqrt(5.f / PI)), (x * y * (7.f * z * z - 1.f)) );
-DECLARE_SH_BASIS_FUNCTION( (4), (-1), (0.75f * sqrt(5.f / 2.f * PI)), (y * (7.f * z * z * z - 3.f * z)) );
+DECLARE_SH_BASIS_FUNCTION( (4), (-1), (0.75f * sqrt(5.f / (2.f * PI))), (y * (7.f * z * z * z - 3.f * z)) );
 DECLARE_SH_BASIS_FUNCTION( (4), (+0), (3.f / 16.f * sqrt(1.f / PI)), (35.f * z * z * z * z - 30.f * z * z + 3.f) );
-DECLARE_SH_BASIS_FUNCTION( (4), (+1), (0.75f * sqrt(5.f / 2.f * PI)), (x * (7.f * z * z * z - 3.f * z)) );
+DECLARE_SH_BASIS_FUNCTION( (4), (+1), (0.75f * sqrt(5.f / (2.f * PI))), (x * (7.f * z * z * z - 3.f * z)) );
 DECLARE_SH_BASIS_FUNCTION( (4), (+2), (3.f / 8.f * sqrt(5.f / PI)), ((x * x - y * y) * (7.f * z * z - 1.f)) );
-DECLARE_SH_BASIS_FUNCTION( (4), (+3), (0.75f * sqrt(35.f / 2.f * PI)), (x * (x * x - 3.f * y * y) * z) );
+DECLARE_SH_BASIS_FUNCTION( (4), (+3), (0.75f * sqrt(35.f / (2.f * PI))), (x * (x * x - 3.f * y * y) * z) );
 DECLARE_SH_BASIS_FUNCTION( (4), (+4), (3.f / 16.f * sqrt(35.f / PI)), (x * x * (x * x - 3.f * y * y) - y * y * (3.f * x * x - y * y)) );
 
 union SH3 {
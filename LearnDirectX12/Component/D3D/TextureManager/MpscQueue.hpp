@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace d3d {
+
+// Unbounded lock-free multi-producer single-consumer queue (Vyukov's intrusive node queue).
+// push() may be called from any thread, tryPop() only from the single consumer thread
+template<typename T>
+class MpscQueue {
+	struct Node {
+		std::atomic<Node *> pNext = nullptr;
+		T value;
+	};
+public:
+	MpscQueue() {
+		Node *pStub = new Node();
+		_pHead.store(pStub, std::memory_order_relaxed);
+		_pTail = pStub;
+	}
+
+	MpscQueue(const MpscQueue &) = delete;
+	MpscQueue &operator=(const MpscQueue &) = delete;
+
+	~MpscQueue() {
+		while (_pTail != nullptr) {
+			Node *pNext = _pTail->pNext.load(std::memory_order_relaxed);
+			delete _pTail;
+			_pTail = pNext;
+		}
+	}
+
+	void push(T value) {
+		Node *pNode = new Node();
+		pNode->value = std::move(value);
+		Node *pPrev = _pHead.exchange(pNode, std::memory_order_acq_rel);
+		pPrev->pNext.store(pNode, std::memory_order_release);
+	}
+
+	// false when the queue is empty, or a producer is halfway through push()
+	bool tryPop(T &value) {
+		Node *pTail = _pTail;
+		Node *pNext = pTail->pNext.load(std::memory_order_acquire);
+		if (pNext == nullptr)
+			return false;
+
+		value = std::move(pNext->value);
+		_pTail = pNext;
+		delete pTail;
+		return true;
+	}
+private:
+	std::atomic<Node *> _pHead;
+	Node *_pTail;
+};
+
+}
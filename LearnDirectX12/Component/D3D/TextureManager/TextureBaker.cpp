@@ -0,0 +1,546 @@
+#include "TextureBaker.h"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <format>
+#include <JobSystem/JobSystem.h>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#define STB_DXT_IMPLEMENTATION
+#include <stb/stb_image.h>			// STB_IMAGE_IMPLEMENTATION lives in IBL.cpp
+#include <stb/stb_image_resize.h>
+#include <stb/stb_dxt.h>
+
+namespace d3d {
+
+// bump when the baked output changes, old cache entries are then ignored
+constexpr static std::uint32_t kTextureBakerVersion = 1;
+
+struct DDSPixelFormat {
+	std::uint32_t size;
+	std::uint32_t flags;
+	std::uint32_t fourCC;
+	std::uint32_t RGBBitCount;
+	std::uint32_t RBitMask;
+	std::uint32_t GBitMask;
+	std::uint32_t BBitMask;
+	std::uint32_t ABitMask;
+};
+
+struct DDSHeader {
+	std::uint32_t  size;
+	std::uint32_t  flags;
+	std::uint32_t  height;
+	std::uint32_t  width;
+	std::uint32_t  pitchOrLinearSize;
+	std::uint32_t  depth;
+	std::uint32_t  mipMapCount;
+	std::uint32_t  reserved1[11];
+	DDSPixelFormat ddspf;
+	std::uint32_t  caps;
+	std::uint32_t  caps2;
+	std::uint32_t  caps3;
+	std::uint32_t  caps4;
+	std::uint32_t  reserved2;
+};
+
+struct DDSHeaderDXT10 {
+	std::uint32_t dxgiFormat;
+	std::uint32_t resourceDimension;
+	std::uint32_t miscFlag;
+	std::uint32_t arraySize;
+	std::uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DDSHeader) == 124);
+static_assert(sizeof(DDSHeaderDXT10) == 20);
+
+constexpr static std::uint32_t kDDSMagic = 0x20534444;				// "DDS "
+constexpr static std::uint32_t kFourCCDX10 = 0x30315844;			// "DX10"
+
+std::vector<std::uint8_t> readBinaryFile(const std::string &fileName) {
+	std::ifstream input(fileName, std::ios::binary | std::ios::ate);
+	if (!input.is_open())
+		return {};
+
+	std::vector<std::uint8_t> data(static_cast<size_t>(input.tellg()));
+	input.seekg(0);
+	input.read(reinterpret_cast<char *>(data.data()), data.size());
+	return data;
+}
+
+static void renormalize(BakedMipLevel &level) {
+	for (size_t i = 0; i < level.data.size(); i += 4) {
+		float x = level.data[i+0] / 255.f * 2.f - 1.f;
+		float y = level.data[i+1] / 255.f * 2.f - 1.f;
+		float z = level.data[i+2] / 255.f * 2.f - 1.f;
+		float length = std::sqrt(x*x + y*y + z*z);
+		if (length < 1e-5f) {
+			x = 0.f; y = 0.f; z = 1.f;
+		} else {
+			x /= length; y /= length; z /= length;
+		}
+		level.data[i+0] = static_cast<std::uint8_t>(std::lround((x * 0.5f + 0.5f) * 255.f));
+		level.data[i+1] = static_cast<std::uint8_t>(std::lround((y * 0.5f + 0.5f) * 255.f));
+		level.data[i+2] = static_cast<std::uint8_t>(std::lround((z * 0.5f + 0.5f) * 255.f));
+	}
+}
+
+static bool hasAlpha(const std::uint8_t *pRgba, size_t numPixel) {
+	for (size_t i = 0; i < numPixel; ++i) {
+		if (pRgba[i*4 + 3] != 255)
+			return true;
+	}
+	return false;
+}
+
+static TextureBlockFormat selectBlockFormat(const BakedMipLevel &level0, const TextureBakeSettings &settings) {
+	if (!settings.compress)
+		return TextureBlockFormat::RGBA8;
+
+	switch (settings.role) {
+	case TextureRole::Normal:
+		return TextureBlockFormat::BC5;
+	case TextureRole::Mask:
+		return TextureBlockFormat::BC1;
+	case TextureRole::Albedo:
+	case TextureRole::Linear:
+	default: {
+		size_t numPixel = static_cast<size_t>(level0.width) * level0.height;
+		return hasAlpha(level0.data.data(), numPixel) ? TextureBlockFormat::BC3 : TextureBlockFormat::BC1;
+	}
+	}
+}
+
+std::uint32_t BakedTexture::getMipCount() const {
+	return static_cast<std::uint32_t>(mips.size() / std::max(arraySize, 1u));
+}
+
+std::uint32_t BakedTexture::getDxgiFormat() const {
+	switch (format) {
+	case TextureBlockFormat::RGBA16F:	return 10;				// DXGI_FORMAT_R16G16B16A16_FLOAT
+	case TextureBlockFormat::RG16F:	return 34;					// DXGI_FORMAT_R16G16_FLOAT
+	case TextureBlockFormat::BC1:	return sRGB ? 72 : 71;		// DXGI_FORMAT_BC1_UNORM_SRGB / DXGI_FORMAT_BC1_UNORM
+	case TextureBlockFormat::BC3:	return sRGB ? 78 : 77;		// DXGI_FORMAT_BC3_UNORM_SRGB / DXGI_FORMAT_BC3_UNORM
+	case TextureBlockFormat::BC4:	return 80;					// DXGI_FORMAT_BC4_UNORM
+	case TextureBlockFormat::BC5:	return 83;					// DXGI_FORMAT_BC5_UNORM
+	case TextureBlockFormat::RGBA8:
+	default:
+		return sRGB ? 29 : 28;									// DXGI_FORMAT_R8G8B8A8_UNORM_SRGB / DXGI_FORMAT_R8G8B8A8_UNORM
+	}
+}
+
+bool BakedTexture::isBlockCompressed() const {
+	switch (format) {
+	case TextureBlockFormat::BC1:
+	case TextureBlockFormat::BC3:
+	case TextureBlockFormat::BC4:
+	case TextureBlockFormat::BC5:
+		return true;
+	default:
+		return false;
+	}
+}
+
+std::uint32_t BakedTexture::getBytesPerPixel() const {
+	switch (format) {
+	case TextureBlockFormat::RGBA16F:	return 8;
+	case TextureBlockFormat::RG16F:		return 4;
+	case TextureBlockFormat::RGBA8:		return 4;
+	default:
+		assert(false);
+		return 0;
+	}
+}
+
+TextureBaker::TextureBaker(std::string cacheDirectory)
+: _cacheDirectory(std::move(cacheDirectory))
+{
+}
+
+BakedTexture TextureBaker::bakeImage(const std::uint8_t *pRgba,
+	std::uint32_t width,
+	std::uint32_t height,
+	const TextureBakeSettings &settings,
+	bool parallel)
+{
+	assert(pRgba != nullptr && width > 0 && height > 0);
+	BakedTexture texture;
+	texture.width = width;
+	texture.height = height;
+	texture.sRGB = (settings.role == TextureRole::Albedo);
+	if (settings.generateMips) {
+		texture.mips = generateMipChain(pRgba, width, height, settings.role);
+	} else {
+		BakedMipLevel level0;
+		level0.width = width;
+		level0.height = height;
+		level0.data.assign(pRgba, pRgba + static_cast<size_t>(width) * height * 4);
+		texture.mips.push_back(std::move(level0));
+	}
+
+	texture.format = selectBlockFormat(texture.mips[0], settings);
+	if (texture.format == TextureBlockFormat::RGBA8)
+		return texture;
+
+	// a grain of the whole chain keeps it on this thread
+	size_t numMips = texture.mips.size();
+	com::parallelFor(0, numMips, parallel ? 1 : numMips, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			texture.mips[i].data = compressLevel(texture.mips[i], texture.format, settings.highQuality);
+	});
+	return texture;
+}
+
+BakedTexture TextureBaker::bakeMemory(const void *pData, size_t size, const TextureBakeSettings &settings, bool parallel) {
+	int width = 0;
+	int height = 0;
+	int channel = 0;
+	stbi_uc *pRgba = stbi_load_from_memory(static_cast<const stbi_uc *>(pData),
+		static_cast<int>(size),
+		&width,
+		&height,
+		&channel,
+		STBI_rgb_alpha
+	);
+	if (pRgba == nullptr)
+		return {};
+
+	BakedTexture texture = bakeImage(pRgba,
+		static_cast<std::uint32_t>(width),
+		static_cast<std::uint32_t>(height),
+		settings,
+		parallel
+	);
+	stbi_image_free(pRgba);
+	return texture;
+}
+
+std::vector<std::uint8_t> TextureBaker::bakeToDDS(const TextureBakeRequest &request) {
+	return bakeToDDSImpl(request, true);
+}
+
+BakedTexture TextureBaker::bakeCached(const TextureBakeRequest &request, bool parallelMips) {
+	BakedTexture texture;
+	std::vector<std::uint8_t> dds = bakeToDDSImpl(request, parallelMips, &texture);
+	if (!texture && !dds.empty())
+		texture = readDDS(dds.data(), dds.size());
+	return texture;
+}
+
+std::vector<std::vector<std::uint8_t>> TextureBaker::bakeBatch(const std::vector<TextureBakeRequest> &requests) {
+	std::vector<std::vector<std::uint8_t>> results(requests.size());
+	// the mip jobs of one texture nest inside its job, idle threads steal them when there are few textures
+	com::parallelFor(0, requests.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+			results[i] = bakeToDDSImpl(requests[i], true);
+	});
+	return results;
+}
+
+TextureBakerStats TextureBaker::getStats() const {
+	TextureBakerStats stats;
+	stats.numBaked = _numBaked;
+	stats.numCacheHits = _numCacheHits;
+	stats.numFailed = _numFailed;
+	return stats;
+}
+
+const std::string &TextureBaker::getCacheDirectory() const {
+	return _cacheDirectory;
+}
+
+std::vector<BakedMipLevel> TextureBaker::generateMipChain(const std::uint8_t *pRgba,
+	std::uint32_t width,
+	std::uint32_t height,
+	TextureRole role)
+{
+	std::vector<BakedMipLevel> mips(calcMipCount(width, height));
+	mips[0].width = width;
+	mips[0].height = height;
+	mips[0].data.assign(pRgba, pRgba + static_cast<size_t>(width) * height * 4);
+
+	// every level halves the one before it, the whole chain reads about 4/3 of the source once
+	for (size_t i = 1; i < mips.size(); ++i) {
+		const BakedMipLevel &src = mips[i-1];
+		BakedMipLevel &level = mips[i];
+		level.width = std::max(src.width >> 1, 1u);
+		level.height = std::max(src.height >> 1, 1u);
+		level.data.resize(static_cast<size_t>(level.width) * level.height * 4);
+
+		int srcW = static_cast<int>(src.width);
+		int srcH = static_cast<int>(src.height);
+		int dstW = static_cast<int>(level.width);
+		int dstH = static_cast<int>(level.height);
+		if (role == TextureRole::Albedo)
+			stbir_resize_uint8_srgb(src.data.data(), srcW, srcH, 0, level.data.data(), dstW, dstH, 0, 4, 3, 0);
+		else
+			stbir_resize_uint8(src.data.data(), srcW, srcH, 0, level.data.data(), dstW, dstH, 0, 4);
+
+		if (role == TextureRole::Normal)
+			renormalize(level);
+	}
+	return mips;
+}
+
+std::vector<std::uint8_t> TextureBaker::compressLevel(const BakedMipLevel &level, TextureBlockFormat format, bool highQuality) {
+	if (format == TextureBlockFormat::RGBA8)
+		return level.data;
+	if (format == TextureBlockFormat::RGBA16F || format == TextureBlockFormat::RG16F) {
+		assert(false);				// float data is written by the producer, there is no block format for it
+		return level.data;
+	}
+
+	size_t blockSize = (format == TextureBlockFormat::BC1 || format == TextureBlockFormat::BC4) ? 8 : 16;
+	std::uint32_t numBlockX = std::max((level.width + 3) / 4, 1u);
+	std::uint32_t numBlockY = std::max((level.height + 3) / 4, 1u);
+	std::vector<std::uint8_t> result(numBlockX * numBlockY * blockSize);
+	int mode = highQuality ? STB_DXT_HIGHQUAL : STB_DXT_NORMAL;
+
+	std::uint8_t block[16 * 4];
+	std::uint8_t *pDest = result.data();
+	for (std::uint32_t by = 0; by < numBlockY; ++by) {
+		for (std::uint32_t bx = 0; bx < numBlockX; ++bx) {
+			// edge blocks of small or odd sized levels repeat the last texel
+			for (std::uint32_t y = 0; y < 4; ++y) {
+				for (std::uint32_t x = 0; x < 4; ++x) {
+					std::uint32_t sx = std::min(bx * 4 + x, level.width - 1);
+					std::uint32_t sy = std::min(by * 4 + y, level.height - 1);
+					const std::uint8_t *pSrc = level.data.data() + (static_cast<size_t>(sy) * level.width + sx) * 4;
+					std::uint8_t *pDst = block + (y * 4 + x) * 4;
+					switch (format) {
+					case TextureBlockFormat::BC4:
+						block[y*4 + x] = pSrc[0];
+						break;
+					case TextureBlockFormat::BC5:
+						block[(y*4 + x) * 2 + 0] = pSrc[0];
+						block[(y*4 + x) * 2 + 1] = pSrc[1];
+						break;
+					default:
+						std::memcpy(pDst, pSrc, 4);
+						break;
+					}
+				}
+			}
+
+			switch (format) {
+			case TextureBlockFormat::BC1:
+				stb_compress_dxt_block(pDest, block, 0, mode);
+				break;
+			case TextureBlockFormat::BC3:
+				stb_compress_dxt_block(pDest, block, 1, mode);
+				break;
+			case TextureBlockFormat::BC4:
+				stb_compress_bc4_block(pDest, block);
+				break;
+			case TextureBlockFormat::BC5:
+				stb_compress_bc5_block(pDest, block);
+				break;
+			default:
+				assert(false);
+				break;
+			}
+			pDest += blockSize;
+		}
+	}
+	return result;
+}
+
+std::vector<std::uint8_t> TextureBaker::writeDDS(const BakedTexture &texture, size_t mostDetailedMip) {
+	assert(static_cast<bool>(texture));
+	assert(texture.arraySize == 1 || mostDetailedMip == 0);
+	size_t mipCount = texture.getMipCount();
+	mostDetailedMip = std::min(mostDetailedMip, mipCount - 1);
+	const BakedMipLevel &topLevel = texture.mips[mostDetailedMip];
+	bool isCompressed = texture.isBlockCompressed();
+
+	DDSHeader header = {};
+	header.size = sizeof(DDSHeader);
+	header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000;			// CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT
+	header.flags |= isCompressed ? 0x80000 : 0x8;				// LINEARSIZE : PITCH
+	header.height = topLevel.height;
+	header.width = topLevel.width;
+	header.pitchOrLinearSize = isCompressed ? static_cast<std::uint32_t>(topLevel.data.size()) : topLevel.width * texture.getBytesPerPixel();
+	header.mipMapCount = static_cast<std::uint32_t>(mipCount - mostDetailedMip);
+	header.ddspf.size = sizeof(DDSPixelFormat);
+	header.ddspf.flags = 0x4;									// DDPF_FOURCC
+	header.ddspf.fourCC = kFourCCDX10;
+	header.caps = 0x1000;										// DDSCAPS_TEXTURE
+	if (header.mipMapCount > 1 || texture.cubeMap)
+		header.caps |= 0x8;										// DDSCAPS_COMPLEX
+	if (header.mipMapCount > 1)
+		header.caps |= 0x400000;								// DDSCAPS_MIPMAP
+	if (texture.cubeMap)
+		header.caps2 = 0x200 | 0xFC00;							// DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES
+
+	DDSHeaderDXT10 headerDX10 = {};
+	headerDX10.dxgiFormat = texture.getDxgiFormat();
+	headerDX10.resourceDimension = 3;							// D3D10_RESOURCE_DIMENSION_TEXTURE2D
+	headerDX10.miscFlag = texture.cubeMap ? 0x4 : 0;			// D3D11_RESOURCE_MISC_TEXTURECUBE
+	headerDX10.arraySize = texture.cubeMap ? texture.arraySize / 6 : texture.arraySize;
+
+	size_t totalSize = sizeof(kDDSMagic) + sizeof(header) + sizeof(headerDX10);
+	for (size_t i = mostDetailedMip; i < texture.mips.size(); ++i)
+		totalSize += texture.mips[i].data.size();
+
+	std::vector<std::uint8_t> result;
+	result.reserve(totalSize);
+	auto append = [&](const void *pData, size_t size) {
+		const auto *pBegin = static_cast<const std::uint8_t *>(pData);
+		result.insert(result.end(), pBegin, pBegin + size);
+	};
+	append(&kDDSMagic, sizeof(kDDSMagic));
+	append(&header, sizeof(header));
+	append(&headerDX10, sizeof(headerDX10));
+	for (size_t i = mostDetailedMip; i < texture.mips.size(); ++i)
+		append(texture.mips[i].data.data(), texture.mips[i].data.size());
+	return result;
+}
+
+BakedTexture TextureBaker::readDDS(const void *pData, size_t size) {
+	DDSHeader header;
+	DDSHeaderDXT10 headerDX10;
+	size_t headerSize = sizeof(kDDSMagic) + sizeof(header) + sizeof(headerDX10);
+	const auto *pBytes = static_cast<const std::uint8_t *>(pData);
+	std::uint32_t magic = 0;
+	if (size < headerSize)
+		return {};
+
+	std::memcpy(&magic, pBytes, sizeof(magic));
+	std::memcpy(&header, pBytes + sizeof(magic), sizeof(header));
+	std::memcpy(&headerDX10, pBytes + sizeof(magic) + sizeof(header), sizeof(headerDX10));
+	if (magic != kDDSMagic || header.ddspf.fourCC != kFourCCDX10)
+		return {};
+
+	BakedTexture texture;
+	texture.width = header.width;
+	texture.height = header.height;
+	texture.cubeMap = (headerDX10.miscFlag & 0x4) != 0;
+	texture.arraySize = texture.cubeMap ? headerDX10.arraySize * 6 : headerDX10.arraySize;
+	constexpr TextureBlockFormat kFormats[] = {
+		TextureBlockFormat::BC1, TextureBlockFormat::BC3, TextureBlockFormat::BC4, TextureBlockFormat::BC5,
+		TextureBlockFormat::RGBA8, TextureBlockFormat::RGBA16F, TextureBlockFormat::RG16F,
+	};
+	bool found = false;
+	for (size_t i = 0; i < std::size(kFormats) * 2 && !found; ++i) {
+		texture.format = kFormats[i / 2];
+		texture.sRGB = (i % 2) != 0;
+		found = texture.getDxgiFormat() == headerDX10.dxgiFormat;
+	}
+	if (!found || texture.width == 0 || texture.height == 0 || texture.arraySize == 0)
+		return {};
+
+	size_t mipCount = std::max(header.mipMapCount, 1u);
+	size_t offset = headerSize;
+	for (std::uint32_t slice = 0; slice < texture.arraySize; ++slice) {
+		for (size_t mip = 0; mip < mipCount; ++mip) {
+			BakedMipLevel level;
+			level.width = std::max(texture.width >> mip, 1u);
+			level.height = std::max(texture.height >> mip, 1u);
+			size_t levelSize = 0;
+			if (texture.isBlockCompressed()) {
+				size_t blockSize = (texture.format == TextureBlockFormat::BC1 || texture.format == TextureBlockFormat::BC4) ? 8 : 16;
+				levelSize = ((level.width + 3) / 4) * ((level.height + 3) / 4) * blockSize;
+			} else {
+				levelSize = static_cast<size_t>(level.width) * level.height * texture.getBytesPerPixel();
+			}
+			if (offset + levelSize > size)
+				return {};
+
+			level.data.assign(pBytes + offset, pBytes + offset + levelSize);
+			offset += levelSize;
+			texture.mips.push_back(std::move(level));
+		}
+	}
+	return texture;
+}
+
+std::uint64_t TextureBaker::calcSourceHash(const void *pData, size_t size, const TextureBakeSettings &settings) {
+	// FNV-1a over the source bytes and everything that changes the output
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	auto combine = [&](const void *pBytes, size_t count) {
+		const auto *pBegin = static_cast<const std::uint8_t *>(pBytes);
+		for (size_t i = 0; i < count; ++i) {
+			hash ^= pBegin[i];
+			hash *= 0x100000001b3ull;
+		}
+	};
+	combine(pData, size);
+	std::uint32_t settingBits[] = {
+		kTextureBakerVersion,
+		static_cast<std::uint32_t>(settings.role),
+		static_cast<std::uint32_t>(settings.generateMips),
+		static_cast<std::uint32_t>(settings.compress),
+		static_cast<std::uint32_t>(settings.highQuality),
+	};
+	combine(settingBits, sizeof(settingBits));
+	return hash;
+}
+
+std::uint32_t TextureBaker::calcMipCount(std::uint32_t width, std::uint32_t height) {
+	std::uint32_t count = 1;
+	std::uint32_t size = std::max(width, height);
+	while (size > 1) {
+		size >>= 1;
+		++count;
+	}
+	return count;
+}
+
+std::vector<std::uint8_t> TextureBaker::bakeToDDSImpl(const TextureBakeRequest &request, bool parallelMips, BakedTexture *pBaked) {
+	std::vector<std::uint8_t> fileData;
+	const void *pData = request.pData;
+	size_t dataSize = request.dataSize;
+	if (pData == nullptr) {
+		fileData = readBinaryFile(request.fileName);
+		pData = fileData.data();
+		dataSize = fileData.size();
+	}
+
+	if (dataSize == 0) {
+		++_numFailed;
+		return {};
+	}
+
+	std::string cachePath;
+	if (!_cacheDirectory.empty()) {
+		std::uint64_t hash = calcSourceHash(pData, dataSize, request.settings);
+		cachePath = std::format("{}{:016x}.dds", _cacheDirectory, hash);
+		std::vector<std::uint8_t> cached = readBinaryFile(cachePath);
+		if (!cached.empty()) {
+			++_numCacheHits;
+			return cached;
+		}
+	}
+
+	BakedTexture texture = bakeMemory(pData, dataSize, request.settings, parallelMips);
+	if (!texture) {
+		++_numFailed;
+		return {};
+	}
+
+	std::vector<std::uint8_t> dds = writeDDS(texture);
+	if (!cachePath.empty()) {
+		std::error_code ec;
+		std::filesystem::create_directories(_cacheDirectory, ec);
+		// write to a temporary file first, another thread or process may bake the same source
+		std::string tempPath = std::format("{}.{}.tmp", cachePath, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		{
+			std::ofstream output(tempPath, std::ios::binary);
+			output.write(reinterpret_cast<const char *>(dds.data()), dds.size());
+		}
+		std::filesystem::rename(tempPath, cachePath, ec);
+		if (ec)
+			std::filesystem::remove(tempPath, ec);
+	}
+	++_numBaked;
+	if (pBaked != nullptr)
+		*pBaked = std::move(texture);
+	return dds;
+}
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <atomic>
+
+namespace d3d {
+
+// The role decides the color space, the mip filter and the block format
+enum class TextureRole {
+	Albedo,			// sRGB color, BC1 or BC3 when the alpha channel is used
+	Normal,			// tangent space normal, BC5 (xy), z is reconstructed in the shader
+	Mask,			// roughness/metallic/ao packed in rgb, linear BC1
+	Linear,			// any other linear data, BC1 or BC3
+};
+
+enum class TextureBlockFormat {
+	BC1,
+	BC3,
+	BC4,
+	BC5,
+	RGBA8,
+	RGBA16F,		// hdr data such as baked environment maps, never produced by bakeImage
+	RG16F,
+};
+
+struct TextureBakeSettings {
+	TextureRole role		 = TextureRole::Albedo;
+	bool		generateMips = true;
+	bool		compress	 = true;		// false keeps RGBA8, useful for debugging
+	bool		highQuality	 = false;		// STB_DXT_HIGHQUAL, ~30% slower
+};
+
+struct BakedMipLevel {
+	std::uint32_t width  = 0;
+	std::uint32_t height = 0;
+	std::vector<std::uint8_t> data;
+};
+
+struct BakedTexture {
+	std::uint32_t width  = 0;
+	std::uint32_t height = 0;
+	TextureBlockFormat format = TextureBlockFormat::RGBA8;
+	bool sRGB = false;
+	std::uint32_t arraySize = 1;				// 6 for a cube map
+	bool cubeMap = false;
+	std::vector<BakedMipLevel> mips;			// dds order, mips[slice * getMipCount() + mip]
+public:
+	explicit operator bool() const { return !mips.empty(); }
+	std::uint32_t getMipCount() const;
+	// numeric DXGI_FORMAT value, this header does not depend on dxgi
+	std::uint32_t getDxgiFormat() const;
+	bool isBlockCompressed() const;
+	std::uint32_t getBytesPerPixel() const;		// uncompressed formats only
+};
+
+struct TextureBakeRequest {
+	std::string			fileName;				// used when pData is null
+	const void		   *pData = nullptr;		// encoded image in memory (png/jpg/tga ...)
+	size_t				dataSize = 0;
+	TextureBakeSettings settings;
+};
+
+struct TextureBakerStats {
+	size_t numBaked = 0;
+	size_t numCacheHits = 0;
+	size_t numFailed = 0;
+};
+
+// whole file in memory, empty when it cannot be opened
+std::vector<std::uint8_t> readBinaryFile(const std::string &fileName);
+
+class TextureBaker {
+public:
+	explicit TextureBaker(std::string cacheDirectory = defaultCacheDirectory);
+
+	// RGBA8 source -> mip chain -> block compression
+	static BakedTexture bakeImage(const std::uint8_t *pRgba,
+		std::uint32_t width,
+		std::uint32_t height,
+		const TextureBakeSettings &settings,
+		bool parallel = true
+	);
+
+	// decode with stb_image, then bakeImage
+	static BakedTexture bakeMemory(const void *pData, size_t size, const TextureBakeSettings &settings, bool parallel = true);
+
+	// Returns a complete dds file. The result is cached on disk keyed by the source hash,
+	// an empty vector means the source could not be decoded
+	std::vector<std::uint8_t> bakeToDDS(const TextureBakeRequest &request);
+
+	// bakeToDDS for callers that keep the mips on the CPU: a cache hit is parsed back with readDDS
+	// instead of being baked again, an empty texture means the source could not be decoded
+	BakedTexture bakeCached(const TextureBakeRequest &request, bool parallelMips = true);
+
+	// bakeToDDS for every request, one job per texture on the shared JobSystem
+	std::vector<std::vector<std::uint8_t>> bakeBatch(const std::vector<TextureBakeRequest> &requests);
+
+	TextureBakerStats getStats() const;
+	const std::string &getCacheDirectory() const;
+
+	// each level is filtered from the previous one, gamma-correct for sRGB roles, normals are
+	// renormalized after every downsample
+	static std::vector<BakedMipLevel> generateMipChain(const std::uint8_t *pRgba,
+		std::uint32_t width,
+		std::uint32_t height,
+		TextureRole role
+	);
+	static std::vector<std::uint8_t> compressLevel(const BakedMipLevel &level, TextureBlockFormat format, bool highQuality);
+	// mips before mostDetailedMip are skipped, used by texture streaming (single slice only)
+	static std::vector<std::uint8_t> writeDDS(const BakedTexture &texture, size_t mostDetailedMip = 0);
+	// the inverse of writeDDS, empty for any file this baker did not write
+	static BakedTexture readDDS(const void *pData, size_t size);
+	static std::uint64_t calcSourceHash(const void *pData, size_t size, const TextureBakeSettings &settings);
+	static std::uint32_t calcMipCount(std::uint32_t width, std::uint32_t height);
+public:
+	static inline std::string defaultCacheDirectory = "resources/TextureCache/";
+private:
+	// pBaked receives the texture when it had to be baked
+	std::vector<std::uint8_t> bakeToDDSImpl(const TextureBakeRequest &request, bool parallelMips, BakedTexture *pBaked = nullptr);
+private:
+	std::string _cacheDirectory;
+	std::atomic<size_t> _numBaked = 0;
+	std::atomic<size_t> _numCacheHits = 0;
+	std::atomic<size_t> _numFailed = 0;
+};
+
+}
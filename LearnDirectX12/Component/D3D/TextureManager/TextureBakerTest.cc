@@ -0,0 +1,101 @@
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include "TestCheck.h"
+#include "D3D/TextureManager/TextureBaker.h"
+#include "JobSystem/JobSystem.h"
+
+using namespace d3d;
+
+void textureBakerTest() {
+	// black/white checkerboard, the gamma-correct average is ~188 instead of 128
+	constexpr std::uint32_t kWidth = 64;
+	constexpr std::uint32_t kHeight = 32;
+	std::vector<std::uint8_t> rgba(kWidth * kHeight * 4);
+	for (std::uint32_t y = 0; y < kHeight; ++y) {
+		for (std::uint32_t x = 0; x < kWidth; ++x) {
+			std::uint8_t value = ((x + y) & 1) ? 255 : 0;
+			std::uint8_t *pPixel = rgba.data() + (y * kWidth + x) * 4;
+			pPixel[0] = pPixel[1] = pPixel[2] = value;
+			pPixel[3] = 255;
+		}
+	}
+
+	TEST_CHECK(TextureBaker::calcMipCount(kWidth, kHeight) == 7);
+	auto srgbMips = TextureBaker::generateMipChain(rgba.data(), kWidth, kHeight, TextureRole::Albedo);
+	auto linearMips = TextureBaker::generateMipChain(rgba.data(), kWidth, kHeight, TextureRole::Mask);
+	TEST_CHECK(srgbMips.size() == 7 && srgbMips.back().width == 1 && srgbMips.back().height == 1);
+	size_t interior = (8 * srgbMips[1].width + 8) * 4;		// away from the clamped edges
+	TEST_CHECK(std::abs(srgbMips[1].data[interior] - 188) <= 3);
+	TEST_CHECK(std::abs(linearMips[1].data[interior] - 128) <= 3);
+	// the next level filters the flat grey of level 1, not the checkerboard again
+	size_t interior2 = (4 * srgbMips[2].width + 4) * 4;
+	TEST_CHECK(std::abs(srgbMips[2].data[interior2] - srgbMips[1].data[interior]) <= 2);
+	for (size_t i = 1; i < srgbMips.size(); ++i)
+		TEST_CHECK(srgbMips[i].width == std::max(srgbMips[i-1].width / 2, 1u));
+
+	// a 1x1 source is its own chain
+	auto singleMip = TextureBaker::generateMipChain(rgba.data(), 1, 1, TextureRole::Albedo);
+	TEST_CHECK(singleMip.size() == 1 && singleMip[0].data.size() == 4);
+
+	TextureBakeSettings settings;
+	settings.role = TextureRole::Albedo;
+	BakedTexture albedo = TextureBaker::bakeImage(rgba.data(), kWidth, kHeight, settings);
+	TEST_CHECK(albedo.format == TextureBlockFormat::BC1 && albedo.sRGB);
+	TEST_CHECK(albedo.mips[0].data.size() == (kWidth / 4) * (kHeight / 4) * 8);
+	TEST_CHECK(albedo.mips.back().data.size() == 8);			// 1x1 level still takes a whole block
+
+	settings.role = TextureRole::Normal;
+	BakedTexture normal = TextureBaker::bakeImage(rgba.data(), kWidth, kHeight, settings);
+	TEST_CHECK(normal.format == TextureBlockFormat::BC5 && !normal.sRGB);
+	TEST_CHECK(normal.mips[0].data.size() == (kWidth / 4) * (kHeight / 4) * 16);
+
+	std::vector<std::uint8_t> dds = TextureBaker::writeDDS(albedo);
+	TEST_CHECK(std::memcmp(dds.data(), "DDS ", 4) == 0);
+	TEST_CHECK(std::memcmp(dds.data() + 84, "DX10", 4) == 0);
+	std::uint32_t dxgiFormat = 0;
+	std::memcpy(&dxgiFormat, dds.data() + 128, sizeof(dxgiFormat));
+	TEST_CHECK(dxgiFormat == 72);								// DXGI_FORMAT_BC1_UNORM_SRGB
+
+	// streaming writes only the resident mip range
+	std::vector<std::uint8_t> ddsTail = TextureBaker::writeDDS(albedo, 3);
+	std::uint32_t ddsWidth = 0;
+	std::uint32_t ddsMipCount = 0;
+	std::memcpy(&ddsWidth, ddsTail.data() + 16, sizeof(ddsWidth));
+	std::memcpy(&ddsMipCount, ddsTail.data() + 28, sizeof(ddsMipCount));
+	TEST_CHECK(ddsWidth == kWidth >> 3 && ddsMipCount == albedo.mips.size() - 3);
+
+	// readDDS gives back what writeDDS wrote, the tail starts at its own top level
+	BakedTexture readBack = TextureBaker::readDDS(dds.data(), dds.size());
+	TEST_CHECK(readBack.format == albedo.format && readBack.sRGB && readBack.mips.size() == albedo.mips.size());
+	for (size_t i = 0; i < albedo.mips.size(); ++i)
+		TEST_CHECK(readBack.mips[i].width == albedo.mips[i].width && readBack.mips[i].data == albedo.mips[i].data);
+	BakedTexture readTail = TextureBaker::readDDS(ddsTail.data(), ddsTail.size());
+	TEST_CHECK(readTail.width == kWidth >> 3 && readTail.mips.back().data == albedo.mips.back().data);
+	TEST_CHECK(!TextureBaker::readDDS(dds.data(), dds.size() - 1));
+
+	// undecodable data fails, the cache is never touched
+	std::string cacheDirectory = (std::filesystem::temp_directory_path() / "D3DTestTextureCache/").string();
+	std::filesystem::remove_all(cacheDirectory);
+	TextureBaker baker(cacheDirectory);
+	const char garbage[] = "not an image";
+	std::vector<TextureBakeRequest> requests(4);
+	for (auto &request : requests) {
+		request.pData = garbage;
+		request.dataSize = sizeof(garbage);
+	}
+	auto results = baker.bakeBatch(requests);
+	TEST_CHECK(results.size() == 4 && results[0].empty());
+	TEST_CHECK(baker.getStats().numFailed == 4);
+	std::filesystem::remove_all(cacheDirectory);
+}
+
+int main() {
+	com::JobSystem::emplace(4);
+	textureBakerTest();
+	com::JobSystem::destroy();
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include "TextureLoader.h"
+#include <cassert>
+#include <algorithm>
+#include <format>
+
+namespace d3d {
+
+TextureLoader::TextureLoader(size_t maxConcurrentIO, std::string cacheDirectory)
+: _pJobSystem(com::JobSystem::instance())
+, _baker(std::move(cacheDirectory))
+, _ioSemaphore(static_cast<std::ptrdiff_t>(std::max<size_t>(maxConcurrentIO, 1)))
+{
+}
+
+TextureLoader::~TextureLoader() {
+	// the jobs point back at this loader
+	waitIdle();
+}
+
+void TextureLoader::request(TextureLoadRequest request) {
+	{
+		std::lock_guard lock(_mutex);
+		if (_stats.numRequested == 0)
+			_startTime = Clock::now();
+
+		++_stats.numRequested;
+		++_stats.numInFlight;
+	}
+
+	if (_pJobSystem == nullptr) {
+		decode(std::move(request));
+		return;
+	}
+	// shared_ptr keeps the job copyable for std::function
+	auto pRequest = std::make_shared<TextureLoadRequest>(std::move(request));
+	_pJobSystem->schedule([this, pRequest]() {
+		decode(std::move(*pRequest));
+	}, &_decodeCounter, com::JobPriority::Low);
+}
+
+bool TextureLoader::tryPop(DecodedTexture &texture) {
+	return _decodedQueue.tryPop(texture);
+}
+
+size_t TextureLoader::drain(const std::function<void(DecodedTexture &)> &callback, size_t maxCount) {
+	size_t count = 0;
+	DecodedTexture texture;
+	while (count < maxCount && tryPop(texture)) {
+		callback(texture);
+		++count;
+	}
+	return count;
+}
+
+void TextureLoader::waitIdle() {
+	if (_pJobSystem != nullptr)
+		_pJobSystem->wait(_decodeCounter);
+}
+
+size_t TextureLoader::getNumInFlight() const {
+	std::lock_guard lock(_mutex);
+	return _stats.numInFlight;
+}
+
+TextureLoaderStats TextureLoader::getStats() const {
+	std::lock_guard lock(_mutex);
+	TextureLoaderStats stats = _stats;
+	stats.numCacheHits = _baker.getStats().numCacheHits;
+	return stats;
+}
+
+std::string TextureLoader::dumpStats() const {
+	TextureLoaderStats stats = getStats();
+	return std::format("[TextureLoader] threads: {}, requested: {}, decoded: {}, failed: {}, in flight: {}, cache hits: {}, "
+		"read: {:.2f} MB, wall: {:.2f} ms, read total: {:.2f} ms, decode total: {:.2f} ms\n",
+		_pJobSystem != nullptr ? _pJobSystem->getThreadCount() : 1,
+		stats.numRequested,
+		stats.numDecoded,
+		stats.numFailed,
+		stats.numInFlight,
+		stats.numCacheHits,
+		stats.readBytes / (1024.0 * 1024.0),
+		stats.wallTimeMs,
+		stats.totalReadMs,
+		stats.totalDecodeMs
+	);
+}
+
+void TextureLoader::decode(TextureLoadRequest request) {
+	DecodedTexture texture;
+	texture.request = std::move(request);
+	std::vector<std::uint8_t> fileData;
+	const void *pData = texture.request.pData.get();
+	size_t dataSize = texture.request.dataSize;
+	if (pData == nullptr) {
+		// only a few reads at once, the disk does not get faster with more threads
+		auto readBegin = Clock::now();
+		_ioSemaphore.acquire();
+		fileData = readBinaryFile(texture.request.path);
+		_ioSemaphore.release();
+		texture.readMs = elapsedMs(readBegin);
+		pData = fileData.data();
+		dataSize = fileData.size();
+	}
+
+	auto decodeBegin = Clock::now();
+	if (dataSize > 0) {
+		// the jobs are already parallel across textures, keep the mips in this job
+		TextureBakeRequest bakeRequest;
+		bakeRequest.pData = pData;
+		bakeRequest.dataSize = dataSize;
+		bakeRequest.settings = texture.request.settings;
+		texture.baked = _baker.bakeCached(bakeRequest, false);
+	}
+	texture.decodeMs = elapsedMs(decodeBegin);
+
+	bool success = static_cast<bool>(texture.baked);
+	double readMs = texture.readMs;
+	double decodeMs = texture.decodeMs;
+	_decodedQueue.push(std::move(texture));
+
+	std::lock_guard lock(_mutex);
+	_stats.wallTimeMs = elapsedMs(_startTime);
+	_stats.readBytes += fileData.size();
+	_stats.totalReadMs += readMs;
+	_stats.totalDecodeMs += decodeMs;
+	success ? ++_stats.numDecoded : ++_stats.numFailed;
+	--_stats.numInFlight;
+}
+
+double TextureLoader::elapsedMs(std::chrono::steady_clock::time_point timePoint) const {
+	return std::chrono::duration<double, std::milli>(Clock::now() - timePoint).count();
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <functional>
+#include <chrono>
+#include <JobSystem/JobSystem.h>
+#include "TextureBaker.h"
+#include "MpscQueue.hpp"
+
+namespace d3d {
+
+struct TextureLoadRequest {
+	std::string path;								// file name, also the TextureManager key
+	std::shared_ptr<const void> pData;				// optional encoded image in memory (embedded gltf textures)
+	size_t dataSize = 0;
+	std::string formatHint;							// extension of pData, used when the upload falls back
+	bool sRGB = true;
+	bool streaming = false;							// register with the TextureManager residency instead of uploading every mip
+	TextureBakeSettings settings;
+};
+
+struct DecodedTexture {
+	TextureLoadRequest request;
+	BakedTexture baked;								// empty when decoding failed
+	double readMs = 0.0;
+	double decodeMs = 0.0;
+};
+
+struct TextureLoaderStats {
+	size_t numRequested = 0;
+	size_t numDecoded = 0;
+	size_t numFailed = 0;
+	size_t numInFlight = 0;
+	size_t numCacheHits = 0;						// loaded from the baked dds cache without decoding
+	size_t readBytes = 0;
+	double wallTimeMs = 0.0;						// first request -> last decoded texture
+	double totalReadMs = 0.0;						// summed over all jobs
+	double totalDecodeMs = 0.0;
+};
+
+// Reads and decodes every texture in a low priority job on the shared JobSystem, without one the
+// request decodes on the calling thread. Sources already baked into the cache directory are read
+// back instead of being decoded and compressed again. File reads are bounded by maxConcurrentIO,
+// decoded results are handed to a single consumer (the uploader) through a lock-free queue.
+// Nothing here touches the device, so the whole decode path can run without one
+class TextureLoader {
+public:
+	explicit TextureLoader(size_t maxConcurrentIO = 2, std::string cacheDirectory = TextureBaker::defaultCacheDirectory);
+	TextureLoader(const TextureLoader &) = delete;
+	TextureLoader &operator=(const TextureLoader &) = delete;
+	~TextureLoader();
+
+	void request(TextureLoadRequest request);
+	// consumer thread only
+	bool tryPop(DecodedTexture &texture);
+	size_t drain(const std::function<void(DecodedTexture &)> &callback, size_t maxCount = -1);
+	// blocks until every request has been decoded, the results still have to be popped
+	void waitIdle();
+	size_t getNumInFlight() const;
+	TextureLoaderStats getStats() const;
+	std::string dumpStats() const;
+private:
+	void decode(TextureLoadRequest request);
+	double elapsedMs(std::chrono::steady_clock::time_point timePoint) const;
+private:
+	using Clock = std::chrono::steady_clock;
+	com::JobSystem *_pJobSystem;
+	com::JobCounter _decodeCounter;
+	TextureBaker _baker;
+	std::counting_semaphore<> _ioSemaphore;
+	MpscQueue<DecodedTexture> _decodedQueue;
+
+	mutable std::mutex _mutex;
+	TextureLoaderStats _stats;
+	Clock::time_point _startTime;
+};
+
+}
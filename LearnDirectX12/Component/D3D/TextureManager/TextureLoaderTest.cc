@@ -0,0 +1,121 @@
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <memory>
+#include <filesystem>
+#include <thread>
+#include "TestCheck.h"
+#include "D3D/TextureManager/TextureLoader.h"
+#include "JobSystem/JobSystem.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+using namespace d3d;
+
+void mpscQueueTest() {
+	MpscQueue<int> queue;
+	constexpr int kNumProducer = 4;
+	constexpr int kNumItem = 10000;
+	std::vector<std::thread> producers;
+	for (int i = 0; i < kNumProducer; ++i) {
+		producers.emplace_back([&queue, i]() {
+			for (int j = 0; j < kNumItem; ++j)
+				queue.push(i * kNumItem + j);
+		});
+	}
+
+	// per producer order must be kept
+	std::vector<int> lastValue(kNumProducer, -1);
+	int numPopped = 0;
+	while (numPopped < kNumProducer * kNumItem) {
+		int value;
+		if (!queue.tryPop(value))
+			continue;
+
+		int producer = value / kNumItem;
+		TEST_CHECK(value > lastValue[producer]);
+		lastValue[producer] = value;
+		++numPopped;
+	}
+	for (auto &producer : producers)
+		producer.join();
+
+	int value;
+	bool popped = queue.tryPop(value);
+	TEST_CHECK(!popped);
+}
+
+void textureLoaderTest() {
+	// CPU only run of the whole read + decode path, no device involved
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "D3DTestTextureLoader";
+	std::filesystem::create_directories(directory);
+
+	constexpr int kNumFile = 8;
+	constexpr int kSize = 64;
+	std::vector<std::uint8_t> rgba(kSize * kSize * 4, 255);
+	std::vector<std::string> fileNames;
+	for (int i = 0; i < kNumFile; ++i) {
+		std::string fileName = (directory / ("texture" + std::to_string(i) + ".png")).string();
+		stbi_write_png(fileName.c_str(), kSize, kSize, 4, rgba.data(), kSize * 4);
+		fileNames.push_back(fileName);
+	}
+
+	int pngSize = 0;
+	unsigned char *pPng = stbi_write_png_to_mem(rgba.data(), kSize * 4, kSize, kSize, 4, &pngSize);
+	std::shared_ptr<std::uint8_t[]> pEmbedded(new std::uint8_t[pngSize]);
+	std::memcpy(pEmbedded.get(), pPng, pngSize);
+	STBIW_FREE(pPng);
+
+	// the second loader finds every decodable source in the cache the first one wrote
+	std::string cacheDirectory = (directory / "TextureCache/").string();
+	for (int pass = 0; pass < 2; ++pass) {
+		TextureLoader loader(2, cacheDirectory);
+		for (const std::string &fileName : fileNames) {
+			TextureLoadRequest request;
+			request.path = fileName;
+			request.settings.role = TextureRole::Albedo;
+			loader.request(std::move(request));
+		}
+
+		TextureLoadRequest embeddedRequest;
+		embeddedRequest.path = "scene.gltf*0";
+		embeddedRequest.pData = pEmbedded;
+		embeddedRequest.dataSize = pngSize;
+		embeddedRequest.formatHint = "png";
+		loader.request(std::move(embeddedRequest));
+
+		TextureLoadRequest missingRequest;
+		missingRequest.path = (directory / "missing.png").string();
+		loader.request(std::move(missingRequest));
+
+		loader.waitIdle();
+		size_t numDecoded = 0;
+		size_t numFailed = 0;
+		loader.drain([&](DecodedTexture &texture) {
+			if (!texture.baked) {
+				++numFailed;
+				return;
+			}
+			TEST_CHECK(texture.baked.width == kSize && texture.baked.mips.size() == 7);
+			TEST_CHECK(texture.baked.format == TextureBlockFormat::BC1 && texture.baked.sRGB);
+			++numDecoded;
+		});
+
+		TextureLoaderStats stats = loader.getStats();
+		TEST_CHECK(numDecoded == kNumFile + 1 && numFailed == 1);
+		TEST_CHECK(stats.numDecoded == numDecoded && stats.numFailed == numFailed && stats.numInFlight == 0);
+		TEST_CHECK(pass == 0 || stats.numCacheHits == numDecoded);
+		std::cout << loader.dumpStats();
+	}
+	std::filesystem::remove_all(directory);
+}
+
+int main() {
+	mpscQueueTest();
+	com::JobSystem::emplace(4);
+	textureLoaderTest();
+	com::JobSystem::destroy();
+	return 0;
+}
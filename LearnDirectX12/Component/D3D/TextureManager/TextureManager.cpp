@@ -1,4 +1,6 @@
 #include "TextureManager.h"
+#include <algorithm>
+#include <utility>
 
 namespace d3d {
 
@@ -22,6 +24,155 @@ void TextureManager::set(const std::string &fileName, std::shared_ptr<dx12lib::T
 
 void TextureManager::erase(const std::string &fileName) {
 	_textureMap.erase(fileName);
+	if (auto iter = _streamingTextures.find(fileName); iter != _streamingTextures.end()) {
+		_textureResidency.unregisterTexture(iter->second.handle);
+		_streamingHandleToName.erase(iter->second.handle);
+		_streamingTextures.erase(iter);
+	}
+}
+
+bool TextureManager::requestTexture(TextureLoadRequest request) {
+	assert(!request.path.empty());
+	if (exist(request.path) || !_loadingTextures.insert(request.path).second)
+		return false;
+
+	getTextureLoader().request(std::move(request));
+	return true;
+}
+
+bool TextureManager::isLoading(const std::string &fileName) const {
+	return _loadingTextures.contains(fileName);
+}
+
+size_t TextureManager::uploadLoadedTextures(dx12lib::CommonContextProxy pCommonCtx, size_t maxCount) {
+	if (_pTextureLoader == nullptr)
+		return 0;
+
+	return _pTextureLoader->drain([&](DecodedTexture &texture) {
+		const TextureLoadRequest &request = texture.request;
+		std::shared_ptr<dx12lib::Texture> pTexture;
+		if (request.streaming && isStreaming(request.path)) {
+			// a reload of released mips, the change that asked for them is applied now
+			StreamingTexture &streamingTexture = _streamingTextures[request.path];
+			streamingTexture.reloading = false;
+			if (texture.baked) {
+				streamingTexture.baked = std::move(texture.baked);
+				applyStreamingChange(pCommonCtx, request.path);
+			}
+			return;
+		}
+
+		if (texture.baked && request.streaming) {
+			StreamingTexture streamingTexture;
+			streamingTexture.request = request;
+			streamingTexture.baked = std::move(texture.baked);
+			TextureStreamingDesc desc;
+			desc.width = streamingTexture.baked.width;
+			desc.height = streamingTexture.baked.height;
+			for (const BakedMipLevel &level : streamingTexture.baked.mips)
+				desc.mipSizeInBytes.push_back(level.data.size());
+			streamingTexture.handle = _textureResidency.registerTexture(desc);
+			_streamingHandleToName[streamingTexture.handle] = request.path;
+			StreamingTexture &entry = (_streamingTextures[request.path] = std::move(streamingTexture));
+			pTexture = createStreamingTexture(pCommonCtx, entry);
+		} else if (texture.baked) {
+			std::vector<std::uint8_t> ddsFile = TextureBaker::writeDDS(texture.baked);
+			pTexture = pCommonCtx->createTextureFromMemory("dds", ddsFile.data(), ddsFile.size(), request.sRGB);
+		} else if (request.pData != nullptr) {
+			// stb_image could not decode it, let dx12lib try the original data
+			pTexture = pCommonCtx->createTextureFromMemory(request.formatHint,
+				request.pData.get(),
+				request.dataSize,
+				request.sRGB
+			);
+		} else {
+			pTexture = pCommonCtx->createTextureFromFile(std::to_wstring(request.path), request.sRGB);
+		}
+		_loadingTextures.erase(request.path);
+		set(request.path, pTexture);
+	}, maxCount);
+}
+
+void TextureManager::flushTextureLoading(dx12lib::CommonContextProxy pCommonCtx) {
+	if (_pTextureLoader == nullptr)
+		return;
+
+	_pTextureLoader->waitIdle();
+	uploadLoadedTextures(pCommonCtx);
+	assert(_loadingTextures.empty());
+}
+
+TextureLoader &TextureManager::getTextureLoader() {
+	// created by the first asynchronous request
+	if (_pTextureLoader == nullptr)
+		_pTextureLoader = std::make_unique<TextureLoader>();
+	return *_pTextureLoader;
+}
+
+bool TextureManager::isStreaming(const std::string &fileName) const {
+	return _streamingTextures.contains(fileName);
+}
+
+void TextureManager::requestTextureScreenSize(const std::string &fileName, float screenSizeInPixels) {
+	auto iter = _streamingTextures.find(fileName);
+	if (iter != _streamingTextures.end())
+		_textureResidency.requestScreenSize(iter->second.handle, screenSizeInPixels);
+}
+
+std::vector<std::string> TextureManager::updateStreaming(dx12lib::CommonContextProxy pCommonCtx) {
+	std::vector<ResidencyChange> changes = _textureResidency.update();
+	for (const ResidencyChange &change : changes)
+		applyStreamingChange(pCommonCtx, _streamingHandleToName[change.handle]);
+	return std::exchange(_updatedStreamingTextures, {});
+}
+
+void TextureManager::setStreamingBudget(size_t budgetInBytes) {
+	_textureResidency.setBudget(budgetInBytes);
+}
+
+TextureResidency &TextureManager::getTextureResidency() {
+	return _textureResidency;
+}
+
+void TextureManager::applyStreamingChange(dx12lib::CommonContextProxy pCommonCtx, const std::string &fileName) {
+	StreamingTexture &streamingTexture = _streamingTextures[fileName];
+	if (streamingTexture.reloading)
+		return;
+
+	std::uint32_t residentMip = _textureResidency.getResidentMip(streamingTexture.handle);
+	const std::vector<BakedMipLevel> &mips = streamingTexture.baked.mips;
+	bool hasAllMips = std::all_of(mips.begin() + residentMip, mips.end(), [](const BakedMipLevel &level) {
+		return !level.data.empty();
+	});
+	if (!hasAllMips) {
+		// the loader reads the baked dds back from the texture cache, the change lands when it is drained
+		streamingTexture.reloading = true;
+		getTextureLoader().request(streamingTexture.request);
+		return;
+	}
+
+	// the previous texture may still be referenced by frames in flight
+	if (auto pOldTexture = get(fileName))
+		pCommonCtx->trackResource(std::move(pOldTexture));
+	set(fileName, createStreamingTexture(pCommonCtx, streamingTexture));
+	if (std::find(_updatedStreamingTextures.begin(), _updatedStreamingTextures.end(), fileName) == _updatedStreamingTextures.end())
+		_updatedStreamingTextures.push_back(fileName);
+}
+
+std::shared_ptr<dx12lib::Texture> TextureManager::createStreamingTexture(dx12lib::CommonContextProxy pCommonCtx,
+	StreamingTexture &streamingTexture)
+{
+	// dx12lib has no partial mip upload, so the texture is rebuilt from the resident mip range
+	std::uint32_t residentMip = _textureResidency.getResidentMip(streamingTexture.handle);
+	std::vector<std::uint8_t> ddsFile = TextureBaker::writeDDS(streamingTexture.baked, residentMip);
+	auto pTexture = pCommonCtx->createTextureFromMemory("dds", ddsFile.data(), ddsFile.size(), streamingTexture.request.sRGB);
+
+	// uploaded mips above the tail are not kept on the CPU, the tail is small and lets a trim
+	// fall back to it without a reload
+	std::uint32_t tailMip = _textureResidency.getTailMip(streamingTexture.handle);
+	for (std::uint32_t mip = residentMip; mip < tailMip; ++mip)
+		std::vector<std::uint8_t>().swap(streamingTexture.baked.mips[mip].data);
+	return pTexture;
 }
 
 void TextureManager::initDefaultTexture(dx12lib::DirectContextProxy pGraphicsCtx) {
@@ -4,7 +4,10 @@
 #include <dx12lib/Texture/TextureStd.h>
 #include <Singleton/Singleton.hpp>
 #include <D3D/AssimpLoader/AssimpLoader.h>
+#include <D3D/TextureManager/TextureLoader.h>
+#include <D3D/TextureManager/TextureResidency.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <memory>
 
@@ -16,6 +19,28 @@ public:
 	bool exist(const std::string &fileName) const;
 	void set(const std::string &fileName, std::shared_ptr<dx12lib::Texture> pShaderResource);
 	void erase(const std::string &fileName);
+
+	// Asynchronous loading, decoding runs in TextureLoader jobs.
+	// Returns false when the texture is already loaded or in flight
+	bool requestTexture(TextureLoadRequest request);
+	bool isLoading(const std::string &fileName) const;
+	// creates the decoded textures on the calling thread, returns the number of new textures
+	size_t uploadLoadedTextures(dx12lib::CommonContextProxy pCommonCtx, size_t maxCount = -1);
+	// waits for every request and uploads all of them
+	void flushTextureLoading(dx12lib::CommonContextProxy pCommonCtx);
+	TextureLoader &getTextureLoader();
+
+	// Texture streaming. Streamed textures start with their mip tail only and are
+	// recreated with more or fewer mips by updateStreaming() according to the requests.
+	// Only the mip tail stays on the CPU, mips above it are read back from the texture
+	// cache by the loader when a later change needs them again
+	bool isStreaming(const std::string &fileName) const;
+	void requestTextureScreenSize(const std::string &fileName, float screenSizeInPixels);
+	// once per frame after uploadLoadedTextures, returns the textures that were recreated since the
+	// last call. Materials holding one of them have to fetch it again with get()
+	std::vector<std::string> updateStreaming(dx12lib::CommonContextProxy pCommonCtx);
+	void setStreamingBudget(size_t budgetInBytes);
+	TextureResidency &getTextureResidency();
 public:
 	static inline std::string defaultAOMap        = "DefaultAlbedoMap.dds";
 	static inline std::string defaultAlbedoMap    = "DefaultAlbedoMap.dds";
@@ -25,6 +50,24 @@ public:
 	static void initDefaultTexture(dx12lib::DirectContextProxy pGraphicsCtx);
 private:
 	std::unordered_map<std::string, std::shared_ptr<dx12lib::Texture>> _textureMap;
+	std::unordered_set<std::string> _loadingTextures;
+	std::unique_ptr<TextureLoader> _pTextureLoader;
+
+	struct StreamingTexture {
+		size_t handle;
+		TextureLoadRequest request;		// read again when a change needs mips that were released
+		BakedTexture baked;				// the data of uploaded mips above the tail is released
+		bool reloading = false;
+	};
+	void applyStreamingChange(dx12lib::CommonContextProxy pCommonCtx, const std::string &fileName);
+	std::shared_ptr<dx12lib::Texture> createStreamingTexture(dx12lib::CommonContextProxy pCommonCtx,
+		StreamingTexture &streamingTexture
+	);
+	constexpr static size_t kDefaultStreamingBudget = 512 * 1024 * 1024;
+	TextureResidency _textureResidency{ kDefaultStreamingBudget };
+	std::unordered_map<std::string, StreamingTexture> _streamingTextures;
+	std::unordered_map<size_t, std::string> _streamingHandleToName;
+	std::vector<std::string> _updatedStreamingTextures;
 };
 
 }
\ No newline at end of file
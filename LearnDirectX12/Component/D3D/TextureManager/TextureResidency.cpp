@@ -0,0 +1,279 @@
+#include "TextureResidency.h"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <format>
+
+namespace d3d {
+
+TextureResidency::TextureResidency(size_t budgetInBytes, std::uint32_t tailMipSize)
+: _budgetInBytes(budgetInBytes), _tailMipSize(std::max(tailMipSize, 1u))
+{
+}
+
+size_t TextureResidency::registerTexture(const TextureStreamingDesc &desc) {
+	assert(!desc.mipSizeInBytes.empty());
+	size_t handle;
+	if (!_freeHandles.empty()) {
+		handle = _freeHandles.back();
+		_freeHandles.pop_back();
+	} else {
+		handle = _entries.size();
+		_entries.emplace_back();
+	}
+
+	Entry &entry = _entries[handle];
+	entry = Entry{};
+	entry.desc = desc;
+	entry.alive = true;
+	std::uint32_t lastMip = static_cast<std::uint32_t>(desc.mipSizeInBytes.size() - 1);
+	while (entry.tailMip < lastMip) {
+		std::uint32_t size = std::max(desc.width >> entry.tailMip, desc.height >> entry.tailMip);
+		if (size <= _tailMipSize)
+			break;
+		++entry.tailMip;
+	}
+	entry.residentMip = entry.tailMip;
+	entry.requestedMip = entry.tailMip;
+	entry.lastRequestFrame = _frameIndex;
+	_residentBytes += calcResidentBytes(entry, entry.residentMip);
+	++_numTextures;
+	return handle;
+}
+
+void TextureResidency::unregisterTexture(size_t handle) {
+	if (!isAlive(handle)) {
+		assert(false);
+		return;
+	}
+
+	Entry &entry = _entries[handle];
+	_residentBytes -= calcResidentBytes(entry, entry.residentMip);
+	entry = Entry{};
+	_freeHandles.push_back(handle);
+	--_numTextures;
+}
+
+void TextureResidency::requestMip(size_t handle, std::uint32_t desiredMip, float priority) {
+	if (!isAlive(handle)) {
+		assert(false);
+		return;
+	}
+
+	Entry &entry = _entries[handle];
+	desiredMip = std::min(desiredMip, entry.tailMip);
+	if (!entry.requested) {
+		entry.requested = true;
+		entry.requestedMip = desiredMip;
+		entry.priority = priority;
+	} else {
+		entry.requestedMip = std::min(entry.requestedMip, desiredMip);
+		entry.priority = std::max(entry.priority, priority);
+	}
+	entry.lastRequestFrame = _frameIndex;
+}
+
+void TextureResidency::requestScreenSize(size_t handle, float screenSizeInPixels) {
+	if (!isAlive(handle)) {
+		assert(false);
+		return;
+	}
+
+	const Entry &entry = _entries[handle];
+	std::uint32_t mip = calcDesiredMip(entry.desc.width, entry.desc.height, screenSizeInPixels);
+	requestMip(handle, mip, screenSizeInPixels);
+}
+
+std::vector<ResidencyChange> TextureResidency::update() {
+	_stats = TextureResidencyStats{};
+	std::map<size_t, std::uint32_t> originalMips;
+	auto setResidentMip = [&](size_t handle, std::uint32_t mip) {
+		Entry &entry = _entries[handle];
+		originalMips.try_emplace(handle, entry.residentMip);
+		_residentBytes -= calcResidentBytes(entry, entry.residentMip);
+		_residentBytes += calcResidentBytes(entry, mip);
+		entry.residentMip = mip;
+	};
+
+	std::vector<size_t> upgrades;
+	std::vector<size_t> evictions;
+	for (size_t handle = 0; handle < _entries.size(); ++handle) {
+		const Entry &entry = _entries[handle];
+		if (!entry.alive)
+			continue;
+
+		std::uint32_t targetMip = entry.requested ? entry.requestedMip : entry.residentMip;
+		_stats.requestedBytes += calcResidentBytes(entry, targetMip);
+		_stats.numRequested += entry.requested ? 1 : 0;
+		if (entry.requested && entry.requestedMip < entry.residentMip)
+			upgrades.push_back(handle);
+
+		std::uint32_t floorMip = entry.requested ? entry.requestedMip : entry.tailMip;
+		if (entry.residentMip < floorMip)
+			evictions.push_back(handle);
+	}
+
+	// the biggest on screen first
+	std::sort(upgrades.begin(), upgrades.end(), [&](size_t lhs, size_t rhs) {
+		return _entries[lhs].priority > _entries[rhs].priority;
+	});
+
+	// textures that were not used this frame go first, least recently used first,
+	// then textures that hold more detail than they asked for
+	std::sort(evictions.begin(), evictions.end(), [&](size_t lhs, size_t rhs) {
+		const Entry &a = _entries[lhs];
+		const Entry &b = _entries[rhs];
+		if (a.requested != b.requested)
+			return !a.requested;
+		if (a.lastRequestFrame != b.lastRequestFrame)
+			return a.lastRequestFrame < b.lastRequestFrame;
+		return a.priority < b.priority;
+	});
+
+	size_t evictCursor = 0;
+	auto makeRoom = [&](size_t needBytes) -> bool {
+		while (_residentBytes + needBytes > _budgetInBytes && evictCursor < evictions.size()) {
+			size_t handle = evictions[evictCursor];
+			Entry &entry = _entries[handle];
+			std::uint32_t floorMip = entry.requested ? entry.requestedMip : entry.tailMip;
+			size_t oldBytes = calcResidentBytes(entry, entry.residentMip);
+
+			// drop one level at a time and keep whatever still fits cached
+			std::uint32_t mip = entry.residentMip;
+			while (mip < floorMip) {
+				++mip;
+				if (_residentBytes - oldBytes + calcResidentBytes(entry, mip) + needBytes <= _budgetInBytes)
+					break;
+			}
+			if (mip >= floorMip)
+				++evictCursor;
+			if (mip == entry.residentMip)
+				continue;
+
+			_stats.evictedBytes += oldBytes - calcResidentBytes(entry, mip);
+			++_stats.numEvictions;
+			setResidentMip(handle, mip);
+		}
+		return _residentBytes + needBytes <= _budgetInBytes;
+	};
+
+	// the budget may have been lowered since the last frame
+	makeRoom(0);
+
+	size_t uploadBudget = _maxUploadBytesPerFrame > 0 ? _maxUploadBytesPerFrame : std::numeric_limits<size_t>::max();
+	for (size_t handle : upgrades) {
+		Entry &entry = _entries[handle];
+		size_t residentBytes = calcResidentBytes(entry, entry.residentMip);
+		// go as close to the requested mip as the budget allows
+		for (std::uint32_t mip = entry.requestedMip; mip < entry.residentMip; ++mip) {
+			size_t needBytes = calcResidentBytes(entry, mip) - residentBytes;
+			if (needBytes > uploadBudget || !makeRoom(needBytes))
+				continue;
+
+			uploadBudget -= needBytes;
+			_stats.uploadedBytes += needBytes;
+			++_stats.numUpgrades;
+			setResidentMip(handle, mip);
+			break;
+		}
+	}
+
+	std::vector<ResidencyChange> changes;
+	for (const auto &[handle, oldMip] : originalMips) {
+		if (_entries[handle].residentMip != oldMip)
+			changes.push_back(ResidencyChange{ handle, oldMip, _entries[handle].residentMip });
+	}
+
+	for (Entry &entry : _entries)
+		entry.requested = false;
+
+	_stats.numTextures = _numTextures;
+	_stats.budgetInBytes = _budgetInBytes;
+	_stats.residentBytes = _residentBytes;
+	++_frameIndex;
+	return changes;
+}
+
+void TextureResidency::setBudget(size_t budgetInBytes) {
+	_budgetInBytes = budgetInBytes;
+}
+
+void TextureResidency::setMaxUploadBytesPerFrame(size_t maxUploadBytes) {
+	_maxUploadBytesPerFrame = maxUploadBytes;
+}
+
+std::uint32_t TextureResidency::getResidentMip(size_t handle) const {
+	assert(isAlive(handle));
+	return _entries[handle].residentMip;
+}
+
+std::uint32_t TextureResidency::getTailMip(size_t handle) const {
+	assert(isAlive(handle));
+	return _entries[handle].tailMip;
+}
+
+size_t TextureResidency::getResidentBytes() const {
+	return _residentBytes;
+}
+
+size_t TextureResidency::getNumTextures() const {
+	return _numTextures;
+}
+
+const TextureResidencyStats &TextureResidency::getStats() const {
+	return _stats;
+}
+
+std::string TextureResidency::dumpStats() const {
+	constexpr double kMB = 1024.0 * 1024.0;
+	return std::format("[TextureResidency] textures: {}, requested: {}, upgrades: {}, evictions: {}, "
+		"requested: {:.2f} MB, resident: {:.2f}/{:.2f} MB, uploaded: {:.2f} MB, evicted: {:.2f} MB\n",
+		_stats.numTextures,
+		_stats.numRequested,
+		_stats.numUpgrades,
+		_stats.numEvictions,
+		_stats.requestedBytes / kMB,
+		_stats.residentBytes / kMB,
+		_stats.budgetInBytes / kMB,
+		_stats.uploadedBytes / kMB,
+		_stats.evictedBytes / kMB
+	);
+}
+
+std::uint32_t TextureResidency::calcDesiredMip(std::uint32_t width, std::uint32_t height, float screenSizeInPixels) {
+	float textureSize = static_cast<float>(std::max(width, height));
+	if (screenSizeInPixels >= textureSize)
+		return 0;
+	if (screenSizeInPixels < 1.f)
+		return std::numeric_limits<std::uint32_t>::max();
+	return static_cast<std::uint32_t>(std::floor(std::log2(textureSize / screenSizeInPixels)));
+}
+
+float TextureResidency::estimateScreenSize(float radius, float distance, float tanHalfFovY, float viewportHeight) {
+	if (distance <= radius)
+		return viewportHeight;
+	return radius / (distance * tanHalfFovY) * viewportHeight;
+}
+
+float TextureResidency::estimateScreenSize(const float center[3], float radius, const TextureStreamingView &view) {
+	float dx = center[0] - view.eyePosition[0];
+	float dy = center[1] - view.eyePosition[1];
+	float dz = center[2] - view.eyePosition[2];
+	float distance = std::sqrt(dx*dx + dy*dy + dz*dz);
+	return estimateScreenSize(radius, distance, view.tanHalfFovY, view.viewportHeight);
+}
+
+size_t TextureResidency::calcResidentBytes(const Entry &entry, std::uint32_t mip) const {
+	size_t bytes = 0;
+	for (size_t i = mip; i < entry.desc.mipSizeInBytes.size(); ++i)
+		bytes += entry.desc.mipSizeInBytes[i];
+	return bytes;
+}
+
+bool TextureResidency::isAlive(size_t handle) const {
+	return handle < _entries.size() && _entries[handle].alive;
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace d3d {
+
+struct TextureStreamingDesc {
+	std::uint32_t width  = 0;
+	std::uint32_t height = 0;
+	std::vector<size_t> mipSizeInBytes;				// index 0 is the most detailed level
+};
+
+// mip indices are the most detailed resident level, everything from there down to the last mip is resident
+struct ResidencyChange {
+	size_t		  handle;
+	std::uint32_t oldMip;
+	std::uint32_t newMip;
+};
+
+struct TextureStreamingView {
+	float eyePosition[3] = { 0.f, 0.f, 0.f };
+	float tanHalfFovY	 = 1.f;
+	float viewportHeight = 1.f;
+};
+
+struct TextureResidencyStats {
+	size_t numTextures = 0;
+	size_t numRequested = 0;						// textures requested this frame
+	size_t numUpgrades = 0;
+	size_t numEvictions = 0;
+	size_t budgetInBytes = 0;
+	size_t requestedBytes = 0;						// every texture at the mip it asked for
+	size_t residentBytes = 0;
+	size_t uploadedBytes = 0;						// streamed in this frame
+	size_t evictedBytes = 0;						// dropped this frame
+};
+
+// CPU side of texture streaming. Tracks which mips of every texture should be resident,
+// upgrades the most important requests first and trims the least recently used textures
+// when the budget is exceeded. Applying the changes on the GPU is up to the caller
+class TextureResidency {
+public:
+	explicit TextureResidency(size_t budgetInBytes, std::uint32_t tailMipSize = 64);
+	// only the mip tail (levels not larger than tailMipSize) is resident after registering
+	size_t registerTexture(const TextureStreamingDesc &desc);
+	void unregisterTexture(size_t handle);
+
+	// several requests in one frame keep the most detailed mip and the highest priority
+	void requestMip(size_t handle, std::uint32_t desiredMip, float priority);
+	void requestScreenSize(size_t handle, float screenSizeInPixels);
+
+	// call once per frame after all requests, returns the mip changes to apply
+	std::vector<ResidencyChange> update();
+
+	void setBudget(size_t budgetInBytes);
+	void setMaxUploadBytesPerFrame(size_t maxUploadBytes);		// 0 means unlimited
+	std::uint32_t getResidentMip(size_t handle) const;
+	std::uint32_t getTailMip(size_t handle) const;
+	size_t getResidentBytes() const;
+	size_t getNumTextures() const;
+	const TextureResidencyStats &getStats() const;
+	std::string dumpStats() const;
+
+	static std::uint32_t calcDesiredMip(std::uint32_t width, std::uint32_t height, float screenSizeInPixels);
+	// projected diameter in pixels of a bounding sphere
+	static float estimateScreenSize(float radius, float distance, float tanHalfFovY, float viewportHeight);
+	static float estimateScreenSize(const float center[3], float radius, const TextureStreamingView &view);
+public:
+	constexpr static size_t kInvalidHandle = -1;
+private:
+	struct Entry {
+		TextureStreamingDesc desc;
+		std::uint32_t tailMip = 0;
+		std::uint32_t residentMip = 0;
+		std::uint32_t requestedMip = 0;
+		float priority = 0.f;
+		std::uint64_t lastRequestFrame = 0;
+		bool requested = false;
+		bool alive = false;
+	};
+	size_t calcResidentBytes(const Entry &entry, std::uint32_t mip) const;
+	bool isAlive(size_t handle) const;
+private:
+	std::vector<Entry> _entries;
+	std::vector<size_t> _freeHandles;
+	size_t _budgetInBytes;
+	size_t _maxUploadBytesPerFrame = 0;
+	std::uint32_t _tailMipSize;
+	std::uint64_t _frameIndex = 1;
+	size_t _residentBytes = 0;
+	size_t _numTextures = 0;
+	TextureResidencyStats _stats;
+};
+
+}
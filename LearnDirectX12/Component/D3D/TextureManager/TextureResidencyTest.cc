@@ -0,0 +1,80 @@
+#include <iostream>
+#include <numeric>
+#include "TestCheck.h"
+#include "D3D/TextureManager/TextureResidency.h"
+
+using namespace d3d;
+
+void textureResidencyTest() {
+	auto makeDesc = [](std::uint32_t size) {
+		TextureStreamingDesc desc;
+		desc.width = size;
+		desc.height = size;
+		for (std::uint32_t mip = size; mip > 0; mip >>= 1)
+			desc.mipSizeInBytes.push_back(static_cast<size_t>(mip) * mip * 4);
+		return desc;
+	};
+	auto bytesFrom = [](const TextureStreamingDesc &desc, std::uint32_t mip) {
+		return std::accumulate(desc.mipSizeInBytes.begin() + mip, desc.mipSizeInBytes.end(), size_t(0));
+	};
+
+	TEST_CHECK(TextureResidency::calcDesiredMip(1024, 1024, 2048.f) == 0);
+	TEST_CHECK(TextureResidency::calcDesiredMip(1024, 1024, 256.f) == 2);
+	TEST_CHECK(TextureResidency::calcDesiredMip(1024, 512, 100.f) == 3);
+
+	TextureStreamingDesc desc = makeDesc(1024);
+	size_t fullBytes = bytesFrom(desc, 0);
+	size_t tailBytes = bytesFrom(desc, 4);
+	// room for one full chain plus a chain without its top mip
+	size_t budget = fullBytes + bytesFrom(desc, 1);
+	TextureResidency residency(budget, 64);
+	size_t a = residency.registerTexture(desc);
+	size_t b = residency.registerTexture(desc);
+	TEST_CHECK(residency.getTailMip(a) == 4 && residency.getResidentMip(a) == 4);
+	TEST_CHECK(residency.getResidentBytes() == 2 * tailBytes);
+
+	// smallest mips first, upgrade on request
+	residency.requestScreenSize(a, 1024.f);
+	residency.requestScreenSize(a, 300.f);			// a second, smaller use keeps the larger request
+	auto changes = residency.update();
+	TEST_CHECK(changes.size() == 1 && changes[0].handle == a && changes[0].oldMip == 4 && changes[0].newMip == 0);
+	TEST_CHECK(residency.getStats().uploadedBytes == fullBytes - tailBytes);
+
+	// a is no longer used, b needs the memory: a gets trimmed back towards its tail
+	residency.update();
+	residency.requestScreenSize(b, 1024.f);
+	changes = residency.update();
+	TEST_CHECK(residency.getResidentMip(b) == 0);
+	TEST_CHECK(residency.getResidentMip(a) > 0);
+	TEST_CHECK(residency.getStats().numEvictions == 1 && residency.getStats().evictedBytes > 0);
+	TEST_CHECK(residency.getResidentBytes() <= budget);
+
+	// both wanted, the bigger one on screen wins the full chain
+	residency.requestScreenSize(a, 4096.f);
+	residency.requestScreenSize(b, 512.f);
+	residency.update();
+	TEST_CHECK(residency.getResidentMip(a) == 0 && residency.getResidentMip(b) == 1);
+	TEST_CHECK(residency.getResidentBytes() <= budget);
+
+	// lowering the budget drops detail even without new requests
+	residency.setBudget(2 * tailBytes);
+	residency.update();
+	TEST_CHECK(residency.getResidentMip(a) == 4 && residency.getResidentMip(b) == 4);
+
+	// per frame upload limit
+	residency.setBudget(fullBytes * 4);
+	residency.setMaxUploadBytesPerFrame(desc.mipSizeInBytes[1] + desc.mipSizeInBytes[2] + desc.mipSizeInBytes[3]);
+	residency.requestScreenSize(a, 1024.f);
+	residency.update();
+	TEST_CHECK(residency.getResidentMip(a) == 1);
+	std::cout << residency.dumpStats();
+
+	residency.unregisterTexture(a);
+	residency.unregisterTexture(b);
+	TEST_CHECK(residency.getResidentBytes() == 0 && residency.getNumTextures() == 0);
+}
+
+int main() {
+	textureResidencyTest();
+	return 0;
+}
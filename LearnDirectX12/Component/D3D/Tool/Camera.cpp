@@ -1,9 +1,7 @@
 #define NOMINMAX
 #include <algorithm>
+#include <limits>
 #include "Camera.h"
-
-#include <iostream>
-
 #include "D3D/Shader/ShaderCommon.h"
 #include "GameTimer/GameTimer.h"
 #include "InputSystem/Mouse.h"
@@ -33,12 +31,40 @@ CameraBase::CameraBase(const CameraDesc &desc) {
 	_farClip = desc.farClip;
 	_fov = desc.fov;
 	_aspect = desc.aspect;
+	_core.setDepthMode(desc.depthMode);
 
 	assert(lengthSquare(Vector3(_lookUp)) > 0.f);
 	assert(lengthSquare(w) > 0.f);
 	assert(_fov > 1.f);
 	assert(_nearClip > 0.f);
 	assert(_farClip > _nearClip);
+
+	_frustumVersion = std::numeric_limits<std::uint64_t>::max();
+	updateCore();
+}
+
+const float4x4 &CameraBase::getView() const {
+	return _core.getView();
+}
+
+const float4x4 &CameraBase::getProj() const {
+	return _core.getProj();
+}
+
+const float4x4 &CameraBase::getViewProj() const {
+	return _core.getViewProj();
+}
+
+const float4x4 &CameraBase::getInvView() const {
+	return _core.getInvView();
+}
+
+const float4x4 &CameraBase::getInvProj() const {
+	return _core.getInvProj();
+}
+
+const float4x4 &CameraBase::getInvViewProj() const {
+	return _core.getInvViewProj();
 }
 
 Matrix4 CameraBase::getMatView() const {
@@ -96,6 +122,37 @@ float CameraBase::getAspect() const {
 	return _aspect;
 }
 
+void CameraBase::setDepthMode(DepthMode mode) {
+	_core.setDepthMode(mode);
+	refreshCore();
+}
+
+DepthMode CameraBase::getDepthMode() const {
+	return _core.getDepthMode();
+}
+
+bool CameraBase::isReverseZ() const {
+	return d3d::isReverseZ(_core.getDepthMode());
+}
+
+float CameraBase::getClearDepth() const {
+	return d3d::getClearDepth(_core.getDepthMode());
+}
+
+D3D12_COMPARISON_FUNC CameraBase::getDepthComparisonFunc() const {
+	return isReverseZ() ? D3D12_COMPARISON_FUNC_GREATER_EQUAL : D3D12_COMPARISON_FUNC_LESS_EQUAL;
+}
+
+void CameraBase::setHaltonJitter(size_t frameIndex, float width, float height, size_t sequenceLength) {
+	_core.setHaltonJitter(frameIndex, width, height, sequenceLength);
+	refreshCore();
+}
+
+void CameraBase::clearJitter() {
+	_core.clearJitter();
+	refreshCore();
+}
+
 const BoundingFrustum &CameraBase::getProjSpaceFrustum() const {
 	return _projSpaceFrustum;
 }
@@ -104,4 +161,29 @@ const BoundingFrustum &CameraBase::getViewSpaceFrustum() const {
 	return _viewSpaceFrustum;
 }
 
+const FrustumPlanesSoA &CameraBase::getFrustumPlanes() const {
+	return _core.getFrustumPlanes();
+}
+
+const CameraCore &CameraBase::getCore() const {
+	return _core;
+}
+
+void CameraBase::updateCore() {
+	_core.setLookAt(_lookFrom, _lookAt, _lookUp);
+	_core.setPerspective(DirectX::XMConvertToRadians(_fov), _aspect, _nearClip, _farClip);
+	refreshCore();
+	DEBUG_CLEAR_DIRTY;
+}
+
+void CameraBase::refreshCore() {
+	_core.update();
+	if (_frustumVersion == _core.getVersion())
+		return;
+	// the jitter does not move the frustum, rebuilding it for a jitter change is cheap enough
+	_projSpaceFrustum = { Matrix4(_core.getFiniteProj()) };
+	_viewSpaceFrustum = _projSpaceFrustum.transform(Matrix4(_core.getInvView()));
+	_frustumVersion = _core.getVersion();
+}
+
 }
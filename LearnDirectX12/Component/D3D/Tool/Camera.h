@@ -3,6 +3,7 @@
 #include "Math/MathHelper.h"
 #include "D3D/d3dutil.h"
 #include "Math/MathStd.hpp"
+#include "D3D/Tool/CameraCore.h"
 
 namespace com {
 
@@ -24,17 +25,21 @@ struct CameraDesc {
 	float        nearClip;
 	float        farClip;
 	float        aspect;
+	DepthMode    depthMode = DepthMode::Standard;
 };
 
+// The matrices live in a CameraCore and are only recomputed when the parameters pushed by
+// updateCore changed. updateCore runs on the update thread, the getters only read the core
 class CameraBase {
 public:
 	CameraBase(const CameraDesc &desc);
-	virtual const Math::float4x4 &getView() const = 0;
-	virtual const Math::float4x4 &getProj() const = 0;
-	virtual const Math::float4x4 &getViewProj() const = 0;
-	virtual	const Math::float4x4 &getInvView() const = 0;
-	virtual const Math::float4x4 &getInvProj() const = 0;
-	virtual const Math::float4x4 &getInvViewProj() const = 0;
+	virtual ~CameraBase() = default;
+	const Math::float4x4 &getView() const;
+	const Math::float4x4 &getProj() const;
+	const Math::float4x4 &getViewProj() const;
+	const Math::float4x4 &getInvView() const;
+	const Math::float4x4 &getInvProj() const;
+	const Math::float4x4 &getInvViewProj() const;
 	virtual void update(std::shared_ptr<com::GameTimer> pGameTimer) = 0;
 	Math::Matrix4 getMatView() const;
 	Math::Matrix4 getMatProj() const;
@@ -47,8 +52,28 @@ public:
 	void setAspect(float aspect);
 	float getFov() const;
 	float getAspect() const;
+	// reverse Z needs a float depth buffer cleared to getClearDepth() and GREATER_EQUAL depth tests
+	void setDepthMode(DepthMode mode);
+	DepthMode getDepthMode() const;
+	bool isReverseZ() const;
+	float getClearDepth() const;
+	D3D12_COMPARISON_FUNC getDepthComparisonFunc() const;
+	// subpixel jitter for temporal techniques, only getProj/getViewProj and their inverses carry it
+	void setHaltonJitter(size_t frameIndex, float width, float height, size_t sequenceLength = 8);
+	void clearJitter();
+	// built from near to far clip with standard depth in every mode, an infinite projection has no
+	// far corners
 	const Math::BoundingFrustum &getProjSpaceFrustum() const;
+	// world space, the name is kept for the existing callers
 	const Math::BoundingFrustum &getViewSpaceFrustum() const;
+	const FrustumPlanesSoA &getFrustumPlanes() const;
+	const CameraCore &getCore() const;
+protected:
+	// pushes _lookFrom/_lookAt/_lookUp and the projection parameters to the core, called at the
+	// end of update
+	void updateCore();
+private:
+	void refreshCore();
 protected:
 	float  _fov;
 	float  _aspect;
@@ -58,12 +83,14 @@ public:
 	Math::float3  _lookAt;
 	float         _nearClip;
 	float         _farClip;
-	Math::BoundingFrustum _viewSpaceFrustum;
-	Math::BoundingFrustum _projSpaceFrustum;
 #if defined(_DEBUG) || defined(DEBUG)
 	bool   _isDirty = false;
 #endif
-
+private:
+	CameraCore _core;
+	std::uint64_t _frustumVersion;
+	Math::BoundingFrustum _viewSpaceFrustum;
+	Math::BoundingFrustum _projSpaceFrustum;
 };
 
-}
\ No newline at end of file
+}
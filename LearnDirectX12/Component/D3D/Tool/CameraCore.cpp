@@ -0,0 +1,482 @@
+#include "CameraCore.h"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+	#define D3D_CAMERA_CORE_SSE 1
+	#include <emmintrin.h>
+#else
+	#define D3D_CAMERA_CORE_SSE 0
+#endif
+
+namespace d3d {
+
+using namespace Math;
+
+template<typename T>
+static bool assignIfChanged(T &dst, const T &src) {
+	if (std::memcmp(&dst, &src, sizeof(T)) == 0)
+		return false;
+	std::memcpy(&dst, &src, sizeof(T));
+	return true;
+}
+
+bool FrustumPlanesSoA::intersectsSphere(const float center[3], float radius) const {
+#if D3D_CAMERA_CORE_SSE
+	__m128 cx = _mm_set1_ps(center[0]);
+	__m128 cy = _mm_set1_ps(center[1]);
+	__m128 cz = _mm_set1_ps(center[2]);
+	__m128 negRadius = _mm_set1_ps(-radius);
+	for (size_t i = 0; i < kNumLanes; i += 4) {
+		__m128 dist = _mm_add_ps(_mm_mul_ps(_mm_load_ps(nx + i), cx), _mm_load_ps(d + i));
+		dist = _mm_add_ps(dist, _mm_mul_ps(_mm_load_ps(ny + i), cy));
+		dist = _mm_add_ps(dist, _mm_mul_ps(_mm_load_ps(nz + i), cz));
+		if (_mm_movemask_ps(_mm_cmplt_ps(dist, negRadius)) != 0)
+			return false;
+	}
+	return true;
+#else
+	for (size_t i = 0; i < kNumPlanes; ++i) {
+		if (nx[i] * center[0] + ny[i] * center[1] + nz[i] * center[2] + d[i] < -radius)
+			return false;
+	}
+	return true;
+#endif
+}
+
+bool FrustumPlanesSoA::intersectsBox(const float center[3], const float extents[3]) const {
+#if D3D_CAMERA_CORE_SSE
+	__m128 cx = _mm_set1_ps(center[0]);
+	__m128 cy = _mm_set1_ps(center[1]);
+	__m128 cz = _mm_set1_ps(center[2]);
+	__m128 ex = _mm_set1_ps(extents[0]);
+	__m128 ey = _mm_set1_ps(extents[1]);
+	__m128 ez = _mm_set1_ps(extents[2]);
+	__m128 signMask = _mm_set1_ps(-0.f);
+	for (size_t i = 0; i < kNumLanes; i += 4) {
+		__m128 px = _mm_load_ps(nx + i);
+		__m128 py = _mm_load_ps(ny + i);
+		__m128 pz = _mm_load_ps(nz + i);
+		__m128 dist = _mm_add_ps(_mm_mul_ps(px, cx), _mm_load_ps(d + i));
+		dist = _mm_add_ps(dist, _mm_mul_ps(py, cy));
+		dist = _mm_add_ps(dist, _mm_mul_ps(pz, cz));
+		__m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, px), ex);
+		radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, py), ey));
+		radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+		if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps())) != 0)
+			return false;
+	}
+	return true;
+#else
+	for (size_t i = 0; i < kNumPlanes; ++i) {
+		float dist = nx[i] * center[0] + ny[i] * center[1] + nz[i] * center[2] + d[i];
+		float radius = std::abs(nx[i]) * extents[0] + std::abs(ny[i]) * extents[1] + std::abs(nz[i]) * extents[2];
+		if (dist + radius < 0.f)
+			return false;
+	}
+	return true;
+#endif
+}
+
+size_t FrustumPlanesSoA::cullSpheres(const float *pX, const float *pY, const float *pZ, const float *pRadius,
+	size_t count, std::uint8_t *pVisible) const
+{
+	size_t numVisible = 0;
+	size_t i = 0;
+#if D3D_CAMERA_CORE_SSE
+	// four spheres per iteration against one broadcast plane at a time
+	for (; i + 4 <= count; i += 4) {
+		__m128 cx = _mm_loadu_ps(pX + i);
+		__m128 cy = _mm_loadu_ps(pY + i);
+		__m128 cz = _mm_loadu_ps(pZ + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(pRadius + i));
+		__m128 outside = _mm_setzero_ps();
+		for (size_t plane = 0; plane < kNumPlanes; ++plane) {
+			__m128 dist = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(nx[plane]), cx), _mm_set1_ps(d[plane]));
+			dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(ny[plane]), cy));
+			dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(nz[plane]), cz));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negRadius));
+		}
+		int mask = _mm_movemask_ps(outside);
+		for (size_t lane = 0; lane < 4; ++lane) {
+			std::uint8_t visible = (mask >> lane & 1) == 0 ? 1 : 0;
+			pVisible[i + lane] = visible;
+			numVisible += visible;
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		const float center[3] = { pX[i], pY[i], pZ[i] };
+		std::uint8_t visible = intersectsSphere(center, pRadius[i]) ? 1 : 0;
+		pVisible[i] = visible;
+		numVisible += visible;
+	}
+	return numVisible;
+}
+
+float getClearDepth(DepthMode mode) {
+	return isReverseZ(mode) ? 0.f : 1.f;
+}
+
+bool isReverseZ(DepthMode mode) {
+	return mode != DepthMode::Standard;
+}
+
+float halton(std::uint32_t index, std::uint32_t base) {
+	assert(base >= 2);
+	float fraction = 1.f;
+	float result = 0.f;
+	while (index > 0) {
+		fraction /= static_cast<float>(base);
+		result += fraction * static_cast<float>(index % base);
+		index /= base;
+	}
+	return result;
+}
+
+void haltonJitter(size_t frameIndex, size_t sequenceLength, float jitter[2]) {
+	assert(sequenceLength > 0);
+	auto index = static_cast<std::uint32_t>(frameIndex % sequenceLength + 1);
+	jitter[0] = halton(index, 2) - 0.5f;
+	jitter[1] = halton(index, 3) - 0.5f;
+}
+
+CameraCore::CameraCore()
+: _eye(0.f, 0.f, 0.f), _target(0.f, 0.f, 1.f), _upHint(0.f, 1.f, 0.f)
+, _fovY(0.7853982f), _aspect(1.f), _nearClip(0.1f), _farClip(1000.f), _jitter{ 0.f, 0.f }
+, _depthMode(DepthMode::Standard)
+, _version(0), _dirtyFlags(ViewDirty | ProjDirty | ViewProjDirty | PlanesDirty)
+{
+}
+
+void CameraCore::setLookAt(const float3 &eye, const float3 &target, const float3 &up) {
+	bool changed = assignIfChanged(_eye, eye);
+	changed |= assignIfChanged(_target, target);
+	changed |= assignIfChanged(_upHint, up);
+	if (changed)
+		markDirty(ViewDirty | ViewProjDirty | PlanesDirty);
+}
+
+void CameraCore::setPerspective(float fovY, float aspect, float zNear, float zFar) {
+	assert(fovY > 0.f && aspect > 0.f);
+	assert(zNear > 0.f && zFar > zNear);
+	const float params[4] = { fovY, aspect, zNear, zFar };
+	float current[4] = { _fovY, _aspect, _nearClip, _farClip };
+	if (!assignIfChanged(current, params))
+		return;
+
+	_fovY = fovY;
+	_aspect = aspect;
+	_nearClip = zNear;
+	_farClip = zFar;
+	markDirty(ProjDirty | ViewProjDirty | PlanesDirty);
+}
+
+void CameraCore::setDepthMode(DepthMode mode) {
+	if (_depthMode == mode)
+		return;
+	_depthMode = mode;
+	markDirty(ProjDirty | ViewProjDirty | PlanesDirty);
+}
+
+void CameraCore::setJitter(float pixelX, float pixelY, float width, float height) {
+	assert(width > 0.f && height > 0.f);
+	// pixel y grows downwards, clip space y upwards
+	const float jitter[2] = { 2.f * pixelX / width, -2.f * pixelY / height };
+	if (assignIfChanged(_jitter, jitter))
+		markDirty(ProjDirty | ViewProjDirty);
+}
+
+void CameraCore::setHaltonJitter(size_t frameIndex, float width, float height, size_t sequenceLength) {
+	float jitter[2];
+	haltonJitter(frameIndex, sequenceLength, jitter);
+	setJitter(jitter[0], jitter[1], width, height);
+}
+
+void CameraCore::clearJitter() {
+	const float jitter[2] = { 0.f, 0.f };
+	if (assignIfChanged(_jitter, jitter))
+		markDirty(ProjDirty | ViewProjDirty);
+}
+
+void CameraCore::update() {
+	updateView();
+	updateProj();
+	updateViewProj();
+	updatePlanes();
+}
+
+bool CameraCore::isDirty() const {
+	return _dirtyFlags != 0;
+}
+
+const float4x4 &CameraCore::getView() const {
+	assert(!isDirty());
+	return _view;
+}
+
+const float4x4 &CameraCore::getInvView() const {
+	assert(!isDirty());
+	return _invView;
+}
+
+const float4x4 &CameraCore::getProj() const {
+	assert(!isDirty());
+	return _proj;
+}
+
+const float4x4 &CameraCore::getInvProj() const {
+	assert(!isDirty());
+	return _invProj;
+}
+
+const float4x4 &CameraCore::getViewProj() const {
+	assert(!isDirty());
+	return _viewProj;
+}
+
+const float4x4 &CameraCore::getInvViewProj() const {
+	assert(!isDirty());
+	return _invViewProj;
+}
+
+const float4x4 &CameraCore::getUnjitteredProj() const {
+	assert(!isDirty());
+	return _unjitteredProj;
+}
+
+const float4x4 &CameraCore::getUnjitteredViewProj() const {
+	assert(!isDirty());
+	return _unjitteredViewProj;
+}
+
+const float4x4 &CameraCore::getFiniteProj() const {
+	assert(!isDirty());
+	return _finiteProj;
+}
+
+const FrustumPlanesSoA &CameraCore::getFrustumPlanes() const {
+	assert(!isDirty());
+	return _planes;
+}
+
+const float3 &CameraCore::getEye() const {
+	return _eye;
+}
+
+const float3 &CameraCore::getRight() const {
+	assert(!isDirty());
+	return _right;
+}
+
+const float3 &CameraCore::getUp() const {
+	assert(!isDirty());
+	return _up;
+}
+
+const float3 &CameraCore::getForward() const {
+	assert(!isDirty());
+	return _forward;
+}
+
+const float *CameraCore::getJitter() const {
+	return _jitter;
+}
+
+const float *CameraCore::getDepthParams() const {
+	assert(!isDirty());
+	return _depthParams;
+}
+
+float CameraCore::linearizeDepth(float depth) const {
+	assert(!isDirty());
+	return _depthParams[1] / (depth - _depthParams[0]);
+}
+
+DepthMode CameraCore::getDepthMode() const {
+	return _depthMode;
+}
+
+float CameraCore::getFovY() const {
+	return _fovY;
+}
+
+float CameraCore::getAspect() const {
+	return _aspect;
+}
+
+float CameraCore::getNearClip() const {
+	return _nearClip;
+}
+
+float CameraCore::getFarClip() const {
+	return _farClip;
+}
+
+std::uint64_t CameraCore::getVersion() const {
+	return _version;
+}
+
+const CameraCoreStats &CameraCore::getStats() const {
+	return _stats;
+}
+
+void CameraCore::markDirty(std::uint32_t flags) {
+	_dirtyFlags |= flags;
+	++_version;
+}
+
+void CameraCore::updateView() {
+	if ((_dirtyFlags & ViewDirty) == 0)
+		return;
+
+	// same basis as XMMatrixLookAtLH
+	Vector3 eye(_eye);
+	Vector3 forward = Vector3(_target) - eye;
+	assert(lengthSquare(forward) > 0.f);
+	forward = normalize(forward);
+	Vector3 right = normalize(cross(Vector3(_upHint), forward));
+	Vector3 up = cross(forward, right);
+	_forward = forward.xyz;
+	_right = right.xyz;
+	_up = up.xyz;
+
+	float eyeRight = dot(right, eye);
+	float eyeUp = dot(up, eye);
+	float eyeForward = dot(forward, eye);
+	_view = float4x4(Matrix4(DX::XMMATRIX(
+		_right.x, _up.x, _forward.x, 0.f,
+		_right.y, _up.y, _forward.y, 0.f,
+		_right.z, _up.z, _forward.z, 0.f,
+		-eyeRight, -eyeUp, -eyeForward, 1.f
+	)));
+	// a rigid transform, the inverse is the transposed rotation followed by the eye
+	_invView = float4x4(Matrix4(DX::XMMATRIX(
+		_right.x,	_right.y,	_right.z,	0.f,
+		_up.x,		_up.y,		_up.z,		0.f,
+		_forward.x, _forward.y, _forward.z, 0.f,
+		_eye.x,		_eye.y,		_eye.z,		1.f
+	)));
+	_dirtyFlags &= ~ViewDirty;
+	++_stats.numViewUpdates;
+}
+
+void CameraCore::updateProj() {
+	if ((_dirtyFlags & ProjDirty) == 0)
+		return;
+
+	// same terms as XMMatrixPerspectiveFovLH, only the depth row changes with the mode
+	float halfFov = 0.5f * _fovY;
+	float yScale = std::cos(halfFov) / std::sin(halfFov);
+	float xScale = yScale / _aspect;
+	float finiteScale = _farClip / (_farClip - _nearClip);
+	float zScale = finiteScale;
+	float zOffset = -finiteScale * _nearClip;
+	switch (_depthMode) {
+	case DepthMode::ReverseZ:
+		zScale = -_nearClip / (_farClip - _nearClip);
+		zOffset = _nearClip * _farClip / (_farClip - _nearClip);
+		break;
+	case DepthMode::ReverseZInfinite:
+		// the limit of ReverseZ for far -> infinity, depth = near / viewZ
+		zScale = 0.f;
+		zOffset = _nearClip;
+		break;
+	default:
+		break;
+	}
+	float jx = _jitter[0];
+	float jy = _jitter[1];
+	_depthParams[0] = zScale;
+	_depthParams[1] = zOffset;
+
+	_finiteProj = float4x4(Matrix4(DX::XMMATRIX(
+		xScale, 0.f,	0.f,						0.f,
+		0.f,	yScale, 0.f,						0.f,
+		0.f,	0.f,	finiteScale,				1.f,
+		0.f,	0.f,	-finiteScale * _nearClip,	0.f
+	)));
+	_unjitteredProj = _finiteProj;
+	_unjitteredProj.m[2][2] = zScale;
+	_unjitteredProj.m[3][2] = zOffset;
+	// the jitter is added to clip x and y scaled by w, which is view z
+	_proj = _unjitteredProj;
+	_proj.m[2][0] = jx;
+	_proj.m[2][1] = jy;
+
+	// clip (X, Y, Z, W) -> view (x, y, z, 1): z = W, x = (X - jx W) / xScale, y = (Y - jy W) / yScale
+	// and the homogeneous 1 is (Z - zScale W) / zOffset
+	_invProj = float4x4(Matrix4(DX::XMMATRIX(
+		1.f / xScale,	0.f,			0.f, 0.f,
+		0.f,			1.f / yScale,	0.f, 0.f,
+		0.f,			0.f,			0.f, 1.f / zOffset,
+		-jx / xScale,	-jy / yScale,	1.f, -zScale / zOffset
+	)));
+	_dirtyFlags &= ~ProjDirty;
+	++_stats.numProjUpdates;
+}
+
+void CameraCore::updateViewProj() {
+	if ((_dirtyFlags & ViewProjDirty) == 0)
+		return;
+
+	// the view applies first
+	Matrix4 view(_view);
+	_viewProj = float4x4(Matrix4(_proj) * view);
+	_unjitteredViewProj = float4x4(Matrix4(_unjitteredProj) * view);
+	// (P V)^-1 = V^-1 P^-1, both already known
+	_invViewProj = float4x4(Matrix4(_invView) * Matrix4(_invProj));
+	_dirtyFlags &= ~ViewProjDirty;
+	++_stats.numViewProjUpdates;
+}
+
+void CameraCore::updatePlanes() {
+	if ((_dirtyFlags & PlanesDirty) == 0)
+		return;
+
+	// Gribb-Hartmann on the unjittered matrix: with row vectors clip = p * M, so the planes are
+	// sums of its columns. D3D clip space is -w <= x, y <= w and 0 <= z <= w
+	const float4x4 &m = _unjitteredViewProj;
+	auto column = [&](size_t col, float sign, size_t plane) {
+		_planes.nx[plane] = m.m[0][3] + sign * m.m[0][col];
+		_planes.ny[plane] = m.m[1][3] + sign * m.m[1][col];
+		_planes.nz[plane] = m.m[2][3] + sign * m.m[2][col];
+		_planes.d[plane] = m.m[3][3] + sign * m.m[3][col];
+	};
+	// 0 <= z is the near plane with standard depth and the far one with reversed depth
+	bool reversed = isReverseZ(_depthMode);
+	size_t zeroPlane = reversed ? FrustumPlanesSoA::Far : FrustumPlanesSoA::Near;
+	size_t wPlane = reversed ? FrustumPlanesSoA::Near : FrustumPlanesSoA::Far;
+	_planes.nx[zeroPlane] = m.m[0][2];
+	_planes.ny[zeroPlane] = m.m[1][2];
+	_planes.nz[zeroPlane] = m.m[2][2];
+	_planes.d[zeroPlane] = m.m[3][2];
+	column(2, -1.f, wPlane);
+	column(0, +1.f, FrustumPlanesSoA::Left);
+	column(0, -1.f, FrustumPlanesSoA::Right);
+	column(1, +1.f, FrustumPlanesSoA::Bottom);
+	column(1, -1.f, FrustumPlanesSoA::Top);
+
+	for (size_t i = 0; i < FrustumPlanesSoA::kNumLanes; ++i) {
+		Vector3 normal(_planes.nx[i], _planes.ny[i], _planes.nz[i]);
+		float lengthSq = lengthSquare(normal);
+		// padding lanes and the far plane of an infinite projection accept everything
+		if (i >= FrustumPlanesSoA::kNumPlanes || lengthSq < 1e-12f) {
+			_planes.nx[i] = 0.f;
+			_planes.ny[i] = 0.f;
+			_planes.nz[i] = 0.f;
+			_planes.d[i] = 1.f;
+			continue;
+		}
+		float invLength = 1.f / std::sqrt(lengthSq);
+		_planes.nx[i] *= invLength;
+		_planes.ny[i] *= invLength;
+		_planes.nz[i] *= invLength;
+		_planes.d[i] *= invLength;
+	}
+	_dirtyFlags &= ~PlanesDirty;
+	++_stats.numPlaneUpdates;
+}
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Math/MathStd.hpp"
+
+namespace d3d {
+
+// world space frustum planes as structure of arrays, lane i of every array is plane i. Normals
+// point inwards: dot(n, p) + d >= 0 inside. The lanes past the six planes are padding that accepts
+// everything, so a culler can test two groups of four planes without a tail
+struct FrustumPlanesSoA {
+	enum Plane { Near, Far, Left, Right, Bottom, Top, kNumPlanes };
+	constexpr static size_t kNumLanes = 8;
+	alignas(16) float nx[kNumLanes];
+	alignas(16) float ny[kNumLanes];
+	alignas(16) float nz[kNumLanes];
+	alignas(16) float d[kNumLanes];
+public:
+	bool intersectsSphere(const float center[3], float radius) const;
+	bool intersectsBox(const float center[3], const float extents[3]) const;
+	// count spheres as separate x/y/z/radius arrays, pVisible[i] = 1 when sphere i is not
+	// completely outside. Returns the number of visible spheres
+	size_t cullSpheres(const float *pX, const float *pY, const float *pZ, const float *pRadius,
+		size_t count, std::uint8_t *pVisible) const;
+};
+
+// radical inverse of index in base, index 0 is skipped by the jitter sequences because it is 0
+float halton(std::uint32_t index, std::uint32_t base);
+// subpixel offset in pixels within [-0.5, 0.5), Halton(2, 3) repeating every sequenceLength frames
+void haltonJitter(size_t frameIndex, size_t sequenceLength, float jitter[2]);
+
+// ReverseZ maps the near plane to depth 1 and the far plane to 0, with a float depth buffer the
+// float exponent then spends its precision on the distance instead of the first meters.
+// ReverseZInfinite drops the far plane from the projection, depth goes to 0 at infinity and the
+// far clip only bounds what the camera still uses it for (shadow distance, the BoundingFrustum)
+enum class DepthMode : std::uint8_t {
+	Standard,
+	ReverseZ,
+	ReverseZInfinite,
+};
+
+// clear value and comparison direction of the depth buffer for a mode
+float getClearDepth(DepthMode mode);
+bool isReverseZ(DepthMode mode);
+
+struct CameraCoreStats {
+	size_t numViewUpdates = 0;
+	size_t numProjUpdates = 0;
+	size_t numViewProjUpdates = 0;
+	size_t numPlaneUpdates = 0;
+};
+
+// Camera matrices, left handed like XMMatrixLookAtLH/XMMatrixPerspectiveFovLH. The setters only
+// store parameters and return without dirtying anything when they did not change, update()
+// recomputes what changed on the thread that owns the camera and the getters only read, so any
+// number of threads may read between two updates. Inverses come from the structure of the
+// matrices: the view is a rigid transform, the projection has five non zero terms. The jitter is
+// a clip space offset on the projection, the unjittered matrices and the frustum planes ignore it
+// so culling and reprojection stay stable
+class CameraCore {
+public:
+	CameraCore();
+	// up does not need to be orthogonal to the view direction
+	void setLookAt(const Math::float3 &eye, const Math::float3 &target, const Math::float3 &up);
+	// fovY in radians
+	void setPerspective(float fovY, float aspect, float zNear, float zFar);
+	void setDepthMode(DepthMode mode);
+	// offset in pixels, the viewport size converts it to clip space
+	void setJitter(float pixelX, float pixelY, float width, float height);
+	void setHaltonJitter(size_t frameIndex, float width, float height, size_t sequenceLength = 8);
+	void clearJitter();
+	// recomputes the matrices and planes of the parameters changed since the last call
+	void update();
+	bool isDirty() const;
+
+	const Math::float4x4 &getView() const;
+	const Math::float4x4 &getInvView() const;
+	const Math::float4x4 &getProj() const;
+	const Math::float4x4 &getInvProj() const;
+	const Math::float4x4 &getViewProj() const;
+	const Math::float4x4 &getInvViewProj() const;
+	const Math::float4x4 &getUnjitteredProj() const;
+	const Math::float4x4 &getUnjitteredViewProj() const;
+	// standard depth from near to far clip without jitter whatever the mode, what
+	// BoundingFrustum::CreateFromMatrix and the shadow fitting expect
+	const Math::float4x4 &getFiniteProj() const;
+	const FrustumPlanesSoA &getFrustumPlanes() const;
+
+	const Math::float3 &getEye() const;
+	// right, up and forward of the view, orthonormal
+	const Math::float3 &getRight() const;
+	const Math::float3 &getUp() const;
+	const Math::float3 &getForward() const;
+	// clip space offset added to x and y
+	const float *getJitter() const;
+	// depth = params[0] + params[1] / viewZ for every mode, so viewZ = params[1] / (depth - params[0])
+	const float *getDepthParams() const;
+	float linearizeDepth(float depth) const;
+	DepthMode getDepthMode() const;
+	float getFovY() const;
+	float getAspect() const;
+	float getNearClip() const;
+	float getFarClip() const;
+	// changes every time a parameter changes, lets users cache what they derive from the matrices
+	std::uint64_t getVersion() const;
+	const CameraCoreStats &getStats() const;
+private:
+	enum DirtyFlag : std::uint32_t {
+		ViewDirty = 1 << 0,
+		ProjDirty = 1 << 1,
+		ViewProjDirty = 1 << 2,
+		PlanesDirty = 1 << 3,
+	};
+	void markDirty(std::uint32_t flags);
+	void updateView();
+	void updateProj();
+	void updateViewProj();
+	void updatePlanes();
+private:
+	Math::float3 _eye;
+	Math::float3 _target;
+	Math::float3 _upHint;
+	float _fovY;
+	float _aspect;
+	float _nearClip;
+	float _farClip;
+	float _jitter[2];
+	DepthMode _depthMode;
+	std::uint64_t _version;
+	std::uint32_t _dirtyFlags;
+	Math::float3 _right;
+	Math::float3 _up;
+	Math::float3 _forward;
+	Math::float4x4 _view;
+	Math::float4x4 _invView;
+	Math::float4x4 _proj;
+	Math::float4x4 _invProj;
+	Math::float4x4 _unjitteredProj;
+	Math::float4x4 _finiteProj;
+	float _depthParams[2];
+	Math::float4x4 _viewProj;
+	Math::float4x4 _invViewProj;
+	Math::float4x4 _unjitteredViewProj;
+	FrustumPlanesSoA _planes;
+	CameraCoreStats _stats;
+};
+
+}
@@ -0,0 +1,293 @@
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <format>
+#include "TestCheck.h"
+#include "D3D/Tool/CameraCore.h"
+#include "D3D/Shadow/CascadeFitting.h"
+
+using namespace d3d;
+using namespace Math;
+
+void cameraCoreTest() {
+	// the product of a matrix and its inverse
+	auto isIdentity = [](const float4x4 &lhs, const float4x4 &rhs) {
+		float4x4 matrix(Matrix4(lhs) * Matrix4(rhs));
+		for (size_t row = 0; row < 4; ++row) {
+			for (size_t col = 0; col < 4; ++col) {
+				if (std::abs(matrix.m[row][col] - (row == col ? 1.f : 0.f)) > 1e-4f)
+					return false;
+			}
+		}
+		return true;
+	};
+	auto project = [](const float3 &point, const float4x4 &matrix, float clip[4]) {
+		for (size_t col = 0; col < 4; ++col)
+			clip[col] = point.x * matrix.m[0][col] + point.y * matrix.m[1][col] + point.z * matrix.m[2][col] + matrix.m[3][col];
+	};
+
+	CameraCore core;
+	const float3 eye(3.f, 2.f, -5.f);
+	const float3 target(0.f, 0.5f, 1.f);
+	const float3 up(0.f, 1.f, 0.f);
+	core.setLookAt(eye, target, up);
+	core.setPerspective(1.0471976f, 16.f / 9.f, 0.1f, 100.f);
+	TEST_CHECK(core.isDirty());
+	core.update();
+	TEST_CHECK(!core.isDirty());
+
+	// the analytic inverses against the products
+	TEST_CHECK(isIdentity(core.getView(), core.getInvView()));
+	TEST_CHECK(isIdentity(core.getProj(), core.getInvProj()));
+	TEST_CHECK(isIdentity(core.getViewProj(), core.getInvViewProj()));
+	{
+		float clip[4];
+		project(eye, core.getView(), clip);
+		TEST_CHECK(std::abs(clip[0]) < 1e-5f && std::abs(clip[1]) < 1e-5f && std::abs(clip[2]) < 1e-5f);
+		// the target is on the view axis, depth goes 0 at the near plane to 1 at the far one
+		project(target, core.getViewProj(), clip);
+		TEST_CHECK(std::abs(clip[0] / clip[3]) < 1e-5f && std::abs(clip[1] / clip[3]) < 1e-5f);
+		TEST_CHECK(clip[2] / clip[3] > 0.f && clip[2] / clip[3] < 1.f);
+		const float3 nearPoint = (Vector3(eye) + Vector3(core.getForward()) * 0.1f).xyz;
+		project(nearPoint, core.getViewProj(), clip);
+		TEST_CHECK(std::abs(clip[2] / clip[3]) < 1e-4f);
+	}
+
+	// update only recomputes what the changed parameters feed
+	CameraCoreStats stats = core.getStats();
+	TEST_CHECK(stats.numViewUpdates == 1 && stats.numProjUpdates == 1 && stats.numViewProjUpdates == 1);
+	std::uint64_t version = core.getVersion();
+	core.setLookAt(eye, target, up);
+	core.setPerspective(1.0471976f, 16.f / 9.f, 0.1f, 100.f);
+	TEST_CHECK(!core.isDirty());
+	core.update();
+	TEST_CHECK(core.getVersion() == version && core.getStats().numViewProjUpdates == 1);
+	const float3 movedEye(3.f, 2.f, -6.f);
+	core.setLookAt(movedEye, target, up);
+	TEST_CHECK(core.getVersion() != version && core.isDirty());
+	core.update();
+	TEST_CHECK(core.getStats().numViewUpdates == 2 && core.getStats().numProjUpdates == 1);
+	TEST_CHECK(core.getStats().numViewProjUpdates == 2 && core.getStats().numPlaneUpdates == 2);
+	TEST_CHECK(isIdentity(core.getViewProj(), core.getInvViewProj()));
+
+	// Halton(2, 3) starting at index 1
+	TEST_CHECK(halton(1, 2) == 0.5f && halton(2, 2) == 0.25f && halton(3, 2) == 0.75f);
+	TEST_CHECK(std::abs(halton(1, 3) - 1.f / 3.f) < 1e-6f && std::abs(halton(2, 3) - 2.f / 3.f) < 1e-6f);
+	{
+		float jitter[2];
+		haltonJitter(8, 8, jitter);
+		TEST_CHECK(jitter[0] == 0.f && std::abs(jitter[1] + 1.f / 6.f) < 1e-6f);
+		float sum[2] = { 0.f, 0.f };
+		for (size_t frame = 0; frame < 16; ++frame) {
+			haltonJitter(frame, 16, jitter);
+			TEST_CHECK(jitter[0] >= -0.5f && jitter[0] < 0.5f && jitter[1] >= -0.5f && jitter[1] < 0.5f);
+			sum[0] += jitter[0];
+			sum[1] += jitter[1];
+		}
+		TEST_CHECK(std::abs(sum[0] / 16.f) < 0.05f && std::abs(sum[1] / 16.f) < 0.05f);
+	}
+
+	// the jitter shifts the projected point by the offset, the unjittered matrices and planes keep still
+	const FrustumPlanesSoA planes = core.getFrustumPlanes();
+	size_t numPlaneUpdates = core.getStats().numPlaneUpdates;
+	float4x4 unjittered = core.getViewProj();
+	core.setHaltonJitter(2, 1920.f, 1080.f);
+	core.update();
+	{
+		float jitter[2];
+		haltonJitter(2, 8, jitter);
+		float clip[4], jitteredClip[4];
+		project(target, unjittered, clip);
+		project(target, core.getViewProj(), jitteredClip);
+		TEST_CHECK(std::abs(jitteredClip[0] / jitteredClip[3] - clip[0] / clip[3] - 2.f * jitter[0] / 1920.f) < 1e-6f);
+		TEST_CHECK(std::abs(jitteredClip[1] / jitteredClip[3] - clip[1] / clip[3] + 2.f * jitter[1] / 1080.f) < 1e-6f);
+		TEST_CHECK(std::memcmp(&core.getUnjitteredViewProj(), &unjittered, sizeof(unjittered)) == 0);
+		TEST_CHECK(isIdentity(core.getProj(), core.getInvProj()));
+		TEST_CHECK(isIdentity(core.getViewProj(), core.getInvViewProj()));
+	}
+	TEST_CHECK(std::memcmp(&core.getFrustumPlanes(), &planes, sizeof(planes)) == 0);
+	TEST_CHECK(core.getStats().numPlaneUpdates == numPlaneUpdates);
+	core.clearJitter();
+	core.update();
+	TEST_CHECK(std::memcmp(&core.getViewProj(), &unjittered, sizeof(unjittered)) == 0);
+
+	// plane tests: the point test from clip space is the reference
+	{
+		const float centerInside[3] = { 0.f, 0.5f, 1.f };
+		const float centerBehind[3] = { 3.f, 2.f, -8.f };
+		const float extents[3] = { 0.5f, 0.5f, 0.5f };
+		TEST_CHECK(planes.intersectsSphere(centerInside, 0.1f) && planes.intersectsBox(centerInside, extents));
+		TEST_CHECK(!planes.intersectsSphere(centerBehind, 1.f) && !planes.intersectsBox(centerBehind, extents));
+		TEST_CHECK(planes.intersectsSphere(centerBehind, 3.f));
+	}
+	std::mt19937 gen(7);
+	std::uniform_real_distribution<float> dist(-60.f, 60.f);
+	constexpr size_t kNumSpheres = 1003;
+	std::vector<float> xs(kNumSpheres), ys(kNumSpheres), zs(kNumSpheres), radii(kNumSpheres);
+	size_t numPointsMismatched = 0;
+	for (size_t i = 0; i < kNumSpheres; ++i) {
+		xs[i] = dist(gen);
+		ys[i] = dist(gen);
+		zs[i] = dist(gen) + 40.f;
+		radii[i] = i % 2 == 0 ? 0.f : std::abs(dist(gen)) * 0.05f;
+		if (radii[i] == 0.f) {
+			const float point[3] = { xs[i], ys[i], zs[i] };
+			float clip[4];
+			project(float3(xs[i], ys[i], zs[i]), core.getViewProj(), clip);
+			bool inside = clip[3] > 0.f && std::abs(clip[0]) <= clip[3] && std::abs(clip[1]) <= clip[3] &&
+				clip[2] >= 0.f && clip[2] <= clip[3];
+			numPointsMismatched += inside != planes.intersectsSphere(point, 0.f);
+		}
+	}
+	TEST_CHECK(numPointsMismatched == 0);
+	std::vector<std::uint8_t> visible(kNumSpheres);
+	size_t numVisible = planes.cullSpheres(xs.data(), ys.data(), zs.data(), radii.data(), kNumSpheres, visible.data());
+	size_t numExpected = 0;
+	for (size_t i = 0; i < kNumSpheres; ++i) {
+		bool inside = true;
+		for (size_t plane = 0; plane < FrustumPlanesSoA::kNumPlanes; ++plane) {
+			if (planes.nx[plane] * xs[i] + planes.ny[plane] * ys[i] + planes.nz[plane] * zs[i] + planes.d[plane] < -radii[i])
+				inside = false;
+		}
+		TEST_CHECK(visible[i] == (inside ? 1 : 0));
+		numExpected += inside;
+	}
+	TEST_CHECK(numVisible == numExpected && numVisible > 0 && numVisible < kNumSpheres);
+	std::cout << std::format("camera core: {} of {} spheres visible", numVisible, kNumSpheres) << std::endl;
+}
+
+void reverseZTest() {
+	// the product of a matrix and its inverse
+	auto isIdentity = [](const float4x4 &lhs, const float4x4 &rhs) {
+		float4x4 matrix(Matrix4(lhs) * Matrix4(rhs));
+		for (size_t row = 0; row < 4; ++row) {
+			for (size_t col = 0; col < 4; ++col) {
+				if (std::abs(matrix.m[row][col] - (row == col ? 1.f : 0.f)) > 1e-4f)
+					return false;
+			}
+		}
+		return true;
+	};
+	// depth the rasterizer stores for a point at view distance z, clip z / w in float like the GPU
+	auto depthAt = [](const float4x4 &proj, float z) {
+		return (proj.m[2][2] * z + proj.m[3][2]) / z;
+	};
+
+	constexpr float kNear = 0.1f;
+	constexpr float kFar = 10000.f;
+	const float3 eye(0.f, 0.f, 0.f);
+	const float3 target(0.f, 0.f, 1.f);
+	const float3 up(0.f, 1.f, 0.f);
+	CameraCore cameras[3];
+	const DepthMode modes[3] = { DepthMode::Standard, DepthMode::ReverseZ, DepthMode::ReverseZInfinite };
+	for (size_t i = 0; i < 3; ++i) {
+		cameras[i].setLookAt(eye, target, up);
+		cameras[i].setPerspective(1.0471976f, 16.f / 9.f, kNear, kFar);
+		cameras[i].setDepthMode(modes[i]);
+		cameras[i].update();
+		TEST_CHECK(isIdentity(cameras[i].getProj(), cameras[i].getInvProj()));
+		TEST_CHECK(isIdentity(cameras[i].getViewProj(), cameras[i].getInvViewProj()));
+		// the finite projection does not follow the mode
+		TEST_CHECK(std::memcmp(&cameras[i].getFiniteProj(), &cameras[0].getProj(), sizeof(float4x4)) == 0);
+	}
+	TEST_CHECK(getClearDepth(DepthMode::Standard) == 1.f && getClearDepth(DepthMode::ReverseZ) == 0.f);
+	TEST_CHECK(!isReverseZ(DepthMode::Standard) && isReverseZ(DepthMode::ReverseZInfinite));
+
+	const float4x4 &standard = cameras[0].getProj();
+	const float4x4 &reversed = cameras[1].getProj();
+	const float4x4 &infinite = cameras[2].getProj();
+	TEST_CHECK(std::abs(depthAt(standard, kNear)) < 1e-6f && std::abs(depthAt(standard, kFar) - 1.f) < 1e-6f);
+	TEST_CHECK(std::abs(depthAt(reversed, kNear) - 1.f) < 1e-6f && std::abs(depthAt(reversed, kFar)) < 1e-6f);
+	TEST_CHECK(std::abs(depthAt(infinite, kNear) - 1.f) < 1e-6f);
+	TEST_CHECK(depthAt(infinite, 1e6f) > 0.f && depthAt(infinite, 1e6f) < 1e-6f);
+	// reversed depth decreases with distance, the infinite one never reaches 0 before infinity
+	for (float z = kNear; z < kFar; z *= 3.f) {
+		TEST_CHECK(depthAt(reversed, z * 3.f) < depthAt(reversed, z));
+		TEST_CHECK(depthAt(infinite, z) > depthAt(reversed, z) - 1e-6f);
+		// standard depth loses the distance in float past the first meters, that is the problem
+		for (const CameraCore &camera : cameras) {
+			if (!isReverseZ(camera.getDepthMode()) && z > 10.f)
+				continue;
+			float depth = depthAt(camera.getProj(), z);
+			TEST_CHECK(std::abs(camera.linearizeDepth(depth) - z) <= z * 1e-3f);
+		}
+	}
+
+	// the far plane of the infinite projection accepts everything, the finite ones cull past it
+	const float distant[3] = { 0.f, 0.f, 50000.f };
+	const float inside[3] = { 0.f, 0.f, 5000.f };
+	TEST_CHECK(!cameras[0].getFrustumPlanes().intersectsSphere(distant, 1.f));
+	TEST_CHECK(!cameras[1].getFrustumPlanes().intersectsSphere(distant, 1.f));
+	TEST_CHECK(cameras[2].getFrustumPlanes().intersectsSphere(distant, 1.f));
+	const float behind[3] = { 0.f, 0.f, -1.f };
+	for (const CameraCore &camera : cameras) {
+		TEST_CHECK(camera.getFrustumPlanes().intersectsSphere(inside, 1.f));
+		TEST_CHECK(!camera.getFrustumPlanes().intersectsSphere(behind, 0.5f));
+		const FrustumPlanesSoA &planes = camera.getFrustumPlanes();
+		TEST_CHECK(std::abs(planes.nz[FrustumPlanesSoA::Near] - 1.f) < 1e-4f);
+		TEST_CHECK(std::abs(planes.d[FrustumPlanesSoA::Near] + kNear) < 1e-4f);
+	}
+
+	// smallest view distance step the depth buffer can still tell apart at z: the next stored depth
+	// value towards the far plane, linearized in double
+	auto floatStep = [&](const CameraCore &camera, float z) {
+		float depth = depthAt(camera.getProj(), z);
+		float next = std::nextafter(depth, isReverseZ(camera.getDepthMode()) ? 0.f : 1.f);
+		const float *pParams = camera.getDepthParams();
+		double nextZ = static_cast<double>(pParams[1]) / (static_cast<double>(next) - pParams[0]);
+		return std::abs(nextZ - static_cast<double>(z));
+	};
+	auto unormStep = [&](const CameraCore &camera, float z, int bits) {
+		double scale = static_cast<double>((1u << bits) - 1);
+		double depth = std::round(static_cast<double>(depthAt(camera.getProj(), z)) * scale);
+		double next = isReverseZ(camera.getDepthMode()) ? depth - 1.0 : depth + 1.0;
+		const float *pParams = camera.getDepthParams();
+		return std::abs(static_cast<double>(pParams[1]) / (next / scale - pParams[0]) - static_cast<double>(z));
+	};
+	std::cout << std::format("[DepthPrecision] near {}, far {}, resolvable distance step at z", kNear, kFar) << std::endl;
+	std::cout << "          z   standard D24   standard F32    reverse F32   reverse inf F32" << std::endl;
+	for (float z : { 1.f, 10.f, 100.f, 1000.f, 5000.f }) {
+		double d24 = unormStep(cameras[0], z, 24);
+		double standardF32 = floatStep(cameras[0], z);
+		double reversedF32 = floatStep(cameras[1], z);
+		double infiniteF32 = floatStep(cameras[2], z);
+		std::cout << std::format("{:>11} {:>14.6g} {:>14.6g} {:>14.6g} {:>17.6g}", z, d24, standardF32, reversedF32, infiniteF32) << std::endl;
+		// a float reversed buffer keeps a roughly constant relative precision
+		TEST_CHECK(reversedF32 < z * 1e-5 && infiniteF32 < z * 1e-5);
+		if (z >= 100.f)
+			TEST_CHECK(reversedF32 * 1000.0 < standardF32 && reversedF32 * 100.0 < d24);
+	}
+	// surfaces one unit apart from 5000 to 5100: standard depth folds them into a handful of values
+	auto countDistinct = [&](const float4x4 &proj) {
+		std::vector<float> depths;
+		for (int i = 0; i <= 100; ++i)
+			depths.push_back(depthAt(proj, 5000.f + static_cast<float>(i)));
+		std::sort(depths.begin(), depths.end());
+		return static_cast<size_t>(std::unique(depths.begin(), depths.end()) - depths.begin());
+	};
+	TEST_CHECK(countDistinct(standard) < 10);
+	TEST_CHECK(countDistinct(reversed) == 101 && countDistinct(infinite) == 101);
+
+	// cascades cover [near, shadow distance], each overlapping the next one a little
+	CascadeSplit splits[4];
+	calcCascadeSplits(kNear, 200.f, 0.7f, 4, splits);
+	TEST_CHECK(splits[0].zNear == kNear && splits[3].zFar == 200.f);
+	for (size_t i = 1; i < 4; ++i) {
+		TEST_CHECK(splits[i].zNear > splits[i - 1].zNear);
+		TEST_CHECK(splits[i - 1].zFar >= splits[i].zNear && splits[i - 1].zFar <= splits[i].zNear * 1.006f);
+	}
+	// lambda 0 is uniform, 1 logarithmic
+	calcCascadeSplits(1.f, 101.f, 0.f, 4, splits, 1.f);
+	TEST_CHECK(std::abs(splits[1].zNear - 26.f) < 1e-3f && std::abs(splits[2].zNear - 51.f) < 1e-3f);
+	calcCascadeSplits(1.f, 10000.f, 1.f, 4, splits, 1.f);
+	TEST_CHECK(std::abs(splits[1].zNear - 10.f) < 1e-3f && std::abs(splits[2].zNear - 100.f) < 1e-2f);
+}
+
+int main() {
+	cameraCoreTest();
+	reverseZTest();
+	return 0;
+}
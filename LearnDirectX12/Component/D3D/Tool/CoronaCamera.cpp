@@ -22,30 +22,6 @@ CoronaCamera::CoronaCamera(const CameraDesc &desc) : CameraBase(desc) {
 	_theta = DirectX::XMConvertToDegrees(std::atan2(direction.z, direction.x));
 }
 
-const float4x4 &CoronaCamera::getView() const {
-	return _view;
-}
-
-const float4x4 &CoronaCamera::getProj() const {
-	return _proj;
-}
-
-const float4x4 &CoronaCamera::getViewProj() const {
-	return _viewProj;
-}
-
-const float4x4 &CoronaCamera::getInvView() const {
-	return _invView;
-}
-
-const float4x4 &CoronaCamera::getInvProj() const {
-	return _invProj;
-}
-
-const float4x4 &CoronaCamera::getInvViewProj() const {
-	return _invViewProj;
-}
-
 void CoronaCamera::update(std::shared_ptr<com::GameTimer> pGameTimer) {
 	float phiRadians = DirectX::XMConvertToRadians(_phi);
 	float thetaRadians = DirectX::XMConvertToRadians(_theta);
@@ -72,23 +48,7 @@ void CoronaCamera::update(std::shared_ptr<com::GameTimer> pGameTimer) {
 	_lookFrom = lookFrom.xyz;
 	_lookUp = lookUp.xyz;
 
-	Matrix4 view = DirectX::XMMatrixLookAtLH(lookFrom, lookAt, lookUp);
-	Matrix4 proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(_fov), _aspect, _nearClip, _farClip);
-	Matrix4 viewProj = proj * view;
-
-	Matrix4 invView = inverse(view);
-	Matrix4 invProj = inverse(proj);
-	Matrix4 invViewProj = inverse(viewProj);
-
-	_view = float4x4(view);
-	_proj = float4x4(proj);
-	_viewProj = float4x4(viewProj);
-	_invView = float4x4(invView);
-	_invProj = float4x4(invProj);
-	_invViewProj = float4x4(invViewProj);
-	_projSpaceFrustum = { proj };
-	_viewSpaceFrustum = _projSpaceFrustum.transform(invView);
-	DEBUG_CLEAR_DIRTY;
+	updateCore();
 }
 
 float CoronaCamera::getPhi() const {
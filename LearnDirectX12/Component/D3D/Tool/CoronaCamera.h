@@ -6,12 +6,6 @@ namespace d3d {
 class CoronaCamera : public CameraBase {
 public:
 	CoronaCamera(const CameraDesc &desc);
-	const Math::float4x4 &getView() const override;
-	const Math::float4x4 &getProj() const override;
-	const Math::float4x4 &getViewProj() const override;
-	const Math::float4x4 &getInvView() const override;
-	const Math::float4x4 &getInvProj() const override;
-	const Math::float4x4 &getInvViewProj() const override;
 	void update(std::shared_ptr<com::GameTimer> pGameTimer) override;
 	float getPhi() const;
 	float getTheta() const;
@@ -27,12 +21,6 @@ private:
 	float			_phi;
 	float			_theta;
 	float			_radius;
-	Math::float4x4	_view;
-	Math::float4x4	_proj;
-	Math::float4x4	_viewProj;
-	Math::float4x4	_invView;
-	Math::float4x4	_invProj;
-	Math::float4x4	_invViewProj;
 	bool			_isMouseLeftPress = false;
 	POINT			_lastMousePosition;
 };
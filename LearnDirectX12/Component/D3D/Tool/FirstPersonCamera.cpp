@@ -31,30 +31,6 @@ FirstPersonCamera::FirstPersonCamera(const CameraDesc &desc) : CameraBase(desc)
 	_roll = DirectX::XMConvertToDegrees(std::asin(upDir.y));
 }
 
-const float4x4 &FirstPersonCamera::getView() const {
-	return _view;
-}
-
-const float4x4 &FirstPersonCamera::getProj() const {
-	return _proj;
-}
-
-const float4x4 &FirstPersonCamera::getViewProj() const {
-	return _viewProj;
-}
-
-const float4x4 &FirstPersonCamera::getInvView() const {
-	return _invView;
-}
-
-const float4x4 &FirstPersonCamera::getInvProj() const {
-	return _invProj;
-}
-
-const float4x4 &FirstPersonCamera::getInvViewProj() const {
-	return _invViewProj;
-}
-
 void FirstPersonCamera::update(std::shared_ptr<com::GameTimer> pGameTimer) {
 	responseEvent(pGameTimer);
 
@@ -82,28 +58,7 @@ void FirstPersonCamera::update(std::shared_ptr<com::GameTimer> pGameTimer) {
 	_lookAt = lookAt.xyz;
 	_lookUp = lookUp.xyz;
 
-	Matrix4 view = DirectX::XMMatrixLookAtLH(lookFrom, lookAt, lookUp);
-	Matrix4 proj = DirectX::XMMatrixPerspectiveFovLH(
-		DirectX::XMConvertToRadians(_fov), 
-		_aspect, 
-		_nearClip, 
-		_farClip
-	);
-	Matrix4 viewProj = proj * view;
-
-	Matrix4 invView = inverse(view);
-	Matrix4 invProj = inverse(proj);
-	Matrix4 invViewProj = inverse(viewProj);
-
-	_view = float4x4(view);
-	_proj = float4x4(proj);
-	_viewProj = float4x4(viewProj);
-	_invView = float4x4(invView);
-	_invProj = float4x4(invProj);
-	_invViewProj = float4x4(invViewProj);
-	_projSpaceFrustum = { proj };
-	_viewSpaceFrustum = _projSpaceFrustum.transform(invView);
-	DEBUG_CLEAR_DIRTY;
+	updateCore();
 }
 
 void FirstPersonCamera::pollEvent(const com::MouseEvent &event) {
@@ -0,0 +1,17 @@
+#include "PathCamera.h"
+
+using namespace Math;
+
+namespace d3d {
+
+void PathCamera::setPose(const float position[3], const float target[3]) {
+	_lookFrom = float3(position[0], position[1], position[2]);
+	_lookAt = float3(target[0], target[1], target[2]);
+	updateCore();
+}
+
+void PathCamera::update(std::shared_ptr<com::GameTimer> pGameTimer) {
+	updateCore();
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <D3D/Tool/Camera.h>
+
+namespace d3d {
+
+// takes its pose from a scripted camera path instead of the input, the headless benchmarks use it
+class PathCamera : public CameraBase {
+public:
+	using CameraBase::CameraBase;
+	void setPose(const float position[3], const float target[3]);
+	void update(std::shared_ptr<com::GameTimer> pGameTimer) override;
+};
+
+}
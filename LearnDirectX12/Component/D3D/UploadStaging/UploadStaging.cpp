@@ -0,0 +1,159 @@
+#include "UploadStaging.h"
+#include <cstring>
+#include <format>
+
+namespace d3d {
+
+std::string UploadStagingStats::toString() const {
+	return std::format("upload staging: {} writes ({} unchanged), {} bytes written, {} bytes changed, {} bytes uploaded in {} ranges",
+		numWrites, numUnchangedWrites, bytesWritten, bytesChanged, bytesUploaded, numRanges);
+}
+
+UploadStaging::UploadStaging(size_t numFrameResources, size_t slotAlignment)
+: _numFrameResources(numFrameResources), _slotAlignment(slotAlignment)
+{
+	assert(numFrameResources > 0 && numFrameResources <= 32);
+	assert(slotAlignment >= kRowSize && (slotAlignment & (slotAlignment - 1)) == 0);
+}
+
+size_t UploadStaging::addSlot(size_t byteSize) {
+	assert(byteSize > 0);
+	Slot slot;
+	slot.offset = (_storage.size() + _slotAlignment - 1) & ~(_slotAlignment - 1);
+	slot.size = byteSize;
+	_storage.resize(slot.offset + byteSize, std::byte{ 0 });
+	_frameShadows.resize(_numFrameResources);
+	for (std::vector<std::byte> &shadow : _frameShadows)
+		shadow.resize(_storage.size(), std::byte{ 0 });
+	_slots.push_back(slot);
+	return _slots.size() - 1;
+}
+
+bool UploadStaging::write(size_t slot, const void *pData, size_t size, size_t offset) {
+	if (slot >= _slots.size() || offset + size > _slots[slot].size) {
+		assert(false);
+		return false;
+	}
+
+	Slot &s = _slots[slot];
+	std::byte *pDst = _storage.data() + s.offset;
+	const auto *pSrc = static_cast<const std::byte *>(pData);
+	++_stats.numWrites;
+	_stats.bytesWritten += size;
+
+	if (!s.written) {
+		std::memcpy(pDst + offset, pSrc, size);
+		s.written = true;
+		_stats.bytesChanged += size;
+		markDirty(slot, 0, s.size);
+		return true;
+	}
+
+	size_t changedBegin = SIZE_MAX;
+	size_t changedEnd = 0;
+	size_t end = offset + size;
+	for (size_t row = offset - offset % kRowSize; row < end; row += kRowSize) {
+		size_t rowBegin = std::max(row, offset);
+		size_t rowEnd = std::min(row + kRowSize, end);
+		if (std::memcmp(pDst + rowBegin, pSrc + (rowBegin - offset), rowEnd - rowBegin) == 0)
+			continue;
+
+		std::memcpy(pDst + rowBegin, pSrc + (rowBegin - offset), rowEnd - rowBegin);
+		changedBegin = std::min(changedBegin, rowBegin);
+		changedEnd = rowEnd;
+		_stats.bytesChanged += rowEnd - rowBegin;
+	}
+
+	if (changedBegin >= changedEnd) {
+		++_stats.numUnchangedWrites;
+		return false;
+	}
+	markDirty(slot, changedBegin, changedEnd);
+	return true;
+}
+
+void UploadStaging::invalidate(size_t slot) {
+	assert(slot < _slots.size());
+	if (_slots[slot].written) {
+		_slots[slot].validShadows = 0;
+		markDirty(slot, 0, _slots[slot].size);
+	}
+}
+
+const std::byte *UploadStaging::getData(size_t slot) const {
+	assert(slot < _slots.size());
+	return _storage.data() + _slots[slot].offset;
+}
+
+size_t UploadStaging::getSlotOffset(size_t slot) const {
+	assert(slot < _slots.size());
+	return _slots[slot].offset;
+}
+
+size_t UploadStaging::getSlotSize(size_t slot) const {
+	assert(slot < _slots.size());
+	return _slots[slot].size;
+}
+
+size_t UploadStaging::getNumSlots() const {
+	return _slots.size();
+}
+
+size_t UploadStaging::getNumDirtySlots() const {
+	return _dirtySlots.size();
+}
+
+size_t UploadStaging::getArenaSize() const {
+	return _storage.size();
+}
+
+const UploadStagingStats &UploadStaging::getLastFrameStats() const {
+	return _lastStats;
+}
+
+void UploadStaging::markDirty(size_t slot, size_t begin, size_t end) {
+	// dirty ranges cover whole rows, the last one stops at the end of the slot
+	Slot &s = _slots[slot];
+	begin -= begin % kRowSize;
+	end = std::min((end + kRowSize - 1) / kRowSize * kRowSize, s.size);
+	if (s.numPendingFlushes == 0) {
+		_dirtySlots.push_back(slot);
+		s.dirtyBegin = begin;
+		s.dirtyEnd = end;
+	} else {
+		s.dirtyBegin = std::min(s.dirtyBegin, begin);
+		s.dirtyEnd = std::max(s.dirtyEnd, end);
+	}
+	s.numPendingFlushes = _numFrameResources;
+}
+
+bool UploadStaging::updateFrameShadow(size_t slot, size_t &begin, size_t &end) {
+	Slot &s = _slots[slot];
+	const std::byte *pStaged = _storage.data() + s.offset;
+	std::byte *pShadow = _frameShadows[_frameResourceIndex].data() + s.offset;
+	std::uint32_t frameBit = 1u << _frameResourceIndex;
+	if ((s.validShadows & frameBit) == 0) {
+		// the copy was never written or was recreated, nothing in it can be trusted
+		s.validShadows |= frameBit;
+		std::memcpy(pShadow, pStaged, s.size);
+		begin = 0;
+		end = s.size;
+		return true;
+	}
+
+	begin = SIZE_MAX;
+	end = 0;
+	for (size_t row = s.dirtyBegin; row < s.dirtyEnd; row += kRowSize) {
+		size_t rowEnd = std::min(row + kRowSize, s.dirtyEnd);
+		if (std::memcmp(pShadow + row, pStaged + row, rowEnd - row) == 0)
+			continue;
+		begin = std::min(begin, row);
+		end = rowEnd;
+	}
+	if (begin >= end)
+		return false;
+	std::memcpy(pShadow + begin, pStaged + begin, end - begin);
+	return true;
+}
+
+}
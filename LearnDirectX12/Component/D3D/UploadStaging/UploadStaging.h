@@ -0,0 +1,122 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace d3d {
+
+struct UploadStagingStats {
+	size_t numWrites = 0;
+	size_t numUnchangedWrites = 0;		// matched the staged bytes, nothing to copy
+	size_t numRanges = 0;				// ranges handed to the flush
+	size_t bytesWritten = 0;			// what the writes passed in, a full rewrite every frame copies this much
+	size_t bytesChanged = 0;			// rows that differed from the staged ones
+	size_t bytesUploaded = 0;			// what the flush handed out
+public:
+	std::string toString() const;
+};
+
+// CPU staging for constant buffers. Every object owns a slot of one contiguous arena; writes compare
+// against the staged bytes in 16 byte rows (a float4 register) and only rows that differ become
+// dirty. Each frame resource has a shadow of what its GPU copy holds, one flush per frame goes to the
+// next frame resource and hands out the rows that differ from that copy's shadow, so a range is never
+// copied into one copy and assumed in the others. Objects that do not write keep their contents and cost nothing
+class UploadStaging {
+public:
+	constexpr static size_t kInvalidSlot = SIZE_MAX;
+	constexpr static size_t kConstantBufferAlignment = 256;
+	constexpr static size_t kRowSize = 16;
+
+	explicit UploadStaging(size_t numFrameResources = 1, size_t slotAlignment = kConstantBufferAlignment);
+	// may move the arena, pointers from getData do not survive it
+	size_t addSlot(size_t byteSize);
+	template<typename T>
+	size_t addSlot() {
+		return addSlot(sizeof(T));
+	}
+
+	// returns true when something changed. The first write of a slot dirties all of it
+	bool write(size_t slot, const void *pData, size_t size, size_t offset = 0);
+	template<typename T>
+	bool write(size_t slot, const T &value) {
+		return write(slot, &value, sizeof(T));
+	}
+
+	// the whole slot is copied again, for a recreated GPU buffer
+	void invalidate(size_t slot);
+
+	// func(size_t slot, size_t offset, size_t size, const std::byte *pData) copies one range into the
+	// current frame resource's buffer, offset is relative to the slot. Ranges come in arena order.
+	// Moves on to the next frame resource and closes the frame's statistics
+	template<typename Func>
+	void flush(Func &&func) {
+		std::sort(_dirtySlots.begin(), _dirtySlots.end());
+		size_t numKept = 0;
+		for (size_t slot : _dirtySlots) {
+			size_t begin = 0;
+			size_t end = 0;
+			if (updateFrameShadow(slot, begin, end)) {
+				func(slot, begin, end - begin, _storage.data() + _slots[slot].offset + begin);
+				++_stats.numRanges;
+				_stats.bytesUploaded += end - begin;
+			}
+			Slot &s = _slots[slot];
+			if (--s.numPendingFlushes > 0) {
+				_dirtySlots[numKept++] = slot;
+			} else {
+				s.dirtyBegin = 0;
+				s.dirtyEnd = 0;
+			}
+		}
+		_dirtySlots.resize(numKept);
+		_frameResourceIndex = (_frameResourceIndex + 1) % _numFrameResources;
+		_lastStats = _stats;
+		_stats = {};
+	}
+
+	const std::byte *getData(size_t slot) const;
+	template<typename T>
+	const T &get(size_t slot) const {
+		static_assert(alignof(T) <= kRowSize);
+		assert(slot < _slots.size() && sizeof(T) <= _slots[slot].size);
+		return *reinterpret_cast<const T *>(getData(slot));
+	}
+
+	// byte offset of the slot in the arena, the layout of a single upload buffer mirroring it
+	size_t getSlotOffset(size_t slot) const;
+	size_t getSlotSize(size_t slot) const;
+	size_t getNumSlots() const;
+	size_t getNumDirtySlots() const;
+	size_t getArenaSize() const;
+	// statistics of the last flushed frame
+	const UploadStagingStats &getLastFrameStats() const;
+private:
+	struct Slot {
+		size_t offset = 0;
+		size_t size = 0;
+		size_t dirtyBegin = 0;						// every frame shadow matches the staged bytes outside of it
+		size_t dirtyEnd = 0;
+		size_t numPendingFlushes = 0;
+		std::uint32_t validShadows = 0;				// bit per frame resource, whose copy holds known bytes
+		bool written = false;
+	};
+
+	void markDirty(size_t slot, size_t begin, size_t end);
+	// the changed rows of the current frame resource's copy, copied into its shadow
+	bool updateFrameShadow(size_t slot, size_t &begin, size_t &end);
+private:
+	size_t _numFrameResources;
+	size_t _slotAlignment;
+	size_t _frameResourceIndex = 0;
+	std::vector<std::byte> _storage;
+	std::vector<std::vector<std::byte>> _frameShadows;		// [frame resource] same layout as _storage
+	std::vector<Slot> _slots;
+	std::vector<size_t> _dirtySlots;
+	UploadStagingStats _stats;
+	UploadStagingStats _lastStats;
+};
+
+}
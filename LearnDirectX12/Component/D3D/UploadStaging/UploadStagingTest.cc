@@ -0,0 +1,141 @@
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include "TestCheck.h"
+#include "D3D/UploadStaging/UploadStaging.h"
+
+using namespace d3d;
+
+void uploadStagingTest() {
+	struct ObjectCB {
+		float world[16];
+		float normal[16];
+		float color[4];
+	};
+	static_assert(sizeof(ObjectCB) == 144);
+
+	struct Range {
+		size_t slot;
+		size_t offset;
+		size_t size;
+	};
+	std::vector<Range> ranges;
+	std::vector<std::byte> gpu;
+	auto flush = [&](d3d::UploadStaging &staging) {
+		ranges.clear();
+		staging.flush([&](size_t slot, size_t offset, size_t size, const std::byte *pData) {
+			ranges.push_back({ slot, offset, size });
+			std::memcpy(gpu.data() + staging.getSlotOffset(slot) + offset, pData, size);
+		});
+	};
+
+	d3d::UploadStaging staging;
+	ObjectCB objects[3] = {};
+	for (size_t i = 0; i < 3; ++i) {
+		for (size_t j = 0; j < 16; ++j)
+			objects[i].world[j] = objects[i].normal[j] = static_cast<float>(i * 100 + j);
+		TEST_CHECK(staging.addSlot<ObjectCB>() == i);
+	}
+	TEST_CHECK(staging.getSlotOffset(1) == 256 && staging.getSlotOffset(2) == 512);
+	TEST_CHECK(staging.getArenaSize() == 512 + sizeof(ObjectCB));
+	gpu.resize(staging.getArenaSize());
+
+	// first frame uploads everything
+	for (size_t i = 0; i < 3; ++i)
+		TEST_CHECK(staging.write(i, objects[i]));
+	flush(staging);
+	TEST_CHECK(ranges.size() == 3 && staging.getLastFrameStats().bytesUploaded == 3 * sizeof(ObjectCB));
+	for (size_t i = 0; i < 3; ++i)
+		TEST_CHECK(std::memcmp(gpu.data() + staging.getSlotOffset(i), &objects[i], sizeof(ObjectCB)) == 0);
+
+	// rewriting unchanged data copies nothing, objects that skip the write keep their contents
+	for (size_t i = 0; i < 3; ++i)
+		TEST_CHECK(!staging.write(i, objects[i]));
+	flush(staging);
+	TEST_CHECK(ranges.empty());
+	const d3d::UploadStagingStats &stats = staging.getLastFrameStats();
+	TEST_CHECK(stats.numWrites == 3 && stats.numUnchangedWrites == 3 && stats.bytesUploaded == 0);
+	TEST_CHECK(stats.bytesWritten == 3 * sizeof(ObjectCB));
+
+	// only the rows that changed: color is the last row of object 1, world[5] is row 1 of object 2
+	objects[1].color[2] = 1.f;
+	objects[2].world[5] = -1.f;
+	staging.write(0, objects[0]);
+	TEST_CHECK(staging.write(2, objects[2]));
+	TEST_CHECK(staging.write(1, objects[1]));
+	flush(staging);
+	TEST_CHECK(ranges.size() == 2);
+	TEST_CHECK(ranges[0].slot == 1 && ranges[0].offset == 128 && ranges[0].size == 16);
+	TEST_CHECK(ranges[1].slot == 2 && ranges[1].offset == 16 && ranges[1].size == 16);
+	TEST_CHECK(staging.getLastFrameStats().bytesUploaded == 32);
+	std::cout << staging.getLastFrameStats().toString() << std::endl;
+	for (size_t i = 0; i < 3; ++i)
+		TEST_CHECK(std::memcmp(gpu.data() + staging.getSlotOffset(i), &objects[i], sizeof(ObjectCB)) == 0);
+	TEST_CHECK(staging.get<ObjectCB>(2).world[5] == -1.f);
+
+	// partial writes and a dirty range spanning rows
+	float row[8] = { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f };
+	TEST_CHECK(staging.write(0, row, sizeof(row), 20));
+	flush(staging);
+	TEST_CHECK(ranges.size() == 1 && ranges[0].offset == 16 && ranges[0].size == 48);
+	TEST_CHECK(staging.get<ObjectCB>(0).world[5] == 1.f && staging.get<ObjectCB>(0).world[12] == 8.f);
+
+	// every frame resource copy gets what differs from its own contents, not what changed last frame
+	d3d::UploadStaging ring(3, 16);
+	size_t slot = ring.addSlot<ObjectCB>();
+	ring.addSlot(8);
+	TEST_CHECK(ring.getSlotOffset(1) == 144);
+	std::vector<std::byte> gpuCopies[3];
+	size_t frame = 0;
+	auto flushRing = [&]() {
+		std::vector<std::byte> &copy = gpuCopies[frame];
+		copy.resize(ring.getArenaSize());
+		ranges.clear();
+		ring.flush([&](size_t slot, size_t offset, size_t size, const std::byte *pData) {
+			ranges.push_back({ slot, offset, size });
+			std::memcpy(copy.data() + ring.getSlotOffset(slot) + offset, pData, size);
+		});
+		TEST_CHECK(std::memcmp(copy.data() + ring.getSlotOffset(slot), ring.getData(slot), sizeof(ObjectCB)) == 0);
+		frame = (frame + 1) % 3;
+	};
+
+	ObjectCB object = {};
+	ring.write(slot, object);
+	for (size_t i = 0; i < 3; ++i) {
+		flushRing();
+		TEST_CHECK(ranges.size() == 1 && ranges[0].offset == 0 && ranges[0].size == sizeof(ObjectCB));
+	}
+	flushRing();
+	TEST_CHECK(ranges.empty() && ring.getNumDirtySlots() == 0);
+
+	// frame 1 gets normal[0], frames 2 and 0 have not seen it when normal[4] changes
+	object.normal[0] = 2.f;
+	ring.write(slot, object);
+	flushRing();
+	TEST_CHECK(ranges.size() == 1 && ranges[0].offset == 64 && ranges[0].size == 16);
+	object.normal[4] = 3.f;
+	ring.write(slot, object);
+	flushRing();
+	TEST_CHECK(ranges.size() == 1 && ranges[0].offset == 64 && ranges[0].size == 32);
+	flushRing();
+	TEST_CHECK(ranges.size() == 1 && ranges[0].offset == 64 && ranges[0].size == 32);
+	flushRing();
+	TEST_CHECK(ranges.size() == 1 && ranges[0].offset == 80 && ranges[0].size == 16);
+	flushRing();
+	TEST_CHECK(ranges.empty() && ring.getNumDirtySlots() == 0);
+
+	// a recreated GPU buffer gets the whole slot again in every copy, never written slots are skipped
+	ring.invalidate(slot);
+	ring.invalidate(1);
+	for (size_t i = 0; i < 3; ++i) {
+		flushRing();
+		TEST_CHECK(ranges.size() == 1 && ranges[0].size == sizeof(ObjectCB));
+	}
+	flushRing();
+	TEST_CHECK(ranges.empty());
+}
+
+int main() {
+	uploadStagingTest();
+	return 0;
+}
@@ -2,6 +2,7 @@
 #define  NOMINMAX
 #include <windows.h>
 #include <cassert>
+#include <cstring>
 #include <d3dcompiler.h>
 #include <format>
 #include "d3dutil.h"
@@ -16,41 +17,108 @@
 
 #include "Model/Mesh/MeshManager.h"
 #include "Shader/D3DShaderResource.h"
+#include "Shader/ShaderCache.h"
+#include <fstream>
+#include <sstream>
 
 namespace d3d {
 
-Microsoft::WRL::ComPtr<ID3DBlob> compileShader(
-	const std::wstring		&fileName, 
-	const D3D_SHADER_MACRO	*defines, 
-	const std::string		&entrypoint, 
-	const std::string		&target) 
-{
+static UINT getDefaultCompileFlags() {
 	UINT compilesFlags = 0;
 #if defined(DEBUG) || defined(_DEBUG) 
 	compilesFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
+	return compilesFlags;
+}
+
+static bool compileWithD3D(const ShaderCompileDesc &desc, std::vector<std::uint8_t> &byteCode, std::string &errorMessage) {
+	std::vector<D3D_SHADER_MACRO> defines;
+	for (const ShaderMacro &macro : desc.macros)
+		defines.push_back({ macro.name.c_str(), macro.definition.c_str() });
+	defines.push_back({ nullptr, nullptr });
 
-	using Microsoft::WRL::ComPtr;
-	HRESULT hr = S_OK;
-	ComPtr<ID3DBlob> byteCode;
-	ComPtr<ID3DBlob> errors;
-	hr = D3DCompileFromFile(
-		fileName.c_str(),
-		defines,
+	WRL::ComPtr<ID3DBlob> pByteCode;
+	WRL::ComPtr<ID3DBlob> errors;
+	HRESULT hr = D3DCompile(desc.source.data(),
+		desc.source.size(),
+		desc.fileName.empty() ? nullptr : desc.fileName.c_str(),
+		defines.data(),
 		D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		entrypoint.c_str(),
-		target.c_str(),
-		compilesFlags,
+		desc.entryPoint.c_str(),
+		desc.target.c_str(),
+		desc.flags,
 		0,
-		&byteCode,
+		&pByteCode,
 		&errors
 	);
 
 	if (FAILED(hr)) {
-		OutputDebugString(static_cast<char *>(errors->GetBufferPointer()));
-		ThrowIfFailed(hr);
+		if (errors != nullptr)
+			errorMessage.assign(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize());
+		else
+			errorMessage = std::format("{}: D3DCompile failed {:x}\n", desc.fileName, static_cast<std::uint32_t>(hr));
+		return false;
 	}
-	return byteCode;
+
+	const auto *pBegin = static_cast<const std::uint8_t *>(pByteCode->GetBufferPointer());
+	byteCode.assign(pBegin, pBegin + pByteCode->GetBufferSize());
+	return true;
+}
+
+static WRL::ComPtr<ID3DBlob> compileShader(const ShaderCompileDesc &desc) {
+	ShaderByteCode pByteCode;
+	std::string errors;
+	if (ShaderCache *pShaderCache = ShaderCache::instance(); pShaderCache != nullptr) {
+		pByteCode = pShaderCache->compile(desc, &errors);
+	} else {
+		std::vector<std::uint8_t> byteCode;
+		if (compileWithD3D(desc, byteCode, errors))
+			pByteCode = std::make_shared<const std::vector<std::uint8_t>>(std::move(byteCode));
+	}
+
+	if (pByteCode == nullptr) {
+		OutputDebugString(errors.c_str());
+		ThrowIfFailed(E_FAIL);
+	}
+
+	WRL::ComPtr<ID3DBlob> pBlob;
+	ThrowIfFailed(D3DCreateBlob(pByteCode->size(), &pBlob));
+	std::memcpy(pBlob->GetBufferPointer(), pByteCode->data(), pByteCode->size());
+	return pBlob;
+}
+
+static ShaderCompileDesc makeCompileDesc(const D3D_SHADER_MACRO *defines, const std::string &entrypoint, const std::string &target) {
+	ShaderCompileDesc desc;
+	for (const D3D_SHADER_MACRO *pMacro = defines; pMacro != nullptr && pMacro->Name != nullptr; ++pMacro) {
+		ShaderMacro macro;
+		macro.name = pMacro->Name;
+		if (pMacro->Definition != nullptr)
+			macro.definition = pMacro->Definition;
+		desc.macros.push_back(std::move(macro));
+	}
+	desc.entryPoint = entrypoint;
+	desc.target = target;
+	desc.flags = getDefaultCompileFlags();
+	return desc;
+}
+
+Microsoft::WRL::ComPtr<ID3DBlob> compileShader(
+	const std::wstring		&fileName, 
+	const D3D_SHADER_MACRO	*defines, 
+	const std::string		&entrypoint, 
+	const std::string		&target) 
+{
+	ShaderCompileDesc desc = makeCompileDesc(defines, entrypoint, target);
+	desc.fileName = std::to_string(fileName);
+	std::ifstream input(fileName, std::ios::binary);
+	if (!input.is_open()) {
+		OutputDebugString(std::format("can't open shader file {}\n", desc.fileName).c_str());
+		ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND));
+	}
+	std::stringstream buffer;
+	buffer << input.rdbuf();
+	desc.source = buffer.str();
+	return compileShader(desc);
 }
 
 
@@ -60,31 +128,9 @@ WRL::ComPtr<ID3DBlob> compileShader(const char *fileContext,
 	const std::string &entrypoint, 
 	const std::string &target) 
 {
-	UINT compilesFlags = 0;
-#if defined(DEBUG) || defined(_DEBUG) 
-	compilesFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-	HRESULT hr = S_OK;
-	WRL::ComPtr<ID3DBlob> byteCode;
-	WRL::ComPtr<ID3DBlob> errors;
-	hr = D3DCompile(fileContext,
-		sizeInByte,
-		nullptr,
-		defines,
-		D3D_COMPILE_STANDARD_FILE_INCLUDE,
-		entrypoint.c_str(),
-		target.c_str(),
-		compilesFlags,
-		0,
-		&byteCode,
-		&errors
-	);
-
-	if (FAILED(hr)) {
-		OutputDebugString(static_cast<char *>(errors->GetBufferPointer()));
-		ThrowIfFailed(hr);
-	}
-	return byteCode;
+	ShaderCompileDesc desc = makeCompileDesc(defines, entrypoint, target);
+	desc.source.assign(fileContext, sizeInByte);
+	return compileShader(desc);
 }
 
 WRL::ComPtr<ID3DBlob> compileShaderParseInclude(const char *pFileName, const char *fileContext, std::size_t sizeInByte,
@@ -115,116 +161,34 @@ std::string calcMacroKey(const std::string &name, const std::vector<D3D_SHADER_M
 }
 
 std::string calcMacroKey(const std::string &name, const D3D_SHADER_MACRO *pMacros, size_t size) {
-	std::map<std::string, std::string> macros;
-	for (size_t i = 0; i < size; ++i) {
-#if defined(_DEBUG) || defined(DEBUG)
-		auto iter = macros.find(pMacros[i].Definition);
-		assert(iter == macros.end());
-#endif
-		if (pMacros[i].Name != nullptr)
-			macros[pMacros[i].Definition] = pMacros[i].Name;
-		else
-			macros[pMacros[i].Definition] = std::string();
+	std::vector<std::pair<std::string_view, std::string_view>> macros;
+	macros.reserve(size);
+	// arrays passed to D3DCompile end with { nullptr, nullptr }
+	for (size_t i = 0; i < size && pMacros[i].Name != nullptr; ++i) {
+		std::string_view definition = pMacros[i].Definition != nullptr ? pMacros[i].Definition : "";
+		macros.emplace_back(pMacros[i].Name, definition);
 	}
-
-	std::string result = name;
-	for (auto &&[key, value] : macros) {
-		if (value.empty())
-			result += std::format("_[{}]", key);
-		else
-			result += std::format("_[{},{}]", key, value);
-	}
-	return result;
+	return buildMacroKeyString(name, macros);
 }
 
-
-struct SplitMacroKeyHelper {
-	bool handleName(const std::string &key) {
-		if (index == key.length()) {
-			name = key;
-			return false;
-		}
-
-		if (key[index] == '_') {
-			name = key.substr(0, index);
-			pTickFun = &SplitMacroKeyHelper::findMacroBegin;
-			position = index + 1;
-		}
-		return true;
-	}
-
-	//  _ ҵ [
-	bool findMacroBegin(const std::string &key) {
-		if (index == key.length())
-			return false;
-		
-		if (key[index] == '[') {
-			position = index + 1;
-			pTickFun = &SplitMacroKeyHelper::handleMacroKey;
-		}
-		assert(key[index] == '_' || key[index] == '[');
-		return true;
-	}
-
-	bool handleMacroKey(const std::string &key) {
-		assert(index < key.length());
-		if (key[index] == ',') {
-			macros.push_back(key.substr(position, index - position));
-			position = index + 1;
-			pTickFun = &SplitMacroKeyHelper::handleMacroValue;
-		}
-		if (key[index] == ']') {
-			macros.push_back(key.substr(position, index - position));
-			macros.push_back("");
-			position = index + 1;
-			pTickFun = &SplitMacroKeyHelper::findMacroBegin;
-		}
-		return true;
-	}
-
-	bool handleMacroValue(const std::string &key) {
-		if (index == key.length()) {
-			assert(false && "The macro key is not complete");
-			return false;
-		}
-
-		if (key[index] == ']') {
-			macros.push_back(key.substr(position, index-position));
-			position = index + 1;
-			pTickFun = &SplitMacroKeyHelper::findMacroBegin;
-		}
-		return true;
-	}
-
-	void parse(const std::string &key) {
-		while ((this->*pTickFun)(key))
-			++index;
-	}
-
-public:
-	bool (SplitMacroKeyHelper:: *pTickFun)(const std::string &key) = &SplitMacroKeyHelper::handleName;
-	size_t position = 0;
-	size_t index = 0;
-	std::string name;
-	std::vector<std::string> macros;
-};
-
 void splitMacroKey(const std::string &key, std::string &name, std::vector<MacroPair> &macros) {
 	if (key.empty())
 		return;
 
+	std::string_view nameView;
+	std::vector<std::pair<std::string_view, std::string_view>> macroViews;
+	if (!parseMacroKeyString(key, nameView, macroViews)) {
+		assert(false && "The macro key is not complete");
+		return;
+	}
 
-	SplitMacroKeyHelper helper;
-	helper.parse(key);
-	name = std::move(helper.name);
+	name = nameView;
+	for (auto &&[macro, value] : macroViews)
+		macros.push_back({ std::string(macro), std::string(value) });
+}
 
-	for (size_t i = 0; i < helper.macros.size(); i += 2) {
-		MacroPair pair = {
-			std::move(helper.macros[i+0]),
-			std::move(helper.macros[i+1]),
-		};
-		macros.push_back(std::move(pair));
-	}
+ShaderPermutationKey calcPermutationKey(const std::string &name, const D3D_SHADER_MACRO *pMacros, size_t size) {
+	return ShaderMacroTable::instance()->makeKey(name, pMacros, size);
 }
 
 D3DInitializer::D3DInitializer() {
@@ -236,6 +200,9 @@ D3DInitializer::D3DInitializer() {
 	
 	TextureManager::emplace();
 	MeshManager::emplace();
+	ShaderMacroTable::emplace();
+	ShaderCache::emplace(&compileWithD3D);
+	ShaderCache::instance()->addIncludeDirectory(D3D_HLSL_SHADER_PATH);
 }
 
 D3DInitializer::~D3DInitializer() {
@@ -245,12 +212,35 @@ D3DInitializer::~D3DInitializer() {
 		std::abort();
 	}
 
+	ShaderCache::destroy();
+	ShaderMacroTable::destroy();
 	MeshManager::destroy();
 	TextureManager::destroy();
 }
 
 void D3DInitializer::loading(dx12lib::DirectContextProxy pDirectCtx) {
 	TextureManager::initDefaultTexture(pDirectCtx);
+
+	// warm the shader cache, later compileShader calls for these are memory hits
+	cmrc::file shaderDefine = getD3DResource("config/ShaderDefine.lua");
+	std::string shaderListText(shaderDefine.begin(), shaderDefine.end());
+	std::vector<ShaderCompileDesc> descs;
+	for (const ShaderListEntry &entry : ShaderCache::parseShaderList(shaderListText)) {
+		std::string fileName = std::string(D3D_HLSL_SHADER_PATH "/../") + entry.file;
+		std::ifstream input(fileName, std::ios::binary);
+		if (!input.is_open())
+			continue;
+
+		std::stringstream buffer;
+		buffer << input.rdbuf();
+		for (auto &&[entryPoint, target] : entry.stages) {
+			ShaderCompileDesc desc = makeCompileDesc(nullptr, entryPoint, target);
+			desc.fileName = fileName;
+			desc.source = buffer.str();
+			descs.push_back(std::move(desc));
+		}
+	}
+	ShaderCache::instance()->compileBatch(descs);
 }
 
 }
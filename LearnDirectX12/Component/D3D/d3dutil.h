@@ -6,6 +6,7 @@
 #include <DirectXMath.h>
 #include <iterator>
 #include "ComponentStd.h"
+#include "D3D/Shader/ShaderPermutation.h"
 #include <Dx12lib/Common/Common.h>
 #include <Dx12lib/Context/ContextStd.h>
 
@@ -73,11 +74,6 @@ public:
 	virtual ~NonCopyable() = default;
 };
 
-struct MacroPair {
-	std::string key;
-	std::string value;
-};
-
 std::string calcMacroKey(const std::string &name, const std::vector<D3D_SHADER_MACRO> &macros);
 std::string calcMacroKey(const std::string &name, const D3D_SHADER_MACRO *pMacros, size_t size);
 
@@ -88,6 +84,14 @@ std::string calcMacroKey(const std::string &name, const D3D_SHADER_MACRO(&pMacro
 
 void splitMacroKey(const std::string &key, std::string &name, std::vector<MacroPair> &macros);
 
+// interned form of calcMacroKey, cheap to hash and compare, see ShaderMacroTable::toString
+ShaderPermutationKey calcPermutationKey(const std::string &name, const D3D_SHADER_MACRO *pMacros, size_t size);
+
+template<size_t N>
+ShaderPermutationKey calcPermutationKey(const std::string &name, const D3D_SHADER_MACRO(&pMacros)[N]) {
+	return calcPermutationKey(name, pMacros, N);
+}
+
 class D3DInitializer {
 	static inline std::atomic_bool isInited{ false };
 public:
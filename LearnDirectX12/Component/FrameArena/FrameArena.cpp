@@ -0,0 +1,251 @@
+#include "FrameArena.h"
+#include <cassert>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace com {
+
+std::string FrameArenaStats::toString() const {
+	return std::format("frame {}: {} allocations, {:.1f} KB, {} upstream allocations, {:.1f} KB reserved, {} threads",
+		frameIndex,
+		numAllocations,
+		static_cast<double>(numBytes) / 1024.0,
+		numUpstreamAllocations,
+		static_cast<double>(numBytesReserved) / 1024.0,
+		numThreads
+	);
+}
+
+struct FrameArenaRegistry {
+	struct Entry {
+		FrameArena arena;
+		bool inUse = false;
+		// counters at the last endFrame
+		size_t numAllocations = 0;
+		size_t numBytes = 0;
+		size_t numUpstreamAllocations = 0;
+	};
+public:
+	FrameArena *acquire() {
+		std::lock_guard lock(mutex);
+		for (auto &pEntry : entries) {
+			if (!pEntry->inUse) {
+				pEntry->inUse = true;
+				pEntry->arena._manualReset = false;
+				return &pEntry->arena;
+			}
+		}
+		entries.push_back(std::make_unique<Entry>());
+		entries.back()->inUse = true;
+		entries.back()->arena._frameIndex = frameIndex.load(std::memory_order_relaxed);
+		return &entries.back()->arena;
+	}
+
+	void release(FrameArena *pArena) {
+		std::lock_guard lock(mutex);
+		for (auto &pEntry : entries) {
+			if (&pEntry->arena == pArena)
+				pEntry->inUse = false;
+		}
+	}
+
+	FrameArenaStats collect() {
+		std::lock_guard lock(mutex);
+		FrameArenaStats stats;
+		stats.frameIndex = frameIndex.load(std::memory_order_relaxed);
+		for (auto &pEntry : entries) {
+			const FrameArena &arena = pEntry->arena;
+			size_t numAllocations = arena.getNumAllocations();
+			size_t numBytes = arena.getNumBytes();
+			size_t numUpstreamAllocations = arena.getNumUpstreamAllocations();
+			if (numAllocations != pEntry->numAllocations)
+				++stats.numThreads;
+			stats.numAllocations += numAllocations - pEntry->numAllocations;
+			stats.numBytes += numBytes - pEntry->numBytes;
+			stats.numUpstreamAllocations += numUpstreamAllocations - pEntry->numUpstreamAllocations;
+			stats.numBytesReserved += arena.getNumBytesReserved();
+			pEntry->numAllocations = numAllocations;
+			pEntry->numBytes = numBytes;
+			pEntry->numUpstreamAllocations = numUpstreamAllocations;
+		}
+		lastStats = stats;
+		return stats;
+	}
+
+	static FrameArenaRegistry &instance() {
+		static FrameArenaRegistry registry;
+		return registry;
+	}
+public:
+	std::mutex mutex;
+	std::vector<std::unique_ptr<Entry>> entries;
+	FrameArenaStats lastStats;
+	std::atomic<size_t> frameIndex = 0;
+};
+
+// hands the arena back to the registry when the thread exits, the next new thread reuses it
+struct FrameArenaThreadSlot {
+	FrameArena *pArena = nullptr;
+public:
+	~FrameArenaThreadSlot() {
+		if (pArena != nullptr)
+			FrameArenaRegistry::instance().release(pArena);
+	}
+};
+
+static thread_local FrameArenaThreadSlot sFrameArenaThreadSlot;
+
+FrameArena::FrameArena(size_t chunkSize, std::pmr::memory_resource *pUpstream)
+: _chunkSize(chunkSize), _pUpstream(pUpstream)
+{
+	assert(chunkSize > sizeof(Chunk));
+	assert(pUpstream != nullptr);
+}
+
+FrameArena::~FrameArena() {
+	releaseChunks();
+}
+
+void FrameArena::reset() {
+	if (_pChunks == nullptr)
+		return;
+
+	if (_pChunks->pNext != nullptr) {
+		// merge: the next frame starts with one chunk as big as everything this one took
+		size_t totalSize = 0;
+		for (Chunk *pChunk = _pChunks; pChunk != nullptr; pChunk = pChunk->pNext)
+			totalSize += pChunk->size;
+		releaseChunks();
+		_chunkSize = std::max(_chunkSize, totalSize);
+		return;
+	}
+	_pCursor = reinterpret_cast<std::byte *>(_pChunks + 1);
+	_bytesUsedInFullChunks = 0;
+}
+
+void FrameArena::setManualReset(bool manualReset) {
+	_manualReset = manualReset;
+}
+
+bool FrameArena::isManualReset() const {
+	return _manualReset;
+}
+
+size_t FrameArena::getNumAllocations() const {
+	return _numAllocations.load(std::memory_order_relaxed);
+}
+
+size_t FrameArena::getNumBytes() const {
+	return _numBytes.load(std::memory_order_relaxed);
+}
+
+size_t FrameArena::getNumUpstreamAllocations() const {
+	return _numUpstreamAllocations.load(std::memory_order_relaxed);
+}
+
+size_t FrameArena::getNumBytesReserved() const {
+	return _numBytesReserved.load(std::memory_order_relaxed);
+}
+
+size_t FrameArena::getNumBytesUsed() const {
+	if (_pChunks == nullptr)
+		return 0;
+	return _bytesUsedInFullChunks + static_cast<size_t>(_pCursor - reinterpret_cast<std::byte *>(_pChunks + 1));
+}
+
+FrameArena *FrameArena::get() {
+	FrameArena *pArena = sFrameArenaThreadSlot.pArena;
+	if (pArena == nullptr) {
+		pArena = FrameArenaRegistry::instance().acquire();
+		sFrameArenaThreadSlot.pArena = pArena;
+	}
+
+	// acquire pairs with endFrame, the readers of the last frame are done before the memory is reused
+	size_t frameIndex = FrameArenaRegistry::instance().frameIndex.load(std::memory_order_acquire);
+	if (!pArena->_manualReset && pArena->_frameIndex != frameIndex) {
+		pArena->reset();
+		pArena->_frameIndex = frameIndex;
+	}
+	return pArena;
+}
+
+void FrameArena::endFrame() {
+	FrameArenaRegistry &registry = FrameArenaRegistry::instance();
+	registry.collect();
+	registry.frameIndex.fetch_add(1, std::memory_order_release);
+	get();
+}
+
+size_t FrameArena::getFrameIndex() {
+	return FrameArenaRegistry::instance().frameIndex.load(std::memory_order_relaxed);
+}
+
+FrameArenaStats FrameArena::getLastFrameStats() {
+	FrameArenaRegistry &registry = FrameArenaRegistry::instance();
+	std::lock_guard lock(registry.mutex);
+	return registry.lastStats;
+}
+
+void *FrameArena::do_allocate(size_t bytes, size_t alignment) {
+	auto alignUp = [=](std::byte *ptr) {
+		auto address = reinterpret_cast<std::uintptr_t>(ptr);
+		return (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+	};
+
+	std::uintptr_t address = alignUp(_pCursor);
+	if (_pCursor == nullptr || address + bytes > reinterpret_cast<std::uintptr_t>(_pEnd)) {
+		allocateChunk(bytes + alignment);
+		address = alignUp(_pCursor);
+	}
+
+	std::byte *ptr = _pCursor + (address - reinterpret_cast<std::uintptr_t>(_pCursor));
+	_pCursor = ptr + bytes;
+	increase(_numAllocations, 1);
+	increase(_numBytes, bytes);
+	return ptr;
+}
+
+void FrameArena::do_deallocate(void *p, size_t bytes, size_t alignment) {
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+	return this == &other;
+}
+
+void FrameArena::allocateChunk(size_t minBytes) {
+	if (_pChunks != nullptr)
+		_bytesUsedInFullChunks += static_cast<size_t>(_pCursor - reinterpret_cast<std::byte *>(_pChunks + 1));
+
+	size_t size = std::max(_chunkSize, minBytes + sizeof(Chunk));
+	auto *pChunk = static_cast<Chunk *>(_pUpstream->allocate(size, alignof(std::max_align_t)));
+	pChunk->pNext = _pChunks;
+	pChunk->size = size;
+	_pChunks = pChunk;
+	_pCursor = reinterpret_cast<std::byte *>(pChunk + 1);
+	_pEnd = reinterpret_cast<std::byte *>(pChunk) + size;
+	increase(_numUpstreamAllocations, 1);
+	increase(_numBytesReserved, size);
+}
+
+void FrameArena::releaseChunks() {
+	while (_pChunks != nullptr) {
+		Chunk *pNext = _pChunks->pNext;
+		_pUpstream->deallocate(_pChunks, _pChunks->size, alignof(std::max_align_t));
+		_pChunks = pNext;
+	}
+	_pCursor = nullptr;
+	_pEnd = nullptr;
+	_bytesUsedInFullChunks = 0;
+	_numBytesReserved.store(0, std::memory_order_relaxed);
+}
+
+void FrameArena::increase(std::atomic<size_t> &counter, size_t value) {
+	// only the owner writes, a plain load and store is enough and avoids the locked add
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <memory_resource>
+
+namespace com {
+
+// allocations served by the arenas between two FrameArena::endFrame calls, summed over all threads
+struct FrameArenaStats {
+	size_t frameIndex = 0;
+	size_t numAllocations = 0;
+	size_t numBytes = 0;
+	size_t numUpstreamAllocations = 0;		// chunks taken from the heap, 0 once the arenas are warm
+	size_t numBytesReserved = 0;			// chunk memory held by all arenas at the end of the frame
+	size_t numThreads = 0;					// arenas that allocated this frame
+public:
+	std::string toString() const;
+};
+
+// Bump allocator for memory that dies with the frame. deallocate does nothing and reset rewinds
+// to the first chunk; a frame that needed several chunks gets them merged into one on reset, so a
+// steady frame takes nothing from the upstream resource.
+// get() is the arena of the calling thread. The main thread rewinds its arena in endFrame, other
+// threads rewind theirs on the first get() after it, unless they set manual reset and call reset
+// at their own frame boundary, like the render thread of the frame pipeline
+class FrameArena : public std::pmr::memory_resource {
+public:
+	constexpr static size_t kDefaultChunkSize = 64 * 1024;
+
+	explicit FrameArena(size_t chunkSize = kDefaultChunkSize, std::pmr::memory_resource *pUpstream = std::pmr::new_delete_resource());
+	~FrameArena() override;
+	FrameArena(const FrameArena &) = delete;
+	FrameArena &operator=(const FrameArena &) = delete;
+
+	void reset();
+	void setManualReset(bool manualReset);
+	bool isManualReset() const;
+	// since construction, endFrame reports the per frame difference
+	size_t getNumAllocations() const;
+	size_t getNumBytes() const;
+	size_t getNumUpstreamAllocations() const;
+	size_t getNumBytesReserved() const;
+	size_t getNumBytesUsed() const;
+
+	static FrameArena *get();
+	// frame boundary of the main thread, nothing may hold frame memory of the ending frame
+	static void endFrame();
+	static size_t getFrameIndex();
+	static FrameArenaStats getLastFrameStats();
+protected:
+	void *do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+private:
+	struct Chunk {
+		Chunk *pNext;
+		size_t size;			// with the header
+	};
+
+	void allocateChunk(size_t minBytes);
+	void releaseChunks();
+	static void increase(std::atomic<size_t> &counter, size_t value);
+private:
+	friend struct FrameArenaRegistry;
+	size_t _chunkSize;
+	std::pmr::memory_resource *_pUpstream;
+	Chunk *_pChunks = nullptr;				// newest first
+	std::byte *_pCursor = nullptr;
+	std::byte *_pEnd = nullptr;
+	size_t _bytesUsedInFullChunks = 0;
+	bool _manualReset = false;
+	size_t _frameIndex = 0;					// the frame of the last lazy reset, thread arenas only
+	// written by the owner thread only, endFrame reads them from the main thread
+	std::atomic<size_t> _numAllocations = 0;
+	std::atomic<size_t> _numBytes = 0;
+	std::atomic<size_t> _numUpstreamAllocations = 0;
+	std::atomic<size_t> _numBytesReserved = 0;
+};
+
+}
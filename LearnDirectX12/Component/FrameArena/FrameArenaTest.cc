@@ -0,0 +1,217 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <vector>
+#include <memory_resource>
+#include "FrameArena.h"
+
+using namespace com;
+
+// counts every global heap allocation, to compare the vector returning paths with the arena ones
+static std::atomic<size_t> sNumHeapAllocations = 0;
+
+void *operator new(size_t size) {
+	sNumHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *ptr = std::malloc(size == 0 ? 1 : size))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+	size_t numAllocations = 0;
+	size_t numLiveBytes = 0;
+protected:
+	void *do_allocate(size_t bytes, size_t alignment) override {
+		++numAllocations;
+		numLiveBytes += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+		numLiveBytes -= bytes;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+		return this == &other;
+	}
+};
+
+void bumpTest() {
+	CountingResource upstream;
+	{
+		FrameArena arena(1024, &upstream);
+		void *p0 = arena.allocate(3, 1);
+		void *p1 = arena.allocate(16, 16);
+		void *p2 = arena.allocate(8, 64);
+		assert(reinterpret_cast<std::uintptr_t>(p1) % 16 == 0);
+		assert(reinterpret_cast<std::uintptr_t>(p2) % 64 == 0);
+		assert(static_cast<std::byte *>(p1) >= static_cast<std::byte *>(p0) + 3);
+		assert(upstream.numAllocations == 1 && arena.getNumAllocations() == 3 && arena.getNumBytes() == 27);
+		arena.deallocate(p1, 16, 16);
+
+		// rewinds to the same memory
+		arena.reset();
+		assert(arena.getNumBytesUsed() == 0);
+		assert(arena.allocate(3, 1) == p0);
+
+		// overflow takes more chunks, the reset merges them into one
+		for (size_t i = 0; i < 8; ++i)
+			static_cast<void>(arena.allocate(512, 8));
+		void *pLarge = arena.allocate(4096, 8);
+		assert(pLarge != nullptr && upstream.numAllocations > 2);
+		assert(arena.getNumBytesUsed() >= 8 * 512 + 4096);
+		size_t reserved = arena.getNumBytesReserved();
+		arena.reset();
+		assert(arena.getNumBytesReserved() == 0);
+
+		size_t numUpstream = upstream.numAllocations;
+		for (size_t frame = 0; frame < 4; ++frame) {
+			for (size_t i = 0; i < 8; ++i)
+				static_cast<void>(arena.allocate(512, 8));
+			static_cast<void>(arena.allocate(4096, 8));
+			assert(arena.getNumBytesReserved() >= reserved);
+			arena.reset();
+		}
+		assert(upstream.numAllocations == numUpstream + 1);
+	}
+	assert(upstream.numLiveBytes == 0);
+}
+
+void pmrContainerTest() {
+	CountingResource upstream;
+	FrameArena arena(4096, &upstream);
+	size_t firstFrameAllocations = 0;
+	for (size_t frame = 0; frame < 3; ++frame) {
+		{
+			std::pmr::vector<std::pmr::vector<int>> lists(&arena);
+			lists.resize(8);
+			for (size_t i = 0; i < lists.size(); ++i) {
+				assert(lists[i].get_allocator().resource() == &arena);
+				for (int j = 0; j < 100; ++j)
+					lists[i].push_back(j);
+			}
+			assert(lists[7][99] == 99);
+		}
+		if (frame == 0)
+			firstFrameAllocations = upstream.numAllocations;
+		arena.reset();
+	}
+	// the first frame needed several chunks, the merged one covers the later frames
+	assert(firstFrameAllocations > 1 && upstream.numAllocations == firstFrameAllocations + 1);
+}
+
+void threadArenaTest() {
+	FrameArena::endFrame();
+	FrameArena *pMain = FrameArena::get();
+	assert(pMain == FrameArena::get());
+	void *pFirst = pMain->allocate(64, 16);
+
+	FrameArena *pWorker = nullptr;
+	std::thread worker([&]() {
+		pWorker = FrameArena::get();
+		std::pmr::vector<float> values(FrameArena::get());
+		values.resize(100);
+	});
+	worker.join();
+	assert(pWorker != nullptr && pWorker != pMain);
+
+	size_t frameIndex = FrameArena::getFrameIndex();
+	FrameArena::endFrame();
+	FrameArenaStats stats = FrameArena::getLastFrameStats();
+	std::cout << stats.toString() << std::endl;
+	assert(stats.frameIndex == frameIndex && FrameArena::getFrameIndex() == frameIndex + 1);
+	assert(stats.numAllocations == 2 && stats.numThreads == 2);
+	assert(stats.numBytes == 64 + 100 * sizeof(float));
+
+	// the main arena rewound at the boundary, an exited thread's arena goes to the next thread
+	assert(pMain->allocate(64, 16) == pFirst);
+	FrameArena *pReused = nullptr;
+	std::thread next([&]() { pReused = FrameArena::get(); });
+	next.join();
+	assert(pReused == pWorker);
+
+	FrameArena::endFrame();
+	stats = FrameArena::getLastFrameStats();
+	assert(stats.numAllocations == 1 && stats.numThreads == 1 && stats.numUpstreamAllocations == 0);
+
+	// manual arenas keep their memory over the boundary until their thread resets them
+	pMain->setManualReset(true);
+	void *pKept = pMain->allocate(16, 16);
+	FrameArena::endFrame();
+	assert(pMain->allocate(16, 16) != pKept);
+	pMain->reset();
+	pMain->setManualReset(false);
+	FrameArena::endFrame();
+}
+
+static std::vector<int> visibleByValue(const std::vector<int> &items) {
+	std::vector<int> result;
+	for (int item : items) {
+		if (item % 3 != 0)
+			result.push_back(item);
+	}
+	return result;
+}
+
+static void visibleInto(const std::vector<int> &items, std::pmr::vector<int> &result) {
+	result.clear();
+	for (int item : items) {
+		if (item % 3 != 0)
+			result.push_back(item);
+	}
+}
+
+void allocationCountTest() {
+	std::vector<int> items(1000);
+	for (size_t i = 0; i < items.size(); ++i)
+		items[i] = static_cast<int>(i);
+
+	constexpr size_t kNumFrames = 16;
+	size_t before = sNumHeapAllocations.load();
+	size_t checksum = 0;
+	for (size_t frame = 0; frame < kNumFrames; ++frame)
+		checksum += visibleByValue(items).size();
+	size_t vectorAllocations = sNumHeapAllocations.load() - before;
+
+	// the first frame warms the arena up
+	FrameArena::endFrame();
+	{
+		std::pmr::vector<int> visible(FrameArena::get());
+		visibleInto(items, visible);
+	}
+	FrameArena::endFrame();
+	before = sNumHeapAllocations.load();
+	for (size_t frame = 0; frame < kNumFrames; ++frame) {
+		std::pmr::vector<int> visible(FrameArena::get());
+		visibleInto(items, visible);
+		checksum -= visible.size();
+		FrameArena::endFrame();
+	}
+	size_t arenaAllocations = sNumHeapAllocations.load() - before;
+	assert(checksum == 0);
+	std::cout << "heap allocations per frame: vector " << static_cast<double>(vectorAllocations) / kNumFrames
+		<< ", frame arena " << static_cast<double>(arenaAllocations) / kNumFrames << std::endl;
+	assert(vectorAllocations >= kNumFrames && arenaAllocations == 0);
+	assert(FrameArena::getLastFrameStats().numAllocations > 0);
+}
+
+int main() {
+	bumpTest();
+	pmrContainerTest();
+	threadArenaTest();
+	allocationCountTest();
+	std::cout << "FrameArena tests passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "GameClock.h"
+#include <chrono>
+#include <cmath>
+
+namespace com {
+
+std::uint64_t SteadyGameClock::now() const {
+	auto time = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+std::uint64_t ManualGameClock::now() const {
+	return _timeNs;
+}
+
+void ManualGameClock::set(std::uint64_t timeNs) {
+	_timeNs = timeNs;
+}
+
+void ManualGameClock::advance(std::uint64_t deltaNs) {
+	_timeNs += deltaNs;
+}
+
+void ManualGameClock::advanceMs(double deltaMs) {
+	_timeNs += static_cast<std::uint64_t>(std::llround(deltaMs * 1e6));
+}
+
+ReplayGameClock::ReplayGameClock(std::vector<std::uint64_t> frameDurationsNs, bool loop)
+: _frameDurationsNs(std::move(frameDurationsNs)), _loop(loop)
+{
+}
+
+ReplayGameClock ReplayGameClock::fromMilliseconds(const std::vector<float> &frameDurationsMs, bool loop) {
+	std::vector<std::uint64_t> durations;
+	durations.reserve(frameDurationsMs.size());
+	for (float ms : frameDurationsMs)
+		durations.push_back(static_cast<std::uint64_t>(std::llround(static_cast<double>(ms) * 1e6)));
+	return ReplayGameClock(std::move(durations), loop);
+}
+
+std::uint64_t ReplayGameClock::now() const {
+	return _timeNs;
+}
+
+void ReplayGameClock::onNewFrame() {
+	// the first frame only starts the timeline
+	if (!_started) {
+		_started = true;
+		return;
+	}
+	if (_frameDurationsNs.empty())
+		return;
+
+	size_t index = _frameIndex;
+	if (index >= _frameDurationsNs.size())
+		index = _loop ? index % _frameDurationsNs.size() : _frameDurationsNs.size() - 1;
+	_timeNs += _frameDurationsNs[index];
+	++_frameIndex;
+}
+
+size_t ReplayGameClock::getFrameIndex() const {
+	return _frameIndex;
+}
+
+bool ReplayGameClock::isFinished() const {
+	return !_loop && _frameIndex >= _frameDurationsNs.size();
+}
+
+}
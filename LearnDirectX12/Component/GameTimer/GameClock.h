@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace com {
+
+// time source of a GameTimer, nanoseconds from an arbitrary origin
+class IGameClock {
+public:
+	virtual std::uint64_t now() const = 0;
+	// called once at the start of every timer frame, replay clocks advance here
+	virtual void onNewFrame() {}
+	virtual ~IGameClock() = default;
+};
+
+class SteadyGameClock : public IGameClock {
+public:
+	std::uint64_t now() const override;
+};
+
+// only moves when told to, for tests
+class ManualGameClock : public IGameClock {
+public:
+	std::uint64_t now() const override;
+	void set(std::uint64_t timeNs);
+	void advance(std::uint64_t deltaNs);
+	void advanceMs(double deltaMs);
+private:
+	std::uint64_t _timeNs = 0;
+};
+
+// Plays back recorded frame durations, one per frame, so a benchmark sees the same deltas on
+// every run. After the last one it repeats the last duration, or wraps around when loop is set
+class ReplayGameClock : public IGameClock {
+public:
+	explicit ReplayGameClock(std::vector<std::uint64_t> frameDurationsNs, bool loop = false);
+	static ReplayGameClock fromMilliseconds(const std::vector<float> &frameDurationsMs, bool loop = false);
+	std::uint64_t now() const override;
+	void onNewFrame() override;
+	size_t getFrameIndex() const;
+	bool isFinished() const;
+private:
+	std::vector<std::uint64_t> _frameDurationsNs;
+	bool _loop;
+	bool _started = false;
+	size_t _frameIndex = 0;
+	std::uint64_t _timeNs = 0;
+};
+
+}
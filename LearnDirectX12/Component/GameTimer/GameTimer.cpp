@@ -1,22 +1,78 @@
 #include "GameTimer.h"
+#include <algorithm>
+#include <cmath>
+#include <format>
 
 namespace com {
 
-GameTimer::GameTimer() {
+constexpr static std::uint64_t kNsPerSecond = 1000000000;
+
+static float toSeconds(std::uint64_t ns) {
+	return static_cast<float>(static_cast<double>(ns) * 1e-9);
+}
+
+static float toMilliseconds(std::uint64_t ns) {
+	return static_cast<float>(static_cast<double>(ns) * 1e-6);
+}
+
+std::string FrameTimeStats::toString() const {
+	return std::format("frames: {}, avg: {:.2f}ms, p50: {:.2f}ms, p95: {:.2f}ms, p99: {:.2f}ms, worst: {:.2f}ms",
+		numFrames, averageMs, p50Ms, p95Ms, p99Ms, worstMs);
+}
+
+FrameTimeStats calcFrameTimeStats(std::vector<float> framesMs) {
+	FrameTimeStats stats;
+	if (framesMs.empty())
+		return stats;
+
+	double sum = 0.0;
+	for (float ms : framesMs)
+		sum += ms;
+	std::sort(framesMs.begin(), framesMs.end());
+
+	auto percentile = [&](float p) {
+		size_t rank = static_cast<size_t>(std::ceil(p * static_cast<float>(framesMs.size())));
+		return framesMs[std::clamp<size_t>(rank, 1, framesMs.size()) - 1];
+	};
+	stats.numFrames = framesMs.size();
+	stats.averageMs = static_cast<float>(sum / static_cast<double>(framesMs.size()));
+	stats.p50Ms = percentile(0.50f);
+	stats.p95Ms = percentile(0.95f);
+	stats.p99Ms = percentile(0.99f);
+	stats.worstMs = framesMs.back();
+	return stats;
+}
+
+GameTimer::GameTimer() : GameTimer(nullptr) {
+}
+
+GameTimer::GameTimer(std::shared_ptr<IGameClock> pClock) : pClock_(std::move(pClock)) {
+	if (pClock_ == nullptr)
+		pClock_ = std::make_shared<SteadyGameClock>();
+	fixedStepNs_ = 0;
+	maxFixedSteps_ = 8;
 	reset();
 }
 
 void GameTimer::reset() {
-	baseTime_ = chrono::steady_clock::now();
+	baseTime_ = now();
 	prevTime_ = baseTime_;
+	stoppedTime_ = baseTime_;
+	nextSecondTime_ = baseTime_ + kNsPerSecond;
 	stopped_ = false;
 	deltaTime_ = 0.f;
 	totalTime_ = 0.f;
-	pausedTime_ = 0.f;
+	pausedTime_ = 0;
 	prevFrameTimes_ = 30;
 	currFameTimes_ = 0;
-	nextTime_ = std::chrono::system_clock::to_time_t(chrono::system_clock::now()) + 1;
+	prevSecondMspf_ = 1000.f / 30.f;
+	currSecondFrameNs_ = 0;
+	frameCount_ = 0;
 	newSeconds_ = false;
+	historyHead_ = 0;
+	historySize_ = 0;
+	fixedAccumulatorNs_ = 0;
+	numFixedSteps_ = 0;
 }
 
 void GameTimer::start() {
@@ -24,10 +80,11 @@ void GameTimer::start() {
 		return;
 
 	stopped_ = false;
-	auto currTime = chrono::steady_clock::now();
+	auto currTime = now();
 	prevTime_ = currTime;
-	chrono::duration<float> diff = currTime - stoppedTime_;
-	pausedTime_ += diff.count();
+	pausedTime_ += currTime - stoppedTime_;
+	// the paused span does not count towards the current second either
+	nextSecondTime_ += currTime - stoppedTime_;
 }
 
 void GameTimer::stop() {
@@ -35,27 +92,36 @@ void GameTimer::stop() {
 		return;
 
 	deltaTime_ = 0.f;
+	numFixedSteps_ = 0;
 	stopped_ = true;
-	stoppedTime_ = chrono::steady_clock::now();
+	stoppedTime_ = now();
 }
 
 void GameTimer::startNewFrame() {
 	if (stopped_)
 		return;
 
-	auto currTime = chrono::steady_clock::now();
-	chrono::duration<float> diff = currTime - prevTime_;
+	pClock_->onNewFrame();
+	auto currTime = now();
+	std::uint64_t frameNs = currTime - prevTime_;
 	prevTime_ = currTime;
-	deltaTime_ = diff.count();
-	diff = currTime - baseTime_;
-	totalTime_ = diff.count() - pausedTime_;
+	deltaTime_ = toSeconds(frameNs);
+	totalTime_ = toSeconds(currTime - baseTime_ - pausedTime_);
+	++frameCount_;
 	++currFameTimes_;
-	time_t sysTime = chrono::system_clock::to_time_t(chrono::system_clock::now());
+	currSecondFrameNs_ += frameNs;
+	recordFrame(frameNs);
+	updateFixedStep(frameNs);
+
 	newSeconds_ = false;
-	if (sysTime >= nextTime_) {
-		nextTime_ = sysTime + 1;
+	if (currTime >= nextSecondTime_) {
+		// a long stall skips whole seconds instead of triggering once per missed second
+		std::uint64_t late = currTime - nextSecondTime_;
+		nextSecondTime_ += (late / kNsPerSecond + 1) * kNsPerSecond;
 		prevFrameTimes_ = currFameTimes_;
+		prevSecondMspf_ = toMilliseconds(currSecondFrameNs_) / static_cast<float>(currFameTimes_);
 		currFameTimes_ = 0;
+		currSecondFrameNs_ = 0;
 		newSeconds_ = true;
 	}
 }
@@ -73,11 +139,78 @@ std::uint32_t GameTimer::FPS() const {
 }
 
 float GameTimer::mspf() const {
-	return 1000.f / float(FPS());
+	return prevSecondMspf_;
 }
 
 bool GameTimer::oneSecondTrigger() const {
 	return newSeconds_;
 }
 
-}
\ No newline at end of file
+std::uint64_t GameTimer::getFrameCount() const {
+	return frameCount_;
+}
+
+FrameTimeStats GameTimer::getFrameTimeStats() const {
+	return calcFrameTimeStats(getFrameHistory());
+}
+
+std::vector<float> GameTimer::getFrameHistory() const {
+	std::vector<float> frames;
+	frames.reserve(historySize_);
+	size_t first = (historyHead_ + kFrameHistorySize - historySize_) % kFrameHistorySize;
+	for (size_t i = 0; i < historySize_; ++i)
+		frames.push_back(frameHistory_[(first + i) % kFrameHistorySize]);
+	return frames;
+}
+
+void GameTimer::setFixedTimeStep(float step, std::uint32_t maxStepsPerFrame) {
+	fixedStepNs_ = step > 0.f ? static_cast<std::uint64_t>(std::llround(static_cast<double>(step) * 1e9)) : 0;
+	maxFixedSteps_ = std::max(maxStepsPerFrame, 1u);
+	fixedAccumulatorNs_ = 0;
+	numFixedSteps_ = 0;
+}
+
+float GameTimer::getFixedTimeStep() const {
+	return toSeconds(fixedStepNs_);
+}
+
+std::uint32_t GameTimer::getNumFixedSteps() const {
+	return numFixedSteps_;
+}
+
+float GameTimer::getInterpolationAlpha() const {
+	if (fixedStepNs_ == 0)
+		return 1.f;
+	return static_cast<float>(static_cast<double>(fixedAccumulatorNs_) / static_cast<double>(fixedStepNs_));
+}
+
+const std::shared_ptr<IGameClock> &GameTimer::getClock() const {
+	return pClock_;
+}
+
+std::uint64_t GameTimer::now() const {
+	return pClock_->now();
+}
+
+void GameTimer::recordFrame(std::uint64_t frameNs) {
+	frameHistory_[historyHead_] = toMilliseconds(frameNs);
+	historyHead_ = (historyHead_ + 1) % kFrameHistorySize;
+	historySize_ = std::min(historySize_ + 1, kFrameHistorySize);
+}
+
+void GameTimer::updateFixedStep(std::uint64_t frameNs) {
+	numFixedSteps_ = 0;
+	if (fixedStepNs_ == 0)
+		return;
+
+	constexpr auto kMaxDeltaNs = static_cast<std::uint64_t>(kMaxFixedStepDelta * kNsPerSecond);
+	fixedAccumulatorNs_ += std::min(frameNs, kMaxDeltaNs);
+	std::uint64_t steps = fixedAccumulatorNs_ / fixedStepNs_;
+	fixedAccumulatorNs_ -= steps * fixedStepNs_;
+	// drop what does not fit instead of spiralling, the simulation just runs slow for a frame
+	if (steps > maxFixedSteps_)
+		steps = maxFixedSteps_;
+	numFixedSteps_ = static_cast<std::uint32_t>(steps);
+}
+
+}
@@ -1,12 +1,38 @@
 #pragma once
 #include <chrono>
+#include <array>
+#include <memory>
+#include <vector>
+#include <string>
+#include "GameClock.h"
 
 namespace com {
 
 namespace chrono = std::chrono;
+
+struct FrameTimeStats {
+	size_t numFrames = 0;
+	float  averageMs = 0.f;
+	float  p50Ms = 0.f;
+	float  p95Ms = 0.f;
+	float  p99Ms = 0.f;
+	float  worstMs = 0.f;
+public:
+	std::string toString() const;
+};
+
+// nearest rank percentiles of a list of frame times in milliseconds
+FrameTimeStats calcFrameTimeStats(std::vector<float> framesMs);
+
 class GameTimer {
+public:
+	constexpr static size_t kFrameHistorySize = 512;
+	// a stall longer than this is fed to the fixed step accumulator as this much
+	constexpr static float kMaxFixedStepDelta = 0.25f;
 public:
 	GameTimer();
+	// the clock is shared by copies of the timer, nullptr falls back to the steady clock
+	explicit GameTimer(std::shared_ptr<IGameClock> pClock);
 	void reset();
 	void start();
 	void stop();
@@ -14,20 +40,51 @@ public:
 	float getTotalTime() const;
 	float getDeltaTime() const;
 	std::uint32_t FPS() const;
+	// measured average frame time of the last full second
 	float mspf() const;
 	bool oneSecondTrigger() const;
+	std::uint64_t getFrameCount() const;
+	// percentiles over the last kFrameHistorySize frames
+	FrameTimeStats getFrameTimeStats() const;
+	// oldest first, milliseconds, can be fed back through ReplayGameClock::fromMilliseconds
+	std::vector<float> getFrameHistory() const;
+
+	// fixed timestep, 0 turns it off. After startNewFrame run getNumFixedSteps() updates of
+	// getFixedTimeStep() seconds and blend the last two states with getInterpolationAlpha()
+	void setFixedTimeStep(float step, std::uint32_t maxStepsPerFrame = 8);
+	float getFixedTimeStep() const;
+	std::uint32_t getNumFixedSteps() const;
+	float getInterpolationAlpha() const;
+	const std::shared_ptr<IGameClock> &getClock() const;
+private:
+	std::uint64_t now() const;
+	void recordFrame(std::uint64_t frameNs);
+	void updateFixedStep(std::uint64_t frameNs);
 private:
-	chrono::steady_clock::time_point baseTime_;
-	chrono::steady_clock::time_point prevTime_;
-	chrono::steady_clock::time_point stoppedTime_;
+	std::shared_ptr<IGameClock> pClock_;
+	std::uint64_t baseTime_;
+	std::uint64_t prevTime_;
+	std::uint64_t stoppedTime_;
+	std::uint64_t pausedTime_;
+	std::uint64_t nextSecondTime_;
 	float	      deltaTime_;
-	float	      pausedTime_;
 	float		  totalTime_;
 	std::uint32_t prevFrameTimes_;
 	std::uint32_t currFameTimes_;
-	std::time_t	  nextTime_;
+	float		  prevSecondMspf_;
+	std::uint64_t currSecondFrameNs_;
+	std::uint64_t frameCount_;
 	bool		  stopped_;
 	bool		  newSeconds_;
+
+	std::array<float, kFrameHistorySize> frameHistory_;
+	size_t		  historyHead_;
+	size_t		  historySize_;
+
+	std::uint64_t fixedStepNs_;
+	std::uint64_t fixedAccumulatorNs_;
+	std::uint32_t maxFixedSteps_;
+	std::uint32_t numFixedSteps_;
 };
 
-}
\ No newline at end of file
+}
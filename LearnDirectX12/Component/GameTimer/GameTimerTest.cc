@@ -1,8 +1,123 @@
 #include <iostream>
+#include <cassert>
+#include <cmath>
 #include <Windows.h>
 #include "GameTimer.h"
 
+static bool nearlyEqual(float lhs, float rhs, float epsilon = 1e-4f) {
+	return std::abs(lhs - rhs) <= epsilon;
+}
+
+void frameStatsTest() {
+	auto pClock = std::make_shared<com::ManualGameClock>();
+	com::GameTimer gt(pClock);
+	// 99 frames of 10ms and one 50ms hitch
+	for (size_t i = 0; i < 100; ++i) {
+		pClock->advanceMs(i == 50 ? 50.0 : 10.0);
+		gt.startNewFrame();
+	}
+	com::FrameTimeStats stats = gt.getFrameTimeStats();
+	assert(stats.numFrames == 100);
+	assert(nearlyEqual(stats.p50Ms, 10.f));
+	assert(nearlyEqual(stats.p95Ms, 10.f));
+	assert(nearlyEqual(stats.p99Ms, 10.f));
+	assert(nearlyEqual(stats.worstMs, 50.f));
+	assert(nearlyEqual(stats.averageMs, 10.4f));
+	assert(nearlyEqual(gt.getTotalTime(), 1.04f));
+
+	// the ring keeps the newest frames only
+	for (size_t i = 0; i < com::GameTimer::kFrameHistorySize; ++i) {
+		pClock->advanceMs(5.0);
+		gt.startNewFrame();
+	}
+	stats = gt.getFrameTimeStats();
+	assert(stats.numFrames == com::GameTimer::kFrameHistorySize);
+	assert(nearlyEqual(stats.worstMs, 5.f));
+	std::cout << "frameStatsTest: " << stats.toString() << std::endl;
+}
+
+void oneSecondTest() {
+	auto pClock = std::make_shared<com::ManualGameClock>();
+	com::GameTimer gt(pClock);
+	size_t triggers = 0;
+	for (size_t i = 0; i < 200; ++i) {
+		pClock->advanceMs(i < 100 ? 10.0 : 20.0);
+		gt.startNewFrame();
+		if (gt.oneSecondTrigger()) {
+			++triggers;
+			if (triggers == 1) {
+				assert(gt.FPS() == 100);
+				assert(nearlyEqual(gt.mspf(), 10.f));
+			}
+		}
+	}
+	assert(triggers == 3);
+	assert(gt.FPS() == 50);
+	assert(nearlyEqual(gt.mspf(), 20.f));
+
+	// time spent stopped is not counted
+	gt.stop();
+	pClock->advanceMs(5000.0);
+	gt.start();
+	pClock->advanceMs(10.0);
+	gt.startNewFrame();
+	assert(!gt.oneSecondTrigger());
+	assert(nearlyEqual(gt.getDeltaTime(), 0.01f));
+	assert(nearlyEqual(gt.getTotalTime(), 3.01f));
+}
+
+void fixedStepTest() {
+	auto pClock = std::make_shared<com::ManualGameClock>();
+	com::GameTimer gt(pClock);
+	gt.setFixedTimeStep(0.01f, 4);
+
+	pClock->advanceMs(25.0);
+	gt.startNewFrame();
+	assert(gt.getNumFixedSteps() == 2);
+	assert(nearlyEqual(gt.getInterpolationAlpha(), 0.5f));
+
+	pClock->advanceMs(5.0);
+	gt.startNewFrame();
+	assert(gt.getNumFixedSteps() == 1);
+	assert(nearlyEqual(gt.getInterpolationAlpha(), 0.f));
+
+	// a hitch is clamped to maxStepsPerFrame instead of spiralling
+	pClock->advanceMs(100.0);
+	gt.startNewFrame();
+	assert(gt.getNumFixedSteps() == 4);
+	assert(gt.getInterpolationAlpha() < 1.f);
+}
+
+void replayClockTest() {
+	std::vector<float> recorded = { 16.f, 17.f, 33.f, 15.f };
+	auto pReplay = std::make_shared<com::ReplayGameClock>(com::ReplayGameClock::fromMilliseconds(recorded));
+	com::GameTimer gt(pReplay);
+	gt.startNewFrame();
+	assert(gt.getDeltaTime() == 0.f);
+	for (float ms : recorded) {
+		gt.startNewFrame();
+		assert(nearlyEqual(gt.getDeltaTime() * 1000.f, ms));
+	}
+	assert(pReplay->isFinished());
+	// past the end the last duration repeats
+	gt.startNewFrame();
+	assert(nearlyEqual(gt.getDeltaTime() * 1000.f, 15.f));
+
+	// two runs over the same recording see the same frames
+	auto pReplayAgain = std::make_shared<com::ReplayGameClock>(com::ReplayGameClock::fromMilliseconds(recorded));
+	com::GameTimer gtAgain(pReplayAgain);
+	for (size_t i = 0; i < 6; ++i)
+		gtAgain.startNewFrame();
+	assert(gt.getFrameHistory() == gtAgain.getFrameHistory());
+	assert(gt.getTotalTime() == gtAgain.getTotalTime());
+}
+
 int main(int argc, char *argv[]) {
+	frameStatsTest();
+	oneSecondTest();
+	fixedStepTest();
+	replayClockTest();
+
 	com::GameTimer gt;
 	for (size_t i = 0; i < 10; ++i) {
 		std::cout << "totalTime: " << gt.getTotalTime() << std::endl;
@@ -15,8 +130,9 @@ int main(int argc, char *argv[]) {
 		if (gt.oneSecondTrigger()) {
 			std::cout << "fps: " << gt.FPS() << std::endl;
 			std::cout << "mspf: " << gt.mspf() << std::endl;
+			std::cout << gt.getFrameTimeStats().toString() << std::endl;
 			++second;
 		}
 	}
 	return 0;
-}
\ No newline at end of file
+}
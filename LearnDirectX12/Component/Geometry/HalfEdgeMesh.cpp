@@ -136,6 +136,34 @@ std::vector<HEEdge *> HEMesh::getNeighborsHalfEdges(const HEVertex *vert) const
 	return result;
 }
 
+void HEMesh::getNeighborsVerts(const HEVertex *vert, std::pmr::vector<HEVertex *> &result) const {
+	result.clear();
+	foreachNeighborsVerts(vert, [&](HEVertex *pOtherVert) {
+		result.push_back(pOtherVert);
+	});
+}
+
+void HEMesh::getNeighborsHalfVerts(const HEVertex *vert, std::pmr::vector<HEVertex *> &result) const {
+	result.clear();
+	foreachNeighborsHalfVerts(vert, [&](HEVertex *pOtherVert) {
+		result.push_back(pOtherVert);
+	});
+}
+
+void HEMesh::getNeighborsEdges(const HEVertex *vert, std::pmr::vector<HEEdge *> &result) const {
+	result.clear();
+	foreachNeighborsEdges(vert, [&](HEEdge *pOtherEdge) {
+		result.push_back(pOtherEdge);
+	});
+}
+
+void HEMesh::getNeighborsHalfEdges(const HEVertex *vert, std::pmr::vector<HEEdge *> &result) const {
+	result.clear();
+	foreachNeighborsHalfEdges(vert, [&](HEEdge *pOtherEdge) {
+		result.push_back(pOtherEdge);
+	});
+}
+
 HalfEdge::HEVertex *HEMesh::getVertex(size_t idx) const {
 	assert(idx < verts.size());
 	return verts[idx].get();
@@ -143,11 +171,11 @@ HalfEdge::HEVertex *HEMesh::getVertex(size_t idx) const {
 
 bool HEMesh::isBoundaryVert(const HEVertex *pVert) const {
 	updateVertBoundaryInfo();
-	for (auto *pEdge : getNeighborsEdges(pVert)) {
-		if (pEdge->isBoundary)
-			return true;
-	}
-	return false;
+	bool isBoundary = false;
+	foreachNeighborsEdges(pVert, [&](HEEdge *pEdge) {
+		isBoundary = isBoundary || pEdge->isBoundary;
+	});
+	return isBoundary;
 }
 
 bool HEMesh::isBoundaryEdge(const HEVertex *pVert1, const HEVertex *pVert2) const {
@@ -2,6 +2,7 @@
 #include <array>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
@@ -73,6 +74,11 @@ public:
 	std::vector<HEVertex *> getNeighborsHalfVerts(const HEVertex *vert) const;
 	std::vector<HEEdge *>	getNeighborsEdges(const HEVertex *vert) const;
 	std::vector<HEEdge *>	getNeighborsHalfEdges(const HEVertex *vert) const;
+	// overwrite result, a caller that keeps result (or gives it a frame arena) allocates nothing per vertex
+	void getNeighborsVerts(const HEVertex *vert, std::pmr::vector<HEVertex *> &result) const;
+	void getNeighborsHalfVerts(const HEVertex *vert, std::pmr::vector<HEVertex *> &result) const;
+	void getNeighborsEdges(const HEVertex *vert, std::pmr::vector<HEEdge *> &result) const;
+	void getNeighborsHalfEdges(const HEVertex *vert, std::pmr::vector<HEEdge *> &result) const;
 
 	HEVertex *getVertex(size_t idx) const;
 
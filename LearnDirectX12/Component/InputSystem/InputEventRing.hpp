@@ -0,0 +1,163 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "GameTimer/GameTimer.h"
+
+namespace com {
+
+// steady clock nanoseconds, every input event carries the time its message was handled
+inline std::uint64_t getInputTimestamp() {
+	auto time = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+// Bounded single producer single consumer ring. The window message handler pushes, the game loop
+// pops; neither side locks or allocates. A full ring drops the new event and counts it
+template<typename T, size_t Capacity>
+class InputEventRing {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+public:
+	constexpr static size_t kCapacity = Capacity;
+
+	// producer
+	bool tryPush(const T &event) {
+		size_t tail = _tail.load(std::memory_order_relaxed);
+		if (tail - _headCache == Capacity) {
+			_headCache = _head.load(std::memory_order_acquire);
+			if (tail - _headCache == Capacity) {
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		_events[tail & kMask] = event;
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer
+	bool tryPop(T &event) {
+		size_t head = _head.load(std::memory_order_relaxed);
+		if (head == _tailCache) {
+			_tailCache = _tail.load(std::memory_order_acquire);
+			if (head == _tailCache)
+				return false;
+		}
+		event = _events[head & kMask];
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer, hands every event published so far to func and frees them with one store
+	template<typename Func>
+	size_t drain(Func &&func) {
+		size_t head = _head.load(std::memory_order_relaxed);
+		size_t tail = _tail.load(std::memory_order_acquire);
+		_tailCache = tail;
+		for (size_t index = head; index != tail; ++index)
+			func(_events[index & kMask]);
+		_head.store(tail, std::memory_order_release);
+		return tail - head;
+	}
+
+	// consumer
+	void clear() {
+		drain([](const T &) {});
+	}
+
+	size_t size() const {
+		size_t tail = _tail.load(std::memory_order_acquire);
+		size_t head = _head.load(std::memory_order_acquire);
+		return tail - head;
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	size_t getDroppedCount() const {
+		return _dropped.load(std::memory_order_relaxed);
+	}
+private:
+	constexpr static size_t kMask = Capacity - 1;
+	std::array<T, Capacity> _events;
+	alignas(64) std::atomic<size_t> _head = 0;
+	size_t _tailCache = 0;						// consumer's last view of _tail
+	alignas(64) std::atomic<size_t> _tail = 0;
+	size_t _headCache = 0;						// producer's last view of _head
+	alignas(64) std::atomic<size_t> _dropped = 0;
+};
+
+// Single producer single consumer slot that holds the newest value only. The producer overwrites
+// it, the consumer copies it out and retries when the copy overlapped a write
+template<typename T>
+class InputLatestSlot {
+	static_assert(std::is_trivially_copyable_v<T>, "T is copied word by word");
+public:
+	// producer
+	void publish(const T &value) {
+		std::uint64_t words[kNumWords] = {};
+		std::memcpy(words, &value, sizeof(T));
+		std::uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+		_sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (size_t i = 0; i < kNumWords; ++i)
+			_words[i].store(words[i], std::memory_order_relaxed);
+		_sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	// consumer, false while nothing was published
+	bool read(T &value) const {
+		std::uint64_t words[kNumWords];
+		std::uint32_t before = 0;
+		std::uint32_t after = 0;
+		do {
+			before = _sequence.load(std::memory_order_acquire);
+			for (size_t i = 0; i < kNumWords; ++i)
+				words[i] = _words[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = _sequence.load(std::memory_order_relaxed);
+		} while (before != after || (before & 1) != 0);
+
+		if (before == 0)
+			return false;
+		std::memcpy(&value, words, sizeof(T));
+		return true;
+	}
+private:
+	constexpr static size_t kNumWords = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+	std::atomic<std::uint32_t> _sequence = 0;				// odd while a write is in progress
+	std::array<std::atomic<std::uint64_t>, kNumWords> _words = {};
+};
+
+// consumer side record of how long events waited between the message handler and the game loop
+class InputLatencyTracker {
+public:
+	constexpr static size_t kMaxSamples = 256;
+
+	void record(std::uint64_t eventTimestamp, std::uint64_t now = getInputTimestamp()) {
+		float latencyMs = now > eventTimestamp ? static_cast<float>(static_cast<double>(now - eventTimestamp) * 1e-6) : 0.f;
+		_samples[_next % kMaxSamples] = latencyMs;
+		++_next;
+	}
+
+	// percentiles of the last kMaxSamples events, in milliseconds
+	FrameTimeStats getStats() const {
+		size_t count = _next < kMaxSamples ? _next : kMaxSamples;
+		return calcFrameTimeStats(std::vector<float>(_samples.begin(), _samples.begin() + count));
+	}
+
+	size_t getNumRecorded() const {
+		return _next;
+	}
+private:
+	std::array<float, kMaxSamples> _samples = {};
+	size_t _next = 0;
+};
+
+}
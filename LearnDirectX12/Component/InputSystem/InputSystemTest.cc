@@ -1,13 +1,59 @@
 #include <iostream>
 #include <format>
+#include <cassert>
+#include <thread>
 #include "GameTimer/GameTimer.h"
+#include "InputEventRing.hpp"
 #include "InputSystem.h"
 #include "Window.h"
 #include "Mouse.h"
 #include "Keyboard.h"
 #include <format>
 
+struct TestEvent {
+	size_t sequence = 0;
+	std::uint64_t timestamp = 0;
+};
+
+void inputEventRingTest() {
+	com::InputEventRing<TestEvent, 8> ring;
+	TestEvent event;
+	assert(!ring.tryPop(event));
+	for (size_t i = 0; i < 10; ++i)
+		ring.tryPush({ i, 0 });
+	// full after 8, the newest two are dropped
+	assert(ring.size() == 8 && ring.getDroppedCount() == 2);
+	assert(ring.tryPop(event) && event.sequence == 0);
+	std::vector<size_t> drained;
+	assert(ring.drain([&](const TestEvent &e) { drained.push_back(e.sequence); }) == 7);
+	assert(drained.front() == 1 && drained.back() == 7 && ring.empty());
+
+	// one producer thread, the consumer drains like a game loop would
+	constexpr size_t kNumEvents = 200000;
+	com::InputEventRing<TestEvent, 256> sharedRing;
+	std::thread producer([&]() {
+		for (size_t i = 0; i < kNumEvents; ++i) {
+			while (!sharedRing.tryPush({ i, com::getInputTimestamp() }))
+				std::this_thread::yield();
+		}
+	});
+	com::InputLatencyTracker latency;
+	size_t expected = 0;
+	while (expected < kNumEvents) {
+		sharedRing.drain([&](const TestEvent &e) {
+			assert(e.sequence == expected);
+			latency.record(e.timestamp);
+			++expected;
+		});
+	}
+	producer.join();
+	assert(latency.getNumRecorded() == kNumEvents);
+	assert(latency.getStats().numFrames == com::InputLatencyTracker::kMaxSamples);
+	std::cout << "input latency: " << latency.getStats().toString() << std::endl;
+}
+
 int main() {
+	inputEventRingTest();
 	std::shared_ptr<com::GameTimer> pGameTimer = std::make_unique<com::GameTimer>();
 	std::unique_ptr<com::InputSystem> pInputSystem = std::make_unique<com::InputSystem>("Title", 800, 600);
 	while (!pInputSystem->shouldClose()) {
@@ -6,51 +6,83 @@ Keyboard::Keyboard() {
 }
 
 bool Keyboard::isKeyPressed(unsigned char key) const {
-	return _keyState.test(key);
+	return testBit(_keyState, key);
 }
 
 bool Keyboard::isCharPressed(unsigned char key) const {
-	return _characterState.test(key);
+	return testBit(_characterState, key);
 }
 
 KeyEvent Keyboard::getKeyEvent() {
-	if (_keycodeQueue.empty())
+	KeyEvent res;
+	if (!_keycodeQueue.tryPop(res))
 		return KeyEvent{};
 
-	auto res = _keycodeQueue.front();
-	_keycodeQueue.pop();
+	_latency.record(res.getTimestamp());
 	return res;
 }
 
 CharEvent Keyboard::getCharEvent() {
-	if (_characterQueue.empty())
+	CharEvent res;
+	if (!_characterQueue.tryPop(res))
 		return CharEvent{};
-	auto res = _characterQueue.front();
-	_characterQueue.pop();
+
+	_latency.record(res.getTimestamp());
 	return res;
 }
 
+size_t Keyboard::drainKeyEvents(std::vector<KeyEvent> &events) {
+	std::uint64_t now = getInputTimestamp();
+	return _keycodeQueue.drain([&](const KeyEvent &event) {
+		_latency.record(event.getTimestamp(), now);
+		events.push_back(event);
+	});
+}
+
+size_t Keyboard::drainCharEvents(std::vector<CharEvent> &events) {
+	std::uint64_t now = getInputTimestamp();
+	return _characterQueue.drain([&](const CharEvent &event) {
+		_latency.record(event.getTimestamp(), now);
+		events.push_back(event);
+	});
+}
+
+FrameTimeStats Keyboard::getLatencyStats() const {
+	return _latency.getStats();
+}
+
+size_t Keyboard::getDroppedEventCount() const {
+	return _keycodeQueue.getDroppedCount() + _characterQueue.getDroppedCount();
+}
 
 void Keyboard::handleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+	unsigned char key = static_cast<unsigned char>(wParam);
 	switch (msg) {
 	case WM_KEYDOWN:
-		_keyState.set(wParam);
-		_keycodeQueue.emplace(KeyState::Pressed, static_cast<char>(wParam));
+		setBit(_keyState, key, true);
+		_keycodeQueue.tryPush(KeyEvent(KeyState::Pressed, key, getInputTimestamp()));
 		break;
 	case WM_KEYUP:
-		_keyState.set(wParam, false);
-		_keycodeQueue.emplace(KeyState::Released, static_cast<char>(wParam));
+		setBit(_keyState, key, false);
+		_keycodeQueue.tryPush(KeyEvent(KeyState::Released, key, getInputTimestamp()));
 		break;
 	case WM_CHAR:
-		_characterState.set(wParam);
-		_characterQueue.emplace(KeyState::Pressed, static_cast<char>(wParam));
+		setBit(_characterState, key, true);
+		_characterQueue.tryPush(CharEvent(KeyState::Pressed, key, getInputTimestamp()));
 		break;
 	}
 }
 
-void Keyboard::endTick(std::shared_ptr<GameTimer> pGameTimer) {
-	tryDiscardEvent(_keycodeQueue);
-	tryDiscardEvent(_characterQueue);
+bool Keyboard::testBit(const KeyBits &bits, unsigned char key) {
+	return (bits[key / 64].load(std::memory_order_relaxed) >> (key % 64)) & 1;
+}
+
+void Keyboard::setBit(KeyBits &bits, unsigned char key, bool value) {
+	std::uint64_t mask = std::uint64_t(1) << (key % 64);
+	if (value)
+		bits[key / 64].fetch_or(mask, std::memory_order_relaxed);
+	else
+		bits[key / 64].fetch_and(~mask, std::memory_order_relaxed);
 }
 
 unsigned char KeyEvent::getKey() const {
@@ -77,7 +109,12 @@ KeyEvent::operator bool() const {
 	return !isInvalid();
 }
 
-KeyEvent::KeyEvent(KeyState state, unsigned char key) : _state(state), _key(key) {
+std::uint64_t KeyEvent::getTimestamp() const {
+	return _timestamp;
+}
+
+KeyEvent::KeyEvent(KeyState state, unsigned char key, std::uint64_t timestamp)
+	: _state(state), _key(key), _timestamp(timestamp) {
 }
 
 unsigned char CharEvent::getCharacter() const {
@@ -100,8 +137,12 @@ CharEvent::operator bool() const {
 	return _state != KeyState::Invalid;
 }
 
-CharEvent::CharEvent(KeyState state, unsigned char character)
-	: _state(state), _character(character) {
+std::uint64_t CharEvent::getTimestamp() const {
+	return _timestamp;
+}
+
+CharEvent::CharEvent(KeyState state, unsigned char character, std::uint64_t timestamp)
+	: _state(state), _character(character), _timestamp(timestamp) {
 }
 
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 #define NOMINMAX
 #include <windows.h>
-#include <bitset>
-#include <queue>
+#include <array>
+#include <atomic>
+#include <vector>
 #include "ITick.h"
+#include "InputSystem/InputEventRing.hpp"
 
 namespace com {
 
@@ -15,22 +17,25 @@ namespace com {
 
 	struct CharEvent {
 		CharEvent() = default;
-		CharEvent(KeyState state, unsigned char character);
+		CharEvent(KeyState state, unsigned char character, std::uint64_t timestamp = 0);
 		unsigned char getCharacter() const;
 		KeyState getState() const;
+		std::uint64_t getTimestamp() const;
 		bool isPressed() const;
 		bool isInvalid() const;
 		explicit operator bool() const;
 	private:
 		KeyState		_state = KeyState::Invalid;
 		unsigned char	_character = 0;
+		std::uint64_t	_timestamp = 0;
 	};
 
 	struct KeyEvent {
 		KeyEvent() = default;
-		KeyEvent(KeyState state, unsigned char key);
+		KeyEvent(KeyState state, unsigned char key, std::uint64_t timestamp = 0);
 		unsigned char getKey() const;
 		KeyState getState() const;
+		std::uint64_t getTimestamp() const;			// getInputTimestamp() when the message was handled
 		bool isPressed() const;
 		bool isReleased() const;
 		bool isInvalid() const;
@@ -38,18 +43,15 @@ namespace com {
 	private:
 		KeyState      _state = KeyState::Invalid;
 		unsigned char _key = 0;				// Use the window's virtual button
+		std::uint64_t _timestamp = 0;
 	};
 
 class GameTimer;
+// handleMsg is the producer and may run on the message thread, everything else is the consumer
 class Keyboard : public ITick {
-
 public:
 	static constexpr int kMaxKeyCodeSize = 0xff;
-	static constexpr int kMaxQueueSize = 0xff;
-	std::bitset<kMaxKeyCodeSize>	_keyState;
-	std::bitset<kMaxKeyCodeSize>	_characterState;
-	std::queue<KeyEvent>			_keycodeQueue;
-	std::queue<CharEvent>			_characterQueue;
+	static constexpr int kMaxQueueSize = 0x100;
 public:
 	Keyboard();
 	Keyboard(const Keyboard &) = delete;
@@ -59,19 +61,25 @@ public:
 	/// https://docs.microsoft.com/en-us/windows/win32/inputdev/virtual-key-codes
 	KeyEvent getKeyEvent();
 	CharEvent getCharEvent();
-
-	template<typename T>
-	static void tryDiscardEvent(std::queue<T> &queue);
+	// appends every pending event, returns how many
+	size_t drainKeyEvents(std::vector<KeyEvent> &events);
+	size_t drainCharEvents(std::vector<CharEvent> &events);
+	// message to consumption latency of the consumed events
+	FrameTimeStats getLatencyStats() const;
+	// events lost to a full queue
+	size_t getDroppedEventCount() const;
 
 	void handleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
-	virtual void endTick(std::shared_ptr<GameTimer> pGameTimer) override;
+private:
+	using KeyBits = std::array<std::atomic<std::uint64_t>, (kMaxKeyCodeSize + 64) / 64>;
+	static bool testBit(const KeyBits &bits, unsigned char key);
+	static void setBit(KeyBits &bits, unsigned char key, bool value);
+private:
+	KeyBits	_keyState = {};
+	KeyBits	_characterState = {};
+	InputEventRing<KeyEvent, kMaxQueueSize>	_keycodeQueue;
+	InputEventRing<CharEvent, kMaxQueueSize> _characterQueue;
+	InputLatencyTracker _latency;
 };
 
-
-template<typename T>
-void Keyboard::tryDiscardEvent(std::queue<T> &queue) {
-	while (queue.size() > Keyboard::kMaxQueueSize)
-		queue.pop();
-}
-
 }
\ No newline at end of file
@@ -6,15 +6,36 @@
 namespace com {
 
 Mouse::Mouse(InputSystem *pInputSystem) : _pInputSystem(pInputSystem) {
-	GetCursorPos(&_lastCursorPos);
-	ScreenToClient(_pInputSystem->pWindow->getHWND(), &_lastCursorPos);
+	POINT cursorPos;
+	GetCursorPos(&cursorPos);
+	ScreenToClient(_pInputSystem->pWindow->getHWND(), &cursorPos);
+	_lastCursorPos.store(cursorPos, std::memory_order_relaxed);
+
+	RAWINPUTDEVICE device;
+	device.usUsagePage = 0x01;		// HID_USAGE_PAGE_GENERIC
+	device.usUsage = 0x02;			// HID_USAGE_GENERIC_MOUSE
+	device.dwFlags = 0;
+	device.hwndTarget = _pInputSystem->pWindow->getHWND();
+	_rawInput = RegisterRawInputDevices(&device, 1, sizeof(device)) == TRUE;
+}
+
+Mouse::~Mouse() {
+	if (!_rawInput)
+		return;
+
+	RAWINPUTDEVICE device;
+	device.usUsagePage = 0x01;
+	device.usUsage = 0x02;
+	device.dwFlags = RIDEV_REMOVE;
+	device.hwndTarget = nullptr;
+	RegisterRawInputDevices(&device, 1, sizeof(device));
 }
 
 void Mouse::handleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 	int x = LOWORD(lParam);
 	int y = HIWORD(lParam);
 	bool isEvent = true;
-	MouseEvent mouseEvent = { x, y, MouseState::Invalid, 0.f };
+	MouseEvent mouseEvent = { x, y, MouseState::Invalid, 0.f, getInputTimestamp() };
 	switch (msg) {
 	case WM_LBUTTONDOWN:
 		mouseEvent._state = MouseState::LPress;
@@ -28,20 +49,47 @@ void Mouse::handleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 	case WM_RBUTTONUP:
 		mouseEvent._state = MouseState::RRelease;
 		break;
-	case WM_MOUSEMOVE:
+	case WM_MOUSEMOVE: {
 		mouseEvent._state = MouseState::Move;
-		if (!_showCursor) {
-			int dx = x - _lastCursorPos.x;
-			int dy = y - _lastCursorPos.y;
-			if (x == _windowCenter.x && y == _windowCenter.y)
+		POINT lastCursorPos = _lastCursorPos.load(std::memory_order_relaxed);
+		if (!_showCursor.load(std::memory_order_relaxed)) {
+			int dx = x - lastCursorPos.x;
+			int dy = y - lastCursorPos.y;
+			POINT windowCenter = _windowCenter.load(std::memory_order_relaxed);
+			if (x == windowCenter.x && y == windowCenter.y)
 				isEvent = false;
 
-			mouseEvent.x = (_virtualCursorPos.x += dx);
-			mouseEvent.y = (_virtualCursorPos.y += dy);
+			POINT virtualCursorPos = _virtualCursorPos.load(std::memory_order_relaxed);
+			virtualCursorPos.x += dx;
+			virtualCursorPos.y += dy;
+			_virtualCursorPos.store(virtualCursorPos, std::memory_order_relaxed);
+			mouseEvent.x = virtualCursorPos.x;
+			mouseEvent.y = virtualCursorPos.y;
+			if (!_rawInput && isEvent) {
+				_deltaX.fetch_add(dx, std::memory_order_relaxed);
+				_deltaY.fetch_add(dy, std::memory_order_relaxed);
+			}
+		} else if (!_rawInput) {
+			_deltaX.fetch_add(x - lastCursorPos.x, std::memory_order_relaxed);
+			_deltaY.fetch_add(y - lastCursorPos.y, std::memory_order_relaxed);
 		}
-		_lastCursorPos.x = x;
-		_lastCursorPos.y = y;
+		_lastCursorPos.store(POINT{ x, y }, std::memory_order_relaxed);
 		break;
+	}
+	case WM_INPUT: {
+		isEvent = false;
+		RAWINPUT rawInput;
+		UINT size = sizeof(rawInput);
+		UINT result = GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &rawInput, &size, sizeof(RAWINPUTHEADER));
+		if (result == static_cast<UINT>(-1) || rawInput.header.dwType != RIM_TYPEMOUSE)
+			break;
+		// tablets and remote desktop report absolute positions, WM_MOUSEMOVE covers those
+		if (rawInput.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE)
+			break;
+		_deltaX.fetch_add(rawInput.data.mouse.lLastX, std::memory_order_relaxed);
+		_deltaY.fetch_add(rawInput.data.mouse.lLastY, std::memory_order_relaxed);
+		break;
+	}
 	case WM_MBUTTONDOWN:
 		mouseEvent._state = MouseState::WheelDown;
 		break;
@@ -51,58 +99,175 @@ void Mouse::handleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 	case WM_MOUSEWHEEL:
 		mouseEvent._offset = GET_WHEEL_DELTA_WPARAM(wParam) / (float)WHEEL_DELTA;
 		mouseEvent._state = MouseState::Wheel;
+		_wheelDelta.fetch_add(GET_WHEEL_DELTA_WPARAM(wParam), std::memory_order_relaxed);
 		break;
 	default:
 		isEvent = false;
 		break;
 	}
 	if (isEvent)
-		_events.push(mouseEvent);
+		pushEvent(mouseEvent);
 }
 
-void Mouse::endTick(std::shared_ptr<GameTimer> pGameTimer) {
-	while (_events.size() > kEventMaxSize)
-		_events.pop();
+MouseEvent Mouse::getEvent() {
+	MouseEvent res;
+	bool olderQueued = true;
+	while (olderQueued) {
+		QueuedEvent queued;
+		bool popped = false;
+		while (!popped && _events.tryPop(queued)) {
+			++_numPopped;
+			popped = acceptQueued(queued);
+		}
+		if (popped) {
+			res = queued.event;
+			break;
+		}
+		// the held back move is newer than everything in the ring
+		takeLatestMove(res, olderQueued);
+	}
+	if (res)
+		_latency.record(res._timestamp);
+	return res;
 }
 
-MouseEvent Mouse::getEvent() {
-	if (_events.empty())
-		return {};
+size_t Mouse::drainEvents(std::vector<MouseEvent> &events) {
+	size_t first = events.size();
+	bool olderQueued = true;
+	while (olderQueued) {
+		_numPopped += _events.drain([&](const QueuedEvent &queued) {
+			if (acceptQueued(queued))
+				events.push_back(queued.event);
+		});
+		MouseEvent latestMove;
+		if (takeLatestMove(latestMove, olderQueued))
+			events.push_back(latestMove);
+	}
+	std::uint64_t now = getInputTimestamp();
+	for (size_t i = first; i < events.size(); ++i)
+		_latency.record(events[i]._timestamp, now);
+	return events.size() - first;
+}
 
-	auto res = _events.front();
-	_events.pop();
-	return res;
+MouseDelta Mouse::consumeDelta() {
+	MouseDelta delta;
+	delta.dx = _deltaX.exchange(0, std::memory_order_relaxed);
+	delta.dy = _deltaY.exchange(0, std::memory_order_relaxed);
+	delta.wheel = static_cast<float>(_wheelDelta.exchange(0, std::memory_order_relaxed)) / static_cast<float>(WHEEL_DELTA);
+	return delta;
+}
+
+bool Mouse::isRawInputEnabled() const {
+	return _rawInput;
+}
+
+FrameTimeStats Mouse::getLatencyStats() const {
+	return _latency.getStats();
+}
+
+size_t Mouse::getDroppedEventCount() const {
+	return _events.getDroppedCount();
+}
+
+void Mouse::pushEvent(const MouseEvent &event) {
+	if (event.isMove()) {
+		// nothing was queued after the held back move, so the new position replaces its position.
+		// It keeps the timestamp of the oldest message it stands for. Every update gets a new id,
+		// a position the consumer already took is never handed out again under the same id
+		if (!isPendingMoveConsumed()) {
+			_pendingMove.event.x = event.x;
+			_pendingMove.event.y = event.y;
+		} else {
+			_pendingMove.event = event;
+		}
+		_pendingMove.moveId = ++_nextMoveId;
+		_latestMove.publish({ _pendingMove, _numPushed });
+		return;
+	}
+	flushPendingMove();
+	pushQueued({ event, 0 });
+}
+
+void Mouse::flushPendingMove() {
+	if (!isPendingMoveConsumed())
+		pushQueued(_pendingMove);
+	_pendingMove.moveId = 0;
+}
+
+void Mouse::pushQueued(const QueuedEvent &queued) {
+	if (_events.tryPush(queued))
+		++_numPushed;
+}
+
+bool Mouse::isPendingMoveConsumed() const {
+	return _pendingMove.moveId <= _consumedMoveId.load(std::memory_order_acquire);
+}
+
+bool Mouse::acceptQueued(const QueuedEvent &queued) {
+	if (queued.moveId == 0)
+		return true;
+	// the consumer took this move from the slot before the producer queued it
+	if (queued.moveId <= _lastMoveId)
+		return false;
+	markMoveConsumed(queued.moveId);
+	return true;
+}
+
+bool Mouse::takeLatestMove(MouseEvent &event, bool &olderQueued) {
+	olderQueued = false;
+	PublishedMove latest;
+	if (!_latestMove.read(latest) || latest.move.moveId <= _lastMoveId)
+		return false;
+
+	// the producer queued events before publishing the move that this side has not popped yet
+	if (latest.numPushed > _numPopped) {
+		olderQueued = true;
+		return false;
+	}
+	markMoveConsumed(latest.move.moveId);
+	// events queued after the move were popped already, the ring dropped its queued copy
+	if (latest.numPushed < _numPopped)
+		return false;
+	event = latest.move.event;
+	return true;
+}
+
+void Mouse::markMoveConsumed(std::uint64_t moveId) {
+	_lastMoveId = moveId;
+	_consumedMoveId.store(moveId, std::memory_order_release);
 }
 
 bool Mouse::getShowCursor() const {
-	return _showCursor;
+	return _showCursor.load(std::memory_order_relaxed);
 }
 
 void Mouse::setShowCursor(bool bShow) {
-	if (_showCursor != bShow) {
-		_showCursor = bShow;
+	bool changed = _showCursor.exchange(bShow, std::memory_order_relaxed) != bShow;
+	if (changed)
 		ShowCursor(bShow);
-	}
 
 	if (!bShow) {
 		adjustCursorPosition();
-		_virtualCursorPos = _lastCursorPos;
+		_virtualCursorPos.store(_lastCursorPos.load(std::memory_order_relaxed), std::memory_order_relaxed);
 	} else {
 		ClipCursor(nullptr);
 	}
 
-	// clear _events
-	std::queue<MouseEvent> temp = {};
-	std::swap(_events, temp);
+	// drop every pending event, the held back move included
+	_numPopped += _events.drain([](const QueuedEvent &) {});
+	PublishedMove latest;
+	if (_latestMove.read(latest) && latest.move.moveId > _lastMoveId)
+		markMoveConsumed(latest.move.moveId);
+	consumeDelta();
 }
 
 void Mouse::adjustCursorPosition() {
 	RECT rect;
 	GetClientRect(_pInputSystem->pWindow->getHWND(), &rect);
-	_windowCenter.x = (rect.right + rect.left) / 2;
-	_windowCenter.y = (rect.bottom + rect.top) / 2;
-	_lastCursorPos = _windowCenter;
-	POINT physicsCursorPos = _lastCursorPos;
+	POINT windowCenter = { (rect.right + rect.left) / 2, (rect.bottom + rect.top) / 2 };
+	_windowCenter.store(windowCenter, std::memory_order_relaxed);
+	_lastCursorPos.store(windowCenter, std::memory_order_relaxed);
+	POINT physicsCursorPos = windowCenter;
 	ClientToScreen(_pInputSystem->pWindow->getHWND(), &physicsCursorPos);
 	SetCursorPos(physicsCursorPos.x, physicsCursorPos.y);
 
@@ -111,7 +276,9 @@ void Mouse::adjustCursorPosition() {
 }
 
 POINT Mouse::getCursorPosition() const {
-	return _showCursor ? _virtualCursorPos : _lastCursorPos;
+	if (_showCursor.load(std::memory_order_relaxed))
+		return _virtualCursorPos.load(std::memory_order_relaxed);
+	return _lastCursorPos.load(std::memory_order_relaxed);
 }
 
 MouseEvent::operator bool() const {
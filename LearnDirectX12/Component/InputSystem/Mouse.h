@@ -1,9 +1,10 @@
 #pragma once
 #define  NOMINMAX
-#include <queue>
 #include <Windows.h>
-#include <bitset>
+#include <atomic>
+#include <vector>
 #include "ITick.h"
+#include "InputSystem/InputEventRing.hpp"
 
 namespace com {
 
@@ -38,30 +39,84 @@ public:
 	int		    y = 0;
 	MouseState	_state = MouseState::Invalid;
 	float	    _offset = 0;
+	std::uint64_t _timestamp = 0;		// getInputTimestamp() when the message was handled
+};
+
+// motion summed since the last consumeDelta
+struct MouseDelta {
+	int   dx = 0;
+	int   dy = 0;
+	float wheel = 0.f;
 };
 
 class GameTimer;
+// handleMsg is the producer and may run on the message thread, everything else is the consumer.
+// Neither side locks. The producer holds the newest move back and merges later moves into it
+// until a button event arrives, then queues it ahead of that event. Meanwhile the held back move
+// is published through a slot the consumer reads once the ring is empty; every move carries an
+// id so the consumer skips a move it already took from the slot. Per message motion goes into
+// the delta accumulator, fed by WM_INPUT when raw input could be registered and by WM_MOUSEMOVE
+// otherwise
 class Mouse : public ITick {
 public:
 	Mouse(InputSystem *pInputSystem);
 	Mouse(const Mouse &) = delete;
 	Mouse &operator=(const Mouse &) = delete;
-	~Mouse() = default;
+	~Mouse();
 	void handleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
-	virtual void endTick(std::shared_ptr<GameTimer> pGameTimer) override;
 	MouseEvent getEvent();
+	// appends every pending event, returns how many
+	size_t drainEvents(std::vector<MouseEvent> &events);
+	// returns and resets the motion accumulated since the last call
+	MouseDelta consumeDelta();
+	bool isRawInputEnabled() const;
+	// message to consumption latency of the consumed events
+	FrameTimeStats getLatencyStats() const;
+	size_t getDroppedEventCount() const;
 	bool getShowCursor() const;
 	void setShowCursor(bool bShow);
 	void adjustCursorPosition();
 	POINT getCursorPosition() const;
 private:
-	static constexpr size_t kEventMaxSize = 0xff;
-	POINT _windowCenter;
-	POINT _virtualCursorPos;
-	POINT _lastCursorPos;
-	bool _showCursor = true;
+	struct QueuedEvent {
+		MouseEvent	  event;
+		std::uint64_t moveId = 0;						// 0 for everything but moves
+	};
+	struct PublishedMove {
+		QueuedEvent move;
+		size_t		numPushed = 0;						// ring pushes before the move, the consumer takes it once it popped as many
+	};
+	// producer
+	void pushEvent(const MouseEvent &event);
+	void flushPendingMove();
+	void pushQueued(const QueuedEvent &queued);
+	bool isPendingMoveConsumed() const;
+	// consumer
+	bool acceptQueued(const QueuedEvent &queued);
+	bool takeLatestMove(MouseEvent &event, bool &olderQueued);
+	void markMoveConsumed(std::uint64_t moveId);
+private:
+	static constexpr size_t kEventMaxSize = 0x100;
+	std::atomic<POINT> _windowCenter = POINT{};
+	std::atomic<POINT> _virtualCursorPos = POINT{};
+	std::atomic<POINT> _lastCursorPos = POINT{};
+	std::atomic<bool> _showCursor = true;
+	bool _rawInput = false;
 	InputSystem *_pInputSystem = nullptr;
-	std::queue<MouseEvent> _events;
+	InputEventRing<QueuedEvent, kEventMaxSize> _events;
+	InputLatestSlot<PublishedMove> _latestMove;
+	std::atomic<std::uint64_t> _consumedMoveId = 0;		// newest move id the consumer handed out
+	// producer only
+	QueuedEvent _pendingMove;							// moveId 0 while no move is held back
+	std::uint64_t _nextMoveId = 0;
+	size_t _numPushed = 0;
+	// consumer only
+	size_t _numPopped = 0;
+	std::uint64_t _lastMoveId = 0;
+	std::atomic<int> _deltaX = 0;
+	std::atomic<int> _deltaY = 0;
+	std::atomic<int> _wheelDelta = 0;					// in WHEEL_DELTA units
+	InputLatencyTracker _latency;
 };
 
 }
\ No newline at end of file
@@ -116,6 +116,9 @@ void Window::beginTick(std::shared_ptr<GameTimer> pGameTimer) {
 		sbuf << _title << ' ';
 		sbuf << "fps: " << pGameTimer->FPS() << ' ';
 		sbuf << "mspf: " << pGameTimer->mspf() << "ms";
+		// how long the consumed mouse events waited for the game loop
+		if (auto latency = _pInputSystem->pMouse->getLatencyStats(); latency.numFrames > 0)
+			sbuf << " input p95: " << latency.p95Ms << "ms";
 		auto title = sbuf.str();
 		SetWindowText(_hwnd, title.c_str());
 	}
@@ -0,0 +1,245 @@
+#include "JobSystem.h"
+#include <cassert>
+#include <algorithm>
+#include <format>
+
+namespace com {
+
+struct JobThreadContext {
+	const JobSystem *pJobSystem = nullptr;
+	size_t threadIndex = JobSystem::kInvalidThread;
+};
+
+static thread_local JobThreadContext sThreadContext;
+
+bool JobCounter::isDone() const {
+	return _pending.load(std::memory_order_acquire) == 0;
+}
+
+size_t JobCounter::getPending() const {
+	return _pending.load(std::memory_order_acquire);
+}
+
+size_t JobSystemStats::getNumExecuted() const {
+	size_t result = 0;
+	for (const JobThreadStats &thread : threads)
+		result += thread.numExecuted;
+	return result;
+}
+
+size_t JobSystemStats::getNumStolen() const {
+	size_t result = 0;
+	for (const JobThreadStats &thread : threads)
+		result += thread.numStolen;
+	return result;
+}
+
+std::string JobSystemStats::toString() const {
+	std::string result = std::format("jobs: {} threads, {} executed, {} stolen, {} injected\n",
+		threads.size(), getNumExecuted(), getNumStolen(), numInjected);
+	for (size_t i = 0; i < threads.size(); ++i)
+		result += std::format("    thread {}: {} executed, {} stolen\n", i, threads[i].numExecuted, threads[i].numStolen);
+	return result;
+}
+
+JobSystem::JobSystem(size_t numThreads) {
+	if (numThreads == 0)
+		numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+	assert(sThreadContext.pJobSystem == nullptr);
+	for (size_t i = 0; i < numThreads; ++i)
+		_threadData.push_back(std::make_unique<ThreadData>());
+	sThreadContext = { this, 0 };
+	for (size_t i = 1; i < numThreads; ++i)
+		_workers.emplace_back(&JobSystem::workerMain, this, i);
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard lock(_wakeMutex);
+		_quit = true;
+	}
+	_wakeCondition.notify_all();
+	for (auto &worker : _workers)
+		worker.join();
+
+	// jobs nobody waited for are dropped
+	for (auto &pThreadData : _threadData) {
+		for (auto &deque : pThreadData->deques) {
+			while (Job *pJob = deque.steal())
+				delete pJob;
+		}
+	}
+	for (auto &queue : _injectQueues) {
+		for (Job *pJob : queue)
+			delete pJob;
+	}
+	if (sThreadContext.pJobSystem == this)
+		sThreadContext = {};
+}
+
+void JobSystem::schedule(JobFunc job, JobCounter *pCounter, JobPriority priority) {
+	assert(job != nullptr);
+	if (pCounter != nullptr)
+		pCounter->_pending.fetch_add(1, std::memory_order_relaxed);
+
+	Job *pJob = new Job{ std::move(job), pCounter };
+	size_t priorityIndex = static_cast<size_t>(priority);
+	size_t threadIndex = getThreadIndex();
+	if (threadIndex != kInvalidThread) {
+		_threadData[threadIndex]->deques[priorityIndex].push(pJob);
+	} else {
+		std::lock_guard lock(_injectMutex);
+		_injectQueues[priorityIndex].push_back(pJob);
+		_numInjected.fetch_add(1, std::memory_order_relaxed);
+		_numInjectQueued.fetch_add(1, std::memory_order_release);
+	}
+
+	// a sleeping worker registers itself before it checks the queue count, one of the two sides sees the other
+	_numQueued.fetch_add(1, std::memory_order_seq_cst);
+	if (_numSleeping.load(std::memory_order_seq_cst) > 0) {
+		{ std::lock_guard lock(_wakeMutex); }
+		_wakeCondition.notify_one();
+	}
+}
+
+void JobSystem::wait(const JobCounter &counter) {
+	while (!counter.isDone()) {
+		if (!tryExecute())
+			std::this_thread::yield();
+	}
+}
+
+bool JobSystem::tryExecute() {
+	size_t threadIndex = getThreadIndex();
+	Job *pJob = threadIndex != kInvalidThread ? findJob(threadIndex) : nullptr;
+	if (pJob == nullptr)
+		return false;
+
+	execute(pJob, threadIndex);
+	return true;
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, const RangeFunc &func, JobPriority priority) {
+	if (begin >= end)
+		return;
+	JobCounter counter;
+	splitRange(begin, end, std::max<size_t>(grainSize, 1), func, counter, priority);
+	wait(counter);
+}
+
+size_t JobSystem::getThreadCount() const {
+	return _threadData.size();
+}
+
+size_t JobSystem::getThreadIndex() const {
+	return sThreadContext.pJobSystem == this ? sThreadContext.threadIndex : kInvalidThread;
+}
+
+JobSystemStats JobSystem::getStats() const {
+	JobSystemStats stats;
+	for (auto &pThreadData : _threadData) {
+		stats.threads.push_back({
+			pThreadData->numExecuted.load(std::memory_order_relaxed),
+			pThreadData->numStolen.load(std::memory_order_relaxed),
+		});
+	}
+	stats.numInjected = _numInjected.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void JobSystem::resetStats() {
+	for (auto &pThreadData : _threadData) {
+		pThreadData->numExecuted.store(0, std::memory_order_relaxed);
+		pThreadData->numStolen.store(0, std::memory_order_relaxed);
+	}
+	_numInjected.store(0, std::memory_order_relaxed);
+}
+
+void JobSystem::workerMain(size_t threadIndex) {
+	sThreadContext = { this, threadIndex };
+	constexpr size_t kSpinCount = 64;
+	size_t numFailed = 0;
+	while (!_quit.load(std::memory_order_relaxed)) {
+		if (Job *pJob = findJob(threadIndex)) {
+			execute(pJob, threadIndex);
+			numFailed = 0;
+			continue;
+		}
+		if (++numFailed < kSpinCount) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock lock(_wakeMutex);
+		_numSleeping.fetch_add(1, std::memory_order_seq_cst);
+		_wakeCondition.wait(lock, [&]() {
+			return _quit.load(std::memory_order_relaxed) || _numQueued.load(std::memory_order_seq_cst) > 0;
+		});
+		_numSleeping.fetch_sub(1, std::memory_order_relaxed);
+		numFailed = 0;
+	}
+}
+
+JobSystem::Job *JobSystem::findJob(size_t threadIndex) {
+	size_t numThreads = _threadData.size();
+	ThreadData &threadData = *_threadData[threadIndex];
+	for (size_t priority = 0; priority < kJobPriorityCount; ++priority) {
+		// own work first, newest first keeps the caches warm
+		Job *pJob = threadData.deques[priority].pop();
+
+		// then the oldest, usually largest, work of the others
+		for (size_t i = 1; pJob == nullptr && i < numThreads; ++i) {
+			size_t victim = (threadIndex + i) % numThreads;
+			pJob = _threadData[victim]->deques[priority].steal();
+			if (pJob != nullptr)
+				threadData.numStolen.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (pJob == nullptr && _numInjectQueued.load(std::memory_order_acquire) > 0) {
+			std::lock_guard lock(_injectMutex);
+			auto &queue = _injectQueues[priority];
+			if (!queue.empty()) {
+				pJob = queue.front();
+				queue.pop_front();
+				_numInjectQueued.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		if (pJob != nullptr) {
+			_numQueued.fetch_sub(1, std::memory_order_relaxed);
+			return pJob;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::execute(Job *pJob, size_t threadIndex) {
+	pJob->func();
+	JobCounter *pCounter = pJob->pCounter;
+	delete pJob;
+	_threadData[threadIndex]->numExecuted.fetch_add(1, std::memory_order_relaxed);
+	if (pCounter != nullptr)
+		pCounter->_pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void parallelFor(size_t begin, size_t end, size_t grainSize, const JobSystem::RangeFunc &func, JobPriority priority) {
+	if (JobSystem *pJobSystem = JobSystem::instance())
+		pJobSystem->parallelFor(begin, end, grainSize, func, priority);
+	else if (begin < end)
+		func(begin, end);
+}
+
+void JobSystem::splitRange(size_t begin, size_t end, size_t grainSize, const RangeFunc &func, JobCounter &counter, JobPriority priority) {
+	// the upper half goes to the deque where a thief finds it, this thread keeps splitting the lower half
+	while (end - begin > grainSize) {
+		size_t middle = begin + (end - begin) / 2;
+		schedule([=, this, &func, &counter]() {
+			splitRange(middle, end, grainSize, func, counter, priority);
+		}, &counter, priority);
+		end = middle;
+	}
+	func(begin, end);
+}
+
+}
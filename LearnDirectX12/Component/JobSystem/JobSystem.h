@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include "JobSystem/WorkStealingDeque.hpp"
+#include "Singleton/Singleton.hpp"
+
+namespace com {
+
+enum class JobPriority : std::uint8_t {
+	High,				// frame critical, always taken first
+	Low,				// background work such as streaming, runs when no high job is left
+};
+
+constexpr size_t kJobPriorityCount = 2;
+
+// counts unfinished jobs, a parent waits on the counter of its children
+class JobCounter {
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter &) = delete;
+	JobCounter &operator=(const JobCounter &) = delete;
+	bool isDone() const;
+	size_t getPending() const;
+private:
+	friend class JobSystem;
+	std::atomic<size_t> _pending = 0;
+};
+
+struct JobThreadStats {
+	size_t numExecuted = 0;
+	size_t numStolen = 0;
+};
+
+struct JobSystemStats {
+	std::vector<JobThreadStats> threads;			// [0] is the thread that created the job system
+	size_t numInjected = 0;							// scheduled from threads outside the job system
+public:
+	size_t getNumExecuted() const;
+	size_t getNumStolen() const;
+	std::string toString() const;
+};
+
+// Work stealing scheduler. Every thread of the system owns one Chase-Lev deque per priority, jobs
+// scheduled from a job go to the deque of its thread, idle threads steal from the top of the others.
+// The creating thread is thread 0, it runs jobs while it waits. Other threads may schedule too,
+// their jobs go through a locked injection queue.
+// BaseApp emplaces the one shared instance, engine code reaches it through instance()
+class JobSystem : public Singleton<JobSystem> {
+public:
+	using JobFunc = std::function<void()>;
+	// [begin, end) of a parallelFor
+	using RangeFunc = std::function<void(size_t begin, size_t end)>;
+
+	// numThreads counts the creating thread, 0 uses every hardware thread
+	explicit JobSystem(size_t numThreads = 0);
+	~JobSystem();
+	JobSystem(const JobSystem &) = delete;
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	// pCounter, when given, must outlive the job
+	void schedule(JobFunc job, JobCounter *pCounter = nullptr, JobPriority priority = JobPriority::High);
+	// runs other jobs until the counter drops to zero, callable from inside a job. Threads outside
+	// the job system only yield
+	void wait(const JobCounter &counter);
+	// runs one queued job on the calling thread, false when there is none or the thread is outside the job system
+	bool tryExecute();
+	// splits [begin, end) in halves until a range is not larger than grainSize and waits for all of them
+	void parallelFor(size_t begin, size_t end, size_t grainSize, const RangeFunc &func, JobPriority priority = JobPriority::High);
+
+	size_t getThreadCount() const;
+	// index of the calling thread, kInvalidThread outside the job system
+	size_t getThreadIndex() const;
+	JobSystemStats getStats() const;
+	void resetStats();
+
+	constexpr static size_t kInvalidThread = -1;
+private:
+	struct Job {
+		JobFunc		func;
+		JobCounter *pCounter;
+	};
+
+	struct alignas(64) ThreadData {
+		WorkStealingDeque<Job> deques[kJobPriorityCount];
+		std::atomic<size_t> numExecuted = 0;
+		std::atomic<size_t> numStolen = 0;
+	};
+
+	void workerMain(size_t threadIndex);
+	Job *findJob(size_t threadIndex);
+	void execute(Job *pJob, size_t threadIndex);
+	void splitRange(size_t begin, size_t end, size_t grainSize, const RangeFunc &func, JobCounter &counter, JobPriority priority);
+private:
+	std::vector<std::unique_ptr<ThreadData>> _threadData;
+	std::vector<std::thread> _workers;
+
+	std::mutex _injectMutex;
+	std::deque<Job *> _injectQueues[kJobPriorityCount];
+	std::atomic<size_t> _numInjected = 0;
+	std::atomic<size_t> _numInjectQueued = 0;		// lets idle threads skip the lock
+
+	std::atomic<size_t> _numQueued = 0;				// scheduled and not yet taken
+	std::atomic<size_t> _numSleeping = 0;
+	std::mutex _wakeMutex;
+	std::condition_variable _wakeCondition;
+	std::atomic<bool> _quit = false;
+};
+
+// parallelFor on the shared job system, runs the whole range on the calling thread when there is none
+void parallelFor(size_t begin, size_t end, size_t grainSize, const JobSystem::RangeFunc &func, JobPriority priority = JobPriority::High);
+
+}
@@ -0,0 +1,197 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <algorithm>
+#include "JobSystem.h"
+
+using namespace com;
+
+void dequeTest() {
+	// the owner pushes and pops while three thieves steal, every item comes out exactly once
+	constexpr int kNumItems = 200000;
+	std::vector<int> items(kNumItems);
+	std::vector<std::atomic<int>> taken(kNumItems);
+	WorkStealingDeque<int> deque(16);
+	std::atomic<bool> done = false;
+	std::atomic<int> numTaken = 0;
+	auto take = [&](int *pItem) {
+		taken[pItem - items.data()].fetch_add(1);
+		numTaken.fetch_add(1);
+	};
+
+	std::vector<std::thread> thieves;
+	for (int i = 0; i < 3; ++i) {
+		thieves.emplace_back([&]() {
+			while (!done.load()) {
+				if (int *pItem = deque.steal())
+					take(pItem);
+			}
+		});
+	}
+	for (int i = 0; i < kNumItems; ++i) {
+		deque.push(&items[i]);
+		if (i % 3 == 0) {
+			if (int *pItem = deque.pop())
+				take(pItem);
+		}
+	}
+	while (int *pItem = deque.pop())
+		take(pItem);
+	while (numTaken.load() < kNumItems)
+		std::this_thread::yield();
+	done = true;
+	for (auto &thief : thieves)
+		thief.join();
+
+	assert(deque.empty());
+	for (auto &count : taken)
+		assert(count.load() == 1);
+	std::cout << "[WorkStealingDeque] " << kNumItems << " items, every item taken once" << std::endl;
+}
+
+void jobSystemTest() {
+	JobSystem jobSystem(4);
+	assert(jobSystem.getThreadCount() == 4 && jobSystem.getThreadIndex() == 0);
+
+	// flat: many tiny jobs on one counter
+	constexpr size_t kNumJobs = 100000;
+	std::atomic<size_t> sum = 0;
+	JobCounter counter;
+	for (size_t i = 0; i < kNumJobs; ++i)
+		jobSystem.schedule([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); }, &counter);
+	jobSystem.wait(counter);
+	assert(counter.isDone() && sum.load() == kNumJobs * (kNumJobs - 1) / 2);
+
+	// nested: every job spawns children on its own counter and waits for them
+	std::function<size_t(size_t)> countNodes = [&](size_t depth) -> size_t {
+		if (depth == 0)
+			return 1;
+		std::atomic<size_t> children = 0;
+		JobCounter childCounter;
+		for (int i = 0; i < 3; ++i) {
+			jobSystem.schedule([&, depth]() {
+				children.fetch_add(countNodes(depth - 1), std::memory_order_relaxed);
+			}, &childCounter);
+		}
+		jobSystem.wait(childCounter);
+		return children.load() + 1;
+	};
+	assert(countNodes(8) == (6561 * 3 - 1) / 2);
+
+	// parallelFor visits every index exactly once for any grain
+	for (size_t grainSize : { size_t(1), size_t(7), size_t(1000), size_t(1 << 20) }) {
+		std::vector<std::atomic<std::uint8_t>> visited(50000);
+		jobSystem.parallelFor(0, visited.size(), grainSize, [&](size_t begin, size_t end) {
+			assert(end - begin <= grainSize);
+			for (size_t i = begin; i < end; ++i)
+				visited[i].fetch_add(1, std::memory_order_relaxed);
+		});
+		for (auto &count : visited)
+			assert(count.load() == 1);
+	}
+	jobSystem.parallelFor(5, 5, 1, [](size_t, size_t) { assert(false); });
+
+	// threads outside the system schedule through the injection queue
+	std::atomic<size_t> external = 0;
+	JobCounter externalCounter;
+	std::vector<std::thread> producers;
+	for (int i = 0; i < 4; ++i) {
+		producers.emplace_back([&]() {
+			assert(jobSystem.getThreadIndex() == JobSystem::kInvalidThread);
+			for (int j = 0; j < 5000; ++j)
+				jobSystem.schedule([&]() { external.fetch_add(1, std::memory_order_relaxed); }, &externalCounter, JobPriority::Low);
+		});
+	}
+	for (auto &producer : producers)
+		producer.join();
+	jobSystem.wait(externalCounter);
+	assert(external.load() == 20000 && jobSystem.getStats().numInjected == 20000);
+	std::cout << jobSystem.getStats().toString();
+}
+
+void priorityTest() {
+	// one thread: the high priority job runs first even though it was scheduled last
+	JobSystem jobSystem(1);
+	std::vector<int> order;
+	JobCounter counter;
+	jobSystem.schedule([&]() { order.push_back(2); }, &counter, JobPriority::Low);
+	jobSystem.schedule([&]() { order.push_back(3); }, &counter, JobPriority::Low);
+	jobSystem.schedule([&]() { order.push_back(1); }, &counter, JobPriority::High);
+	jobSystem.wait(counter);
+	assert(order.size() == 3 && order[0] == 1);
+	std::cout << "[JobSystem] priority order ok" << std::endl;
+}
+
+void sharedJobSystemTest() {
+	// tryExecute takes queued work onto the calling thread, one job per call
+	{
+		JobSystem jobSystem(1);
+		int numRun = 0;
+		jobSystem.schedule([&]() { ++numRun; });
+		assert(jobSystem.tryExecute() && numRun == 1);
+		assert(!jobSystem.tryExecute());
+	}
+
+	// without the shared instance the helper runs the whole range inline
+	size_t numRanges = 0;
+	parallelFor(0, 100, 10, [&](size_t begin, size_t end) {
+		assert(begin == 0 && end == 100);
+		++numRanges;
+	});
+	assert(numRanges == 1);
+
+	JobSystem::emplace(4);
+	std::vector<std::atomic<std::uint8_t>> visited(10000);
+	parallelFor(0, visited.size(), 64, [&](size_t begin, size_t end) {
+		assert(end - begin <= 64);
+		for (size_t i = begin; i < end; ++i)
+			visited[i].fetch_add(1, std::memory_order_relaxed);
+	});
+	for (auto &count : visited)
+		assert(count.load() == 1);
+	assert(JobSystem::instance()->getStats().getNumExecuted() > 0);
+	JobSystem::destroy();
+	std::cout << "[JobSystem] shared instance ok" << std::endl;
+}
+
+void scalingBenchmark() {
+	// the same compute bound loop with 1, 2, 4 ... hardware threads
+	constexpr size_t kCount = 1 << 20;
+	std::vector<float> values(kCount);
+	size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	double baseMs = 0.0;
+	for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+		JobSystem jobSystem(numThreads);
+		auto begin = std::chrono::steady_clock::now();
+		for (int repeat = 0; repeat < 4; ++repeat) {
+			jobSystem.parallelFor(0, kCount, 4096, [&](size_t first, size_t last) {
+				for (size_t i = first; i < last; ++i) {
+					float x = static_cast<float>(i);
+					for (int k = 0; k < 16; ++k)
+						x = std::sqrt(x * 1.0001f + 1.f);
+					values[i] = x;
+				}
+			});
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / 4.0;
+		if (numThreads == 1)
+			baseMs = ms;
+		JobSystemStats stats = jobSystem.getStats();
+		std::cout << std::format("[JobSystem] {} threads: {:.2f} ms, speedup {:.2f}x, {} jobs, {} stolen\n",
+			numThreads, ms, baseMs / ms, stats.getNumExecuted(), stats.getNumStolen());
+	}
+}
+
+int main() {
+	dequeTest();
+	jobSystemTest();
+	priorityTest();
+	sharedJobSystemTest();
+	scalingBenchmark();
+	return 0;
+}
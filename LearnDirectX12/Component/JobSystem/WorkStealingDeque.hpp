@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace com {
+
+// Chase-Lev deque of pointers. The owner thread pushes and pops at the bottom (LIFO), any thread
+// may steal from the top (FIFO). Grown arrays are kept until destruction, a thief may still read
+// the old one
+template<typename T>
+class WorkStealingDeque {
+public:
+	explicit WorkStealingDeque(size_t capacity = 1024) {
+		size_t powerOfTwo = 16;
+		while (powerOfTwo < capacity)
+			powerOfTwo *= 2;
+		_arrays.push_back(std::make_unique<Array>(powerOfTwo));
+		_pArray.store(_arrays.back().get(), std::memory_order_relaxed);
+	}
+	WorkStealingDeque(const WorkStealingDeque &) = delete;
+	WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+	// owner only
+	void push(T *pItem) {
+		std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+		std::int64_t top = _top.load(std::memory_order_acquire);
+		Array *pArray = _pArray.load(std::memory_order_relaxed);
+		if (bottom - top >= static_cast<std::int64_t>(pArray->capacity))
+			pArray = grow(pArray, top, bottom);
+		pArray->put(bottom, pItem);
+		_bottom.store(bottom + 1, std::memory_order_release);
+	}
+
+	// owner only, nullptr when empty or a thief won the last item
+	T *pop() {
+		std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+		Array *pArray = _pArray.load(std::memory_order_relaxed);
+		_bottom.store(bottom, std::memory_order_seq_cst);
+		std::int64_t top = _top.load(std::memory_order_seq_cst);
+		if (top > bottom) {
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T *pItem = pArray->get(bottom);
+		if (top == bottom) {
+			// the last item, race the thieves for it
+			if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				pItem = nullptr;
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return pItem;
+	}
+
+	// any thread, nullptr when empty or the race was lost
+	T *steal() {
+		std::int64_t top = _top.load(std::memory_order_seq_cst);
+		std::int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+		if (top >= bottom)
+			return nullptr;
+
+		Array *pArray = _pArray.load(std::memory_order_acquire);
+		T *pItem = pArray->get(top);
+		if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return pItem;
+	}
+
+	// a snapshot, exact only on the owner thread while nobody steals
+	size_t size() const {
+		std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+		std::int64_t top = _top.load(std::memory_order_relaxed);
+		return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+private:
+	struct Array {
+		size_t capacity;
+		size_t mask;
+		std::unique_ptr<std::atomic<T *>[]> items;
+	public:
+		explicit Array(size_t capacity)
+		: capacity(capacity), mask(capacity - 1), items(std::make_unique<std::atomic<T *>[]>(capacity)) {}
+		void put(std::int64_t index, T *pItem) {
+			items[static_cast<size_t>(index) & mask].store(pItem, std::memory_order_relaxed);
+		}
+		T *get(std::int64_t index) const {
+			return items[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+		}
+	};
+
+	Array *grow(Array *pArray, std::int64_t top, std::int64_t bottom) {
+		auto pNewArray = std::make_unique<Array>(pArray->capacity * 2);
+		for (std::int64_t index = top; index < bottom; ++index)
+			pNewArray->put(index, pArray->get(index));
+		_arrays.push_back(std::move(pNewArray));
+		_pArray.store(_arrays.back().get(), std::memory_order_release);
+		return _arrays.back().get();
+	}
+private:
+	alignas(64) std::atomic<std::int64_t> _top = 0;
+	alignas(64) std::atomic<std::int64_t> _bottom = 0;
+	std::atomic<Array *> _pArray = nullptr;
+	std::vector<std::unique_ptr<Array>> _arrays;		// owner only
+};
+
+}
@@ -0,0 +1,313 @@
+#include "Profiler.h"
+#include <cassert>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+namespace com {
+
+ProfileEventRing::ProfileEventRing(size_t capacity) {
+	size_t powerOfTwo = 16;
+	while (powerOfTwo < capacity)
+		powerOfTwo *= 2;
+	_mask = powerOfTwo - 1;
+	_events = std::make_unique<ProfileEvent[]>(powerOfTwo);
+}
+
+bool ProfileEventRing::push(const ProfileEvent &event) {
+	size_t head = _head.load(std::memory_order_relaxed);
+	size_t tail = _tail.load(std::memory_order_acquire);
+	if (head - tail > _mask) {
+		_numDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	_events[head & _mask] = event;
+	_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+size_t ProfileEventRing::getNumDropped() const {
+	return _numDropped.load(std::memory_order_relaxed);
+}
+
+struct ProfileThreadContext {
+	std::uint64_t profilerId = 0;
+	void *pState = nullptr;
+};
+
+static thread_local ProfileThreadContext sProfileThreadContext;
+static std::atomic<std::uint64_t> sNextProfilerId = 1;
+
+static std::uint64_t hashPath(std::uint64_t parentPathId, const ProfileZoneDesc *pZone) {
+	// FNV-1a over the parent path and the zone address
+	std::uint64_t hash = parentPathId == 0 ? 14695981039346656037ull : parentPathId;
+	auto value = reinterpret_cast<std::uintptr_t>(pZone);
+	for (size_t i = 0; i < sizeof(value); ++i) {
+		hash ^= (value >> (i * 8)) & 0xff;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static std::string escapeJson(const char *pText) {
+	std::string result;
+	for (; *pText != '\0'; ++pText) {
+		char c = *pText;
+		if (c == '"' || c == '\\')
+			result += '\\';
+		if (static_cast<unsigned char>(c) < 0x20)
+			continue;
+		result += c;
+	}
+	return result;
+}
+
+Profiler::Profiler(size_t ringSize)
+: _id(sNextProfilerId.fetch_add(1)), _ringSize(ringSize), _startNs(0)
+{
+	_startNs = now();
+	_frameBeginNs = 0;
+}
+
+Profiler::~Profiler() = default;
+
+std::uint64_t Profiler::now() const {
+	auto time = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count()) - _startNs;
+}
+
+void Profiler::record(const ProfileZoneDesc *pZone, std::uint64_t beginNs, std::uint64_t endNs) {
+	getThreadState()->ring.push({ pZone, beginNs, endNs });
+}
+
+void Profiler::setThreadName(const std::string &name) {
+	ThreadState *pState = getThreadState();
+	std::lock_guard lock(_threadMutex);
+	pState->name = name;
+}
+
+void Profiler::endFrame() {
+	std::vector<std::pair<size_t, std::vector<ProfileEvent>>> threadEvents;
+	{
+		std::lock_guard lock(_threadMutex);
+		for (auto &pState : _threads) {
+			std::vector<ProfileEvent> events;
+			pState->ring.drain([&](const ProfileEvent &event) { events.push_back(event); });
+			threadEvents.emplace_back(pState->threadIndex, std::move(events));
+		}
+	}
+
+	std::uint64_t frameEndNs = now();
+	_lastFrameMs = static_cast<double>(frameEndNs - _frameBeginNs) * 1e-6;
+	_frameBeginNs = frameEndNs;
+	if (_frameIndex == 0)
+		_timeToFirstFrameMs = _lastFrameMs;
+
+	if (_captureFramesLeft > 0) {
+		for (auto &[threadIndex, events] : threadEvents) {
+			for (const ProfileEvent &event : events)
+				_captureEvents.push_back({ event, threadIndex });
+		}
+		--_captureFramesLeft;
+	}
+
+	// the trees of every thread are merged by path, a parent never spans two threads
+	FrameTree tree;
+	for (auto &[threadIndex, events] : threadEvents) {
+		std::sort(events.begin(), events.end(), [](const ProfileEvent &lhs, const ProfileEvent &rhs) {
+			return lhs.beginNs < rhs.beginNs || (lhs.beginNs == rhs.beginNs && lhs.endNs > rhs.endNs);
+		});
+		aggregate(events, tree);
+	}
+	updateStatistics(tree);
+	++_frameIndex;
+}
+
+size_t Profiler::getFrameIndex() const {
+	return _frameIndex;
+}
+
+double Profiler::getLastFrameMs() const {
+	return _lastFrameMs;
+}
+
+double Profiler::getTimeToFirstFrameMs() const {
+	return _timeToFirstFrameMs;
+}
+
+const std::vector<ProfileZoneStats> &Profiler::getZoneStats() const {
+	return _zoneStats;
+}
+
+size_t Profiler::getNumDroppedEvents() const {
+	std::lock_guard lock(_threadMutex);
+	size_t result = 0;
+	for (auto &pState : _threads)
+		result += pState->ring.getNumDropped();
+	return result;
+}
+
+void Profiler::startCapture(size_t numFrames) {
+	_captureEvents.clear();
+	_captureFramesLeft = numFrames;
+}
+
+bool Profiler::isCapturing() const {
+	return _captureFramesLeft > 0;
+}
+
+size_t Profiler::getNumCapturedEvents() const {
+	return _captureEvents.size();
+}
+
+std::string Profiler::toChromeTrace() const {
+	std::string result = "{\"traceEvents\":[\n";
+	bool first = true;
+	auto append = [&](const std::string &event) {
+		if (!first)
+			result += ",\n";
+		result += event;
+		first = false;
+	};
+
+	{
+		std::lock_guard lock(_threadMutex);
+		for (auto &pState : _threads) {
+			std::string name = pState->name.empty() ? std::format("thread {}", pState->threadIndex) : pState->name;
+			append(std::format(R"({{"name":"thread_name","ph":"M","pid":0,"tid":{},"args":{{"name":"{}"}}}})",
+				pState->threadIndex, escapeJson(name.c_str())));
+		}
+	}
+	for (const TraceEvent &traceEvent : _captureEvents) {
+		const ProfileEvent &event = traceEvent.event;
+		append(std::format(R"({{"name":"{}","cat":"cpu","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":0,"tid":{}}})",
+			escapeJson(event.pZone->name),
+			static_cast<double>(event.beginNs) * 1e-3,
+			static_cast<double>(event.endNs - event.beginNs) * 1e-3,
+			traceEvent.threadIndex));
+	}
+	result += "\n]}\n";
+	return result;
+}
+
+bool Profiler::writeChromeTrace(const std::string &path) const {
+	namespace fs = std::filesystem;
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream output(tempPath, std::ios::binary);
+		if (!output)
+			return false;
+		std::string trace = toChromeTrace();
+		output.write(trace.data(), static_cast<std::streamsize>(trace.size()));
+		if (!output)
+			return false;
+	}
+	std::error_code error;
+	fs::rename(tempPath, path, error);
+	return !error;
+}
+
+Profiler::ThreadState *Profiler::getThreadState() {
+	ProfileThreadContext &context = sProfileThreadContext;
+	if (context.profilerId == _id)
+		return static_cast<ThreadState *>(context.pState);
+
+	std::lock_guard lock(_threadMutex);
+	_threads.push_back(std::make_unique<ThreadState>(_ringSize, _threads.size()));
+	context.profilerId = _id;
+	context.pState = _threads.back().get();
+	return _threads.back().get();
+}
+
+void Profiler::aggregate(const std::vector<ProfileEvent> &events, FrameTree &tree) const {
+	// events are sorted by begin time, a zone is a child of the innermost open zone that contains it
+	struct OpenZone {
+		std::uint64_t endNs;
+		std::uint64_t pathId;
+	};
+	std::vector<OpenZone> stack;
+	for (const ProfileEvent &event : events) {
+		while (!stack.empty() && stack.back().endNs < event.endNs)
+			stack.pop_back();
+
+		std::uint64_t parentPathId = stack.empty() ? 0 : stack.back().pathId;
+		std::uint64_t pathId = hashPath(parentPathId, event.pZone);
+		auto [iter, inserted] = tree.nodes.try_emplace(pathId);
+		FrameNode &node = iter->second;
+		if (inserted) {
+			node.pZone = event.pZone;
+			node.depth = stack.size();
+			if (parentPathId != 0)
+				tree.nodes[parentPathId].children.push_back(pathId);
+			else
+				tree.roots.push_back(pathId);
+		}
+
+		double ms = static_cast<double>(event.endNs - event.beginNs) * 1e-6;
+		++node.numCalls;
+		node.totalMs += ms;
+		if (parentPathId != 0)
+			tree.nodes[parentPathId].childMs += ms;
+		stack.push_back({ event.endNs, pathId });
+	}
+}
+
+void Profiler::updateStatistics(FrameTree &tree) {
+	size_t slot = _frameIndex % kHistorySize;
+	size_t windowSize = std::min(_frameIndex + 1, kHistorySize);
+	_zoneStats.clear();
+
+	std::vector<std::uint64_t> pending(tree.roots.rbegin(), tree.roots.rend());
+	while (!pending.empty()) {
+		std::uint64_t pathId = pending.back();
+		pending.pop_back();
+		const FrameNode &node = tree.nodes[pathId];
+		pending.insert(pending.end(), node.children.rbegin(), node.children.rend());
+
+		PathHistory &history = _histories[pathId];
+		// frames in between without a call count as zero
+		size_t numSkipped = std::min(_frameIndex - history.lastFrame, kHistorySize);
+		for (size_t i = 1; i < numSkipped; ++i) {
+			history.totalMs[(history.lastFrame + i) % kHistorySize] = 0.0;
+			history.selfMs[(history.lastFrame + i) % kHistorySize] = 0.0;
+		}
+		if (history.pZone == nullptr) {
+			std::fill(std::begin(history.totalMs), std::end(history.totalMs), 0.0);
+			std::fill(std::begin(history.selfMs), std::end(history.selfMs), 0.0);
+		}
+		history.pZone = node.pZone;
+		history.lastFrame = _frameIndex;
+		history.totalMs[slot] = node.totalMs;
+		history.selfMs[slot] = std::max(node.totalMs - node.childMs, 0.0);
+
+		ProfileZoneStats stats;
+		stats.pZone = node.pZone;
+		stats.pathId = pathId;
+		stats.depth = node.depth;
+		stats.numCalls = node.numCalls;
+		stats.lastMs = node.totalMs;
+		stats.minMs = node.totalMs;
+		stats.maxMs = node.totalMs;
+		double totalSum = 0.0;
+		double selfSum = 0.0;
+		for (size_t i = 0; i < windowSize; ++i) {
+			size_t index = (_frameIndex + kHistorySize - i) % kHistorySize;
+			totalSum += history.totalMs[index];
+			selfSum += history.selfMs[index];
+			stats.minMs = std::min(stats.minMs, history.totalMs[index]);
+			stats.maxMs = std::max(stats.maxMs, history.totalMs[index]);
+		}
+		stats.avgMs = totalSum / static_cast<double>(windowSize);
+		stats.avgSelfMs = selfSum / static_cast<double>(windowSize);
+		_zoneStats.push_back(stats);
+	}
+
+	// forget paths that left the window
+	std::erase_if(_histories, [&](const auto &item) {
+		return _frameIndex - item.second.lastFrame >= kHistorySize;
+	});
+}
+
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include "Singleton/Singleton.hpp"
+
+namespace com {
+
+// lives in static storage, the address is the zone id
+struct ProfileZoneDesc {
+	const char	 *name;
+	const char	 *file;
+	std::uint32_t line;
+};
+
+struct ProfileEvent {
+	const ProfileZoneDesc *pZone = nullptr;
+	std::uint64_t beginNs = 0;
+	std::uint64_t endNs = 0;
+};
+
+// single producer single consumer ring, the producer drops events when it is full
+class ProfileEventRing {
+public:
+	explicit ProfileEventRing(size_t capacity);
+	bool push(const ProfileEvent &event);
+	template<typename Func>
+	size_t drain(Func &&func) {
+		size_t tail = _tail.load(std::memory_order_relaxed);
+		size_t head = _head.load(std::memory_order_acquire);
+		for (size_t index = tail; index != head; ++index)
+			func(_events[index & _mask]);
+		_tail.store(head, std::memory_order_release);
+		return head - tail;
+	}
+	size_t getNumDropped() const;
+private:
+	size_t _mask;
+	std::unique_ptr<ProfileEvent[]> _events;
+	alignas(64) std::atomic<size_t> _head = 0;		// written by the producer
+	alignas(64) std::atomic<size_t> _tail = 0;		// written by the consumer
+	std::atomic<size_t> _numDropped = 0;
+};
+
+// one row of the statistics table, rows are in depth first order of the last frame
+struct ProfileZoneStats {
+	const ProfileZoneDesc *pZone = nullptr;
+	std::uint64_t pathId = 0;
+	size_t depth = 0;
+	size_t numCalls = 0;			// last frame
+	double lastMs = 0.0;
+	double avgMs = 0.0;				// over the rolling window
+	double minMs = 0.0;
+	double maxMs = 0.0;
+	double avgSelfMs = 0.0;			// without the time of the child zones
+};
+
+// Hierarchical CPU profiler. Zones write complete events into a lock free ring of their thread,
+// endFrame drains every ring once per frame, rebuilds the zone tree from the time ranges and
+// keeps rolling statistics per path. Captured frames export to the Chrome trace format
+class Profiler : public Singleton<Profiler> {
+public:
+	constexpr static size_t kDefaultRingSize = 1 << 14;
+	constexpr static size_t kHistorySize = 120;
+
+	explicit Profiler(size_t ringSize = kDefaultRingSize);
+	~Profiler();
+	Profiler(const Profiler &) = delete;
+	Profiler &operator=(const Profiler &) = delete;
+
+	std::uint64_t now() const;
+	void record(const ProfileZoneDesc *pZone, std::uint64_t beginNs, std::uint64_t endNs);
+	// shown for the calling thread in the trace
+	void setThreadName(const std::string &name);
+
+	void endFrame();
+	size_t getFrameIndex() const;
+	double getLastFrameMs() const;
+	// profiler creation -> end of the first frame, the startup cost of the app
+	double getTimeToFirstFrameMs() const;
+	const std::vector<ProfileZoneStats> &getZoneStats() const;
+	size_t getNumDroppedEvents() const;
+
+	// the next numFrames frames keep their raw events for toChromeTrace
+	void startCapture(size_t numFrames);
+	bool isCapturing() const;
+	size_t getNumCapturedEvents() const;
+	std::string toChromeTrace() const;
+	bool writeChromeTrace(const std::string &path) const;
+private:
+	struct ThreadState {
+		ProfileEventRing ring;
+		size_t threadIndex;
+		std::string name;
+	public:
+		ThreadState(size_t ringSize, size_t threadIndex) : ring(ringSize), threadIndex(threadIndex) {}
+	};
+
+	struct TraceEvent {
+		ProfileEvent event;
+		size_t threadIndex;
+	};
+
+	struct PathHistory {
+		const ProfileZoneDesc *pZone = nullptr;
+		double totalMs[kHistorySize] = {};
+		double selfMs[kHistorySize] = {};
+		size_t lastFrame = 0;
+	};
+
+	struct FrameNode {
+		const ProfileZoneDesc *pZone = nullptr;
+		size_t depth = 0;
+		size_t numCalls = 0;
+		double totalMs = 0.0;
+		double childMs = 0.0;
+		std::vector<std::uint64_t> children;
+	};
+
+	struct FrameTree {
+		std::unordered_map<std::uint64_t, FrameNode> nodes;		// by path id
+		std::vector<std::uint64_t> roots;
+	};
+
+	ThreadState *getThreadState();
+	void aggregate(const std::vector<ProfileEvent> &events, FrameTree &tree) const;
+	void updateStatistics(FrameTree &tree);
+private:
+	std::uint64_t _id;
+	size_t _ringSize;
+	std::uint64_t _startNs;
+
+	mutable std::mutex _threadMutex;
+	std::vector<std::unique_ptr<ThreadState>> _threads;
+
+	size_t _frameIndex = 0;
+	std::uint64_t _frameBeginNs = 0;
+	double _lastFrameMs = 0.0;
+	double _timeToFirstFrameMs = 0.0;
+	std::unordered_map<std::uint64_t, PathHistory> _histories;
+	std::vector<ProfileZoneStats> _zoneStats;
+
+	size_t _captureFramesLeft = 0;
+	std::vector<TraceEvent> _captureEvents;
+};
+
+// RAII zone, does nothing while no profiler exists
+class ProfileScope {
+public:
+	explicit ProfileScope(const ProfileZoneDesc *pZone) : _pZone(pZone), _pProfiler(Profiler::instance()) {
+		if (_pProfiler != nullptr)
+			_beginNs = _pProfiler->now();
+	}
+	~ProfileScope() {
+		if (_pProfiler != nullptr)
+			_pProfiler->record(_pZone, _beginNs, _pProfiler->now());
+	}
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+private:
+	const ProfileZoneDesc *_pZone;
+	Profiler *_pProfiler;
+	std::uint64_t _beginNs = 0;
+};
+
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// PROFILE_ZONE("name") times the rest of the enclosing scope
+#define PROFILE_ZONE(zoneName)																			\
+	static constexpr com::ProfileZoneDesc PROFILE_CONCAT(sProfileZone, __LINE__) { zoneName, __FILE__, __LINE__ };	\
+	com::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(&PROFILE_CONCAT(sProfileZone, __LINE__))
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <format>
+#include <filesystem>
+#include "Profiler.h"
+
+using namespace com;
+
+static void busyWait(double ms) {
+	auto end = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(ms);
+	while (std::chrono::steady_clock::now() < end)
+		;
+}
+
+static void leaf() {
+	PROFILE_ZONE("leaf");
+	busyWait(0.2);
+}
+
+static void update() {
+	PROFILE_ZONE("update");
+	for (int i = 0; i < 3; ++i)
+		leaf();
+}
+
+static void render() {
+	PROFILE_ZONE("render");
+	busyWait(0.5);
+	leaf();
+}
+
+static const ProfileZoneStats *findRow(const std::vector<ProfileZoneStats> &rows, const char *name, size_t depth) {
+	for (const ProfileZoneStats &row : rows) {
+		if (std::strcmp(row.pZone->name, name) == 0 && row.depth == depth)
+			return &row;
+	}
+	return nullptr;
+}
+
+void ringTest() {
+	ProfileEventRing ring(16);
+	static constexpr ProfileZoneDesc zone { "zone", __FILE__, __LINE__ };
+	for (std::uint64_t i = 0; i < 20; ++i)
+		ring.push({ &zone, i, i + 1 });
+	assert(ring.getNumDropped() == 4);
+	std::uint64_t expected = 0;
+	size_t count = ring.drain([&](const ProfileEvent &event) { assert(event.beginNs == expected++); });
+	assert(count == 16 && ring.drain([](const ProfileEvent &) {}) == 0);
+}
+
+void profilerTest() {
+	// no profiler: zones are free
+	assert(Profiler::instance() == nullptr);
+	update();
+
+	Profiler::emplace();
+	Profiler *pProfiler = Profiler::instance();
+	pProfiler->setThreadName("main");
+	pProfiler->startCapture(2);
+	for (int frame = 0; frame < 4; ++frame) {
+		{
+			PROFILE_ZONE("frame");
+			update();
+			render();
+			std::thread worker([&]() {
+				PROFILE_ZONE("worker");
+				leaf();
+			});
+			worker.join();
+		}
+		pProfiler->endFrame();
+	}
+
+	// rows are depth first: frame, update, leaf, render, leaf, then the worker tree
+	const std::vector<ProfileZoneStats> &rows = pProfiler->getZoneStats();
+	assert(rows.size() == 7);
+	assert(std::strcmp(rows[0].pZone->name, "frame") == 0 && rows[0].depth == 0);
+	assert(std::strcmp(rows[1].pZone->name, "update") == 0 && rows[1].depth == 1);
+	assert(std::strcmp(rows[2].pZone->name, "leaf") == 0 && rows[2].depth == 2 && rows[2].numCalls == 3);
+	assert(std::strcmp(rows[3].pZone->name, "render") == 0);
+	assert(std::strcmp(rows[4].pZone->name, "leaf") == 0 && rows[4].numCalls == 1);
+	assert(rows[2].pathId != rows[4].pathId);
+	const ProfileZoneStats *pWorker = findRow(rows, "worker", 0);
+	assert(pWorker != nullptr && findRow(rows, "leaf", 1) != nullptr);
+
+	// self time excludes the children, totals nest
+	const ProfileZoneStats &updateRow = rows[1];
+	assert(updateRow.lastMs >= rows[2].lastMs && updateRow.avgSelfMs < updateRow.avgMs);
+	assert(rows[2].lastMs >= 0.6 && rows[0].lastMs >= updateRow.lastMs + rows[3].lastMs);
+	assert(updateRow.minMs <= updateRow.avgMs && updateRow.avgMs <= updateRow.maxMs);
+	// the first frame also counts everything since the profiler was created
+	assert(pProfiler->getTimeToFirstFrameMs() >= updateRow.minMs);
+
+	// two captured frames: 1 frame + 1 update + 3 leaf + 1 render + 1 leaf + 1 worker + 1 leaf each
+	assert(!pProfiler->isCapturing() && pProfiler->getNumCapturedEvents() == 18);
+	std::string trace = pProfiler->toChromeTrace();
+	assert(trace.find("\"traceEvents\"") != std::string::npos);
+	assert(trace.find("\"name\":\"render\",\"cat\":\"cpu\",\"ph\":\"X\"") != std::string::npos);
+	assert(trace.find("\"args\":{\"name\":\"main\"}") != std::string::npos);
+	assert(pProfiler->writeChromeTrace("profiler_trace.json"));
+	std::filesystem::remove("profiler_trace.json");
+
+	// cost of one zone, fewer than the ring holds
+	size_t numRows = rows.size();
+	constexpr int kNumZones = 10000;
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < kNumZones; ++i) {
+		PROFILE_ZONE("overhead");
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / kNumZones;
+	pProfiler->endFrame();
+	std::cout << std::format("[Profiler] {} rows, zone overhead {:.1f} ns, dropped {}\n",
+		numRows, ns, pProfiler->getNumDroppedEvents());
+	assert(pProfiler->getNumDroppedEvents() == 0);
+	Profiler::destroy();
+}
+
+int main() {
+	ringTest();
+	profilerTest();
+	return 0;
+}
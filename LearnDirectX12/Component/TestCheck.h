@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// assert that is not compiled out by NDEBUG, the tests run in release builds too
+#define TEST_CHECK(expr)																		\
+	do {																						\
+		if (!(expr)) {																			\
+			std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #expr);		\
+			std::abort();																		\
+		}																						\
+	} while (false)
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include "D3D/Sky/IBLBaker.h"
+#include "JobSystem/JobSystem.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+static void printUsage() {
+	std::cout << "usage: IBLBakeTool <input.hdr> [options]\n"
+		<< "  --out <directory>         cache directory (default " << d3d::IBLBaker::defaultCacheDirectory << ")\n"
+		<< "  --env-size <n>            environment cube map size\n"
+		<< "  --prefilter-size <n>      prefiltered cube map size\n"
+		<< "  --prefilter-mips <n>      prefiltered mip count\n"
+		<< "  --prefilter-samples <n>   GGX samples per texel\n"
+		<< "  --lut-size <n>            BRDF LUT size\n"
+		<< "  --lut-samples <n>         BRDF LUT samples per texel\n"
+		<< "  --sh-order <n>            number of SH bands\n"
+		<< "  --threads <n>             worker threads, 0 uses every core\n"
+		<< "  --force                   bake even if the cache is up to date\n";
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printUsage();
+		return 1;
+	}
+
+	std::string inputFileName;
+	std::string cacheDirectory = d3d::IBLBaker::defaultCacheDirectory;
+	d3d::IBLBakeSettings settings;
+	size_t numThreads = 0;
+	bool force = false;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		auto nextValue = [&]() -> std::uint32_t {
+			if (i + 1 >= argc) {
+				std::cerr << "missing value for " << arg << std::endl;
+				std::exit(1);
+			}
+			return static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		};
+
+		if (arg == "--out") {
+			if (i + 1 >= argc) {
+				printUsage();
+				return 1;
+			}
+			cacheDirectory = argv[++i];
+			if (!cacheDirectory.empty() && cacheDirectory.back() != '/' && cacheDirectory.back() != '\\')
+				cacheDirectory += '/';
+		} else if (arg == "--env-size") {
+			settings.envMapSize = nextValue();
+		} else if (arg == "--prefilter-size") {
+			settings.prefilterSize = nextValue();
+		} else if (arg == "--prefilter-mips") {
+			settings.prefilterMipLevels = nextValue();
+		} else if (arg == "--prefilter-samples") {
+			settings.prefilterSampleCount = nextValue();
+		} else if (arg == "--lut-size") {
+			settings.brdfLutSize = nextValue();
+		} else if (arg == "--lut-samples") {
+			settings.brdfSampleCount = nextValue();
+		} else if (arg == "--sh-order") {
+			settings.shOrder = static_cast<int>(nextValue());
+		} else if (arg == "--threads") {
+			numThreads = nextValue();
+		} else if (arg == "--force") {
+			force = true;
+		} else if (arg == "--help" || arg == "-h") {
+			printUsage();
+			return 0;
+		} else if (inputFileName.empty()) {
+			inputFileName = arg;
+		} else {
+			std::cerr << "unknown argument " << arg << std::endl;
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (settings.envMapSize == 0 || settings.prefilterSize == 0 || settings.prefilterMipLevels == 0 ||
+		settings.prefilterSampleCount == 0 || settings.brdfLutSize == 0 || settings.brdfSampleCount == 0 ||
+		settings.shOrder <= 0 || settings.shOrder > d3d::kMaxSHOrder)
+	{
+		std::cerr << "invalid settings" << std::endl;
+		return 1;
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	com::JobSystem::emplace(numThreads);
+	d3d::IBLBaker baker(cacheDirectory);
+	d3d::IBLBakeFiles files = baker.bake(inputFileName, settings, force);
+	com::JobSystem::destroy();
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	if (!files) {
+		std::cerr << "failed to bake " << inputFileName << std::endl;
+		return 1;
+	}
+
+	d3d::IBLBakerStats stats = baker.getStats();
+	std::cout << (stats.numCacheHits > 0 ? "up to date: " : "baked: ") << inputFileName
+		<< " (" << elapsedMs << " ms)\n"
+		<< "  environment: " << files.envMapPath << "\n"
+		<< "  prefiltered: " << files.prefilterEnvMapPath << "\n"
+		<< "  brdf lut:    " << files.brdfLutPath << "\n"
+		<< "  sh:          " << files.irradianceSHPath << std::endl;
+	return 0;
+}
@@ -12,6 +12,7 @@
 #include "InputSystem/Keyboard.h"
 #include "InputSystem/Mouse.h"
 #include "GameTimer/GameTimer.h"
+#include "FrameArena/FrameArena.h"
 #include "D3D/Sky/SkyBox.h"
 #include "D3D/Tool/FirstPersonCamera.h"
 
@@ -42,6 +43,7 @@ void InstanceApp::onInitialize(dx12lib::DirectContextProxy pDirectCtx) {
 	buildMaterial(pDirectCtx);
 	buildPSO();
 	buildRenderItem();
+	buildInstanceBuffer(pDirectCtx);
 }
 
 void InstanceApp::onBeginTick(std::shared_ptr<com::GameTimer> pGameTimer) {
@@ -73,7 +75,8 @@ void InstanceApp::onTick(std::shared_ptr<com::GameTimer> pGameTimer) {
 		for (size_t idx = 0; idx < srvCount; ++idx)
 			pDirectCtx->setShaderResourceView(baseRegister + idx, _textures[idx]->getSRV());
 
-		std::vector<RenderItem> renderItems = cullingByFrustum(pGameTimer);
+		std::pmr::vector<RenderItem> renderItems(com::FrameArena::get());
+		cullingByFrustum(_opaqueRenderItems, _pCamera->getViewSpaceFrustum(), pGameTimer->getTotalTime(), renderItems);
 		doDrawInstance(pDirectCtx, _geometryMap["skull"], renderItems, pGameTimer);
 		_pSkyBox->render(pDirectCtx, _pCamera);
 		renderTarget.unbind(pDirectCtx);
@@ -122,7 +125,6 @@ void InstanceApp::buildCamera() {
 void InstanceApp::buildBuffer(dx12lib::CommonContextProxy pCommonCtx) {
 	_pPassCB = pCommonCtx->createFRConstantBuffer<d3d::CBPassType>();
 	_pLightCB = pCommonCtx->createConstantBuffer<d3d::CBLightType>();
-	_pInstanceBuffer = pCommonCtx->createFRStructuredBuffer<InstanceData>(kMaxInstanceSize);
 
 	auto pLight = _pLightCB->visit<d3d::CBLightType>();
 	pLight->ambientLight = float4(0.2f, 0.2f, 0.2f, 1.f);
@@ -218,9 +220,17 @@ void InstanceApp::buildPSO() {
 void InstanceApp::buildRenderItem() {
 	auto pMesh = _geometryMap["skull"];
 	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::uniform_int_distribution<size_t> disMat(0, _materials.size()-1);
-	std::uniform_int_distribution<size_t> disMap(0, _textures.size()-1);
+	_opaqueRenderItems = buildRenderItems(pMesh->getBounds(), _materials.size(), _textures.size(), rd());
+}
+
+std::vector<RenderItem> InstanceApp::buildRenderItems(const DirectX::BoundingBox &bounds, 
+	size_t numMaterials, 
+	size_t numTextures, 
+	std::uint32_t seed)
+{
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<size_t> disMat(0, numMaterials-1);
+	std::uniform_int_distribution<size_t> disMap(0, numTextures-1);
 	std::uniform_real_distribution<float> disVec(-1.f, 1.f);
 
 	float width = 100.0f;
@@ -228,7 +238,7 @@ void InstanceApp::buildRenderItem() {
 	float depth = 100.0f;
 	constexpr size_t n = 5;
 
-	_opaqueRenderItems.resize(n * n * n);
+	std::vector<RenderItem> renderItems(n * n * n);
 
 	float x = -0.5f * width;
 	float y = -0.5f * height;
@@ -240,7 +250,7 @@ void InstanceApp::buildRenderItem() {
 		for (size_t i = 0; i < n; ++i) {
 			for (size_t j = 0; j < n; ++j) {
 				size_t index = k * n * n + i * n + j;
-				auto &item = _opaqueRenderItems[index];
+				auto &item = renderItems[index];
 				item.materialIdx = disMat(gen);
 				item.diffuseMapIdx = disMap(gen);
 				item.axis = static_cast<float3>(normalize(Vector3(disVec(gen), disVec(gen), disVec(gen))));
@@ -250,39 +260,50 @@ void InstanceApp::buildRenderItem() {
 					0.0f, 0.0f, 1.0f, 0.0f,
 					x+j*dx, y+i*dy, z+k*dz, 1.0f
 				);
-				item.bounds = pMesh->getBounds();
+				item.bounds = bounds;
 			}
 		}
 	}
+	return renderItems;
 }
 
-std::vector<RenderItem> InstanceApp::cullingByFrustum(std::shared_ptr<com::GameTimer> pGameTimer) const {
-	std::vector<RenderItem> res;
-	BoundingFrustum viewSpaceFrustum = _pCamera->getViewSpaceFrustum();
-	float totalTime = pGameTimer->getTotalTime();
+void InstanceApp::buildInstanceBuffer(dx12lib::CommonContextProxy pCommonCtx) {
+	// every item visible at once is the most a frame can draw, so the buffer never grows
+	_pInstanceBuffer = pCommonCtx->createFRStructuredBuffer<InstanceData>(_opaqueRenderItems.size());
+}
 
-	for (const auto &rItem : _opaqueRenderItems) {
+void InstanceApp::cullingByFrustum(std::span<const RenderItem> opaqueRenderItems, 
+	const BoundingFrustum &frustum, 
+	float totalTime, 
+	std::pmr::vector<RenderItem> &renderItems)
+{
+	renderItems.clear();
+	renderItems.reserve(opaqueRenderItems.size());
+	for (const auto &rItem : opaqueRenderItems) {
 		Quaternion q = Quaternion(rItem.axis, totalTime);
 		Matrix4 matWorld = Matrix4(rItem.matWorld) * static_cast<Matrix4>(q);
 		auto bounds = BoundingBox(rItem.bounds).transform(matWorld);
-		if (viewSpaceFrustum.contains(bounds) != DirectX::DISJOINT)
-			res.push_back(rItem);
+		if (frustum.contains(bounds) != DirectX::DISJOINT)
+			renderItems.push_back(rItem);
 	}
-	return res;
 }
 
-void InstanceApp::doDrawInstance(dx12lib::GraphicsContextProxy pGraphicsCtx, 
-	std::shared_ptr<d3d::Mesh> pMesh, 
-	const std::vector<RenderItem> &renderItems,
-	std::shared_ptr<com::GameTimer> pGameTimer)
+void InstanceApp::batchInstances(std::span<const RenderItem> renderItems, 
+	float totalTime, 
+	d3d::DrawQueue &drawQueue, 
+	d3d::InstanceBatcher &instanceBatcher, 
+	std::span<InstanceData> instanceBuffer)
 {
+	drawQueue.clear();
+	for (size_t i = 0; i < renderItems.size(); ++i) {
+		// one pipeline, one mesh, the material is read per instance
+		drawQueue.push(d3d::DrawSortKey::make(0, 0, 0, 0, 0.f), static_cast<std::uint32_t>(i));
+	}
+	drawQueue.sort();
+	instanceBatcher.build(drawQueue.getItems());
 
-	float totalTime = pGameTimer->getTotalTime();
-
-	size_t idx = 0;
-	std::span<InstanceData> bufferVisitor = _pInstanceBuffer->visit();
-	for (const RenderItem &rItem : renderItems) {
-		InstanceData &instData = bufferVisitor[idx++];
+	instanceBatcher.packInstances(instanceBuffer.data(), instanceBuffer.size(), [&](InstanceData &instData, std::uint32_t index) {
+		const RenderItem &rItem = renderItems[index];
 		instData.materialIdx = static_cast<uint32_t>(rItem.materialIdx);
 		instData.diffuseMapIdx = static_cast<uint32_t>(rItem.diffuseMapIdx);
 		Quaternion q = Quaternion(rItem.axis, totalTime);
@@ -292,11 +313,22 @@ void InstanceApp::doDrawInstance(dx12lib::GraphicsContextProxy pGraphicsCtx,
 		Matrix4 matNormal = transpose(invWorld);
 		instData.matWorld = float4x4(matWorld);
 		instData.matNormal = float4x4(matNormal);
-	}
+	});
+}
 
-	pGraphicsCtx->setStructuredBuffer(sInstanceShaderRegister, _pInstanceBuffer);
-	pGraphicsCtx->setVertexBuffer(pMesh->getVertexBuffer());
-	pGraphicsCtx->setIndexBuffer(pMesh->getIndexBuffer());
-	pGraphicsCtx->setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	pMesh->drawIndexedInstanced(pGraphicsCtx, idx);
+void InstanceApp::doDrawInstance(dx12lib::DirectContextProxy pDirectCtx, 
+	std::shared_ptr<d3d::Mesh> pMesh, 
+	std::span<const RenderItem> renderItems,
+	std::shared_ptr<com::GameTimer> pGameTimer)
+{
+	batchInstances(renderItems, pGameTimer->getTotalTime(), _drawQueue, _instanceBatcher, _pInstanceBuffer->visit());
+	pDirectCtx->setStructuredBuffer(sInstanceShaderRegister, _pInstanceBuffer);
+	pDirectCtx->setVertexBuffer(pMesh->getVertexBuffer());
+	pDirectCtx->setIndexBuffer(pMesh->getIndexBuffer());
+	pDirectCtx->setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	// the shader indexes the instance buffer with SV_InstanceID alone, which works while every key
+	// is equal and the whole frame is a single batch
+	assert(_instanceBatcher.getBatches().size() <= 1);
+	for (const d3d::InstanceBatch &batch : _instanceBatcher.getBatches())
+		pMesh->drawIndexedInstanced(pDirectCtx, batch.instanceCount, batch.firstInstance);
 }
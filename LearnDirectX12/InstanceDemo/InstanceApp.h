@@ -4,8 +4,12 @@
 #include "D3D/Shader/ShaderCommon.h"
 #include "D3D/Model/Mesh/Mesh.h"
 #include "D3D/Tool/Camera.h"
+#include "D3D/DrawQueue/DrawQueue.h"
+#include "D3D/DrawQueue/InstanceBatcher.h"
 #include "dx12lib/Pipeline/ShaderRegister.hpp"
 #include <DirectXCollision.h>
+#include <memory_resource>
+#include <span>
 
 
 struct OpaqueVertex {
@@ -36,6 +40,24 @@ class InstanceApp : public com::BaseApp {
 public:
 	InstanceApp();
 	~InstanceApp() override;
+
+	// CPU half of the frame, InstanceBenchmark runs it without a device
+	static std::vector<RenderItem> buildRenderItems(const DirectX::BoundingBox &bounds, 
+		size_t numMaterials, 
+		size_t numTextures, 
+		std::uint32_t seed
+	);
+	static void cullingByFrustum(std::span<const RenderItem> opaqueRenderItems, 
+		const Math::BoundingFrustum &frustum, 
+		float totalTime, 
+		std::pmr::vector<RenderItem> &renderItems
+	);
+	static void batchInstances(std::span<const RenderItem> renderItems, 
+		float totalTime, 
+		d3d::DrawQueue &drawQueue, 
+		d3d::InstanceBatcher &instanceBatcher, 
+		std::span<InstanceData> instanceBuffer
+	);
 private:
 	void onInitialize(dx12lib::DirectContextProxy pDirectCtx) override;
 	void onBeginTick(std::shared_ptr<com::GameTimer> pGameTimer) override;
@@ -50,14 +72,13 @@ private:
 	void buildMaterial(dx12lib::CommonContextProxy pCommonCtx);
 	void buildPSO();
 	void buildRenderItem();
-	std::vector<RenderItem> cullingByFrustum(std::shared_ptr<com::GameTimer> pGameTimer) const;
-	void doDrawInstance(dx12lib::GraphicsContextProxy pGraphicsCtx, 
+	void buildInstanceBuffer(dx12lib::CommonContextProxy pCommonCtx);
+	void doDrawInstance(dx12lib::DirectContextProxy pDirectCtx, 
 		std::shared_ptr<d3d::Mesh> pMesh, 
-		const std::vector<RenderItem> &renderItems,
+		std::span<const RenderItem> renderItems,
 		std::shared_ptr<com::GameTimer> pGameTimer
 	);
 private:
-	constexpr static inline size_t kMaxInstanceSize = 150;
 	constexpr static inline size_t kMaxTextureArraySize = 5;
 	static inline dx12lib::ShaderRegister sInstanceShaderRegister{ dx12lib::RegisterSlot::SRV0, dx12lib::RegisterSpace::Space1 };
 	static inline dx12lib::ShaderRegister sMaterialShaderRegister{ dx12lib::RegisterSlot::SRV1, dx12lib::RegisterSpace::Space1 };
@@ -74,7 +95,9 @@ private:
 	std::shared_ptr<dx12lib::ConstantBuffer>   _pLightCB;
 	std::shared_ptr<dx12lib::SRStructuredBuffer> _pMaterialData;
 	FRConstantBufferPtr<d3d::CBPassType>       _pPassCB;
-	FRStructuredBufferPtr<InstanceData>        _pInstanceBuffer;
+	FRStructuredBufferPtr<InstanceData>        _pInstanceBuffer;		// one slot per render item
 	std::vector<RenderItem> _opaqueRenderItems;
+	d3d::DrawQueue _drawQueue;
+	d3d::InstanceBatcher _instanceBatcher;
 	bool _bMouseLeftPress = false;
 };
\ No newline at end of file
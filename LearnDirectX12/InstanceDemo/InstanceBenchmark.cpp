@@ -0,0 +1,65 @@
+#include "InstanceBenchmark.h"
+#include "Geometry/GeometryGenerator.h"
+
+using namespace Math;
+
+const char *InstanceBenchmark::getName() const {
+	return "InstanceDemo";
+}
+
+void InstanceBenchmark::onBenchmarkBegin(com::BenchmarkConfig &config) {
+	// the skull bounds as InstanceApp::loadSkull builds them
+	com::GometryGenerator gen;
+	com::MeshData skullMesh = gen.loadObjFile("resources/skull.obj");
+	DirectX::BoundingBox bounds;
+	if (!skullMesh.vertices.empty()) {
+		DirectX::BoundingBox::CreateFromPoints(bounds, 
+			skullMesh.vertices.size(), 
+			&skullMesh.vertices[0].position, 
+			sizeof(com::Vertex)
+		);
+	}
+
+	// fixed seed and counts, the demo uses random_device and a random number of materials
+	constexpr size_t kNumMaterials = 20;
+	constexpr size_t kNumTextures = 5;
+	_opaqueRenderItems = InstanceApp::buildRenderItems(bounds, kNumMaterials, kNumTextures, 1234);
+	_instanceBuffer.resize(_opaqueRenderItems.size());
+
+	d3d::CameraDesc cameraDesc {
+		float3(0.f, 0.f, -150.f),
+		float3(0.f, 1.f, 0.f),
+		float3(0.f, 0.f, 0.f),
+		DirectX::XMConvertToDegrees(config.fovY),
+		config.zNear,
+		config.zFar,
+		config.aspect,
+	};
+	_pCamera = std::make_unique<d3d::PathCamera>(cameraDesc);
+
+	if (config.cameraPath.empty()) {
+		// in and out of the grid, the visible set changes a lot
+		float center[3] = { 0.f, 0.f, 0.f };
+		config.cameraPath = com::CameraPath::makeOrbit(center, 90.f, 15.f, 12.f);
+	}
+}
+
+std::uint64_t InstanceBenchmark::onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) {
+	float totalTime = frame.pGameTimer->getTotalTime();
+	_pCamera->setPose(frame.camera.position, frame.camera.target);
+	{
+		com::BenchmarkStageScope scope(stages, "cull");
+		InstanceApp::cullingByFrustum(_opaqueRenderItems, _pCamera->getViewSpaceFrustum(), totalTime, _visibleItems);
+	}
+	{
+		com::BenchmarkStageScope scope(stages, "batch");
+		InstanceApp::batchInstances(_visibleItems, totalTime, _drawQueue, _instanceBatcher, _instanceBuffer);
+	}
+
+	com::BenchmarkHash hash;
+	hash.add(_visibleItems.size());
+	hash.add(_instanceBatcher.getBatches().size());
+	for (const RenderItem &item : _visibleItems)
+		hash.add(item.materialIdx);
+	return hash.get();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Benchmark/Benchmark.h"
+#include "D3D/Tool/PathCamera.h"
+#include "InstanceApp.h"
+
+// CPU side of InstanceApp without a device: the skull grid goes through InstanceApp's own culling
+// and instance batching every frame, only the seed is fixed
+class InstanceBenchmark : public com::IBenchmarkScene {
+public:
+	const char *getName() const override;
+	void onBenchmarkBegin(com::BenchmarkConfig &config) override;
+	std::uint64_t onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) override;
+private:
+	std::unique_ptr<d3d::PathCamera> _pCamera;
+	std::vector<RenderItem> _opaqueRenderItems;
+	std::pmr::vector<RenderItem> _visibleItems;
+	std::vector<InstanceData> _instanceBuffer;
+	d3d::DrawQueue _drawQueue;
+	d3d::InstanceBatcher _instanceBatcher;
+};
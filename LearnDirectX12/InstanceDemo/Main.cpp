@@ -1,8 +1,15 @@
 #include <iostream>
 #include "GameTimer/GameTimer.h"
 #include "InstanceApp.h"
+#include "InstanceBenchmark.h"
+
+int main(int argc, char *argv[]) {
+	// --benchmark runs the CPU side of the frame headless, see Benchmark/Benchmark.h for the flags
+	if (com::isBenchmarkRequested(argc, argv)) {
+		InstanceBenchmark benchmark;
+		return com::runBenchmarkMain(argc, argv, benchmark);
+	}
 
-int main() {
 	auto pGameTimer = std::make_shared<com::GameTimer>();
 	InstanceApp app;
 	try {
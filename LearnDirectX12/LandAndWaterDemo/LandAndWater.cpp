@@ -18,6 +18,7 @@
 #include "Geometry/GeometryGenerator.h"
 #include <DirectXColors.h>
 #include <random>
+#include <cstring>
 #include "D3D/Tool/FirstPersonCamera.h"
 
 
@@ -162,6 +163,19 @@ void LandAndWater::updateConstantBuffer(std::shared_ptr<com::GameTimer> pGameTim
 	pGPUPassCB->invRenderTargetSize = _pSwapChain->getInvRenderTargetSize();
 	pGPUPassCB->deltaTime = pGameTimer->getDeltaTime();
 	pGPUPassCB->totalTime = pGameTimer->getTotalTime();
+	updateObjectConstantBuffer();
+}
+
+void LandAndWater::updateObjectConstantBuffer() {
+	// every item stages its constants each frame, each frame resource copy gets the rows that differ from it
+	for (auto &&[passName, renderItems] : _renderItemMap) {
+		for (const RenderItem &rItem : renderItems)
+			_objectStaging.write(rItem._objectCBSlot, rItem._objectCB);
+	}
+	_objectStaging.flush([&](size_t slot, size_t offset, size_t size, const std::byte *pData) {
+		auto pGPUObjectCB = _objectCBuffers[slot]->visit();
+		std::memcpy(reinterpret_cast<std::byte *>(pGPUObjectCB.ptr()) + offset, pData, size);
+	});
 }
 
 
@@ -448,55 +462,50 @@ void LandAndWater::buildMaterials() {
 void LandAndWater::buildRenderItems(dx12lib::DirectContextProxy pDirectCtx) {
 	namespace DX = DirectX;
 
-	auto pBoxMesh = _geometryMap["boxGeo"];
-	auto boxMat = _materialMap["boxMat"];
-	CBObjectType boxOBjectCB;
-	boxOBjectCB.material = boxMat;
-	Matrix4 boxWorldMat = Matrix4::makeScale(5.f, 5.f, 5.f) * Matrix4::makeTranslation(0.f, 2.3f, 0.f);
-	boxOBjectCB.world = float4x4(boxWorldMat);
-	boxOBjectCB.normalMat = float4x4::identity();
-	boxOBjectCB.matTransform = float4x4::identity();
 	RenderItem boxRItem;
-	boxRItem._pMesh = pBoxMesh;
-	boxRItem._pConstantBuffer = pDirectCtx->createFRConstantBuffer<CBObjectType>(boxOBjectCB);
+	boxRItem._pMesh = _geometryMap["boxGeo"];
+	boxRItem._objectCB.material = _materialMap["boxMat"];
+	Matrix4 boxWorldMat = Matrix4::makeScale(5.f, 5.f, 5.f) * Matrix4::makeTranslation(0.f, 2.3f, 0.f);
+	boxRItem._objectCB.world = float4x4(boxWorldMat);
+	boxRItem._objectCB.normalMat = float4x4::identity();
+	boxRItem._objectCB.matTransform = float4x4::identity();
 	boxRItem._pAlbedoMap = _textureMap["WireFence.dds"];
 
-	auto pLandMesh = _geometryMap["landGeo"];
-	auto landMat = _materialMap["landMat"];
-	CBObjectType landOBjectCB;
-	landOBjectCB.material = landMat;
-	Matrix4 landMatTransform = Matrix4::makeScale(5.f, 5.f, 1.f);
-	landOBjectCB.matTransform = float4x4(landMatTransform);
-	landOBjectCB.world = float4x4::identity();
-	landOBjectCB.normalMat = float4x4::identity();
 	RenderItem landRItem;
-	landRItem._pMesh = pLandMesh;
-	landRItem._pConstantBuffer = pDirectCtx->createFRConstantBuffer<CBObjectType>(landOBjectCB);
+	landRItem._pMesh = _geometryMap["landGeo"];
+	landRItem._objectCB.material = _materialMap["landMat"];
+	Matrix4 landMatTransform = Matrix4::makeScale(5.f, 5.f, 1.f);
+	landRItem._objectCB.matTransform = float4x4(landMatTransform);
+	landRItem._objectCB.world = float4x4::identity();
+	landRItem._objectCB.normalMat = float4x4::identity();
 	landRItem._pAlbedoMap = _textureMap["grass.dds"];
 
-	auto pWaterMesh = _geometryMap["gridGeo"];
-	auto waterMat = _materialMap["waterMat"];
-	CBObjectType waterOBjectCB;
-	waterOBjectCB.material = waterMat;
-	waterOBjectCB.world = float4x4::identity();
-	waterOBjectCB.normalMat = float4x4::identity();
-	waterOBjectCB.matTransform = float4x4::identity();
 	RenderItem waterRItem;
-	waterRItem._pMesh = pWaterMesh;
-	waterRItem._pConstantBuffer = pDirectCtx->createFRConstantBuffer<CBObjectType>(waterOBjectCB);
+	waterRItem._pMesh = _geometryMap["gridGeo"];
+	waterRItem._objectCB.material = _materialMap["waterMat"];
+	waterRItem._objectCB.world = float4x4::identity();
+	waterRItem._objectCB.normalMat = float4x4::identity();
+	waterRItem._objectCB.matTransform = float4x4::identity();
 
 	RenderItem treeBillboards;
-	CBObjectType treeObjectCB;
-	treeObjectCB.material = _materialMap["TreeBillboardMat"];
-	treeObjectCB.world = float4x4::identity();
-	treeObjectCB.normalMat = float4x4::identity();
-	treeObjectCB.matTransform = float4x4::identity();
 	treeBillboards._pMesh = _geometryMap["TreeBillboardGeo"];
-	treeBillboards._pConstantBuffer = pDirectCtx->createFRConstantBuffer<CBObjectType>(treeObjectCB);
+	treeBillboards._objectCB.material = _materialMap["TreeBillboardMat"];
+	treeBillboards._objectCB.world = float4x4::identity();
+	treeBillboards._objectCB.normalMat = float4x4::identity();
+	treeBillboards._objectCB.matTransform = float4x4::identity();
 	treeBillboards._pAlbedoMap = _textureMap["treeArray2.dds"];
-	_renderItemMap["ClipPSO"].push_back(boxRItem);
-	_renderItemMap["TexturePSO"].push_back(landRItem);
-	_renderItemMap["WaterPSO"].push_back(waterRItem);
-	_renderItemMap["TreeBillboardPSO"].push_back(treeBillboards);
+
+	addRenderItem(pDirectCtx, "ClipPSO", std::move(boxRItem));
+	addRenderItem(pDirectCtx, "TexturePSO", std::move(landRItem));
+	addRenderItem(pDirectCtx, "WaterPSO", std::move(waterRItem));
+	addRenderItem(pDirectCtx, "TreeBillboardPSO", std::move(treeBillboards));
+	updateObjectConstantBuffer();
+}
+
+void LandAndWater::addRenderItem(dx12lib::DirectContextProxy pDirectCtx, const std::string &passName, RenderItem renderItem) {
+	renderItem._objectCBSlot = _objectStaging.addSlot<CBObjectType>();
+	renderItem._pConstantBuffer = pDirectCtx->createFRConstantBuffer<CBObjectType>();
+	_objectCBuffers.push_back(renderItem._pConstantBuffer);
+	_renderItemMap[passName].push_back(std::move(renderItem));
 }
 
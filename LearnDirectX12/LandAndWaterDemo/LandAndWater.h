@@ -6,6 +6,7 @@
 #include "D3D/Shader/ShaderCommon.h"
 #include "D3D/d3dutil.h"
 #include "D3D/Model/Mesh/Mesh.h"
+#include "D3D/UploadStaging/UploadStaging.h"
 
 
 namespace com {
@@ -65,6 +66,8 @@ struct CBObjectType {
 
 struct RenderItem {
 	std::shared_ptr<d3d::Mesh> _pMesh;
+	CBObjectType _objectCB;
+	size_t _objectCBSlot = d3d::UploadStaging::kInvalidSlot;
 	dx12lib::FRConstantBufferPtr<CBObjectType> _pConstantBuffer;
 	std::shared_ptr<dx12lib::ITextureResource> _pAlbedoMap;
 };
@@ -81,6 +84,7 @@ public:
 private:
 	void pollEvent();
 	void updateConstantBuffer(std::shared_ptr<com::GameTimer> pGameTimer);
+	void updateObjectConstantBuffer();
 	void renderWaterPass(dx12lib::DirectContextProxy pDirectCtx);
 	void drawOpaqueRenderItems(dx12lib::DirectContextProxy pDirectCtx,
 		const std::string &passName,
@@ -98,6 +102,7 @@ private:
 	void loadTextures(dx12lib::DirectContextProxy pDirectCtx);
 	void buildMaterials();
 	void buildRenderItems(dx12lib::DirectContextProxy pDirectCtx);
+	void addRenderItem(dx12lib::DirectContextProxy pDirectCtx, const std::string &passName, RenderItem renderItem);
 private:
 	std::unique_ptr<d3d::BlurFilter> _pBlurFilter;
 	FRConstantBufferPtr<WaterCBType> _pWaterCB;
@@ -107,6 +112,8 @@ private:
 	std::map<std::string, d3d::MaterialData> _materialMap;
 	std::map<std::string, std::shared_ptr<d3d::Mesh>> _geometryMap;
 	std::map<std::string, std::vector<RenderItem>> _renderItemMap;
+	d3d::UploadStaging _objectStaging { dx12lib::kFrameResourceCount };
+	std::vector<FRConstantBufferPtr<CBObjectType>> _objectCBuffers;		// by staging slot
 	std::map<std::string, std::shared_ptr<dx12lib::GraphicsPSO>> _psoMap;
 	std::map<std::string, std::shared_ptr<dx12lib::ITextureResource>> _textureMap;
 };
\ No newline at end of file
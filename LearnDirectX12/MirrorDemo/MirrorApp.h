@@ -29,7 +29,7 @@ struct RenderItem {
 	std::shared_ptr<d3d::Mesh> _pMesh;
 	dx12lib::FRConstantBufferPtr<ObjectCBType> _pObjectCB;
 	std::shared_ptr<dx12lib::ITextureResource> _pAlbedoMap;
-	d3d::SubMesh _submesh;
+	std::vector<d3d::SubMesh> _submeshs;
 };
 
 struct Vertex {
@@ -58,7 +58,7 @@ void Shape::onInitialize(dx12lib::DirectContextProxy pDirectCtx) {
 	buildGeometry(pDirectCtx);
 	loadTextures(pDirectCtx);
 	buildMaterials();
-	buildSkullAnimation();
+	_skullAnimation = buildSkullAnimation();
 	loadModelAndBuildRenderItem(pDirectCtx);
 	buildRenderItem(pDirectCtx);
 	_pSobelFilter = std::make_unique<d3d::SobelFilter>(pDirectCtx, _width, _height);
@@ -232,7 +232,7 @@ void Shape::buildRenderItem(dx12lib::DirectContextProxy pDirectCtx) {
 	boxObjCb.matNormal = float4x4(transpose(inverse(matWorld)));
 
 	auto pMesh = _geometrys["box"];
-	boxItem.subMesh = pMesh->getSubMesh();
+	boxItem.subMeshs = pMesh->getSubMesh();
 	boxItem.pVertexBuffer = pMesh->getVertexBuffer();
 	boxItem.pIndexBuffer = pMesh->getIndexBuffer();
 	boxItem.pAlbedo = _textureMap["bricks.dds"];
@@ -248,7 +248,7 @@ void Shape::buildRenderItem(dx12lib::DirectContextProxy pDirectCtx) {
 	gridObjCB.matTexCoord = float4x4(Matrix4::makeScale(10.f, 10.f, 1.f));
 
 	pMesh = _geometrys["grid"];
-	gridItem.subMesh = pMesh->getSubMesh();
+	gridItem.subMeshs = pMesh->getSubMesh();
 	gridItem.pVertexBuffer = pMesh->getVertexBuffer();
 	gridItem.pIndexBuffer = pMesh->getIndexBuffer();
 	gridItem.pAlbedo = _textureMap["tile.dds"];
@@ -289,10 +289,10 @@ void Shape::buildRenderItem(dx12lib::DirectContextProxy pDirectCtx) {
 
 		auto pCylinderMesh = _geometrys["cylinder"];
 		auto pShapeMesh = _geometrys["sphere"];
-		leftCylRItem.subMesh = pCylinderMesh->getSubMesh();
-		rightCylRItem.subMesh = pCylinderMesh->getSubMesh();
-		leftSphereRItem.subMesh = pShapeMesh->getSubMesh();
-		rightSphereRItem.subMesh = pShapeMesh->getSubMesh();
+		leftCylRItem.subMeshs = pCylinderMesh->getSubMesh();
+		rightCylRItem.subMeshs = pCylinderMesh->getSubMesh();
+		leftSphereRItem.subMeshs = pShapeMesh->getSubMesh();
+		rightSphereRItem.subMeshs = pShapeMesh->getSubMesh();
 
 		leftCylRItem.pVertexBuffer = pCylinderMesh->getVertexBuffer();
 		rightCylRItem.pVertexBuffer = pCylinderMesh->getVertexBuffer();
@@ -330,19 +330,18 @@ void Shape::buildRenderItem(dx12lib::DirectContextProxy pDirectCtx) {
 	auto &colorRenderItems = _renderItems[pColorPSOName];
 	RenderItem skullItem;
 	ObjectCB skullObjCB;
-	matWorld = Matrix4::makeTranslation(0.f, 1.f, 0.f);
+	matWorld = getSkullWorld();
 	skullObjCB.material = _materials["skullMat"];
 	skullObjCB.matWorld = float4x4(matWorld);
 	skullObjCB.matNormal = float4x4(transpose(inverse(matWorld)));
 
 	pMesh = _geometrys["skull"];
-	skullItem.subMesh = pMesh->getSubMesh();
+	skullItem.subMeshs = pMesh->getSubMesh();
 	skullItem.pVertexBuffer = pMesh->getVertexBuffer();
 	skullItem.pIndexBuffer = pMesh->getIndexBuffer();
 	skullItem.pObjectCb = pDirectCtx->createFRConstantBuffer<ObjectCB>(skullObjCB);
 	colorRenderItems.push_back(skullItem);
 
-	_skullMatWorld = skullObjCB.matWorld;
 	_pSkullObjCB = skullItem.pObjectCb;
 }
 
@@ -469,38 +468,71 @@ void Shape::buildMaterials() {
 	_materials["skullMat"] = skullMat;
 }
 
-void Shape::buildSkullAnimation() {
+d3d::BoneAnimation Shape::buildSkullAnimation() {
 	Quaternion q0 { Vector3(0.f, 1.f, 0.f), DirectX::XMConvertToRadians(30.f) };
 	Quaternion q1 { Vector3(1.f, 1.f, 2.f), DirectX::XMConvertToRadians(45.0f) };
 	Quaternion q2 { Vector3(0.f, 1.f, 0.f), DirectX::XMConvertToRadians(-30.0f) };
 	Quaternion q3 { Vector3(1.f, 0.f, 0.f), DirectX::XMConvertToRadians(70.0f) };
 
 	constexpr float scale = 2.f;
-	_skullAnimation.keyframes.resize(5);
-	_skullAnimation.keyframes[0].timePoint = 0.f * scale;
-	_skullAnimation.keyframes[0].translation = float3(-7.f, 0.f, 0.f);
-	_skullAnimation.keyframes[0].scale = float3(0.5f);
-	_skullAnimation.keyframes[0].rotationQuat = float4(q0);
-
-	_skullAnimation.keyframes[1].timePoint = 2.f * scale;
-	_skullAnimation.keyframes[1].translation = float3(0.f, 2.f, 10.f);
-	_skullAnimation.keyframes[1].scale = float3(0.45f);
-	_skullAnimation.keyframes[1].rotationQuat = float4(q1);
-
-	_skullAnimation.keyframes[2].timePoint = 4.0f * scale;
-	_skullAnimation.keyframes[2].translation = float3(7.f, 0.f, 0.f);
-	_skullAnimation.keyframes[2].scale = float3(0.5f);
-	_skullAnimation.keyframes[2].rotationQuat = float4(q2);
-
-	_skullAnimation.keyframes[3].timePoint = 6.0f * scale;
-	_skullAnimation.keyframes[3].translation = float3(0.0f, 1.0f, -10.0f);
-	_skullAnimation.keyframes[3].scale = float3(0.65f);
-	_skullAnimation.keyframes[3].rotationQuat = float4(q3);
-
-	_skullAnimation.keyframes[4].timePoint = 8.0f * scale;
-	_skullAnimation.keyframes[4].translation = float3(-7.0f, 0.0f, 0.0f);
-	_skullAnimation.keyframes[4].scale = float3(0.5f);
-	_skullAnimation.keyframes[4].rotationQuat = float4(q0);
+	d3d::BoneAnimation skullAnimation;
+	skullAnimation.keyframes.resize(5);
+	skullAnimation.keyframes[0].timePoint = 0.f * scale;
+	skullAnimation.keyframes[0].translation = float3(-7.f, 0.f, 0.f);
+	skullAnimation.keyframes[0].scale = float3(0.5f);
+	skullAnimation.keyframes[0].rotationQuat = float4(q0);
+
+	skullAnimation.keyframes[1].timePoint = 2.f * scale;
+	skullAnimation.keyframes[1].translation = float3(0.f, 2.f, 10.f);
+	skullAnimation.keyframes[1].scale = float3(0.45f);
+	skullAnimation.keyframes[1].rotationQuat = float4(q1);
+
+	skullAnimation.keyframes[2].timePoint = 4.0f * scale;
+	skullAnimation.keyframes[2].translation = float3(7.f, 0.f, 0.f);
+	skullAnimation.keyframes[2].scale = float3(0.5f);
+	skullAnimation.keyframes[2].rotationQuat = float4(q2);
+
+	skullAnimation.keyframes[3].timePoint = 6.0f * scale;
+	skullAnimation.keyframes[3].translation = float3(0.0f, 1.0f, -10.0f);
+	skullAnimation.keyframes[3].scale = float3(0.65f);
+	skullAnimation.keyframes[3].rotationQuat = float4(q3);
+
+	skullAnimation.keyframes[4].timePoint = 8.0f * scale;
+	skullAnimation.keyframes[4].translation = float3(-7.0f, 0.0f, 0.0f);
+	skullAnimation.keyframes[4].scale = float3(0.5f);
+	skullAnimation.keyframes[4].rotationQuat = float4(q0);
+	return skullAnimation;
+}
+
+Matrix4 Shape::getSkullWorld() {
+	return Matrix4::makeTranslation(0.f, 1.f, 0.f);
+}
+
+void Shape::updateSkullAnimation(const d3d::BoneAnimation &animation,
+	float &timePoint,
+	float deltaTime,
+	float4x4 &matWorld,
+	float4x4 &matNormal)
+{
+	timePoint += deltaTime;
+	if (timePoint > animation.getEndTime())
+		timePoint = 0.f;
+
+	Matrix4 animationMatrix { animation.interpolate(timePoint) };
+	Matrix4 world = animationMatrix * getSkullWorld();
+	matWorld = float4x4(world);
+	matNormal = float4x4(transpose(inverse(world)));
+}
+
+void Shape::updateSkinnedAnimation(const d3d::SkinnedData &skinnedData,
+	float &timePoint,
+	float deltaTime,
+	std::span<float4x4> boneTransforms)
+{
+	timePoint += deltaTime;
+	if (timePoint > skinnedData.getClipEndTime("Take1"))
+		timePoint = 0.f;
+	skinnedData.getFinalTransforms("Take1", timePoint, boneTransforms);
 }
 
 void Shape::loadModelAndBuildRenderItem(dx12lib::DirectContextProxy pDirectCtx) {
@@ -549,10 +581,12 @@ void Shape::loadModelAndBuildRenderItem(dx12lib::DirectContextProxy pDirectCtx)
 		objectCb.material.metallic = std::clamp(objectCb.material.metallic, 0.f, 1.f);
 
 		rItem.pObjectCb = pDirectCtx->createFRConstantBuffer<ObjectCB>(objectCb);
-		rItem.subMesh.name = std::to_string(subSet.id);
-		rItem.subMesh.count = subSet.faceCount * 3;
-		rItem.subMesh.startIndexLocation = subSet.faceStart * 3;
-		rItem.subMesh.baseVertexLocation = 0;
+		d3d::SubMesh subMesh;
+		subMesh.name = std::to_string(subSet.id);
+		subMesh.count = subSet.faceCount * 3;
+		subMesh.startIndexLocation = subSet.faceStart * 3;
+		subMesh.baseVertexLocation = 0;
+		rItem.subMeshs.push_back(subMesh);
 
 		rItem.pVertexBuffer = pVertexBuffer;
 		rItem.pIndexBuffer = pIndexBuffer;
@@ -588,7 +622,8 @@ void Shape::renderShapesPass(dx12lib::DirectContextProxy pDirectCtx) {
 		pDirectCtx->setConstantBuffer(dx12lib::RegisterSlot::CBV2, rItem.pObjectCb);
 		pDirectCtx->setShaderResourceView(dx12lib::RegisterSlot::SRV0, rItem.pAlbedo->getSRV());
 		pDirectCtx->setShaderResourceView(dx12lib::RegisterSlot::SRV1, rItem.pNormal->getSRV());
-		rItem.subMesh.drawIndexedInstanced(pDirectCtx);
+		for (const d3d::SubMesh &subMesh : rItem.subMeshs)
+			subMesh.drawIndexedInstanced(pDirectCtx);
 	}
 }
 
@@ -607,7 +642,8 @@ void Shape::renderSkullPass(dx12lib::DirectContextProxy pDirectCtx) {
 	pDirectCtx->setIndexBuffer(rItem.pIndexBuffer);
 	pDirectCtx->setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	pDirectCtx->setConstantBuffer(dx12lib::RegisterSlot::CBV2, rItem.pObjectCb);
-	rItem.subMesh.drawIndexedInstanced(pDirectCtx);
+	for (const d3d::SubMesh &subMesh : rItem.subMeshs)
+		subMesh.drawIndexedInstanced(pDirectCtx);
 }
 
 void Shape::renderSkinnedAnimationPass(dx12lib::DirectContextProxy pDirectCtx) {
@@ -625,7 +661,8 @@ void Shape::renderSkinnedAnimationPass(dx12lib::DirectContextProxy pDirectCtx) {
 		pDirectCtx->setConstantBuffer(dx12lib::RegisterSlot::CBV2, rItem.pObjectCb);
 		pDirectCtx->setShaderResourceView(dx12lib::RegisterSlot::SRV0, rItem.pAlbedo->getSRV());
 		pDirectCtx->setShaderResourceView(dx12lib::RegisterSlot::SRV1, rItem.pNormal->getSRV());
-		rItem.subMesh.drawIndexedInstanced(pDirectCtx);
+		for (const d3d::SubMesh &subMesh : rItem.subMeshs)
+			subMesh.drawIndexedInstanced(pDirectCtx);
 	}
 }
 
@@ -646,26 +683,18 @@ void Shape::updatePassCB(std::shared_ptr<com::GameTimer> pGameTimer) {
 }
 
 void Shape::updateSkullAnimationCb(std::shared_ptr<com::GameTimer> pGameTimer) {
-	_skullAnimationTimePoint += pGameTimer->getDeltaTime();
-	if (_skullAnimationTimePoint > _skullAnimation.getEndTime())
-		_skullAnimationTimePoint = 0.f;
-
-	Matrix4 matWorld { _skullMatWorld };
-	Matrix4 animationMatrix { _skullAnimation.interpolate(_skullAnimationTimePoint) };
-	matWorld = animationMatrix * matWorld;
 	auto pSkullCBVisitor = _pSkullObjCB->visit();
-	pSkullCBVisitor->matWorld = float4x4(matWorld);
-	pSkullCBVisitor->matNormal = float4x4(transpose(inverse(matWorld)));
+	updateSkullAnimation(_skullAnimation, 
+		_skullAnimationTimePoint, 
+		pGameTimer->getDeltaTime(), 
+		pSkullCBVisitor->matWorld, 
+		pSkullCBVisitor->matNormal
+	);
 }
 
 void Shape::updateSkinnedAnimationCb(std::shared_ptr<com::GameTimer> pGameTimer) {
-	_skinnedAnimationTimePoint += pGameTimer->getDeltaTime();
-	if (_skinnedAnimationTimePoint > _skinnedData.getClipEndTime("Take1"))
-		_skinnedAnimationTimePoint = 0.f;
-
 	auto pSkinnedBoneCbVisit = _pSkinnedBoneCb->visit();
-	std::vector<float4x4> boneTransforms = _skinnedData.getFinalTransforms("Take1", _skinnedAnimationTimePoint);
-	size_t limit = std::min(SkinnedBoneCB::kMaxCount, boneTransforms.size());
-	for (size_t i = 0; i < limit; ++i)
-		pSkinnedBoneCbVisit->boneTransforms[i] = boneTransforms[i];
+	size_t limit = std::min(SkinnedBoneCB::kMaxCount, _skinnedData.getBoneCount());
+	std::span<float4x4> boneTransforms(pSkinnedBoneCbVisit->boneTransforms, limit);
+	updateSkinnedAnimation(_skinnedData, _skinnedAnimationTimePoint, pGameTimer->getDeltaTime(), boneTransforms);
 }
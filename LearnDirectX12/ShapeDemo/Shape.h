@@ -33,7 +33,7 @@ struct SkinnedBoneCB {
 };
 
 struct RenderItem {
-	d3d::SubMesh subMesh;
+	std::vector<d3d::SubMesh> subMeshs;
 	FRConstantBufferPtr<ObjectCB> pObjectCb;
 	std::shared_ptr<dx12lib::VertexBuffer> pVertexBuffer;
 	std::shared_ptr<dx12lib::IndexBuffer> pIndexBuffer;
@@ -49,6 +49,21 @@ public:
 	void onBeginTick(std::shared_ptr<com::GameTimer> pGameTimer) override;
 	void onTick(std::shared_ptr<com::GameTimer> pGameTimer) override;
 	void onResize(dx12lib::DirectContextProxy pDirectCtx, int width, int height) override;
+
+	// CPU half of the animation updates, ShapeBenchmark runs them without a device
+	static d3d::BoneAnimation buildSkullAnimation();
+	static Math::Matrix4 getSkullWorld();
+	static void updateSkullAnimation(const d3d::BoneAnimation &animation,
+		float &timePoint, 
+		float deltaTime, 
+		Math::float4x4 &matWorld, 
+		Math::float4x4 &matNormal
+	);
+	static void updateSkinnedAnimation(const d3d::SkinnedData &skinnedData, 
+		float &timePoint, 
+		float deltaTime, 
+		std::span<Math::float4x4> boneTransforms
+	);
 private:
 	void buildTexturePSO(dx12lib::DirectContextProxy pDirectCtx);
 	void buildColorPSO(dx12lib::DirectContextProxy pDirectCtx);
@@ -57,7 +72,6 @@ private:
 	void buildGeometry(dx12lib::DirectContextProxy pDirectCtx);
 	void buildGameLight(dx12lib::DirectContextProxy pDirectCtx);
 	void buildMaterials();
-	void buildSkullAnimation();
 	void loadModelAndBuildRenderItem(dx12lib::DirectContextProxy pDirectCtx);
 	void loadTextures(dx12lib::DirectContextProxy pDirectCtx);
 	void renderShapesPass(dx12lib::DirectContextProxy pDirectCtx);
@@ -68,7 +82,6 @@ private:
 	void updateSkullAnimationCb(std::shared_ptr<com::GameTimer> pGameTimer);
 	void updateSkinnedAnimationCb(std::shared_ptr<com::GameTimer> pGameTimer);
 private:
-	Math::float4x4 _skullMatWorld;
 	d3d::BoneAnimation _skullAnimation;
 	float _skullAnimationTimePoint = 0.f;
 	FRConstantBufferPtr<ObjectCB> _pSkullObjCB;
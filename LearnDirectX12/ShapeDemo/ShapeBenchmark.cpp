@@ -0,0 +1,56 @@
+#include "ShapeBenchmark.h"
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include "D3D/M3dLoader/M3dLoader.h"
+
+using namespace Math;
+
+const char *ShapeBenchmark::getName() const {
+	return "ShapeDemo";
+}
+
+void ShapeBenchmark::onBenchmarkBegin(com::BenchmarkConfig &config) {
+	_skullAnimation = Shape::buildSkullAnimation();
+	_skullAnimationTimePoint = 0.f;
+	_skinnedAnimationTimePoint = 0.f;
+
+	// same file as Shape::loadModelAndBuildRenderItem, only the skeleton and clips are kept
+	std::vector<d3d::SkinnedVertex> vertices;
+	std::vector<uint16_t> indices;
+	std::vector<d3d::M3dLoader::Subset> subsets;
+	std::vector<d3d::M3dLoader::M3dMaterial> materials;
+	_skinnedData = d3d::SkinnedData();
+	[[maybe_unused]] bool loaded = d3d::M3dLoader::loadM3d("resource/soldier.m3d", vertices, indices, subsets, materials, _skinnedData);
+	assert(loaded);
+
+	if (config.cameraPath.empty()) {
+		float center[3] = { 0.f, 2.f, 0.f };
+		config.cameraPath = com::CameraPath::makeOrbit(center, 20.f, 8.f, 10.f);
+	}
+}
+
+std::uint64_t ShapeBenchmark::onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) {
+	float deltaTime = frame.pGameTimer->getDeltaTime();
+	{
+		com::BenchmarkStageScope scope(stages, "skull animation");
+		Shape::updateSkullAnimation(_skullAnimation, 
+			_skullAnimationTimePoint, 
+			deltaTime, 
+			_skullObjCB.matWorld, 
+			_skullObjCB.matNormal
+		);
+	}
+	size_t numBones = std::min(SkinnedBoneCB::kMaxCount, _skinnedData.getBoneCount());
+	{
+		com::BenchmarkStageScope scope(stages, "skinning");
+		std::span<float4x4> boneTransforms(_skinnedBoneCB.boneTransforms, numBones);
+		Shape::updateSkinnedAnimation(_skinnedData, _skinnedAnimationTimePoint, deltaTime, boneTransforms);
+	}
+
+	com::BenchmarkHash hash;
+	hash.add(static_cast<std::uint64_t>(std::lround(_skullObjCB.matWorld.m[3][0] * 1000.f)));
+	for (size_t i = 0; i < numBones; ++i)
+		hash.add(static_cast<std::uint64_t>(std::lround(_skinnedBoneCB.boneTransforms[i].m[3][0] * 1000.f)));
+	return hash.get();
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include "Benchmark/Benchmark.h"
+#include "Shape.h"
+
+// CPU side of Shape without a device: the skull key frame animation and the soldier's skinning
+// palette, through the same Shape::updateSkullAnimation/updateSkinnedAnimation the demo runs.
+// Shape draws every item without culling or sorting, so there is nothing else to measure
+class ShapeBenchmark : public com::IBenchmarkScene {
+public:
+	const char *getName() const override;
+	void onBenchmarkBegin(com::BenchmarkConfig &config) override;
+	std::uint64_t onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) override;
+private:
+	d3d::BoneAnimation _skullAnimation;
+	float _skullAnimationTimePoint = 0.f;
+	ObjectCB _skullObjCB;
+	d3d::SkinnedData _skinnedData;
+	float _skinnedAnimationTimePoint = 0.f;
+	SkinnedBoneCB _skinnedBoneCB;
+};
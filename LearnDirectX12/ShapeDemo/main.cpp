@@ -1,7 +1,14 @@
 #include <iostream>
 #include "Shape.h"
+#include "ShapeBenchmark.h"
+
+int main(int argc, char *argv[]) {
+	// --benchmark runs the CPU side of the frame headless, see Benchmark/Benchmark.h for the flags
+	if (com::isBenchmarkRequested(argc, argv)) {
+		ShapeBenchmark benchmark;
+		return com::runBenchmarkMain(argc, argv, benchmark);
+	}
 
-int main() {
 	std::shared_ptr<com::GameTimer> pGameTimer = std::make_shared<com::GameTimer>();
 	Shape app;
 	try {
@@ -3,8 +3,15 @@
 #include <Windows.h>
 #include "GameTimer/GameTimer.h"
 #include "TBDRApp.h"
+#include "TBDRBenchmark.h"
+
+int main(int argc, char *argv[]) {
+	// --benchmark runs the CPU side of the frame headless, see Benchmark/Benchmark.h for the flags
+	if (com::isBenchmarkRequested(argc, argv)) {
+		TBDRBenchmark benchmark;
+		return com::runBenchmarkMain(argc, argv, benchmark);
+	}
 
-int main() {
 	std::shared_ptr<com::GameTimer> pGameTimer = std::make_shared<com::GameTimer>();
 	TBDRApp app;
 	try {
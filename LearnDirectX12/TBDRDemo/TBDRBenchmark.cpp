@@ -0,0 +1,122 @@
+#include "TBDRBenchmark.h"
+#include <algorithm>
+#include <limits>
+#include "D3D/AssimpLoader/ALTree.h"
+#include "D3D/AssimpLoader/ALNode.h"
+#include "D3D/AssimpLoader/ALMesh.h"
+#include "D3D/Model/MeshModel/MeshNode.h"
+
+using namespace Math;
+
+const char *TBDRBenchmark::getName() const {
+	return "TBDRDemo";
+}
+
+void TBDRBenchmark::onBenchmarkBegin(com::BenchmarkConfig &config) {
+	_transforms.clear();
+	_meshes.clear();
+	_geometries.clear();
+	// same model as TBDRApp::onInitialize
+	d3d::ALTree alTree("resources/SponzaPBR/Sponza.gltf");
+	addNode(alTree.getRootNode(), d3d::TransformHierarchy::kInvalidNode);
+	_transforms.update();
+
+	// the model does not move, the world boxes are computed once
+	_worldAABBs.clear();
+	float sceneMin[3] = { +std::numeric_limits<float>::max(), +std::numeric_limits<float>::max(), +std::numeric_limits<float>::max() };
+	float sceneMax[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+	for (size_t mesh : _meshes) {
+		const d3d::TransformAABB &bounds = _transforms.getWorldBounds(mesh);
+		Vector3 center(bounds.center[0], bounds.center[1], bounds.center[2]);
+		Vector3 extents(bounds.extents[0], bounds.extents[1], bounds.extents[2]);
+		_worldAABBs.emplace_back(center - extents, center + extents);
+		for (size_t c = 0; c < 3; ++c) {
+			sceneMin[c] = std::min(sceneMin[c], bounds.center[c] - bounds.extents[c]);
+			sceneMax[c] = std::max(sceneMax[c], bounds.center[c] + bounds.extents[c]);
+		}
+	}
+
+	d3d::CameraDesc cameraDesc {
+		float3(0.f, 1.f, 0.f),
+		float3(0.f, 1.f, 0.f),
+		float3(1.f, 1.f, 0.f),
+		DirectX::XMConvertToDegrees(config.fovY),
+		config.zNear,
+		config.zFar,
+		config.aspect,
+	};
+	_pCamera = std::make_unique<d3d::PathCamera>(cameraDesc);
+
+	if (config.cameraPath.empty() && !_meshes.empty()) {
+		// down the nave along the long axis at head height and back, looking around on the way
+		size_t axis = (sceneMax[0] - sceneMin[0] >= sceneMax[2] - sceneMin[2]) ? 0 : 2;
+		size_t side = 2 - axis;
+		float center[3];
+		float extents[3];
+		for (size_t c = 0; c < 3; ++c) {
+			center[c] = (sceneMin[c] + sceneMax[c]) * 0.5f;
+			extents[c] = (sceneMax[c] - sceneMin[c]) * 0.5f;
+		}
+		const float keys[][2] = {
+			{ -0.8f, +0.f }, { -0.3f, +0.4f }, { +0.3f, -0.4f }, { +0.8f, +0.f }, { +0.3f, +0.4f }, { -0.3f, -0.4f }, { -0.8f, +0.f },
+		};
+		com::CameraPath path(true);
+		for (size_t i = 0; i < std::size(keys); ++i) {
+			com::CameraPose pose;
+			std::copy_n(center, 3, pose.position);
+			std::copy_n(center, 3, pose.target);
+			pose.position[axis] += keys[i][0] * extents[axis];
+			pose.position[1] = sceneMin[1] + extents[1] * 0.3f;
+			pose.target[axis] = pose.position[axis] - keys[i][0] * extents[axis] * 0.5f;
+			pose.target[side] += keys[i][1] * extents[side];
+			pose.target[1] = pose.position[1];
+			path.addKey(3.f * static_cast<float>(i), pose);
+		}
+		config.cameraPath = path;
+	}
+}
+
+std::uint64_t TBDRBenchmark::onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) {
+	_pCamera->setPose(frame.camera.position, frame.camera.target);
+	{
+		com::BenchmarkStageScope scope(stages, "cull");
+		const BoundingFrustum &frustum = _pCamera->getViewSpaceFrustum();
+		_visible.clear();
+		for (size_t i = 0; i < _worldAABBs.size(); ++i) {
+			if (frustum.contains(_worldAABBs[i]) != DX::ContainmentType::DISJOINT)
+				_visible.push_back(static_cast<std::uint32_t>(i));
+		}
+	}
+	{
+		com::BenchmarkStageScope scope(stages, "queue");
+		const d3d::CameraCore &core = _pCamera->getCore();
+		Vector3 eye(core.getEye());
+		Vector3 forward(core.getForward());
+		_drawQueue.clear();
+		for (std::uint32_t index : _visible) {
+			const float *center = _transforms.getWorldBounds(_meshes[index]).center;
+			float viewDepth = dot(Vector3(center[0], center[1], center[2]) - eye, forward);
+			_drawQueue.push(d3d::DrawSortKey::make(0, 0, _geometries[index], _geometries[index], viewDepth), index);
+		}
+		_drawQueue.sort();
+	}
+
+	com::BenchmarkHash hash;
+	hash.add(_visible.size());
+	for (const d3d::DrawItem &item : _drawQueue.getItems())
+		hash.add(item.index);
+	return hash.get();
+}
+
+void TBDRBenchmark::addNode(const d3d::ALNode *pALNode, size_t parent) {
+	size_t node = _transforms.addNode(parent, pALNode->getNodeTransform());
+	for (size_t i = 0; i < pALNode->getNumMesh(); ++i) {
+		std::shared_ptr<d3d::ALMesh> pALMesh = pALNode->getMesh(i);
+		size_t mesh = _transforms.addNode(node);
+		_transforms.setLocalBounds(mesh, d3d::MeshNode::calcMeshBounds(*pALMesh));
+		_meshes.push_back(mesh);
+		_geometries.push_back(static_cast<std::uint32_t>(pALMesh->getMeshIdx()));
+	}
+	for (size_t i = 0; i < pALNode->getNumChildren(); ++i)
+		addNode(pALNode->getChildren(i), node);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Benchmark/Benchmark.h"
+#include "D3D/DrawQueue/DrawQueue.h"
+#include "D3D/Model/Transform/TransformHierarchy.h"
+#include "D3D/Tool/PathCamera.h"
+
+namespace d3d {
+class ALNode;
+}
+
+// CPU side of TBDRApp without a device: the Sponza meshes TBDRApp loads are culled against the
+// camera and queued for the gbuffer pass. TBDRApp has no point lights yet, so nothing is binned
+class TBDRBenchmark : public com::IBenchmarkScene {
+public:
+	const char *getName() const override;
+	void onBenchmarkBegin(com::BenchmarkConfig &config) override;
+	std::uint64_t onBenchmarkFrame(const com::BenchmarkFrame &frame, com::BenchmarkStageRecorder &stages) override;
+private:
+	void addNode(const d3d::ALNode *pALNode, size_t parent);
+private:
+	d3d::TransformHierarchy _transforms;
+	std::vector<size_t> _meshes;
+	std::vector<std::uint32_t> _geometries;
+	std::vector<Math::BoundingBox> _worldAABBs;
+	std::unique_ptr<d3d::PathCamera> _pCamera;
+	std::vector<std::uint32_t> _visible;
+	d3d::DrawQueue _drawQueue;
+};
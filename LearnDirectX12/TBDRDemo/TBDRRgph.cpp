@@ -8,6 +8,8 @@
 #include "RenderGraph/Pass/ClearPass.hpp"
 #include "RenderGraph/Pass/CopyPass.hpp"
 #include "RenderGraph/RenderGraph/RenderGraph.h"
+#include "D3D/RenderGraphCompiler/RenderGraphCompiler.h"
+#include <functional>
 
 namespace TBDRRgph {
 
@@ -52,7 +54,7 @@ PostPass::PostPass(const std::string &passName)
 }
 
 std::shared_ptr<rgph::RenderGraph> createTBDRRenderGraph(TBDRApp *pApp) {
-	std::shared_ptr<rgph::RenderGraph> pRenderGraph;
+	std::shared_ptr<rgph::RenderGraph> pRenderGraph = std::make_shared<rgph::RenderGraph>();
 
 	auto pClearDsPass = std::make_shared<rgph::ClearDsPass>(ClearDsPass);
 	auto pClearGBuffer = std::make_shared<ClearGBufferPass>(ClearGBuffer);
@@ -60,78 +62,98 @@ std::shared_ptr<rgph::RenderGraph> createTBDRRenderGraph(TBDRApp *pApp) {
 	auto pLightingPass = std::make_shared<LightingPass>(Lighting);
 	auto pLightingCopyToMainRt = std::make_shared<rgph::CopyPass>(LightingCopyToMainRt);
 	auto pSkyBox = std::make_shared<d3d::SkyBoxPass>(SkyBox);
-	auto pPostPass = std::make_shared<PostPass>(ColorGradingAndGammaCorrection);
-	auto pMainRtCopyToBackRt = std::make_shared<rgph::CopyPass>(MainRtCopyToBackRt);
 	auto pPresentPass = std::make_shared<rgph::PresentPass>(Present);
 
-	/// Clear Depth Stencil Pass
-	{
-		auto getDepthStencil = [=]() {
-			return pApp->getSwapChain()->getDepthStencil2D();
+	/// the frame as resource accesses, the compiler orders the passes and derives every preExecuteState
+	using Usage = d3d::GraphResourceUsage;
+	using SetState = std::function<void(D3D12_RESOURCE_STATES)>;
+	struct AccessBinding {
+		d3d::GraphResourceAccess access;
+		std::function<void()> link;					// feeds the pass resource from the resource source
+		SetState setState;
+	};
+	auto access = [](d3d::GraphResourceId resource, auto source, Usage usage, auto &passResource) -> AccessBinding {
+		return {
+			{ resource, usage },
+			[=, &passResource]() { source >> passResource; },
+			[&passResource](D3D12_RESOURCE_STATES state) { passResource.preExecuteState = state; },
 		};
-
-		getDepthStencil >> pClearDsPass->pDepthStencil;
-		pClearDsPass->pDepthStencil.preExecuteState = D3D12_RESOURCE_STATE_DEPTH_WRITE;
-		pRenderGraph->addPass(pClearDsPass);
-	}
-	/// Clear GBuffer Pass
-	{
-		pApp->pGBuffer0 >> pClearGBuffer->pGBuffer0;
-		pApp->pGBuffer1 >> pClearGBuffer->pGBuffer1;
-		pApp->pGBuffer2 >> pClearGBuffer->pGBuffer2;
-		pClearGBuffer->pGBuffer0.preExecuteState = D3D12_RESOURCE_STATE_RENDER_TARGET;
-		pClearGBuffer->pGBuffer1.preExecuteState = D3D12_RESOURCE_STATE_RENDER_TARGET;
-		pClearGBuffer->pGBuffer1.preExecuteState = D3D12_RESOURCE_STATE_RENDER_TARGET;
-		pRenderGraph->addPass(pClearGBuffer);
-	}
-	/// GBuffer Pass
-	{
-		pClearGBuffer->pGBuffer0 >> pGBufferPass->pGBuffer0;
-		pClearGBuffer->pGBuffer1 >> pGBufferPass->pGBuffer1;
-		pClearGBuffer->pGBuffer2 >> pGBufferPass->pGBuffer2;
-		pClearDsPass->pDepthStencil >> pGBufferPass->pDepthStencil;
-		pRenderGraph->addPass(pGBufferPass);
-	}
-	/// Lighting Pass
-	{
-		pClearGBuffer->pGBuffer0.preExecuteState = D3D12_RESOURCE_STATE_GENERIC_READ;
-		pGBufferPass->pGBuffer0 >> pLightingPass->pGBuffer0;
-
-		pClearGBuffer->pGBuffer1.preExecuteState = D3D12_RESOURCE_STATE_GENERIC_READ;
-		pGBufferPass->pGBuffer1 >> pLightingPass->pGBuffer1;
-
-		pClearGBuffer->pGBuffer2.preExecuteState = D3D12_RESOURCE_STATE_GENERIC_READ;
-		pGBufferPass->pGBuffer2 >> pLightingPass->pGBuffer2;
-
-		pLightingPass->pDepthBuffer.preExecuteState = D3D12_RESOURCE_STATE_DEPTH_READ;
-		pGBufferPass->pDepthStencil >> pLightingPass->pDepthBuffer;
-
-		pLightingPass->pLightingBuffer.preExecuteState = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
-		pApp->pLightingBuffer >> pLightingPass->pLightingBuffer;
-		pRenderGraph->addPass(pLightingPass);
-	}
-	/// copy lighting to main rt
-	{
-		auto getRenderTarget = [=]() {
-			return pApp->getSwapChain()->getRenderTarget2D();
-		};
-
-		pLightingPass->pLightingBuffer >> pLightingCopyToMainRt->pSrcResource;
-		getRenderTarget >> pLightingCopyToMainRt->pDstResource;
-		pRenderGraph->addPass(pLightingCopyToMainRt);
-	}
-	/// SkyBox Pass
-	{
-		pSkyBox->pRenderTarget.preExecuteState = D3D12_RESOURCE_STATE_RENDER_TARGET;
-		pLightingCopyToMainRt->pDstResource >> pSkyBox->pRenderTarget;
-		pSkyBox->pDepthStencil.preExecuteState = D3D12_RESOURCE_STATE_DEPTH_WRITE;
-		pGBufferPass->pDepthStencil >> pSkyBox->pDepthStencil;
-		pRenderGraph->addPass(pGBufferPass);
-	}
-	/// ColorGrading & GammaCorrection
-	{
-		pSkyBox->pRenderTarget >> pPostPass->pBackBuffer;
-
+	};
+
+	d3d::RenderGraphCompiler compiler;
+	d3d::GraphResourceId depthStencil = compiler.addResource({ "DepthStencil", true, D3D12_RESOURCE_STATE_DEPTH_WRITE });
+	d3d::GraphResourceId backBuffer = compiler.addResource({ "BackBuffer", true, D3D12_RESOURCE_STATE_PRESENT });
+	// owned by the app for now, so they report no memory to alias
+	d3d::GraphResourceId gbuffer0 = compiler.addResource({ "GBuffer0" });
+	d3d::GraphResourceId gbuffer1 = compiler.addResource({ "GBuffer1" });
+	d3d::GraphResourceId gbuffer2 = compiler.addResource({ "GBuffer2" });
+	d3d::GraphResourceId lightingBuffer = compiler.addResource({ "LightingBuffer" });
+
+	auto getDepthStencil = [=]() {
+		return pApp->getSwapChain()->getDepthStencil2D();
+	};
+	auto getRenderTarget = [=]() {
+		return pApp->getSwapChain()->getRenderTarget2D();
+	};
+
+	struct PassBinding {
+		std::function<void()> addToGraph;
+		std::vector<AccessBinding> accesses;
+	};
+	std::vector<PassBinding> bindings;
+	auto declarePass = [&](auto pPass, const std::string &name, std::vector<AccessBinding> accesses, bool hasSideEffect = false) {
+		d3d::GraphPassDesc desc { name, {}, hasSideEffect };
+		for (const AccessBinding &binding : accesses)
+			desc.accesses.push_back(binding.access);
+		compiler.addPass(std::move(desc));
+		bindings.push_back({ [=]() { pRenderGraph->addPass(pPass); }, std::move(accesses) });
+	};
+
+	declarePass(pClearDsPass, ClearDsPass, {
+		access(depthStencil, getDepthStencil, Usage::DepthWrite, pClearDsPass->pDepthStencil),
+	});
+	declarePass(pClearGBuffer, ClearGBuffer, {
+		access(gbuffer0, pApp->pGBuffer0, Usage::RenderTarget, pClearGBuffer->pGBuffer0),
+		access(gbuffer1, pApp->pGBuffer1, Usage::RenderTarget, pClearGBuffer->pGBuffer1),
+		access(gbuffer2, pApp->pGBuffer2, Usage::RenderTarget, pClearGBuffer->pGBuffer2),
+	});
+	declarePass(pGBufferPass, GBuffer, {
+		access(gbuffer0, pApp->pGBuffer0, Usage::RenderTarget, pGBufferPass->pGBuffer0),
+		access(gbuffer1, pApp->pGBuffer1, Usage::RenderTarget, pGBufferPass->pGBuffer1),
+		access(gbuffer2, pApp->pGBuffer2, Usage::RenderTarget, pGBufferPass->pGBuffer2),
+		access(depthStencil, getDepthStencil, Usage::DepthWrite, pGBufferPass->pDepthStencil),
+	});
+	// the lighting compute shader samples the depth, it is never bound as a depth target here
+	declarePass(pLightingPass, Lighting, {
+		access(gbuffer0, pApp->pGBuffer0, Usage::NonPixelShaderRead, pLightingPass->pGBuffer0),
+		access(gbuffer1, pApp->pGBuffer1, Usage::NonPixelShaderRead, pLightingPass->pGBuffer1),
+		access(gbuffer2, pApp->pGBuffer2, Usage::NonPixelShaderRead, pLightingPass->pGBuffer2),
+		access(depthStencil, getDepthStencil, Usage::NonPixelShaderRead, pLightingPass->pDepthBuffer),
+		access(lightingBuffer, pApp->pLightingBuffer, Usage::UnorderedAccess, pLightingPass->pLightingBuffer),
+	});
+	declarePass(pLightingCopyToMainRt, LightingCopyToMainRt, {
+		access(lightingBuffer, pApp->pLightingBuffer, Usage::CopySource, pLightingCopyToMainRt->pSrcResource),
+		access(backBuffer, getRenderTarget, Usage::CopyDest, pLightingCopyToMainRt->pDstResource),
+	});
+	declarePass(pSkyBox, SkyBox, {
+		access(backBuffer, getRenderTarget, Usage::RenderTarget, pSkyBox->pRenderTarget),
+		access(depthStencil, getDepthStencil, Usage::DepthWrite, pSkyBox->pDepthStencil),
+	});
+	declarePass(pPresentPass, Present, {
+		access(backBuffer, getRenderTarget, Usage::Present, pPresentPass->pRenderTarget),
+	}, true);
+
+	d3d::CompiledRenderGraph compiled = compiler.compile();
+	if (!compiled)
+		return nullptr;
+
+	for (const d3d::GraphCompiledPass &compiledPass : compiled.schedule) {
+		PassBinding &binding = bindings[compiledPass.pass];
+		for (size_t i = 0; i < binding.accesses.size(); ++i) {
+			binding.accesses[i].link();
+			binding.accesses[i].setState(static_cast<D3D12_RESOURCE_STATES>(compiled.getPassState(compiledPass.pass, i)));
+		}
+		binding.addToGraph();
 	}
 	return pRenderGraph;
 }
@@ -59,6 +59,7 @@ public:
 	rgph::PassResourcePtr<dx12lib::IRenderTarget2D> pBackBuffer;
 };
 
+// nullptr when the pass accesses do not compile (a dependency cycle)
 std::shared_ptr<rgph::RenderGraph> createTBDRRenderGraph(TBDRApp *pApp);
 
 }